@@ -168,11 +168,15 @@ AutocompleteController::AutocompleteController(
     AutocompleteControllerDelegate* delegate,
     int provider_types)
     : delegate_(delegate),
+      history_quick_provider_(NULL),
       history_url_provider_(NULL),
       keyword_provider_(NULL),
       search_provider_(NULL),
       zero_suggest_provider_(NULL),
       stop_timer_duration_(OmniboxFieldTrial::StopTimerFieldTrialDuration()),
+      history_quick_deadline_(OmniboxFieldTrial::HQPWorkerDeadline()),
+      history_quick_pending_(false),
+      history_quick_late_(false),
       done_(true),
       in_start_(false),
       profile_(profile) {
@@ -183,8 +187,10 @@ AutocompleteController::AutocompleteController(
     providers_.push_back(new BuiltinProvider(this, profile));
   if (provider_types & AutocompleteProvider::TYPE_EXTENSION_APP)
     providers_.push_back(new ExtensionAppProvider(this, profile));
-  if (provider_types & AutocompleteProvider::TYPE_HISTORY_QUICK)
-    providers_.push_back(new HistoryQuickProvider(this, profile));
+  if (provider_types & AutocompleteProvider::TYPE_HISTORY_QUICK) {
+    history_quick_provider_ = new HistoryQuickProvider(this, profile);
+    providers_.push_back(history_quick_provider_);
+  }
   if (provider_types & AutocompleteProvider::TYPE_HISTORY_URL) {
     history_url_provider_ = new HistoryURLProvider(this, profile);
     providers_.push_back(history_url_provider_);
@@ -281,6 +287,10 @@ void AutocompleteController::Start(const AutocompleteInput& input) {
         name, 1, 1000, 50, base::Histogram::kUmaTargetedHistogramFlag);
     counter->Add(static_cast<int>((end_time - start_time).InMilliseconds()));
   }
+  history_quick_deadline_time_ = start_time + history_quick_deadline_;
+  history_quick_pending_ =
+      history_quick_provider_ && !history_quick_provider_->done();
+  history_quick_late_ = false;
   in_start_ = false;
   CheckIfDone();
   // The second true forces saying the default match has changed.
@@ -370,6 +380,14 @@ void AutocompleteController::ExpireCopiedEntries() {
 }
 
 void AutocompleteController::OnProviderUpdate(bool updated_matches) {
+  if (history_quick_pending_ && history_quick_provider_->done()) {
+    history_quick_pending_ = false;
+    history_quick_late_ =
+        (base::TimeTicks::Now() > history_quick_deadline_time_) &&
+        (result_.default_match() != result_.end());
+    UMA_HISTOGRAM_BOOLEAN("Omnibox.HistoryQuickProviderMissedDeadline",
+                          history_quick_late_);
+  }
   CheckIfDone();
   // Multiple providers may provide synchronous results, so we only update the
   // results if we're not in Start().
@@ -443,8 +461,17 @@ void AutocompleteController::UpdateResult(
   last_result.Swap(&result_);
 
   for (ACProviders::const_iterator i(providers_.begin());
-       i != providers_.end(); ++i)
-    result_.AppendMatches((*i)->matches());
+       i != providers_.end(); ++i) {
+    if ((*i == history_quick_provider_) && history_quick_late_) {
+      ACMatches late_matches((*i)->matches());
+      for (ACMatches::iterator match(late_matches.begin());
+           match != late_matches.end(); ++match)
+        match->allowed_to_be_default_match = false;
+      result_.AppendMatches(late_matches);
+    } else {
+      result_.AppendMatches((*i)->matches());
+    }
+  }
 
   // Sort the matches and trim to a small number of "best" matches.
   result_.SortAndCull(input_, profile_);
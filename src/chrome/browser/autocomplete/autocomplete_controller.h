@@ -138,6 +138,8 @@ class AutocompleteController : public AutocompleteProviderListener {
                            RedundantKeywordsIgnoredInResult);
   FRIEND_TEST_ALL_PREFIXES(AutocompleteProviderTest, UpdateAssistedQueryStats);
   FRIEND_TEST_ALL_PREFIXES(AutocompleteProviderTest, GetDestinationURL);
+  FRIEND_TEST_ALL_PREFIXES(AutocompleteProviderTest,
+                           LateHistoryQuickMatchesAreNotDefault);
   FRIEND_TEST_ALL_PREFIXES(OmniboxViewTest, DoesNotUpdateAutocompleteOnBlur);
   FRIEND_TEST_ALL_PREFIXES(OmniboxViewViewsTest, CloseOmniboxPopupOnTextDrag);
 
@@ -190,6 +192,11 @@ class AutocompleteController : public AutocompleteProviderListener {
   // A list of all providers.
   ACProviders providers_;
 
+  // The HistoryQuickProvider, whose matches are held to
+  // |history_quick_deadline_|.  Only AutocompleteProvider's interface is
+  // needed, so that tests can stand in their own provider.
+  AutocompleteProvider* history_quick_provider_;
+
   HistoryURLProvider* history_url_provider_;
 
   KeywordProvider* keyword_provider_;
@@ -230,6 +237,23 @@ class AutocompleteController : public AutocompleteProviderListener {
   // and doesn't expect it to change.
   const base::TimeDelta stop_timer_duration_;
 
+  // How long after Start() the matches of |history_quick_provider_|, which
+  // scores on a worker thread when this is nonzero, may still take over the
+  // default match.  Later matches are shown, but not allowed to be default
+  // if there already is a default match, so that it stays stable while the
+  // user reads it.
+  const base::TimeDelta history_quick_deadline_;
+
+  // When |history_quick_deadline_| passes for the current query.
+  base::TimeTicks history_quick_deadline_time_;
+
+  // True while |history_quick_provider_| is scoring the current query.
+  bool history_quick_pending_;
+
+  // True if |history_quick_provider_| missed the deadline for the current
+  // query.
+  bool history_quick_late_;
+
   // True if a query is not currently running.
   bool done_;
 
@@ -607,6 +607,39 @@ TEST_F(AutocompleteProviderTest, UpdateAssistedQueryStats) {
   }
 }
 
+// Matches from the HistoryQuickProvider that missed the controller's deadline
+// are kept, but may not take over the default match.
+TEST_F(AutocompleteProviderTest, LateHistoryQuickMatchesAreNotDefault) {
+  TestProvider* provider1 = NULL;
+  TestProvider* provider2 = NULL;
+  ResetControllerWithTestProviders(false, &provider1, &provider2);
+  RunTest();
+
+  // The second provider has the higher relevance, so it supplies the default
+  // match while it is on time.
+  const AutocompleteResult& result = controller_->result();
+  ASSERT_TRUE(result.default_match() != result.end());
+  EXPECT_EQ(provider2, result.default_match()->provider);
+
+  // Have the controller treat the second provider as a late
+  // HistoryQuickProvider.
+  controller_->history_quick_provider_ = provider2;
+  controller_->history_quick_late_ = true;
+  controller_->UpdateResult(false, false);
+
+  ASSERT_TRUE(result.default_match() != result.end());
+  EXPECT_EQ(provider1, result.default_match()->provider);
+  size_t late_matches = 0;
+  for (AutocompleteResult::const_iterator i(result.begin());
+       i != result.end(); ++i) {
+    if (i->provider == provider2) {
+      ++late_matches;
+      EXPECT_FALSE(i->allowed_to_be_default_match);
+    }
+  }
+  EXPECT_EQ(kResultsPerProvider, late_matches);
+}
+
 TEST_F(AutocompleteProviderTest, GetDestinationURL) {
   ResetControllerWithKeywordAndSearchProviders();
 
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "base/basictypes.h"
+#include "base/bind.h"
 #include "base/command_line.h"
 #include "base/i18n/break_iterator.h"
 #include "base/logging.h"
@@ -16,6 +17,8 @@
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/task_runner_util.h"
+#include "base/threading/sequenced_worker_pool.h"
 #include "base/time/time.h"
 #include "chrome/browser/autocomplete/autocomplete_result.h"
 #include "chrome/browser/autocomplete/history_url_provider.h"
@@ -36,6 +39,7 @@
 #include "chrome/common/net/url_fixer_upper.h"
 #include "chrome/common/pref_names.h"
 #include "chrome/common/url_constants.h"
+#include "content/public/browser/browser_thread.h"
 #include "content/public/browser/notification_source.h"
 #include "content/public/browser/notification_types.h"
 #include "net/base/escape.h"
@@ -55,12 +59,17 @@ HistoryQuickProvider::HistoryQuickProvider(
     Profile* profile)
     : HistoryProvider(listener, profile,
           AutocompleteProvider::TYPE_HISTORY_QUICK),
-      languages_(profile_->GetPrefs()->GetString(prefs::kAcceptLanguages)) {
+      languages_(profile_->GetPrefs()->GetString(prefs::kAcceptLanguages)),
+      score_on_worker_(
+          OmniboxFieldTrial::HQPWorkerDeadline() > base::TimeDelta()),
+      weak_ptr_factory_(this) {
 }
 
 void HistoryQuickProvider::Start(const AutocompleteInput& input,
                                  bool minimal_changes) {
   matches_.clear();
+  weak_ptr_factory_.InvalidateWeakPtrs();
+  done_ = true;
   if (disabled_)
     return;
 
@@ -76,7 +85,27 @@ void HistoryQuickProvider::Start(const AutocompleteInput& input,
   // autocomplete behavior here.
   if (GetIndex()) {
     base::TimeTicks start_time = base::TimeTicks::Now();
-    DoAutocomplete();
+    if (score_on_worker_ && input.want_asynchronous_matches()) {
+      if (!worker_task_runner_.get()) {
+        base::SequencedWorkerPool* pool =
+            content::BrowserThread::GetBlockingPool();
+        worker_task_runner_ = pool->GetSequencedTaskRunnerWithShutdownBehavior(
+            pool->GetSequenceToken(),
+            base::SequencedWorkerPool::SKIP_ON_SHUTDOWN);
+      }
+      done_ = false;
+      base::PostTaskAndReplyWithResult(
+          worker_task_runner_.get(),
+          FROM_HERE,
+          GetIndex()->GetHistoryItemsForTermsCallback(
+              autocomplete_input_.text(),
+              autocomplete_input_.cursor_position()),
+          base::Bind(&HistoryQuickProvider::OnHistoryItemsScored,
+                     weak_ptr_factory_.GetWeakPtr(), start_time));
+      return;
+    }
+    DoAutocomplete(GetIndex()->HistoryItemsForTerms(
+        autocomplete_input_.text(), autocomplete_input_.cursor_position()));
     if (input.text().length() < 6) {
       base::TimeTicks end_time = base::TimeTicks::Now();
       std::string name = "HistoryQuickProvider.QueryIndexTime." +
@@ -97,13 +126,15 @@ void HistoryQuickProvider::DeleteMatch(const AutocompleteMatch& match) {
   DeleteMatchFromMatches(match);
 }
 
+void HistoryQuickProvider::Stop(bool clear_cached_results) {
+  weak_ptr_factory_.InvalidateWeakPtrs();
+  AutocompleteProvider::Stop(clear_cached_results);
+}
+
 HistoryQuickProvider::~HistoryQuickProvider() {}
 
-void HistoryQuickProvider::DoAutocomplete() {
-  // Get the matching URLs from the DB.
-  ScoredHistoryMatches matches = GetIndex()->HistoryItemsForTerms(
-      autocomplete_input_.text(),
-      autocomplete_input_.cursor_position());
+void HistoryQuickProvider::DoAutocomplete(
+    const ScoredHistoryMatches& matches) {
   if (matches.empty())
     return;
 
@@ -231,6 +262,17 @@ void HistoryQuickProvider::DoAutocomplete() {
   }
 }
 
+void HistoryQuickProvider::OnHistoryItemsScored(
+    base::TimeTicks start_time,
+    const ScoredHistoryMatches& matches) {
+  done_ = true;
+  DoAutocomplete(matches);
+  UpdateStarredStateOfMatches();
+  UMA_HISTOGRAM_TIMES("HistoryQuickProvider.WorkerQueryTime",
+                      base::TimeTicks::Now() - start_time);
+  listener_->OnProviderUpdate(!matches_.empty());
+}
+
 AutocompleteMatch HistoryQuickProvider::QuickMatchToACMatch(
     const ScoredHistoryMatch& history_match,
     int score) {
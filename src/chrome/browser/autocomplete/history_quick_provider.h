@@ -9,6 +9,9 @@
 
 #include "base/basictypes.h"
 #include "base/compiler_specific.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
 #include "chrome/browser/autocomplete/autocomplete_input.h"
 #include "chrome/browser/autocomplete/autocomplete_match.h"
 #include "chrome/browser/autocomplete/history_provider.h"
@@ -17,6 +20,10 @@
 
 class Profile;
 
+namespace base {
+class SequencedTaskRunner;
+}
+
 namespace history {
 class ScoredHistoryMatch;
 }  // namespace history
@@ -25,15 +32,20 @@ class ScoredHistoryMatch;
 // the history system) which quickly (and synchronously) provides matching
 // results from recently or frequently visited sites in the profile's
 // history.
+//
+// When the HQPWorkerDeadline experiment is active and the input wants
+// asynchronous matches, the history index is scored on a worker thread
+// instead, and the matches are built and reported when the scores come back.
 class HistoryQuickProvider : public HistoryProvider {
  public:
   HistoryQuickProvider(AutocompleteProviderListener* listener,
                        Profile* profile);
 
-  // AutocompleteProvider. |minimal_changes| is ignored since there is no asynch
-  // completion performed.
+  // AutocompleteProvider. |minimal_changes| is ignored since each query
+  // rescores the index.
   virtual void Start(const AutocompleteInput& input,
                      bool minimal_changes) OVERRIDE;
+  virtual void Stop(bool clear_cached_results) OVERRIDE;
 
   virtual void DeleteMatch(const AutocompleteMatch& match) OVERRIDE;
 
@@ -48,11 +60,18 @@ class HistoryQuickProvider : public HistoryProvider {
   friend class HistoryQuickProviderTest;
   FRIEND_TEST_ALL_PREFIXES(HistoryQuickProviderTest, Spans);
   FRIEND_TEST_ALL_PREFIXES(HistoryQuickProviderTest, Relevance);
+  FRIEND_TEST_ALL_PREFIXES(HistoryQuickProviderTest, WorkerMatchesUIThread);
 
   virtual ~HistoryQuickProvider();
 
-  // Performs the autocomplete matching and scoring.
-  void DoAutocomplete();
+  // Builds |matches_| from |matches|, the scored history items which match
+  // |autocomplete_input_|.
+  void DoAutocomplete(const history::ScoredHistoryMatches& matches);
+
+  // Called with the history items scored on the worker thread for the query
+  // started at |start_time|.
+  void OnHistoryItemsScored(base::TimeTicks start_time,
+                            const history::ScoredHistoryMatches& matches);
 
   // Creates an AutocompleteMatch from |history_match|, assigning it
   // the score |score|.
@@ -74,9 +93,20 @@ class HistoryQuickProvider : public HistoryProvider {
   // Only used for testing.
   scoped_ptr<history::InMemoryURLIndex> index_for_testing_;
 
+  // True if the index is scored on |worker_task_runner_|.
+  bool score_on_worker_;
+
+  // Runs the scoring tasks one at a time, so that they do not contend for the
+  // index.  Created on first use.
+  scoped_refptr<base::SequencedTaskRunner> worker_task_runner_;
+
   // This provider is disabled when true.
   static bool disabled_;
 
+  // Invalidated when a query is started or stopped, dropping the scores of
+  // the previous query.
+  base::WeakPtrFactory<HistoryQuickProvider> weak_ptr_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(HistoryQuickProvider);
 };
 
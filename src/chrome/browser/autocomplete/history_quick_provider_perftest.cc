@@ -0,0 +1,195 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <map>
+#include <string>
+
+#include "base/format_macros.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop/message_loop.h"
+#include "base/metrics/field_trial.h"
+#include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversions.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "base/time/time.h"
+#include "chrome/browser/autocomplete/autocomplete_input.h"
+#include "chrome/browser/autocomplete/autocomplete_provider_listener.h"
+#include "chrome/browser/autocomplete/history_quick_provider.h"
+#include "chrome/browser/bookmarks/bookmark_model_factory.h"
+#include "chrome/browser/history/history_backend.h"
+#include "chrome/browser/history/history_database.h"
+#include "chrome/browser/history/history_service.h"
+#include "chrome/browser/history/history_service_factory.h"
+#include "chrome/browser/history/in_memory_url_index.h"
+#include "chrome/browser/omnibox/omnibox_field_trial.h"
+#include "chrome/browser/search_engines/template_url_service.h"
+#include "chrome/browser/search_engines/template_url_service_factory.h"
+#include "chrome/test/base/testing_profile.h"
+#include "components/bookmarks/test/bookmark_test_helpers.h"
+#include "components/variations/entropy_provider.h"
+#include "components/variations/variations_associated_data.h"
+#include "content/public/test/test_browser_thread.h"
+#include "sql/statement.h"
+#include "sql/transaction.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+using content::BrowserThread;
+
+namespace {
+
+// URLs in the history database, spread over hosts the way a long-lived
+// profile's history is.
+const size_t kURLs = 10000;
+const size_t kHosts = 500;
+
+// Visits recorded for each URL.
+const size_t kVisitsPerURL = 3;
+
+// Times each URL is typed in full, one keystroke at a time.
+const size_t kRuns = 20;
+
+// The text typed; its prefixes match many of the URLs above.
+const char kTypedText[] = "site42.example.com/articles/page";
+
+}  // namespace
+
+class HistoryQuickProviderPerfTest : public testing::Test,
+                                     public AutocompleteProviderListener {
+ public:
+  HistoryQuickProviderPerfTest()
+      : ui_thread_(BrowserThread::UI, &message_loop_),
+        file_thread_(BrowserThread::FILE, &message_loop_) {}
+
+  // AutocompleteProviderListener:
+  virtual void OnProviderUpdate(bool updated_matches) OVERRIDE {}
+
+ protected:
+  static KeyedService* CreateTemplateURLService(
+      content::BrowserContext* profile) {
+    return new TemplateURLService(static_cast<Profile*>(profile));
+  }
+
+  virtual void SetUp() OVERRIDE;
+
+  // Fills kURLs URLs and their visits into the history database.
+  void FillData();
+
+  // Types kTypedText into |provider| kRuns times and returns the time spent
+  // in Start() on this thread, per keystroke.
+  double TimeKeystrokes(HistoryQuickProvider* provider);
+
+  base::MessageLoopForUI message_loop_;
+  content::TestBrowserThread ui_thread_;
+  content::TestBrowserThread file_thread_;
+
+  scoped_ptr<TestingProfile> profile_;
+  HistoryService* history_service_;
+};
+
+void HistoryQuickProviderPerfTest::SetUp() {
+  profile_.reset(new TestingProfile());
+  ASSERT_TRUE(profile_->CreateHistoryService(true, false));
+  profile_->CreateBookmarkModel(true);
+  test::WaitForBookmarkModelToLoad(
+      BookmarkModelFactory::GetForProfile(profile_.get()));
+  profile_->BlockUntilHistoryIndexIsRefreshed();
+  history_service_ =
+      HistoryServiceFactory::GetForProfile(profile_.get(),
+                                           Profile::EXPLICIT_ACCESS);
+  ASSERT_TRUE(history_service_);
+  TemplateURLServiceFactory::GetInstance()->SetTestingFactoryAndUse(
+      profile_.get(), &HistoryQuickProviderPerfTest::CreateTemplateURLService);
+  FillData();
+  history_service_->InMemoryIndex()->RebuildFromHistory(
+      history_service_->history_backend_->db());
+}
+
+void HistoryQuickProviderPerfTest::FillData() {
+  sql::Connection& db(history_service_->history_backend_->db()->GetDB());
+  ASSERT_TRUE(db.is_open());
+
+  const base::Time now = base::Time::Now();
+  sql::Transaction transaction(&db);
+  ASSERT_TRUE(transaction.Begin());
+  size_t visit_id = 1;
+  for (size_t i = 0; i < kURLs; ++i) {
+    const std::string url = base::StringPrintf(
+        "http://site%" PRIuS ".example.com/articles/page%" PRIuS ".html",
+        i % kHosts, i);
+    const std::string title = base::StringPrintf("Article %" PRIuS, i);
+    const base::Time last_visit = now - base::TimeDelta::FromHours(i);
+    sql::Statement url_statement(db.GetUniqueStatement(base::StringPrintf(
+        "INSERT INTO \"urls\" VALUES(%" PRIuS ", \'%s\', \'%s\', %d, %d, %"
+        PRId64 ", 0, 0)",
+        i + 1, url.c_str(), title.c_str(), static_cast<int>(kVisitsPerURL),
+        1, last_visit.ToInternalValue()).c_str()));
+    ASSERT_TRUE(url_statement.Run());
+    for (size_t j = 0; j < kVisitsPerURL; ++j) {
+      const base::Time visit_time =
+          last_visit - base::TimeDelta::FromDays(j);
+      sql::Statement visit_statement(db.GetUniqueStatement(base::StringPrintf(
+          "INSERT INTO \"visits\" VALUES(%" PRIuS ", %" PRIuS ", %" PRId64
+          ", 0, %d, 0, 1)",
+          visit_id++, i + 1, visit_time.ToInternalValue(),
+          (j == 0) ? content::PAGE_TRANSITION_TYPED :
+                     content::PAGE_TRANSITION_LINK).c_str()));
+      ASSERT_TRUE(visit_statement.Run());
+    }
+  }
+  ASSERT_TRUE(transaction.Commit());
+}
+
+double HistoryQuickProviderPerfTest::TimeKeystrokes(
+    HistoryQuickProvider* provider) {
+  const std::string text(kTypedText);
+  base::TimeDelta elapsed;
+  for (size_t run = 0; run < kRuns; ++run) {
+    for (size_t length = 1; length <= text.length(); ++length) {
+      AutocompleteInput input(base::ASCIIToUTF16(text.substr(0, length)),
+                              base::string16::npos, base::string16(), GURL(),
+                              AutocompleteInput::INVALID_SPEC, false, false,
+                              true, true);
+      const base::TimeTicks start = base::TimeTicks::Now();
+      provider->Start(input, false);
+      elapsed += base::TimeTicks::Now() - start;
+      // Let a worker query finish before the next keystroke, as it would
+      // between keystrokes of a user typing.
+      BrowserThread::GetBlockingPool()->FlushForTesting();
+      base::MessageLoop::current()->RunUntilIdle();
+      EXPECT_TRUE(provider->done());
+      EXPECT_FALSE(provider->matches().empty());
+    }
+  }
+  return elapsed.InMicroseconds() /
+      static_cast<double>(kRuns * text.length());
+}
+
+// Times the UI thread work of HistoryQuickProvider::Start() per keystroke,
+// scoring the in-memory URL index on the UI thread and on a worker thread.
+TEST_F(HistoryQuickProviderPerfTest, KeystrokeLatency) {
+  scoped_refptr<HistoryQuickProvider> ui_provider(
+      new HistoryQuickProvider(this, profile_.get()));
+
+  base::FieldTrialList field_trial_list(
+      new metrics::SHA1EntropyProvider("foo"));
+  std::map<std::string, std::string> params;
+  params[OmniboxFieldTrial::kHQPWorkerDeadlineRule] = "30";
+  ASSERT_TRUE(chrome_variations::AssociateVariationParams(
+      OmniboxFieldTrial::kBundledExperimentFieldTrialName, "A", params));
+  base::FieldTrialList::CreateFieldTrial(
+      OmniboxFieldTrial::kBundledExperimentFieldTrialName, "A");
+  scoped_refptr<HistoryQuickProvider> worker_provider(
+      new HistoryQuickProvider(this, profile_.get()));
+  chrome_variations::testing::ClearAllVariationParams();
+
+  const double ui_thread_time = TimeKeystrokes(ui_provider.get());
+  const double worker_time = TimeKeystrokes(worker_provider.get());
+
+  const std::string trace = base::StringPrintf("%" PRIuS "_urls", kURLs);
+  perf_test::PrintResult("hqp_start_ui_thread_scoring", "", trace,
+                         ui_thread_time, "us/keystroke", true);
+  perf_test::PrintResult("hqp_start_worker_scoring", "", trace, worker_time,
+                         "us/keystroke", true);
+}
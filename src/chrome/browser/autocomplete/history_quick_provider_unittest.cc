@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -13,9 +14,12 @@
 #include "base/format_macros.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/message_loop/message_loop.h"
+#include "base/metrics/field_trial.h"
 #include "base/prefs/pref_service.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "base/time/time.h"
 #include "chrome/browser/autocomplete/autocomplete_match.h"
 #include "chrome/browser/autocomplete/autocomplete_provider_listener.h"
 #include "chrome/browser/autocomplete/autocomplete_result.h"
@@ -28,6 +32,7 @@
 #include "chrome/browser/history/in_memory_url_index.h"
 #include "chrome/browser/history/url_database.h"
 #include "chrome/browser/history/url_index_private_data.h"
+#include "chrome/browser/omnibox/omnibox_field_trial.h"
 #include "chrome/browser/search_engines/template_url.h"
 #include "chrome/browser/search_engines/template_url_service.h"
 #include "chrome/browser/search_engines/template_url_service_factory.h"
@@ -35,6 +40,8 @@
 #include "chrome/test/base/testing_browser_process.h"
 #include "chrome/test/base/testing_profile.h"
 #include "components/bookmarks/test/bookmark_test_helpers.h"
+#include "components/variations/entropy_provider.h"
+#include "components/variations/variations_associated_data.h"
 #include "content/public/test/test_browser_thread.h"
 #include "sql/transaction.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -646,6 +653,63 @@ TEST_F(HistoryQuickProviderTest, CullSearchResults) {
                     ASCIIToUTF16(".com"));
 }
 
+// Types a URL one character at a time, scoring the index on the UI thread and
+// on a worker thread, and checks that both give the same matches.
+TEST_F(HistoryQuickProviderTest, WorkerMatchesUIThread) {
+  base::FieldTrialList field_trial_list(
+      new metrics::SHA1EntropyProvider("foo"));
+  std::map<std::string, std::string> params;
+  params[OmniboxFieldTrial::kHQPWorkerDeadlineRule] = "30";
+  ASSERT_TRUE(chrome_variations::AssociateVariationParams(
+      OmniboxFieldTrial::kBundledExperimentFieldTrialName, "A", params));
+  base::FieldTrialList::CreateFieldTrial(
+      OmniboxFieldTrial::kBundledExperimentFieldTrialName, "A");
+  scoped_refptr<HistoryQuickProvider> worker_provider(
+      new HistoryQuickProvider(this, profile_.get()));
+  chrome_variations::testing::ClearAllVariationParams();
+  EXPECT_FALSE(provider_->score_on_worker_);
+  ASSERT_TRUE(worker_provider->score_on_worker_);
+
+  const std::string text("popularsitewithroot.com");
+  for (size_t length = 1; length <= text.length(); ++length) {
+    SCOPED_TRACE(text.substr(0, length));
+    AutocompleteInput input(ASCIIToUTF16(text.substr(0, length)),
+                            base::string16::npos, base::string16(), GURL(),
+                            AutocompleteInput::INVALID_SPEC, false, false,
+                            true, true);
+    provider_->Start(input, false);
+    EXPECT_TRUE(provider_->done());
+
+    worker_provider->Start(input, false);
+    EXPECT_FALSE(worker_provider->done());
+    BrowserThread::GetBlockingPool()->FlushForTesting();
+    base::MessageLoop::current()->RunUntilIdle();
+    ASSERT_TRUE(worker_provider->done());
+
+    const ACMatches& expected = provider_->matches();
+    const ACMatches& actual = worker_provider->matches();
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(expected[i].destination_url, actual[i].destination_url);
+      EXPECT_EQ(expected[i].relevance, actual[i].relevance);
+      EXPECT_EQ(expected[i].allowed_to_be_default_match,
+                actual[i].allowed_to_be_default_match);
+    }
+  }
+
+  // A stopped query reports nothing.
+  worker_provider->Start(
+      AutocompleteInput(ASCIIToUTF16("popular"), base::string16::npos,
+                        base::string16(), GURL(),
+                        AutocompleteInput::INVALID_SPEC, false, false, true,
+                        true),
+      false);
+  worker_provider->Stop(false);
+  BrowserThread::GetBlockingPool()->FlushForTesting();
+  base::MessageLoop::current()->RunUntilIdle();
+  EXPECT_TRUE(worker_provider->matches().empty());
+}
+
 // HQPOrderingTest -------------------------------------------------------------
 
 TestURLInfo ordering_test_db[] = {
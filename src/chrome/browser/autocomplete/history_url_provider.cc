@@ -523,36 +523,49 @@ void HistoryURLProvider::DoAutocomplete(history::HistoryBackend* backend,
   what_you_typed_match.relevance = CalculateRelevance(WHAT_YOU_TYPED, 0);
 
   // Get the matching URLs from the DB
-  history::URLRows url_matches;
   history::HistoryMatches history_matches;
 
   if (search_url_database_) {
     const URLPrefixes& prefixes = URLPrefix::GetURLPrefixes();
+    std::vector<std::string> prefix_strings;
     for (URLPrefixes::const_iterator i(prefixes.begin()); i != prefixes.end();
-         ++i) {
-      if (params->cancel_flag.IsSet())
-        return;  // Canceled in the middle of a query, give up.
-      // We only need kMaxMatches results in the end, but before we
-      // get there we need to promote lower-quality matches that are
-      // prefixes of higher-quality matches, and remove lower-quality
-      // redirects.  So we ask for more results than we need, of every
-      // prefix type, in hopes this will give us far more than enough
-      // to work with.  CullRedirects() will then reduce the list to
-      // the best kMaxMatches results.
-      db->AutocompleteForPrefix(
-          base::UTF16ToUTF8(i->prefix + params->input.text()),
-          kMaxMatches * 2,
-          (backend == NULL),
-          &url_matches);
-      for (history::URLRows::const_iterator j(url_matches.begin());
-           j != url_matches.end(); ++j) {
+         ++i)
+      prefix_strings.push_back(base::UTF16ToUTF8(i->prefix));
+    // We only need kMaxMatches results in the end, but before we get there we
+    // need to promote lower-quality matches that are prefixes of
+    // higher-quality matches, and remove lower-quality redirects.  So we ask
+    // for more results than we need, of every prefix type, in hopes this will
+    // give us far more than enough to work with.  CullRedirects() will then
+    // reduce the list to the best kMaxMatches results.
+    const std::string text(base::UTF16ToUTF8(params->input.text()));
+    std::vector<history::URLRows> url_matches;
+    if (backend) {
+      // The on-disk database runs one query per prefix type; check for
+      // cancellation between them so a newer query need not wait.
+      url_matches.resize(prefix_strings.size());
+      for (size_t i = 0; i < prefix_strings.size(); ++i) {
+        if (params->cancel_flag.IsSet())
+          return;  // Canceled in the middle of a query, give up.
+        db->AutocompleteForPrefix(prefix_strings[i] + text, kMaxMatches * 2,
+                                  false, &url_matches[i]);
+      }
+    } else {
+      // The in-memory database answers every prefix type in one lookup of
+      // its prefix index.
+      db->AutocompleteForPrefixes(prefix_strings, text, kMaxMatches * 2, true,
+                                  &url_matches);
+    }
+    for (size_t i = 0; i < prefixes.size(); ++i) {
+      const URLPrefix& prefix = prefixes[i];
+      for (history::URLRows::const_iterator j(url_matches[i].begin());
+           j != url_matches[i].end(); ++j) {
         const URLPrefix* best_prefix =
             URLPrefix::BestURLPrefix(base::UTF8ToUTF16(j->url().spec()),
                                      base::string16());
         DCHECK(best_prefix != NULL);
-        history_matches.push_back(history::HistoryMatch(*j, i->prefix.length(),
-            i->num_components == 0,
-            i->num_components >= best_prefix->num_components));
+        history_matches.push_back(history::HistoryMatch(*j,
+            prefix.prefix.length(), prefix.num_components == 0,
+            prefix.num_components >= best_prefix->num_components));
       }
     }
   }
@@ -4,7 +4,9 @@
 
 #include "chrome/browser/extensions/api/messaging/extension_message_port.h"
 
+#include "chrome/browser/extensions/api/messaging/shared_message_buffer.h"
 #include "chrome/browser/profiles/profile.h"
+#include "chrome/common/extensions/chrome_extension_messages.h"
 #include "content/public/browser/render_process_host.h"
 #include "extensions/browser/extension_host.h"
 #include "extensions/browser/extension_system.h"
@@ -53,6 +55,23 @@ void ExtensionMessagePort::DispatchOnMessage(const Message& message,
       routing_id_, target_port_id, message));
 }
 
+void ExtensionMessagePort::DispatchOnSharedMessage(
+    const scoped_refptr<SharedMessageBuffer>& buffer,
+    bool user_gesture,
+    int target_port_id) {
+  // If the process is still starting, the handle cannot be shared yet, and
+  // the message is queued with a copy of the payload instead.
+  base::SharedMemoryHandle handle;
+  if (!process_->GetHandle() ||
+      !buffer->ShareToProcess(process_->GetHandle(), &handle)) {
+    MessageService::MessagePort::DispatchOnSharedMessage(
+        buffer, user_gesture, target_port_id);
+    return;
+  }
+  process_->Send(new ChromeExtensionMsg_DeliverSharedMessage(
+      routing_id_, target_port_id, handle, buffer->size(), user_gesture));
+}
+
 void ExtensionMessagePort::IncrementLazyKeepaliveCount() {
   Profile* profile =
       Profile::FromBrowserContext(process_->GetBrowserContext());
@@ -33,6 +33,10 @@ class ExtensionMessagePort : public MessageService::MessagePort {
                                     const std::string& error_message) OVERRIDE;
   virtual void DispatchOnMessage(const Message& message,
                                  int target_port_id) OVERRIDE;
+  virtual void DispatchOnSharedMessage(
+      const scoped_refptr<SharedMessageBuffer>& buffer,
+      bool user_gesture,
+      int target_port_id) OVERRIDE;
   virtual void IncrementLazyKeepaliveCount() OVERRIDE;
   virtual void DecrementLazyKeepaliveCount() OVERRIDE;
   virtual content::RenderProcessHost* GetRenderProcessHost() OVERRIDE;
@@ -16,6 +16,7 @@
 #include "chrome/browser/extensions/api/messaging/extension_message_port.h"
 #include "chrome/browser/extensions/api/messaging/incognito_connectability.h"
 #include "chrome/browser/extensions/api/messaging/native_message_port.h"
+#include "chrome/browser/extensions/api/messaging/shared_message_buffer.h"
 #include "chrome/browser/extensions/api/tabs/tabs_constants.h"
 #include "chrome/browser/extensions/extension_service.h"
 #include "chrome/browser/extensions/extension_tab_util.h"
@@ -135,6 +136,13 @@ content::RenderProcessHost*
   return NULL;
 }
 
+void MessageService::MessagePort::DispatchOnSharedMessage(
+    const scoped_refptr<SharedMessageBuffer>& buffer,
+    bool user_gesture,
+    int target_port_id) {
+  DispatchOnMessage(Message(buffer->GetData(), user_gesture), target_port_id);
+}
+
 // static
 void MessageService::AllocatePortIdPair(int* port1, int* port2) {
   unsigned channel_id =
@@ -570,8 +578,37 @@ void MessageService::PostMessage(int source_port_id, const Message& message) {
   DispatchMessage(source_port_id, iter->second, message);
 }
 
+void MessageService::PostSharedMessage(
+    int source_port_id,
+    const scoped_refptr<SharedMessageBuffer>& buffer,
+    bool user_gesture) {
+  int channel_id = GET_CHANNEL_ID(source_port_id);
+  MessageChannelMap::iterator iter = channels_.find(channel_id);
+  if (iter == channels_.end()) {
+    // Pending messages are rare, so they keep to the ordinary path.
+    EnqueuePendingMessage(source_port_id, channel_id,
+                          Message(buffer->GetData(), user_gesture));
+    return;
+  }
+
+  int dest_port_id;
+  MessagePort* port =
+      GetDestinationPort(source_port_id, iter->second, &dest_port_id);
+  port->DispatchOnSharedMessage(buffer, user_gesture, dest_port_id);
+}
+
 void MessageService::PostMessageFromNativeProcess(int port_id,
                                                   const std::string& message) {
+  // Native hosts may send messages of up to 1MB; copy those into shared
+  // memory once, rather than into an IPC message for the receiver.
+  if (message.size() >= SharedMessageBuffer::kMinSize) {
+    scoped_refptr<SharedMessageBuffer> buffer =
+        SharedMessageBuffer::CreateFromData(message);
+    if (buffer.get()) {
+      PostSharedMessage(port_id, buffer, false /* user_gesture */);
+      return;
+    }
+  }
   PostMessage(port_id, Message(message, false /* user_gesture */));
 }
 
@@ -652,12 +689,21 @@ void MessageService::EnqueuePendingMessageForLazyBackgroundLoad(
 void MessageService::DispatchMessage(int source_port_id,
                                      MessageChannel* channel,
                                      const Message& message) {
+  int dest_port_id;
+  MessagePort* port =
+      GetDestinationPort(source_port_id, channel, &dest_port_id);
+  port->DispatchOnMessage(message, dest_port_id);
+}
+
+// static
+MessageService::MessagePort* MessageService::GetDestinationPort(
+    int source_port_id,
+    MessageChannel* channel,
+    int* dest_port_id) {
   // Figure out which port the ID corresponds to.
-  int dest_port_id = GET_OPPOSITE_PORT_ID(source_port_id);
-  MessagePort* port = IS_OPENER_PORT_ID(dest_port_id) ?
+  *dest_port_id = GET_OPPOSITE_PORT_ID(source_port_id);
+  return IS_OPENER_PORT_ID(*dest_port_id) ?
       channel->opener.get() : channel->receiver.get();
-
-  port->DispatchOnMessage(message, dest_port_id);
 }
 
 bool MessageService::MaybeAddPendingLazyBackgroundPageOpenChannelTask(
@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "base/compiler_specific.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/weak_ptr.h"
 #include "chrome/browser/extensions/api/messaging/message_property_provider.h"
@@ -37,6 +38,7 @@ namespace extensions {
 class Extension;
 class ExtensionHost;
 class LazyBackgroundTaskQueue;
+class SharedMessageBuffer;
 
 // This class manages message and event passing between renderer processes.
 // It maintains a list of processes that are listening to events and a set of
@@ -90,6 +92,15 @@ class MessageService : public BrowserContextKeyedAPI,
     virtual void DispatchOnMessage(const Message& message,
                                    int target_port_id) = 0;
 
+    // Dispatch a message from a native messaging host whose payload is in
+    // |buffer|.  Ports which can take a shared memory handle override this to
+    // pass the handle instead of the payload; by default the payload is copied
+    // and dispatched as above.
+    virtual void DispatchOnSharedMessage(
+        const scoped_refptr<SharedMessageBuffer>& buffer,
+        bool user_gesture,
+        int target_port_id);
+
     // MessagPorts that target extensions will need to adjust their keepalive
     // counts for their lazy background page.
     virtual void IncrementLazyKeepaliveCount() {}
@@ -153,6 +164,13 @@ class MessageService : public BrowserContextKeyedAPI,
   // port if the channel isn't pending.
   void PostMessage(int port_id, const Message& message);
 
+  // Same as above, for a message from a native messaging host whose payload
+  // is in |buffer|.  The payload is only copied if the channel is still
+  // pending.
+  void PostSharedMessage(int port_id,
+                         const scoped_refptr<SharedMessageBuffer>& buffer,
+                         bool user_gesture);
+
   // NativeMessageProcessHost::Client
   virtual void PostMessageFromNativeProcess(
       int port_id,
@@ -216,6 +234,12 @@ class MessageService : public BrowserContextKeyedAPI,
   void DispatchMessage(int port_id, MessageChannel* channel,
                        const Message& message);
 
+  // Returns the port of |channel| which receives the messages posted to
+  // |source_port_id|, and sets |dest_port_id| to its id.
+  static MessagePort* GetDestinationPort(int source_port_id,
+                                         MessageChannel* channel,
+                                         int* dest_port_id);
+
   // Potentially registers a pending task with the LazyBackgroundTaskQueue
   // to open a channel. Returns true if a task was queued.
   // Takes ownership of |params| if true is returned.
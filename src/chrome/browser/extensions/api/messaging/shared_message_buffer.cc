@@ -0,0 +1,66 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/extensions/api/messaging/shared_message_buffer.h"
+
+#include <string.h>
+
+#include "base/metrics/histogram.h"
+
+namespace extensions {
+
+const size_t SharedMessageBuffer::kMinSize = 64 * 1024;
+
+// static
+scoped_refptr<SharedMessageBuffer> SharedMessageBuffer::CreateFromData(
+    const std::string& data) {
+  if (data.empty() || data.size() > kuint32max)
+    return NULL;
+
+  base::SharedMemory shared_memory;
+  base::SharedMemoryCreateOptions options;
+  options.size = data.size();
+  options.share_read_only = true;
+  if (!shared_memory.Create(options) || !shared_memory.Map(data.size()))
+    return NULL;
+  memcpy(shared_memory.memory(), data.data(), data.size());
+
+  // Keep only a read-only mapping, so that receivers cannot be handed a
+  // writable one.
+  base::SharedMemoryHandle readonly_handle;
+  if (!shared_memory.ShareReadOnlyToProcess(base::GetCurrentProcessHandle(),
+                                            &readonly_handle) ||
+      !base::SharedMemory::IsHandleValid(readonly_handle)) {
+    return NULL;
+  }
+  scoped_ptr<base::SharedMemory> readonly_memory(
+      new base::SharedMemory(readonly_handle, /*read_only=*/true));
+  if (!readonly_memory->Map(data.size()))
+    return NULL;
+
+  UMA_HISTOGRAM_MEMORY_KB("Extensions.SharedMessageKB", data.size() / 1024);
+  return new SharedMessageBuffer(readonly_memory.Pass(), data.size());
+}
+
+std::string SharedMessageBuffer::GetData() const {
+  return std::string(static_cast<const char*>(shared_memory_->memory()),
+                     size_);
+}
+
+bool SharedMessageBuffer::ShareToProcess(
+    base::ProcessHandle process,
+    base::SharedMemoryHandle* handle) const {
+  return shared_memory_->ShareToProcess(process, handle) &&
+         base::SharedMemory::IsHandleValid(*handle);
+}
+
+SharedMessageBuffer::SharedMessageBuffer(
+    scoped_ptr<base::SharedMemory> shared_memory,
+    uint32 size)
+    : shared_memory_(shared_memory.Pass()),
+      size_(size) {}
+
+SharedMessageBuffer::~SharedMessageBuffer() {}
+
+}  // namespace extensions
@@ -0,0 +1,61 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_EXTENSIONS_API_MESSAGING_SHARED_MESSAGE_BUFFER_H_
+#define CHROME_BROWSER_EXTENSIONS_API_MESSAGING_SHARED_MESSAGE_BUFFER_H_
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
+#include "base/process/process_handle.h"
+
+namespace extensions {
+
+// The serialized payload of a large message from a native messaging host, in
+// read-only shared memory.  The payload is copied into the buffer once, and the
+// receiving renderer copies it out once; only the handle travels through the
+// IPC channel, in place of the payload being copied into an IPC message,
+// through the channel and back out of the message.  Native messaging is the
+// only producer of these buffers.
+class SharedMessageBuffer
+    : public base::RefCountedThreadSafe<SharedMessageBuffer> {
+ public:
+  // Payloads smaller than this are cheaper to copy into the IPC message than
+  // to put in shared memory.
+  static const size_t kMinSize;
+
+  // Copies |data| into a new buffer.  Returns NULL if the shared memory cannot
+  // be created.
+  static scoped_refptr<SharedMessageBuffer> CreateFromData(
+      const std::string& data);
+
+  uint32 size() const { return size_; }
+
+  // Returns a copy of the payload, for ports which cannot take a handle.
+  std::string GetData() const;
+
+  // Duplicates the handle of the buffer into |process|.  Returns false if the
+  // process is gone.
+  bool ShareToProcess(base::ProcessHandle process,
+                      base::SharedMemoryHandle* handle) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<SharedMessageBuffer>;
+
+  SharedMessageBuffer(scoped_ptr<base::SharedMemory> shared_memory,
+                      uint32 size);
+  ~SharedMessageBuffer();
+
+  scoped_ptr<base::SharedMemory> shared_memory_;
+  uint32 size_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedMessageBuffer);
+};
+
+}  // namespace extensions
+
+#endif  // CHROME_BROWSER_EXTENSIONS_API_MESSAGING_SHARED_MESSAGE_BUFFER_H_
@@ -0,0 +1,93 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/extensions/api/messaging/shared_message_buffer.h"
+
+#include <string>
+
+#include "base/memory/shared_memory.h"
+#include "base/process/process_handle.h"
+#include "chrome/browser/extensions/api/messaging/message_service.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace extensions {
+
+namespace {
+
+// A port which records the messages it is dispatched.
+class RecordingMessagePort : public MessageService::MessagePort {
+ public:
+  RecordingMessagePort() : target_port_id_(-1) {}
+  virtual ~RecordingMessagePort() {}
+
+  virtual void DispatchOnMessage(const Message& message,
+                                 int target_port_id) OVERRIDE {
+    message_ = message;
+    target_port_id_ = target_port_id;
+  }
+
+  const Message& message() const { return message_; }
+  int target_port_id() const { return target_port_id_; }
+
+ private:
+  Message message_;
+  int target_port_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordingMessagePort);
+};
+
+// A payload of |size| bytes which is not all the same byte.
+std::string MakePayload(size_t size) {
+  std::string payload(size, '\0');
+  for (size_t i = 0; i < size; ++i)
+    payload[i] = static_cast<char>('a' + i % 26);
+  return payload;
+}
+
+}  // namespace
+
+TEST(SharedMessageBufferTest, CreateFromData) {
+  const std::string payload = MakePayload(SharedMessageBuffer::kMinSize);
+  scoped_refptr<SharedMessageBuffer> buffer =
+      SharedMessageBuffer::CreateFromData(payload);
+  ASSERT_TRUE(buffer.get());
+  EXPECT_EQ(payload.size(), buffer->size());
+  EXPECT_EQ(payload, buffer->GetData());
+
+  EXPECT_FALSE(SharedMessageBuffer::CreateFromData(std::string()).get());
+}
+
+// A native messaging reply of the largest size hosts may send survives being
+// shared to a receiver and mapped there.
+TEST(SharedMessageBufferTest, ShareToProcess) {
+  const std::string payload = MakePayload(1024 * 1024);
+  scoped_refptr<SharedMessageBuffer> buffer =
+      SharedMessageBuffer::CreateFromData(payload);
+  ASSERT_TRUE(buffer.get());
+
+  base::SharedMemoryHandle handle;
+  ASSERT_TRUE(buffer->ShareToProcess(base::GetCurrentProcessHandle(),
+                                     &handle));
+  base::SharedMemory received(handle, true /* read_only */);
+  ASSERT_TRUE(received.Map(buffer->size()));
+  EXPECT_EQ(payload,
+            std::string(static_cast<const char*>(received.memory()),
+                        buffer->size()));
+}
+
+// Ports which cannot take a handle are dispatched a copy of the payload.
+TEST(SharedMessageBufferTest, DefaultPortCopiesPayload) {
+  const std::string payload = MakePayload(SharedMessageBuffer::kMinSize);
+  scoped_refptr<SharedMessageBuffer> buffer =
+      SharedMessageBuffer::CreateFromData(payload);
+  ASSERT_TRUE(buffer.get());
+
+  RecordingMessagePort port;
+  port.DispatchOnSharedMessage(buffer, true /* user_gesture */, 7);
+  EXPECT_EQ(7, port.target_port_id());
+  EXPECT_EQ(payload, port.message().data);
+  EXPECT_TRUE(port.message().user_gesture);
+}
+
+}  // namespace extensions
@@ -0,0 +1,274 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/extensions/api/storage/coalescing_value_store.h"
+
+#include "base/logging.h"
+#include "base/metrics/histogram.h"
+#include "base/values.h"
+#include "extensions/browser/value_store/value_store_change.h"
+#include "extensions/browser/value_store/value_store_util.h"
+
+namespace util = value_store_util;
+
+namespace extensions {
+
+ValueStoreCommitScheduler::ValueStoreCommitScheduler(base::TimeDelta delay)
+    : delay_(delay) {}
+
+ValueStoreCommitScheduler::~ValueStoreCommitScheduler() {
+  DCHECK(scheduled_.empty());
+}
+
+void ValueStoreCommitScheduler::Schedule(CoalescingValueStore* store) {
+  scheduled_.insert(store);
+  if (!timer_.IsRunning()) {
+    timer_.Start(
+        FROM_HERE, delay_, this, &ValueStoreCommitScheduler::CommitAll);
+  }
+}
+
+void ValueStoreCommitScheduler::Cancel(CoalescingValueStore* store) {
+  scheduled_.erase(store);
+  if (scheduled_.empty())
+    timer_.Stop();
+}
+
+void ValueStoreCommitScheduler::CommitAll() {
+  std::set<CoalescingValueStore*> scheduled;
+  scheduled.swap(scheduled_);
+  timer_.Stop();
+  for (std::set<CoalescingValueStore*>::iterator it = scheduled.begin();
+       it != scheduled.end(); ++it) {
+    (*it)->Commit();
+  }
+}
+
+CoalescingValueStore::CoalescingValueStore(
+    const scoped_refptr<ValueStoreCommitScheduler>& scheduler,
+    scoped_ptr<ValueStore> delegate)
+    : scheduler_(scheduler),
+      delegate_(delegate.Pass()),
+      pending_writes_(0) {}
+
+CoalescingValueStore::~CoalescingValueStore() {
+  Commit();
+}
+
+void CoalescingValueStore::Commit() {
+  scheduler_->Cancel(this);
+  if (pending_.empty())
+    return;
+
+  base::DictionaryValue settings;
+  std::vector<std::string> removed_keys;
+  for (PendingMap::iterator it = pending_.begin(); it != pending_.end();
+       ++it) {
+    if (it->second.get())
+      settings.SetWithoutPathExpansion(it->first, it->second.release());
+    else
+      removed_keys.push_back(it->first);
+  }
+  UMA_HISTOGRAM_COUNTS_1000("Extensions.Storage.WritesPerCommit",
+                            pending_writes_);
+  pending_.clear();
+  pending_writes_ = 0;
+
+  // Quota was enforced when the writes were made.
+  std::string error;
+  if (!removed_keys.empty()) {
+    WriteResult result = delegate_->Remove(removed_keys);
+    if (result->HasError())
+      error = "Failed to commit removed settings: " + result->error().message;
+  }
+  if (!settings.empty()) {
+    WriteResult result = delegate_->Set(IGNORE_QUOTA, settings);
+    if (result->HasError() && error.empty())
+      error = "Failed to commit settings: " + result->error().message;
+  }
+  UMA_HISTOGRAM_BOOLEAN("Extensions.Storage.CommitFailed", !error.empty());
+  if (!error.empty()) {
+    LOG(WARNING) << error;
+    if (!commit_error_callback_.is_null())
+      commit_error_callback_.Run(error);
+  }
+}
+
+size_t CoalescingValueStore::GetBytesInUse(const std::string& key) {
+  Commit();
+  return delegate_->GetBytesInUse(key);
+}
+
+size_t CoalescingValueStore::GetBytesInUse(
+    const std::vector<std::string>& keys) {
+  Commit();
+  return delegate_->GetBytesInUse(keys);
+}
+
+size_t CoalescingValueStore::GetBytesInUse() {
+  Commit();
+  return delegate_->GetBytesInUse();
+}
+
+ValueStore::ReadResult CoalescingValueStore::Get(const std::string& key) {
+  return Get(std::vector<std::string>(1, key));
+}
+
+ValueStore::ReadResult CoalescingValueStore::Get(
+    const std::vector<std::string>& keys) {
+  ReadResult result = delegate_->Get(keys);
+  if (!result->HasError())
+    ApplyPending(&keys, &result->settings());
+  return result.Pass();
+}
+
+ValueStore::ReadResult CoalescingValueStore::Get() {
+  ReadResult result = delegate_->Get();
+  if (!result->HasError())
+    ApplyPending(NULL, &result->settings());
+  return result.Pass();
+}
+
+ValueStore::WriteResult CoalescingValueStore::Set(
+    WriteOptions options, const std::string& key, const base::Value& value) {
+  base::DictionaryValue current;
+  scoped_ptr<Error> error =
+      ReadCurrent(std::vector<std::string>(1, key), &current);
+  if (error)
+    return MakeWriteResult(error.Pass());
+
+  scoped_ptr<ValueStoreChangeList> changes(new ValueStoreChangeList());
+  Write(key, make_scoped_ptr(value.DeepCopy()), &current, changes.get());
+  return MakeWriteResult(changes.Pass());
+}
+
+ValueStore::WriteResult CoalescingValueStore::Set(
+    WriteOptions options, const base::DictionaryValue& settings) {
+  std::vector<std::string> keys;
+  for (base::DictionaryValue::Iterator it(settings); !it.IsAtEnd();
+       it.Advance()) {
+    keys.push_back(it.key());
+  }
+  base::DictionaryValue current;
+  scoped_ptr<Error> error = ReadCurrent(keys, &current);
+  if (error)
+    return MakeWriteResult(error.Pass());
+
+  scoped_ptr<ValueStoreChangeList> changes(new ValueStoreChangeList());
+  for (base::DictionaryValue::Iterator it(settings); !it.IsAtEnd();
+       it.Advance()) {
+    Write(it.key(), make_scoped_ptr(it.value().DeepCopy()), &current,
+          changes.get());
+  }
+  return MakeWriteResult(changes.Pass());
+}
+
+ValueStore::WriteResult CoalescingValueStore::Remove(const std::string& key) {
+  return Remove(std::vector<std::string>(1, key));
+}
+
+ValueStore::WriteResult CoalescingValueStore::Remove(
+    const std::vector<std::string>& keys) {
+  base::DictionaryValue current;
+  scoped_ptr<Error> error = ReadCurrent(keys, &current);
+  if (error)
+    return MakeWriteResult(error.Pass());
+
+  scoped_ptr<ValueStoreChangeList> changes(new ValueStoreChangeList());
+  for (std::vector<std::string>::const_iterator it = keys.begin();
+       it != keys.end(); ++it) {
+    Write(*it, scoped_ptr<base::Value>(), &current, changes.get());
+  }
+  return MakeWriteResult(changes.Pass());
+}
+
+ValueStore::WriteResult CoalescingValueStore::Clear() {
+  Commit();
+  return delegate_->Clear();
+}
+
+bool CoalescingValueStore::Restore() {
+  Commit();
+  return delegate_->Restore();
+}
+
+bool CoalescingValueStore::RestoreKey(const std::string& key) {
+  Commit();
+  return delegate_->RestoreKey(key);
+}
+
+void CoalescingValueStore::ApplyPending(const std::vector<std::string>* keys,
+                                        base::DictionaryValue* settings) const {
+  if (keys) {
+    for (std::vector<std::string>::const_iterator it = keys->begin();
+         it != keys->end(); ++it) {
+      PendingMap::const_iterator pending = pending_.find(*it);
+      if (pending == pending_.end())
+        continue;
+      if (pending->second.get())
+        settings->SetWithoutPathExpansion(*it, pending->second->DeepCopy());
+      else
+        settings->RemoveWithoutPathExpansion(*it, NULL);
+    }
+    return;
+  }
+
+  for (PendingMap::const_iterator it = pending_.begin(); it != pending_.end();
+       ++it) {
+    if (it->second.get())
+      settings->SetWithoutPathExpansion(it->first, it->second->DeepCopy());
+    else
+      settings->RemoveWithoutPathExpansion(it->first, NULL);
+  }
+}
+
+scoped_ptr<ValueStore::Error> CoalescingValueStore::ReadCurrent(
+    const std::vector<std::string>& keys,
+    base::DictionaryValue* current) {
+  // Only keys without pending writes need a read from the delegate.
+  std::vector<std::string> unread_keys;
+  for (std::vector<std::string>::const_iterator it = keys.begin();
+       it != keys.end(); ++it) {
+    if (!pending_.count(*it))
+      unread_keys.push_back(*it);
+  }
+  if (!unread_keys.empty()) {
+    ReadResult result = delegate_->Get(unread_keys);
+    if (result->HasError()) {
+      const Error& error = result->error();
+      return make_scoped_ptr(new Error(
+          error.code,
+          error.message,
+          error.key ? util::NewKey(*error.key) : util::NoKey()));
+    }
+    result->settings().Swap(current);
+  }
+  ApplyPending(&keys, current);
+  return scoped_ptr<Error>();
+}
+
+void CoalescingValueStore::Write(const std::string& key,
+                                 scoped_ptr<base::Value> value,
+                                 base::DictionaryValue* current,
+                                 ValueStoreChangeList* changes) {
+  scoped_ptr<base::Value> old_value;
+  current->RemoveWithoutPathExpansion(key, &old_value);
+  const bool unchanged =
+      value ? old_value && old_value->Equals(value.get()) : !old_value;
+  if (unchanged) {
+    if (old_value)
+      current->SetWithoutPathExpansion(key, old_value.release());
+    return;
+  }
+
+  changes->push_back(ValueStoreChange(
+      key, old_value.release(), value ? value->DeepCopy() : NULL));
+  if (value)
+    current->SetWithoutPathExpansion(key, value->DeepCopy());
+  pending_[key] = make_linked_ptr(value.release());
+  ++pending_writes_;
+  scheduler_->Schedule(this);
+}
+
+}  // namespace extensions
@@ -0,0 +1,145 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_EXTENSIONS_API_STORAGE_COALESCING_VALUE_STORE_H_
+#define CHROME_BROWSER_EXTENSIONS_API_STORAGE_COALESCING_VALUE_STORE_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/compiler_specific.h"
+#include "base/memory/linked_ptr.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "extensions/browser/value_store/value_store.h"
+
+namespace extensions {
+
+class CoalescingValueStore;
+
+// Commits the pending writes of a set of CoalescingValueStores together, a
+// short while after the first of them is written to, so that the stores of
+// all extensions share one timer.  Lives on the FILE thread.
+class ValueStoreCommitScheduler
+    : public base::RefCounted<ValueStoreCommitScheduler> {
+ public:
+  explicit ValueStoreCommitScheduler(base::TimeDelta delay);
+
+  // Commits the writes of |store| once the delay is over.
+  void Schedule(CoalescingValueStore* store);
+
+  // |store| committed its writes or is going away.
+  void Cancel(CoalescingValueStore* store);
+
+  // Commits the writes of every scheduled store now.
+  void CommitAll();
+
+ private:
+  friend class base::RefCounted<ValueStoreCommitScheduler>;
+
+  ~ValueStoreCommitScheduler();
+
+  const base::TimeDelta delay_;
+  std::set<CoalescingValueStore*> scheduled_;
+  base::OneShotTimer<ValueStoreCommitScheduler> timer_;
+
+  DISALLOW_COPY_AND_ASSIGN(ValueStoreCommitScheduler);
+};
+
+// Decorates a ValueStore with write-behind: set() and remove() only update
+// an in-memory overlay, which is committed to the delegate by the scheduler
+// as one Set() and one Remove() however many calls made it up.  Extensions
+// which write the same keys in a tight loop then cost one write per key per
+// commit, instead of one for every call.
+//
+// Writes report their changes right away, computed against the overlay, so
+// layers above (quota, sync) see the same changes as without it.  Since the
+// delegate is only written later, failures to commit cannot be returned to
+// the caller; they are reported to the commit error callback instead, so
+// that sync can be told.  Reads still go to the delegate and report its
+// errors.
+class CoalescingValueStore : public ValueStore {
+ public:
+  // Called with the error message when pending writes, whose changes were
+  // already returned, fail to reach the delegate.  The writes are dropped.
+  typedef base::Callback<void(const std::string& message)>
+      CommitErrorCallback;
+
+  CoalescingValueStore(
+      const scoped_refptr<ValueStoreCommitScheduler>& scheduler,
+      scoped_ptr<ValueStore> delegate);
+  virtual ~CoalescingValueStore();
+
+  // Writes the pending changes to the delegate.
+  void Commit();
+
+  bool HasPendingWrites() const { return !pending_.empty(); }
+
+  void set_commit_error_callback(const CommitErrorCallback& callback) {
+    commit_error_callback_ = callback;
+  }
+
+  // ValueStore implementation.
+  virtual size_t GetBytesInUse(const std::string& key) OVERRIDE;
+  virtual size_t GetBytesInUse(const std::vector<std::string>& keys) OVERRIDE;
+  virtual size_t GetBytesInUse() OVERRIDE;
+  virtual ReadResult Get(const std::string& key) OVERRIDE;
+  virtual ReadResult Get(const std::vector<std::string>& keys) OVERRIDE;
+  virtual ReadResult Get() OVERRIDE;
+  virtual WriteResult Set(
+      WriteOptions options,
+      const std::string& key,
+      const base::Value& value) OVERRIDE;
+  virtual WriteResult Set(
+      WriteOptions options, const base::DictionaryValue& values) OVERRIDE;
+  virtual WriteResult Remove(const std::string& key) OVERRIDE;
+  virtual WriteResult Remove(const std::vector<std::string>& keys) OVERRIDE;
+  virtual WriteResult Clear() OVERRIDE;
+  virtual bool Restore() OVERRIDE;
+  virtual bool RestoreKey(const std::string& key) OVERRIDE;
+
+  ValueStore* delegate() { return delegate_.get(); }
+
+ private:
+  // The value of each key written since the last commit; NULL if the key
+  // was removed.
+  typedef std::map<std::string, linked_ptr<base::Value> > PendingMap;
+
+  // Applies the pending writes to |settings|, which holds the delegate's
+  // values for |keys|, or for every key if |keys| is NULL.
+  void ApplyPending(const std::vector<std::string>* keys,
+                    base::DictionaryValue* settings) const;
+
+  // Reads the current values of |keys| into |current|, from the pending
+  // writes or else from the delegate.
+  scoped_ptr<Error> ReadCurrent(const std::vector<std::string>& keys,
+                                base::DictionaryValue* current);
+
+  // Sets |key| to |value|, or removes it if |value| is NULL, and appends the
+  // change from its value in |current| to |changes|.
+  void Write(const std::string& key,
+             scoped_ptr<base::Value> value,
+             base::DictionaryValue* current,
+             ValueStoreChangeList* changes);
+
+  scoped_refptr<ValueStoreCommitScheduler> scheduler_;
+  scoped_ptr<ValueStore> delegate_;
+  PendingMap pending_;
+
+  // The number of writes since the last commit.
+  int pending_writes_;
+
+  CommitErrorCallback commit_error_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(CoalescingValueStore);
+};
+
+}  // namespace extensions
+
+#endif  // CHROME_BROWSER_EXTENSIONS_API_STORAGE_COALESCING_VALUE_STORE_H_
@@ -0,0 +1,159 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/extensions/api/storage/coalescing_value_store.h"
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "content/public/test/test_browser_thread.h"
+#include "extensions/browser/value_store/leveldb_value_store.h"
+#include "extensions/browser/value_store/testing_value_store.h"
+#include "extensions/browser/value_store/value_store_unittest.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace extensions {
+
+namespace {
+
+const ValueStore::WriteOptions DEFAULTS = ValueStore::DEFAULTS;
+
+ValueStore* Param(const base::FilePath& file_path) {
+  return new CoalescingValueStore(
+      make_scoped_refptr(new ValueStoreCommitScheduler(base::TimeDelta())),
+      scoped_ptr<ValueStore>(new LeveldbValueStore(file_path)));
+}
+
+void AppendError(std::vector<std::string>* errors, const std::string& error) {
+  errors->push_back(error);
+}
+
+}  // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    CoalescingValueStore,
+    ValueStoreTest,
+    testing::Values(&Param));
+
+class CoalescingValueStoreTest : public testing::Test {
+ public:
+  CoalescingValueStoreTest()
+      : file_thread_(content::BrowserThread::FILE, &loop_),
+        scheduler_(new ValueStoreCommitScheduler(
+            base::TimeDelta::FromMilliseconds(500))) {}
+
+ protected:
+  // Returns a store over a TestingValueStore, which is returned in
+  // |delegate|.
+  scoped_ptr<CoalescingValueStore> CreateStore(TestingValueStore** delegate) {
+    *delegate = new TestingValueStore();
+    return make_scoped_ptr(new CoalescingValueStore(
+        scheduler_, scoped_ptr<ValueStore>(*delegate)));
+  }
+
+  base::MessageLoop loop_;
+  content::TestBrowserThread file_thread_;
+  scoped_refptr<ValueStoreCommitScheduler> scheduler_;
+};
+
+TEST_F(CoalescingValueStoreTest, CoalescesWrites) {
+  TestingValueStore* delegate;
+  scoped_ptr<CoalescingValueStore> store = CreateStore(&delegate);
+
+  base::FundamentalValue one(1);
+  base::FundamentalValue two(2);
+  ValueStore::WriteResult result = store->Set(DEFAULTS, "a", one);
+  ASSERT_FALSE(result->HasError());
+  EXPECT_EQ(1u, result->changes().size());
+  result = store->Set(DEFAULTS, "a", two);
+  ASSERT_EQ(1u, result->changes().size());
+  EXPECT_TRUE(result->changes()[0].old_value()->Equals(&one));
+  EXPECT_TRUE(result->changes()[0].new_value()->Equals(&two));
+  result = store->Set(DEFAULTS, "b", one);
+  EXPECT_EQ(1u, result->changes().size());
+  result = store->Remove("b");
+  ASSERT_EQ(1u, result->changes().size());
+  EXPECT_FALSE(result->changes()[0].new_value());
+
+  // Setting a value again, or removing a missing key, changes nothing.
+  EXPECT_TRUE(store->Set(DEFAULTS, "a", two)->changes().empty());
+  EXPECT_TRUE(store->Remove("c")->changes().empty());
+
+  // Reads see the pending writes, which have not reached the delegate.
+  EXPECT_EQ(0, delegate->write_count());
+  ValueStore::ReadResult read = store->Get();
+  ASSERT_FALSE(read->HasError());
+  EXPECT_EQ(1u, read->settings().size());
+  const base::Value* value = NULL;
+  ASSERT_TRUE(read->settings().GetWithoutPathExpansion("a", &value));
+  EXPECT_TRUE(value->Equals(&two));
+  EXPECT_TRUE(store->HasPendingWrites());
+
+  scheduler_->CommitAll();
+  EXPECT_FALSE(store->HasPendingWrites());
+  EXPECT_EQ(2, delegate->write_count());
+  read = delegate->Get();
+  EXPECT_EQ(1u, read->settings().size());
+  ASSERT_TRUE(read->settings().GetWithoutPathExpansion("a", &value));
+  EXPECT_TRUE(value->Equals(&two));
+}
+
+TEST_F(CoalescingValueStoreTest, ReportsReadErrors) {
+  TestingValueStore* delegate;
+  scoped_ptr<CoalescingValueStore> store = CreateStore(&delegate);
+
+  delegate->set_error_code(ValueStore::CORRUPTION);
+  base::FundamentalValue one(1);
+  EXPECT_TRUE(store->Set(DEFAULTS, "a", one)->HasError());
+  EXPECT_TRUE(store->Get()->HasError());
+  EXPECT_FALSE(store->HasPendingWrites());
+}
+
+TEST_F(CoalescingValueStoreTest, CommitsWhenScheduled) {
+  scheduler_ = new ValueStoreCommitScheduler(base::TimeDelta());
+  TestingValueStore* delegate;
+  scoped_ptr<CoalescingValueStore> store = CreateStore(&delegate);
+  base::FundamentalValue one(1);
+  store->Set(DEFAULTS, "a", one);
+  EXPECT_EQ(0, delegate->write_count());
+
+  loop_.RunUntilIdle();
+  EXPECT_FALSE(store->HasPendingWrites());
+  EXPECT_EQ(1, delegate->write_count());
+}
+
+TEST_F(CoalescingValueStoreTest, ReportsCommitErrors) {
+  TestingValueStore* delegate;
+  scoped_ptr<CoalescingValueStore> store = CreateStore(&delegate);
+  std::vector<std::string> errors;
+  store->set_commit_error_callback(base::Bind(&AppendError, &errors));
+
+  base::FundamentalValue one(1);
+  ASSERT_FALSE(store->Set(DEFAULTS, "a", one)->HasError());
+  scheduler_->CommitAll();
+  EXPECT_TRUE(errors.empty());
+
+  // The write succeeds, since "a" is read from the pending writes, but its
+  // commit fails.
+  base::FundamentalValue two(2);
+  delegate->set_error_code(ValueStore::CORRUPTION);
+  ASSERT_FALSE(store->Set(DEFAULTS, "a", two)->HasError());
+  EXPECT_TRUE(store->Set(DEFAULTS, "b", two)->HasError());
+  scheduler_->CommitAll();
+  EXPECT_EQ(1u, errors.size());
+  EXPECT_FALSE(store->HasPendingWrites());
+
+  // The failed write is dropped.
+  delegate->set_error_code(ValueStore::OK);
+  ValueStore::ReadResult read = store->Get("a");
+  const base::Value* value = NULL;
+  ASSERT_TRUE(read->settings().GetWithoutPathExpansion("a", &value));
+  EXPECT_TRUE(value->Equals(&one));
+}
+
+}  // namespace extensions
@@ -8,6 +8,7 @@
 #include "base/json/json_writer.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
 #include "chrome/browser/extensions/api/storage/settings_sync_util.h"
 #include "chrome/browser/extensions/api/storage/sync_value_store_cache.h"
 #include "chrome/browser/extensions/api/storage/syncable_settings_storage.h"
@@ -23,6 +24,7 @@
 #include "sync/api/sync_change_processor_wrapper_for_test.h"
 #include "sync/api/sync_error_factory.h"
 #include "sync/api/sync_error_factory_mock.h"
+#include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 using base::DictionaryValue;
@@ -987,6 +989,77 @@ TEST_F(ExtensionSettingsSyncTest, FailingProcessChangesDisablesSync) {
   }
 }
 
+TEST_F(ExtensionSettingsSyncTest, FailingCommitDisablesSync) {
+  syncer::ModelType model_type = syncer::EXTENSION_SETTINGS;
+  Manifest::Type type = Manifest::TYPE_EXTENSION;
+
+  base::StringValue fooValue("fooValue");
+  base::StringValue barValue("barValue");
+
+  TestingValueStoreFactory* testing_factory = new TestingValueStoreFactory();
+  storage_factory_->Reset(testing_factory);
+
+  ValueStore* good = AddExtensionAndGetStorage("good", type);
+  ValueStore* bad = AddExtensionAndGetStorage("bad", type);
+
+  syncer::SyncErrorFactoryMock* error_factory =
+      new syncer::SyncErrorFactoryMock();
+  EXPECT_CALL(*error_factory, CreateAndUploadError(testing::_, testing::_))
+      .WillOnce(testing::Return(syncer::SyncError()));
+  GetSyncableService(model_type)->MergeDataAndStartSyncing(
+      model_type,
+      syncer::SyncDataList(),
+      sync_processor_wrapper_.PassAs<syncer::SyncChangeProcessor>(),
+      scoped_ptr<syncer::SyncErrorFactory>(error_factory));
+
+  // Both writes are sent to sync, but the one of bad fails when it is
+  // committed, which happens after a delay.
+  good->Set(DEFAULTS, "foo", fooValue);
+  bad->Set(DEFAULTS, "foo", fooValue);
+  EXPECT_EQ(2u, sync_processor_->changes().size());
+  testing_factory->GetExisting("bad")->set_error_code(ValueStore::CORRUPTION);
+  {
+    base::RunLoop run_loop;
+    message_loop_.PostDelayedTask(FROM_HERE,
+                                  run_loop.QuitClosure(),
+                                  base::TimeDelta::FromSeconds(2));
+    run_loop.Run();
+  }
+  testing_factory->GetExisting("bad")->set_error_code(ValueStore::OK);
+  EXPECT_PRED_FORMAT2(SettingsEq, base::DictionaryValue(), bad->Get());
+
+  // bad no longer sends changes to sync.
+  sync_processor_->ClearChanges();
+  good->Set(DEFAULTS, "bar", barValue);
+  bad->Set(DEFAULTS, "bar", barValue);
+  EXPECT_EQ(
+      syncer::SyncChange::ACTION_ADD,
+      sync_processor_->GetOnlyChange("good", "bar").change_type());
+  EXPECT_EQ(1u, sync_processor_->changes().size());
+
+  // When sync starts again, bad takes the setting which failed to commit
+  // back from sync.
+  GetSyncableService(model_type)->StopSyncing(model_type);
+  sync_processor_wrapper_.reset(
+      new syncer::SyncChangeProcessorWrapperForTest(sync_processor_.get()));
+  {
+    syncer::SyncDataList sync_data;
+    sync_data.push_back(settings_sync_util::CreateData(
+          "bad", "foo", fooValue, model_type));
+    GetSyncableService(model_type)->MergeDataAndStartSyncing(
+        model_type,
+        sync_data,
+        sync_processor_wrapper_.PassAs<syncer::SyncChangeProcessor>(),
+        scoped_ptr<syncer::SyncErrorFactory>(
+            new syncer::SyncErrorFactoryMock()));
+  }
+  {
+    base::DictionaryValue dict;
+    dict.Set("foo", fooValue.DeepCopy());
+    EXPECT_PRED_FORMAT2(SettingsEq, dict, bad->Get());
+  }
+}
+
 TEST_F(ExtensionSettingsSyncTest, FailingGetAllSyncDataDoesntStopSync) {
   syncer::ModelType model_type = syncer::EXTENSION_SETTINGS;
   Manifest::Type type = Manifest::TYPE_EXTENSION;
@@ -4,8 +4,10 @@
 
 #include "chrome/browser/extensions/api/storage/sync_storage_backend.h"
 
+#include "base/bind.h"
 #include "base/files/file_enumerator.h"
 #include "base/logging.h"
+#include "chrome/browser/extensions/api/storage/coalescing_value_store.h"
 #include "chrome/browser/extensions/api/storage/settings_sync_processor.h"
 #include "chrome/browser/extensions/api/storage/settings_sync_util.h"
 #include "chrome/browser/extensions/api/storage/syncable_settings_storage.h"
@@ -18,6 +20,9 @@ namespace extensions {
 
 namespace {
 
+// How long writes to a storage area are coalesced before they are committed.
+const int kCommitDelayMs = 500;
+
 void AddAllSyncData(const std::string& extension_id,
                     const base::DictionaryValue& src,
                     syncer::ModelType type,
@@ -41,8 +46,11 @@ SyncStorageBackend::SyncStorageBackend(
       base_path_(base_path),
       quota_(quota),
       observers_(observers),
+      commit_scheduler_(new ValueStoreCommitScheduler(
+          base::TimeDelta::FromMilliseconds(kCommitDelayMs))),
       sync_type_(sync_type),
-      flare_(flare) {
+      flare_(flare),
+      weak_factory_(this) {
   DCHECK_CURRENTLY_ON(BrowserThread::FILE);
   DCHECK(sync_type_ == syncer::EXTENSION_SETTINGS ||
          sync_type_ == syncer::APP_SETTINGS);
@@ -66,9 +74,17 @@ SyncableSettingsStorage* SyncStorageBackend::GetOrCreateStorageWithSyncData(
     return maybe_storage->second.get();
   }
 
+  // Writes are coalesced underneath the quota enforcer, which still sees
+  // every write and its changes as they are made.
+  CoalescingValueStore* coalescing_storage = new CoalescingValueStore(
+      commit_scheduler_,
+      make_scoped_ptr(storage_factory_->Create(base_path_, extension_id)));
+  coalescing_storage->set_commit_error_callback(
+      base::Bind(&SyncStorageBackend::OnCommitError,
+                 weak_factory_.GetWeakPtr(),
+                 extension_id));
   scoped_ptr<SettingsStorageQuotaEnforcer> storage(
-      new SettingsStorageQuotaEnforcer(
-          quota_, storage_factory_->Create(base_path_, extension_id)));
+      new SettingsStorageQuotaEnforcer(quota_, coalescing_storage));
 
   // It's fine to create the quota enforcer underneath the sync layer, since
   // sync will only go ahead if each underlying storage operation succeeds.
@@ -284,4 +300,20 @@ SyncStorageBackend::CreateSettingsSyncProcessor(const std::string& extension_id)
       extension_id, sync_type_, sync_processor_.get()));
 }
 
+void SyncStorageBackend::OnCommitError(const std::string& extension_id,
+                                       const std::string& message) {
+  DCHECK_CURRENTLY_ON(BrowserThread::FILE);
+  StorageObjMap::iterator maybe_storage = storage_objs_.find(extension_id);
+  if (maybe_storage == storage_objs_.end() || !sync_processor_.get())
+    return;
+
+  // Sync has changes which never reached disk.  Stop syncing the area, so
+  // that it is merged with sync again, and takes those changes back from it,
+  // the next time sync starts.
+  maybe_storage->second->StopSyncing();
+  sync_error_factory_->CreateAndUploadError(
+      FROM_HERE,
+      "Failed to commit settings of " + extension_id + ": " + message);
+}
+
 }  // namespace extensions
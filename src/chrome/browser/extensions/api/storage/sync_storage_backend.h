@@ -14,6 +14,7 @@
 #include "base/memory/linked_ptr.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/weak_ptr.h"
 #include "extensions/browser/api/storage/settings_observer.h"
 #include "extensions/browser/api/storage/settings_storage_factory.h"
 #include "extensions/browser/api/storage/settings_storage_quota_enforcer.h"
@@ -27,6 +28,7 @@ namespace extensions {
 
 class SettingsSyncProcessor;
 class SyncableSettingsStorage;
+class ValueStoreCommitScheduler;
 
 // Manages ValueStore objects for extensions, including routing
 // changes from sync to them.
@@ -78,6 +80,11 @@ class SyncStorageBackend : public syncer::SyncableService {
   scoped_ptr<SettingsSyncProcessor> CreateSettingsSyncProcessor(
       const std::string& extension_id) const;
 
+  // Called when the storage area of |extension_id| failed to commit writes
+  // whose changes were already sent to sync.
+  void OnCommitError(const std::string& extension_id,
+                     const std::string& message);
+
   // The Factory to use for creating new ValueStores.
   const scoped_refptr<SettingsStorageFactory> storage_factory_;
 
@@ -90,6 +97,11 @@ class SyncStorageBackend : public syncer::SyncableService {
   // The list of observers to settings changes.
   const scoped_refptr<SettingsObserverList> observers_;
 
+  // Commits the coalesced writes of every storage area.  Declared before
+  // |storage_objs_| so that the areas commit their last writes before it
+  // goes away.
+  const scoped_refptr<ValueStoreCommitScheduler> commit_scheduler_;
+
   // A cache of ValueStore objects that have already been created.
   // Ensure that there is only ever one created per extension.
   typedef std::map<std::string, linked_ptr<SyncableSettingsStorage> >
@@ -107,6 +119,11 @@ class SyncStorageBackend : public syncer::SyncableService {
 
   syncer::SyncableService::StartSyncFlare flare_;
 
+  // Invalidated first, so that storage areas committing as they are destroyed
+  // do not call back into a backend which is going away.  Mutable since
+  // storage areas are created lazily by const methods.
+  mutable base::WeakPtrFactory<SyncStorageBackend> weak_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(SyncStorageBackend);
 };
 
@@ -4,12 +4,20 @@
 
 #include "chrome/browser/extensions/user_script_master.h"
 
+#include <map>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/bind_helpers.h"
 #include "base/file_util.h"
 #include "base/files/file_path.h"
+#include "base/lazy_instance.h"
+#include "base/metrics/histogram.h"
+#include "base/pickle.h"
+#include "base/sha1.h"
+#include "base/synchronization/lock.h"
 #include "base/version.h"
 #include "chrome/browser/chrome_notification_types.h"
 #include "chrome/browser/extensions/extension_service.h"
@@ -17,7 +25,9 @@
 #include "chrome/browser/extensions/image_loader.h"
 #include "chrome/browser/profiles/profile.h"
 #include "chrome/common/extensions/api/i18n/default_locale_handler.h"
+#include "chrome/common/extensions/chrome_extension_messages.h"
 #include "chrome/common/extensions/manifest_handlers/content_scripts_handler.h"
+#include "chrome/common/extensions/user_script_bundle.h"
 #include "content/public/browser/notification_service.h"
 #include "content/public/browser/render_process_host.h"
 #include "extensions/browser/content_verifier.h"
@@ -31,6 +41,37 @@ using content::BrowserThread;
 
 namespace extensions {
 
+namespace {
+
+// The shared bundles, by the SHA-1 of their image.  The registry holds a
+// reference to each bundle, and drops those which no master holds any more
+// whenever a bundle is looked up.
+struct SharedBundleRegistry {
+  base::Lock lock;
+  std::map<std::string, scoped_refptr<UserScriptMaster::SharedBundle> >
+      bundles;
+};
+
+base::LazyInstance<SharedBundleRegistry> g_shared_bundles =
+    LAZY_INSTANCE_INITIALIZER;
+
+// Whether renderers are sent one UserScriptBundle segment per extension.
+// Otherwise they are sent all of the scripts in one pickled segment, which is
+// kept under the empty extension id.  Renderers only read the pickled segment,
+// so segments are only sent in tests until they can read those too.
+bool g_use_script_segments = false;
+
+bool UseScriptSegments() {
+  return g_use_script_segments;
+}
+
+}  // namespace
+
+// static
+void UserScriptMaster::SetUseScriptSegmentsForTesting(bool use_segments) {
+  g_use_script_segments = use_segments;
+}
+
 // Helper function to parse greasesmonkey headers
 static bool GetDeclarationValue(const base::StringPiece& line,
                                 const base::StringPiece& prefix,
@@ -151,6 +192,7 @@ bool UserScriptMaster::ScriptReloader::ParseMetadataHeader(
 
 void UserScriptMaster::ScriptReloader::StartLoad(
     const UserScriptList& user_scripts,
+    const std::set<std::string>& extension_ids,
     const ExtensionsInfo& extensions_info) {
   // Add a reference to ourselves to keep ourselves alive while we're running.
   // Balanced by NotifyMaster().
@@ -160,17 +202,19 @@ void UserScriptMaster::ScriptReloader::StartLoad(
   this->extensions_info_ = extensions_info;
   BrowserThread::PostTask(
       BrowserThread::FILE, FROM_HERE,
-      base::Bind(
-          &UserScriptMaster::ScriptReloader::RunLoad, this, user_scripts));
+      base::Bind(&UserScriptMaster::ScriptReloader::RunLoad,
+                 this,
+                 user_scripts,
+                 extension_ids));
 }
 
 UserScriptMaster::ScriptReloader::~ScriptReloader() {}
 
 void UserScriptMaster::ScriptReloader::NotifyMaster(
-    scoped_ptr<base::SharedMemory> memory) {
+    const BundleMap& bundles) {
   // The master could go away
   if (master_)
-    master_->NewScriptsAvailable(memory.Pass());
+    master_->NewScriptsAvailable(bundles);
 
   // Drop our self-reference.
   // Balances StartLoad().
@@ -282,8 +326,16 @@ SubstitutionMap* UserScriptMaster::ScriptReloader::GetLocalizationMessages(
       extensions_info_[extension_id].second);
 }
 
-// Pickle user scripts and return pointer to the shared memory.
-static scoped_ptr<base::SharedMemory> Serialize(const UserScriptList& scripts) {
+// Pickle user scripts, or flatten them into a UserScriptBundle image if
+// renderers read those, and return the shared memory segment holding them.
+static scoped_refptr<UserScriptMaster::SharedBundle> Serialize(
+    const UserScriptList& scripts) {
+  if (UseScriptSegments()) {
+    std::string image;
+    UserScriptBundle::Build(scripts, &image);
+    return UserScriptMaster::SharedBundle::GetOrCreate(image);
+  }
+
   Pickle pickle;
   pickle.WriteUInt64(scripts.size());
   for (size_t i = 0; i < scripts.size(); i++) {
@@ -303,48 +355,141 @@ static scoped_ptr<base::SharedMemory> Serialize(const UserScriptList& scripts) {
       pickle.WriteData(contents.data(), contents.length());
     }
   }
+  return UserScriptMaster::SharedBundle::GetOrCreate(std::string(
+      static_cast<const char*>(pickle.data()), pickle.size()));
+}
+
+// This method will be called on the file thread.
+void UserScriptMaster::ScriptReloader::RunLoad(
+    const UserScriptList& user_scripts,
+    const std::set<std::string>& extension_ids) {
+  LoadUserScripts(const_cast<UserScriptList*>(&user_scripts));
+
+  // Scripts now contains list of up-to-date scripts. Load the content of each
+  // extension in its own shared memory and let the master know it's ready.
+  // An extension whose segment cannot be created is left out, so that its
+  // renderers keep its previous scripts.
+  BundleMap bundles;
+  if (!UseScriptSegments()) {
+    // |user_scripts| holds the scripts of every extension, which all go in
+    // one segment.
+    scoped_refptr<SharedBundle> bundle = Serialize(user_scripts);
+    if (bundle.get())
+      bundles[std::string()] = bundle;
+  } else {
+    std::map<std::string, UserScriptList> scripts_by_extension;
+    for (UserScriptList::const_iterator it = user_scripts.begin();
+         it != user_scripts.end(); ++it) {
+      scripts_by_extension[it->extension_id()].push_back(*it);
+    }
+    for (std::set<std::string>::const_iterator it = extension_ids.begin();
+         it != extension_ids.end(); ++it) {
+      std::map<std::string, UserScriptList>::const_iterator scripts =
+          scripts_by_extension.find(*it);
+      if (scripts == scripts_by_extension.end()) {
+        bundles[*it] = NULL;
+        continue;
+      }
+      scoped_refptr<SharedBundle> bundle = Serialize(scripts->second);
+      if (bundle.get())
+        bundles[*it] = bundle;
+    }
+  }
+
+  // We need to post the task back even if no scripts ware found to balance
+  // the AddRef/Release calls.
+  BrowserThread::PostTask(master_thread_id_,
+                          FROM_HERE,
+                          base::Bind(&ScriptReloader::NotifyMaster,
+                                     this,
+                                     bundles));
+}
+
+// static
+scoped_refptr<UserScriptMaster::SharedBundle>
+UserScriptMaster::SharedBundle::GetOrCreate(const std::string& image) {
+  const std::string digest = base::SHA1HashString(image);
+  SharedBundleRegistry& registry = g_shared_bundles.Get();
+  base::AutoLock lock(registry.lock);
+
+  // Drop the bundles only the registry still holds.  Nobody else can take a
+  // new reference to them, since that needs the lock.
+  std::map<std::string, scoped_refptr<SharedBundle> >::iterator it =
+      registry.bundles.begin();
+  while (it != registry.bundles.end()) {
+    if (it->second->HasOneRef())
+      registry.bundles.erase(it++);
+    else
+      ++it;
+  }
+
+  it = registry.bundles.find(digest);
+  UMA_HISTOGRAM_BOOLEAN("Extensions.UserScriptBundleShared",
+                        it != registry.bundles.end());
+  if (it != registry.bundles.end())
+    return it->second;
 
   // Create the shared memory object.
   base::SharedMemory shared_memory;
 
   base::SharedMemoryCreateOptions options;
-  options.size = pickle.size();
+  options.size = image.size();
   options.share_read_only = true;
   if (!shared_memory.Create(options))
-    return scoped_ptr<base::SharedMemory>();
+    return NULL;
 
-  if (!shared_memory.Map(pickle.size()))
-    return scoped_ptr<base::SharedMemory>();
+  if (!shared_memory.Map(image.size()))
+    return NULL;
 
-  // Copy the pickle to shared memory.
-  memcpy(shared_memory.memory(), pickle.data(), pickle.size());
+  // Copy the image to shared memory.
+  memcpy(shared_memory.memory(), image.data(), image.size());
 
   base::SharedMemoryHandle readonly_handle;
   if (!shared_memory.ShareReadOnlyToProcess(base::GetCurrentProcessHandle(),
                                             &readonly_handle))
-    return scoped_ptr<base::SharedMemory>();
+    return NULL;
 
-  return make_scoped_ptr(new base::SharedMemory(readonly_handle,
-                                                /*read_only=*/true));
+  UMA_HISTOGRAM_MEMORY_KB("Extensions.UserScriptBundleKB",
+                          image.size() / 1024);
+  scoped_refptr<SharedBundle> bundle(new SharedBundle(
+      make_scoped_ptr(
+          new base::SharedMemory(readonly_handle, /*read_only=*/true)),
+      image.size()));
+  registry.bundles[digest] = bundle;
+  return bundle;
 }
 
-// This method will be called on the file thread.
-void UserScriptMaster::ScriptReloader::RunLoad(
-    const UserScriptList& user_scripts) {
-  LoadUserScripts(const_cast<UserScriptList*>(&user_scripts));
+UserScriptMaster::SharedBundle::SharedBundle(
+    scoped_ptr<base::SharedMemory> shared_memory,
+    size_t size)
+    : shared_memory_(shared_memory.Pass()),
+      size_(size) {}
 
-  // Scripts now contains list of up-to-date scripts. Load the content in the
-  // shared memory and let the master know it's ready. We need to post the task
-  // back even if no scripts ware found to balance the AddRef/Release calls.
-  BrowserThread::PostTask(master_thread_id_,
-                          FROM_HERE,
-                          base::Bind(&ScriptReloader::NotifyMaster,
-                                     this,
-                                     base::Passed(Serialize(user_scripts))));
+UserScriptMaster::SharedBundle::~SharedBundle() {}
+
+UserScriptMaster::Segment::Segment() : version(0) {}
+
+UserScriptMaster::Segment::~Segment() {}
+
+// static
+void UserScriptMaster::GetSegmentsToSend(
+    const SegmentMap& segments,
+    uint32 version,
+    std::vector<std::string>* extension_ids) {
+  for (SegmentMap::const_iterator it = segments.begin();
+       it != segments.end(); ++it) {
+    if (it->second.version <= version)
+      continue;
+    if (version == 0 && !it->second.bundle.get())
+      continue;
+    extension_ids->push_back(it->first);
+  }
 }
 
 UserScriptMaster::UserScriptMaster(Profile* profile)
-    : extensions_service_ready_(false),
+    : version_(0),
+      scripts_ready_(false),
+      extensions_service_ready_(false),
       pending_load_(false),
       profile_(profile),
       extension_registry_observer_(this) {
@@ -353,6 +498,8 @@ UserScriptMaster::UserScriptMaster(Profile* profile)
                  content::Source<Profile>(profile_));
   registrar_.Add(this, content::NOTIFICATION_RENDERER_PROCESS_CREATED,
                  content::NotificationService::AllBrowserContextsAndSources());
+  registrar_.Add(this, content::NOTIFICATION_RENDERER_PROCESS_TERMINATED,
+                 content::NotificationService::AllBrowserContextsAndSources());
 }
 
 UserScriptMaster::~UserScriptMaster() {
@@ -360,8 +507,20 @@ UserScriptMaster::~UserScriptMaster() {
     script_reloader_->DisownMaster();
 }
 
-void UserScriptMaster::NewScriptsAvailable(
-    scoped_ptr<base::SharedMemory> handle) {
+void UserScriptMaster::NewScriptsAvailable(const BundleMap& bundles) {
+  // Stamp the reloaded segments with a new version, even if further changes
+  // came in while we were loading: those only cover the extensions which
+  // changed since, so these scripts are still current.
+  if (!bundles.empty()) {
+    ++version_;
+    for (BundleMap::const_iterator it = bundles.begin();
+         it != bundles.end(); ++it) {
+      Segment& segment = segments_[it->first];
+      segment.bundle = it->second;
+      segment.version = version_;
+    }
+  }
+
   if (pending_load_) {
     // While we were loading, there were further changes.  Don't bother
     // notifying about these scripts and instead just immediately reload.
@@ -371,31 +530,21 @@ void UserScriptMaster::NewScriptsAvailable(
     // We're no longer loading.
     script_reloader_ = NULL;
 
-    if (handle == NULL) {
-      // This can happen if we run out of file descriptors.  In that case, we
-      // have a choice between silently omitting all user scripts for new tabs,
-      // by nulling out shared_memory_, or only silently omitting new ones by
-      // leaving the existing object in place. The second seems less bad, even
-      // though it removes the possibility that freeing the shared memory block
-      // would open up enough FDs for long enough for a retry to succeed.
-
-      // Pretend the extension change didn't happen.
-      return;
-    }
-
-    // We've got scripts ready to go.
-    shared_memory_ = handle.Pass();
+    // We've got scripts ready to go.  Segments which could not be created,
+    // which can happen if we run out of file descriptors, were left out;
+    // renderers silently keep the previous scripts of those extensions.
+    scripts_ready_ = true;
 
     for (content::RenderProcessHost::iterator i(
             content::RenderProcessHost::AllHostsIterator());
          !i.IsAtEnd(); i.Advance()) {
-      SendUpdate(i.GetCurrentValue(), shared_memory_.get());
+      SendUpdate(i.GetCurrentValue());
     }
 
     content::NotificationService::current()->Notify(
         chrome::NOTIFICATION_USER_SCRIPTS_UPDATED,
         content::Source<Profile>(profile_),
-        content::Details<base::SharedMemory>(shared_memory_.get()));
+        content::NotificationService::NoDetails());
   }
 }
 
@@ -420,13 +569,8 @@ void UserScriptMaster::OnExtensionLoaded(
     user_scripts_.push_back(*iter);
     user_scripts_.back().set_incognito_enabled(incognito_enabled);
   }
-  if (extensions_service_ready_) {
-    if (script_reloader_.get()) {
-      pending_load_ = true;
-    } else {
-      StartLoad();
-    }
-  }
+  if (!scripts.empty())
+    ExtensionChanged(extension->id());
 }
 
 void UserScriptMaster::OnExtensionUnloaded(
@@ -442,7 +586,16 @@ void UserScriptMaster::OnExtensionUnloaded(
     if (iter->extension_id() != extension->id())
       new_user_scripts.push_back(*iter);
   }
+  if (new_user_scripts.size() == user_scripts_.size())
+    return;
   user_scripts_ = new_user_scripts;
+  ExtensionChanged(extension->id());
+}
+
+void UserScriptMaster::ExtensionChanged(const std::string& extension_id) {
+  changed_extensions_.insert(extension_id);
+  if (!extensions_service_ready_)
+    return;
   if (script_reloader_.get()) {
     pending_load_ = true;
   } else {
@@ -466,10 +619,18 @@ void UserScriptMaster::Observe(int type,
           process->GetBrowserContext());
       if (!profile_->IsSameProfile(profile))
         return;
+      // The process id may be reused by a new process, which has no scripts.
+      renderer_versions_.erase(process->GetID());
       if (ScriptsReady())
-        SendUpdate(process, GetSharedMemory());
+        SendUpdate(process);
       break;
     }
+    case content::NOTIFICATION_RENDERER_PROCESS_TERMINATED: {
+      content::RenderProcessHost* process =
+          content::Source<content::RenderProcessHost>(source).ptr();
+      renderer_versions_.erase(process->GetID());
+      return;
+    }
     default:
       DCHECK(false);
   }
@@ -487,11 +648,20 @@ void UserScriptMaster::StartLoad() {
   if (!script_reloader_.get())
     script_reloader_ = new ScriptReloader(this);
 
-  script_reloader_->StartLoad(user_scripts_, extensions_info_);
+  // Only the scripts of the extensions which changed are reloaded, unless
+  // all of the scripts share one segment.
+  UserScriptList changed_scripts;
+  for (UserScriptList::const_iterator it = user_scripts_.begin();
+       it != user_scripts_.end(); ++it) {
+    if (!UseScriptSegments() || changed_extensions_.count(it->extension_id()))
+      changed_scripts.push_back(*it);
+  }
+  script_reloader_->StartLoad(
+      changed_scripts, changed_extensions_, extensions_info_);
+  changed_extensions_.clear();
 }
 
-void UserScriptMaster::SendUpdate(content::RenderProcessHost* process,
-                                  base::SharedMemory* shared_memory) {
+void UserScriptMaster::SendUpdate(content::RenderProcessHost* process) {
   // Don't allow injection of content scripts into <webview>.
   if (process->IsGuest())
     return;
@@ -507,12 +677,68 @@ void UserScriptMaster::SendUpdate(content::RenderProcessHost* process,
   if (!handle)
     return;
 
-  base::SharedMemoryHandle handle_for_process;
-  if (!shared_memory->ShareToProcess(handle, &handle_for_process))
-    return;  // This can legitimately fail if the renderer asserts at startup.
+  uint32& renderer_version = renderer_versions_[process->GetID()];
+  std::vector<std::string> extension_ids;
+  GetSegmentsToSend(segments_, renderer_version, &extension_ids);
+  if (extension_ids.empty()) {
+    renderer_version = version_;
+    return;
+  }
 
-  if (base::SharedMemory::IsHandleValid(handle_for_process))
-    process->Send(new ExtensionMsg_UpdateUserScripts(handle_for_process));
+  if (!UseScriptSegments()) {
+    // All of the scripts are in the one segment of the empty extension id.
+    DCHECK_EQ(1u, extension_ids.size());
+    const Segment& segment = segments_[extension_ids[0]];
+    DCHECK(segment.bundle.get());
+    base::SharedMemoryHandle handle_for_process;
+    if (!segment.bundle->shared_memory()->ShareToProcess(handle,
+                                                         &handle_for_process))
+      return;  // This can legitimately fail if the renderer asserts at startup.
+
+    if (base::SharedMemory::IsHandleValid(handle_for_process) &&
+        process->Send(new ExtensionMsg_UpdateUserScripts(handle_for_process))) {
+      renderer_version = version_;
+    }
+    return;
+  }
+
+  // A segment without a bundle is sent with an invalid handle, which tells
+  // the renderer to drop the scripts of that extension.
+  std::vector<ChromeExtensionMsg_UserScriptSegment> update;
+  size_t update_size = 0;
+  bool complete = true;
+  for (size_t i = 0; i < extension_ids.size(); ++i) {
+    const Segment& segment = segments_[extension_ids[i]];
+    ChromeExtensionMsg_UserScriptSegment segment_params;
+    segment_params.extension_id = extension_ids[i];
+    segment_params.handle = base::SharedMemory::NULLHandle();
+    if (segment.bundle.get()) {
+      // This can legitimately fail if the renderer asserts at startup.
+      if (!segment.bundle->shared_memory()->ShareToProcess(
+              handle, &segment_params.handle) ||
+          !base::SharedMemory::IsHandleValid(segment_params.handle)) {
+        complete = false;
+        break;
+      }
+      update_size += segment.bundle->size();
+    }
+    update.push_back(segment_params);
+  }
+
+  // The handles which were shared are sent even if a later one failed, since
+  // the message is what hands them over to the renderer; without it they
+  // would leak.  The renderer then stays at its version, so that the whole
+  // update is sent again next time.
+  if (update.empty())
+    return;
+  UMA_HISTOGRAM_COUNTS_100("Extensions.UserScriptUpdateSegments",
+                           update.size());
+  UMA_HISTOGRAM_MEMORY_KB("Extensions.UserScriptUpdateKB", update_size / 1024);
+  if (process->Send(
+          new ChromeExtensionMsg_UpdateUserScriptSegments(version_, update)) &&
+      complete) {
+    renderer_version = version_;
+  }
 }
 
 }  // namespace extensions
@@ -6,7 +6,9 @@
 #define CHROME_BROWSER_EXTENSIONS_USER_SCRIPT_MASTER_H_
 
 #include <map>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "base/compiler_specific.h"
 #include "base/memory/scoped_ptr.h"
@@ -33,41 +35,99 @@ class ExtensionRegistry;
 typedef std::map<std::string, ExtensionSet::ExtensionPathAndDefaultLocale>
     ExtensionsInfo;
 
-// Manages a segment of shared memory that contains the user scripts the user
-// has installed.  Lives on the UI thread.
+// Manages the segments of shared memory that contain the user scripts the
+// user has installed.  All of the scripts are reloaded into one segment, which
+// is sent whole.  In tests there can instead be one segment per extension:
+// when an extension is loaded or unloaded, only its scripts are reloaded, and
+// renderers are only sent the segments which changed since their last update.
+// Lives on the UI thread.
 class UserScriptMaster : public base::RefCountedThreadSafe<UserScriptMaster>,
                          public content::NotificationObserver,
                          public ExtensionRegistryObserver {
  public:
+  class SharedBundle;
+
+  // The reloaded segments, by extension id.  The bundle of an extension which
+  // no longer has any scripts is NULL.
+  typedef std::map<std::string, scoped_refptr<SharedBundle> > BundleMap;
+
+  // The scripts of one extension, and the update version in which they last
+  // changed.  |bundle| is NULL once the extension has no scripts left, so
+  // that renderers which still hold its old scripts are told to drop them.
+  struct Segment {
+    Segment();
+    ~Segment();
+
+    scoped_refptr<SharedBundle> bundle;
+    uint32 version;
+  };
+  typedef std::map<std::string, Segment> SegmentMap;
+
   explicit UserScriptMaster(Profile* profile);
 
-  // Kicks off a process on the file thread to reload scripts from disk
-  // into a new chunk of shared memory and notify renderers.
+  // Kicks off a process on the file thread to reload the scripts of the
+  // extensions which changed since the last load from disk into new chunks
+  // of shared memory and notify renderers.
   virtual void StartLoad();
 
-  // Gets the segment of shared memory for the scripts.
-  base::SharedMemory* GetSharedMemory() const {
-    return shared_memory_.get();
-  }
-
   // Called by the script reloader when new scripts have been loaded.
-  void NewScriptsAvailable(scoped_ptr<base::SharedMemory> handle);
+  void NewScriptsAvailable(const BundleMap& bundles);
 
   // Return true if we have any scripts ready.
-  bool ScriptsReady() const { return shared_memory_.get() != NULL; }
+  bool ScriptsReady() const { return scripts_ready_; }
+
+  // Appends the ids of the extensions in |segments| which changed after
+  // |version| to |extension_ids|.  A renderer at version 0 has no scripts
+  // yet, so it is not sent the segments of extensions without scripts.
+  static void GetSegmentsToSend(const SegmentMap& segments,
+                                uint32 version,
+                                std::vector<std::string>* extension_ids);
 
   // Returns the content verifier for our browser context.
   ContentVerifier* content_verifier();
 
+  // Makes masters keep one UserScriptBundle segment per extension, and send
+  // renderers ChromeExtensionMsg_UpdateUserScriptSegments.  Renderers cannot
+  // read those yet, so this is only for tests.
+  static void SetUseScriptSegmentsForTesting(bool use_segments);
+
  protected:
   friend class base::RefCountedThreadSafe<UserScriptMaster>;
 
   virtual ~UserScriptMaster();
 
  public:
+  // A segment of read-only shared memory holding the serialized scripts of a
+  // master: a pickled UserScriptList, or a UserScriptBundle image per
+  // extension in tests.  Masters whose scripts serialize to the
+  // same image, such as the principal profiles of a user with the same
+  // extensions, share one segment.
+  class SharedBundle : public base::RefCountedThreadSafe<SharedBundle> {
+   public:
+    // Returns the segment holding |image|, creating it if no master holds
+    // one yet.  Returns NULL if the shared memory cannot be created.  May be
+    // called on any thread.
+    static scoped_refptr<SharedBundle> GetOrCreate(const std::string& image);
+
+    base::SharedMemory* shared_memory() const { return shared_memory_.get(); }
+    size_t size() const { return size_; }
+
+   private:
+    friend class base::RefCountedThreadSafe<SharedBundle>;
+
+    SharedBundle(scoped_ptr<base::SharedMemory> shared_memory, size_t size);
+    ~SharedBundle();
+
+    scoped_ptr<base::SharedMemory> shared_memory_;
+    size_t size_;
+
+    DISALLOW_COPY_AND_ASSIGN(SharedBundle);
+  };
+
   // We reload user scripts on the file thread to prevent blocking the UI.
   // ScriptReloader lives on the file thread and does the reload
-  // work, and then sends a message back to its master with a new SharedMemory*.
+  // work, and then sends a message back to its master with a SharedBundle for
+  // every extension whose scripts were reloaded.
   // ScriptReloader is the worker that manages running the script load
   // on the file thread. It must be created on, and its public API must only be
   // called from, the master's thread.
@@ -80,9 +140,11 @@ class UserScriptMaster : public base::RefCountedThreadSafe<UserScriptMaster>,
 
     explicit ScriptReloader(UserScriptMaster* master);
 
-    // Start loading of scripts.
+    // Start loading of the scripts of |extension_ids|, which are all of the
+    // scripts in |external_scripts|.
     // Will always send a message to the master upon completion.
     void StartLoad(const UserScriptList& external_scripts,
+                   const std::set<std::string>& extension_ids,
                    const ExtensionsInfo& extensions_info);
 
     // The master is going away; don't call it back.
@@ -105,13 +167,14 @@ class UserScriptMaster : public base::RefCountedThreadSafe<UserScriptMaster>,
 
     // Runs on the master thread.
     // Notify the master that new scripts are available.
-    void NotifyMaster(scoped_ptr<base::SharedMemory> memory);
+    void NotifyMaster(const BundleMap& bundles);
 
     // Runs on the File thread.
-    // Load the specified user scripts, calling NotifyMaster when done.
-    // |user_scripts| is intentionally passed by value so its lifetime isn't
-    // tied to the caller.
-    void RunLoad(const UserScriptList& user_scripts);
+    // Load the specified user scripts, calling NotifyMaster with a bundle for
+    // each of |extension_ids| when done.  Both arguments are intentionally
+    // passed by value so their lifetime isn't tied to the caller.
+    void RunLoad(const UserScriptList& user_scripts,
+                 const std::set<std::string>& extension_ids);
 
     void LoadUserScripts(UserScriptList* user_scripts);
 
@@ -149,9 +212,13 @@ class UserScriptMaster : public base::RefCountedThreadSafe<UserScriptMaster>,
       const Extension* extension,
       UnloadedExtensionInfo::Reason reason) OVERRIDE;
 
-  // Sends the renderer process a new set of user scripts.
-  void SendUpdate(content::RenderProcessHost* process,
-                  base::SharedMemory* shared_memory);
+  // Marks the scripts of |extension_id| as changed, and reloads them unless
+  // the initial set of extensions is still loading.
+  void ExtensionChanged(const std::string& extension_id);
+
+  // Sends the renderer process the segments which changed since its last
+  // update.
+  void SendUpdate(content::RenderProcessHost* process);
 
   // Manages our notification registrations.
   content::NotificationRegistrar registrar_;
@@ -159,8 +226,22 @@ class UserScriptMaster : public base::RefCountedThreadSafe<UserScriptMaster>,
   // We hang on to our pointer to know if we've already got one running.
   scoped_refptr<ScriptReloader> script_reloader_;
 
-  // Contains the scripts that were found the last time scripts were updated.
-  scoped_ptr<base::SharedMemory> shared_memory_;
+  // The scripts of every extension which has had scripts since we started,
+  // as of the last update.
+  SegmentMap segments_;
+
+  // The version of the last update.  Every update gets a new version, and
+  // its segments are stamped with it.
+  uint32 version_;
+
+  // The version each renderer process was last brought up to, by process id.
+  std::map<int, uint32> renderer_versions_;
+
+  // The extensions whose scripts changed since the last load started.
+  std::set<std::string> changed_extensions_;
+
+  // If the first load has finished.
+  bool scripts_ready_;
 
   // List of scripts from currently-installed extensions we should load.
   UserScriptList user_scripts_;
@@ -0,0 +1,112 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/extensions/user_script_master.h"
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+#include "chrome/common/extensions/user_script_bundle.h"
+#include "extensions/common/url_pattern.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "url/gurl.h"
+
+namespace extensions {
+
+namespace {
+
+const int kExtensionCount = 40;
+const int kRendererCount = 100;
+
+// A content script of about the size extensions commonly inject.
+const size_t kScriptSize = 16 * 1024;
+
+UserScript MakeScript(const std::string& extension_id, char fill) {
+  UserScript script;
+  script.set_extension_id(extension_id);
+  script.add_url_pattern(URLPattern(URLPattern::SCHEME_ALL, "<all_urls>"));
+  UserScript::File file(
+      base::FilePath(), base::FilePath(),
+      GURL("chrome-extension://" + extension_id + "/content.js"));
+  file.set_content(std::string(kScriptSize, fill));
+  script.js_scripts().push_back(file);
+  return script;
+}
+
+}  // namespace
+
+// Updates 100 renderers after one of 40 extensions changes, and reports the
+// segments and bytes they are sent with one segment per extension, against a
+// full reload which sends every renderer all of the scripts.
+TEST(UserScriptMasterPerfTest, DeltaUpdateSendsChangedSegments) {
+  UserScriptMaster::SegmentMap segments;
+  UserScriptList all_scripts;
+  std::vector<std::string> extension_ids;
+  for (int i = 0; i < kExtensionCount; ++i) {
+    const std::string extension_id = "extension" + base::IntToString(i);
+    const UserScript script =
+        MakeScript(extension_id, static_cast<char>('a' + i % 26));
+    UserScriptList user_scripts(1, script);
+    std::string image;
+    UserScriptBundle::Build(user_scripts, &image);
+
+    UserScriptMaster::Segment& segment = segments[extension_id];
+    segment.bundle = UserScriptMaster::SharedBundle::GetOrCreate(image);
+    ASSERT_TRUE(segment.bundle.get());
+    segment.version = 1;
+    extension_ids.push_back(extension_id);
+    all_scripts.push_back(script);
+  }
+
+  // One extension is updated.
+  const std::string& changed_id = extension_ids[7];
+  UserScriptList changed_scripts(1, MakeScript(changed_id, 'z'));
+  std::string changed_image;
+  UserScriptBundle::Build(changed_scripts, &changed_image);
+  segments[changed_id].bundle =
+      UserScriptMaster::SharedBundle::GetOrCreate(changed_image);
+  ASSERT_TRUE(segments[changed_id].bundle.get());
+  segments[changed_id].version = 2;
+  all_scripts[7] = changed_scripts[0];
+
+  size_t delta_segments = 0;
+  size_t delta_bytes = 0;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kRendererCount; ++i) {
+    std::vector<std::string> to_send;
+    UserScriptMaster::GetSegmentsToSend(segments, 1, &to_send);
+    for (size_t j = 0; j < to_send.size(); ++j)
+      delta_bytes += segments[to_send[j]].bundle->size();
+    delta_segments += to_send.size();
+  }
+  const base::TimeDelta delta_time = base::TimeTicks::Now() - start;
+  EXPECT_EQ(static_cast<size_t>(kRendererCount), delta_segments);
+
+  std::string full_image;
+  UserScriptBundle::Build(all_scripts, &full_image);
+  const size_t full_segments = kRendererCount;
+  const size_t full_bytes = kRendererCount * full_image.size();
+  EXPECT_LT(delta_bytes, full_bytes);
+
+  const std::string trace = base::IntToString(kExtensionCount) +
+      "_extensions_" + base::IntToString(kRendererCount) + "_renderers";
+  perf_test::PrintResult("user_script_update_segments", "", "delta_" + trace,
+                         delta_segments, "segments", false);
+  perf_test::PrintResult("user_script_update_segments", "", "full_" + trace,
+                         full_segments, "segments", false);
+  perf_test::PrintResult("user_script_update_bytes", "", "delta_" + trace,
+                         delta_bytes, "bytes", true);
+  perf_test::PrintResult("user_script_update_bytes", "", "full_" + trace,
+                         full_bytes, "bytes", true);
+  perf_test::PrintResult("user_script_update_time", "", "delta_" + trace,
+                         delta_time.InMicroseconds() /
+                             static_cast<double>(kRendererCount),
+                         "us/renderer", false);
+}
+
+}  // namespace extensions
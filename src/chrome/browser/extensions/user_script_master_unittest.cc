@@ -11,8 +11,10 @@
 #include "base/files/scoped_temp_dir.h"
 #include "base/message_loop/message_loop.h"
 #include "base/path_service.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
 #include "chrome/browser/chrome_notification_types.h"
+#include "chrome/common/extensions/user_script_bundle.h"
 #include "chrome/test/base/testing_profile.h"
 #include "content/public/browser/notification_registrar.h"
 #include "content/public/browser/notification_service.h"
@@ -39,7 +41,7 @@ namespace extensions {
 class UserScriptMasterTest : public testing::Test,
                              public content::NotificationObserver {
  public:
-  UserScriptMasterTest() : shared_memory_(NULL) {
+  UserScriptMasterTest() : scripts_updated_(false) {
   }
 
   virtual void SetUp() {
@@ -67,7 +69,7 @@ class UserScriptMasterTest : public testing::Test,
                        const content::NotificationDetails& details) OVERRIDE {
     DCHECK(type == chrome::NOTIFICATION_USER_SCRIPTS_UPDATED);
 
-    shared_memory_ = content::Details<base::SharedMemory>(details).ptr();
+    scripts_updated_ = true;
     if (base::MessageLoop::current() == &message_loop_)
       base::MessageLoop::current()->Quit();
   }
@@ -83,8 +85,8 @@ class UserScriptMasterTest : public testing::Test,
   scoped_ptr<content::TestBrowserThread> file_thread_;
   scoped_ptr<content::TestBrowserThread> ui_thread_;
 
-  // Updated to the script shared memory when we get notified.
-  base::SharedMemory* shared_memory_;
+  // Set when we get notified that the scripts were updated.
+  bool scripts_updated_;
 };
 
 // Test that we get notified even when there are no scripts.
@@ -95,7 +97,8 @@ TEST_F(UserScriptMasterTest, NoScripts) {
   message_loop_.PostTask(FROM_HERE, base::MessageLoop::QuitClosure());
   message_loop_.Run();
 
-  ASSERT_TRUE(shared_memory_ != NULL);
+  ASSERT_TRUE(scripts_updated_);
+  EXPECT_TRUE(master->ScriptsReady());
 }
 
 TEST_F(UserScriptMasterTest, Parse1) {
@@ -274,4 +277,182 @@ TEST_F(UserScriptMasterTest, LeaveBOMNotAtTheBeginning) {
   EXPECT_EQ(content, user_scripts[0].js_scripts()[0].GetContent().as_string());
 }
 
+TEST_F(UserScriptMasterTest, BundleMatchesLikeUserScripts) {
+  UserScriptList user_scripts;
+
+  UserScript all_urls;
+  all_urls.set_extension_id("all");
+  all_urls.add_url_pattern(URLPattern(URLPattern::SCHEME_ALL, "<all_urls>"));
+  all_urls.add_exclude_url_pattern(
+      URLPattern(URLPattern::SCHEME_ALL, "*://*.example.com/private/*"));
+  user_scripts.push_back(all_urls);
+
+  UserScript subdomains;
+  subdomains.set_extension_id("subdomains");
+  subdomains.set_run_location(UserScript::DOCUMENT_START);
+  subdomains.set_match_all_frames(true);
+  subdomains.add_url_pattern(
+      URLPattern(URLPattern::SCHEME_ALL, "https://*.google.com/mail/*"));
+  UserScript::File file(base::FilePath(), base::FilePath(),
+                        GURL("chrome-extension://subdomains/inject.js"));
+  file.set_content("alert('hi');");
+  subdomains.js_scripts().push_back(file);
+  user_scripts.push_back(subdomains);
+
+  UserScript exact_host;
+  exact_host.set_extension_id("exact");
+  exact_host.add_url_pattern(
+      URLPattern(URLPattern::SCHEME_ALL, "http://example.com:8080/a?b*"));
+  exact_host.add_exclude_glob("*nope*");
+  user_scripts.push_back(exact_host);
+
+  UserScript globs_only;
+  globs_only.set_extension_id("globs");
+  globs_only.add_glob("*mail.yahoo.com*");
+  user_scripts.push_back(globs_only);
+
+  std::string image;
+  UserScriptBundle::Build(user_scripts, &image);
+  scoped_ptr<UserScriptBundle> bundle(
+      UserScriptBundle::Create(image.data(), image.size()));
+  ASSERT_TRUE(bundle.get());
+  ASSERT_EQ(user_scripts.size(), bundle->script_count());
+
+  EXPECT_EQ("subdomains", bundle->extension_id(1));
+  EXPECT_EQ(UserScript::DOCUMENT_START, bundle->run_location(1));
+  EXPECT_TRUE(bundle->match_all_frames(1));
+  ASSERT_EQ(1U, bundle->js_file_count(1));
+  EXPECT_EQ("chrome-extension://subdomains/inject.js",
+            bundle->js_file_url(1, 0));
+  EXPECT_EQ("alert('hi');", bundle->js_file_content(1, 0));
+  EXPECT_EQ(0U, bundle->css_file_count(1));
+
+  const char* kUrls[] = {
+    "http://example.com/",
+    "http://www.example.com/private/x",
+    "https://google.com/mail/inbox",
+    "https://mail.google.com/mail/inbox",
+    "https://mail.google.com/calendar",
+    "http://mail.google.com/mail/inbox",
+    "https://notgoogle.com/mail/inbox",
+    "http://example.com:8080/a?bc",
+    "http://example.com:8080/a?nope",
+    "http://example.com/a?bc",
+    "http://www.example.com:8080/a?bc",
+    "http://mail.yahoo.com/",
+    "file:///home/user/mail.yahoo.com",
+    "chrome://settings/",
+    "filesystem:https://mail.google.com/mail/temporary/x",
+    "filesystem:https://mail.google.com/temporary/x",
+    "filesystem:http://www.example.com/private/x",
+    "filesystem:http://example.com:8080/a?bc",
+    "filesystem:chrome://settings/temporary/x",
+  };
+  for (size_t i = 0; i < arraysize(kUrls); ++i) {
+    const GURL url(kUrls[i]);
+    std::vector<size_t> expected;
+    for (size_t j = 0; j < user_scripts.size(); ++j) {
+      if (user_scripts[j].MatchesURL(url))
+        expected.push_back(j);
+    }
+    std::vector<size_t> scripts;
+    bundle->GetScriptsForURL(url, &scripts);
+    EXPECT_EQ(expected, scripts) << url.spec();
+  }
+}
+
+TEST_F(UserScriptMasterTest, BundleRejectsInvalidImages) {
+  UserScriptList user_scripts;
+  UserScript script;
+  script.add_url_pattern(URLPattern(URLPattern::SCHEME_ALL, "http://a.com/*"));
+  user_scripts.push_back(script);
+
+  std::string image;
+  UserScriptBundle::Build(user_scripts, &image);
+  EXPECT_TRUE(UserScriptBundle::Create(image.data(), image.size()).get());
+  EXPECT_FALSE(UserScriptBundle::Create(image.data(), image.size() - 4).get());
+
+  // A string reference past the end of the image.
+  std::string corrupt = image;
+  std::fill(corrupt.begin() + 40, corrupt.begin() + 48, '\xFF');
+  EXPECT_FALSE(UserScriptBundle::Create(corrupt.data(), corrupt.size()).get());
+}
+
+TEST_F(UserScriptMasterTest, SharedBundleIsShared) {
+  UserScriptList user_scripts;
+  UserScript script;
+  script.add_url_pattern(URLPattern(URLPattern::SCHEME_ALL, "http://a.com/*"));
+  user_scripts.push_back(script);
+
+  std::string image;
+  UserScriptBundle::Build(user_scripts, &image);
+  scoped_refptr<UserScriptMaster::SharedBundle> bundle =
+      UserScriptMaster::SharedBundle::GetOrCreate(image);
+  ASSERT_TRUE(bundle.get());
+  EXPECT_EQ(bundle.get(),
+            UserScriptMaster::SharedBundle::GetOrCreate(image).get());
+
+  user_scripts.push_back(script);
+  std::string other_image;
+  UserScriptBundle::Build(user_scripts, &other_image);
+  EXPECT_NE(bundle.get(),
+            UserScriptMaster::SharedBundle::GetOrCreate(other_image).get());
+}
+
+// Checks which segments renderers at different versions are sent after
+// extensions change.
+TEST_F(UserScriptMasterTest, DeltaUpdateSendsChangedSegments) {
+  const int kExtensionCount = 40;
+
+  UserScriptMaster::SegmentMap segments;
+  std::vector<std::string> extension_ids;
+  for (int i = 0; i < kExtensionCount; ++i) {
+    UserScriptList user_scripts;
+    UserScript script;
+    script.set_extension_id("extension" + base::IntToString(i));
+    script.add_url_pattern(
+        URLPattern(URLPattern::SCHEME_ALL, "http://a.com/*"));
+    user_scripts.push_back(script);
+    std::string image;
+    UserScriptBundle::Build(user_scripts, &image);
+
+    UserScriptMaster::Segment& segment = segments[script.extension_id()];
+    segment.bundle = UserScriptMaster::SharedBundle::GetOrCreate(image);
+    ASSERT_TRUE(segment.bundle.get());
+    segment.version = 1;
+    extension_ids.push_back(script.extension_id());
+  }
+
+  // Bringing up a new renderer sends every segment.
+  std::vector<std::string> to_send;
+  UserScriptMaster::GetSegmentsToSend(segments, 0, &to_send);
+  EXPECT_EQ(extension_ids, to_send);
+
+  // Renderers which are up to date get nothing.
+  to_send.clear();
+  UserScriptMaster::GetSegmentsToSend(segments, 1, &to_send);
+  EXPECT_TRUE(to_send.empty());
+
+  // One extension is updated: renderers get its segment only.
+  segments[extension_ids[7]].bundle =
+      UserScriptMaster::SharedBundle::GetOrCreate("updated");
+  segments[extension_ids[7]].version = 2;
+  to_send.clear();
+  UserScriptMaster::GetSegmentsToSend(segments, 1, &to_send);
+  ASSERT_EQ(1u, to_send.size());
+  EXPECT_EQ(extension_ids[7], to_send[0]);
+
+  // Another extension is unloaded: renderers which held its scripts are told
+  // to drop them, but new renderers are not sent it at all.
+  segments[extension_ids[3]].bundle = NULL;
+  segments[extension_ids[3]].version = 3;
+  to_send.clear();
+  UserScriptMaster::GetSegmentsToSend(segments, 2, &to_send);
+  ASSERT_EQ(1u, to_send.size());
+  EXPECT_EQ(extension_ids[3], to_send[0]);
+  to_send.clear();
+  UserScriptMaster::GetSegmentsToSend(segments, 0, &to_send);
+  EXPECT_EQ(static_cast<size_t>(kExtensionCount - 1), to_send.size());
+}
+
 }  // namespace extensions
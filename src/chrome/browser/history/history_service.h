@@ -597,6 +597,7 @@ class HistoryService : public CancelableRequestProvider,
   friend class history::HistoryBackend;
   friend class history::HistoryQueryTest;
   friend class HistoryOperation;
+  friend class HistoryQuickProviderPerfTest;
   friend class HistoryQuickProviderTest;
   friend class HistoryURLProvider;
   friend class HistoryURLProviderTest;
@@ -20,6 +20,8 @@ InMemoryDatabase::~InMemoryDatabase() {
 }
 
 bool InMemoryDatabase::InitDB() {
+  prefix_index_.Clear();
+
   // Set the database page size to 4K for better performance.
   db_.set_page_size(4096);
 
@@ -141,9 +143,31 @@ bool InMemoryDatabase::InitFromDisk(const base::FilePath& history_name) {
   CreateMainURLIndex();
   CreateKeywordSearchTermsIndices();
 
+  begin_load = base::TimeTicks::Now();
+  URLRows rows;
+  URLEnumerator enumerator;
+  if (InitURLEnumeratorForEverything(&enumerator)) {
+    URLRow row;
+    while (enumerator.GetNextURL(&row))
+      rows.push_back(row);
+  }
+  prefix_index_.Reset(rows);
+  UMA_HISTOGRAM_TIMES("History.InMemoryDBPrefixIndexBuild",
+                      base::TimeTicks::Now() - begin_load);
+
   return true;
 }
 
+void InMemoryDatabase::AutocompleteForPrefixes(
+    const std::vector<std::string>& prefixes,
+    const std::string& text,
+    size_t max_results,
+    bool typed_only,
+    std::vector<URLRows>* results) {
+  prefix_index_.AutocompleteForPrefixes(prefixes, text, max_results,
+                                        typed_only, results);
+}
+
 sql::Connection& InMemoryDatabase::GetDB() {
   return db_;
 }
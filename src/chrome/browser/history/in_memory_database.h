@@ -7,6 +7,7 @@
 
 #include "base/basictypes.h"
 #include "chrome/browser/history/url_database.h"
+#include "chrome/browser/history/url_prefix_index.h"
 #include "sql/connection.h"
 
 namespace base {
@@ -32,6 +33,17 @@ class InMemoryDatabase : public URLDatabase {
   // much slower.
   bool InitFromDisk(const base::FilePath& history_name);
 
+  // The index of the URL table used for autocompletion.  Whoever modifies the
+  // URL table must update it to match; see InMemoryHistoryBackend.
+  URLPrefixIndex* prefix_index() { return &prefix_index_; }
+
+  // URLDatabase:
+  virtual void AutocompleteForPrefixes(const std::vector<std::string>& prefixes,
+                                       const std::string& text,
+                                       size_t max_results,
+                                       bool typed_only,
+                                       std::vector<URLRows>* results) OVERRIDE;
+
  protected:
   // Implemented for URLDatabase.
   virtual sql::Connection& GetDB() OVERRIDE;
@@ -43,6 +55,8 @@ class InMemoryDatabase : public URLDatabase {
 
   sql::Connection db_;
 
+  URLPrefixIndex prefix_index_;
+
   DISALLOW_COPY_AND_ASSIGN(InMemoryDatabase);
 };
 
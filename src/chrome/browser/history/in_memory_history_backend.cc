@@ -105,10 +105,14 @@ void InMemoryHistoryBackend::Observe(
 void InMemoryHistoryBackend::OnURLVisitedOrModified(const URLRow& url_row) {
   DCHECK(db_);
   DCHECK(url_row.id());
-  if (url_row.typed_count() || db_->GetKeywordSearchTermRow(url_row.id(), NULL))
+  if (url_row.typed_count() ||
+      db_->GetKeywordSearchTermRow(url_row.id(), NULL)) {
     db_->InsertOrUpdateURLRowByID(url_row);
-  else
+    db_->prefix_index()->AddOrUpdate(url_row);
+  } else {
     db_->DeleteURLRow(url_row.id());
+    db_->prefix_index()->Delete(url_row.id());
+  }
 }
 
 void InMemoryHistoryBackend::OnURLsDeleted(const URLsDeletedDetails& details) {
@@ -129,6 +133,7 @@ void InMemoryHistoryBackend::OnURLsDeleted(const URLsDeletedDetails& details) {
     // This will also delete the corresponding keyword search term.
     // Ignore errors, as we typically only cache a subset of URLRows.
     db_->DeleteURLRow(row->id());
+    db_->prefix_index()->Delete(row->id());
   }
 }
 
@@ -136,6 +141,7 @@ void InMemoryHistoryBackend::OnKeywordSearchTermUpdated(
     const KeywordSearchUpdatedDetails& details) {
   DCHECK(details.url_row.id());
   db_->InsertOrUpdateURLRowByID(details.url_row);
+  db_->prefix_index()->AddOrUpdate(details.url_row);
   db_->SetKeywordSearchTermsForURL(
       details.url_row.id(), details.keyword_id, details.term);
 }
@@ -4,6 +4,10 @@
 
 #include "chrome/browser/history/in_memory_url_index.h"
 
+#include <set>
+#include <vector>
+
+#include "base/bind.h"
 #include "base/debug/trace_event.h"
 #include "base/file_util.h"
 #include "base/strings/utf_string_conversions.h"
@@ -17,15 +21,74 @@
 #include "chrome/browser/profiles/profile.h"
 #include "chrome/common/url_constants.h"
 #include "components/bookmarks/browser/bookmark_model.h"
+#include "components/bookmarks/browser/bookmark_service.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/notification_details.h"
 #include "content/public/browser/notification_service.h"
 #include "content/public/browser/notification_source.h"
+#include "url/gurl.h"
 
 using in_memory_url_index::InMemoryURLIndexCacheItem;
 
 namespace history {
 
+namespace {
+
+// The URLs bookmarked when a query was started, for scoring it on a worker
+// thread, where the profile's BookmarkModel may already have been destroyed.
+class BookmarkSnapshot : public BookmarkService {
+ public:
+  // Copies the bookmarked URLs of |bookmark_service|, which may be NULL.
+  explicit BookmarkSnapshot(BookmarkService* bookmark_service);
+  virtual ~BookmarkSnapshot() {}
+
+  // BookmarkService:
+  virtual bool IsBookmarked(const GURL& url) OVERRIDE;
+  virtual void GetBookmarks(std::vector<URLAndTitle>* bookmarks) OVERRIDE;
+  virtual void BlockTillLoaded() OVERRIDE {}
+
+ private:
+  std::set<GURL> urls_;
+
+  DISALLOW_COPY_AND_ASSIGN(BookmarkSnapshot);
+};
+
+BookmarkSnapshot::BookmarkSnapshot(BookmarkService* bookmark_service) {
+  if (!bookmark_service)
+    return;
+  std::vector<URLAndTitle> bookmarks;
+  bookmark_service->GetBookmarks(&bookmarks);
+  for (size_t i = 0; i < bookmarks.size(); ++i)
+    urls_.insert(bookmarks[i].url);
+}
+
+bool BookmarkSnapshot::IsBookmarked(const GURL& url) {
+  return urls_.count(url) != 0;
+}
+
+void BookmarkSnapshot::GetBookmarks(std::vector<URLAndTitle>* bookmarks) {
+  for (std::set<GURL>::const_iterator i = urls_.begin(); i != urls_.end();
+       ++i) {
+    URLAndTitle bookmark;
+    bookmark.url = *i;
+    bookmarks->push_back(bookmark);
+  }
+}
+
+// Scores the query on a worker thread against |bookmarks|, which the callback
+// owns.
+ScoredHistoryMatches HistoryItemsForTermsWithSnapshot(
+    scoped_refptr<URLIndexPrivateData> private_data,
+    const base::string16& term_string,
+    size_t cursor_position,
+    const std::string& languages,
+    BookmarkSnapshot* bookmarks) {
+  return private_data->HistoryItemsForTerms(term_string, cursor_position,
+                                            languages, bookmarks);
+}
+
+}  // namespace
+
 // Called by DoSaveToCacheFile to delete any old cache file at |path| when
 // there is no private data to save. Runs on the FILE thread.
 void DeleteCacheFile(const base::FilePath& path) {
@@ -168,6 +231,20 @@ ScoredHistoryMatches InMemoryURLIndex::HistoryItemsForTerms(
       BookmarkModelFactory::GetForProfile(profile_));
 }
 
+base::Callback<ScoredHistoryMatches(void)>
+InMemoryURLIndex::GetHistoryItemsForTermsCallback(
+    const base::string16& term_string,
+    size_t cursor_position) {
+  // The profile, and with it the BookmarkModel, may be destroyed while the
+  // query runs on a worker thread, so the query gets its own copy of the
+  // bookmarked URLs, taken here on the main thread.
+  BookmarkSnapshot* bookmarks =
+      new BookmarkSnapshot(BookmarkModelFactory::GetForProfile(profile_));
+  return base::Bind(&HistoryItemsForTermsWithSnapshot, private_data_,
+                    term_string, cursor_position, languages_,
+                    base::Owned(bookmarks));
+}
+
 // Updating --------------------------------------------------------------------
 
 void InMemoryURLIndex::DeleteURL(const GURL& url) {
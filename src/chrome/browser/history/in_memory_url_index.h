@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "base/basictypes.h"
+#include "base/callback_forward.h"
 #include "base/files/file_path.h"
 #include "base/gtest_prod_util.h"
 #include "base/memory/ref_counted.h"
@@ -26,6 +27,7 @@
 #include "content/public/browser/notification_registrar.h"
 #include "sql/connection.h"
 
+class HistoryQuickProviderPerfTest;
 class HistoryQuickProviderTest;
 class Profile;
 
@@ -121,6 +123,14 @@ class InMemoryURLIndex : public content::NotificationObserver,
   ScoredHistoryMatches HistoryItemsForTerms(const base::string16& term_string,
                                             size_t cursor_position);
 
+  // Returns a callback which runs HistoryItemsForTerms() for |term_string|
+  // against the index data as it stands now.  The callback may be run on any
+  // thread; it keeps the data alive, and updates to the index wait while it
+  // runs.
+  base::Callback<ScoredHistoryMatches(void)> GetHistoryItemsForTermsCallback(
+      const base::string16& term_string,
+      size_t cursor_position);
+
   // Deletes the index entry, if any, for the given |url|.
   void DeleteURL(const GURL& url);
 
@@ -140,6 +150,7 @@ class InMemoryURLIndex : public content::NotificationObserver,
   }
 
  private:
+  friend class ::HistoryQuickProviderPerfTest;
   friend class ::HistoryQuickProviderTest;
   friend class InMemoryURLIndexTest;
   friend class InMemoryURLIndexCacheTest;
@@ -311,6 +311,19 @@ bool URLDatabase::AutocompleteForPrefix(const std::string& prefix,
   return !results->empty();
 }
 
+void URLDatabase::AutocompleteForPrefixes(
+    const std::vector<std::string>& prefixes,
+    const std::string& text,
+    size_t max_results,
+    bool typed_only,
+    std::vector<URLRows>* results) {
+  results->assign(prefixes.size(), URLRows());
+  for (size_t i = 0; i < prefixes.size(); ++i) {
+    AutocompleteForPrefix(prefixes[i] + text, max_results, typed_only,
+                          &(*results)[i]);
+  }
+}
+
 bool URLDatabase::IsTypedHost(const std::string& host) {
   const char* schemes[] = {
     url::kHttpScheme,
@@ -168,6 +168,16 @@ class URLDatabase {
                              bool typed_only,
                              URLRows* results);
 
+  // Fills each element of |results| with the URLs AutocompleteForPrefix()
+  // finds for the matching string of |prefixes| followed by |text|.  This
+  // runs one query per prefix; it is virtual so that the in-memory database
+  // can answer from its URLPrefixIndex instead.
+  virtual void AutocompleteForPrefixes(const std::vector<std::string>& prefixes,
+                                       const std::string& text,
+                                       size_t max_results,
+                                       bool typed_only,
+                                       std::vector<URLRows>* results);
+
   // Returns true if the database holds some past typed navigation to a URL on
   // the provided hostname.
   bool IsTypedHost(const std::string& host);
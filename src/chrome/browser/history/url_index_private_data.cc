@@ -160,9 +160,6 @@ ScoredHistoryMatches URLIndexPrivateData::HistoryItemsForTerms(
       (cursor_position > 0)) {
     search_string.insert(cursor_position, base::ASCIIToUTF16(" "));
   }
-  pre_filter_item_count_ = 0;
-  post_filter_item_count_ = 0;
-  post_scoring_item_count_ = 0;
   // The search string we receive may contain escaped characters. For reducing
   // the index we need individual, lower-cased words, ignoring escapings. For
   // the final filtering we need whitespace separated substrings possibly
@@ -178,45 +175,79 @@ ScoredHistoryMatches URLIndexPrivateData::HistoryItemsForTerms(
       history::String16VectorFromString16(lower_unescaped_string, false, NULL));
   ScoredHistoryMatches scored_items;
 
-  // Do nothing if we have indexed no words (probably because we've not been
-  // initialized yet) or the search string has no words.
-  if (word_list_.empty() || lower_words.empty()) {
-    search_term_cache_.clear();  // Invalidate the term cache.
-    return scored_items;
-  }
+  // We call these 'terms' (as opposed to 'words'; see above) as in this case
+  // we only want to break up the search string on 'true' whitespace rather than
+  // escaped whitespace. When the user types "colspec=ID%20Mstone Release" we
+  // get two 'terms': "colspec=id%20mstone" and "release".
+  history::String16Vector lower_raw_terms;
+  const bool has_terms = Tokenize(lower_raw_string, base::kWhitespaceUTF16,
+                                  &lower_raw_terms) != 0;
+
+  // The candidates and the index data needed to score them are copied while
+  // |lock_| is held, so that index updates on the main thread only wait for
+  // the lookup and not for the scoring.
+  HistoryInfoMap candidates;
+  WordStartsMap candidate_word_starts;
+  bool was_trimmed = false;
+  {
+    base::AutoLock lock(lock_);
+    pre_filter_item_count_ = 0;
+    post_filter_item_count_ = 0;
+    post_scoring_item_count_ = 0;
+
+    // Do nothing if we have indexed no words (probably because we've not been
+    // initialized yet) or the search string has no words.
+    if (word_list_.empty() || lower_words.empty()) {
+      search_term_cache_.clear();  // Invalidate the term cache.
+      return scored_items;
+    }
 
-  // Reset used_ flags for search_term_cache_. We use a basic mark-and-sweep
-  // approach.
-  ResetSearchTermCache();
-
-  HistoryIDSet history_id_set = HistoryIDSetFromWords(lower_words);
-
-  // Trim the candidate pool if it is large. Note that we do not filter out
-  // items that do not contain the search terms as proper substrings -- doing
-  // so is the performance-costly operation we are trying to avoid in order
-  // to maintain omnibox responsiveness.
-  const size_t kItemsToScoreLimit = 500;
-  pre_filter_item_count_ = history_id_set.size();
-  // If we trim the results set we do not want to cache the results for next
-  // time as the user's ultimately desired result could easily be eliminated
-  // in this early rough filter.
-  bool was_trimmed = (pre_filter_item_count_ > kItemsToScoreLimit);
-  if (was_trimmed) {
-    HistoryIDVector history_ids;
-    std::copy(history_id_set.begin(), history_id_set.end(),
-              std::back_inserter(history_ids));
-    // Trim down the set by sorting by typed-count, visit-count, and last
-    // visit.
-    HistoryItemFactorGreater
-        item_factor_functor(history_info_map_);
-    std::partial_sort(history_ids.begin(),
-                      history_ids.begin() + kItemsToScoreLimit,
-                      history_ids.end(),
-                      item_factor_functor);
-    history_id_set.clear();
-    std::copy(history_ids.begin(), history_ids.begin() + kItemsToScoreLimit,
-              std::inserter(history_id_set, history_id_set.end()));
-    post_filter_item_count_ = history_id_set.size();
+    // Reset used_ flags for search_term_cache_. We use a basic mark-and-sweep
+    // approach.
+    ResetSearchTermCache();
+
+    HistoryIDSet history_id_set = HistoryIDSetFromWords(lower_words);
+
+    // Trim the candidate pool if it is large. Note that we do not filter out
+    // items that do not contain the search terms as proper substrings --
+    // doing so is the performance-costly operation we are trying to avoid in
+    // order to maintain omnibox responsiveness.
+    const size_t kItemsToScoreLimit = 500;
+    pre_filter_item_count_ = history_id_set.size();
+    // If we trim the results set we do not want to cache the results for next
+    // time as the user's ultimately desired result could easily be eliminated
+    // in this early rough filter.
+    was_trimmed = (pre_filter_item_count_ > kItemsToScoreLimit);
+    if (was_trimmed) {
+      HistoryIDVector history_ids;
+      std::copy(history_id_set.begin(), history_id_set.end(),
+                std::back_inserter(history_ids));
+      // Trim down the set by sorting by typed-count, visit-count, and last
+      // visit.
+      HistoryItemFactorGreater
+          item_factor_functor(history_info_map_);
+      std::partial_sort(history_ids.begin(),
+                        history_ids.begin() + kItemsToScoreLimit,
+                        history_ids.end(),
+                        item_factor_functor);
+      history_id_set.clear();
+      std::copy(history_ids.begin(), history_ids.begin() + kItemsToScoreLimit,
+                std::inserter(history_id_set, history_id_set.end()));
+      post_filter_item_count_ = history_id_set.size();
+    }
+
+    if (has_terms) {
+      for (HistoryIDSet::const_iterator i = history_id_set.begin();
+           i != history_id_set.end(); ++i) {
+        HistoryInfoMap::const_iterator info = history_info_map_.find(*i);
+        if (info == history_info_map_.end())
+          continue;
+        candidates.insert(*info);
+        WordStartsMap::const_iterator starts = word_starts_map_.find(*i);
+        DCHECK(starts != word_starts_map_.end());
+        candidate_word_starts.insert(*starts);
+      }
+    }
   }
 
   // Pass over all of the candidates filtering out any without a proper
@@ -225,14 +256,7 @@ ScoredHistoryMatches URLIndexPrivateData::HistoryItemsForTerms(
   // URL elements. When the user has specifically typed something akin to
   // "sort=pri&colspec=ID%20Mstone%20Release" we want to make sure that that
   // specific substring appears in the URL or page title.
-
-  // We call these 'terms' (as opposed to 'words'; see above) as in this case
-  // we only want to break up the search string on 'true' whitespace rather than
-  // escaped whitespace. When the user types "colspec=ID%20Mstone Release" we
-  // get two 'terms': "colspec=id%20mstone" and "release".
-  history::String16Vector lower_raw_terms;
-  if (Tokenize(lower_raw_string, base::kWhitespaceUTF16,
-               &lower_raw_terms) == 0) {
+  if (!has_terms) {
     // Don't score matches when there are no terms to score against.  (It's
     // possible that the word break iterater that extracts words to search
     // for in the database allows some whitespace "words" whereas Tokenize
@@ -242,9 +266,15 @@ ScoredHistoryMatches URLIndexPrivateData::HistoryItemsForTerms(
     // but this is such a rare edge case that it's not worth the time.
     return scored_items;
   }
-  scored_items = std::for_each(history_id_set.begin(), history_id_set.end(),
-      AddHistoryMatch(*this, languages, bookmark_service, lower_raw_string,
-                      lower_raw_terms, base::Time::Now())).ScoredMatches();
+  AddHistoryMatch add_history_match(candidates, candidate_word_starts,
+                                    languages, bookmark_service,
+                                    lower_raw_string, lower_raw_terms,
+                                    base::Time::Now());
+  for (HistoryInfoMap::const_iterator i = candidates.begin();
+       i != candidates.end(); ++i) {
+    add_history_match(i->first);
+  }
+  scored_items = add_history_match.ScoredMatches();
 
   // Select and sort only the top kMaxMatches results.
   if (scored_items.size() > AutocompleteProvider::kMaxMatches) {
@@ -258,6 +288,8 @@ ScoredHistoryMatches URLIndexPrivateData::HistoryItemsForTerms(
     std::sort(scored_items.begin(), scored_items.end(),
               ScoredHistoryMatch::MatchScoreGreater);
   }
+
+  base::AutoLock lock(lock_);
   post_scoring_item_count_ = scored_items.size();
 
   if (was_trimmed) {
@@ -281,6 +313,8 @@ bool URLIndexPrivateData::UpdateURL(
     const URLRow& row,
     const std::string& languages,
     const std::set<std::string>& scheme_whitelist) {
+  base::AutoLock lock(lock_);
+
   // The row may or may not already be in our index. If it is not already
   // indexed and it qualifies then it gets indexed. If it is already
   // indexed and still qualifies then it gets updated, otherwise it
@@ -336,6 +370,7 @@ bool URLIndexPrivateData::UpdateURL(
 void URLIndexPrivateData::UpdateRecentVisits(
     URLID url_id,
     const VisitVector& recent_visits) {
+  base::AutoLock lock(lock_);
   HistoryInfoMap::iterator row_pos = history_info_map_.find(url_id);
   if (row_pos != history_info_map_.end()) {
     VisitInfoVector* visits = &row_pos->second.visits;
@@ -377,6 +412,7 @@ class HistoryInfoMapItemHasURL {
 };
 
 bool URLIndexPrivateData::DeleteURL(const GURL& url) {
+  base::AutoLock lock(lock_);
   // Find the matching entry in the history_info_map_.
   HistoryInfoMap::iterator pos = std::find_if(
       history_info_map_.begin(),
@@ -496,6 +532,7 @@ bool URLIndexPrivateData::Empty() const {
 }
 
 void URLIndexPrivateData::Clear() {
+  base::AutoLock lock(lock_);
   last_time_rebuilt_from_history_ = base::Time();
   word_list_.clear();
   available_words_.clear();
@@ -1261,13 +1298,15 @@ URLIndexPrivateData::SearchTermCacheItem::~SearchTermCacheItem() {}
 // URLIndexPrivateData::AddHistoryMatch ----------------------------------------
 
 URLIndexPrivateData::AddHistoryMatch::AddHistoryMatch(
-    const URLIndexPrivateData& private_data,
+    const HistoryInfoMap& history_info_map,
+    const WordStartsMap& word_starts_map,
     const std::string& languages,
     BookmarkService* bookmark_service,
     const base::string16& lower_string,
     const String16Vector& lower_terms,
     const base::Time now)
-  : private_data_(private_data),
+  : history_info_map_(history_info_map),
+    word_starts_map_(word_starts_map),
     languages_(languages),
     bookmark_service_(bookmark_service),
     lower_string_(lower_string),
@@ -1296,13 +1335,13 @@ URLIndexPrivateData::AddHistoryMatch::~AddHistoryMatch() {}
 void URLIndexPrivateData::AddHistoryMatch::operator()(
     const HistoryID history_id) {
   HistoryInfoMap::const_iterator hist_pos =
-      private_data_.history_info_map_.find(history_id);
-  if (hist_pos != private_data_.history_info_map_.end()) {
+      history_info_map_.find(history_id);
+  if (hist_pos != history_info_map_.end()) {
     const URLRow& hist_item = hist_pos->second.url_row;
     const VisitInfoVector& visits = hist_pos->second.visits;
     WordStartsMap::const_iterator starts_pos =
-        private_data_.word_starts_map_.find(history_id);
-    DCHECK(starts_pos != private_data_.word_starts_map_.end());
+        word_starts_map_.find(history_id);
+    DCHECK(starts_pos != word_starts_map_.end());
     ScoredHistoryMatch match(hist_item, visits, languages_, lower_string_,
                              lower_terms_, lower_terms_to_word_starts_offsets_,
                              starts_pos->second, now_, bookmark_service_);
@@ -11,6 +11,7 @@
 #include "base/files/file_path.h"
 #include "base/gtest_prod_util.h"
 #include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
 #include "chrome/browser/common/cancelable_request.h"
 #include "chrome/browser/history/history_service.h"
 #include "chrome/browser/history/in_memory_url_index_cache.pb.h"
@@ -41,7 +42,10 @@ static const int kCurrentCacheFileVersion = 4;
 // be no calls from any other class.
 //
 // All public member functions are called on the main thread unless otherwise
-// annotated.
+// annotated.  HistoryItemsForTerms() may also run on a worker thread, holding
+// a reference to the instance; the functions which update the index wait while
+// such a query looks up and copies its candidates, but not while it scores
+// them.
 class URLIndexPrivateData
     : public base::RefCountedThreadSafe<URLIndexPrivateData> {
  public:
@@ -65,7 +69,8 @@ class URLIndexPrivateData
   // |kItemsToScoreLimit| limit) will be retained and used for subsequent calls
   // to this function. |bookmark_service| is used to boost a result's score if
   // its URL is referenced by one or more of the user's bookmarks.  |languages|
-  // is used to help parse/format the URLs in the history index.
+  // is used to help parse/format the URLs in the history index.  This may be
+  // called on any thread.
   ScoredHistoryMatches HistoryItemsForTerms(base::string16 term_string,
                                             size_t cursor_position,
                                             const std::string& languages,
@@ -194,7 +199,8 @@ class URLIndexPrivateData
   // history URL match, inserting accepted matches into |scored_matches_|.
   class AddHistoryMatch : public std::unary_function<HistoryID, void> {
    public:
-    AddHistoryMatch(const URLIndexPrivateData& private_data,
+    AddHistoryMatch(const HistoryInfoMap& history_info_map,
+                    const WordStartsMap& word_starts_map,
                     const std::string& languages,
                     BookmarkService* bookmark_service,
                     const base::string16& lower_string,
@@ -207,7 +213,8 @@ class URLIndexPrivateData
     ScoredHistoryMatches ScoredMatches() const { return scored_matches_; }
 
    private:
-    const URLIndexPrivateData& private_data_;
+    const HistoryInfoMap& history_info_map_;
+    const WordStartsMap& word_starts_map_;
     const std::string& languages_;
     BookmarkService* bookmark_service_;
     ScoredHistoryMatches scored_matches_;
@@ -323,6 +330,14 @@ class URLIndexPrivateData
   static bool URLSchemeIsWhitelisted(const GURL& gurl,
                                      const std::set<std::string>& whitelist);
 
+  // Held by the functions which update the index on the main thread, and by
+  // queries, which may run on a worker thread, only while they look up and
+  // copy their candidates and while they sweep |search_term_cache_|; scoring
+  // runs on the copies without it.  Functions which only read the index on the
+  // main thread do not need it, since queries change nothing but
+  // |search_term_cache_| and the item counts below.
+  base::Lock lock_;
+
   // Cache of search terms.
   SearchTermCacheMap search_term_cache_;
 
@@ -0,0 +1,158 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/history/url_prefix_index.h"
+
+#include <algorithm>
+
+#include "base/strings/string_util.h"
+#include "base/strings/utf_string_conversions.h"
+#include "chrome/browser/autocomplete/url_prefix.h"
+#include "chrome/browser/history/url_database.h"
+
+namespace history {
+
+URLPrefixIndex::Entry::Entry()
+    : prefix(0),
+      id(0),
+      typed_count(0),
+      visit_count(0) {
+}
+
+URLPrefixIndex::Entry::~Entry() {}
+
+URLPrefixIndex::URLPrefixIndex() {
+  // GetURLPrefixes() lists the longest prefixes first and ends with the empty
+  // prefix, so the first one a URL starts with is its longest.
+  const URLPrefixes& prefixes = URLPrefix::GetURLPrefixes();
+  for (URLPrefixes::const_iterator i(prefixes.begin()); i != prefixes.end();
+       ++i)
+    prefixes_.push_back(base::UTF16ToUTF8(i->prefix));
+  DCHECK(!prefixes_.empty() && prefixes_.back().empty());
+}
+
+URLPrefixIndex::~URLPrefixIndex() {}
+
+void URLPrefixIndex::Reset(const URLRows& rows) {
+  Clear();
+  for (URLRows::const_iterator i(rows.begin()); i != rows.end(); ++i) {
+    if (i->hidden() || !i->url().is_valid() || rows_.count(i->id()))
+      continue;
+    rows_[i->id()] = *i;
+    entries_.push_back(MakeEntry(*i));
+  }
+  std::sort(entries_.begin(), entries_.end(), &URLPrefixIndex::EntryLess);
+}
+
+void URLPrefixIndex::AddOrUpdate(const URLRow& row) {
+  Delete(row.id());
+  if (row.hidden() || !row.url().is_valid())
+    return;
+  rows_[row.id()] = row;
+  const Entry entry(MakeEntry(row));
+  entries_.insert(std::upper_bound(entries_.begin(), entries_.end(), entry,
+                                   &URLPrefixIndex::EntryLess),
+                  entry);
+}
+
+void URLPrefixIndex::Delete(URLID id) {
+  std::map<URLID, URLRow>::iterator row = rows_.find(id);
+  if (row == rows_.end())
+    return;
+  const Entry entry(MakeEntry(row->second));
+  Entries::iterator i = std::lower_bound(entries_.begin(), entries_.end(),
+                                         entry, &URLPrefixIndex::EntryLess);
+  DCHECK(i != entries_.end() && i->id == id);
+  entries_.erase(i);
+  rows_.erase(row);
+}
+
+void URLPrefixIndex::Clear() {
+  entries_.clear();
+  rows_.clear();
+}
+
+void URLPrefixIndex::AutocompleteForPrefixes(
+    const std::vector<std::string>& prefixes,
+    const std::string& text,
+    size_t max_results,
+    bool typed_only,
+    std::vector<URLRows>* results) const {
+  results->assign(prefixes.size(), URLRows());
+  std::vector<const Entry*> candidates;
+  for (size_t i = 0; i < prefixes.size(); ++i) {
+    candidates.clear();
+    AddCandidates(prefixes[i] + text, typed_only, &candidates);
+    const size_t count = std::min(max_results, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count,
+                      candidates.end(), &URLPrefixIndex::EntryRanksHigher);
+    URLRows* rows = &(*results)[i];
+    rows->reserve(count);
+    for (size_t j = 0; j < count; ++j)
+      rows->push_back(rows_.find(candidates[j]->id)->second);
+  }
+}
+
+// static
+bool URLPrefixIndex::EntryLess(const Entry& a, const Entry& b) {
+  if (a.prefix != b.prefix)
+    return a.prefix < b.prefix;
+  const int key_order = a.key.compare(b.key);
+  if (key_order != 0)
+    return key_order < 0;
+  return a.id < b.id;
+}
+
+// static
+bool URLPrefixIndex::EntryRanksHigher(const Entry* a, const Entry* b) {
+  if (a->typed_count != b->typed_count)
+    return a->typed_count > b->typed_count;
+  if (a->visit_count != b->visit_count)
+    return a->visit_count > b->visit_count;
+  if (a->last_visit != b->last_visit)
+    return a->last_visit > b->last_visit;
+  return a->id < b->id;
+}
+
+URLPrefixIndex::Entry URLPrefixIndex::MakeEntry(const URLRow& row) const {
+  // Match the URL as the database stores it, as AutocompleteForPrefix() does.
+  const std::string url(URLDatabase::GURLToDatabaseURL(row.url()));
+  Entry entry;
+  while (!StartsWithASCII(url, prefixes_[entry.prefix], true))
+    ++entry.prefix;
+  entry.key = url.substr(prefixes_[entry.prefix].length());
+  entry.id = row.id();
+  entry.typed_count = row.typed_count();
+  entry.visit_count = row.visit_count();
+  entry.last_visit = row.last_visit();
+  return entry;
+}
+
+void URLPrefixIndex::AddCandidates(
+    const std::string& text,
+    bool typed_only,
+    std::vector<const Entry*>* candidates) const {
+  for (size_t prefix = 0; prefix < prefixes_.size(); ++prefix) {
+    // A URL starts with |text| if its prefix starts with |text|, or if its
+    // prefix is a start of |text| and its key starts with the remainder.
+    Entry bound;
+    bound.prefix = prefix;
+    if (!StartsWithASCII(prefixes_[prefix], text, true)) {
+      if (!StartsWithASCII(text, prefixes_[prefix], true))
+        continue;
+      bound.key = text.substr(prefixes_[prefix].length());
+    }
+    for (Entries::const_iterator i(std::lower_bound(
+             entries_.begin(), entries_.end(), bound,
+             &URLPrefixIndex::EntryLess));
+         (i != entries_.end()) && (i->prefix == prefix) &&
+         StartsWithASCII(i->key, bound.key, true);
+         ++i) {
+      if (!typed_only || (i->typed_count > 0))
+        candidates->push_back(&(*i));
+    }
+  }
+}
+
+}  // namespace history
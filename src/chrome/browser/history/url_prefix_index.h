@@ -0,0 +1,103 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_HISTORY_URL_PREFIX_INDEX_H_
+#define CHROME_BROWSER_HISTORY_URL_PREFIX_INDEX_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/time/time.h"
+#include "chrome/browser/history/history_types.h"
+
+namespace history {
+
+// An in-memory index of URL rows for autocompleting typed text, which answers
+// the queries of URLDatabase::AutocompleteForPrefix() for every URLPrefix
+// variant of the text at once, without SQL.
+//
+// Each URL is split into the longest URLPrefix it starts with ("http://www.",
+// "https://", ...) and the rest, its key.  The index is a sorted array of
+// (prefix, key) entries carrying the typed count, visit count and last visit
+// used to rank them.  A URL starts with some string when its prefix starts
+// with that string, or its prefix is a start of that string and its key
+// starts with the remainder; each of those is a binary search in the array.
+class URLPrefixIndex {
+ public:
+  URLPrefixIndex();
+  ~URLPrefixIndex();
+
+  // Replaces the contents of the index with |rows|.
+  void Reset(const URLRows& rows);
+
+  // Adds |row|, or updates the row with the same id.  Hidden rows and rows
+  // with invalid URLs are removed instead, since they never autocomplete.
+  void AddOrUpdate(const URLRow& row);
+
+  // Removes the row with |id|, if any.
+  void Delete(URLID id);
+
+  void Clear();
+
+  size_t size() const { return rows_.size(); }
+
+  // For each string in |prefixes|, fills the matching element of |results|
+  // with up to |max_results| rows whose URL starts with that string followed
+  // by |text|.  Rows are ordered as URLDatabase::AutocompleteForPrefix() orders
+  // them: by typed count, then by visit count, then most recent first.  If
+  // |typed_only| is true, only rows which were typed at least once are
+  // returned.
+  void AutocompleteForPrefixes(const std::vector<std::string>& prefixes,
+                               const std::string& text,
+                               size_t max_results,
+                               bool typed_only,
+                               std::vector<URLRows>* results) const;
+
+ private:
+  struct Entry {
+    Entry();
+    ~Entry();
+
+    // Index into |prefixes_| of the longest prefix of the URL.
+    size_t prefix;
+    // The rest of the URL.
+    std::string key;
+    URLID id;
+    int typed_count;
+    int visit_count;
+    base::Time last_visit;
+  };
+  typedef std::vector<Entry> Entries;
+
+  // Orders entries by prefix, then key.
+  static bool EntryLess(const Entry& a, const Entry& b);
+
+  // Orders entries as autocomplete results.
+  static bool EntryRanksHigher(const Entry* a, const Entry* b);
+
+  // Returns the entry for |row|, without its position in |entries_|.
+  Entry MakeEntry(const URLRow& row) const;
+
+  // Adds the entries whose URL starts with |text| to |candidates|.
+  void AddCandidates(const std::string& text,
+                     bool typed_only,
+                     std::vector<const Entry*>* candidates) const;
+
+  // The URLPrefixes, longest first, in UTF-8.
+  std::vector<std::string> prefixes_;
+
+  // Sorted by EntryLess().
+  Entries entries_;
+
+  // The full rows, by id.
+  std::map<URLID, URLRow> rows_;
+
+  DISALLOW_COPY_AND_ASSIGN(URLPrefixIndex);
+};
+
+}  // namespace history
+
+#endif  // CHROME_BROWSER_HISTORY_URL_PREFIX_INDEX_H_
@@ -0,0 +1,134 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversions.h"
+#include "base/time/time.h"
+#include "chrome/browser/autocomplete/url_prefix.h"
+#include "chrome/browser/history/url_database.h"
+#include "chrome/browser/history/url_prefix_index.h"
+#include "sql/connection.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace history {
+
+namespace {
+
+// A history of kHosts * kPathsPerHost URLs over a few schemes.
+const int kHosts = 2000;
+const int kPathsPerHost = 10;
+const char* const kSchemes[] = { "http://www.", "https://", "http://" };
+
+// URLs typed one character at a time.
+const char* const kTyped[] = {
+  "site1234.example.com/page5", "www.site42.example.com/", "https://s",
+};
+
+// Results asked for per prefix, as HistoryURLProvider does.
+const size_t kMaxResults = 6;
+
+std::vector<std::string> PrefixStrings() {
+  std::vector<std::string> strings;
+  const URLPrefixes& prefixes = URLPrefix::GetURLPrefixes();
+  for (URLPrefixes::const_iterator i(prefixes.begin()); i != prefixes.end();
+       ++i)
+    strings.push_back(base::UTF16ToUTF8(i->prefix));
+  return strings;
+}
+
+// Returns the 99th percentile of |times|, which it sorts, in microseconds.
+size_t P99Microseconds(std::vector<base::TimeDelta>* times) {
+  std::sort(times->begin(), times->end());
+  return static_cast<size_t>(
+      (*times)[(times->size() - 1) * 99 / 100].InMicroseconds());
+}
+
+}  // namespace
+
+class URLPrefixIndexPerfTest : public testing::Test,
+                               public URLDatabase {
+ public:
+  URLPrefixIndexPerfTest() {}
+
+ protected:
+  // Provided for URLDatabase.
+  virtual sql::Connection& GetDB() OVERRIDE {
+    return db_;
+  }
+
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(db_.OpenInMemory());
+    CreateURLTable(false);
+    CreateMainURLIndex();
+  }
+
+  virtual void TearDown() OVERRIDE {
+    db_.Close();
+  }
+
+  sql::Connection db_;
+  URLPrefixIndex index_;
+};
+
+// Types URLs one character at a time into a large history and reports the
+// 99th percentile latency of looking up every prefix variant, in SQL and in
+// the index.
+TEST_F(URLPrefixIndexPerfTest, KeystrokeLatency) {
+  for (int host = 0; host < kHosts; ++host) {
+    for (int path = 0; path < kPathsPerHost; ++path) {
+      const int visit_count = host * kPathsPerHost + path + 1;
+      URLRow row(GURL(base::StringPrintf(
+          "%ssite%d.example.com/page%d",
+          kSchemes[host % arraysize(kSchemes)], host, path)));
+      row.set_visit_count(visit_count);
+      row.set_typed_count(visit_count % 3);
+      row.set_last_visit(base::Time::Now() -
+                         base::TimeDelta::FromHours(visit_count));
+      AddURL(row);
+    }
+  }
+  URLRows rows;
+  URLEnumerator enumerator;
+  ASSERT_TRUE(InitURLEnumeratorForEverything(&enumerator));
+  URLRow row;
+  while (enumerator.GetNextURL(&row))
+    rows.push_back(row);
+  index_.Reset(rows);
+
+  const std::vector<std::string> prefixes(PrefixStrings());
+  std::vector<base::TimeDelta> database_times;
+  std::vector<base::TimeDelta> index_times;
+  for (size_t i = 0; i < arraysize(kTyped); ++i) {
+    const std::string typed(kTyped[i]);
+    for (size_t length = 1; length <= typed.length(); ++length) {
+      const std::string text(typed.substr(0, length));
+      std::vector<URLRows> expected;
+      base::TimeTicks start = base::TimeTicks::Now();
+      URLDatabase::AutocompleteForPrefixes(prefixes, text, kMaxResults, true,
+                                           &expected);
+      database_times.push_back(base::TimeTicks::Now() - start);
+
+      std::vector<URLRows> actual;
+      start = base::TimeTicks::Now();
+      index_.AutocompleteForPrefixes(prefixes, text, kMaxResults, true,
+                                     &actual);
+      index_times.push_back(base::TimeTicks::Now() - start);
+      ASSERT_EQ(expected.size(), actual.size()) << text;
+    }
+  }
+
+  const std::string trace = base::StringPrintf(
+      "%d_urls", kHosts * kPathsPerHost);
+  perf_test::PrintResult("prefix_lookup_p99_sql", "", trace,
+                         P99Microseconds(&database_times), "us", true);
+  perf_test::PrintResult("prefix_lookup_p99_index", "", trace,
+                         P99Microseconds(&index_times), "us", true);
+}
+
+}  // namespace history
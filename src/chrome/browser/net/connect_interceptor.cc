@@ -28,6 +28,9 @@ void ConnectInterceptor::WitnessURLRequest(net::URLRequest* request) {
   // Learn what URLs are likely to be needed during next startup.
   predictor_->LearnAboutInitialNavigation(request_scheme_host);
 
+  // Credit any speculative preconnection which this request used.
+  predictor_->ObserveRequestForPreconnectFeedback(request_scheme_host);
+
   bool redirected_host = false;
   bool is_subresource = !(request->load_flags() & net::LOAD_MAIN_FRAME);
   if (request->referrer().empty()) {
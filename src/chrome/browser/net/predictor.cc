@@ -11,8 +11,11 @@
 
 #include "base/basictypes.h"
 #include "base/bind.h"
+#include "base/bind_helpers.h"
 #include "base/compiler_specific.h"
 #include "base/containers/mru_cache.h"
+#include "base/file_util.h"
+#include "base/files/important_file_writer.h"
 #include "base/metrics/histogram.h"
 #include "base/prefs/pref_service.h"
 #include "base/prefs/scoped_user_pref_update.h"
@@ -26,6 +29,7 @@
 #include "base/values.h"
 #include "chrome/browser/io_thread.h"
 #include "chrome/browser/net/preconnect.h"
+#include "chrome/browser/net/referrer_graph.h"
 #include "chrome/browser/net/spdyproxy/proxy_advisor.h"
 #include "chrome/browser/prefs/session_startup_pref.h"
 #include "chrome/common/chrome_switches.h"
@@ -69,6 +73,7 @@ const double Predictor::kReferrerTrimRatio = 0.97153;
 const int64 Predictor::kDurationBetweenTrimmingsHours = 1;
 const int64 Predictor::kDurationBetweenTrimmingIncrementsSeconds = 15;
 const size_t Predictor::kUrlsTrimmedPerIncrement = 5u;
+const size_t Predictor::kMaxUnusedSpeculativePreconnects = 8u;
 const size_t Predictor::kMaxSpeculativeParallelResolves = 3;
 const int Predictor::kMaxUnusedSocketLifetimeSecondsWithoutAGet = 10;
 // To control our congestion avoidance system, which discards a queue when
@@ -263,6 +268,88 @@ void Predictor::PreconnectUsage::ObserveLinkNavigation(const GURL& url) {
   UMA_HISTOGRAM_BOOLEAN("Net.PreconnectedLinkNavigations", did_use_preconnect);
 }
 
+Predictor::PreconnectFeedback::PreconnectFeedback()
+    : max_unused_lifetime_(base::TimeDelta::FromSeconds(
+          Predictor::kMaxUnusedSocketLifetimeSecondsWithoutAGet)) {
+}
+
+Predictor::PreconnectFeedback::~PreconnectFeedback() {}
+
+void Predictor::PreconnectFeedback::ObservePreconnect(
+    const GURL& referrer,
+    const GURL& subresource,
+    const GURL& url,
+    base::TimeTicks now) {
+  // A repeated preconnection mostly finds the earlier sockets still idle, so
+  // it is credited to the earlier one.
+  if (unused_.find(url) != unused_.end())
+    return;
+  UnusedPreconnect& preconnect = unused_[url];
+  preconnect.referrer = referrer;
+  preconnect.subresource = subresource;
+  preconnect.time = now;
+  expiry_queue_.push(std::make_pair(now, url));
+}
+
+void Predictor::PreconnectFeedback::ObserveRequest(
+    const GURL& url,
+    base::TimeTicks now,
+    std::vector<Outcome>* outcomes) {
+  ExpireUnused(now, outcomes);
+
+  UnusedPreconnects::iterator it = unused_.find(url);
+  if (it == unused_.end())
+    return;
+  Outcome outcome;
+  outcome.referrer = it->second.referrer;
+  outcome.subresource = it->second.subresource;
+  outcome.was_used = true;
+  outcome.lead_time = now - it->second.time;
+  outcomes->push_back(outcome);
+  unused_.erase(it);
+}
+
+void Predictor::PreconnectFeedback::ExpireUnused(
+    base::TimeTicks now,
+    std::vector<Outcome>* outcomes) {
+  while (!expiry_queue_.empty() &&
+         now - expiry_queue_.front().first >= max_unused_lifetime_) {
+    UnusedPreconnects::iterator it = unused_.find(expiry_queue_.front().second);
+    if (it != unused_.end() && it->second.time == expiry_queue_.front().first) {
+      Outcome outcome;
+      outcome.referrer = it->second.referrer;
+      outcome.subresource = it->second.subresource;
+      outcome.was_used = false;
+      outcomes->push_back(outcome);
+      unused_.erase(it);
+    }
+    expiry_queue_.pop();
+  }
+}
+
+void Predictor::PreconnectFeedback::Clear() {
+  unused_.clear();
+  expiry_queue_ = std::queue<std::pair<base::TimeTicks, GURL> >();
+}
+
+namespace {
+
+scoped_refptr<ReferrerGraph> LoadReferrerGraphOnFileThread(
+    const base::FilePath& path) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+  base::TimeTicks start = base::TimeTicks::Now();
+  scoped_refptr<ReferrerGraph> graph = ReferrerGraph::CreateFromFile(path);
+  if (graph.get()) {
+    UMA_HISTOGRAM_TIMES("Net.PredictorReferrerGraphLoadTime",
+                        base::TimeTicks::Now() - start);
+    UMA_HISTOGRAM_COUNTS("Net.PredictorReferrerGraphReferrers",
+                         graph->url_count());
+  }
+  return graph;
+}
+
+}  // namespace
+
 Predictor::Predictor(bool preconnect_enabled)
     : url_request_context_getter_(NULL),
       predictor_enabled_(true),
@@ -276,6 +363,7 @@ Predictor::Predictor(bool preconnect_enabled)
       ssl_config_service_(NULL),
       preconnect_enabled_(preconnect_enabled),
       consecutive_omnibox_preconnect_count_(0),
+      referrer_graph_discarded_(false),
       next_trim_time_(base::TimeTicks::Now() +
                       TimeDelta::FromHours(kDurationBetweenTrimmingsHours)),
       observer_(NULL) {
@@ -530,6 +618,19 @@ void Predictor::DiscardAllResults() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
   // Delete anything listed so far in this session that shows in about:dns.
   referrers_.clear();
+  // Drop the mapping before the file is deleted, which fails on Windows while
+  // the file is mapped.  A graph still being loaded is dropped when it
+  // arrives.
+  referrer_graph_ = NULL;
+  referrer_graph_discarded_ = true;
+  preconnect_feedback_.Clear();
+  if (!referrer_graph_path_.empty()) {
+    BrowserThread::PostTask(
+        BrowserThread::FILE,
+        FROM_HERE,
+        base::Bind(base::IgnoreResult(&base::DeleteFile),
+                   referrer_graph_path_, false));
+  }
 
 
   // Try to delete anything in our work queue.
@@ -595,6 +696,7 @@ void Predictor::LearnFromNavigation(const GURL& referring_url,
   DCHECK_EQ(target_url, Predictor::CanonicalizeUrl(target_url));
   DCHECK_NE(target_url, GURL::EmptyGURL());
 
+  ImportReferrerFromGraph(referring_url);
   referrers_[referring_url].SuggestHost(target_url);
   // Possibly do some referrer trimming.
   TrimReferrers();
@@ -798,6 +900,55 @@ void Predictor::DeserializeReferrersThenDelete(
   delete referral_list;
 }
 
+void Predictor::SetReferrerGraph(const scoped_refptr<ReferrerGraph>& graph) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (referrer_graph_discarded_)
+    return;
+  referrer_graph_ = graph;
+}
+
+void Predictor::ImportReferrerFromGraph(const GURL& url) {
+  if (!referrer_graph_.get() || referrers_.find(url) != referrers_.end())
+    return;
+  Referrer referrer;
+  if (referrer_graph_->GetReferrer(url, &referrer))
+    referrers_[url] = referrer;
+}
+
+// static
+void Predictor::WriteReferrerGraphOnFileThread(
+    const base::FilePath& path,
+    scoped_ptr<Referrers> referrers) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+  // Only this predictor writes |path|, so the file still holds the graph it
+  // loaded at startup, or nothing if the graph was discarded since.
+  // Referrers which were never copied out of it this session are carried
+  // over, trimmed once as the shutdown trim did for the others.
+  {
+    scoped_refptr<ReferrerGraph> loaded = ReferrerGraph::CreateFromFile(path);
+    if (loaded.get()) {
+      std::vector<GURL> urls;
+      loaded->GetReferrerUrls(&urls);
+      for (size_t i = 0; i < urls.size(); ++i) {
+        if (referrers->find(urls[i]) != referrers->end())
+          continue;
+        Referrer referrer;
+        loaded->GetReferrer(urls[i], &referrer);
+        if (referrer.Trim(kReferrerTrimRatio, kDiscardableExpectedValue))
+          (*referrers)[urls[i]] = referrer;
+      }
+    }
+    // |loaded| is unmapped here, as Windows cannot replace a mapped file.
+  }
+
+  std::string image;
+  ReferrerGraph::Build(*referrers, &image);
+  UMA_HISTOGRAM_COUNTS("Net.PredictorReferrerGraphKilobytes",
+                       image.size() / 1024);
+  if (!base::ImportantFileWriter::WriteFileAtomically(path, image))
+    LOG(WARNING) << "Failed to write the referrer graph";
+}
+
 void Predictor::DiscardInitialNavigationHistory() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
   if (initial_observer_.get())
@@ -831,6 +982,15 @@ void Predictor::FinalizeInitializationOnIOThread(
   // Prefetch these hostnames on startup.
   DnsPrefetchMotivatedList(startup_urls, UrlInfo::STARTUP_LIST_MOTIVATED);
   DeserializeReferrersThenDelete(referral_list);
+
+  if (!referrer_graph_path_.empty()) {
+    BrowserThread::PostTaskAndReplyWithResult(
+        BrowserThread::FILE,
+        FROM_HERE,
+        base::Bind(&LoadReferrerGraphOnFileThread, referrer_graph_path_),
+        base::Bind(&Predictor::SetReferrerGraph,
+                   weak_factory_->GetWeakPtr()));
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -951,7 +1111,24 @@ void Predictor::SaveDnsPrefetchStateForNextStartupAndTrim(
   // Do at least one trim at shutdown, in case the user wasn't running long
   // enough to do any regular trimming of referrers.
   TrimReferrersNow();
-  SerializeReferrers(referral_list);
+  if (referrer_graph_path_.empty()) {
+    SerializeReferrers(referral_list);
+  } else {
+    // The referrers go to the graph file, so only the format version is left
+    // in the pref.  Older referrers in the pref are thereby migrated.
+    referral_list->Clear();
+    referral_list->Append(
+        new base::FundamentalValue(kPredictorReferrerVersion));
+    // Unmap the file before it is replaced.
+    referrer_graph_ = NULL;
+    referrer_graph_discarded_ = true;
+    BrowserThread::PostTask(
+        BrowserThread::FILE,
+        FROM_HERE,
+        base::Bind(&Predictor::WriteReferrerGraphOnFileThread,
+                   referrer_graph_path_,
+                   base::Passed(make_scoped_ptr(new Referrers(referrers_)))));
+  }
 
   completion->Signal();
 }
@@ -1035,6 +1212,47 @@ void Predictor::RecordPreconnectNavigationStat(
     preconnect_usage_->ObserveNavigationChain(url_chain, is_subresource);
 }
 
+void Predictor::ObserveRequestForPreconnectFeedback(const GURL& url) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (!predictor_enabled_)
+    return;
+  std::vector<PreconnectFeedback::Outcome> outcomes;
+  preconnect_feedback_.ObserveRequest(url, base::TimeTicks::Now(), &outcomes);
+  ApplyPreconnectOutcomes(outcomes);
+}
+
+bool Predictor::AdmitSpeculativePreconnect() {
+  std::vector<PreconnectFeedback::Outcome> outcomes;
+  preconnect_feedback_.ExpireUnused(base::TimeTicks::Now(), &outcomes);
+  ApplyPreconnectOutcomes(outcomes);
+
+  const bool admitted =
+      preconnect_feedback_.unused_count() < kMaxUnusedSpeculativePreconnects;
+  UMA_HISTOGRAM_BOOLEAN("Net.PreconnectSpeculationAdmitted", admitted);
+  return admitted;
+}
+
+void Predictor::ApplyPreconnectOutcomes(
+    const std::vector<PreconnectFeedback::Outcome>& outcomes) {
+  for (size_t i = 0; i < outcomes.size(); ++i) {
+    const PreconnectFeedback::Outcome& outcome = outcomes[i];
+    // The complement of this is the rate of wasted preconnections.
+    UMA_HISTOGRAM_BOOLEAN("Net.PreconnectFeedbackUsed", outcome.was_used);
+    if (outcome.was_used) {
+      UMA_HISTOGRAM_TIMES("Net.PreconnectFeedbackLeadTime",
+                          outcome.lead_time);
+    }
+
+    // The referrer may have been trimmed away in the meantime.
+    Referrers::iterator referrer = referrers_.find(outcome.referrer);
+    if (referrer == referrers_.end())
+      continue;
+    Referrer::iterator value = referrer->second.find(outcome.subresource);
+    if (value != referrer->second.end())
+      value->second.RecordPreconnectOutcome(outcome.was_used);
+  }
+}
+
 void Predictor::RecordLinkNavigation(const GURL& url) {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
   if (preconnect_usage_)
@@ -1096,6 +1314,7 @@ void Predictor::PrepareFrameSubresources(const GURL& original_url,
 
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
   DCHECK_EQ(url.GetWithEmptyPath(), url);
+  ImportReferrerFromGraph(url);
   Referrers::iterator it = referrers_.find(url);
   if (referrers_.end() == it) {
     // Only when we don't know anything about this url, make 2 connections
@@ -1123,13 +1342,22 @@ void Predictor::PrepareFrameSubresources(const GURL& original_url,
                                 static_cast<int>(connection_expectation * 100),
                                 10, 5000, 50);
     future_url->second.ReferrerWasObserved();
+    // Discount the expected use by how often our earlier preconnections to
+    // this subresource went unused.
+    const double preconnect_expectation =
+        connection_expectation * future_url->second.preconnect_utilization();
     if (preconnect_enabled_ &&
-        connection_expectation > kPreconnectWorthyExpectedValue) {
+        preconnect_expectation > kPreconnectWorthyExpectedValue &&
+        AdmitSpeculativePreconnect()) {
       evalution = PRECONNECTION;
       future_url->second.IncrementPreconnectionCount();
-      int count = static_cast<int>(std::ceil(connection_expectation));
+      int count = static_cast<int>(std::ceil(preconnect_expectation));
       if (url.host() == future_url->first.host())
         ++count;
+      preconnect_feedback_.ObservePreconnect(
+          url, future_url->first,
+          GetHSTSRedirectOnIOThread(future_url->first),
+          base::TimeTicks::Now());
       PreconnectUrlOnIOThread(future_url->first, first_party_for_cookies,
                               motivation, count);
     } else if (connection_expectation > kDNSPreresolutionWorthyExpectedValue) {
@@ -25,7 +25,9 @@
 #include <string>
 #include <vector>
 
+#include "base/files/file_path.h"
 #include "base/gtest_prod_util.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/weak_ptr.h"
 #include "chrome/browser/net/referrer.h"
@@ -57,6 +59,8 @@ class PrefRegistrySyncable;
 
 namespace chrome_browser_net {
 
+class ReferrerGraph;
+
 typedef chrome_common_net::UrlList UrlList;
 typedef chrome_common_net::NameList NameList;
 typedef std::map<GURL, UrlInfo> Results;
@@ -113,6 +117,12 @@ class Predictor {
   // TODO(jar): We should do a persistent field trial to validate/optimize this.
   static const int kMaxUnusedSocketLifetimeSecondsWithoutAGet;
 
+  // Speculative preconnections to learned subresources are only admitted
+  // while fewer than this many earlier ones are still waiting to be used.
+  // When pages load faster than their preconnections are used, further
+  // speculation would only compete with the foreground requests.
+  static const size_t kMaxUnusedSpeculativePreconnects;
+
   // |max_concurrent| specifies how many concurrent (parallel) prefetches will
   // be performed. Host lookups will be issued through |host_resolver|.
   explicit Predictor(bool preconnect_enabled);
@@ -128,6 +138,16 @@ class Predictor {
 
   // ------------- Start UI thread methods.
 
+  // Sets the file in which the referrer graph is kept.  The graph is not shared
+  // between principals: each has its own file, written only by its predictor,
+  // so that clearing one principal's data cannot be undone by another.  The
+  // file is mapped rather than parsed at startup.  If this is not set, the
+  // referrer graph is kept in |user_prefs| instead.  Must be called before
+  // InitNetworkPredictor().
+  void set_referrer_graph_path(const base::FilePath& path) {
+    referrer_graph_path_ = path;
+  }
+
   virtual void InitNetworkPredictor(PrefService* user_prefs,
                                     PrefService* local_state,
                                     IOThread* io_thread,
@@ -206,6 +226,12 @@ class Predictor {
 
   void DeserializeReferrersThenDelete(base::ListValue* referral_list);
 
+  // Uses |graph| to look up referrers which have not been seen yet in this
+  // session.  A referrer is copied out of |graph| the first time that it is
+  // used or learned about.  |graph| may be NULL, and is ignored if the graph
+  // was discarded while it was loading.
+  void SetReferrerGraph(const scoped_refptr<ReferrerGraph>& graph);
+
   void DiscardInitialNavigationHistory();
 
   void FinalizeInitializationOnIOThread(
@@ -259,6 +285,11 @@ class Predictor {
 
   void RecordLinkNavigation(const GURL& url);
 
+  // Records a request to |url|, which was canonicalized by CanonicalizeUrl(),
+  // so that the preconnections it used can be credited to the referrers which
+  // predicted them.
+  void ObserveRequestForPreconnectFeedback(const GURL& url);
+
   // ------------- End IO thread methods.
 
   // The following methods may be called on either the IO or UI threads.
@@ -322,6 +353,12 @@ class Predictor {
   FRIEND_TEST_ALL_PREFIXES(PredictorTest, PriorityQueuePushPopTest);
   FRIEND_TEST_ALL_PREFIXES(PredictorTest, PriorityQueueReorderTest);
   FRIEND_TEST_ALL_PREFIXES(PredictorTest, ReferrerSerializationTrimTest);
+  FRIEND_TEST_ALL_PREFIXES(PredictorTest, ReferrerGraphWriteMergesTest);
+  FRIEND_TEST_ALL_PREFIXES(PredictorTest, ReferrerGraphDiscardTest);
+  FRIEND_TEST_ALL_PREFIXES(PredictorPerfTest, ReferrerGraphStartup);
+  FRIEND_TEST_ALL_PREFIXES(PredictorTest, PreconnectFeedbackTest);
+  FRIEND_TEST_ALL_PREFIXES(PredictorTest, PreconnectAdmissionTest);
+  FRIEND_TEST_ALL_PREFIXES(PredictorTest, PreconnectUtilizationTest);
   FRIEND_TEST_ALL_PREFIXES(PredictorTest, SingleLookupTestWithDisabledAdvisor);
   FRIEND_TEST_ALL_PREFIXES(PredictorTest, SingleLookupTestWithEnabledAdvisor);
   FRIEND_TEST_ALL_PREFIXES(PredictorTest, TestSimplePreconnectAdvisor);
@@ -388,6 +425,68 @@ class Predictor {
     static const size_t kStartupResolutionCount = 10;
   };
 
+  // The PreconnectFeedback tracks the speculative preconnections made for
+  // learned subresources, to find out whether each was used by a request
+  // before its socket would have been dropped.  The outcomes are fed back into
+  // the referrers which predicted them.
+  class PreconnectFeedback {
+   public:
+    struct Outcome {
+      GURL referrer;
+      GURL subresource;
+      bool was_used;
+      // For a used preconnection, the time from preconnecting to the first
+      // request.  This bounds the connection setup time that was saved.
+      base::TimeDelta lead_time;
+    };
+
+    PreconnectFeedback();
+    ~PreconnectFeedback();
+
+    // Records a preconnection to |url|, made because |referrer| listed
+    // |subresource|.  |url| differs from |subresource| after an HSTS
+    // redirect.
+    void ObservePreconnect(const GURL& referrer,
+                           const GURL& subresource,
+                           const GURL& url,
+                           base::TimeTicks now);
+
+    // Records a request to |url|.  Appends the outcome for any preconnection
+    // it used, and for any which expired unused, to |outcomes|.
+    void ObserveRequest(const GURL& url,
+                        base::TimeTicks now,
+                        std::vector<Outcome>* outcomes);
+
+    // Appends the outcomes for any preconnections which expired unused to
+    // |outcomes|.
+    void ExpireUnused(base::TimeTicks now, std::vector<Outcome>* outcomes);
+
+    // The number of preconnections which are neither used nor expired.
+    size_t unused_count() const { return unused_.size(); }
+
+    // Forgets all preconnections, without recording outcomes for them.
+    void Clear();
+
+   private:
+    struct UnusedPreconnect {
+      GURL referrer;
+      GURL subresource;
+      base::TimeTicks time;
+    };
+    // Keyed by the preconnected URL.
+    typedef std::map<GURL, UnusedPreconnect> UnusedPreconnects;
+
+    UnusedPreconnects unused_;
+
+    // The preconnected URLs in |unused_|, in the order they were made.  URLs
+    // which have since been used are skipped when they reach the front.
+    std::queue<std::pair<base::TimeTicks, GURL> > expiry_queue_;
+
+    const base::TimeDelta max_unused_lifetime_;
+
+    DISALLOW_COPY_AND_ASSIGN(PreconnectFeedback);
+  };
+
   // A map that is keyed with the host/port that we've learned were the cause
   // of loading additional URLs.  The list of additional targets is held
   // in a Referrer instance, which is a value in this map.
@@ -478,6 +577,14 @@ class Predictor {
   // helpful manner.
   bool CongestionControlPerformed(UrlInfo* info);
 
+  // Returns true if a speculative preconnection to a learned subresource may
+  // be made now, given how many earlier ones are still unused.
+  bool AdmitSpeculativePreconnect();
+
+  // Adjusts the referrers named in |outcomes|, and records their stats.
+  void ApplyPreconnectOutcomes(
+      const std::vector<PreconnectFeedback::Outcome>& outcomes);
+
   // Take lookup requests from work_queue_ and tell HostResolver to look them up
   // asynchronously, provided we don't exceed concurrent resolution limit.
   void StartSomeQueuedResolutions();
@@ -486,6 +593,16 @@ class Predictor {
   // series of short tasks by posting continuations again an again until done.
   void TrimReferrers();
 
+  // Copies the referrer for |url| out of referrer_graph_ into referrers_, if
+  // referrers_ has none yet.
+  void ImportReferrerFromGraph(const GURL& url);
+
+  // Writes |referrers| to the referrer graph in |path|, together with the
+  // referrers in the file which were not copied out of it this session.
+  static void WriteReferrerGraphOnFileThread(
+      const base::FilePath& path,
+      scoped_ptr<Referrers> referrers);
+
   // Loads urls_being_trimmed_ from keys of current referrers_.
   void LoadUrlsForTrimming();
 
@@ -572,12 +689,24 @@ class Predictor {
   class PreconnectUsage;
   scoped_ptr<PreconnectUsage> preconnect_usage_;
 
+  PreconnectFeedback preconnect_feedback_;
+
   // For each URL that we might navigate to (that we've "learned about")
   // we have a Referrer list. Each Referrer list has all hostnames we might
   // need to pre-resolve or pre-connect to when there is a navigation to the
   // orginial hostname.
   Referrers referrers_;
 
+  // The file holding this principal's referrer graph, and the mapping of it
+  // which was loaded at startup.  Referrers are copied out of the mapping into
+  // referrers_ as they are needed.
+  base::FilePath referrer_graph_path_;
+  scoped_refptr<ReferrerGraph> referrer_graph_;
+
+  // Set once referrer_graph_ has been dropped for good, because the graph was
+  // discarded or is being written out.
+  bool referrer_graph_discarded_;
+
   // List of URLs in referrers_ currently being trimmed (scaled down to
   // eventually be aged out of use).
   std::vector<GURL> urls_being_trimmed_;
@@ -0,0 +1,85 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "chrome/browser/net/predictor.h"
+#include "chrome/browser/net/referrer_graph.h"
+#include "content/public/test/test_browser_thread_bundle.h"
+#include "net/dns/mock_host_resolver.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace chrome_browser_net {
+
+namespace {
+
+const int kReferrerCount = 5000;
+const int kSubresourcesPerReferrer = 8;
+
+// Builds the referrer list of a well-used profile, in the format the prefs
+// keep it in.
+base::ListValue* NewLargeSerializationList() {
+  base::ListValue* referral_list = new base::ListValue;
+  referral_list->Append(
+      new base::FundamentalValue(Predictor::kPredictorReferrerVersion));
+  for (int i = 0; i < kReferrerCount; ++i) {
+    base::ListValue* motivation_list = new base::ListValue;
+    motivation_list->Append(new base::StringValue(
+        base::StringPrintf("http://www.site%d.com:80/", i)));
+    base::ListValue* subresource_list = new base::ListValue;
+    for (int j = 0; j < kSubresourcesPerReferrer; ++j) {
+      subresource_list->Append(new base::StringValue(
+          base::StringPrintf("http://cdn%d.site%d.com:80/", j, i)));
+      subresource_list->Append(new base::FundamentalValue(1.0 + j));
+    }
+    motivation_list->Append(subresource_list);
+    referral_list->Append(motivation_list);
+  }
+  return referral_list;
+}
+
+}  // namespace
+
+// Compares loading a large referrer list from prefs with mapping the graph.
+TEST(PredictorPerfTest, ReferrerGraphStartup) {
+  content::TestBrowserThreadBundle thread_bundle;
+  net::MockCachingHostResolver host_resolver;
+  scoped_ptr<base::ListValue> referral_list(NewLargeSerializationList());
+  std::string json;
+  base::JSONWriter::Write(referral_list.get(), &json);
+
+  Predictor predictor(true);
+  predictor.SetHostResolver(&host_resolver);
+  base::TimeTicks start = base::TimeTicks::Now();
+  predictor.DeserializeReferrers(*referral_list);
+  const base::TimeDelta deserialize_time = base::TimeTicks::Now() - start;
+
+  std::string image;
+  ReferrerGraph::Build(predictor.referrers_, &image);
+  start = base::TimeTicks::Now();
+  scoped_refptr<ReferrerGraph> graph(ReferrerGraph::CreateFromImage(image));
+  const base::TimeDelta load_time = base::TimeTicks::Now() - start;
+  ASSERT_TRUE(graph.get());
+  EXPECT_EQ(static_cast<size_t>(kReferrerCount * kSubresourcesPerReferrer),
+            graph->edge_count());
+
+  perf_test::PrintResult("referrer_startup", "", "prefs_deserialize",
+                         deserialize_time.InMillisecondsF(), "ms", true);
+  perf_test::PrintResult("referrer_startup", "", "graph_load",
+                         load_time.InMillisecondsF(), "ms", true);
+  perf_test::PrintResult("referrer_size", "", "prefs_json", json.size(),
+                         "bytes", true);
+  perf_test::PrintResult("referrer_size", "", "graph_image", image.size(),
+                         "bytes", true);
+
+  predictor.Shutdown();
+}
+
+}  // namespace chrome_browser_net
@@ -8,12 +8,16 @@
 #include <sstream>
 #include <string>
 
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/message_loop/message_loop.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
 #include "base/timer/timer.h"
 #include "base/values.h"
 #include "chrome/browser/net/predictor.h"
+#include "chrome/browser/net/referrer_graph.h"
 #include "chrome/browser/net/spdyproxy/proxy_advisor.h"
 #include "chrome/browser/net/url_info.h"
 #include "chrome/common/net/predictor_common.h"
@@ -73,6 +77,7 @@ class PredictorTest : public testing::Test {
   PredictorTest()
       : ui_thread_(BrowserThread::UI, &loop_),
         io_thread_(BrowserThread::IO, &loop_),
+        file_thread_(BrowserThread::FILE, &loop_),
         host_resolver_(new net::MockCachingHostResolver()) {
   }
 
@@ -120,6 +125,7 @@ class PredictorTest : public testing::Test {
   base::MessageLoopForUI loop_;
   content::TestBrowserThread ui_thread_;
   content::TestBrowserThread io_thread_;
+  content::TestBrowserThread file_thread_;
 
  protected:
   scoped_ptr<net::MockCachingHostResolver> host_resolver_;
@@ -569,6 +575,133 @@ TEST_F(PredictorTest, ReferrerSerializationTrimTest) {
   predictor.Shutdown();
 }
 
+// Make sure that referrers survive a round trip through the compact graph,
+// with their use rates kept to the precision of its fixed-point format.
+TEST_F(PredictorTest, ReferrerGraphTest) {
+  const GURL motivation_url("http://www.google.com:91");
+  const GURL icon_url("http://icons.google.com:90");
+  const GURL img_url("http://img.google.com:92");
+  const GURL unknown_url("http://unknown.google.com:93");
+  const double kRateIcon = 23.4;
+  const double kRateImg = 0.1;
+  const double kPrecision = 1 / ReferrerGraph::kRateScale;
+
+  ReferrerGraph::ReferrerMap referrers;
+  referrers[motivation_url].SuggestHost(icon_url);
+  referrers[motivation_url][icon_url].SetSubresourceUseRate(kRateIcon);
+  referrers[motivation_url].SuggestHost(img_url);
+  referrers[motivation_url][img_url].SetSubresourceUseRate(kRateImg);
+  referrers[icon_url].SuggestHost(img_url);
+
+  std::string image;
+  ReferrerGraph::Build(referrers, &image);
+  scoped_refptr<ReferrerGraph> graph(ReferrerGraph::CreateFromImage(image));
+  ASSERT_TRUE(graph.get());
+  EXPECT_EQ(3U, graph->url_count());
+  EXPECT_EQ(3U, graph->edge_count());
+
+  Referrer referrer;
+  ASSERT_TRUE(graph->GetReferrer(motivation_url, &referrer));
+  EXPECT_EQ(2U, referrer.size());
+  EXPECT_NEAR(kRateIcon, referrer[icon_url].subresource_use_rate(),
+              kPrecision);
+  EXPECT_NEAR(kRateImg, referrer[img_url].subresource_use_rate(), kPrecision);
+
+  // |img_url| is only a subresource, and |unknown_url| is not in the graph.
+  Referrer other;
+  EXPECT_FALSE(graph->GetReferrer(img_url, &other));
+  EXPECT_FALSE(graph->GetReferrer(unknown_url, &other));
+  EXPECT_TRUE(other.empty());
+
+  std::vector<GURL> urls;
+  graph->GetReferrerUrls(&urls);
+  ASSERT_EQ(2U, urls.size());
+  EXPECT_EQ(icon_url, urls[0]);
+  EXPECT_EQ(motivation_url, urls[1]);
+
+  // Truncated or corrupted images are rejected.
+  EXPECT_FALSE(ReferrerGraph::CreateFromImage(
+      image.substr(0, image.size() - 1)).get());
+  std::string corrupt(image);
+  corrupt[0] ^= 1;
+  EXPECT_FALSE(ReferrerGraph::CreateFromImage(corrupt).get());
+  EXPECT_FALSE(ReferrerGraph::CreateFromImage(std::string()).get());
+}
+
+// Make sure that writing the graph keeps the referrers of the file which were
+// not used, trimmed once.
+TEST_F(PredictorTest, ReferrerGraphWriteMergesTest) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const base::FilePath path = temp_dir.path().AppendASCII("graph");
+
+  const GURL first_url("http://www.google.com:91");
+  const GURL second_url("http://mail.google.com:92");
+  const GURL stale_url("http://old.google.com:93");
+  const GURL subresource_url("http://icons.google.com:90");
+  const double kRate = 3.5;
+  const double kStaleRate = Predictor::kDiscardableExpectedValue;
+
+  scoped_ptr<Predictor::Referrers> referrers(new Predictor::Referrers);
+  (*referrers)[first_url].SuggestHost(subresource_url);
+  (*referrers)[first_url][subresource_url].SetSubresourceUseRate(kRate);
+  (*referrers)[stale_url].SuggestHost(subresource_url);
+  (*referrers)[stale_url][subresource_url].SetSubresourceUseRate(kStaleRate);
+  Predictor::WriteReferrerGraphOnFileThread(path, referrers.Pass());
+
+  referrers.reset(new Predictor::Referrers);
+  (*referrers)[second_url].SuggestHost(subresource_url);
+  Predictor::WriteReferrerGraphOnFileThread(path, referrers.Pass());
+
+  scoped_refptr<ReferrerGraph> graph(ReferrerGraph::CreateFromFile(path));
+  ASSERT_TRUE(graph.get());
+  Referrer referrer;
+  ASSERT_TRUE(graph->GetReferrer(first_url, &referrer));
+  EXPECT_NEAR(kRate * Predictor::kReferrerTrimRatio,
+              referrer[subresource_url].subresource_use_rate(),
+              1 / ReferrerGraph::kRateScale);
+  EXPECT_TRUE(graph->GetReferrer(second_url, &referrer));
+  // The stale referrer was trimmed below the threshold and discarded.
+  EXPECT_FALSE(graph->GetReferrer(stale_url, &referrer));
+}
+
+// Make sure that discarding the results deletes the graph file, that a graph
+// which finishes loading afterwards is ignored, and that the next write does
+// not bring the discarded referrers back.
+TEST_F(PredictorTest, ReferrerGraphDiscardTest) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const base::FilePath path = temp_dir.path().AppendASCII("graph");
+
+  const GURL motivation_url("http://www.google.com:91");
+  const GURL subresource_url("http://icons.google.com:90");
+  scoped_ptr<Predictor::Referrers> referrers(new Predictor::Referrers);
+  (*referrers)[motivation_url].SuggestHost(subresource_url);
+  Predictor::WriteReferrerGraphOnFileThread(path, referrers.Pass());
+  scoped_refptr<ReferrerGraph> graph(ReferrerGraph::CreateFromFile(path));
+  ASSERT_TRUE(graph.get());
+
+  Predictor predictor(true);
+  predictor.SetHostResolver(host_resolver_.get());
+  predictor.set_referrer_graph_path(path);
+  predictor.DiscardAllResults();
+  predictor.SetReferrerGraph(graph);
+  graph = NULL;
+  loop_.RunUntilIdle();
+  EXPECT_FALSE(base::PathExists(path));
+
+  predictor.ImportReferrerFromGraph(motivation_url);
+  EXPECT_TRUE(predictor.referrers_.empty());
+
+  Predictor::WriteReferrerGraphOnFileThread(
+      path, make_scoped_ptr(new Predictor::Referrers(predictor.referrers_)));
+  graph = ReferrerGraph::CreateFromFile(path);
+  Referrer referrer;
+  EXPECT_FALSE(graph.get() && graph->GetReferrer(motivation_url, &referrer));
+  graph = NULL;
+
+  predictor.Shutdown();
+}
 
 TEST_F(PredictorTest, PriorityQueuePushPopTest) {
   Predictor::HostNameQueue queue;
@@ -764,6 +897,117 @@ TEST_F(PredictorTest, HSTSRedirectSubresources) {
   predictor.Shutdown();
 }
 
+TEST_F(PredictorTest, PreconnectFeedbackTest) {
+  const GURL kReferrerUrl("http://example.com");
+  const GURL kUsedUrl("http://images.example.com");
+  const GURL kUnusedUrl("http://ads.example.com");
+  const base::TimeDelta kLifetime = base::TimeDelta::FromSeconds(
+      Predictor::kMaxUnusedSocketLifetimeSecondsWithoutAGet);
+
+  Predictor::PreconnectFeedback feedback;
+  std::vector<Predictor::PreconnectFeedback::Outcome> outcomes;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  feedback.ObservePreconnect(kReferrerUrl, kUsedUrl, kUsedUrl, start);
+  feedback.ObservePreconnect(kReferrerUrl, kUnusedUrl, kUnusedUrl, start);
+  // A repeated preconnection is credited to the first one.
+  feedback.ObservePreconnect(kReferrerUrl, kUsedUrl, kUsedUrl,
+                             start + base::TimeDelta::FromSeconds(1));
+  EXPECT_EQ(2u, feedback.unused_count());
+
+  const base::TimeDelta kLeadTime = base::TimeDelta::FromMilliseconds(300);
+  feedback.ObserveRequest(kUsedUrl, start + kLeadTime, &outcomes);
+  ASSERT_EQ(1u, outcomes.size());
+  EXPECT_EQ(kReferrerUrl, outcomes[0].referrer);
+  EXPECT_EQ(kUsedUrl, outcomes[0].subresource);
+  EXPECT_TRUE(outcomes[0].was_used);
+  EXPECT_EQ(kLeadTime, outcomes[0].lead_time);
+  EXPECT_EQ(1u, feedback.unused_count());
+
+  // A request to a URL which was not preconnected has no outcome.
+  outcomes.clear();
+  feedback.ObserveRequest(kReferrerUrl, start + kLeadTime, &outcomes);
+  EXPECT_TRUE(outcomes.empty());
+
+  // The other preconnection is wasted once its sockets would be dropped.
+  feedback.ExpireUnused(start + kLifetime, &outcomes);
+  ASSERT_EQ(1u, outcomes.size());
+  EXPECT_EQ(kUnusedUrl, outcomes[0].subresource);
+  EXPECT_FALSE(outcomes[0].was_used);
+  EXPECT_EQ(0u, feedback.unused_count());
+
+  // A request after expiry is too late to use it.
+  outcomes.clear();
+  feedback.ObserveRequest(kUnusedUrl, start + kLifetime, &outcomes);
+  EXPECT_TRUE(outcomes.empty());
+}
+
+// Tests that speculative preconnections are dropped while too many earlier
+// ones are still unused, but the navigation itself is always preconnected.
+TEST_F(PredictorTest, PreconnectAdmissionTest) {
+  const GURL kUrl("http://example.com");
+  const GURL kSubresourceUrl("http://images.example.com");
+  const double kUseRate = 23.4;
+
+  Predictor predictor(true);
+  TestPredictorObserver observer;
+  predictor.SetObserver(&observer);
+
+  scoped_ptr<base::ListValue> referral_list(NewEmptySerializationList());
+  AddToSerializedList(kUrl, kSubresourceUrl, kUseRate, referral_list.get());
+  predictor.DeserializeReferrers(*referral_list.get());
+
+  const base::TimeTicks now = base::TimeTicks::Now();
+  for (size_t i = 0; i < Predictor::kMaxUnusedSpeculativePreconnects; ++i) {
+    const GURL unused_url(
+        base::StringPrintf("http://unused%d.example.com", static_cast<int>(i)));
+    predictor.preconnect_feedback_.ObservePreconnect(
+        kUrl, unused_url, unused_url, now);
+  }
+
+  predictor.PreconnectUrlAndSubresources(kUrl, GURL());
+  ASSERT_EQ(1u, observer.preconnected_urls_.size());
+  EXPECT_EQ(kUrl, observer.preconnected_urls_[0]);
+
+  // Using one of the earlier preconnections makes room for another.
+  predictor.ObserveRequestForPreconnectFeedback(
+      GURL("http://unused0.example.com"));
+  observer.preconnected_urls_.clear();
+  predictor.PreconnectUrlAndSubresources(kUrl, GURL());
+  ASSERT_EQ(2u, observer.preconnected_urls_.size());
+  EXPECT_EQ(kSubresourceUrl, observer.preconnected_urls_[1]);
+
+  predictor.Shutdown();
+}
+
+// Tests that a subresource whose preconnections keep going unused is only
+// preresolved.
+TEST_F(PredictorTest, PreconnectUtilizationTest) {
+  const GURL kUrl("http://example.com");
+  const GURL kSubresourceUrl("http://images.example.com");
+  const double kUseRate = 23.4;
+
+  Predictor predictor(true);
+  TestPredictorObserver observer;
+  predictor.SetObserver(&observer);
+
+  scoped_ptr<base::ListValue> referral_list(NewEmptySerializationList());
+  AddToSerializedList(kUrl, kSubresourceUrl, kUseRate, referral_list.get());
+  predictor.DeserializeReferrers(*referral_list.get());
+
+  Predictor::PreconnectFeedback::Outcome wasted;
+  wasted.referrer = kUrl;
+  wasted.subresource = kSubresourceUrl;
+  wasted.was_used = false;
+  predictor.ApplyPreconnectOutcomes(
+      std::vector<Predictor::PreconnectFeedback::Outcome>(10, wasted));
+
+  predictor.PreconnectUrlAndSubresources(kUrl, GURL());
+  ASSERT_EQ(1u, observer.preconnected_urls_.size());
+  EXPECT_EQ(kUrl, observer.preconnected_urls_[0]);
+
+  predictor.Shutdown();
+}
+
 #if defined(OS_ANDROID) || defined(OS_IOS)
 // Tests for the predictor with a proxy advisor
 
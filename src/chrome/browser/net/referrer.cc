@@ -50,6 +50,12 @@ static const double kWeightingForOldConnectsExpectedValue = 0.66;
 // a starting point.
 static const double kInitialConnectsExpectedValue = 2.0;
 
+// The preconnect utilization is smoothed in the same way as the expected
+// connections: each outcome is weighted against the previous estimate.  Until
+// we have seen any outcome, we assume that preconnections are used.
+static const double kWeightingForOldPreconnectUtilization = 0.66;
+static const double kInitialPreconnectUtilization = 1.0;
+
 Referrer::Referrer() : use_count_(1) {}
 
 void Referrer::SuggestHost(const GURL& url) {
@@ -116,6 +122,7 @@ bool Referrer::Trim(double reduce_rate, double threshold) {
 
 bool ReferrerValue::Trim(double reduce_rate, double threshold) {
   subresource_use_rate_ *= reduce_rate;
+  preconnect_utilization_ = 1.0 - (1.0 - preconnect_utilization_) * reduce_rate;
   return subresource_use_rate_ > threshold;
 }
 
@@ -165,7 +172,8 @@ ReferrerValue::ReferrerValue()
       navigation_count_(0),
       preconnection_count_(0),
       preresolution_count_(0),
-      subresource_use_rate_(kInitialConnectsExpectedValue) {
+      subresource_use_rate_(kInitialConnectsExpectedValue),
+      preconnect_utilization_(kInitialPreconnectUtilization) {
 }
 
 void ReferrerValue::SubresourceIsNeeded() {
@@ -175,6 +183,12 @@ void ReferrerValue::SubresourceIsNeeded() {
   subresource_use_rate_ += 1 - kWeightingForOldConnectsExpectedValue;
 }
 
+void ReferrerValue::RecordPreconnectOutcome(bool was_used) {
+  preconnect_utilization_ =
+      preconnect_utilization_ * kWeightingForOldPreconnectUtilization +
+      (was_used ? 1 - kWeightingForOldPreconnectUtilization : 0);
+}
+
 void ReferrerValue::ReferrerWasObserved() {
   subresource_use_rate_ *= kWeightingForOldConnectsExpectedValue;
   // Note: the use rate is temporarilly possibly incorect, as we need to find
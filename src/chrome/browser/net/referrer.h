@@ -60,8 +60,17 @@ class ReferrerValue {
   int64 preresolution_count() const { return preresolution_count_; }
   void preresolution_increment() { ++preresolution_count_; }
 
+  double preconnect_utilization() const { return preconnect_utilization_; }
+
+  // Record whether a preconnection to this subresource, made as a consequence
+  // of its referrer, was used before the socket would have been dropped.
+  // Wasted preconnections diminish the preconnect_utilization_.
+  void RecordPreconnectOutcome(bool was_used);
+
   // Reduce the subresource_use_rate_ by the supplied factor, and return true
-  // if the result is still greater than the given threshold.
+  // if the result is still greater than the given threshold.  The
+  // preconnect_utilization_ recovers by the same factor, so that old evidence
+  // of wasted preconnections is eventually forgotten.
   bool Trim(double reduce_rate, double threshold);
 
  private:
@@ -81,6 +90,11 @@ class ReferrerValue {
   // A smoothed estimate of the expected number of connections that will be made
   // to this subresource.
   double subresource_use_rate_;
+
+  // A smoothed estimate of the fraction of preconnections to this subresource
+  // which were used.  This discounts subresource_use_rate_ when deciding
+  // whether to preconnect.
+  double preconnect_utilization_;
 };
 
 //------------------------------------------------------------------------------
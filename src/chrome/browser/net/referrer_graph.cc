@@ -0,0 +1,269 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/referrer_graph.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/file_util.h"
+#include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/logging.h"
+
+namespace chrome_browser_net {
+
+namespace {
+
+// Identifies the image format.  Bump |kFormatVersion| when the layout
+// changes; older images are then discarded and learned again.
+const uint32 kMagic = 0x48505247;  // "GRPH"
+const uint32 kFormatVersion = 1;
+
+const uint16 kMaxFixedRate = 0xFFFF;
+
+size_t PaddedRatesSize(size_t edge_count) {
+  return (edge_count * sizeof(uint16) + 3) & ~static_cast<size_t>(3);
+}
+
+}  // namespace
+
+struct ReferrerGraph::Header {
+  uint32 magic;
+  uint32 format_version;
+  uint32 url_count;
+  uint32 edge_count;
+  uint32 string_bytes;
+};
+
+struct ReferrerGraph::UrlEntry {
+  uint32 offset;
+  uint32 length;
+  uint32 first_edge;
+  uint32 edge_count;
+};
+
+const double ReferrerGraph::kRateScale = 1024.0;
+
+ReferrerGraph::ReferrerGraph()
+    : size_(0),
+      header_(NULL),
+      urls_(NULL),
+      edge_urls_(NULL),
+      edge_rates_(NULL),
+      strings_(NULL) {}
+
+ReferrerGraph::~ReferrerGraph() {}
+
+// static
+void ReferrerGraph::Build(const ReferrerMap& referrers, std::string* image) {
+  // Give every referrer and subresource a dense id, in spec order.
+  std::map<std::string, uint32> ids;
+  std::map<std::string, const Referrer*> referrers_by_spec;
+  for (ReferrerMap::const_iterator it = referrers.begin();
+       it != referrers.end(); ++it) {
+    ids[it->first.spec()] = 0;
+    referrers_by_spec[it->first.spec()] = &it->second;
+    for (Referrer::const_iterator sub = it->second.begin();
+         sub != it->second.end(); ++sub) {
+      ids[sub->first.spec()] = 0;
+    }
+  }
+  uint32 next_id = 0;
+  for (std::map<std::string, uint32>::iterator it = ids.begin();
+       it != ids.end(); ++it) {
+    it->second = next_id++;
+  }
+
+  std::vector<UrlEntry> urls;
+  std::vector<uint32> edge_urls;
+  std::vector<uint16> edge_rates;
+  std::string strings;
+  for (std::map<std::string, uint32>::const_iterator it = ids.begin();
+       it != ids.end(); ++it) {
+    UrlEntry entry;
+    entry.offset = strings.size();
+    entry.length = it->first.size();
+    entry.first_edge = edge_urls.size();
+    strings.append(it->first);
+
+    std::map<std::string, const Referrer*>::const_iterator referrer =
+        referrers_by_spec.find(it->first);
+    if (referrer != referrers_by_spec.end()) {
+      for (Referrer::const_iterator sub = referrer->second->begin();
+           sub != referrer->second->end(); ++sub) {
+        const double fixed_rate = std::floor(
+            sub->second.subresource_use_rate() * kRateScale + 0.5);
+        edge_urls.push_back(ids[sub->first.spec()]);
+        edge_rates.push_back(static_cast<uint16>(
+            std::max(0.0, std::min<double>(kMaxFixedRate, fixed_rate))));
+      }
+    }
+    entry.edge_count = edge_urls.size() - entry.first_edge;
+    urls.push_back(entry);
+  }
+
+  Header header;
+  header.magic = kMagic;
+  header.format_version = kFormatVersion;
+  header.url_count = urls.size();
+  header.edge_count = edge_urls.size();
+  header.string_bytes = strings.size();
+
+  image->assign(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (!urls.empty()) {
+    image->append(reinterpret_cast<const char*>(&urls[0]),
+                  urls.size() * sizeof(UrlEntry));
+  }
+  if (!edge_urls.empty()) {
+    image->append(reinterpret_cast<const char*>(&edge_urls[0]),
+                  edge_urls.size() * sizeof(uint32));
+    image->append(reinterpret_cast<const char*>(&edge_rates[0]),
+                  edge_rates.size() * sizeof(uint16));
+    image->append(PaddedRatesSize(edge_rates.size()) -
+                  edge_rates.size() * sizeof(uint16), '\0');
+  }
+  image->append(strings);
+}
+
+// static
+scoped_refptr<ReferrerGraph> ReferrerGraph::CreateFromFile(
+    const base::FilePath& path) {
+  if (!base::PathExists(path))
+    return NULL;
+  scoped_refptr<ReferrerGraph> graph(new ReferrerGraph());
+  graph->file_.reset(new base::MemoryMappedFile());
+  if (!graph->file_->Initialize(path) ||
+      !graph->Init(reinterpret_cast<const char*>(graph->file_->data()),
+                   graph->file_->length())) {
+    return NULL;
+  }
+  return graph;
+}
+
+// static
+scoped_refptr<ReferrerGraph> ReferrerGraph::CreateFromImage(
+    const std::string& image) {
+  scoped_refptr<ReferrerGraph> graph(new ReferrerGraph());
+  graph->image_ = image;
+  if (!graph->Init(graph->image_.data(), graph->image_.size()))
+    return NULL;
+  return graph;
+}
+
+size_t ReferrerGraph::url_count() const {
+  return header_->url_count;
+}
+
+size_t ReferrerGraph::edge_count() const {
+  return header_->edge_count;
+}
+
+bool ReferrerGraph::GetReferrer(const GURL& url, Referrer* referrer) const {
+  uint32 index;
+  if (!FindUrl(url.spec(), &index) || urls_[index].edge_count == 0)
+    return false;
+
+  const UrlEntry& entry = urls_[index];
+  for (uint32 i = entry.first_edge; i < entry.first_edge + entry.edge_count;
+       ++i) {
+    GURL subresource(SpecAt(edge_urls_[i]).as_string());
+    referrer->SuggestHost(subresource);
+    (*referrer)[subresource].SetSubresourceUseRate(
+        edge_rates_[i] / kRateScale);
+  }
+  return true;
+}
+
+void ReferrerGraph::GetReferrerUrls(std::vector<GURL>* urls) const {
+  for (uint32 i = 0; i < header_->url_count; ++i) {
+    if (urls_[i].edge_count > 0)
+      urls->push_back(GURL(SpecAt(i).as_string()));
+  }
+}
+
+bool ReferrerGraph::Init(const char* data, size_t size) {
+  if (size < sizeof(Header) ||
+      reinterpret_cast<uintptr_t>(data) % sizeof(uint32) != 0) {
+    return false;
+  }
+  const Header* header = reinterpret_cast<const Header*>(data);
+  if (header->magic != kMagic || header->format_version != kFormatVersion)
+    return false;
+
+  // 64-bit arithmetic cannot overflow on 32-bit counts.
+  const uint64 expected_size = sizeof(Header) +
+      static_cast<uint64>(header->url_count) * sizeof(UrlEntry) +
+      static_cast<uint64>(header->edge_count) * sizeof(uint32) +
+      PaddedRatesSize(header->edge_count) +
+      header->string_bytes;
+  if (expected_size != size)
+    return false;
+
+  const char* pos = data + sizeof(Header);
+  const UrlEntry* urls = reinterpret_cast<const UrlEntry*>(pos);
+  pos += header->url_count * sizeof(UrlEntry);
+  const uint32* edge_urls = reinterpret_cast<const uint32*>(pos);
+  pos += header->edge_count * sizeof(uint32);
+  const uint16* edge_rates = reinterpret_cast<const uint16*>(pos);
+  pos += PaddedRatesSize(header->edge_count);
+  const char* strings = pos;
+
+  for (uint32 i = 0; i < header->url_count; ++i) {
+    const UrlEntry& entry = urls[i];
+    if (static_cast<uint64>(entry.offset) + entry.length >
+            header->string_bytes ||
+        static_cast<uint64>(entry.first_edge) + entry.edge_count >
+            header->edge_count) {
+      return false;
+    }
+    // Lookups binary search the specs, so they must be strictly ascending.
+    if (i > 0) {
+      const UrlEntry& previous = urls[i - 1];
+      if (base::StringPiece(strings + previous.offset, previous.length) >=
+          base::StringPiece(strings + entry.offset, entry.length)) {
+        return false;
+      }
+    }
+  }
+  for (uint32 i = 0; i < header->edge_count; ++i) {
+    if (edge_urls[i] >= header->url_count)
+      return false;
+  }
+
+  size_ = size;
+  header_ = header;
+  urls_ = urls;
+  edge_urls_ = edge_urls;
+  edge_rates_ = edge_rates;
+  strings_ = strings;
+  return true;
+}
+
+base::StringPiece ReferrerGraph::SpecAt(uint32 index) const {
+  const UrlEntry& entry = urls_[index];
+  return base::StringPiece(strings_ + entry.offset, entry.length);
+}
+
+bool ReferrerGraph::FindUrl(const base::StringPiece& spec,
+                            uint32* index) const {
+  uint32 begin = 0;
+  uint32 end = header_->url_count;
+  while (begin < end) {
+    const uint32 mid = begin + (end - begin) / 2;
+    const int cmp = SpecAt(mid).compare(spec);
+    if (cmp == 0) {
+      *index = mid;
+      return true;
+    }
+    if (cmp < 0) {
+      begin = mid + 1;
+    } else {
+      end = mid;
+    }
+  }
+  return false;
+}
+
+}  // namespace chrome_browser_net
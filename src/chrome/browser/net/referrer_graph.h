@@ -0,0 +1,106 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// A compact, read-only snapshot of the referrer graph learned by a Predictor.
+// Every URL in the graph gets a dense id, and the subresources of each
+// referrer are stored as (id, fixed-point use rate) pairs.  The snapshot is
+// persisted as a single file which is memory-mapped when loaded.  Lookups read
+// the mapping in place, with no parsing step, and referrers are only copied
+// out of it as they are used.
+//
+// Image layout, all fields in host byte order and 4-byte aligned:
+//
+// Header header;
+// UrlEntry urls[header.url_count];       // Sorted by spec.
+// uint32 edge_urls[header.edge_count];   // Indices into |urls|.
+// uint16 edge_rates[header.edge_count];  // Padded to a multiple of 4 bytes.
+// char strings[header.string_bytes];
+
+#ifndef CHROME_BROWSER_NET_REFERRER_GRAPH_H_
+#define CHROME_BROWSER_NET_REFERRER_GRAPH_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/string_piece.h"
+#include "chrome/browser/net/referrer.h"
+#include "url/gurl.h"
+
+namespace base {
+class FilePath;
+class MemoryMappedFile;
+}
+
+namespace chrome_browser_net {
+
+class ReferrerGraph : public base::RefCountedThreadSafe<ReferrerGraph> {
+ public:
+  typedef std::map<GURL, Referrer> ReferrerMap;
+
+  // Use rates are stored in 1/kRateScale units, and clamped to what fits in
+  // 16 bits.
+  static const double kRateScale;
+
+  // Serializes |referrers| into |image|.
+  static void Build(const ReferrerMap& referrers, std::string* image);
+
+  // Maps the image in |path|.  Returns NULL if the file does not exist or is
+  // not a valid image.  This does blocking IO.
+  static scoped_refptr<ReferrerGraph> CreateFromFile(
+      const base::FilePath& path);
+
+  // Returns a graph which reads a copy of |image|, or NULL if it is invalid.
+  static scoped_refptr<ReferrerGraph> CreateFromImage(
+      const std::string& image);
+
+  size_t url_count() const;
+  size_t edge_count() const;
+  size_t image_size() const { return size_; }
+
+  // If |url| has learned subresources, adds them with their use rates to
+  // |referrer| and returns true.
+  bool GetReferrer(const GURL& url, Referrer* referrer) const;
+
+  // Appends every URL which has learned subresources to |urls|.
+  void GetReferrerUrls(std::vector<GURL>* urls) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<ReferrerGraph>;
+
+  struct Header;
+  struct UrlEntry;
+
+  ReferrerGraph();
+  ~ReferrerGraph();
+
+  // Points the tables at |data| once it is validated.  Every index is checked
+  // here, so that lookups need no bounds checks.
+  bool Init(const char* data, size_t size);
+
+  base::StringPiece SpecAt(uint32 index) const;
+
+  // Returns true and sets |index| if |spec| is in the graph.
+  bool FindUrl(const base::StringPiece& spec, uint32* index) const;
+
+  // Backs the image for graphs loaded from a file, or from memory.
+  scoped_ptr<base::MemoryMappedFile> file_;
+  std::string image_;
+  size_t size_;
+
+  const Header* header_;
+  const UrlEntry* urls_;
+  const uint32* edge_urls_;
+  const uint16* edge_rates_;
+  const char* strings_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReferrerGraph);
+};
+
+}  // namespace chrome_browser_net
+
+#endif  // CHROME_BROWSER_NET_REFERRER_GRAPH_H_
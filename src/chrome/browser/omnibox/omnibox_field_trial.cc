@@ -419,6 +419,17 @@ bool OmniboxFieldTrial::HQPAllowMatchInSchemeValue() {
       kHQPAllowMatchInSchemeRule) == "true";
 }
 
+base::TimeDelta OmniboxFieldTrial::HQPWorkerDeadline() {
+  int deadline_ms;
+  if (!base::StringToInt(
+          chrome_variations::GetVariationParamValue(
+              kBundledExperimentFieldTrialName, kHQPWorkerDeadlineRule),
+          &deadline_ms) ||
+      (deadline_ms < 0))
+    return base::TimeDelta();
+  return base::TimeDelta::FromMilliseconds(deadline_ms);
+}
+
 bool OmniboxFieldTrial::BookmarksIndexURLsValue() {
   return chrome_variations::GetVariationParamValue(
       kBundledExperimentFieldTrialName,
@@ -436,6 +447,7 @@ const char OmniboxFieldTrial::kHQPBookmarkValueRule[] =
 const char OmniboxFieldTrial::kHQPAllowMatchInTLDRule[] = "HQPAllowMatchInTLD";
 const char OmniboxFieldTrial::kHQPAllowMatchInSchemeRule[] =
     "HQPAllowMatchInScheme";
+const char OmniboxFieldTrial::kHQPWorkerDeadlineRule[] = "HQPWorkerDeadline";
 const char OmniboxFieldTrial::kZeroSuggestRule[] = "ZeroSuggest";
 const char OmniboxFieldTrial::kZeroSuggestVariantRule[] = "ZeroSuggestVariant";
 const char OmniboxFieldTrial::kBookmarksIndexURLsRule[] = "BookmarksIndexURLs";
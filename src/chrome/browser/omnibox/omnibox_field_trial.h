@@ -258,6 +258,16 @@ class OmniboxFieldTrial {
   // match in scheme experiment isn't active.
   static bool HQPAllowMatchInSchemeValue();
 
+  // ---------------------------------------------------------
+  // For the HQPWorkerDeadline experiment that's part of the
+  // bundled omnibox field trial.
+
+  // Returns how long after a keystroke HQP matches scored on a worker
+  // thread may still become the default match.  Returns zero, meaning HQP
+  // scores on the UI thread, if the worker deadline experiment isn't active
+  // or if parsing the experiment-provided duration fails.
+  static base::TimeDelta HQPWorkerDeadline();
+
   // ---------------------------------------------------------
   // For the BookmarksIndexURLs experiment that's part of the
   // bundled omnibox field trial.
@@ -280,6 +290,7 @@ class OmniboxFieldTrial {
   static const char kHQPDiscountFrecencyWhenFewVisitsRule[];
   static const char kHQPAllowMatchInTLDRule[];
   static const char kHQPAllowMatchInSchemeRule[];
+  static const char kHQPWorkerDeadlineRule[];
   static const char kZeroSuggestRule[];
   static const char kZeroSuggestVariantRule[];
   static const char kBookmarksIndexURLsRule[];
@@ -18,7 +18,9 @@
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/test/test_timeouts.h"
+#include "base/threading/thread_restrictions.h"
 #include "base/values.h"
+#include "chrome/browser/browser_process.h"
 #include "chrome/browser/browsing_data/browsing_data_helper.h"
 #include "chrome/browser/browsing_data/browsing_data_remover.h"
 #include "chrome/browser/browsing_data/browsing_data_remover_test_util.h"
@@ -39,6 +41,7 @@
 #include "chrome/browser/prerender/prerender_manager_factory.h"
 #include "chrome/browser/profiles/profile.h"
 #include "chrome/browser/profiles/profile_io_data.h"
+#include "chrome/browser/profiles/profile_manager.h"
 #include "chrome/browser/renderer_host/chrome_resource_dispatcher_host_delegate.h"
 #include "chrome/browser/safe_browsing/database_manager.h"
 #include "chrome/browser/safe_browsing/safe_browsing_service.h"
@@ -673,6 +676,11 @@ class FakeSafeBrowsingDatabaseManager :  public SafeBrowsingDatabaseManager {
     return false;
   }
 
+  virtual bool CheckBrowseUrlInBatch(const GURL& gurl,
+                                     Client* client) OVERRIDE {
+    return CheckBrowseUrl(gurl, client);
+  }
+
   void SetThreatTypeForUrl(const GURL& url, SBThreatType threat_type) {
     url_ = url;
     threat_type_ = threat_type;
@@ -1007,6 +1015,26 @@ class NeverRunsExternalProtocolHandlerDelegate
   }
 };
 
+// Routes every navigation to |target|, for as long as it is alive.
+class TestPrincipalResolver : public PrerenderManager::PrincipalResolver {
+ public:
+  explicit TestPrincipalResolver(Profile* target) : target_(target) {
+    PrerenderManager::SetPrincipalResolver(this);
+  }
+
+  virtual ~TestPrincipalResolver() {
+    PrerenderManager::SetPrincipalResolver(NULL);
+  }
+
+  virtual Profile* GetTargetPrincipal(Profile* source,
+                                      const GURL& url) OVERRIDE {
+    return target_;
+  }
+
+ private:
+  Profile* target_;
+};
+
 base::FilePath GetTestPath(const std::string& file_name) {
   return ui_test_utils::GetTestFilePath(
       base::FilePath(FILE_PATH_LITERAL("prerender")),
@@ -4293,6 +4321,51 @@ IN_PROC_BROWSER_TEST_F(PrerenderBrowserTest, PrerenderWindowClose) {
                    FINAL_STATUS_CLOSED, 0);
 }
 
+// Checks that a prerender which is made in the principal the navigation to it
+// will be routed to is swapped in when that navigation lands there, even
+// though its session storage namespace is not an alias of the target tab's.
+IN_PROC_BROWSER_TEST_F(PrerenderBrowserTest, PrerenderCrossPrincipal) {
+  ProfileManager* profile_manager = g_browser_process->profile_manager();
+  Profile* principal = NULL;
+  {
+    base::ThreadRestrictions::ScopedAllowIO allow_io;
+    principal = Profile::CreateProfile(
+        profile_manager->GenerateNextProfileDirectoryPath(), NULL,
+        Profile::CREATE_MODE_SYNCHRONOUS);
+  }
+  ASSERT_TRUE(principal);
+  profile_manager->RegisterTestingProfile(principal, true, false);
+  Browser* principal_browser = CreateBrowser(principal);
+  PrerenderManager* principal_prerender_manager =
+      PrerenderManagerFactory::GetForProfile(principal);
+  ASSERT_TRUE(principal_prerender_manager);
+
+  const GURL url = test_server()->GetURL("files/prerender/prerender_page.html");
+  TestPrincipalResolver resolver(principal);
+  scoped_ptr<PrerenderHandle> handle(
+      GetPrerenderManager()->AddPrerenderFromOmnibox(
+          url, GetSessionStorageNamespace(), gfx::Size(640, 480)));
+  ASSERT_TRUE(handle.get());
+  ASSERT_TRUE(handle->contents());
+  EXPECT_TRUE(handle->contents()->is_cross_principal());
+  EXPECT_TRUE(handle->IsPrerendering());
+  EXPECT_FALSE(GetPrerenderManager()->HasPrerenderedUrl(
+      url, GetActiveWebContents()));
+
+  WebContents* prerender_web_contents =
+      handle->contents()->prerender_contents();
+  ASSERT_TRUE(prerender_web_contents);
+  content::WaitForLoadStop(prerender_web_contents);
+
+  // The navigation in the target principal goes through
+  // PrerenderManager::MaybeUsePrerenderedPage(), which must swap the
+  // prerender in rather than wait on a session storage merge.
+  ui_test_utils::NavigateToURL(principal_browser, url);
+  EXPECT_EQ(prerender_web_contents,
+            principal_browser->tab_strip_model()->GetActiveWebContents());
+  EXPECT_FALSE(handle->IsPrerendering());
+}
+
 class PrerenderIncognitoBrowserTest : public PrerenderBrowserTest {
  public:
   virtual void SetUpOnMainThread() OVERRIDE {
@@ -10,6 +10,7 @@
 
 #include "apps/ui/web_contents_sizer.h"
 #include "base/bind.h"
+#include "base/metrics/histogram.h"
 #include "base/strings/utf_string_conversions.h"
 #include "chrome/browser/chrome_notification_types.h"
 #include "chrome/browser/history/history_tab_helper.h"
@@ -231,6 +232,7 @@ PrerenderContents::PrerenderContents(
       page_id_(0),
       has_stopped_loading_(false),
       has_finished_loading_(false),
+      is_cross_principal_(false),
       final_status_(FINAL_STATUS_MAX),
       match_complete_status_(MATCH_COMPLETE_DEFAULT),
       prerendering_has_been_cancelled_(false),
@@ -251,6 +253,7 @@ PrerenderContents* PrerenderContents::CreateMatchCompleteReplacement() {
       prerender_url(), referrer(), origin(), experiment_id());
 
   new_contents->load_start_time_ = load_start_time_;
+  new_contents->is_cross_principal_ = is_cross_principal_;
   new_contents->session_storage_namespace_id_ = session_storage_namespace_id_;
   new_contents->set_match_complete_status(
       PrerenderContents::MATCH_COMPLETE_REPLACEMENT_PENDING);
@@ -434,6 +437,12 @@ PrerenderContents::~PrerenderContents() {
   }
   prerender_manager_->RecordFinalStatusWithMatchCompleteStatus(
       origin(), experiment_id(), match_complete_status(), final_status());
+  // The FINAL_STATUS_USED bucket gives the swap-in rate of prerenders which
+  // were placed in another principal than the one which predicted them.
+  if (is_cross_principal_) {
+    UMA_HISTOGRAM_ENUMERATION("Prerender.CrossPrincipalFinalStatus",
+                              final_status(), FINAL_STATUS_MAX);
+  }
 
   bool used = final_status() == FINAL_STATUS_USED ||
               final_status() == FINAL_STATUS_WOULD_HAVE_BEEN_USED;
@@ -175,6 +175,13 @@ class PrerenderContents : public content::NotificationObserver,
   bool has_stopped_loading() const { return has_stopped_loading_; }
   bool has_finished_loading() const { return has_finished_loading_; }
   bool prerendering_has_started() const { return prerendering_has_started_; }
+
+  // Whether the prerender was created in this principal on behalf of another
+  // one, because the navigation to it will be routed here.
+  bool is_cross_principal() const { return is_cross_principal_; }
+  void set_is_cross_principal(bool is_cross_principal) {
+    is_cross_principal_ = is_cross_principal;
+  }
   MatchCompleteStatus match_complete_status() const {
     return match_complete_status_;
   }
@@ -418,6 +425,8 @@ class PrerenderContents : public content::NotificationObserver,
   // True when the main frame has finished loading.
   bool has_finished_loading_;
 
+  bool is_cross_principal_;
+
   // This must be the same value as the PrerenderTracker has recorded for
   // |this|, when |this| has a RenderView.
   FinalStatus final_status_;
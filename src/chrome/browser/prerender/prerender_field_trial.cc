@@ -45,6 +45,7 @@ const char kLocalPredictorUnencryptedSyncOnlyKeyName[] =
 const char kSideEffectFreeWhitelistKeyName[] = "SideEffectFreeWhitelist";
 const char kPrerenderLaunchKeyName[] = "PrerenderLaunch";
 const char kPrerenderAlwaysControlKeyName[] = "PrerenderAlwaysControl";
+const char kPrincipalWarmUpKeyName[] = "PrincipalWarmUp";
 const char kPrerenderQueryPrerenderServiceKeyName[] =
     "PrerenderQueryPrerenderService";
 const char kPrerenderQueryPrerenderServiceCurrentURLKeyName[] =
@@ -335,6 +336,10 @@ bool IsLocalPredictorPrerenderAlwaysControlEnabled() {
       kEnabledGroup;
 }
 
+bool IsLocalPredictorWarmUpEnabled() {
+  return GetLocalPredictorSpecValue(kPrincipalWarmUpKeyName) == kEnabledGroup;
+}
+
 bool ShouldQueryPrerenderService(Profile* profile) {
   return IsUnencryptedSyncEnabled(profile) &&
       GetLocalPredictorSpecValue(kPrerenderQueryPrerenderServiceKeyName) ==
@@ -48,6 +48,10 @@ bool IsLocalPredictorPrerenderLaunchEnabled();
 // is irrelevant.
 bool IsLocalPredictorPrerenderAlwaysControlEnabled();
 
+// Returns true if the local predictor should warm up the principal of
+// candidates which fall short of being prerendered.
+bool IsLocalPredictorWarmUpEnabled();
+
 // Returns true if we should query the prerender service for the profile
 // provided.
 bool ShouldQueryPrerenderService(Profile* profile);
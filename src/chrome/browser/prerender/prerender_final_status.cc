@@ -63,6 +63,7 @@ const char* kFinalStatusNames[] = {
   "Cookie Conflict",
   "Non-Empty Browsing Instance",
   "Navigation Intercepted",
+  "Principal Unavailable",
   "Max",
 };
 COMPILE_ASSERT(arraysize(kFinalStatusNames) == FINAL_STATUS_MAX + 1,
@@ -482,4 +482,20 @@ bool PrerenderHistograms::IsOriginExperimentWash() const {
   return origin_experiment_wash_;
 }
 
+void PrerenderHistograms::RecordWarmUpResult(Origin origin,
+                                             bool used,
+                                             base::TimeDelta age) const {
+  PREFIXED_HISTOGRAM("WarmUpUsed", origin, UMA_HISTOGRAM_BOOLEAN(name, used));
+  if (used) {
+    PREFIXED_HISTOGRAM(
+        "WarmUpTimeUntilUsed", origin,
+        UMA_HISTOGRAM_CUSTOM_TIMES(
+            name,
+            age,
+            base::TimeDelta::FromMilliseconds(10),
+            base::TimeDelta::FromMinutes(30),
+            50));
+  }
+}
+
 }  // namespace prerender
@@ -128,6 +128,13 @@ class PrerenderHistograms {
                           int64 prerender_bytes,
                           int64 profile_bytes);
 
+  // Records the outcome of a warm-up once a navigation used it, or it expired.
+  // |used| is whether a navigation to its site followed.  Unused warm-ups are
+  // wasted work.
+  void RecordWarmUpResult(Origin origin,
+                          bool used,
+                          base::TimeDelta age) const;
+
  private:
   base::TimeTicks GetCurrentTimeTicks() const;
 
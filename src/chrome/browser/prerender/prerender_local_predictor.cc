@@ -1091,6 +1091,9 @@ void PrerenderLocalPredictor::ContinuePrerenderCheck(
       g_browser_process->safe_browsing_service()->database_manager();
 #endif
   PrerenderProperties* prerender_properties = NULL;
+  // The first candidate which was a likely navigation, but was not
+  // prerendered.  If nothing is prerendered, its principal is warmed up.
+  GURL warm_up_url;
 
   for (int i = 0; i < static_cast<int>(info->candidate_urls_.size()); i++) {
     RecordEvent(EVENT_CONTINUE_PRERENDER_CHECK_EXAMINE_NEXT_URL);
@@ -1129,6 +1132,8 @@ void PrerenderLocalPredictor::ContinuePrerenderCheck(
         GetIssuedPrerenderSlotForPriority(url_info->priority);
     if (!prerender_properties) {
       RecordEvent(EVENT_CONTINUE_PRERENDER_CHECK_PRIORITY_TOO_LOW);
+      if (warm_up_url.is_empty())
+        warm_up_url = url_info->url;
       url_info.reset(NULL);
       continue;
     }
@@ -1181,13 +1186,20 @@ void PrerenderLocalPredictor::ContinuePrerenderCheck(
     }
     if (!SkipLocalPredictorDefaultNoPrerender()) {
       RecordEvent(EVENT_CONTINUE_PRERENDER_CHECK_FALLTHROUGH_NOT_PRERENDERING);
+      if (warm_up_url.is_empty())
+        warm_up_url = url_info->url;
       url_info.reset(NULL);
     } else {
       RecordEvent(EVENT_CONTINUE_PRERENDER_CHECK_FALLTHROUGH_PRERENDERING);
     }
   }
-  if (!url_info.get())
+  if (!url_info.get()) {
+    if (!warm_up_url.is_empty() && IsLocalPredictorWarmUpEnabled()) {
+      RecordEvent(EVENT_ISSUING_WARM_UP);
+      prerender_manager_->WarmUpForURL(ORIGIN_LOCAL_PREDICTOR, warm_up_url);
+    }
     return;
+  }
   RecordEvent(EVENT_CONTINUE_PRERENDER_CHECK_ISSUING_PRERENDER);
   DCHECK(prerender_properties != NULL);
   if (IsLocalPredictorPrerenderLaunchEnabled()) {
@@ -137,6 +137,7 @@ class PrerenderLocalPredictor : public history::VisitDatabaseObserver,
     EVENT_TAB_HELPER_URL_SEEN_MATCH_BROWSER_NAVIGATE = 87,
     EVENT_TAB_HELPER_URL_SEEN_NAMESPACE_MATCH_ENTRY = 88,
     EVENT_TAB_HELPER_URL_SEEN_NAMESPACE_MATCH_BROWSER_NAVIGATE = 89,
+    EVENT_ISSUING_WARM_UP = 90,
     EVENT_MAX_VALUE
   };
 
@@ -11,6 +11,7 @@
 
 #include "base/bind.h"
 #include "base/bind_helpers.h"
+#include "base/guid.h"
 #include "base/logging.h"
 #include "base/memory/weak_ptr.h"
 #include "base/metrics/histogram.h"
@@ -49,8 +50,10 @@
 #include "chrome/common/pref_names.h"
 #include "chrome/common/prerender_messages.h"
 #include "chrome/common/prerender_types.h"
+#include "content/public/browser/browser_context.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/devtools_agent_host.h"
+#include "content/public/browser/dom_storage_context.h"
 #include "content/public/browser/navigation_controller.h"
 #include "content/public/browser/notification_service.h"
 #include "content/public/browser/notification_source.h"
@@ -65,6 +68,8 @@
 #include "content/public/common/url_constants.h"
 #include "extensions/common/constants.h"
 #include "net/base/registry_controlled_domains/registry_controlled_domain.h"
+#include "net/cookies/cookie_monster.h"
+#include "net/cookies/cookie_store.h"
 #include "net/url_request/url_request_context.h"
 #include "net/url_request/url_request_context_getter.h"
 
@@ -97,6 +102,12 @@ const int kHistoryLength = 100;
 // Timeout, in ms, for a session storage namespace merge.
 const int kSessionStorageNamespaceMergeTimeoutMs = 500;
 
+// Time after which an unused warm-up is counted as wasted.
+const int kWarmUpTimeToLiveSeconds = 60;
+
+// Maximum number of warm-ups held per principal.
+const size_t kMaxWarmUps = 2;
+
 // If true, all session storage merges hang indefinitely.
 bool g_hang_session_storage_merges_for_testing = false;
 
@@ -164,6 +175,16 @@ void CheckIfCookiesExistForDomainOnIOThread(
       base::Bind(&CheckIfCookiesExistForDomainResultOnIOThread, callback));
 }
 
+void WarmUpCookiesOnIOThread(net::URLRequestContextGetter* rq_context,
+                             const GURL& url) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  // The cookie monster loads the cookies for the domain of |url| ahead of the
+  // rest of its database.  The cookies themselves are not needed yet.
+  rq_context->GetURLRequestContext()->cookie_store()->GetCookieMonster()->
+      GetAllCookiesForURLAsync(url,
+                               net::CookieMonster::GetCookieListCallback());
+}
+
 }  // namespace
 
 class PrerenderManager::OnCloseWebContentsDeleter
@@ -222,10 +243,20 @@ class PrerenderManager::OnCloseWebContentsDeleter
 // static
 int PrerenderManager::prerenders_per_session_count_ = 0;
 
+// static
+PrerenderManager::PrincipalResolver* PrerenderManager::principal_resolver_ =
+    NULL;
+
 // static
 PrerenderManager::PrerenderManagerMode PrerenderManager::mode_ =
     PRERENDER_MODE_ENABLED;
 
+struct PrerenderManager::WarmUp {
+  Origin origin;
+  GURL site;
+  base::TimeTicks start_time;
+};
+
 struct PrerenderManager::NavigationRecord {
   NavigationRecord(const GURL& url, base::TimeTicks time)
       : url(url),
@@ -324,6 +355,8 @@ void PrerenderManager::Shutdown() {
   // |local_predictor_| accesses it.
   if (local_predictor_)
     local_predictor_->Shutdown();
+  while (!warm_ups_.empty())
+    FinishWarmUp(warm_ups_.begin(), false);
   profile_ = NULL;
 
   DCHECK(active_prerenders_.empty());
@@ -409,6 +442,22 @@ void PrerenderManager::CancelAllPrerenders() {
   }
 }
 
+void PrerenderManager::WarmUpForURL(Origin origin, const GURL& url) {
+  DCHECK(CalledOnValidThread());
+  if (!IsEnabled() || !DoesURLHaveValidScheme(url))
+    return;
+
+  Profile* target_principal = GetTargetPrincipal(url);
+  PrerenderManager* target_manager = NULL;
+  if (target_principal == profile_) {
+    target_manager = this;
+  } else if (target_principal) {
+    target_manager = GetPrerenderManagerForPrincipal(target_principal);
+  }
+  if (target_manager)
+    target_manager->StartWarmUp(origin, url);
+}
+
 bool PrerenderManager::MaybeUsePrerenderedPage(const GURL& url,
                                                chrome::NavigateParams* params) {
   DCHECK(CalledOnValidThread());
@@ -465,8 +514,12 @@ bool PrerenderManager::MaybeUsePrerenderedPage(const GURL& url,
       prerender_data->contents()->GetSessionStorageNamespace();
   // Only when actually prerendering is session storage namespace merging an
   // issue. For the control group, it will be assumed that the merge succeeded.
+  // A prerender made on behalf of another principal has a namespace of its
+  // own, which no tab of this principal is an alias of, so there is nothing
+  // to merge it into; the prerendered page keeps its namespace once swapped.
   if (prerender_namespace && prerender_namespace != target_namespace &&
-      !prerender_namespace->IsAliasOf(target_namespace)) {
+      !prerender_namespace->IsAliasOf(target_namespace) &&
+      !prerender_data->contents()->is_cross_principal()) {
     if (!ShouldMergeSessionStorageNamespaces()) {
       RecordEvent(prerender_data->contents(),
                   PRERENDER_EVENT_SWAPIN_MERGING_DISABLED);
@@ -610,6 +663,14 @@ WebContents* PrerenderManager::SwapInternal(
     histograms_->RecordTimeUntilUsed(
         prerender_data->contents()->origin(),
         GetCurrentTimeTicks() - prerender_data->contents()->load_start_time());
+    // The page load time saved by a prerender is at most the time it had been
+    // loading before it was used.
+    if (prerender_data->contents()->is_cross_principal()) {
+      UMA_HISTOGRAM_MEDIUM_TIMES(
+          "Prerender.CrossPrincipalTimeUntilUsed",
+          GetCurrentTimeTicks() -
+              prerender_data->contents()->load_start_time());
+    }
   }
   histograms_->RecordAbandonTimeUntilUsed(
       prerender_data->contents()->origin(),
@@ -781,6 +842,11 @@ const char* PrerenderManager::GetModeString() {
   return "";
 }
 
+// static
+void PrerenderManager::SetPrincipalResolver(PrincipalResolver* resolver) {
+  principal_resolver_ = resolver;
+}
+
 // static
 bool PrerenderManager::IsPrerenderingPossible() {
   return GetMode() != PRERENDER_MODE_DISABLED;
@@ -979,6 +1045,16 @@ void PrerenderManager::RecordNavigation(const GURL& url) {
 
   navigations_.push_back(NavigationRecord(url, GetCurrentTimeTicks()));
   CleanUpOldNavigations();
+
+  ExpireWarmUps();
+  const GURL site = content::SiteInstance::GetSiteForURL(profile_, url);
+  for (ScopedVector<WarmUp>::iterator it = warm_ups_.begin();
+       it != warm_ups_.end(); ++it) {
+    if ((*it)->site == site) {
+      FinishWarmUp(it, true);
+      break;
+    }
+  }
 }
 
 // protected
@@ -1278,6 +1354,26 @@ PrerenderHandle* PrerenderManager::AddPrerender(
     url = alias_url;
   }
 
+  // A navigation to |url| which is routed to another principal would never
+  // find a prerender made here, so hand the prerender over to that principal.
+  // Its PrerenderCookieStore then stages the cookie writes of the prerender
+  // against the cookie monster of that principal, too.
+  Profile* target_principal = GetTargetPrincipal(url_arg);
+  if (target_principal != profile_) {
+    PrerenderManager* target_manager = target_principal ?
+        GetPrerenderManagerForPrincipal(target_principal) : NULL;
+    UMA_HISTOGRAM_BOOLEAN("Prerender.CrossPrincipalManagerAvailable",
+                          target_manager != NULL);
+    if (target_manager) {
+      return target_manager->AddCrossPrincipalPrerender(
+          origin, process_id, url_arg, referrer, size);
+    }
+    histograms_->RecordPrerender(origin, url_arg);
+    RecordFinalStatusWithoutCreatingPrerenderContents(
+        url, origin, experiment, FINAL_STATUS_PRINCIPAL_UNAVAILABLE);
+    return NULL;
+  }
+
   // From here on, we will record a FinalStatus so we need to register with the
   // histogram tracking.
   histograms_->RecordPrerender(origin, url_arg);
@@ -1383,6 +1479,93 @@ PrerenderHandle* PrerenderManager::AddPrerender(
   return prerender_handle;
 }
 
+PrerenderHandle* PrerenderManager::AddCrossPrincipalPrerender(
+    Origin origin,
+    int child_id,
+    const GURL& url,
+    const content::Referrer& referrer,
+    const gfx::Size& size) {
+  DCHECK(CalledOnValidThread());
+  if (!IsEnabled())
+    return NULL;
+
+  // Do not bounce the prerender on if this principal would route the
+  // navigation elsewhere again.
+  if (GetTargetPrincipal(url) != profile_)
+    return NULL;
+
+  // Each prerender gets a namespace of its own, so that two of them swapped
+  // into different tabs do not share sessionStorage.
+  scoped_refptr<SessionStorageNamespace> session_storage_namespace =
+      content::BrowserContext::GetDefaultStoragePartition(profile_)->
+          GetDOMStorageContext()->RecreateSessionStorage(base::GenerateGUID());
+
+  PrerenderHandle* handle = AddPrerender(
+      origin, child_id, url, referrer, size, session_storage_namespace.get());
+  if (handle && handle->contents())
+    handle->contents()->set_is_cross_principal(true);
+  return handle;
+}
+
+PrerenderManager* PrerenderManager::GetPrerenderManagerForPrincipal(
+    Profile* principal) const {
+  return PrerenderManagerFactory::GetForProfile(principal);
+}
+
+Profile* PrerenderManager::GetTargetPrincipal(const GURL& url) const {
+  if (!principal_resolver_)
+    return profile_;
+  return principal_resolver_->GetTargetPrincipal(profile_, url);
+}
+
+void PrerenderManager::StartWarmUp(Origin origin, const GURL& url) {
+  DCHECK(CalledOnValidThread());
+  if (!IsEnabled())
+    return;
+
+  ExpireWarmUps();
+  const GURL site = content::SiteInstance::GetSiteForURL(profile_, url);
+  for (ScopedVector<WarmUp>::const_iterator it = warm_ups_.begin();
+       it != warm_ups_.end(); ++it) {
+    if ((*it)->site == site)
+      return;
+  }
+  if (warm_ups_.size() >= kMaxWarmUps)
+    FinishWarmUp(warm_ups_.begin(), false);
+
+  scoped_ptr<WarmUp> warm_up(new WarmUp);
+  warm_up->origin = origin;
+  warm_up->site = site;
+  warm_up->start_time = GetCurrentTimeTicks();
+
+  // Creating the storage partition brings up its DOM storage context, and the
+  // request context whose cookie monster is then asked for |url|.
+  content::StoragePartition* storage_partition =
+      content::BrowserContext::GetStoragePartitionForSite(profile_, url);
+  BrowserThread::PostTask(
+      BrowserThread::IO, FROM_HERE,
+      base::Bind(&WarmUpCookiesOnIOThread,
+                 make_scoped_refptr(storage_partition->GetURLRequestContext()),
+                 url));
+
+  warm_ups_.push_back(warm_up.release());
+}
+
+void PrerenderManager::FinishWarmUp(ScopedVector<WarmUp>::iterator warm_up,
+                                    bool used) {
+  histograms_->RecordWarmUpResult(
+      (*warm_up)->origin, used,
+      GetCurrentTimeTicks() - (*warm_up)->start_time);
+  warm_ups_.erase(warm_up);
+}
+
+void PrerenderManager::ExpireWarmUps() {
+  const base::TimeTicks expiry_time = GetCurrentTimeTicks() -
+      base::TimeDelta::FromSeconds(kWarmUpTimeToLiveSeconds);
+  while (!warm_ups_.empty() && warm_ups_.front()->start_time <= expiry_time)
+    FinishWarmUp(warm_ups_.begin(), false);
+}
+
 void PrerenderManager::StartSchedulingPeriodicCleanups() {
   DCHECK(CalledOnValidThread());
   if (repeating_timer_.IsRunning())
@@ -102,6 +102,21 @@ class PrerenderManager : public base::SupportsWeakPtr<PrerenderManager>,
 
   typedef predictors::LoggedInPredictorTable::LoggedInStateMap LoggedInStateMap;
 
+  // Under principal isolation, a navigation may be routed to another principal
+  // (Profile) than the one it started in.  A prerender is only found by the
+  // PrerenderManager of the principal the navigation lands in, so prerenders
+  // are created there directly.  The PrincipalManager resolves the principal.
+  class PrincipalResolver {
+   public:
+    virtual ~PrincipalResolver() {}
+
+    // Returns the principal which a navigation from |source| to |url| will
+    // land in, creating it speculatively if it does not exist yet.  Returns
+    // |source| if the navigation stays in it, or NULL if the principal cannot
+    // be created.
+    virtual Profile* GetTargetPrincipal(Profile* source, const GURL& url) = 0;
+  };
+
   // ID indicating that no experiment is active.
   static const uint8 kNoExperiment = 0;
 
@@ -163,6 +178,13 @@ class PrerenderManager : public base::SupportsWeakPtr<PrerenderManager>,
   // Cancels all active prerenders.
   void CancelAllPrerenders();
 
+  // Prepares for a navigation to |url| which is not likely enough to be
+  // prerendered.  The principal the navigation would land in is created, with
+  // its storage partition, and the cookie monster starts loading the cookies
+  // for |url|.  Nothing is fetched, and no renderer is spawned.  The warm-up
+  // counts as used once RecordNavigation() sees a navigation to its site.
+  void WarmUpForURL(Origin origin, const GURL& url);
+
   // If |url| matches a valid prerendered page and |params| are compatible, try
   // to swap it and merge browsing histories. Returns |true| and updates
   // |params->target_contents| if a prerendered page is swapped in, |false|
@@ -207,6 +229,11 @@ class PrerenderManager : public base::SupportsWeakPtr<PrerenderManager>,
   static bool IsControlGroup(uint8 experiment_id);
   static bool IsNoUseGroup();
 
+  // Sets the resolver consulted for every new prerender.  Without one, every
+  // prerender is created in the principal which requested it.  |resolver| is
+  // not owned, and must outlive all PrerenderManagers, or be reset to NULL.
+  static void SetPrincipalResolver(PrincipalResolver* resolver);
+
   // Query the list of current prerender pages to see if the given web contents
   // is prerendering a page. The optional parameter |origin| is an output
   // parameter which, if a prerender is found, is set to the Origin of the
@@ -554,6 +581,8 @@ class PrerenderManager : public base::SupportsWeakPtr<PrerenderManager>,
   // Time window for which we record old navigations, in milliseconds.
   static const int kNavigationRecordWindowMs = 5000;
 
+  struct WarmUp;
+
   void OnCancelPrerenderHandle(PrerenderData* prerender_data);
 
   // Adds a prerender for |url| from |referrer| initiated from the process
@@ -569,6 +598,37 @@ class PrerenderManager : public base::SupportsWeakPtr<PrerenderManager>,
       const gfx::Size& size,
       content::SessionStorageNamespace* session_storage_namespace);
 
+  // Adds a prerender which another principal predicted, but which the
+  // navigation to |url| will be routed to this principal for.  The prerender
+  // gets a fresh session storage namespace of this principal, since the one
+  // of the tab which predicted it belongs to another principal, and is
+  // swapped in without a merge.  Returns NULL if this principal would route
+  // the navigation on again.
+  PrerenderHandle* AddCrossPrincipalPrerender(
+      Origin origin,
+      int child_id,
+      const GURL& url,
+      const content::Referrer& referrer,
+      const gfx::Size& size);
+
+  // Returns the PrerenderManager of |principal|, or NULL if it does not
+  // prerender.
+  virtual PrerenderManager* GetPrerenderManagerForPrincipal(
+      Profile* principal) const;
+
+  // Returns the principal a navigation to |url| will land in, or NULL if it
+  // cannot be created.
+  Profile* GetTargetPrincipal(const GURL& url) const;
+
+  // Warms up this principal for |url|, see WarmUpForURL().
+  void StartWarmUp(Origin origin, const GURL& url);
+
+  // Records the outcome of |warm_up| and removes it.
+  void FinishWarmUp(ScopedVector<WarmUp>::iterator warm_up, bool used);
+
+  // Finishes the warm-ups which were not used in time.
+  void ExpireWarmUps();
+
   void StartSchedulingPeriodicCleanups();
   void StopSchedulingPeriodicCleanups();
 
@@ -704,6 +764,11 @@ class PrerenderManager : public base::SupportsWeakPtr<PrerenderManager>,
 
   static PrerenderManagerMode mode_;
 
+  static PrincipalResolver* principal_resolver_;
+
+  // Outstanding warm-ups of this principal, oldest first.
+  ScopedVector<WarmUp> warm_ups_;
+
   // A count of how many prerenders we do per session. Initialized to 0 then
   // incremented and emitted to a histogram on each successful prerender.
   static int prerenders_per_session_count_;
@@ -13,6 +13,7 @@
 #include "base/strings/stringprintf.h"
 #include "base/time/time.h"
 #include "chrome/browser/prerender/prerender_contents.h"
+#include "chrome/browser/prerender/prerender_field_trial.h"
 #include "chrome/browser/prerender/prerender_handle.h"
 #include "chrome/browser/prerender/prerender_link_manager.h"
 #include "chrome/browser/prerender/prerender_manager.h"
@@ -88,6 +89,26 @@ const gfx::Size kSize(640, 480);
 
 const uint32 kDefaultRelTypes = PrerenderRelTypePrerender;
 
+// Routes every navigation to |target|, for as long as it is alive.
+class TestPrincipalResolver : public PrerenderManager::PrincipalResolver {
+ public:
+  explicit TestPrincipalResolver(Profile* target) : target_(target) {
+    PrerenderManager::SetPrincipalResolver(this);
+  }
+
+  virtual ~TestPrincipalResolver() {
+    PrerenderManager::SetPrincipalResolver(NULL);
+  }
+
+  virtual Profile* GetTargetPrincipal(Profile* source,
+                                      const GURL& url) OVERRIDE {
+    return target_;
+  }
+
+ private:
+  Profile* target_;
+};
+
 }  // namespace
 
 class UnitTestPrerenderManager : public PrerenderManager {
@@ -200,6 +221,15 @@ class UnitTestPrerenderManager : public PrerenderManager {
     return next_prerender_contents_.get();
   }
 
+  size_t warm_up_count() const {
+    return warm_ups_.size();
+  }
+
+  void set_principal_prerender_manager(Profile* principal,
+                                       PrerenderManager* prerender_manager) {
+    principal_prerender_managers_[principal] = prerender_manager;
+  }
+
   // from PrerenderManager
   virtual Time GetCurrentTime() const OVERRIDE {
     return time_;
@@ -219,6 +249,13 @@ class UnitTestPrerenderManager : public PrerenderManager {
     return iter->second;
   }
 
+  virtual PrerenderManager* GetPrerenderManagerForPrincipal(
+      Profile* principal) const OVERRIDE {
+    std::map<Profile*, PrerenderManager*>::const_iterator it =
+        principal_prerender_managers_.find(principal);
+    return it == principal_prerender_managers_.end() ? NULL : it->second;
+  }
+
   void DummyPrerenderContentsStarted(int child_id,
                                      int route_id,
                                      PrerenderContents* prerender_contents) {
@@ -261,6 +298,8 @@ class UnitTestPrerenderManager : public PrerenderManager {
   typedef std::map<std::pair<int,int>, PrerenderContents*> PrerenderContentsMap;
   PrerenderContentsMap prerender_contents_map_;
 
+  std::map<Profile*, PrerenderManager*> principal_prerender_managers_;
+
   Time time_;
   TimeTicks time_ticks_;
   scoped_ptr<PrerenderContents> next_prerender_contents_;
@@ -345,6 +384,10 @@ class PrerenderTest : public testing::Test {
     return prerender_manager_.get();
   }
 
+  Profile* profile() {
+    return &profile_;
+  }
+
   PrerenderLinkManager* prerender_link_manager() {
     return prerender_link_manager_.get();
   }
@@ -419,6 +462,116 @@ TEST_F(PrerenderTest, FoundTest) {
   ASSERT_EQ(prerender_contents, prerender_manager()->FindAndUseEntry(url));
 }
 
+// Tests that a prerender stays in its principal when the navigation to it
+// does.
+TEST_F(PrerenderTest, SamePrincipalTest) {
+  TestPrincipalResolver resolver(profile());
+  GURL url("http://www.google.com/");
+  DummyPrerenderContents* prerender_contents =
+      prerender_manager()->CreateNextPrerenderContents(
+          url,
+          FINAL_STATUS_USED);
+  EXPECT_TRUE(AddSimplePrerender(url));
+  EXPECT_TRUE(prerender_contents->prerendering_has_started());
+  EXPECT_FALSE(prerender_contents->is_cross_principal());
+  ASSERT_EQ(prerender_contents, prerender_manager()->FindAndUseEntry(url));
+}
+
+// Tests that a prerender is created in the principal the navigation to it
+// will be routed to, where that navigation will find it.
+TEST_F(PrerenderTest, CrossPrincipalTest) {
+  TestingProfile principal;
+  UnitTestPrerenderManager principal_prerender_manager(
+      &principal, g_browser_process->prerender_tracker());
+  prerender_manager()->set_principal_prerender_manager(
+      &principal, &principal_prerender_manager);
+  TestPrincipalResolver resolver(&principal);
+
+  GURL url("http://www.google.com/");
+  DummyPrerenderContents* prerender_contents =
+      principal_prerender_manager.CreateNextPrerenderContents(
+          url,
+          FINAL_STATUS_USED);
+  EXPECT_TRUE(AddSimplePrerender(url));
+  EXPECT_TRUE(prerender_contents->prerendering_has_started());
+  EXPECT_TRUE(prerender_contents->is_cross_principal());
+  EXPECT_FALSE(prerender_manager()->FindEntry(url));
+  ASSERT_EQ(prerender_contents,
+            principal_prerender_manager.FindAndUseEntry(url));
+  principal_prerender_manager.Shutdown();
+}
+
+// Tests that nothing is prerendered when the principal the navigation will be
+// routed to cannot be created.
+TEST_F(PrerenderTest, PrincipalUnavailableTest) {
+  TestPrincipalResolver resolver(NULL);
+  GURL url("http://www.google.com/");
+  prerender_manager()->CreateNextPrerenderContents(
+      url,
+      FINAL_STATUS_MANAGER_SHUTDOWN);
+  EXPECT_FALSE(AddSimplePrerender(url));
+  EXPECT_TRUE(prerender_manager()->next_prerender_contents());
+}
+
+// Tests that a warm-up is held once per site until a navigation to the site
+// uses it.
+TEST_F(PrerenderTest, WarmUpUsedByNavigationTest) {
+  prerender_manager()->WarmUpForURL(ORIGIN_LOCAL_PREDICTOR,
+                                    GURL("http://www.google.com/search"));
+  EXPECT_EQ(1u, prerender_manager()->warm_up_count());
+  prerender_manager()->WarmUpForURL(ORIGIN_LOCAL_PREDICTOR,
+                                    GURL("http://mail.google.com/"));
+  EXPECT_EQ(1u, prerender_manager()->warm_up_count());
+
+  prerender_manager()->RecordNavigation(GURL("http://www.example.com/"));
+  EXPECT_EQ(1u, prerender_manager()->warm_up_count());
+  prerender_manager()->RecordNavigation(GURL("http://www.google.com/"));
+  EXPECT_EQ(0u, prerender_manager()->warm_up_count());
+}
+
+// Tests that only the newest warm-ups are held, and that they expire.
+TEST_F(PrerenderTest, WarmUpLimitAndExpiryTest) {
+  prerender_manager()->WarmUpForURL(ORIGIN_LOCAL_PREDICTOR,
+                                    GURL("http://www.google.com/"));
+  prerender_manager()->WarmUpForURL(ORIGIN_LOCAL_PREDICTOR,
+                                    GURL("http://www.example.com/"));
+  prerender_manager()->WarmUpForURL(ORIGIN_LOCAL_PREDICTOR,
+                                    GURL("http://www.chromium.org/"));
+  EXPECT_EQ(2u, prerender_manager()->warm_up_count());
+
+  // The oldest warm-up was dropped to make room.
+  prerender_manager()->RecordNavigation(GURL("http://www.google.com/"));
+  EXPECT_EQ(2u, prerender_manager()->warm_up_count());
+
+  prerender_manager()->AdvanceTimeTicks(TimeDelta::FromMinutes(2));
+  prerender_manager()->RecordNavigation(GURL("http://www.example.com/"));
+  EXPECT_EQ(0u, prerender_manager()->warm_up_count());
+}
+
+// Tests that the principal a navigation will be routed to is the one warmed
+// up, and that its warm-ups are released on shutdown.
+TEST_F(PrerenderTest, WarmUpCrossPrincipalTest) {
+  TestingProfile principal;
+  UnitTestPrerenderManager principal_prerender_manager(
+      &principal, g_browser_process->prerender_tracker());
+  prerender_manager()->set_principal_prerender_manager(
+      &principal, &principal_prerender_manager);
+  TestPrincipalResolver resolver(&principal);
+
+  prerender_manager()->WarmUpForURL(ORIGIN_LOCAL_PREDICTOR,
+                                    GURL("http://www.google.com/"));
+  EXPECT_EQ(0u, prerender_manager()->warm_up_count());
+  EXPECT_EQ(1u, principal_prerender_manager.warm_up_count());
+
+  principal_prerender_manager.Shutdown();
+  EXPECT_EQ(0u, principal_prerender_manager.warm_up_count());
+}
+
+// Tests that warm-ups are only issued when the field trial turns them on.
+TEST_F(PrerenderTest, WarmUpDisabledByDefaultTest) {
+  EXPECT_FALSE(IsLocalPredictorWarmUpEnabled());
+}
+
 // Make sure that if queue a request, and a second prerender request for the
 // same URL comes in, that the second request attaches to the first prerender,
 // and we don't use the second prerender contents.
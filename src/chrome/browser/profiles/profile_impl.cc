@@ -414,6 +414,10 @@ ProfileImpl::ProfileImpl(
   predictor_ = chrome_browser_net::Predictor::CreatePredictor(
       !command_line->HasSwitch(switches::kDisablePreconnect),
       g_browser_process->profile_manager() == NULL);
+  if (g_browser_process->profile_manager()) {
+    predictor_->set_referrer_graph_path(
+        path_.Append(chrome::kPredictorReferrerGraphFilename));
+  }
 
   // If we are creating the profile synchronously, then we should load the
   // policy data immediately.
@@ -187,8 +187,12 @@ void ChromeRenderMessageFilter::OnResourceTypeStats(
 }
 
 void ChromeRenderMessageFilter::OnUpdatedCacheStats(
-    const WebCache::UsageStats& stats) {
+    const WebCache::UsageStats& stats,
+    uint32 misses,
+    uint32 object_count) {
   WebCacheManager::GetInstance()->ObserveStats(render_process_id_, stats);
+  WebCacheManager::GetInstance()->ObserveMisses(render_process_id_, misses,
+                                                object_count);
 }
 
 void ChromeRenderMessageFilter::OnFPS(int routing_id, float fps) {
@@ -70,7 +70,9 @@ class ChromeRenderMessageFilter : public content::BrowserMessageFilter {
   void OnDnsPrefetch(const std::vector<std::string>& hostnames);
   void OnPreconnect(const GURL& url);
   void OnResourceTypeStats(const blink::WebCache::ResourceTypeStats& stats);
-  void OnUpdatedCacheStats(const blink::WebCache::UsageStats& stats);
+  void OnUpdatedCacheStats(const blink::WebCache::UsageStats& stats,
+                           uint32 misses,
+                           uint32 object_count);
   void OnFPS(int routing_id, float fps);
   void OnV8HeapStats(int v8_memory_allocated, int v8_memory_used);
 
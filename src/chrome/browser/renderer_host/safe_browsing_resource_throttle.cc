@@ -43,8 +43,9 @@ SafeBrowsingResourceThrottle::~SafeBrowsingResourceThrottle() {
 }
 
 void SafeBrowsingResourceThrottle::WillStartRequest(bool* defer) {
-  // We need to check the new URL before starting the request.
-  if (CheckUrl(request_->url()))
+  // We need to check the new URL before starting the request.  The
+  // subresources of a page are checked together.
+  if (CheckUrl(request_->url(), is_subresource_))
     return;
 
   // If the URL couldn't be verified synchronously, defer starting the
@@ -62,7 +63,7 @@ void SafeBrowsingResourceThrottle::WillRedirectRequest(const GURL& new_url,
   redirect_urls_.push_back(new_url);
 
   // We need to check the new URL before following the redirect.
-  if (CheckUrl(new_url))
+  if (CheckUrl(new_url, false))
     return;
 
   // If the URL couldn't be verified synchronously, defer following the
@@ -179,9 +180,11 @@ void SafeBrowsingResourceThrottle::OnBlockingPageComplete(bool proceed) {
   }
 }
 
-bool SafeBrowsingResourceThrottle::CheckUrl(const GURL& url) {
+bool SafeBrowsingResourceThrottle::CheckUrl(const GURL& url, bool in_batch) {
   CHECK(state_ == STATE_NONE);
-  bool succeeded_synchronously = database_manager_->CheckBrowseUrl(url, this);
+  bool succeeded_synchronously =
+      in_batch ? database_manager_->CheckBrowseUrlInBatch(url, this) :
+                 database_manager_->CheckBrowseUrl(url, this);
   if (succeeded_synchronously) {
     threat_type_ = SB_THREAT_TYPE_SAFE;
     ui_manager_->LogPauseDelay(base::TimeDelta());  // No delay.
@@ -29,7 +29,9 @@ class URLRequest;
 // before following any subsequent redirect.
 //
 // In the common case, the check completes synchronously (no match in the bloom
-// filter), so the request's flow is un-interrupted.
+// filter), so the request's flow is un-interrupted.  This holds for
+// subresources too; only those which match a prefix are deferred, and those
+// of a page are then checked as one batch.
 //
 // However if the URL fails this quick check, it has the possibility of being
 // on the blacklist. Now the request is suspended (prevented from starting),
@@ -81,10 +83,11 @@ class SafeBrowsingResourceThrottle
   // SafeBrowsingService::UrlCheckCallback implementation.
   void OnBlockingPageComplete(bool proceed);
 
-  // Starts running |url| through the safe browsing check. Returns true if the
-  // URL is safe to visit. Otherwise returns false and will call
-  // OnBrowseUrlResult() when the check has completed.
-  bool CheckUrl(const GURL& url);
+  // Starts running |url| through the safe browsing check, together with the
+  // other subresources of the page if |in_batch|. Returns true if the URL is
+  // safe to visit. Otherwise returns false and will call OnBrowseUrlResult()
+  // when the check has completed.
+  bool CheckUrl(const GURL& url, bool in_batch);
 
   // Callback for when the safe browsing check (which was initiated by
   // StartCheckingUrl()) has taken longer than kCheckUrlTimeoutMs.
@@ -5,6 +5,9 @@
 #include "chrome/browser/renderer_host/web_cache_manager.h"
 
 #include <algorithm>
+#include <cmath>
+#include <queue>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/compiler_specific.h"
@@ -36,6 +39,35 @@ static const int kReviseAllocationDelayMS = 200;
 // The default size limit of the in-memory cache is 8 MB
 static const int kDefaultMemoryCacheSize = 8 * 1024 * 1024;
 
+// Weight of the latest report in the smoothed miss rate of a renderer.
+static const double kMissRateSmoothing = 0.5;
+
+// The working set of a renderer is what its cache holds plus what it missed
+// over this many seconds, i.e. the objects it referenced within the window.
+// The window is about the time a page takes to load and lay out, over which
+// it references most of its subresources and reuses them.  A longer window
+// counts repeated misses of the same objects more than once, and one shorter
+// than a load misses objects which the page still needs.
+static const double kWorkingSetWindowSeconds = 5.0;
+
+// Object size assumed for renderers whose cache is empty.
+static const double kDefaultObjectSize = 16 * 1024;
+
+// Smallest working set assumed for a renderer.
+static const double kMinWorkingSetBytes = 256 * 1024;
+
+// Bounds the reference rate inferred from the misses of a renderer whose
+// cache seemingly holds its whole working set.
+static const double kMinMissRatio = 0.05;
+
+// A miss in an inactive renderer is worth this much of one in an active one.
+static const double kInactiveMissWeight = 0.1;
+
+// The utility allocator hands out memory in chunks of at least this many
+// bytes, and in at most kMaxAllocationChunks chunks.
+static const size_t kAllocationChunkBytes = 64 * 1024;
+static const size_t kMaxAllocationChunks = 1024;
+
 namespace {
 
 int GetDefaultCacheSize() {
@@ -96,6 +128,7 @@ void WebCacheManager::Add(int renderer_id) {
   RendererInfo* stats = &(stats_[renderer_id]);
   memset(stats, 0, sizeof(*stats));
   stats->access = Time::Now();
+  stats->miss_report = stats->access;
 
   // Revise our allocation strategy to account for this new renderer.
   ReviseAllocationStrategyLater();
@@ -145,6 +178,27 @@ void WebCacheManager::ObserveStats(int renderer_id,
   entry->second.minDeadCapacity = stats.minDeadCapacity;
 }
 
+void WebCacheManager::ObserveMisses(int renderer_id,
+                                    size_t misses,
+                                    size_t object_count) {
+  StatsMap::iterator entry = stats_.find(renderer_id);
+  if (entry == stats_.end())
+    return;  // We might see stats for a renderer that has been destroyed.
+
+  RendererInfo& info = entry->second;
+  Time now = Time::Now();
+  double seconds = std::max(1.0, (now - info.miss_report).InSecondsF());
+  double miss_rate = misses / seconds;
+  if (info.has_miss_stats) {
+    miss_rate = kMissRateSmoothing * miss_rate +
+                (1 - kMissRateSmoothing) * info.miss_rate;
+  }
+  info.has_miss_stats = true;
+  info.miss_rate = miss_rate;
+  info.object_count = object_count;
+  info.miss_report = now;
+}
+
 void WebCacheManager::SetGlobalSizeLimit(size_t bytes) {
   global_size_limit_ = bytes;
   ReviseAllocationStrategyLater();
@@ -309,6 +363,153 @@ void WebCacheManager::AddToStrategy(const std::set<int>& renderers,
   }
 }
 
+bool WebCacheManager::AttemptTactics(const WebCache::UsageStats& active,
+                                     const WebCache::UsageStats& inactive,
+                                     AllocationStrategy* strategy) {
+  // We attempt various tactics in order of preference.  Our first preference
+  // is not to evict any objects.  If we don't have enough resources, we'll
+  // first try to evict dead data only.  If that fails, we'll just divide the
+  // resources we have evenly.
+  //
+  // We always try to give the active renderers some head room in their
+  // allocations so they can take memory away from an inactive renderer with
+  // a large cache allocation.
+  //
+  // Notice the early exit will prevent attempting less desirable tactics once
+  // we've found a workable strategy.
+  return  // Ideally, we'd like to give the active renderers some headroom and
+          // keep all our current objects.
+      AttemptTactic(KEEP_CURRENT_WITH_HEADROOM, active,
+                    KEEP_CURRENT, inactive, strategy) ||
+      // If we can't have that, then we first try to evict the dead objects in
+      // the caches of inactive renderers.
+      AttemptTactic(KEEP_CURRENT_WITH_HEADROOM, active,
+                    KEEP_LIVE, inactive, strategy) ||
+      // Next, we try to keep the live objects in the active renders (with some
+      // room for new objects) and give whatever is left to the inactive
+      // renderers.
+      AttemptTactic(KEEP_LIVE_WITH_HEADROOM, active,
+                    DIVIDE_EVENLY, inactive, strategy) ||
+      // If we've gotten this far, then we are very tight on memory.  Let's try
+      // to at least keep around the live objects for the active renderers.
+      AttemptTactic(KEEP_LIVE, active, DIVIDE_EVENLY, inactive, strategy) ||
+      // We're basically out of memory.  The best we can do is just divide up
+      // what we have and soldier on.
+      AttemptTactic(DIVIDE_EVENLY, active, DIVIDE_EVENLY, inactive, strategy);
+}
+
+// static
+double WebCacheManager::GetMissRate(const MissCurve& curve, double capacity) {
+  return curve.reference_rate * std::exp(-capacity / curve.working_set);
+}
+
+// static
+WebCacheManager::MissCurve WebCacheManager::GetMissCurve(
+    const RendererInfo& info) {
+  double cached_bytes = static_cast<double>(info.liveSize) + info.deadSize;
+  double object_size = kDefaultObjectSize;
+  if (info.object_count > 0 && cached_bytes > 0)
+    object_size = cached_bytes / info.object_count;
+
+  MissCurve curve;
+  curve.working_set = std::max(kMinWorkingSetBytes,
+      cached_bytes + info.miss_rate * kWorkingSetWindowSeconds * object_size);
+  // The misses observed at the current capacity imply the reference rate.
+  curve.reference_rate = info.miss_rate /
+      std::max(kMinMissRatio, std::exp(-(info.capacity / curve.working_set)));
+  return curve;
+}
+
+// static
+double WebCacheManager::GetChunkGain(const Candidate& candidate,
+                                     size_t chunk) {
+  double weight = candidate.active ? 1.0 : kInactiveMissWeight;
+  return weight * (GetMissRate(candidate.curve, candidate.allocation) -
+                   GetMissRate(candidate.curve, candidate.allocation + chunk));
+}
+
+bool WebCacheManager::AttemptUtilityAllocation(AllocationStrategy* strategy) {
+  DCHECK(strategy);
+
+  std::vector<Candidate> candidates;
+  size_t active_live_size = 0;
+  size_t inactive_live_size = 0;
+  double active_working_set = 0;
+  double reference_rate_sum = 0;
+  size_t reporting_renderers = 0;
+  for (StatsMap::const_iterator it = stats_.begin(); it != stats_.end();
+       ++it) {
+    Candidate candidate;
+    candidate.renderer_id = it->first;
+    candidate.active = active_renderers_.count(it->first) != 0;
+    if (!candidate.active && !inactive_renderers_.count(it->first))
+      continue;
+    candidate.curve = GetMissCurve(it->second);
+    candidate.allocation = it->second.liveSize;
+    if (candidate.active) {
+      active_live_size += it->second.liveSize;
+      active_working_set += candidate.curve.working_set;
+    } else {
+      inactive_live_size += it->second.liveSize;
+    }
+    if (it->second.has_miss_stats) {
+      reference_rate_sum += candidate.curve.reference_rate;
+      ++reporting_renderers;
+    }
+    candidates.push_back(candidate);
+  }
+  if (reporting_renderers == 0 || active_live_size > global_size_limit_)
+    return false;
+
+  // Renderers which have not reported yet are assumed to be typical.
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    const StatsMap::const_iterator info =
+        stats_.find(candidates[i].renderer_id);
+    if (!info->second.has_miss_stats) {
+      candidates[i].curve.reference_rate =
+          reference_rate_sum / reporting_renderers;
+    }
+  }
+
+  // The active renderers keep their live objects.  The inactive renderers
+  // keep theirs only if that leaves room for the working sets of the active
+  // renderers, and otherwise compete for memory like everything else.
+  size_t remaining = global_size_limit_ - active_live_size;
+  if (global_size_limit_ < std::max<double>(active_live_size,
+                                            active_working_set) +
+                               inactive_live_size) {
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      if (!candidates[i].active)
+        candidates[i].allocation = 0;
+    }
+  } else {
+    remaining -= inactive_live_size;
+  }
+
+  // Hand out the rest by marginal utility.  The modeled miss curves are
+  // convex, so the gain of each renderer's next chunk only ever decreases.
+  const size_t chunk =
+      std::max(kAllocationChunkBytes, remaining / kMaxAllocationChunks);
+  typedef std::pair<double, size_t> Gain;
+  std::priority_queue<Gain> gains;
+  for (size_t i = 0; i < candidates.size(); ++i)
+    gains.push(Gain(GetChunkGain(candidates[i], chunk), i));
+  while (remaining > 0 && !gains.empty()) {
+    size_t i = gains.top().second;
+    gains.pop();
+    size_t bytes = std::min(chunk, remaining);
+    candidates[i].allocation += bytes;
+    remaining -= bytes;
+    gains.push(Gain(GetChunkGain(candidates[i], chunk), i));
+  }
+
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    strategy->push_back(
+        Allocation(candidates[i].renderer_id, candidates[i].allocation));
+  }
+  return true;
+}
+
 void WebCacheManager::EnactStrategy(const AllocationStrategy& strategy) {
   // Inform each render process of its cache allocation.
   AllocationStrategy::const_iterator allocation = strategy.begin();
@@ -382,38 +583,13 @@ void WebCacheManager::ReviseAllocationStrategy() {
 
   // Compute an allocation strategy.
   //
-  // We attempt various tactics in order of preference.  Our first preference
-  // is not to evict any objects.  If we don't have enough resources, we'll
-  // first try to evict dead data only.  If that fails, we'll just divide the
-  // resources we have evenly.
-  //
-  // We always try to give the active renderers some head room in their
-  // allocations so they can take memory away from an inactive renderer with
-  // a large cache allocation.
-  //
-  // Notice the early exit will prevent attempting less desirable tactics once
-  // we've found a workable strategy.
+  // Once renderers report their misses, we hand out memory where it saves
+  // the most misses.  Until then, or if the live objects of the active
+  // renderers do not fit, we fall back to the allocation tactics.
   AllocationStrategy strategy;
-  if (  // Ideally, we'd like to give the active renderers some headroom and
-        // keep all our current objects.
-      AttemptTactic(KEEP_CURRENT_WITH_HEADROOM, active,
-                    KEEP_CURRENT, inactive, &strategy) ||
-      // If we can't have that, then we first try to evict the dead objects in
-      // the caches of inactive renderers.
-      AttemptTactic(KEEP_CURRENT_WITH_HEADROOM, active,
-                    KEEP_LIVE, inactive, &strategy) ||
-      // Next, we try to keep the live objects in the active renders (with some
-      // room for new objects) and give whatever is left to the inactive
-      // renderers.
-      AttemptTactic(KEEP_LIVE_WITH_HEADROOM, active,
-                    DIVIDE_EVENLY, inactive, &strategy) ||
-      // If we've gotten this far, then we are very tight on memory.  Let's try
-      // to at least keep around the live objects for the active renderers.
-      AttemptTactic(KEEP_LIVE, active, DIVIDE_EVENLY, inactive, &strategy) ||
-      // We're basically out of memory.  The best we can do is just divide up
-      // what we have and soldier on.
-      AttemptTactic(DIVIDE_EVENLY, active, DIVIDE_EVENLY, inactive,
-                    &strategy)) {
+  bool utility_allocation = AttemptUtilityAllocation(&strategy);
+  UMA_HISTOGRAM_BOOLEAN("Cache.UtilityAllocation", utility_allocation);
+  if (utility_allocation || AttemptTactics(active, inactive, &strategy)) {
     // Having found a workable strategy, we enact it.
     EnactStrategy(strategy);
   } else {
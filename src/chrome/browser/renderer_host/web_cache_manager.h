@@ -60,6 +60,12 @@ class WebCacheManager : public content::NotificationObserver {
   void ObserveStats(
       int renderer_id, const blink::WebCache::UsageStats& stats);
 
+  // Along with their statistics, renderers report how many resource loads
+  // missed their cache since the last report, and how many objects their
+  // cache holds.  The cache manager uses these to estimate how much each
+  // renderer would gain from a larger allocation.
+  void ObserveMisses(int renderer_id, size_t misses, size_t object_count);
+
   // The global limit on the number of bytes in all the in-memory caches.
   size_t global_size_limit() const { return global_size_limit_; }
 
@@ -90,6 +96,25 @@ class WebCacheManager : public content::NotificationObserver {
   struct RendererInfo : blink::WebCache::UsageStats {
     // The access time for this renderer.
     base::Time access;
+
+    // Whether the renderer has reported its misses yet.
+    bool has_miss_stats;
+    // Resource loads per second which missed the cache, smoothed over the
+    // recent reports.
+    double miss_rate;
+    // The number of objects in the cache at the last report.
+    size_t object_count;
+    // When misses were last reported, or when the renderer was added.
+    base::Time miss_report;
+  };
+
+  // The utility allocator models the cache of a renderer as serving a working
+  // set of |working_set| bytes, which is referenced |reference_rate| times a
+  // second.  A cache of c bytes then misses
+  // reference_rate * exp(-c / working_set) times a second.
+  struct MissCurve {
+    double reference_rate;
+    double working_set;
   };
 
   typedef std::map<int, RendererInfo> StatsMap;
@@ -178,6 +203,42 @@ class WebCacheManager : public content::NotificationObserver {
                      size_t extra_bytes_to_allocate,
                      AllocationStrategy* strategy);
 
+  // Attempt the allocation tactics in order of preference, and place the
+  // first workable strategy in |strategy|.  Returns |false| if none works.
+  bool AttemptTactics(const blink::WebCache::UsageStats& active_stats,
+                      const blink::WebCache::UsageStats& inactive_stats,
+                      AllocationStrategy* strategy);
+
+  // A renderer being considered by the utility allocator.
+  struct Candidate {
+    int renderer_id;
+    bool active;
+    MissCurve curve;
+    size_t allocation;
+  };
+
+  // Returns the misses per second of a cache of |capacity| bytes.
+  static double GetMissRate(const MissCurve& curve, double capacity);
+
+  // Estimates the miss curve of a renderer from the statistics it reported.
+  static MissCurve GetMissCurve(const RendererInfo& info);
+
+  // Returns the weighted misses per second which giving |candidate| another
+  // |chunk| bytes would save.
+  static double GetChunkGain(const Candidate& candidate, size_t chunk);
+
+  // Compute an allocation strategy which hands out memory by marginal utility
+  // and place the result in |strategy|.  Active renderers first keep their
+  // live objects, and inactive renderers keep theirs if memory is plentiful.
+  // The rest of |global_size_limit_| goes, a chunk at a time, to the renderer
+  // whose modeled misses the chunk reduces the most.  Misses of inactive
+  // renderers count for less, so memory is reclaimed from them first.
+  //
+  // Returns |false| if no renderer has reported its misses yet, or if the
+  // live objects of the active renderers do not fit.  Does not modify
+  // |strategy| on failure.
+  bool AttemptUtilityAllocation(AllocationStrategy* strategy);
+
   // Enact an allocation strategy by informing the renderers of their
   // allocations according to |strategy|.
   void EnactStrategy(const AllocationStrategy& strategy);
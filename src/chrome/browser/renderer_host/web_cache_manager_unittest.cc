@@ -2,8 +2,16 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <map>
+#include <set>
 #include <string>
+#include <vector>
 
+#include "base/basictypes.h"
+#include "base/memory/scoped_vector.h"
 #include "base/message_loop/message_loop.h"
 #include "chrome/browser/renderer_host/web_cache_manager.h"
 #include "content/public/test/test_browser_thread.h"
@@ -81,6 +89,29 @@ class WebCacheManagerTest : public testing::Test {
                      strategy);
   }
 
+  static void SetMissStats(WebCacheManager* h,
+                           int renderer_id,
+                           double miss_rate,
+                           size_t object_count) {
+    WebCacheManager::RendererInfo& info = stats(h)[renderer_id];
+    info.has_miss_stats = true;
+    info.miss_rate = miss_rate;
+    info.object_count = object_count;
+  }
+  static bool AttemptTactics(WebCacheManager* h,
+                             std::list< std::pair<int,size_t> >* strategy) {
+    WebCache::UsageStats active_stats;
+    WebCache::UsageStats inactive_stats;
+    h->GatherStats(h->active_renderers_, &active_stats);
+    h->GatherStats(h->inactive_renderers_, &inactive_stats);
+    return h->AttemptTactics(active_stats, inactive_stats, strategy);
+  }
+  static bool AttemptUtilityAllocation(
+      WebCacheManager* h,
+      std::list< std::pair<int,size_t> >* strategy) {
+    return h->AttemptUtilityAllocation(strategy);
+  }
+
   enum {
     DIVIDE_EVENLY = WebCacheManager::DIVIDE_EVENLY,
     KEEP_CURRENT_WITH_HEADROOM = WebCacheManager::KEEP_CURRENT_WITH_HEADROOM,
@@ -309,3 +340,291 @@ TEST_F(WebCacheManagerTest, AddToStrategyTest) {
   manager()->Remove(kRendererID);
   manager()->Remove(kRendererID2);
 }
+
+TEST_F(WebCacheManagerTest, ObserveMissesTest) {
+  manager()->Add(kRendererID);
+  EXPECT_FALSE(stats(manager())[kRendererID].has_miss_stats);
+
+  manager()->ObserveMisses(kRendererID, 10, 25);
+  EXPECT_TRUE(stats(manager())[kRendererID].has_miss_stats);
+  EXPECT_LT(0.0, stats(manager())[kRendererID].miss_rate);
+  EXPECT_EQ(25U, stats(manager())[kRendererID].object_count);
+
+  // Misses of renderers which are gone are ignored.
+  manager()->ObserveMisses(kRendererID2, 10, 25);
+  EXPECT_EQ(0U, stats(manager()).count(kRendererID2));
+
+  manager()->Remove(kRendererID);
+}
+
+TEST_F(WebCacheManagerTest, UtilityAllocationTest) {
+  manager()->Add(kRendererID);
+  manager()->Add(kRendererID2);
+
+  manager()->ObserveStats(kRendererID, kStats);
+  manager()->ObserveStats(kRendererID2, kStats2);
+
+  const size_t kLimit = 8 * 1024 * 1024;
+  manager()->SetGlobalSizeLimit(kLimit);
+
+  // Without reported misses, the allocation tactics are used.
+  AllocationStrategy strategy;
+  EXPECT_FALSE(AttemptUtilityAllocation(manager(), &strategy));
+  EXPECT_TRUE(strategy.empty());
+
+  // The renderer which misses more gets more memory, and all of the memory is
+  // handed out.
+  SetMissStats(manager(), kRendererID, 8.0, 100);
+  SetMissStats(manager(), kRendererID2, 0.5, 100);
+  EXPECT_TRUE(AttemptUtilityAllocation(manager(), &strategy));
+  EXPECT_EQ(2U, strategy.size());
+
+  size_t total_bytes = 0;
+  size_t allocation = 0;
+  size_t allocation2 = 0;
+  for (AllocationStrategy::iterator iter = strategy.begin();
+       iter != strategy.end(); ++iter) {
+    total_bytes += iter->second;
+    if (iter->first == kRendererID)
+      allocation = iter->second;
+    else if (iter->first == kRendererID2)
+      allocation2 = iter->second;
+    else
+      ADD_FAILURE();  // Unexpected entry in strategy.
+  }
+  EXPECT_EQ(kLimit, total_bytes);
+  EXPECT_LE(kStats.liveSize, allocation);
+  EXPECT_LE(kStats2.liveSize, allocation2);
+  EXPECT_GT(allocation, allocation2);
+
+  manager()->Remove(kRendererID);
+  manager()->Remove(kRendererID2);
+}
+
+TEST_F(WebCacheManagerTest, UtilityAllocationReclaimsInactiveFirstTest) {
+  manager()->Add(kRendererID);
+  manager()->Add(kRendererID2);
+
+  manager()->ObserveActivity(kRendererID);
+  SimulateInactivity(manager(), kRendererID2);
+
+  manager()->ObserveStats(kRendererID, kStats);
+  manager()->ObserveStats(kRendererID2, kStats2);
+  SetMissStats(manager(), kRendererID, 4.0, 50);
+  SetMissStats(manager(), kRendererID2, 4.0, 50);
+
+  // There is not enough memory for the live objects of both renderers.
+  manager()->SetGlobalSizeLimit(kStats.liveSize + kStats2.liveSize / 2);
+
+  AllocationStrategy strategy;
+  EXPECT_TRUE(AttemptUtilityAllocation(manager(), &strategy));
+  EXPECT_EQ(2U, strategy.size());
+  for (AllocationStrategy::iterator iter = strategy.begin();
+       iter != strategy.end(); ++iter) {
+    if (iter->first == kRendererID)
+      EXPECT_LE(kStats.liveSize, iter->second);
+    else if (iter->first == kRendererID2)
+      EXPECT_GT(kStats2.liveSize, iter->second);
+    else
+      ADD_FAILURE();  // Unexpected entry in strategy.
+  }
+
+  manager()->Remove(kRendererID);
+  manager()->Remove(kRendererID2);
+}
+
+namespace {
+
+// Generates the resource loads of a browsing session in one renderer, and
+// replays them against a cache, so that allocations can be scored
+// independently of the model the utility allocator uses.
+class SyntheticSession {
+ public:
+  // |objects| resources of one to four times |object_size| bytes are loaded
+  // |loads| times, with Zipf-distributed popularity of exponent |skew|.
+  SyntheticSession(int index,
+                   int objects,
+                   double skew,
+                   size_t object_size,
+                   size_t loads)
+      : index_(index),
+        object_size_(object_size) {
+    std::vector<double> cdf;
+    double total = 0;
+    for (int i = 0; i < objects; ++i)
+      total += 1.0 / std::pow(i + 1.0, skew);
+    double sum = 0;
+    for (int i = 0; i < objects; ++i) {
+      sum += 1.0 / std::pow(i + 1.0, skew) / total;
+      cdf.push_back(sum);
+    }
+    uint64 random = (index * 7919 + 1) & 0xffffffff;
+    for (size_t i = 0; i < loads; ++i) {
+      random = (random * 1103515245 + 12345) & 0x7fffffff;
+      double u = (random % 1000000) / 1000000.0;
+      int object = static_cast<int>(
+          std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+      loads_.push_back(std::min(object, objects - 1));
+    }
+  }
+
+  const std::vector<int>& loads() const { return loads_; }
+
+  size_t GetObjectSize(int object) const {
+    uint64 hash = static_cast<uint64>(object) * 2654435761U + index_ * 40503;
+    return object_size_ * (1 + (hash >> 7) % 4);
+  }
+
+ private:
+  int index_;
+  size_t object_size_;
+  std::vector<int> loads_;
+};
+
+// A memory cache of |capacity| bytes which evicts the least recently used
+// objects.
+class LRUCache {
+ public:
+  explicit LRUCache(size_t capacity) : capacity_(capacity), size_(0) {}
+
+  // Replays loads [|begin|, |end|) of |session| and returns how many missed.
+  size_t Replay(const SyntheticSession& session, size_t begin, size_t end) {
+    size_t misses = 0;
+    for (size_t i = begin; i < end; ++i) {
+      int object = session.loads()[i];
+      Index::iterator it = index_.find(object);
+      if (it != index_.end()) {
+        order_.splice(order_.begin(), order_, it->second);
+        continue;
+      }
+      ++misses;
+      size_t size = session.GetObjectSize(object);
+      if (size > capacity_)
+        continue;
+      while (size_ + size > capacity_) {
+        size_ -= order_.back().second;
+        index_.erase(order_.back().first);
+        order_.pop_back();
+      }
+      order_.push_front(std::make_pair(object, size));
+      index_[object] = order_.begin();
+      size_ += size;
+    }
+    return misses;
+  }
+
+  // Returns the bytes of cached objects which were among |objects|.
+  size_t GetSizeOf(const std::set<int>& objects) const {
+    size_t size = 0;
+    for (Order::const_iterator it = order_.begin(); it != order_.end(); ++it) {
+      if (objects.count(it->first))
+        size += it->second;
+    }
+    return size;
+  }
+
+  size_t size() const { return size_; }
+  size_t object_count() const { return order_.size(); }
+
+ private:
+  typedef std::list<std::pair<int, size_t> > Order;
+  typedef std::map<int, Order::iterator> Index;
+
+  size_t capacity_;
+  size_t size_;
+  Order order_;
+  Index index_;
+};
+
+}  // namespace
+
+// Generates a minute of loads in each of three active and five inactive
+// renderers, all of which had 1 MB of cache, and reports the stats the
+// renderers would have seen.  Then scores both allocators by the misses of
+// all of the renderers over the next minute, replayed against LRU caches of
+// the allocated sizes, across a range of global limits.
+TEST_F(WebCacheManagerTest, UtilityAllocationSimulationTest) {
+  struct SessionParams {
+    bool active;
+    int objects;
+    double skew;
+    size_t object_size;
+    size_t loads_per_second;
+  };
+  const size_t kKB = 1024;
+  const size_t kMB = 1024 * kKB;
+  const SessionParams kSessions[] = {
+    { true, 400, 0.9, 24 * kKB, 20 },
+    { true, 150, 1.2, 16 * kKB, 6 },
+    { true, 800, 0.7, 8 * kKB, 15 },
+    { false, 300, 1.0, 32 * kKB, 1 },
+    { false, 200, 0.8, 16 * kKB, 1 },
+    { false, 100, 1.1, 8 * kKB, 1 },
+    { false, 60, 1.0, 24 * kKB, 0 },
+    { false, 30, 0.9, 16 * kKB, 0 },
+  };
+  const int kSeconds = 60;
+  // Background tabs still see a few loads.
+  const size_t kMinLoads = 20;
+  const size_t kInitialCapacity = 1 * kMB;
+
+  ScopedVector<SyntheticSession> sessions;
+  std::vector<size_t> observed_loads;
+  for (size_t i = 0; i < arraysize(kSessions); ++i) {
+    const SessionParams& params = kSessions[i];
+    const size_t loads =
+        std::max(params.loads_per_second * kSeconds, kMinLoads);
+    sessions.push_back(new SyntheticSession(static_cast<int>(i),
+                                            params.objects, params.skew,
+                                            params.object_size, 2 * loads));
+    observed_loads.push_back(loads);
+
+    LRUCache cache(kInitialCapacity);
+    const size_t misses = cache.Replay(*sessions[i], 0, loads);
+    std::set<int> recent(sessions[i]->loads().begin() + loads - loads / 10,
+                         sessions[i]->loads().begin() + loads);
+    const size_t live_size = cache.GetSizeOf(recent);
+
+    const int renderer_id = kRendererID + static_cast<int>(i);
+    manager()->Add(renderer_id);
+    WebCache::UsageStats usage = { 0, kInitialCapacity / 2, kInitialCapacity,
+                                   live_size, cache.size() - live_size };
+    manager()->ObserveStats(renderer_id, usage);
+    SetMissStats(manager(), renderer_id,
+                 static_cast<double>(misses) / kSeconds,
+                 cache.object_count());
+    if (!params.active)
+      SimulateInactivity(manager(), renderer_id);
+  }
+
+  size_t total_tactics_misses = 0;
+  size_t total_utility_misses = 0;
+  const size_t kLimits[] = { 4 * kMB, 8 * kMB, 16 * kMB, 32 * kMB };
+  for (size_t i = 0; i < arraysize(kLimits); ++i) {
+    manager()->SetGlobalSizeLimit(kLimits[i]);
+
+    AllocationStrategy strategies[2];
+    ASSERT_TRUE(AttemptTactics(manager(), &strategies[0]));
+    ASSERT_TRUE(AttemptUtilityAllocation(manager(), &strategies[1]));
+
+    size_t misses[2] = { 0, 0 };
+    for (size_t j = 0; j < arraysize(strategies); ++j) {
+      for (AllocationStrategy::iterator iter = strategies[j].begin();
+           iter != strategies[j].end(); ++iter) {
+        const size_t session = iter->first - kRendererID;
+        ASSERT_LT(session, sessions.size());
+        LRUCache cache(iter->second);
+        cache.Replay(*sessions[session], 0, observed_loads[session]);
+        misses[j] += cache.Replay(*sessions[session], observed_loads[session],
+                                  2 * observed_loads[session]);
+      }
+    }
+    EXPECT_LE(misses[1], misses[0]) << "Global limit: " << kLimits[i];
+    total_tactics_misses += misses[0];
+    total_utility_misses += misses[1];
+  }
+  EXPECT_LT(total_utility_misses, total_tactics_misses);
+
+  for (size_t i = 0; i < arraysize(kSessions); ++i)
+    manager()->Remove(kRendererID + static_cast<int>(i));
+}
@@ -8,6 +8,7 @@
 #include "base/command_line.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
 #include "base/message_loop/message_loop.h"
 #include "base/metrics/histogram.h"
 #include "base/metrics/sparse_histogram.h"
@@ -21,6 +22,7 @@
 #include "chrome/common/pref_names.h"
 #include "chrome/common/safe_browsing/client_model.pb.h"
 #include "chrome/common/safe_browsing/csd.pb.h"
+#include "chrome/common/safe_browsing/flat_client_model.h"
 #include "chrome/common/safe_browsing/safebrowsing_messages.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/notification_service.h"
@@ -97,6 +99,7 @@ ClientSideDetectionService::CacheState::CacheState(bool phish, base::Time time)
 ClientSideDetectionService::ClientSideDetectionService(
     net::URLRequestContextGetter* request_context_getter)
     : enabled_(false),
+      model_image_size_(0),
       weak_factory_(this),
       request_context_getter_(request_context_getter) {
   registrar_.Add(this, content::NOTIFICATION_RENDERER_PROCESS_CREATED,
@@ -252,6 +255,13 @@ void ClientSideDetectionService::SendModelToProcess(
   std::string model;
   if (profile->GetPrefs()->GetBoolean(prefs::kSafeBrowsingEnabled)) {
     VLOG(2) << "Sending phishing model to RenderProcessHost @" << process;
+    base::SharedMemoryHandle handle;
+    if (model_image_.get() &&
+        model_image_->ShareReadOnlyToProcess(process->GetHandle(), &handle)) {
+      process->Send(
+          new SafeBrowsingMsg_SetPhishingModelImage(handle, model_image_size_));
+      return;
+    }
     model = model_str_;
   } else {
     VLOG(2) << "Disabling client-side phishing detection for "
@@ -260,6 +270,33 @@ void ClientSideDetectionService::SendModelToProcess(
   process->Send(new SafeBrowsingMsg_SetPhishingModel(model));
 }
 
+void ClientSideDetectionService::CreateModelImage() {
+  DCHECK(model_.get());
+  model_image_.reset();
+  model_image_size_ = 0;
+
+  std::string image;
+  if (!FlatClientModel::Build(*model_, &image))
+    return;
+
+  // Renderers only get read-only handles, so a compromised renderer cannot
+  // change the model used by the others.
+  base::SharedMemoryCreateOptions options;
+  options.size = image.size();
+  options.share_read_only = true;
+  scoped_ptr<base::SharedMemory> shared_memory(new base::SharedMemory());
+  if (!shared_memory->Create(options) || !shared_memory->Map(image.size()))
+    return;
+  memcpy(shared_memory->memory(), image.data(), image.size());
+  // The browser never reads the image, only shares it.
+  shared_memory->Unmap();
+
+  UMA_HISTOGRAM_COUNTS("SBClientPhishing.ModelImageKilobytes",
+                       image.size() / 1024);
+  model_image_.swap(shared_memory);
+  model_image_size_ = image.size();
+}
+
 void ClientSideDetectionService::SendModelToRenderers() {
   for (content::RenderProcessHost::iterator i(
           content::RenderProcessHost::AllHostsIterator());
@@ -439,6 +476,7 @@ void ClientSideDetectionService::HandleModelResponse(
     // The model is valid => replace the existing model with the new one.
     model_str_.assign(data);
     model_.swap(model);
+    CreateModelImage();
     model_status = MODEL_SUCCESS;
   }
   EndFetchModel(model_status);
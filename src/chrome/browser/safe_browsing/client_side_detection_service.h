@@ -37,6 +37,7 @@
 class SafeBrowsingService;
 
 namespace base {
+class SharedMemory;
 class TimeDelta;
 }
 
@@ -280,6 +281,10 @@ class ClientSideDetectionService : public net::URLFetcherDelegate,
   // valid hashes in the model.
   static bool ModelHasValidHashIds(const ClientSideModel& model);
 
+  // Flattens |model_| into |model_image_|.  On failure |model_image_| is
+  // cleared, and renderers are sent |model_str_| instead.
+  void CreateModelImage();
+
   // Returns the URL that will be used for phishing requests.
   static GURL GetClientReportUrl(const std::string& report_url);
 
@@ -289,6 +294,12 @@ class ClientSideDetectionService : public net::URLFetcherDelegate,
 
   std::string model_str_;
   scoped_ptr<ClientSideModel> model_;
+
+  // |model_| flattened into a FlatClientModel image, which renderers map
+  // instead of each parsing their own copy of |model_str_|.  NULL if the
+  // image could not be created.
+  scoped_ptr<base::SharedMemory> model_image_;
+  uint32 model_image_size_;
   scoped_ptr<base::TimeDelta> model_max_age_;
   scoped_ptr<net::URLFetcher> model_fetcher_;
 
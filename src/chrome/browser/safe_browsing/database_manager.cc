@@ -396,6 +396,137 @@ bool SafeBrowsingDatabaseManager::CheckBrowseUrl(const GURL& url,
   return false;
 }
 
+bool SafeBrowsingDatabaseManager::CheckBrowseUrlInBatch(const GURL& url,
+                                                        Client* client) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (!enabled_)
+    return true;
+
+  if (!CanCheckUrl(url))
+    return true;
+
+  std::vector<SBThreatType> expected_threats;
+  expected_threats.push_back(SB_THREAT_TYPE_URL_MALWARE);
+  expected_threats.push_back(SB_THREAT_TYPE_URL_PHISHING);
+
+  const base::TimeTicks start = base::TimeTicks::Now();
+  if (!MakeDatabaseAvailable()) {
+    // DatabaseLoadComplete() checks the queue as one batch.
+    QueuedCheck queued_check(safe_browsing_util::MALWARE,  // or PHISH
+                             client,
+                             url,
+                             expected_threats,
+                             start);
+    queued_checks_.push_back(queued_check);
+    return false;
+  }
+
+  // The prefix set is checked here, as in CheckBrowseUrl(), so that only the
+  // URLs which match a prefix wait for the batch.
+  std::vector<SBPrefix> prefix_hits;
+  std::vector<SBFullHashResult> cache_hits;
+
+  bool prefix_match =
+      database_->ContainsBrowseUrl(url, &prefix_hits, &cache_hits);
+
+  UMA_HISTOGRAM_TIMES("SB2.FilterCheck", base::TimeTicks::Now() - start);
+
+  if (!prefix_match)
+    return true;  // URL is okay.
+
+  // The subresource requests of a page arrive in a burst of IO thread tasks,
+  // so one task posted for the first of them runs after most of the others.
+  if (batched_checks_.empty()) {
+    BrowserThread::PostTask(
+        BrowserThread::IO, FROM_HERE,
+        base::Bind(&SafeBrowsingDatabaseManager::RunBrowseUrlBatch, this));
+  }
+  batched_checks_.push_back(QueuedCheck(safe_browsing_util::MALWARE,
+                                        client,
+                                        url,
+                                        expected_threats,
+                                        start));
+  return false;
+}
+
+void SafeBrowsingDatabaseManager::CheckBrowseUrls(
+    const std::vector<GURL>& urls,
+    const std::vector<Client*>& clients,
+    std::vector<bool>* safe) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  DCHECK_EQ(urls.size(), clients.size());
+  safe->assign(urls.size(), true);
+  if (!enabled_)
+    return;
+
+  // Indices of the URLs which need to be checked against the database.
+  std::vector<GURL> check_urls;
+  std::vector<size_t> check_indices;
+  for (size_t i = 0; i < urls.size(); ++i) {
+    if (CanCheckUrl(urls[i])) {
+      check_urls.push_back(urls[i]);
+      check_indices.push_back(i);
+    }
+  }
+  if (check_urls.empty())
+    return;
+
+  std::vector<SBThreatType> expected_threats;
+  expected_threats.push_back(SB_THREAT_TYPE_URL_MALWARE);
+  expected_threats.push_back(SB_THREAT_TYPE_URL_PHISHING);
+
+  const base::TimeTicks start = base::TimeTicks::Now();
+  if (!MakeDatabaseAvailable()) {
+    for (size_t i = 0; i < check_indices.size(); ++i) {
+      const size_t index = check_indices[i];
+      QueuedCheck queued_check(safe_browsing_util::MALWARE,  // or PHISH
+                               clients[index],
+                               urls[index],
+                               expected_threats,
+                               start);
+      queued_checks_.push_back(queued_check);
+      (*safe)[index] = false;
+    }
+    return;
+  }
+
+  std::vector<std::vector<SBPrefix> > prefix_hits;
+  std::vector<std::vector<SBFullHashResult> > cache_hits;
+
+  bool prefix_match =
+      database_->ContainsBrowseUrls(check_urls, &prefix_hits, &cache_hits);
+
+  UMA_HISTOGRAM_TIMES("SB2.FilterCheckBatch", base::TimeTicks::Now() - start);
+  UMA_HISTOGRAM_COUNTS("SB2.FilterCheckBatchSize", check_urls.size());
+
+  if (!prefix_match)
+    return;  // URLs are okay.
+
+  for (size_t i = 0; i < check_urls.size(); ++i) {
+    if (prefix_hits[i].empty())
+      continue;  // URL is okay.
+
+    // Needs to be asynchronous, since we could be in the constructor of a
+    // ResourceDispatcherHost event handler which can't pause there.
+    SafeBrowsingCheck* check =
+        new SafeBrowsingCheck(std::vector<GURL>(1, check_urls[i]),
+                              std::vector<SBFullHash>(),
+                              clients[check_indices[i]],
+                              safe_browsing_util::MALWARE,
+                              expected_threats);
+    check->need_get_hash = cache_hits[i].empty();
+    check->prefix_hits.swap(prefix_hits[i]);
+    check->cache_hits.swap(cache_hits[i]);
+    checks_.insert(check);
+
+    BrowserThread::PostTask(
+        BrowserThread::IO, FROM_HERE,
+        base::Bind(&SafeBrowsingDatabaseManager::OnCheckDone, this, check));
+
+    (*safe)[check_indices[i]] = false;
+  }
+}
+
 void SafeBrowsingDatabaseManager::CancelCheck(Client* client) {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
   for (CurrentChecks::iterator i = checks_.begin(); i != checks_.end(); ++i) {
@@ -407,13 +538,23 @@ void SafeBrowsingDatabaseManager::CancelCheck(Client* client) {
   }
 
   // Scan the queued clients store. Clients may be here if they requested a URL
-  // check before the database has finished loading.
-  for (std::deque<QueuedCheck>::iterator it(queued_checks_.begin());
-       it != queued_checks_.end(); ) {
+  // check before the database has finished loading, or are waiting for a batch
+  // to be checked or answered.
+  EraseQueuedChecks(client, &queued_checks_);
+  EraseQueuedChecks(client, &batched_checks_);
+  EraseQueuedChecks(client, &safe_checks_);
+}
+
+// static
+void SafeBrowsingDatabaseManager::EraseQueuedChecks(
+    Client* client,
+    std::deque<QueuedCheck>* checks) {
+  for (std::deque<QueuedCheck>::iterator it(checks->begin());
+       it != checks->end(); ) {
     // In this case it's safe to delete matches entirely since nothing has a
     // pointer to them.
     if (it->client == client)
-      it = queued_checks_.erase(it);
+      it = checks->erase(it);
     else
       ++it;
   }
@@ -554,7 +695,12 @@ void SafeBrowsingDatabaseManager::DoStopOnIOThread() {
 
   enabled_ = false;
 
-  // Delete queued checks, calling back any clients with 'SB_THREAT_TYPE_SAFE'.
+  // Delete queued and batched checks, calling back any clients with
+  // 'SB_THREAT_TYPE_SAFE'.
+  queued_checks_.insert(queued_checks_.end(),
+                        batched_checks_.begin(),
+                        batched_checks_.end());
+  batched_checks_.clear();
   while (!queued_checks_.empty()) {
     QueuedCheck queued = queued_checks_.front();
     if (queued.client) {
@@ -764,26 +910,66 @@ void SafeBrowsingDatabaseManager::DatabaseLoadComplete() {
   if (queued_checks_.empty())
     return;
 
-  // If the database isn't already available, calling CheckUrl() in the loop
-  // below will add the check back to the queue, and we'll infinite-loop.
+  // If the database isn't already available, calling CheckBrowseUrls() below
+  // will add the checks back to the queue, and we'll lose track of them.
   DCHECK(DatabaseAvailable());
+
+  // The queue mostly holds the subresources of pages which started loading
+  // before the database was ready, so check it as one batch.
+  std::vector<QueuedCheck> checks;
   while (!queued_checks_.empty()) {
-    QueuedCheck check = queued_checks_.front();
+    const QueuedCheck& check = queued_checks_.front();
     DCHECK(!check.start.is_null());
     HISTOGRAM_TIMES("SB.QueueDelay", base::TimeTicks::Now() - check.start);
-    // If CheckUrl() determines the URL is safe immediately, it doesn't call the
-    // client's handler function (because normally it's being directly called by
-    // the client).  Since we're not the client, we have to convey this result.
-    if (check.client && CheckBrowseUrl(check.url, check.client)) {
-      SafeBrowsingCheck sb_check(std::vector<GURL>(1, check.url),
-                                 std::vector<SBFullHash>(),
-                                 check.client,
-                                 check.check_type,
-                                 check.expected_threats);
-      check.client->OnSafeBrowsingResult(sb_check);
-    }
+    if (check.client)
+      checks.push_back(check);
     queued_checks_.pop_front();
   }
+  RunBrowseUrlChecks(checks);
+}
+
+void SafeBrowsingDatabaseManager::RunBrowseUrlBatch() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  // DoStopOnIOThread() answers the batch if the service stopped first.
+  std::vector<QueuedCheck> checks(batched_checks_.begin(),
+                                  batched_checks_.end());
+  batched_checks_.clear();
+  RunBrowseUrlChecks(checks);
+}
+
+void SafeBrowsingDatabaseManager::RunBrowseUrlChecks(
+    const std::vector<QueuedCheck>& checks) {
+  if (checks.empty())
+    return;
+
+  std::vector<GURL> urls;
+  std::vector<Client*> clients;
+  for (size_t i = 0; i < checks.size(); ++i) {
+    urls.push_back(checks[i].url);
+    clients.push_back(checks[i].client);
+  }
+  std::vector<bool> safe;
+  CheckBrowseUrls(urls, clients, &safe);
+
+  // If CheckBrowseUrls() determines a URL is safe immediately, it doesn't call
+  // the client's handler function (because normally it's being directly called
+  // by the client).  Since we're not the client, we have to convey this result.
+  // The safe checks are answered through |safe_checks_| so that a client
+  // cancelled by an earlier callback is dropped by CancelCheck().
+  for (size_t i = 0; i < checks.size(); ++i) {
+    if (safe[i])
+      safe_checks_.push_back(checks[i]);
+  }
+  while (!safe_checks_.empty()) {
+    QueuedCheck check = safe_checks_.front();
+    safe_checks_.pop_front();
+    SafeBrowsingCheck sb_check(std::vector<GURL>(1, check.url),
+                               std::vector<SBFullHash>(),
+                               check.client,
+                               check.check_type,
+                               check.expected_threats);
+    check.client->OnSafeBrowsingResult(sb_check);
+  }
 }
 
 void SafeBrowsingDatabaseManager::AddDatabaseChunks(
@@ -129,6 +129,21 @@ class SafeBrowsingDatabaseManager
   // result when it is ready.
   virtual bool CheckBrowseUrl(const GURL& url, Client* client);
 
+  // Like CheckBrowseUrl(), but a URL which matches a prefix in the database is
+  // checked together with the other matches queued in the same burst of IO
+  // thread tasks, as the subresources of a page are.  URLs which match no
+  // prefix are found safe synchronously, so only the matches are deferred.
+  // When false is returned the client is always called back, safe or not.
+  virtual bool CheckBrowseUrlInBatch(const GURL& url, Client* client);
+
+  // Batched CheckBrowseUrl(), checking |urls[i]| on behalf of |clients[i]|.
+  // Work is shared between URLs, so this is cheaper than checking them one at
+  // a time when they come from the same page.  |safe| is filled with the
+  // per-URL return value of CheckBrowseUrl().
+  void CheckBrowseUrls(const std::vector<GURL>& urls,
+                       const std::vector<Client*>& clients,
+                       std::vector<bool>* safe);
+
   // Check if the prefix for |url| is in safebrowsing download add lists.
   // Result will be passed to callback in |client|.
   virtual bool CheckDownloadUrl(const std::vector<GURL>& url_chain,
@@ -272,6 +287,17 @@ class SafeBrowsingDatabaseManager
   // checks them.
   void DatabaseLoadComplete();
 
+  // Checks the URLs queued by CheckBrowseUrlInBatch().
+  void RunBrowseUrlBatch();
+
+  // Checks |checks| as one batch, and calls back the clients of those found
+  // safe.  The others are called back when their checks complete.
+  void RunBrowseUrlChecks(const std::vector<QueuedCheck>& checks);
+
+  // Removes the checks of |client| from |checks|.
+  static void EraseQueuedChecks(Client* client,
+                                std::deque<QueuedCheck>* checks);
+
   // Called on the database thread to add/remove chunks and host keys.
   // Callee will free the data when it's done.
   void AddDatabaseChunks(const std::string& list, SBChunkList* chunks,
@@ -390,6 +416,11 @@ class SafeBrowsingDatabaseManager
 
   std::deque<QueuedCheck> queued_checks_;
 
+  // Checks waiting for RunBrowseUrlBatch(), and checks found safe which are
+  // waiting for their clients to be called back.
+  std::deque<QueuedCheck> batched_checks_;
+  std::deque<QueuedCheck> safe_checks_;
+
   // Timeout to use for safe browsing checks.
   base::TimeDelta check_timeout_;
 
@@ -2,12 +2,15 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <set>
 #include <string>
 #include <vector>
 
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/run_loop.h"
 #include "chrome/browser/safe_browsing/database_manager.h"
+#include "chrome/browser/safe_browsing/safe_browsing_database.h"
 #include "chrome/browser/safe_browsing/safe_browsing_service.h"
 #include "content/public/test/test_browser_thread_bundle.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -16,12 +19,117 @@
 
 using content::TestBrowserThreadBundle;
 
+namespace {
+
+// Records the browse URL results it is called back with.
+class TestClient : public SafeBrowsingDatabaseManager::Client {
+ public:
+  TestClient() {}
+  virtual ~TestClient() {}
+
+  virtual void OnCheckBrowseUrlResult(const GURL& url,
+                                      SBThreatType threat_type) OVERRIDE {
+    urls_.push_back(url);
+  }
+
+  const std::vector<GURL>& urls() const { return urls_; }
+
+ private:
+  std::vector<GURL> urls_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestClient);
+};
+
+// Matches a prefix for the browse URLs it is given, and nothing else.
+class TestSafeBrowsingDatabase : public SafeBrowsingDatabase {
+ public:
+  TestSafeBrowsingDatabase() {}
+  virtual ~TestSafeBrowsingDatabase() {}
+
+  void AddBrowseUrl(const GURL& url) { browse_urls_.insert(url); }
+
+  virtual void Init(const base::FilePath& filename) OVERRIDE {}
+  virtual bool ResetDatabase() OVERRIDE { return true; }
+  virtual bool ContainsBrowseUrl(
+      const GURL& url,
+      std::vector<SBPrefix>* prefix_hits,
+      std::vector<SBFullHashResult>* cache_hits) OVERRIDE {
+    prefix_hits->clear();
+    cache_hits->clear();
+    if (!browse_urls_.count(url))
+      return false;
+    prefix_hits->push_back(0);
+    return true;
+  }
+  virtual bool ContainsDownloadUrl(
+      const std::vector<GURL>& urls,
+      std::vector<SBPrefix>* prefix_hits) OVERRIDE {
+    return false;
+  }
+  virtual bool ContainsCsdWhitelistedUrl(const GURL& url) OVERRIDE {
+    return false;
+  }
+  virtual bool ContainsDownloadWhitelistedUrl(const GURL& url) OVERRIDE {
+    return false;
+  }
+  virtual bool ContainsDownloadWhitelistedString(
+      const std::string& str) OVERRIDE {
+    return false;
+  }
+  virtual bool ContainsExtensionPrefixes(
+      const std::vector<SBPrefix>& prefixes,
+      std::vector<SBPrefix>* prefix_hits) OVERRIDE {
+    return false;
+  }
+  virtual bool ContainsSideEffectFreeWhitelistUrl(const GURL& url) OVERRIDE {
+    return false;
+  }
+  virtual bool ContainsMalwareIP(const std::string& ip_address) OVERRIDE {
+    return false;
+  }
+  virtual bool UpdateStarted(std::vector<SBListChunkRanges>* lists) OVERRIDE {
+    return false;
+  }
+  virtual void InsertChunks(const std::string& list_name,
+                            const SBChunkList& chunks) OVERRIDE {}
+  virtual void DeleteChunks(
+      const std::vector<SBChunkDelete>& chunk_deletes) OVERRIDE {}
+  virtual void UpdateFinished(bool update_succeeded) OVERRIDE {}
+  virtual void CacheHashResults(
+      const std::vector<SBPrefix>& prefixes,
+      const std::vector<SBFullHashResult>& full_hits,
+      const base::TimeDelta& cache_lifetime) OVERRIDE {}
+  virtual bool IsMalwareIPMatchKillSwitchOn() OVERRIDE { return false; }
+  virtual bool IsCsdWhitelistKillSwitchOn() OVERRIDE { return false; }
+
+ private:
+  std::set<GURL> browse_urls_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestSafeBrowsingDatabase);
+};
+
+}  // namespace
+
 class SafeBrowsingDatabaseManagerTest : public PlatformTest {
  public:
   bool RunSBHashTest(const safe_browsing_util::ListType list_type,
                      const std::vector<SBThreatType>& expected_threats,
                      const std::string& result_list);
 
+ protected:
+  void SetEnabled(SafeBrowsingDatabaseManager* db_manager, bool enabled) {
+    db_manager->enabled_ = enabled;
+  }
+
+  void SetDatabase(SafeBrowsingDatabaseManager* db_manager,
+                   SafeBrowsingDatabase* database) {
+    db_manager->database_ = database;
+  }
+
+  size_t BatchedCheckCount(SafeBrowsingDatabaseManager* db_manager) {
+    return db_manager->batched_checks_.size();
+  }
+
  private:
   TestBrowserThreadBundle thread_bundle_;
 };
@@ -78,3 +186,48 @@ TEST_F(SafeBrowsingDatabaseManagerTest, CheckCorrespondsListType) {
                             multiple_threats,
                             safe_browsing_util::kMalwareList));
 }
+
+// URLs checked in a batch are found safe right away unless they match a prefix.
+// Those which do are queued until the batch runs, cancelled checks are dropped
+// from it, and the remaining clients are called back.
+TEST_F(SafeBrowsingDatabaseManagerTest, CheckBrowseUrlInBatch) {
+  scoped_refptr<SafeBrowsingService> sb_service(
+      SafeBrowsingService::CreateSafeBrowsingService());
+  scoped_refptr<SafeBrowsingDatabaseManager> db_manager(
+      new SafeBrowsingDatabaseManager(sb_service));
+  TestSafeBrowsingDatabase database;
+  database.AddBrowseUrl(GURL("http://www.example.com/a.js"));
+  database.AddBrowseUrl(GURL("http://www.example.com/b.js"));
+  database.AddBrowseUrl(GURL("http://www.example.com/c.js"));
+  SetDatabase(db_manager.get(), &database);
+
+  // URLs which cannot be checked, or match no prefix, are safe right away.
+  TestClient client1, client2, client3;
+  SetEnabled(db_manager.get(), true);
+  EXPECT_TRUE(db_manager->CheckBrowseUrlInBatch(GURL("data:text/html,a"),
+                                                &client1));
+  EXPECT_TRUE(db_manager->CheckBrowseUrlInBatch(
+      GURL("http://www.example.com/d.js"), &client1));
+  EXPECT_EQ(0u, BatchedCheckCount(db_manager.get()));
+  EXPECT_FALSE(db_manager->CheckBrowseUrlInBatch(
+      GURL("http://www.example.com/a.js"), &client1));
+  EXPECT_FALSE(db_manager->CheckBrowseUrlInBatch(
+      GURL("http://www.example.com/b.js"), &client2));
+  EXPECT_FALSE(db_manager->CheckBrowseUrlInBatch(
+      GURL("http://www.example.com/c.js"), &client3));
+  EXPECT_EQ(3u, BatchedCheckCount(db_manager.get()));
+
+  db_manager->CancelCheck(&client2);
+  EXPECT_EQ(2u, BatchedCheckCount(db_manager.get()));
+
+  // The manager finds everything safe once disabled, without a database.
+  SetEnabled(db_manager.get(), false);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(0u, BatchedCheckCount(db_manager.get()));
+  ASSERT_EQ(1u, client1.urls().size());
+  EXPECT_EQ(GURL("http://www.example.com/a.js"), client1.urls()[0]);
+  EXPECT_TRUE(client2.urls().empty());
+  ASSERT_EQ(1u, client3.urls().size());
+  EXPECT_EQ(GURL("http://www.example.com/c.js"), client3.urls()[0]);
+  SetDatabase(db_manager.get(), NULL);
+}
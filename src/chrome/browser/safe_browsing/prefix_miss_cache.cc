@@ -0,0 +1,65 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/safe_browsing/prefix_miss_cache.h"
+
+#include <string.h>
+
+namespace safe_browsing {
+
+PrefixMissCache::PrefixMissCache()
+    : contains_zero_(0),
+      count_(0) {
+  memset(slots_, 0, sizeof(slots_));
+}
+
+PrefixMissCache::~PrefixMissCache() {}
+
+void PrefixMissCache::Insert(SBPrefix prefix) {
+  const base::subtle::Atomic32 value =
+      static_cast<base::subtle::Atomic32>(prefix);
+  if (value == 0) {
+    if (base::subtle::NoBarrier_CompareAndSwap(&contains_zero_, 0, 1) == 0)
+      base::subtle::NoBarrier_AtomicIncrement(&count_, 1);
+    return;
+  }
+
+  for (size_t i = 0; i < kMaxProbes; ++i) {
+    base::subtle::Atomic32* slot =
+        &slots_[(prefix + i) & (kCapacity - 1)];
+    const base::subtle::Atomic32 previous =
+        base::subtle::Release_CompareAndSwap(slot, 0, value);
+    if (previous == 0) {
+      base::subtle::NoBarrier_AtomicIncrement(&count_, 1);
+      return;
+    }
+    if (previous == value)
+      return;
+  }
+}
+
+bool PrefixMissCache::Contains(SBPrefix prefix) const {
+  const base::subtle::Atomic32 value =
+      static_cast<base::subtle::Atomic32>(prefix);
+  if (value == 0)
+    return base::subtle::NoBarrier_Load(&contains_zero_) != 0;
+
+  for (size_t i = 0; i < kMaxProbes; ++i) {
+    const base::subtle::Atomic32 current =
+        base::subtle::Acquire_Load(&slots_[(prefix + i) & (kCapacity - 1)]);
+    if (current == value)
+      return true;
+
+    // Slots are never cleared, so an empty slot ends the probe sequence.
+    if (current == 0)
+      return false;
+  }
+  return false;
+}
+
+size_t PrefixMissCache::size() const {
+  return static_cast<size_t>(base::subtle::NoBarrier_Load(&count_));
+}
+
+}  // namespace safe_browsing
@@ -0,0 +1,61 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// A fixed-capacity set of |SBPrefix| items which can be read and written
+// from any thread without locking.  Used to remember prefixes for which a
+// gethash request returned no full hashes, so that lookups on the IO thread
+// do not have to contend with the database thread to consult it.
+//
+// The table is open-addressed with linear probing over a bounded window.
+// Prefixes are the leading bits of SHA-256 hashes, so they are used as their
+// own hash.  Insertions which find no free slot in the window are dropped.
+// That is fail-safe: a dropped miss only costs a repeated gethash request.
+// Entries are never removed; the owner discards the whole cache when the
+// prefix set it describes is replaced.
+
+#ifndef CHROME_BROWSER_SAFE_BROWSING_PREFIX_MISS_CACHE_H_
+#define CHROME_BROWSER_SAFE_BROWSING_PREFIX_MISS_CACHE_H_
+
+#include "base/atomicops.h"
+#include "base/basictypes.h"
+#include "chrome/browser/safe_browsing/safe_browsing_util.h"
+
+namespace safe_browsing {
+
+class PrefixMissCache {
+ public:
+  PrefixMissCache();
+  ~PrefixMissCache();
+
+  // Add |prefix| to the set.  May silently drop |prefix| if the table is
+  // too full around its home slot.
+  void Insert(SBPrefix prefix);
+
+  // |true| if |prefix| was previously inserted and not dropped.
+  bool Contains(SBPrefix prefix) const;
+
+  // Number of prefixes held.  May lag concurrent insertions.
+  size_t size() const;
+  bool empty() const { return size() == 0; }
+
+ private:
+  // 4096 slots is 16k, which comfortably holds the misses accumulated
+  // between updates.  Must be a power of two.
+  static const size_t kCapacity = 4096;
+
+  // Longest probe sequence.  Eight slots is half a cache line.
+  static const size_t kMaxProbes = 8;
+
+  // Slot value 0 marks an empty slot, so the prefix 0 is tracked by
+  // |contains_zero_|.
+  base::subtle::Atomic32 slots_[kCapacity];
+  base::subtle::Atomic32 contains_zero_;
+  base::subtle::Atomic32 count_;
+
+  DISALLOW_COPY_AND_ASSIGN(PrefixMissCache);
+};
+
+}  // namespace safe_browsing
+
+#endif  // CHROME_BROWSER_SAFE_BROWSING_PREFIX_MISS_CACHE_H_
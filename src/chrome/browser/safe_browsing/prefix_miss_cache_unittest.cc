@@ -0,0 +1,58 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/safe_browsing/prefix_miss_cache.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace safe_browsing {
+
+TEST(PrefixMissCacheTest, Empty) {
+  PrefixMissCache cache;
+  EXPECT_TRUE(cache.empty());
+  EXPECT_FALSE(cache.Contains(0u));
+  EXPECT_FALSE(cache.Contains(1u));
+  EXPECT_FALSE(cache.Contains(static_cast<SBPrefix>(-1)));
+}
+
+TEST(PrefixMissCacheTest, InsertAndContains) {
+  PrefixMissCache cache;
+  cache.Insert(0u);
+  cache.Insert(17u);
+  cache.Insert(static_cast<SBPrefix>(-1));
+  EXPECT_EQ(3u, cache.size());
+
+  EXPECT_TRUE(cache.Contains(0u));
+  EXPECT_TRUE(cache.Contains(17u));
+  EXPECT_TRUE(cache.Contains(static_cast<SBPrefix>(-1)));
+  EXPECT_FALSE(cache.Contains(18u));
+
+  // Duplicates are not counted twice.
+  cache.Insert(0u);
+  cache.Insert(17u);
+  EXPECT_EQ(3u, cache.size());
+}
+
+// Prefixes which share a home slot probe forward, and once the probe window
+// is full further insertions are dropped rather than displacing anything.
+TEST(PrefixMissCacheTest, Collisions) {
+  PrefixMissCache cache;
+  const SBPrefix kStride = 1u << 20;
+  for (SBPrefix i = 1; i <= 20; ++i) {
+    cache.Insert(i * kStride);
+  }
+  EXPECT_LT(cache.size(), 20u);
+  EXPECT_GT(cache.size(), 0u);
+
+  size_t found = 0;
+  for (SBPrefix i = 1; i <= 20; ++i) {
+    if (cache.Contains(i * kStride))
+      ++found;
+  }
+  EXPECT_EQ(cache.size(), found);
+  EXPECT_TRUE(cache.Contains(kStride));
+  EXPECT_FALSE(cache.Contains(21 * kStride));
+}
+
+}  // namespace safe_browsing
@@ -81,16 +81,26 @@ size_t EstimateFinalCount(SBPrefix current_prefix, size_t current_count) {
   return estimated_prefix_count + estimated_prefix_count / 100;
 }
 
+// Fill the subtree rooted at slot |k| of |eytzinger| with the items of
+// |index| starting at position |i|, in order.  Returns the position of the
+// next unconsumed item.  Recursion depth is the height of the tree.
+size_t FillEytzinger(const std::vector<std::pair<SBPrefix, uint32> >& index,
+                     size_t i, size_t k,
+                     std::vector<SBPrefix>* eytzinger,
+                     std::vector<uint32>* eytzinger_rank) {
+  if (k >= eytzinger->size())
+    return i;
+  i = FillEytzinger(index, i, 2 * k, eytzinger, eytzinger_rank);
+  (*eytzinger)[k] = index[i].first;
+  (*eytzinger_rank)[k] = static_cast<uint32>(i);
+  ++i;
+  return FillEytzinger(index, i, 2 * k + 1, eytzinger, eytzinger_rank);
+}
+
 }  // namespace
 
 namespace safe_browsing {
 
-// For |std::upper_bound()| to find a prefix w/in a vector of pairs.
-// static
-bool PrefixSet::PrefixLess(const IndexPair& a, const IndexPair& b) {
-  return a.first < b.first;
-}
-
 PrefixSet::PrefixSet() {
 }
 
@@ -101,36 +111,62 @@ PrefixSet::PrefixSet(IndexVector* index,
   index_.swap(*index);
   deltas_.swap(*deltas);
   full_hashes_.swap(*full_hashes);
+  BuildLookupIndex();
 }
 
 PrefixSet::~PrefixSet() {}
 
-bool PrefixSet::PrefixExists(SBPrefix prefix) const {
-  if (index_.empty())
-    return false;
+void PrefixSet::BuildLookupIndex() {
+  eytzinger_.resize(index_.size() + 1);
+  eytzinger_rank_.resize(index_.size() + 1);
+  const size_t consumed =
+      FillEytzinger(index_, 0, 1, &eytzinger_, &eytzinger_rank_);
+  DCHECK_EQ(consumed, index_.size());
+}
+
+bool PrefixSet::FindRun(SBPrefix prefix, size_t* index_pos) const {
+  DCHECK_EQ(eytzinger_.size(), index_.size() + 1);
 
-  // Find the first position after |prefix| in |index_|.
-  IndexVector::const_iterator iter =
-      std::upper_bound(index_.begin(), index_.end(),
-                       IndexPair(prefix, 0), PrefixLess);
+  // Walk down the implicit tree, going right while slots are not greater
+  // than |prefix|.  The walk ends one level below a leaf.
+  const size_t n = index_.size();
+  size_t k = 1;
+  while (k <= n) {
+    k = 2 * k + (eytzinger_[k] <= prefix ? 1 : 0);
+  }
+
+  // Undo the trailing right turns and the last left turn to land on the
+  // first slot greater than |prefix|.  If every turn was to the right, |k|
+  // ends up 0 and every item is less than or equal to |prefix|.
+  while (k & 1)
+    k >>= 1;
+  k >>= 1;
+  const size_t upper_bound = (k == 0 ? n : eytzinger_rank_[k]);
 
   // |prefix| comes before anything that's in the set.
-  if (iter == index_.begin())
+  if (upper_bound == 0)
     return false;
 
-  // Capture the upper bound of our target entry's deltas.
-  const size_t bound = (iter == index_.end() ? deltas_.size() : iter->second);
+  *index_pos = upper_bound - 1;
+  return true;
+}
 
-  // Back up to the entry our target is in.
-  --iter;
+bool PrefixSet::PrefixExists(SBPrefix prefix) const {
+  size_t pos;
+  if (!FindRun(prefix, &pos))
+    return false;
+
+  // Capture the upper bound of our target entry's deltas.
+  const size_t bound =
+      (pos + 1 == index_.size() ? deltas_.size() : index_[pos + 1].second);
 
   // All prefixes in |index_| are in the set.
-  SBPrefix current = iter->first;
+  SBPrefix current = index_[pos].first;
   if (current == prefix)
     return true;
 
   // Scan forward accumulating deltas while a match is possible.
-  for (size_t di = iter->second; di < bound && current < prefix; ++di) {
+  for (size_t di = index_[pos].second; di < bound && current < prefix; ++di) {
     current += deltas_[di];
   }
 
@@ -427,6 +463,7 @@ scoped_ptr<PrefixSet> PrefixSetBuilder::GetPrefixSet(
   // Precisely size |index_| for read-only.  It's 50k-60k, so minor savings, but
   // they're almost free.
   PrefixSet::IndexVector(prefix_set_->index_).swap(prefix_set_->index_);
+  prefix_set_->BuildLookupIndex();
 
   prefix_set_->full_hashes_ = hashes;
   std::sort(prefix_set_->full_hashes_.begin(), prefix_set_->full_hashes_.end(),
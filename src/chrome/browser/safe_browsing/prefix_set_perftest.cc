@@ -0,0 +1,88 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/rand_util.h"
+#include "base/time/time.h"
+#include "chrome/browser/safe_browsing/prefix_miss_cache.h"
+#include "chrome/browser/safe_browsing/prefix_set.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace safe_browsing {
+
+namespace {
+
+// Number of lookups timed per measurement.  About half hit.
+const size_t kLookups = 1000 * 1000;
+
+// Build a set of |count| uniformly-distributed prefixes, which is what
+// hashed URLs look like, and time |kLookups| calls to |Exists()|.
+void RunLookupTest(const std::string& trace, size_t count) {
+  std::vector<SBPrefix> prefixes;
+  prefixes.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    prefixes.push_back(static_cast<SBPrefix>(base::RandUint64()));
+  }
+  std::sort(prefixes.begin(), prefixes.end());
+
+  PrefixSetBuilder builder(prefixes);
+  scoped_ptr<PrefixSet> prefix_set = builder.GetPrefixSetNoHashes();
+
+  std::vector<SBFullHash> probes(kLookups);
+  for (size_t i = 0; i < probes.size(); ++i) {
+    memset(&probes[i], 0, sizeof(probes[i]));
+    probes[i].prefix = (i % 2) ?
+        prefixes[base::RandGenerator(prefixes.size())] :
+        static_cast<SBPrefix>(base::RandUint64());
+  }
+
+  size_t hits = 0;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (size_t i = 0; i < probes.size(); ++i) {
+    if (prefix_set->Exists(probes[i]))
+      ++hits;
+  }
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  EXPECT_GE(hits, kLookups / 2);
+
+  perf_test::PrintResult("prefix_set_lookup", "", trace,
+                         elapsed.InMicroseconds() * 1000.0 / kLookups,
+                         "ns/lookup", true);
+
+  // Repeat the probes against a miss cache holding half of them, the way
+  // |ContainsBrowseUrl()| consults it after a prefix hit.
+  PrefixMissCache miss_cache;
+  for (size_t i = 1; i < probes.size(); i += 2) {
+    miss_cache.Insert(probes[i].prefix);
+  }
+  size_t cached = 0;
+  const base::TimeTicks miss_start = base::TimeTicks::Now();
+  for (size_t i = 0; i < probes.size(); ++i) {
+    if (miss_cache.Contains(probes[i].prefix))
+      ++cached;
+  }
+  const base::TimeDelta miss_elapsed = base::TimeTicks::Now() - miss_start;
+  EXPECT_GT(cached, 0u);
+
+  perf_test::PrintResult("prefix_miss_cache_lookup", "", trace,
+                         miss_elapsed.InMicroseconds() * 1000.0 / kLookups,
+                         "ns/lookup", true);
+}
+
+}  // namespace
+
+TEST(PrefixSetPerfTest, Lookup1M) {
+  RunLookupTest("1M_prefixes", 1000 * 1000);
+}
+
+TEST(PrefixSetPerfTest, Lookup10M) {
+  RunLookupTest("10M_prefixes", 10 * 1000 * 1000);
+}
+
+}  // namespace safe_browsing
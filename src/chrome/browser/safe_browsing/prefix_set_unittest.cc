@@ -362,6 +362,38 @@ TEST_F(PrefixSetTest, EdgeCases) {
   }
 }
 
+// Check that the Eytzinger search lands on the same |index_| entry as a
+// binary search over the sorted index, including at the edges.
+TEST_F(PrefixSetTest, LookupIndexMatchesIndex) {
+  PrefixSetBuilder builder(shared_prefixes_);
+  scoped_ptr<PrefixSet> prefix_set = builder.GetPrefixSetNoHashes();
+  const PrefixSet::IndexVector& index = prefix_set->index_;
+  ASSERT_FALSE(index.empty());
+
+  std::vector<SBPrefix> probes;
+  probes.push_back(0u);
+  probes.push_back(static_cast<SBPrefix>(-1));
+  for (size_t i = 0; i < index.size(); ++i) {
+    probes.push_back(index[i].first - 1);
+    probes.push_back(index[i].first);
+    probes.push_back(index[i].first + 1);
+  }
+
+  for (size_t i = 0; i < probes.size(); ++i) {
+    size_t expected = 0;
+    while (expected < index.size() && index[expected].first <= probes[i])
+      ++expected;
+
+    size_t pos = 0;
+    if (expected == 0) {
+      EXPECT_FALSE(prefix_set->FindRun(probes[i], &pos));
+    } else {
+      ASSERT_TRUE(prefix_set->FindRun(probes[i], &pos));
+      EXPECT_EQ(expected - 1, pos);
+    }
+  }
+}
+
 // Test writing a prefix set to disk and reading it back in.
 TEST_F(PrefixSetTest, ReadWrite) {
   base::FilePath filename;
@@ -673,10 +705,9 @@ TEST_F(PrefixSetTest, ReadWriteSigned) {
   scoped_ptr<PrefixSet> prefix_set = PrefixSet::LoadFile(filename);
   ASSERT_TRUE(prefix_set.get());
 
-  // |PrefixExists()| uses |std::upper_bound()| to find a starting point, which
-  // assumes |index_| is sorted.  Depending on how |upper_bound()| is
-  // implemented, if the actual list is sorted by |int32|, then one of these
-  // test pairs should fail.
+  // |PrefixExists()| searches a tree built from |index_| to find a starting
+  // point, which assumes |index_| is sorted.  If the actual list is sorted by
+  // |int32|, then one of these test pairs should fail.
   EXPECT_TRUE(prefix_set->PrefixExists(1000u));
   EXPECT_TRUE(prefix_set->PrefixExists(1023u));
   EXPECT_TRUE(prefix_set->PrefixExists(static_cast<uint32>(-1000)));
@@ -98,6 +98,11 @@ class FakeSafeBrowsingDatabaseManager :  public SafeBrowsingDatabaseManager {
     return false;
   }
 
+  virtual bool CheckBrowseUrlInBatch(const GURL& gurl,
+                                     Client* client) OVERRIDE {
+    return CheckBrowseUrl(gurl, client);
+  }
+
   void OnCheckBrowseURLDone(const GURL& gurl, Client* client) {
     std::vector<SBThreatType> expected_threats;
     expected_threats.push_back(SB_THREAT_TYPE_URL_MALWARE);
@@ -102,7 +102,7 @@ int EncodeChunkId(const int chunk, const int list_id) {
   return chunk << 1 | list_id % 2;
 }
 
-// Generate the set of full hashes to check for |url|.  If
+// Generate the host/path expressions to check for |url|.  If
 // |include_whitelist_hashes| is true we will generate additional path-prefixes
 // to match against the csd whitelist.  E.g., if the path-prefix /foo is on the
 // whitelist it should also match /foo/bar which is not the case for all the
@@ -112,9 +112,9 @@ int EncodeChunkId(const int chunk, const int list_id) {
 // does an early exit on match.  Since match should be the infrequent
 // case (phishing or malware found), consider combining this function
 // with that one.
-void BrowseFullHashesToCheck(const GURL& url,
-                             bool include_whitelist_hashes,
-                             std::vector<SBFullHash>* full_hashes) {
+void BrowseExpressionsToCheck(const GURL& url,
+                              bool include_whitelist_hashes,
+                              std::vector<std::string>* expressions) {
   std::vector<std::string> hosts;
   if (url.HostIsIPAddress()) {
     hosts.push_back(url.host());
@@ -128,7 +128,7 @@ void BrowseFullHashesToCheck(const GURL& url,
   for (size_t i = 0; i < hosts.size(); ++i) {
     for (size_t j = 0; j < paths.size(); ++j) {
       const std::string& path = paths[j];
-      full_hashes->push_back(SBFullHashForString(hosts[i] + path));
+      expressions->push_back(hosts[i] + path);
 
       // We may have /foo as path-prefix in the whitelist which should
       // also match with /foo/bar and /foo?bar.  Hence, for every path
@@ -136,13 +136,23 @@ void BrowseFullHashesToCheck(const GURL& url,
       if (include_whitelist_hashes &&
           path.size() > 1 &&
           path[path.size() - 1] == '/') {
-        full_hashes->push_back(
-            SBFullHashForString(hosts[i] + path.substr(0, path.size() - 1)));
+        expressions->push_back(hosts[i] + path.substr(0, path.size() - 1));
       }
     }
   }
 }
 
+// Generate the set of full hashes to check for |url|, see
+// BrowseExpressionsToCheck().
+void BrowseFullHashesToCheck(const GURL& url,
+                             bool include_whitelist_hashes,
+                             std::vector<SBFullHash>* full_hashes) {
+  std::vector<std::string> expressions;
+  BrowseExpressionsToCheck(url, include_whitelist_hashes, &expressions);
+  for (size_t i = 0; i < expressions.size(); ++i)
+    full_hashes->push_back(SBFullHashForString(expressions[i]));
+}
+
 // Get the prefixes matching the download |urls|.
 void GetDownloadUrlPrefixes(const std::vector<GURL>& urls,
                             std::vector<SBPrefix>* prefixes) {
@@ -366,6 +376,27 @@ SafeBrowsingDatabase* SafeBrowsingDatabase::Create(
 SafeBrowsingDatabase::~SafeBrowsingDatabase() {
 }
 
+bool SafeBrowsingDatabase::ContainsBrowseUrls(
+    const std::vector<GURL>& urls,
+    std::vector<std::vector<SBPrefix> >* prefix_hits,
+    std::vector<std::vector<SBFullHashResult> >* cache_hits) {
+  prefix_hits->clear();
+  prefix_hits->resize(urls.size());
+  cache_hits->clear();
+  cache_hits->resize(urls.size());
+
+  bool any_match = false;
+  for (size_t i = 0; i < urls.size(); ++i) {
+    if (ContainsBrowseUrl(urls[i], &(*prefix_hits)[i], &(*cache_hits)[i])) {
+      any_match = true;
+    } else {
+      (*prefix_hits)[i].clear();
+      (*cache_hits)[i].clear();
+    }
+  }
+  return any_match;
+}
+
 // static
 base::FilePath SafeBrowsingDatabase::BrowseDBFilename(
     const base::FilePath& db_base_filename) {
@@ -446,6 +477,14 @@ void SafeBrowsingDatabase::RecordFailure(FailureType failure_type) {
                             FAILURE_DATABASE_MAX);
 }
 
+SafeBrowsingDatabaseNew::BrowseLookup::BrowseLookup(
+    scoped_ptr<safe_browsing::PrefixSet> prefix_set)
+    : prefix_set_(prefix_set.Pass()) {
+  DCHECK(prefix_set_.get());
+}
+
+SafeBrowsingDatabaseNew::BrowseLookup::~BrowseLookup() {}
+
 SafeBrowsingDatabaseNew::SafeBrowsingDatabaseNew()
     : creation_loop_(base::MessageLoop::current()),
       browse_store_(new SafeBrowsingStoreFile),
@@ -637,8 +676,7 @@ bool SafeBrowsingDatabaseNew::ResetDatabase() {
   {
     base::AutoLock locked(lookup_lock_);
     cached_browse_hashes_.clear();
-    prefix_miss_cache_.clear();
-    browse_prefix_set_.reset();
+    browse_lookup_ = NULL;
     side_effect_free_whitelist_prefix_set_.reset();
     ip_blacklist_.clear();
   }
@@ -648,6 +686,12 @@ bool SafeBrowsingDatabaseNew::ResetDatabase() {
   return true;
 }
 
+scoped_refptr<SafeBrowsingDatabaseNew::BrowseLookup>
+SafeBrowsingDatabaseNew::GetBrowseLookup() {
+  base::AutoLock locked(lookup_lock_);
+  return browse_lookup_;
+}
+
 bool SafeBrowsingDatabaseNew::ContainsBrowseUrl(
     const GURL& url,
     std::vector<SBPrefix>* prefix_hits,
@@ -661,22 +705,22 @@ bool SafeBrowsingDatabaseNew::ContainsBrowseUrl(
   if (full_hashes.empty())
     return false;
 
-  // This function is called on the I/O thread, prevent changes to
-  // filter and caches.
-  base::AutoLock locked(lookup_lock_);
+  // This function is called on the I/O thread.  Holding a reference keeps
+  // the prefix set alive if an update swaps it out during the search.
+  scoped_refptr<BrowseLookup> lookup = GetBrowseLookup();
 
-  // |browse_prefix_set_| is empty until it is either read from disk, or the
+  // |browse_lookup_| is empty until it is either read from disk, or the
   // first update populates it.  Bail out without a hit if not yet
   // available.
-  if (!browse_prefix_set_.get())
+  if (!lookup.get())
     return false;
 
   size_t miss_count = 0;
   for (size_t i = 0; i < full_hashes.size(); ++i) {
-    if (browse_prefix_set_->Exists(full_hashes[i])) {
+    if (lookup->prefix_set()->Exists(full_hashes[i])) {
       const SBPrefix prefix = full_hashes[i].prefix;
       prefix_hits->push_back(prefix);
-      if (prefix_miss_cache_.count(prefix) > 0)
+      if (lookup->miss_cache()->Contains(prefix))
         ++miss_count;
     }
   }
@@ -687,11 +731,87 @@ bool SafeBrowsingDatabaseNew::ContainsBrowseUrl(
 
   // Find matching cached gethash responses.
   std::sort(prefix_hits->begin(), prefix_hits->end());
+  base::AutoLock locked(lookup_lock_);
   GetCachedFullHashesForBrowse(*prefix_hits, cached_browse_hashes_, cache_hits);
 
   return true;
 }
 
+bool SafeBrowsingDatabaseNew::ContainsBrowseUrls(
+    const std::vector<GURL>& urls,
+    std::vector<std::vector<SBPrefix> >* prefix_hits,
+    std::vector<std::vector<SBFullHashResult> >* cache_hits) {
+  // Clear the results first.
+  prefix_hits->clear();
+  prefix_hits->resize(urls.size());
+  cache_hits->clear();
+  cache_hits->resize(urls.size());
+
+  // This function is called on the I/O thread.  Holding a reference keeps
+  // the prefix set alive if an update swaps it out during the search.
+  scoped_refptr<BrowseLookup> lookup = GetBrowseLookup();
+
+  // |browse_lookup_| is empty until it is either read from disk, or the
+  // first update populates it.  Bail out without a hit if not yet
+  // available.
+  if (!lookup.get())
+    return false;
+
+  // The subresources of a page mostly share hosts and leading path
+  // components, so each distinct expression is hashed and probed once per
+  // batch.  Maps the expression to its prefix on a hit, else to -1.
+  base::hash_map<std::string, int64> probed;
+  std::vector<std::string> expressions;
+  bool any_match = false;
+  for (size_t i = 0; i < urls.size(); ++i) {
+    std::vector<SBPrefix>* url_prefix_hits = &(*prefix_hits)[i];
+
+    expressions.clear();
+    BrowseExpressionsToCheck(urls[i], false, &expressions);
+    for (size_t j = 0; j < expressions.size(); ++j) {
+      std::pair<base::hash_map<std::string, int64>::iterator, bool> inserted =
+          probed.insert(std::make_pair(expressions[j], -1));
+      if (inserted.second) {
+        const SBFullHash full_hash = SBFullHashForString(expressions[j]);
+        if (lookup->prefix_set()->Exists(full_hash))
+          inserted.first->second = full_hash.prefix;
+      }
+      if (inserted.first->second != -1) {
+        url_prefix_hits->push_back(
+            static_cast<SBPrefix>(inserted.first->second));
+      }
+    }
+
+    // If all the prefixes are cached as 'misses', don't issue a GetHash.
+    size_t miss_count = 0;
+    for (size_t j = 0; j < url_prefix_hits->size(); ++j) {
+      if (lookup->miss_cache()->Contains((*url_prefix_hits)[j]))
+        ++miss_count;
+    }
+    if (miss_count == url_prefix_hits->size()) {
+      url_prefix_hits->clear();
+      continue;
+    }
+
+    std::sort(url_prefix_hits->begin(), url_prefix_hits->end());
+    any_match = true;
+  }
+
+  if (!any_match)
+    return false;
+
+  // Find matching cached gethash responses.
+  base::AutoLock locked(lookup_lock_);
+  for (size_t i = 0; i < urls.size(); ++i) {
+    if (!(*prefix_hits)[i].empty()) {
+      GetCachedFullHashesForBrowse((*prefix_hits)[i], cached_browse_hashes_,
+                                   &(*cache_hits)[i]);
+    }
+  }
+
+  return true;
+}
+
 bool SafeBrowsingDatabaseNew::ContainsDownloadUrl(
     const std::vector<GURL>& urls,
     std::vector<SBPrefix>* prefix_hits) {
@@ -1021,14 +1141,22 @@ void SafeBrowsingDatabaseNew::CacheHashResults(
     const base::TimeDelta& cache_lifetime) {
   const base::Time expire_after = base::Time::Now() + cache_lifetime;
 
-  // This is called on the I/O thread, lock against updates.
-  base::AutoLock locked(lookup_lock_);
-
+  // The miss cache does not need the lock.  If an update has swapped in a
+  // new prefix set since the lookup, the misses are recorded against the
+  // new set, which is fail-safe (the hash will be fetched again).
   if (full_hits.empty()) {
-    prefix_miss_cache_.insert(prefixes.begin(), prefixes.end());
+    scoped_refptr<BrowseLookup> lookup = GetBrowseLookup();
+    if (lookup.get()) {
+      for (size_t i = 0; i < prefixes.size(); ++i) {
+        lookup->miss_cache()->Insert(prefixes[i]);
+      }
+    }
     return;
   }
 
+  // This is called on the I/O thread, lock against updates.
+  base::AutoLock locked(lookup_lock_);
+
   const size_t orig_size = cached_browse_hashes_.size();
   for (std::vector<SBFullHashResult>::const_iterator iter = full_hits.begin();
        iter != full_hits.end(); ++iter) {
@@ -1311,10 +1439,11 @@ void SafeBrowsingDatabaseNew::UpdateBrowseStore() {
     full_hash_results.push_back(add_full_hashes[i].full_hash);
   }
 
-  scoped_ptr<safe_browsing::PrefixSet>
-      prefix_set(builder.GetPrefixSet(full_hash_results));
+  scoped_refptr<BrowseLookup> lookup(
+      new BrowseLookup(builder.GetPrefixSet(full_hash_results)));
 
-  // Swap in the newly built filter and cache.
+  // Swap in the newly built filter and cache.  The new lookup starts with an
+  // empty miss cache.
   {
     base::AutoLock locked(lookup_lock_);
 
@@ -1324,17 +1453,20 @@ void SafeBrowsingDatabaseNew::UpdateBrowseStore() {
     // at the earlier point.  I believe that is fail-safe as-is (the
     // hash will be fetched again).
     cached_browse_hashes_.clear();
-    prefix_miss_cache_.clear();
-    browse_prefix_set_.swap(prefix_set);
+    browse_lookup_.swap(lookup);
   }
 
+  // Lookups in flight may still hold the old prefix set.  Whichever side
+  // releases the last reference frees it.
+  lookup = NULL;
+
   DVLOG(1) << "SafeBrowsingDatabaseImpl built prefix set in "
            << (base::TimeTicks::Now() - before).InMilliseconds()
            << " ms total.";
   UMA_HISTOGRAM_LONG_TIMES("SB2.BuildFilter", base::TimeTicks::Now() - before);
 
   // Persist the prefix set to disk.  Since only this thread changes
-  // |browse_prefix_set_|, there is no need to lock.
+  // |browse_lookup_|, there is no need to lock.
   WritePrefixSet();
 
   // Gather statistics.
@@ -1465,14 +1597,17 @@ void SafeBrowsingDatabaseNew::LoadPrefixSet() {
   base::DeleteFile(bloom_filter_filename, false);
 
   const base::TimeTicks before = base::TimeTicks::Now();
-  browse_prefix_set_ = safe_browsing::PrefixSet::LoadFile(
-      browse_prefix_set_filename_);
+  scoped_ptr<safe_browsing::PrefixSet> prefix_set =
+      safe_browsing::PrefixSet::LoadFile(browse_prefix_set_filename_);
   DVLOG(1) << "SafeBrowsingDatabaseNew read prefix set in "
            << (base::TimeTicks::Now() - before).InMilliseconds() << " ms";
   UMA_HISTOGRAM_TIMES("SB2.PrefixSetLoad", base::TimeTicks::Now() - before);
 
-  if (!browse_prefix_set_.get())
+  if (!prefix_set.get()) {
     RecordFailure(FAILURE_BROWSE_PREFIX_SET_READ);
+    return;
+  }
+  browse_lookup_ = new BrowseLookup(prefix_set.Pass());
 }
 
 bool SafeBrowsingDatabaseNew::Delete() {
@@ -1531,11 +1666,11 @@ bool SafeBrowsingDatabaseNew::Delete() {
 void SafeBrowsingDatabaseNew::WritePrefixSet() {
   DCHECK_EQ(creation_loop_, base::MessageLoop::current());
 
-  if (!browse_prefix_set_.get())
+  if (!browse_lookup_.get())
     return;
 
   const base::TimeTicks before = base::TimeTicks::Now();
-  const bool write_ok = browse_prefix_set_->WriteFile(
+  const bool write_ok = browse_lookup_->prefix_set()->WriteFile(
       browse_prefix_set_filename_);
   DVLOG(1) << "SafeBrowsingDatabaseNew wrote prefix set in "
            << (base::TimeTicks::Now() - before).InMilliseconds() << " ms";
@@ -13,10 +13,12 @@
 #include "base/containers/hash_tables.h"
 #include "base/files/file_path.h"
 #include "base/gtest_prod_util.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/synchronization/lock.h"
 #include "base/time/time.h"
+#include "chrome/browser/safe_browsing/prefix_miss_cache.h"
 #include "chrome/browser/safe_browsing/safe_browsing_store.h"
 
 namespace base {
@@ -112,6 +114,16 @@ class SafeBrowsingDatabase {
       std::vector<SBPrefix>* prefix_hits,
       std::vector<SBFullHashResult>* cache_hits) = 0;
 
+  // Batched ContainsBrowseUrl().  |prefix_hits| and |cache_hits| are resized to
+  // match |urls|, and the entries for a URL are non-empty only if the URL needs
+  // further checking.  Returns true if any URL does.  Implementations may share
+  // work between URLs which generate the same host/path expressions, as the
+  // subresources of a page mostly do.  Safe to call from any thread.
+  virtual bool ContainsBrowseUrls(
+      const std::vector<GURL>& urls,
+      std::vector<std::vector<SBPrefix> >* prefix_hits,
+      std::vector<std::vector<SBFullHashResult> >* cache_hits);
+
   // Returns false if none of |urls| are in Download database. If it returns
   // true, |prefix_hits| should contain the prefixes for the URLs that were in
   // the database.  This function could ONLY be accessed from creation thread.
@@ -307,6 +319,10 @@ class SafeBrowsingDatabaseNew : public SafeBrowsingDatabase {
       const GURL& url,
       std::vector<SBPrefix>* prefix_hits,
       std::vector<SBFullHashResult>* cache_hits) OVERRIDE;
+  virtual bool ContainsBrowseUrls(
+      const std::vector<GURL>& urls,
+      std::vector<std::vector<SBPrefix> >* prefix_hits,
+      std::vector<std::vector<SBFullHashResult> >* cache_hits) OVERRIDE;
   virtual bool ContainsDownloadUrl(const std::vector<GURL>& urls,
                                    std::vector<SBPrefix>* prefix_hits) OVERRIDE;
   virtual bool ContainsCsdWhitelistedUrl(const GURL& url) OVERRIDE;
@@ -349,6 +365,34 @@ class SafeBrowsingDatabaseNew : public SafeBrowsingDatabase {
   // IPv6 IP prefix using SHA-1.
   typedef std::map<std::string, base::hash_set<std::string> > IPBlacklist;
 
+  // The browse prefix set together with the gethash misses cached against
+  // it.  Built on the database thread and published by swapping
+  // |browse_lookup_| under |lookup_lock_|.  Lookups hold the lock only long
+  // enough to take a reference and then search without it.  The prefix set
+  // is never modified once published and the miss cache is safe for
+  // concurrent use, so a rebuild never stalls the IO thread.
+  class BrowseLookup : public base::RefCountedThreadSafe<BrowseLookup> {
+   public:
+    explicit BrowseLookup(scoped_ptr<safe_browsing::PrefixSet> prefix_set);
+
+    const safe_browsing::PrefixSet* prefix_set() const {
+      return prefix_set_.get();
+    }
+    safe_browsing::PrefixMissCache* miss_cache() { return &miss_cache_; }
+
+   private:
+    friend class base::RefCountedThreadSafe<BrowseLookup>;
+    ~BrowseLookup();
+
+    const scoped_ptr<safe_browsing::PrefixSet> prefix_set_;
+    safe_browsing::PrefixMissCache miss_cache_;
+
+    DISALLOW_COPY_AND_ASSIGN(BrowseLookup);
+  };
+
+  // Returns a reference to the current |browse_lookup_|, which may be NULL.
+  scoped_refptr<BrowseLookup> GetBrowseLookup();
+
   // Returns true if the whitelist is disabled or if any of the given hashes
   // matches the whitelist.
   bool ContainsWhitelistedHashes(const SBWhitelist& whitelist,
@@ -414,8 +458,8 @@ class SafeBrowsingDatabaseNew : public SafeBrowsingDatabase {
   base::MessageLoop* creation_loop_;
 
   // Lock for protecting access to variables that may be used on the
-  // IO thread.  This includes |prefix_set_|, |cached_browse_hashes_|,
-  // |prefix_miss_cache_|, |csd_whitelist_|.
+  // IO thread.  This includes the |browse_lookup_| pointer,
+  // |cached_browse_hashes_|, |csd_whitelist_|.
   base::Lock lookup_lock_;
 
   // Underlying persistent store for chunk data.
@@ -460,11 +504,6 @@ class SafeBrowsingDatabaseNew : public SafeBrowsingDatabase {
   // scanning.  Discarded on next update.
   std::vector<SBFullHashCached> cached_browse_hashes_;
 
-  // Cache of prefixes that returned empty results (no full hash
-  // match) to |CacheHashResults()|.  Cached to prevent asking for
-  // them every time.  Cleared on next update.
-  std::set<SBPrefix> prefix_miss_cache_;
-
   // Used to schedule resetting the database because of corruption.
   base::WeakPtrFactory<SafeBrowsingDatabaseNew> reset_factory_;
 
@@ -477,9 +516,12 @@ class SafeBrowsingDatabaseNew : public SafeBrowsingDatabase {
   // Used to optimize away database update.
   bool change_detected_;
 
-  // Used to check if a prefix was in the browse database.
+  // Used to check if a prefix was in the browse database.  Also carries
+  // the cache of prefixes that returned empty results (no full hash match)
+  // to |CacheHashResults()|, so that the cache is discarded with the
+  // prefix set on the next update.
   base::FilePath browse_prefix_set_filename_;
-  scoped_ptr<safe_browsing::PrefixSet> browse_prefix_set_;
+  scoped_refptr<BrowseLookup> browse_lookup_;
 
   // Used to check if a prefix was in the browse database.
   base::FilePath side_effect_free_whitelist_prefix_set_filename_;
@@ -0,0 +1,124 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "chrome/browser/safe_browsing/safe_browsing_database.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "url/gurl.h"
+
+namespace {
+
+// The subresources of a large page, spread over a few hosts and paths the
+// way scripts, images and trackers are.
+const size_t kSubresources = 300;
+const size_t kHosts = 12;
+const size_t kDirectories = 8;
+
+// Pages timed per measurement.
+const size_t kPages = 200;
+
+// Host-level entries added to the database, so that the prefix set has a
+// realistic size.
+const int kChunks = 50;
+const int kHostsPerChunk = 1000;
+
+void InsertAddChunkHostPrefix(SBChunk* chunk,
+                              int chunk_number,
+                              const std::string& host_name) {
+  chunk->chunk_number = chunk_number;
+  chunk->is_add = true;
+  SBChunkHost host;
+  host.host = SBFullHashForString(host_name).prefix;
+  host.entry = SBEntry::Create(SBEntry::ADD_PREFIX, 0);
+  host.entry->set_chunk_id(chunk->chunk_number);
+  chunk->hosts.push_back(host);
+}
+
+std::vector<GURL> MakePage() {
+  std::vector<GURL> urls;
+  for (size_t i = 0; i < kSubresources; ++i) {
+    urls.push_back(GURL(base::StringPrintf(
+        "http://cdn%d.static.example.com/assets/v%d/resource%d.js?rev=%d",
+        static_cast<int>(i % kHosts),
+        static_cast<int>(i % kDirectories),
+        static_cast<int>(i),
+        static_cast<int>(i % 3))));
+  }
+  return urls;
+}
+
+}  // namespace
+
+// Times the IO thread work of checking the subresources of a page against
+// the browse database, one URL at a time and as one batch.
+TEST(SafeBrowsingDatabasePerfTest, SubresourcePage) {
+  base::MessageLoop message_loop;
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  scoped_ptr<SafeBrowsingDatabaseNew> database(new SafeBrowsingDatabaseNew);
+  database->Init(temp_dir.path().AppendASCII("SafeBrowsingPerfDatabase"));
+
+  std::vector<SBListChunkRanges> lists;
+  ASSERT_TRUE(database->UpdateStarted(&lists));
+  for (int i = 0; i < kChunks; ++i) {
+    SBChunkList chunks;
+    SBChunk chunk;
+    for (int j = 0; j < kHostsPerChunk; ++j) {
+      InsertAddChunkHostPrefix(
+          &chunk, i + 1,
+          base::StringPrintf("www.malware%d.com/", i * kHostsPerChunk + j));
+    }
+    chunks.push_back(chunk);
+    database->InsertChunks(safe_browsing_util::kMalwareList, chunks);
+  }
+  database->UpdateFinished(true);
+
+  const std::vector<GURL> urls = MakePage();
+
+  size_t single_hits = 0;
+  std::vector<SBPrefix> prefix_hits;
+  std::vector<SBFullHashResult> cache_hits;
+  const base::TimeTicks single_start = base::TimeTicks::Now();
+  for (size_t page = 0; page < kPages; ++page) {
+    for (size_t i = 0; i < urls.size(); ++i) {
+      if (database->ContainsBrowseUrl(urls[i], &prefix_hits, &cache_hits))
+        ++single_hits;
+    }
+  }
+  const base::TimeDelta single_time = base::TimeTicks::Now() - single_start;
+
+  size_t batch_hits = 0;
+  std::vector<std::vector<SBPrefix> > batch_prefix_hits;
+  std::vector<std::vector<SBFullHashResult> > batch_cache_hits;
+  const base::TimeTicks batch_start = base::TimeTicks::Now();
+  for (size_t page = 0; page < kPages; ++page) {
+    if (database->ContainsBrowseUrls(urls, &batch_prefix_hits,
+                                     &batch_cache_hits)) {
+      ++batch_hits;
+    }
+  }
+  const base::TimeDelta batch_time = base::TimeTicks::Now() - batch_start;
+
+  EXPECT_EQ(0u, single_hits);
+  EXPECT_EQ(0u, batch_hits);
+
+  const std::string trace = base::StringPrintf(
+      "%d_subresources", static_cast<int>(kSubresources));
+  perf_test::PrintResult("browse_check_single", "", trace,
+                         single_time.InMicroseconds() /
+                             static_cast<double>(kPages),
+                         "us/page", true);
+  perf_test::PrintResult("browse_check_batch", "", trace,
+                         batch_time.InMicroseconds() /
+                             static_cast<double>(kPages),
+                         "us/page", true);
+}
@@ -1028,13 +1028,15 @@ TEST_F(SafeBrowsingDatabaseTest, HashCaching) {
   database_->CacheHashResults(prefix_misses, empty_full_hash, kCacheLifetime);
 
   // Prefixes with no full results are misses.
-  EXPECT_EQ(2U, database_->prefix_miss_cache_.size());
+  ASSERT_TRUE(database_->browse_lookup_.get());
+  EXPECT_EQ(2U, database_->browse_lookup_->miss_cache()->size());
 
   // Update the database.
   PopulateDatabaseForCacheTest();
 
   // Prefix miss cache should be cleared.
-  EXPECT_TRUE(database_->prefix_miss_cache_.empty());
+  ASSERT_TRUE(database_->browse_lookup_.get());
+  EXPECT_TRUE(database_->browse_lookup_->miss_cache()->empty());
 
   // Cache a GetHash miss for a particular prefix, and even though the prefix is
   // in the database, it is flagged as a miss so looking up the associated URL
@@ -1939,3 +1941,73 @@ TEST_F(SafeBrowsingDatabaseTest, ContainsBrowseURL) {
   EXPECT_FALSE(database_->ContainsBrowseUrl(
       GURL(std::string("http://") + kExampleFine), &prefix_hits, &cache_hits));
 }
+
+// Checking URLs as a batch gives the same results as checking them one at a
+// time, including for URLs which share host/path expressions.
+TEST_F(SafeBrowsingDatabaseTest, ContainsBrowseURLs) {
+  std::vector<SBListChunkRanges> lists;
+  ASSERT_TRUE(database_->UpdateStarted(&lists));
+
+  // Add a host-level hit.
+  {
+    SBChunkList chunks;
+    SBChunk chunk;
+    InsertAddChunkHostPrefix(&chunk, 1, "www.evil.com/");
+    chunks.push_back(chunk);
+    database_->InsertChunks(safe_browsing_util::kMalwareList, chunks);
+  }
+
+  // Add a specific fullhash.
+  static const char kWhateverMalware[] = "www.whatever.com/malware.html";
+  {
+    SBChunkList chunks;
+    SBChunk chunk;
+    InsertAddChunkHostFullHashes(&chunk, 2, "www.whatever.com/",
+                                 kWhateverMalware);
+    chunks.push_back(chunk);
+    database_->InsertChunks(safe_browsing_util::kMalwareList, chunks);
+  }
+
+  database_->UpdateFinished(true);
+
+  std::vector<GURL> urls;
+  urls.push_back(GURL("http://www.evil.com/malware.html"));
+  urls.push_back(GURL("http://www.whatever.com/fine.html"));
+  urls.push_back(GURL(std::string("http://") + kWhateverMalware));
+  urls.push_back(GURL("http://www.evil.com/other.html"));
+  urls.push_back(GURL("http://www.whatever.com/fine.html"));
+
+  std::vector<std::vector<SBPrefix> > prefix_hits;
+  std::vector<std::vector<SBFullHashResult> > cache_hits;
+  EXPECT_TRUE(database_->ContainsBrowseUrls(urls, &prefix_hits, &cache_hits));
+  ASSERT_EQ(urls.size(), prefix_hits.size());
+  ASSERT_EQ(urls.size(), cache_hits.size());
+
+  for (size_t i = 0; i < urls.size(); ++i) {
+    std::vector<SBPrefix> single_prefix_hits;
+    std::vector<SBFullHashResult> single_cache_hits;
+    const bool match = database_->ContainsBrowseUrl(
+        urls[i], &single_prefix_hits, &single_cache_hits);
+    EXPECT_EQ(match, !prefix_hits[i].empty()) << urls[i];
+    if (match)
+      EXPECT_EQ(single_prefix_hits, prefix_hits[i]) << urls[i];
+    EXPECT_TRUE(cache_hits[i].empty());
+  }
+
+  ASSERT_EQ(1U, prefix_hits[0].size());
+  EXPECT_EQ(SBPrefixForString("www.evil.com/"), prefix_hits[0][0]);
+  EXPECT_TRUE(prefix_hits[1].empty());
+  ASSERT_EQ(1U, prefix_hits[2].size());
+  EXPECT_EQ(SBPrefixForString(kWhateverMalware), prefix_hits[2][0]);
+  EXPECT_EQ(prefix_hits[0], prefix_hits[3]);
+  EXPECT_TRUE(prefix_hits[4].empty());
+
+  // A batch of safe URLs has no hits.
+  urls.clear();
+  urls.push_back(GURL("http://www.whatever.com/fine.html"));
+  urls.push_back(GURL("http://www.good.com/"));
+  EXPECT_FALSE(database_->ContainsBrowseUrls(urls, &prefix_hits, &cache_hits));
+  ASSERT_EQ(urls.size(), prefix_hits.size());
+  EXPECT_TRUE(prefix_hits[0].empty());
+  EXPECT_TRUE(prefix_hits[1].empty());
+}
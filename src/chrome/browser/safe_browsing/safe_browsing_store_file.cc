@@ -9,6 +9,7 @@
 #include "base/md5.h"
 #include "base/metrics/histogram.h"
 #include "base/metrics/sparse_histogram.h"
+#include "base/time/time.h"
 
 namespace {
 
@@ -65,6 +66,30 @@ union FileHeader {
   struct FileHeaderV8 v8;
 };
 
+// Magic number and version for the delta segment file.  The magic differs
+// from |kFileMagic| so that one file can never be mistaken for the other.
+const int32 kDeltaMagic = 0x600D71FD;
+const int32 kDeltaVersion = 1;
+
+// Header at the front of the delta segment file.
+struct DeltaHeader {
+  int32 magic, version;
+  uint32 add_chunk_count, sub_chunk_count;
+  uint32 add_del_count, sub_del_count;
+  uint32 add_prefix_count, sub_prefix_count;
+  uint32 add_hash_count, sub_hash_count;
+  base::MD5Digest main_checksum;
+};
+
+// Main files smaller than this are always rewritten in full.  Rewriting a few
+// megabytes is cheap, and keeps small stores in a single file.
+const int64 kMinDeltaBaseBytes = 4 * 1024 * 1024;
+
+// The delta is merged into the main file once its data or its deleted chunks
+// exceed this fraction of the main file's.  This bounds the extra work each
+// reader does, and the bytes each delta update writes.
+const int64 kDeltaCompactRatio = 8;
+
 // Header for each chunk in the chunk-accumulation file.
 struct ChunkHeader {
   uint32 add_prefix_count, sub_prefix_count;
@@ -452,6 +477,29 @@ class StateInternal {
     sub_full_hashes_.clear();
   }
 
+  void SwapData(StateInternal* other) {
+    SwapContainers(&other->add_prefixes_, &other->sub_prefixes_,
+                   &other->add_full_hashes_, &other->sub_full_hashes_);
+  }
+
+  void SwapContainers(SBAddPrefixes* add_prefixes,
+                      SBSubPrefixes* sub_prefixes,
+                      std::vector<SBAddFullHash>* add_full_hashes,
+                      std::vector<SBSubFullHash>* sub_full_hashes) {
+    add_prefixes_.swap(*add_prefixes);
+    sub_prefixes_.swap(*sub_prefixes);
+    add_full_hashes_.swap(*add_full_hashes);
+    sub_full_hashes_.swap(*sub_full_hashes);
+  }
+
+  // Approximate memory held by the data, also the bytes needed to write it.
+  int64 ApproximateBytes() const {
+    return static_cast<int64>(add_prefixes_.size()) * sizeof(SBAddPrefix) +
+        static_cast<int64>(sub_prefixes_.size()) * sizeof(SBSubPrefix) +
+        static_cast<int64>(add_full_hashes_.size()) * sizeof(SBAddFullHash) +
+        static_cast<int64>(sub_full_hashes_.size()) * sizeof(SBSubFullHash);
+  }
+
   // Merge data from |beg|..|end| into receiver's state, then process the state.
   // The current state and the range given should corrospond to the same sorted
   // shard of data from different sources.  |add_del_cache| and |sub_del_cache|
@@ -486,6 +534,20 @@ class StateInternal {
                   add_del_cache, sub_del_cache);
   }
 
+  // Drop data from the chunks in |add_del_cache| and |sub_del_cache|.  Used on
+  // main file data before merging a delta, so that chunks deleted by earlier
+  // updates cannot knock out or delete data which arrived after them.  This
+  // goes through SBProcessSubs(), so the subs left in the shard are also
+  // matched against its adds again; that is a no-op for netted main file data.
+  void ApplyDeletions(const base::hash_set<int32>& add_del_cache,
+                      const base::hash_set<int32>& sub_del_cache) {
+    if (add_del_cache.empty() && sub_del_cache.empty())
+      return;
+    SBProcessSubs(&add_prefixes_, &sub_prefixes_,
+                  &add_full_hashes_, &sub_full_hashes_,
+                  add_del_cache, sub_del_cache);
+  }
+
   // Sort the data appropriately for the sharding, merging, and processing
   // operations.
   void SortData() {
@@ -507,6 +569,14 @@ class StateInternal {
                             sub_full_hashes_.begin());
   }
 
+  // Iterator just past the end of the state's data.
+  StateInternalPos StateEnd() {
+    return StateInternalPos(add_prefixes_.end(),
+                            sub_prefixes_.end(),
+                            add_full_hashes_.end(),
+                            sub_full_hashes_.end());
+  }
+
   // An iterator pointing just after the last possible element of the shard
   // indicated by |shard_max|.  Used to step through the state by shard.
   // TODO(shess): Verify whether binary search really improves over linear.
@@ -561,6 +631,143 @@ bool IsPowerOfTwo(const T& val) {
   return val && (val & (val - 1)) == 0;
 }
 
+// Read the final checksum of the main file |filename| into |digest|.
+bool ReadTrailingDigest(const base::FilePath& filename,
+                        base::MD5Digest* digest) {
+  base::ScopedFILE file(base::OpenFile(filename, "rb"));
+  if (file.get() == NULL)
+    return false;
+  if (fseek(file.get(), -static_cast<long>(sizeof(*digest)), SEEK_END) != 0)
+    return false;
+  return ReadItem(digest, file.get(), NULL);
+}
+
+// Read the delta segment for the main file |filename|.  Fills in the chunks
+// seen, the chunks deleted since the main file was written, and the delta's
+// data.  Returns false if there is no delta, or if it is corrupt or was
+// written against a different main file, in which case it should be ignored.
+bool ReadDeltaFile(const base::FilePath& filename,
+                   std::set<int32>* add_chunks,
+                   std::set<int32>* sub_chunks,
+                   base::hash_set<int32>* add_del_cache,
+                   base::hash_set<int32>* sub_del_cache,
+                   StateInternal* delta_state) {
+  const base::FilePath delta_filename =
+      SafeBrowsingStoreFile::DeltaFileForFilename(filename);
+  base::ScopedFILE file(base::OpenFile(delta_filename, "rb"));
+  if (file.get() == NULL)
+    return false;
+
+  base::MD5Digest main_checksum;
+  if (!ReadTrailingDigest(filename, &main_checksum))
+    return false;
+
+  base::MD5Context context;
+  base::MD5Init(&context);
+  DeltaHeader header;
+  if (!ReadItem(&header, file.get(), &context))
+    return false;
+  if (header.magic != kDeltaMagic || header.version != kDeltaVersion)
+    return false;
+  if (memcmp(&header.main_checksum, &main_checksum, sizeof(main_checksum)))
+    return false;
+
+  // Sanity-check the counts against the file size before reading.
+  int64 size = 0;
+  if (!base::GetFileSize(delta_filename, &size))
+    return false;
+  int64 expected_size = sizeof(header);
+  expected_size += static_cast<int64>(header.add_chunk_count) * sizeof(int32);
+  expected_size += static_cast<int64>(header.sub_chunk_count) * sizeof(int32);
+  expected_size += static_cast<int64>(header.add_del_count) * sizeof(int32);
+  expected_size += static_cast<int64>(header.sub_del_count) * sizeof(int32);
+  expected_size +=
+      static_cast<int64>(header.add_prefix_count) * sizeof(SBAddPrefix);
+  expected_size +=
+      static_cast<int64>(header.sub_prefix_count) * sizeof(SBSubPrefix);
+  expected_size +=
+      static_cast<int64>(header.add_hash_count) * sizeof(SBAddFullHash);
+  expected_size +=
+      static_cast<int64>(header.sub_hash_count) * sizeof(SBSubFullHash);
+  expected_size += sizeof(base::MD5Digest);
+  if (size != expected_size)
+    return false;
+
+  std::set<int32> add_chunks_read;
+  std::set<int32> sub_chunks_read;
+  std::vector<int32> add_dels_read;
+  std::vector<int32> sub_dels_read;
+  StateInternal state;
+  if (!ReadToContainer(&add_chunks_read, header.add_chunk_count,
+                       file.get(), &context) ||
+      !ReadToContainer(&sub_chunks_read, header.sub_chunk_count,
+                       file.get(), &context) ||
+      !ReadToContainer(&add_dels_read, header.add_del_count,
+                       file.get(), &context) ||
+      !ReadToContainer(&sub_dels_read, header.sub_del_count,
+                       file.get(), &context) ||
+      !state.AppendData(header.add_prefix_count, header.sub_prefix_count,
+                        header.add_hash_count, header.sub_hash_count,
+                        file.get(), &context) ||
+      !ReadAndVerifyChecksum(file.get(), &context)) {
+    return false;
+  }
+
+  add_chunks->swap(add_chunks_read);
+  sub_chunks->swap(sub_chunks_read);
+  add_del_cache->clear();
+  add_del_cache->insert(add_dels_read.begin(), add_dels_read.end());
+  sub_del_cache->clear();
+  sub_del_cache->insert(sub_dels_read.begin(), sub_dels_read.end());
+  delta_state->SwapData(&state);
+  return true;
+}
+
+// Rewind |fp| and write a delta segment to it.  |main_checksum| is the final
+// checksum of the main file the delta applies to.
+bool WriteDeltaFile(const base::MD5Digest& main_checksum,
+                    const std::set<int32>& add_chunks,
+                    const std::set<int32>& sub_chunks,
+                    const base::hash_set<int32>& add_del_cache,
+                    const base::hash_set<int32>& sub_del_cache,
+                    const StateInternal& delta_state,
+                    FILE* fp) {
+  if (!FileRewind(fp))
+    return false;
+
+  base::MD5Context context;
+  base::MD5Init(&context);
+
+  DeltaHeader header;
+  header.magic = kDeltaMagic;
+  header.version = kDeltaVersion;
+  header.add_chunk_count = add_chunks.size();
+  header.sub_chunk_count = sub_chunks.size();
+  header.add_del_count = add_del_cache.size();
+  header.sub_del_count = sub_del_cache.size();
+  header.add_prefix_count = delta_state.add_prefixes_.size();
+  header.sub_prefix_count = delta_state.sub_prefixes_.size();
+  header.add_hash_count = delta_state.add_full_hashes_.size();
+  header.sub_hash_count = delta_state.sub_full_hashes_.size();
+  header.main_checksum = main_checksum;
+
+  if (!WriteItem(header, fp, &context) ||
+      !WriteContainer(add_chunks, fp, &context) ||
+      !WriteContainer(sub_chunks, fp, &context) ||
+      !WriteContainer(add_del_cache, fp, &context) ||
+      !WriteContainer(sub_del_cache, fp, &context) ||
+      !WriteContainer(delta_state.add_prefixes_, fp, &context) ||
+      !WriteContainer(delta_state.sub_prefixes_, fp, &context) ||
+      !WriteContainer(delta_state.add_full_hashes_, fp, &context) ||
+      !WriteContainer(delta_state.sub_full_hashes_, fp, &context)) {
+    return false;
+  }
+
+  base::MD5Digest digest;
+  base::MD5Final(&digest, &context);
+  return WriteItem(digest, fp, NULL);
+}
+
 // Helper to read the entire database state, used by GetAddPrefixes() and
 // GetAddFullHashes().  Those functions are generally used only for smaller
 // files.  Returns false in case of errors reading the data.
@@ -625,7 +832,23 @@ bool ReadDbStateHelper(const base::FilePath& filename,
   if (!base::GetFileSize(filename, &size))
     return false;
 
-  return static_cast<int64>(ftell(file.get())) == size;
+  if (static_cast<int64>(ftell(file.get())) != size)
+    return false;
+
+  // Fold in updates which have not been merged into the main file yet.
+  StateInternal delta_state;
+  base::hash_set<int32> add_del_cache;
+  base::hash_set<int32> sub_del_cache;
+  if (version == kFileVersion &&
+      ReadDeltaFile(filename, &add_chunks, &sub_chunks,
+                    &add_del_cache, &sub_del_cache, &delta_state)) {
+    db_state->ApplyDeletions(add_del_cache, sub_del_cache);
+    db_state->MergeDataAndProcess(delta_state.StateBegin(),
+                                  delta_state.StateEnd(),
+                                  base::hash_set<int32>(),
+                                  base::hash_set<int32>());
+  }
+  return true;
 }
 
 }  // namespace
@@ -657,7 +880,11 @@ void SafeBrowsingStoreFile::CheckForOriginalAndDelete(
 }
 
 SafeBrowsingStoreFile::SafeBrowsingStoreFile()
-    : chunks_written_(0), empty_(false), corruption_seen_(false) {}
+    : chunks_written_(0),
+      empty_(false),
+      has_delta_(false),
+      min_delta_base_bytes_(kMinDeltaBaseBytes),
+      corruption_seen_(false) {}
 
 SafeBrowsingStoreFile::~SafeBrowsingStoreFile() {
   Close();
@@ -869,6 +1096,26 @@ bool SafeBrowsingStoreFile::BeginUpdate() {
     return OnCorruptDatabase();
   }
 
+  // Chunks recorded in a delta segment supersede the main file's lists.  A
+  // delta which cannot be used is ignored, see the header comment.
+  if (version == kFileVersion) {
+    std::set<int32> add_chunks;
+    std::set<int32> sub_chunks;
+    base::hash_set<int32> add_del_cache;
+    base::hash_set<int32> sub_del_cache;
+    StateInternal delta_state;
+    if (ReadDeltaFile(filename_, &add_chunks, &sub_chunks,
+                      &add_del_cache, &sub_del_cache, &delta_state)) {
+      add_chunks_cache_.swap(add_chunks);
+      sub_chunks_cache_.swap(sub_chunks);
+      delta_add_del_.swap(add_del_cache);
+      delta_sub_del_.swap(sub_del_cache);
+      delta_state.SwapContainers(&delta_add_prefixes_, &delta_sub_prefixes_,
+                                 &delta_add_hashes_, &delta_sub_hashes_);
+      has_delta_ = true;
+    }
+  }
+
   file_.swap(file);
   new_file_.swap(new_file);
   return true;
@@ -907,6 +1154,8 @@ bool SafeBrowsingStoreFile::DoUpdate(
   CHECK(builder);
   CHECK(add_full_hashes_result);
 
+  const base::TimeTicks update_start = base::TimeTicks::Now();
+
   // Rewind the temporary storage.
   if (!FileRewind(new_file_.get()))
     return false;
@@ -956,6 +1205,24 @@ bool SafeBrowsingStoreFile::DoUpdate(
   // The state was accumulated by chunk, sort by prefix.
   new_state.SortData();
 
+  // Fold the update into any updates not yet merged into the main file, as
+  // read by BeginUpdate().  The result is the data for a new delta segment, if
+  // one is written.
+  StateInternal delta_state;
+  base::hash_set<int32> prior_add_del;
+  base::hash_set<int32> prior_sub_del;
+  if (has_delta_) {
+    delta_state.SwapContainers(&delta_add_prefixes_, &delta_sub_prefixes_,
+                               &delta_add_hashes_, &delta_sub_hashes_);
+    prior_add_del.swap(delta_add_del_);
+    prior_sub_del.swap(delta_sub_del_);
+    delta_state.MergeDataAndProcess(new_state.StateBegin(),
+                                    new_state.StateEnd(),
+                                    add_del_cache_, sub_del_cache_);
+  } else {
+    delta_state.SwapData(&new_state);
+  }
+
   // These strides control how much data is loaded into memory per pass.
   // Strides must be an even power of two.  |in_stride| will be derived from the
   // input file.  |out_stride| will be derived from an estimate of the resulting
@@ -970,11 +1237,15 @@ bool SafeBrowsingStoreFile::DoUpdate(
   int version = kInvalidVersion;
   FileHeader header;
 
+  // Chunks listed in the main file.
+  std::set<int32> main_add_chunks;
+  std::set<int32> main_sub_chunks;
+
   if (!empty_) {
     DCHECK(file_.get());
 
     version = ReadAndVerifyHeader(filename_, &header,
-                                  &add_chunks_cache_, &sub_chunks_cache_,
+                                  &main_add_chunks, &main_sub_chunks,
                                   file_.get(), &in_context);
     if (version == kInvalidVersion)
       return OnCorruptDatabase();
@@ -986,18 +1257,52 @@ bool SafeBrowsingStoreFile::DoUpdate(
     // broken if this is not correct.
     if (!IsPowerOfTwo(in_stride))
       return OnCorruptDatabase();
+
+    // A delta's chunk lists already account for the main file's.
+    if (!has_delta_) {
+      add_chunks_cache_.insert(main_add_chunks.begin(), main_add_chunks.end());
+      sub_chunks_cache_.insert(main_sub_chunks.begin(), main_sub_chunks.end());
+    }
+  }
+
+  // Deletions which would have to be applied to the main file.  Deleting a
+  // chunk whose data may be in the delta forces a full rewrite, because the
+  // delta alone cannot undo the subs that chunk already applied to the main
+  // file's data.
+  base::hash_set<int32> pending_add_del(prior_add_del);
+  base::hash_set<int32> pending_sub_del(prior_sub_del);
+  bool deletes_delta_chunks = false;
+  for (base::hash_set<int32>::const_iterator iter = add_del_cache_.begin();
+       iter != add_del_cache_.end(); ++iter) {
+    if (!main_add_chunks.count(*iter) || !pending_add_del.insert(*iter).second)
+      deletes_delta_chunks = true;
+  }
+  for (base::hash_set<int32>::const_iterator iter = sub_del_cache_.begin();
+       iter != sub_del_cache_.end(); ++iter) {
+    if (!main_sub_chunks.count(*iter) || !pending_sub_del.insert(*iter).second)
+      deletes_delta_chunks = true;
   }
 
   // We no longer need to track deleted chunks.
   DeleteChunksFromSet(add_del_cache_, &add_chunks_cache_);
   DeleteChunksFromSet(sub_del_cache_, &sub_chunks_cache_);
 
-  // Calculate |out_stride| to break the file down into reasonable shards.
+  // Calculate |out_stride| to break the file down into reasonable shards, and
+  // decide whether to write a delta or rewrite the main file.
+  bool write_delta = false;
   {
     int64 original_size = 0;
     if (!empty_ && !base::GetFileSize(filename_, &original_size))
       return OnCorruptDatabase();
 
+    const int64 main_chunks = main_add_chunks.size() + main_sub_chunks.size();
+    const int64 pending_dels = pending_add_del.size() + pending_sub_del.size();
+    write_delta = !empty_ && version == kFileVersion &&
+        !deletes_delta_chunks &&
+        original_size >= min_delta_base_bytes_ &&
+        delta_state.ApproximateBytes() * kDeltaCompactRatio <= original_size &&
+        pending_dels * kDeltaCompactRatio <= main_chunks;
+
     // Approximate the final size as everything.  Subs and deletes will reduce
     // the size, but modest over-sharding won't hurt much.
     int64 shard_size = original_size + update_size;
@@ -1023,7 +1328,8 @@ bool SafeBrowsingStoreFile::DoUpdate(
 
   // Start writing the new data to |new_file_|.
   base::MD5Context out_context;
-  if (!WriteHeader(out_stride, add_chunks_cache_, sub_chunks_cache_,
+  if (!write_delta &&
+      !WriteHeader(out_stride, add_chunks_cache_, sub_chunks_cache_,
                    new_file_.get(), &out_context)) {
     return false;
   }
@@ -1034,7 +1340,7 @@ bool SafeBrowsingStoreFile::DoUpdate(
   uint64 process_min = 0;
 
   // Start at the beginning of the updates.
-  StateInternalPos new_pos = new_state.StateBegin();
+  StateInternalPos delta_pos = delta_state.StateBegin();
 
   // Re-usable container for shard processing.
   StateInternal db_state;
@@ -1042,6 +1348,7 @@ bool SafeBrowsingStoreFile::DoUpdate(
   // Track aggregate counts for histograms.
   size_t add_prefix_count = 0;
   size_t sub_prefix_count = 0;
+  int64 peak_bytes = 0;
 
   do {
     // Maximum element in the current shard.
@@ -1084,16 +1391,20 @@ bool SafeBrowsingStoreFile::DoUpdate(
           in_min += in_stride;
         } while (in_min <= kMaxSBPrefix && in_min < process_max);
       }
+
+      // Drop main file data from chunks deleted by earlier delta updates.
+      db_state.ApplyDeletions(prior_add_del, prior_sub_del);
     }
 
     // Shard the update data to match the database data, then merge the update
     // data and process the results.
     {
-      StateInternalPos new_end = new_state.ShardEnd(new_pos, process_max);
-      db_state.MergeDataAndProcess(new_pos, new_end,
+      StateInternalPos delta_end = delta_state.ShardEnd(delta_pos, process_max);
+      db_state.MergeDataAndProcess(delta_pos, delta_end,
                                    add_del_cache_, sub_del_cache_);
-      new_pos = new_end;
+      delta_pos = delta_end;
     }
+    peak_bytes = std::max(peak_bytes, db_state.ApproximateBytes());
 
     // Collect the processed data for return to caller.
     for (size_t i = 0; i < db_state.add_prefixes_.size(); ++i) {
@@ -1106,19 +1417,22 @@ bool SafeBrowsingStoreFile::DoUpdate(
     sub_prefix_count += db_state.sub_prefixes_.size();
 
     // Write one or more shards of processed output.
-    StateInternalPos out_pos = db_state.StateBegin();
-    do {
-      SBPrefix out_max = static_cast<SBPrefix>(out_min + out_stride - 1);
-      DCHECK_GT(out_max, out_min);
-
-      StateInternalPos out_end = db_state.ShardEnd(out_pos, out_max);
-      if (!db_state.WriteShard(out_pos, out_end, new_file_.get(), &out_context))
-        return false;
-      out_pos = out_end;
-
-      out_min += out_stride;
-    } while (out_min == static_cast<SBPrefix>(out_min) &&
-             out_min < process_max);
+    if (!write_delta) {
+      StateInternalPos out_pos = db_state.StateBegin();
+      do {
+        SBPrefix out_max = static_cast<SBPrefix>(out_min + out_stride - 1);
+        DCHECK_GT(out_max, out_min);
+
+        StateInternalPos out_end = db_state.ShardEnd(out_pos, out_max);
+        if (!db_state.WriteShard(out_pos, out_end,
+                                 new_file_.get(), &out_context))
+          return false;
+        out_pos = out_end;
+
+        out_min += out_stride;
+      } while (out_min == static_cast<SBPrefix>(out_min) &&
+               out_min < process_max);
+    }
 
     process_min += process_stride;
   } while (process_min <= kMaxSBPrefix);
@@ -1137,11 +1451,25 @@ bool SafeBrowsingStoreFile::DoUpdate(
   }
   DCHECK(!file_.get());
 
-  // Write the overall checksum.
-  base::MD5Digest out_digest;
-  base::MD5Final(&out_digest, &out_context);
-  if (!WriteItem(out_digest, new_file_.get(), NULL))
-    return false;
+  if (write_delta) {
+    // Leave the main file alone and replace the delta segment.
+    base::MD5Digest main_digest;
+    if (!ReadTrailingDigest(filename_, &main_digest))
+      return OnCorruptDatabase();
+    if (!WriteDeltaFile(main_digest, add_chunks_cache_, sub_chunks_cache_,
+                        pending_add_del, pending_sub_del, delta_state,
+                        new_file_.get())) {
+      return false;
+    }
+  } else {
+    // Write the overall checksum.
+    base::MD5Digest out_digest;
+    base::MD5Final(&out_digest, &out_context);
+    if (!WriteItem(out_digest, new_file_.get(), NULL))
+      return false;
+  }
+
+  const int64 written_bytes = ftell(new_file_.get());
 
   // Trim any excess left over from the temporary chunk data.
   if (!base::TruncateFile(new_file_.get()))
@@ -1149,17 +1477,38 @@ bool SafeBrowsingStoreFile::DoUpdate(
 
   // Close the file handle and swizzle the file into place.
   new_file_.reset();
-  if (!base::DeleteFile(filename_, false) &&
-      base::PathExists(filename_))
-    return false;
-
   const base::FilePath new_filename = TemporaryFileForFilename(filename_);
-  if (!base::Move(new_filename, filename_))
-    return false;
+  const base::FilePath delta_filename = DeltaFileForFilename(filename_);
+  if (write_delta) {
+    if (!base::Move(new_filename, delta_filename))
+      return false;
+  } else {
+    // The delta must go first, else a stale delta could be read against the
+    // new main file if the process dies between the steps.  The checksum
+    // check would reject it, but there is no reason to rely on that.
+    if (!base::DeleteFile(delta_filename, false) &&
+        base::PathExists(delta_filename))
+      return false;
+
+    if (!base::DeleteFile(filename_, false) &&
+        base::PathExists(filename_))
+      return false;
+
+    if (!base::Move(new_filename, filename_))
+      return false;
+  }
 
   // Record counts before swapping to caller.
   UMA_HISTOGRAM_COUNTS("SB2.AddPrefixes", add_prefix_count);
   UMA_HISTOGRAM_COUNTS("SB2.SubPrefixes", sub_prefix_count);
+  UMA_HISTOGRAM_COUNTS("SB2.StoreUpdateWriteKilobytes",
+                       static_cast<int>(written_bytes / 1024));
+  UMA_HISTOGRAM_BOOLEAN("SB2.StoreUpdateCompacted", !write_delta);
+  UMA_HISTOGRAM_COUNTS(
+      "SB2.StoreUpdatePeakKilobytes",
+      static_cast<int>((peak_bytes + delta_state.ApproximateBytes()) / 1024));
+  UMA_HISTOGRAM_TIMES("SB2.StoreUpdateTime",
+                      base::TimeTicks::Now() - update_start);
 
   return true;
 }
@@ -1234,6 +1583,13 @@ bool SafeBrowsingStoreFile::DeleteStore(const base::FilePath& basename) {
     return false;
   }
 
+  const base::FilePath delta_filename = DeltaFileForFilename(basename);
+  if (!base::DeleteFile(delta_filename, false) &&
+      base::PathExists(delta_filename)) {
+    NOTREACHED();
+    return false;
+  }
+
   // With SQLite support gone, one way to get to this code is if the
   // existing file is a SQLite file.  Make sure the journal file is
   // also removed.
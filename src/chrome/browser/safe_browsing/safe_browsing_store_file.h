@@ -121,6 +121,42 @@
 //     - Write shards to the temp file.
 //   - Delete original file.
 //   - Rename temp file to original filename.
+//
+// Rewriting the whole file costs I/O proportional to the database size, while
+// most updates only touch a small fraction of it.  So once the main file is
+// large, updates are instead accumulated in a delta segment file next to it
+// (see DeltaFileForFilename()).  The delta holds every chunk received since
+// the main file was last written, already netted against itself, plus the ids
+// of chunks deleted since then:
+//
+// int32 magic;                 // kDeltaMagic
+// int32 version;               // kDeltaVersion
+// uint32 add_chunk_count;      // Chunks seen, superseding the main file's.
+// uint32 sub_chunk_count;
+// uint32 add_del_count;        // Chunks deleted since the main file was
+// uint32 sub_del_count;        // written.
+// uint32 add_prefix_count;
+// uint32 sub_prefix_count;
+// uint32 add_hash_count;
+// uint32 sub_hash_count;
+// MD5Digest main_checksum;     // Final checksum of the main file.
+// array[add_chunk_count], array[sub_chunk_count] {
+//   int32 chunk_id;
+// }
+// array[add_del_count], array[sub_del_count] {
+//   int32 chunk_id;
+// }
+// Sorted add/sub prefix/hash arrays, as in a main file shard.
+// MD5Digest checksum;          // Checksum over entire file.
+//
+// Readers filter each main file shard by the deleted chunks, then merge the
+// matching range of the delta.  The main file is never modified by a delta
+// update, and is consistent by itself.  A delta which is missing, corrupt, or
+// whose |main_checksum| does not match is ignored, which just causes the
+// server to resend its chunks.  When the delta grows past a fraction of the
+// main file, the update folds it into a full rewrite as described above and
+// removes it.  This only saves writes: every update still reads all of the
+// main file's shards, because the prefix set is rebuilt from the full data.
 
 class SafeBrowsingStoreFile : public SafeBrowsingStore {
  public:
@@ -177,9 +213,22 @@ class SafeBrowsingStoreFile : public SafeBrowsingStore {
     return base::FilePath(filename.value() + FILE_PATH_LITERAL("_new"));
   }
 
+  // Returns the name of the delta segment holding updates which have not
+  // yet been merged into |filename|.  Exported for unit tests.
+  static const base::FilePath DeltaFileForFilename(
+      const base::FilePath& filename) {
+    return base::FilePath(filename.value() + FILE_PATH_LITERAL("_delta"));
+  }
+
   // Delete any on-disk files, including the permanent storage.
   static bool DeleteStore(const base::FilePath& basename);
 
+  // Main files smaller than |bytes| are always rewritten in full, since the
+  // rewrite is cheap.  Lets tests exercise delta updates on small stores.
+  void SetMinDeltaBaseBytesForTesting(int64 bytes) {
+    min_delta_base_bytes_ = bytes;
+  }
+
  private:
   // Does the actual update for FinishUpdate(), so that FinishUpdate() can clean
   // up correctly in case of error.
@@ -225,6 +274,13 @@ class SafeBrowsingStoreFile : public SafeBrowsingStore {
     std::set<int32>().swap(sub_chunks_cache_);
     base::hash_set<int32>().swap(add_del_cache_);
     base::hash_set<int32>().swap(sub_del_cache_);
+    has_delta_ = false;
+    SBAddPrefixes().swap(delta_add_prefixes_);
+    SBSubPrefixes().swap(delta_sub_prefixes_);
+    std::vector<SBAddFullHash>().swap(delta_add_hashes_);
+    std::vector<SBSubFullHash>().swap(delta_sub_hashes_);
+    base::hash_set<int32>().swap(delta_add_del_);
+    base::hash_set<int32>().swap(delta_sub_del_);
   }
 
   // Buffers for collecting data between BeginChunk() and
@@ -246,6 +302,22 @@ class SafeBrowsingStoreFile : public SafeBrowsingStore {
   base::ScopedFILE new_file_;
   bool empty_;
 
+  // True if a valid delta segment was found by BeginUpdate(), in which case
+  // the chunk caches were loaded from it rather than the main file.
+  bool has_delta_;
+
+  // The data and deleted chunks of the delta segment, kept from BeginUpdate()
+  // for DoUpdate() so that the delta is only read once per update.
+  SBAddPrefixes delta_add_prefixes_;
+  SBSubPrefixes delta_sub_prefixes_;
+  std::vector<SBAddFullHash> delta_add_hashes_;
+  std::vector<SBSubFullHash> delta_sub_hashes_;
+  base::hash_set<int32> delta_add_del_;
+  base::hash_set<int32> delta_sub_del_;
+
+  // See SetMinDeltaBaseBytesForTesting().
+  int64 min_delta_base_bytes_;
+
   // Cache of chunks which have been seen.  Loaded from the database
   // on BeginUpdate() so that it can be queried during the
   // transaction.
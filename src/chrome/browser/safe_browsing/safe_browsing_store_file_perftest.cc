@@ -0,0 +1,145 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/safe_browsing/safe_browsing_store_file.h"
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/rand_util.h"
+#include "base/time/time.h"
+#include "chrome/browser/safe_browsing/prefix_set.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace {
+
+// About the size of a well-used browse store: 800 add chunks of 1000
+// prefixes, over 6MB of main file.
+const int kMainChunkCount = 800;
+const int kPrefixesPerChunk = 1000;
+
+// Updates timed against the populated store, each one new add chunk and one
+// sub chunk, which is typical of the periodic updates.
+const int kUpdateCount = 10;
+const int kSubsPerChunk = 50;
+
+// Adds |add_chunk| with random prefixes, and |sub_chunk| knocking out some of
+// the prefixes of |sub_target_chunk|, to the update in progress.
+void WriteChunks(SafeBrowsingStoreFile* store,
+                 int add_chunk,
+                 int sub_chunk,
+                 int sub_target_chunk,
+                 const std::vector<SBPrefix>& sub_targets) {
+  ASSERT_TRUE(store->BeginChunk());
+  store->SetAddChunk(add_chunk);
+  for (int i = 0; i < kPrefixesPerChunk; ++i) {
+    ASSERT_TRUE(store->WriteAddPrefix(
+        add_chunk, static_cast<SBPrefix>(base::RandUint64())));
+  }
+  ASSERT_TRUE(store->FinishChunk());
+
+  if (sub_targets.empty())
+    return;
+  ASSERT_TRUE(store->BeginChunk());
+  store->SetSubChunk(sub_chunk);
+  for (size_t i = 0; i < sub_targets.size(); ++i) {
+    ASSERT_TRUE(store->WriteSubPrefix(sub_chunk, sub_target_chunk,
+                                      sub_targets[i]));
+  }
+  ASSERT_TRUE(store->FinishChunk());
+}
+
+bool FinishUpdate(SafeBrowsingStoreFile* store) {
+  safe_browsing::PrefixSetBuilder builder;
+  std::vector<SBAddFullHash> add_full_hashes_result;
+  return store->FinishUpdate(&builder, &add_full_hashes_result);
+}
+
+// Populates a store in |dir|, then runs |kUpdateCount| small updates against
+// it and reports the time per update and the bytes the updates wrote.
+// |min_delta_base_bytes| decides whether the updates write a delta segment.
+void RunUpdates(const base::FilePath& dir,
+                int64 min_delta_base_bytes,
+                const std::string& trace) {
+  const base::FilePath filename = dir.AppendASCII("SafeBrowsingPerfStore");
+  const base::FilePath delta_filename =
+      SafeBrowsingStoreFile::DeltaFileForFilename(filename);
+  SafeBrowsingStoreFile store;
+  store.Init(filename, base::Bind(&base::DoNothing));
+
+  ASSERT_TRUE(store.BeginUpdate());
+  for (int i = 0; i < kMainChunkCount; ++i)
+    WriteChunks(&store, i + 1, 0, 0, std::vector<SBPrefix>());
+  ASSERT_TRUE(FinishUpdate(&store));
+  int64 main_size = 0;
+  ASSERT_TRUE(base::GetFileSize(filename, &main_size));
+
+  // Subs target prefixes of the main file, so that they are applied to it.
+  SBAddPrefixes add_prefixes;
+  ASSERT_TRUE(store.GetAddPrefixes(&add_prefixes));
+  ASSERT_EQ(static_cast<size_t>(kMainChunkCount * kPrefixesPerChunk),
+            add_prefixes.size());
+
+  store.SetMinDeltaBaseBytesForTesting(min_delta_base_bytes);
+  int64 written_bytes = 0;
+  base::TimeDelta elapsed;
+  for (int i = 0; i < kUpdateCount; ++i) {
+    std::vector<SBPrefix> sub_targets;
+    int sub_target_chunk = 0;
+    for (size_t j = 0; j < add_prefixes.size() &&
+             sub_targets.size() < static_cast<size_t>(kSubsPerChunk); ++j) {
+      if (add_prefixes[j].chunk_id != i + 1)
+        continue;
+      sub_target_chunk = add_prefixes[j].chunk_id;
+      sub_targets.push_back(add_prefixes[j].prefix);
+    }
+
+    const base::TimeTicks start = base::TimeTicks::Now();
+    ASSERT_TRUE(store.BeginUpdate());
+    WriteChunks(&store, kMainChunkCount + i + 1, i + 1, sub_target_chunk,
+                sub_targets);
+    ASSERT_TRUE(FinishUpdate(&store));
+    elapsed += base::TimeTicks::Now() - start;
+
+    // A delta update rewrites the delta, a full update the main file.
+    int64 size = 0;
+    if (base::PathExists(delta_filename)) {
+      ASSERT_TRUE(base::GetFileSize(delta_filename, &size));
+    } else {
+      ASSERT_TRUE(base::GetFileSize(filename, &size));
+    }
+    written_bytes += size;
+  }
+
+  perf_test::PrintResult("store_update_time", "", trace,
+                         elapsed.InMillisecondsF() / kUpdateCount,
+                         "ms/update", true);
+  perf_test::PrintResult("store_update_written", "", trace,
+                         static_cast<size_t>(written_bytes / kUpdateCount),
+                         "bytes/update", true);
+  perf_test::PrintResult("store_main_file", "", trace,
+                         static_cast<size_t>(main_size), "bytes", false);
+
+  EXPECT_TRUE(store.Delete());
+}
+
+}  // namespace
+
+// Compares small updates to a realistically sized store when they are written
+// to a delta segment and when they rewrite the main file.  Both read the whole
+// main file, so the difference is in the writes.
+TEST(SafeBrowsingStoreFilePerfTest, DeltaUpdate) {
+  base::ScopedTempDir full_dir;
+  ASSERT_TRUE(full_dir.CreateUniqueTempDir());
+  RunUpdates(full_dir.path(), kint64max, "full_rewrite");
+
+  base::ScopedTempDir delta_dir;
+  ASSERT_TRUE(delta_dir.CreateUniqueTempDir());
+  RunUpdates(delta_dir.path(), 0, "delta");
+}
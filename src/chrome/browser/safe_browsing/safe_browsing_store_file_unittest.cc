@@ -31,6 +31,10 @@ const SBFullHash kHash4 = SBFullHashForString("four");
 const SBFullHash kHash5 = SBFullHashForString("five");
 const SBFullHash kHash6 = SBFullHashForString("six");
 
+// Chunks used by PopulateManyChunks().
+const int kManyChunkBase = 100;
+const int kManyChunkCount = 10;
+
 const SBPrefix kMinSBPrefix = 0u;
 const SBPrefix kMaxSBPrefix = ~kMinSBPrefix;
 
@@ -102,6 +106,26 @@ class SafeBrowsingStoreFileTest : public PlatformTest {
     EXPECT_TRUE(store_->FinishUpdate(&builder, &add_full_hashes_result));
   }
 
+  // Populate the store with |kManyChunkCount| add chunks of one prefix each,
+  // enough that deleting one of them can be recorded in a delta.
+  void PopulateManyChunks() {
+    ASSERT_TRUE(store_->BeginUpdate());
+    for (int i = 0; i < kManyChunkCount; ++i) {
+      EXPECT_TRUE(store_->BeginChunk());
+      store_->SetAddChunk(kManyChunkBase + i);
+      EXPECT_TRUE(store_->WriteAddPrefix(kManyChunkBase + i, ManyPrefix(i)));
+      EXPECT_TRUE(store_->FinishChunk());
+    }
+
+    safe_browsing::PrefixSetBuilder builder;
+    std::vector<SBAddFullHash> add_full_hashes_result;
+    EXPECT_TRUE(store_->FinishUpdate(&builder, &add_full_hashes_result));
+  }
+
+  static SBPrefix ManyPrefix(int i) {
+    return static_cast<SBPrefix>(i + 1) * 0x01000000u;
+  }
+
   // Manually read the shard stride info from the file.
   uint32 ReadStride() {
     base::ScopedFILE file(base::OpenFile(filename_, "rb"));
@@ -472,6 +496,264 @@ TEST_F(SafeBrowsingStoreFileTest, DeleteTemp) {
   EXPECT_FALSE(base::PathExists(temp_file));
 }
 
+// Test that updates to a large enough store are written to a delta segment,
+// leaving the main file untouched, and that the delta is read back.
+TEST_F(SafeBrowsingStoreFileTest, DeltaUpdate) {
+  store_->SetMinDeltaBaseBytesForTesting(0);
+  PopulateStore();
+
+  const base::FilePath delta_file =
+      SafeBrowsingStoreFile::DeltaFileForFilename(filename_);
+  EXPECT_FALSE(base::PathExists(delta_file));
+  std::string original_contents;
+  ASSERT_TRUE(base::ReadFileToString(filename_, &original_contents));
+
+  ASSERT_TRUE(store_->BeginUpdate());
+  EXPECT_TRUE(store_->BeginChunk());
+  store_->SetAddChunk(kAddChunk3);
+  EXPECT_TRUE(store_->WriteAddPrefix(kAddChunk3, kHash5.prefix));
+  EXPECT_TRUE(store_->FinishChunk());
+
+  {
+    safe_browsing::PrefixSetBuilder builder;
+    std::vector<SBAddFullHash> add_full_hashes_result;
+    EXPECT_TRUE(store_->FinishUpdate(&builder, &add_full_hashes_result));
+
+    std::vector<SBPrefix> prefixes_result;
+    builder.GetPrefixSetNoHashes()->GetPrefixes(&prefixes_result);
+    ASSERT_EQ(3U, prefixes_result.size());
+    EXPECT_EQ(kHash1.prefix, prefixes_result[0]);
+    EXPECT_EQ(kHash5.prefix, prefixes_result[1]);
+    EXPECT_EQ(kHash2.prefix, prefixes_result[2]);
+
+    ASSERT_EQ(1U, add_full_hashes_result.size());
+    EXPECT_TRUE(SBFullHashEqual(kHash4, add_full_hashes_result[0].full_hash));
+  }
+
+  EXPECT_TRUE(base::PathExists(delta_file));
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(filename_, &contents));
+  EXPECT_EQ(original_contents, contents);
+
+  // A fresh store sees the main file and the delta together.
+  store_.reset(new SafeBrowsingStoreFile());
+  store_->Init(filename_,
+               base::Bind(&SafeBrowsingStoreFileTest::OnCorruptionDetected,
+                          base::Unretained(this)));
+  store_->SetMinDeltaBaseBytesForTesting(0);
+
+  SBAddPrefixes add_prefixes;
+  EXPECT_TRUE(store_->GetAddPrefixes(&add_prefixes));
+  ASSERT_EQ(3U, add_prefixes.size());
+  EXPECT_EQ(kAddChunk1, add_prefixes[0].chunk_id);
+  EXPECT_EQ(kHash1.prefix, add_prefixes[0].prefix);
+  EXPECT_EQ(kAddChunk3, add_prefixes[1].chunk_id);
+  EXPECT_EQ(kHash5.prefix, add_prefixes[1].prefix);
+  EXPECT_EQ(kAddChunk1, add_prefixes[2].chunk_id);
+  EXPECT_EQ(kHash2.prefix, add_prefixes[2].prefix);
+
+  ASSERT_TRUE(store_->BeginUpdate());
+  std::vector<int> chunks;
+  store_->GetAddChunks(&chunks);
+  ASSERT_EQ(3U, chunks.size());
+  EXPECT_EQ(kAddChunk1, chunks[0]);
+  EXPECT_EQ(kAddChunk2, chunks[1]);
+  EXPECT_EQ(kAddChunk3, chunks[2]);
+  EXPECT_TRUE(store_->CheckSubChunk(kSubChunk1));
+
+  {
+    safe_browsing::PrefixSetBuilder builder;
+    std::vector<SBAddFullHash> add_full_hashes_result;
+    EXPECT_TRUE(store_->FinishUpdate(&builder, &add_full_hashes_result));
+
+    std::vector<SBPrefix> prefixes_result;
+    builder.GetPrefixSetNoHashes()->GetPrefixes(&prefixes_result);
+    EXPECT_EQ(3U, prefixes_result.size());
+    EXPECT_EQ(1U, add_full_hashes_result.size());
+  }
+  EXPECT_FALSE(corruption_detected_);
+}
+
+// Test that deleting a main file chunk is recorded in the delta, and that the
+// chunk can be added again afterwards.
+TEST_F(SafeBrowsingStoreFileTest, DeltaDeleteChunks) {
+  store_->SetMinDeltaBaseBytesForTesting(0);
+  PopulateManyChunks();
+
+  const base::FilePath delta_file =
+      SafeBrowsingStoreFile::DeltaFileForFilename(filename_);
+  std::string original_contents;
+  ASSERT_TRUE(base::ReadFileToString(filename_, &original_contents));
+
+  ASSERT_TRUE(store_->BeginUpdate());
+  store_->DeleteAddChunk(kManyChunkBase);
+  {
+    safe_browsing::PrefixSetBuilder builder;
+    std::vector<SBAddFullHash> add_full_hashes_result;
+    EXPECT_TRUE(store_->FinishUpdate(&builder, &add_full_hashes_result));
+
+    std::vector<SBPrefix> prefixes_result;
+    builder.GetPrefixSetNoHashes()->GetPrefixes(&prefixes_result);
+    ASSERT_EQ(static_cast<size_t>(kManyChunkCount - 1),
+              prefixes_result.size());
+    EXPECT_EQ(ManyPrefix(1), prefixes_result[0]);
+  }
+  EXPECT_TRUE(base::PathExists(delta_file));
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(filename_, &contents));
+  EXPECT_EQ(original_contents, contents);
+
+  // Re-add the deleted chunk with different data.
+  ASSERT_TRUE(store_->BeginUpdate());
+  EXPECT_FALSE(store_->CheckAddChunk(kManyChunkBase));
+  EXPECT_TRUE(store_->CheckAddChunk(kManyChunkBase + 1));
+  EXPECT_TRUE(store_->BeginChunk());
+  store_->SetAddChunk(kManyChunkBase);
+  EXPECT_TRUE(store_->WriteAddPrefix(kManyChunkBase, kHash1.prefix));
+  EXPECT_TRUE(store_->FinishChunk());
+  {
+    safe_browsing::PrefixSetBuilder builder;
+    std::vector<SBAddFullHash> add_full_hashes_result;
+    EXPECT_TRUE(store_->FinishUpdate(&builder, &add_full_hashes_result));
+  }
+  EXPECT_TRUE(base::PathExists(delta_file));
+
+  SBAddPrefixes add_prefixes;
+  EXPECT_TRUE(store_->GetAddPrefixes(&add_prefixes));
+  ASSERT_EQ(static_cast<size_t>(kManyChunkCount), add_prefixes.size());
+  for (size_t i = 0; i < add_prefixes.size(); ++i) {
+    EXPECT_NE(ManyPrefix(0), add_prefixes[i].prefix);
+  }
+
+  ASSERT_TRUE(store_->BeginUpdate());
+  EXPECT_TRUE(store_->CheckAddChunk(kManyChunkBase));
+  {
+    safe_browsing::PrefixSetBuilder builder;
+    std::vector<SBAddFullHash> add_full_hashes_result;
+    EXPECT_TRUE(store_->FinishUpdate(&builder, &add_full_hashes_result));
+  }
+  EXPECT_FALSE(corruption_detected_);
+}
+
+// Test that a large enough delta is folded back into the main file.
+TEST_F(SafeBrowsingStoreFileTest, DeltaCompaction) {
+  store_->SetMinDeltaBaseBytesForTesting(0);
+  PopulateStore();
+
+  ASSERT_TRUE(store_->BeginUpdate());
+  EXPECT_TRUE(store_->BeginChunk());
+  store_->SetAddChunk(kAddChunk3);
+  EXPECT_TRUE(store_->WriteAddPrefix(kAddChunk3, kHash5.prefix));
+  EXPECT_TRUE(store_->FinishChunk());
+  {
+    safe_browsing::PrefixSetBuilder builder;
+    std::vector<SBAddFullHash> add_full_hashes_result;
+    EXPECT_TRUE(store_->FinishUpdate(&builder, &add_full_hashes_result));
+  }
+
+  const base::FilePath delta_file =
+      SafeBrowsingStoreFile::DeltaFileForFilename(filename_);
+  EXPECT_TRUE(base::PathExists(delta_file));
+
+  // Too small for a delta, so the update rewrites the main file.
+  store_->SetMinDeltaBaseBytesForTesting(1024 * 1024 * 1024);
+  ASSERT_TRUE(store_->BeginUpdate());
+  {
+    safe_browsing::PrefixSetBuilder builder;
+    std::vector<SBAddFullHash> add_full_hashes_result;
+    EXPECT_TRUE(store_->FinishUpdate(&builder, &add_full_hashes_result));
+
+    std::vector<SBPrefix> prefixes_result;
+    builder.GetPrefixSetNoHashes()->GetPrefixes(&prefixes_result);
+    EXPECT_EQ(3U, prefixes_result.size());
+  }
+  EXPECT_FALSE(base::PathExists(delta_file));
+
+  SBAddPrefixes add_prefixes;
+  EXPECT_TRUE(store_->GetAddPrefixes(&add_prefixes));
+  EXPECT_EQ(3U, add_prefixes.size());
+
+  ASSERT_TRUE(store_->BeginUpdate());
+  EXPECT_TRUE(store_->CheckAddChunk(kAddChunk3));
+  {
+    safe_browsing::PrefixSetBuilder builder;
+    std::vector<SBAddFullHash> add_full_hashes_result;
+    EXPECT_TRUE(store_->FinishUpdate(&builder, &add_full_hashes_result));
+  }
+  EXPECT_FALSE(corruption_detected_);
+}
+
+// Test that a corrupt delta, or one written against another main file, is
+// ignored rather than treated as corruption of the store.
+TEST_F(SafeBrowsingStoreFileTest, DeltaIgnoredIfInvalid) {
+  store_->SetMinDeltaBaseBytesForTesting(0);
+  PopulateStore();
+
+  ASSERT_TRUE(store_->BeginUpdate());
+  EXPECT_TRUE(store_->BeginChunk());
+  store_->SetAddChunk(kAddChunk3);
+  EXPECT_TRUE(store_->WriteAddPrefix(kAddChunk3, kHash5.prefix));
+  EXPECT_TRUE(store_->FinishChunk());
+  {
+    safe_browsing::PrefixSetBuilder builder;
+    std::vector<SBAddFullHash> add_full_hashes_result;
+    EXPECT_TRUE(store_->FinishUpdate(&builder, &add_full_hashes_result));
+  }
+
+  const base::FilePath delta_file =
+      SafeBrowsingStoreFile::DeltaFileForFilename(filename_);
+  const base::FilePath saved_delta_file =
+      filename_.AddExtension(FILE_PATH_LITERAL("saved"));
+  ASSERT_TRUE(base::CopyFile(delta_file, saved_delta_file));
+
+  // Corrupt the delta's data.
+  int64 delta_size = 0;
+  ASSERT_TRUE(base::GetFileSize(delta_file, &delta_size));
+  base::ScopedFILE file(base::OpenFile(delta_file, "rb+"));
+  const long kOffset = static_cast<long>(delta_size) - 20;
+  EXPECT_EQ(fseek(file.get(), kOffset, SEEK_SET), 0);
+  const uint32 kOnes = ~0u;
+  EXPECT_EQ(fwrite(&kOnes, sizeof(kOnes), 1, file.get()), 1U);
+  file.reset();
+
+  {
+    SBAddPrefixes add_prefixes;
+    EXPECT_TRUE(store_->GetAddPrefixes(&add_prefixes));
+    EXPECT_EQ(2U, add_prefixes.size());
+  }
+
+  // Rewrite the main file with different data, then put back the old delta.
+  store_->SetMinDeltaBaseBytesForTesting(1024 * 1024 * 1024);
+  ASSERT_TRUE(store_->BeginUpdate());
+  EXPECT_FALSE(store_->CheckAddChunk(kAddChunk3));
+  EXPECT_TRUE(store_->BeginChunk());
+  store_->SetAddChunk(kAddChunk4);
+  EXPECT_TRUE(store_->WriteAddPrefix(kAddChunk4, kHash6.prefix));
+  EXPECT_TRUE(store_->FinishChunk());
+  {
+    safe_browsing::PrefixSetBuilder builder;
+    std::vector<SBAddFullHash> add_full_hashes_result;
+    EXPECT_TRUE(store_->FinishUpdate(&builder, &add_full_hashes_result));
+  }
+  EXPECT_FALSE(base::PathExists(delta_file));
+  ASSERT_TRUE(base::CopyFile(saved_delta_file, delta_file));
+
+  {
+    SBAddPrefixes add_prefixes;
+    EXPECT_TRUE(store_->GetAddPrefixes(&add_prefixes));
+    EXPECT_EQ(3U, add_prefixes.size());
+  }
+  ASSERT_TRUE(store_->BeginUpdate());
+  EXPECT_FALSE(store_->CheckAddChunk(kAddChunk3));
+  EXPECT_TRUE(store_->CheckAddChunk(kAddChunk4));
+  {
+    safe_browsing::PrefixSetBuilder builder;
+    std::vector<SBAddFullHash> add_full_hashes_result;
+    EXPECT_TRUE(store_->FinishUpdate(&builder, &add_full_hashes_result));
+  }
+  EXPECT_FALSE(corruption_detected_);
+}
+
 // Test basic corruption-handling.
 TEST_F(SafeBrowsingStoreFileTest, DetectsCorruption) {
   // Load a store with some data.
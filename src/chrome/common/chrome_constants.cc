@@ -177,6 +177,8 @@ const base::FilePath::CharType kMediaCacheDirname[] = FPL("Media Cache");
 const base::FilePath::CharType kNewTabThumbnailsFilename[] =
     FPL("Top Thumbnails");
 const base::FilePath::CharType kOBCertFilename[] = FPL("Origin Bound Certs");
+const base::FilePath::CharType kPredictorReferrerGraphFilename[] =
+    FPL("Predictor Referrer Graph");
 const base::FilePath::CharType kPreferencesFilename[] = FPL("Preferences");
 const base::FilePath::CharType kProtectedPreferencesFilename[] =
     FPL("Protected Preferences");
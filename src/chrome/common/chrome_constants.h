@@ -75,6 +75,7 @@ extern const base::FilePath::CharType kManagedUserSettingsFilename[];
 extern const base::FilePath::CharType kMediaCacheDirname[];
 extern const base::FilePath::CharType kNewTabThumbnailsFilename[];
 extern const base::FilePath::CharType kOBCertFilename[];
+extern const base::FilePath::CharType kPredictorReferrerGraphFilename[];
 extern const base::FilePath::CharType kPreferencesFilename[];
 extern const base::FilePath::CharType kProtectedPreferencesFilename[];
 extern const base::FilePath::CharType kReadmeFilename[];
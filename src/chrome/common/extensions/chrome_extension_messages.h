@@ -8,6 +8,10 @@
 //
 // Multiply-included message file, hence no include guard.
 
+#include <string>
+#include <vector>
+
+#include "base/memory/shared_memory.h"
 #include "chrome/common/extensions/api/webstore/webstore_api_constants.h"
 #include "chrome/common/web_application_info.h"
 #include "ipc/ipc_message_macros.h"
@@ -31,8 +35,35 @@ IPC_STRUCT_TRAITS_BEGIN(WebApplicationInfo)
   IPC_STRUCT_TRAITS_MEMBER(icons)
 IPC_STRUCT_TRAITS_END()
 
+// The content scripts of one extension, as a UserScriptBundle image in
+// read-only shared memory.
+IPC_STRUCT_BEGIN(ChromeExtensionMsg_UserScriptSegment)
+  IPC_STRUCT_MEMBER(std::string, extension_id)
+
+  // Invalid if the extension no longer has any content scripts.
+  IPC_STRUCT_MEMBER(base::SharedMemoryHandle, handle)
+IPC_STRUCT_END()
+
 // Messages sent from the browser to the renderer.
 
+// Notification that the content scripts of some extensions changed since the
+// last update.  Each segment replaces the scripts the renderer holds for its
+// extension; the scripts of other extensions are unchanged.  |version|
+// identifies the update.
+IPC_MESSAGE_CONTROL2(ChromeExtensionMsg_UpdateUserScriptSegments,
+                     uint32 /* version */,
+                     std::vector<ChromeExtensionMsg_UserScriptSegment>)
+
+// Delivers a message from a native messaging host whose serialized payload is
+// in read-only shared memory, in place of ExtensionMsg_DeliverMessage.  Used
+// for large payloads, which are then not copied into the IPC message and
+// through the channel.
+IPC_MESSAGE_ROUTED4(ChromeExtensionMsg_DeliverSharedMessage,
+                    int /* target_port_id */,
+                    base::SharedMemoryHandle /* payload */,
+                    uint32 /* payload size */,
+                    bool /* user_gesture */)
+
 // Requests application info for the page. The renderer responds back with
 // ExtensionHostMsg_DidGetApplicationInfo.
 IPC_MESSAGE_ROUTED1(ChromeExtensionMsg_GetApplicationInfo,
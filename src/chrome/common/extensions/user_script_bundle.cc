@@ -0,0 +1,587 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/common/extensions/user_script_bundle.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
+#include "content/public/common/url_constants.h"
+#include "extensions/common/constants.h"
+#include "extensions/common/url_pattern.h"
+#include "url/gurl.h"
+
+namespace extensions {
+
+namespace {
+
+// Identifies the image format.  Bump |kFormatVersion| when the layout changes;
+// browser and renderer are always the same build, so there is no need to read
+// older images.
+const uint32 kMagic = 0x4E425355;  // "USBN"
+const uint32 kFormatVersion = 1;
+
+// ScriptEntry::flags.
+const uint32 kEmulateGreasemonkey = 1 << 0;
+const uint32 kMatchAllFrames = 1 << 1;
+const uint32 kIncognitoEnabled = 1 << 2;
+
+// PatternEntry::flags.
+const uint32 kMatchAllUrls = 1 << 0;
+const uint32 kMatchSubdomains = 1 << 1;
+
+// The schemes a URLPattern can be restricted to, and their masks.
+const struct {
+  const char* scheme;
+  int mask;
+} kSchemeMasks[] = {
+  { url::kHttpScheme, URLPattern::SCHEME_HTTP },
+  { url::kHttpsScheme, URLPattern::SCHEME_HTTPS },
+  { content::kFileScheme, URLPattern::SCHEME_FILE },
+  { content::kFtpScheme, URLPattern::SCHEME_FTP },
+  { content::kChromeUIScheme, URLPattern::SCHEME_CHROMEUI },
+  { kExtensionScheme, URLPattern::SCHEME_EXTENSION },
+  { content::kFileSystemScheme, URLPattern::SCHEME_FILESYSTEM },
+};
+
+// Escapes the characters of a URLPattern path which MatchPattern() treats as
+// special, as URLPattern does for its own matching.
+std::string EscapePath(const std::string& path) {
+  std::string escaped = path;
+  ReplaceSubstringsAfterOffset(&escaped, 0, "\\", "\\\\");
+  ReplaceSubstringsAfterOffset(&escaped, 0, "?", "\\?");
+  return escaped;
+}
+
+template <typename T>
+void AppendArray(const std::vector<T>& values, std::string* image) {
+  if (!values.empty()) {
+    image->append(reinterpret_cast<const char*>(&values[0]),
+                  values.size() * sizeof(T));
+  }
+}
+
+}  // namespace
+
+struct UserScriptBundle::Header {
+  uint32 magic;
+  uint32 format_version;
+  uint32 script_count;
+  uint32 file_count;
+  uint32 pattern_count;
+  uint32 glob_count;
+  uint32 host_count;
+  uint32 any_host_count;
+  uint32 unindexed_count;
+  uint32 string_bytes;
+};
+
+struct UserScriptBundle::StringRef {
+  uint32 offset;
+  uint32 length;
+};
+
+struct UserScriptBundle::ScriptEntry {
+  StringRef extension_id;
+  uint32 run_location;
+  uint32 flags;
+  uint32 first_file;
+  uint32 js_file_count;
+  uint32 css_file_count;
+  uint32 first_exclude_pattern;
+  uint32 exclude_pattern_count;
+  uint32 first_glob;
+  uint32 glob_count;
+  uint32 exclude_glob_count;  // Follow the globs.
+};
+
+struct UserScriptBundle::FileEntry {
+  StringRef url;
+  StringRef content;
+};
+
+struct UserScriptBundle::PatternEntry {
+  uint32 script;
+  uint32 valid_schemes;
+  uint32 flags;
+  StringRef scheme;
+  StringRef host;
+  StringRef port;
+  StringRef path;  // Escaped for MatchPattern().
+};
+
+struct UserScriptBundle::HostEntry {
+  StringRef host;
+  uint32 pattern;
+};
+
+UserScriptBundle::UserScriptBundle()
+    : header_(NULL),
+      scripts_(NULL),
+      files_(NULL),
+      patterns_(NULL),
+      globs_(NULL),
+      hosts_(NULL),
+      any_host_(NULL),
+      unindexed_(NULL),
+      strings_(NULL) {}
+
+UserScriptBundle::~UserScriptBundle() {}
+
+// static
+void UserScriptBundle::Build(const UserScriptList& scripts,
+                             std::string* image) {
+  std::string strings;
+  std::vector<ScriptEntry> script_entries;
+  std::vector<FileEntry> files;
+  std::vector<PatternEntry> patterns;
+  std::vector<StringRef> globs;
+  std::vector<std::pair<std::string, uint32> > hosts;
+  std::vector<uint32> any_host;
+  std::vector<uint32> unindexed;
+
+  for (size_t i = 0; i < scripts.size(); ++i) {
+    const UserScript& script = scripts[i];
+    const uint32 script_index = i;
+
+    ScriptEntry entry;
+    entry.extension_id = AddString(script.extension_id(), &strings);
+    entry.run_location = script.run_location();
+    entry.flags = (script.emulate_greasemonkey() ? kEmulateGreasemonkey : 0) |
+                  (script.match_all_frames() ? kMatchAllFrames : 0) |
+                  (script.is_incognito_enabled() ? kIncognitoEnabled : 0);
+
+    entry.first_file = files.size();
+    entry.js_file_count = script.js_scripts().size();
+    for (size_t j = 0; j < script.js_scripts().size(); ++j) {
+      FileEntry file;
+      file.url = AddString(script.js_scripts()[j].url().spec(), &strings);
+      file.content = AddString(script.js_scripts()[j].GetContent(), &strings);
+      files.push_back(file);
+    }
+    entry.css_file_count = script.css_scripts().size();
+    for (size_t j = 0; j < script.css_scripts().size(); ++j) {
+      FileEntry file;
+      file.url = AddString(script.css_scripts()[j].url().spec(), &strings);
+      file.content = AddString(script.css_scripts()[j].GetContent(), &strings);
+      files.push_back(file);
+    }
+
+    // Include patterns are referenced from the index, exclude patterns from
+    // their script.  Both live in |patterns|.
+    for (URLPatternSet::const_iterator pattern = script.url_patterns().begin();
+         pattern != script.url_patterns().end(); ++pattern) {
+      const uint32 pattern_index = patterns.size();
+      patterns.push_back(FlattenPattern(script_index, *pattern, &strings));
+      // Patterns which match every host cannot be found by host.
+      if (pattern->match_all_urls() ||
+          (pattern->match_subdomains() && pattern->host().empty()) ||
+          pattern->scheme() == content::kFileScheme) {
+        any_host.push_back(pattern_index);
+      } else {
+        hosts.push_back(std::make_pair(pattern->host(), pattern_index));
+      }
+    }
+    if (script.url_patterns().is_empty())
+      unindexed.push_back(script_index);
+
+    entry.first_exclude_pattern = patterns.size();
+    for (URLPatternSet::const_iterator pattern =
+             script.exclude_url_patterns().begin();
+         pattern != script.exclude_url_patterns().end(); ++pattern) {
+      patterns.push_back(FlattenPattern(script_index, *pattern, &strings));
+    }
+    entry.exclude_pattern_count = patterns.size() - entry.first_exclude_pattern;
+
+    entry.first_glob = globs.size();
+    entry.glob_count = script.globs().size();
+    for (size_t j = 0; j < script.globs().size(); ++j)
+      globs.push_back(AddString(script.globs()[j], &strings));
+    entry.exclude_glob_count = script.exclude_globs().size();
+    for (size_t j = 0; j < script.exclude_globs().size(); ++j)
+      globs.push_back(AddString(script.exclude_globs()[j], &strings));
+
+    script_entries.push_back(entry);
+  }
+
+  std::sort(hosts.begin(), hosts.end());
+  std::vector<HostEntry> host_entries;
+  for (size_t i = 0; i < hosts.size(); ++i) {
+    HostEntry entry;
+    entry.host = patterns[hosts[i].second].host;
+    entry.pattern = hosts[i].second;
+    host_entries.push_back(entry);
+  }
+
+  Header header;
+  header.magic = kMagic;
+  header.format_version = kFormatVersion;
+  header.script_count = script_entries.size();
+  header.file_count = files.size();
+  header.pattern_count = patterns.size();
+  header.glob_count = globs.size();
+  header.host_count = host_entries.size();
+  header.any_host_count = any_host.size();
+  header.unindexed_count = unindexed.size();
+  header.string_bytes = strings.size();
+
+  image->assign(reinterpret_cast<const char*>(&header), sizeof(header));
+  AppendArray(script_entries, image);
+  AppendArray(files, image);
+  AppendArray(patterns, image);
+  AppendArray(globs, image);
+  AppendArray(host_entries, image);
+  AppendArray(any_host, image);
+  AppendArray(unindexed, image);
+  image->append(strings);
+}
+
+// static
+scoped_ptr<UserScriptBundle> UserScriptBundle::Create(const char* data,
+                                                      size_t size) {
+  DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(data) % sizeof(uint32));
+  if (size < sizeof(Header))
+    return scoped_ptr<UserScriptBundle>();
+
+  const Header* header = reinterpret_cast<const Header*>(data);
+  if (header->magic != kMagic || header->format_version != kFormatVersion)
+    return scoped_ptr<UserScriptBundle>();
+
+  // 64-bit arithmetic cannot overflow on 32-bit counts.
+  const uint64 expected_size = sizeof(Header) +
+      static_cast<uint64>(header->script_count) * sizeof(ScriptEntry) +
+      static_cast<uint64>(header->file_count) * sizeof(FileEntry) +
+      static_cast<uint64>(header->pattern_count) * sizeof(PatternEntry) +
+      static_cast<uint64>(header->glob_count) * sizeof(StringRef) +
+      static_cast<uint64>(header->host_count) * sizeof(HostEntry) +
+      static_cast<uint64>(header->any_host_count) * sizeof(uint32) +
+      static_cast<uint64>(header->unindexed_count) * sizeof(uint32) +
+      header->string_bytes;
+  if (expected_size != size)
+    return scoped_ptr<UserScriptBundle>();
+
+  scoped_ptr<UserScriptBundle> bundle(new UserScriptBundle());
+  const char* pos = data + sizeof(Header);
+  bundle->header_ = header;
+  bundle->scripts_ = reinterpret_cast<const ScriptEntry*>(pos);
+  pos += header->script_count * sizeof(ScriptEntry);
+  bundle->files_ = reinterpret_cast<const FileEntry*>(pos);
+  pos += header->file_count * sizeof(FileEntry);
+  bundle->patterns_ = reinterpret_cast<const PatternEntry*>(pos);
+  pos += header->pattern_count * sizeof(PatternEntry);
+  bundle->globs_ = reinterpret_cast<const StringRef*>(pos);
+  pos += header->glob_count * sizeof(StringRef);
+  bundle->hosts_ = reinterpret_cast<const HostEntry*>(pos);
+  pos += header->host_count * sizeof(HostEntry);
+  bundle->any_host_ = reinterpret_cast<const uint32*>(pos);
+  pos += header->any_host_count * sizeof(uint32);
+  bundle->unindexed_ = reinterpret_cast<const uint32*>(pos);
+  pos += header->unindexed_count * sizeof(uint32);
+  bundle->strings_ = pos;
+
+  // Every index must stay inside the image, so that lookups need no checks.
+
+  for (uint32 i = 0; i < header->script_count; ++i) {
+    const ScriptEntry& entry = bundle->scripts_[i];
+    if (!bundle->InStrings(entry.extension_id) ||
+        static_cast<uint64>(entry.first_file) + entry.js_file_count +
+                entry.css_file_count > header->file_count ||
+        static_cast<uint64>(entry.first_exclude_pattern) +
+                entry.exclude_pattern_count > header->pattern_count ||
+        static_cast<uint64>(entry.first_glob) + entry.glob_count +
+                entry.exclude_glob_count > header->glob_count) {
+      return scoped_ptr<UserScriptBundle>();
+    }
+  }
+  for (uint32 i = 0; i < header->file_count; ++i) {
+    if (!bundle->InStrings(bundle->files_[i].url) ||
+        !bundle->InStrings(bundle->files_[i].content)) {
+      return scoped_ptr<UserScriptBundle>();
+    }
+  }
+  for (uint32 i = 0; i < header->pattern_count; ++i) {
+    const PatternEntry& entry = bundle->patterns_[i];
+    if (entry.script >= header->script_count ||
+        !bundle->InStrings(entry.scheme) || !bundle->InStrings(entry.host) ||
+        !bundle->InStrings(entry.port) || !bundle->InStrings(entry.path)) {
+      return scoped_ptr<UserScriptBundle>();
+    }
+  }
+  for (uint32 i = 0; i < header->glob_count; ++i) {
+    if (!bundle->InStrings(bundle->globs_[i]))
+      return scoped_ptr<UserScriptBundle>();
+  }
+  for (uint32 i = 0; i < header->host_count; ++i) {
+    const HostEntry& entry = bundle->hosts_[i];
+    if (!bundle->InStrings(entry.host) ||
+        entry.pattern >= header->pattern_count) {
+      return scoped_ptr<UserScriptBundle>();
+    }
+    // Lookups binary search the hosts, so they must be sorted.
+    if (i > 0 && bundle->StringAt(entry.host) <
+        bundle->StringAt(bundle->hosts_[i - 1].host)) {
+      return scoped_ptr<UserScriptBundle>();
+    }
+  }
+  for (uint32 i = 0; i < header->any_host_count; ++i) {
+    if (bundle->any_host_[i] >= header->pattern_count)
+      return scoped_ptr<UserScriptBundle>();
+  }
+  for (uint32 i = 0; i < header->unindexed_count; ++i) {
+    if (bundle->unindexed_[i] >= header->script_count)
+      return scoped_ptr<UserScriptBundle>();
+  }
+
+  return bundle.Pass();
+}
+
+size_t UserScriptBundle::script_count() const {
+  return header_->script_count;
+}
+
+base::StringPiece UserScriptBundle::extension_id(size_t script) const {
+  DCHECK_LT(script, script_count());
+  return StringAt(scripts_[script].extension_id);
+}
+
+UserScript::RunLocation UserScriptBundle::run_location(size_t script) const {
+  DCHECK_LT(script, script_count());
+  return static_cast<UserScript::RunLocation>(scripts_[script].run_location);
+}
+
+bool UserScriptBundle::emulate_greasemonkey(size_t script) const {
+  DCHECK_LT(script, script_count());
+  return (scripts_[script].flags & kEmulateGreasemonkey) != 0;
+}
+
+bool UserScriptBundle::match_all_frames(size_t script) const {
+  DCHECK_LT(script, script_count());
+  return (scripts_[script].flags & kMatchAllFrames) != 0;
+}
+
+bool UserScriptBundle::is_incognito_enabled(size_t script) const {
+  DCHECK_LT(script, script_count());
+  return (scripts_[script].flags & kIncognitoEnabled) != 0;
+}
+
+size_t UserScriptBundle::js_file_count(size_t script) const {
+  DCHECK_LT(script, script_count());
+  return scripts_[script].js_file_count;
+}
+
+base::StringPiece UserScriptBundle::js_file_url(size_t script,
+                                                size_t index) const {
+  DCHECK_LT(index, js_file_count(script));
+  return StringAt(files_[scripts_[script].first_file + index].url);
+}
+
+base::StringPiece UserScriptBundle::js_file_content(size_t script,
+                                                    size_t index) const {
+  DCHECK_LT(index, js_file_count(script));
+  return StringAt(files_[scripts_[script].first_file + index].content);
+}
+
+size_t UserScriptBundle::css_file_count(size_t script) const {
+  DCHECK_LT(script, script_count());
+  return scripts_[script].css_file_count;
+}
+
+base::StringPiece UserScriptBundle::css_file_content(size_t script,
+                                                     size_t index) const {
+  DCHECK_LT(index, css_file_count(script));
+  const ScriptEntry& entry = scripts_[script];
+  return StringAt(
+      files_[entry.first_file + entry.js_file_count + index].content);
+}
+
+void UserScriptBundle::GetScriptsForURL(const GURL& url,
+                                        std::vector<size_t>* scripts) const {
+  if (header_->script_count == 0)
+    return;
+
+  // Gather the scripts with a matching include pattern.
+  std::vector<size_t> candidates(unindexed_,
+                                 unindexed_ + header_->unindexed_count);
+  for (uint32 i = 0; i < header_->any_host_count; ++i) {
+    const PatternEntry& pattern = patterns_[any_host_[i]];
+    if (MatchesPattern(pattern, url))
+      candidates.push_back(pattern.script);
+  }
+  // Filesystem URLs are indexed by the host of their inner URL, which is
+  // what URLPattern matches them against.
+  const GURL& host_url = url.inner_url() ? *url.inner_url() : url;
+  base::StringPiece host(host_url.host());
+  AddHostCandidates(host, false, url, &candidates);
+  if (!host_url.HostIsIPAddress()) {
+    for (size_t dot = host.find('.'); dot != base::StringPiece::npos;
+         dot = host.find('.')) {
+      host = host.substr(dot + 1);
+      AddHostCandidates(host, true, url, &candidates);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+
+  // Only the candidates are checked against their excludes and globs.
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    const ScriptEntry& script = scripts_[candidates[i]];
+    bool excluded = false;
+    for (uint32 j = 0; j < script.exclude_pattern_count && !excluded; ++j) {
+      excluded =
+          MatchesPattern(patterns_[script.first_exclude_pattern + j], url);
+    }
+    if (excluded)
+      continue;
+    if (script.glob_count > 0 &&
+        !MatchesGlobs(script.first_glob, script.glob_count, url)) {
+      continue;
+    }
+    if (script.exclude_glob_count > 0 &&
+        MatchesGlobs(script.first_glob + script.glob_count,
+                     script.exclude_glob_count, url)) {
+      continue;
+    }
+    scripts->push_back(candidates[i]);
+  }
+}
+
+// static
+UserScriptBundle::StringRef UserScriptBundle::AddString(
+    const base::StringPiece& value,
+    std::string* strings) {
+  StringRef ref;
+  ref.offset = strings->size();
+  ref.length = value.size();
+  value.AppendToString(strings);
+  return ref;
+}
+
+// static
+UserScriptBundle::PatternEntry UserScriptBundle::FlattenPattern(
+    uint32 script,
+    const URLPattern& pattern,
+    std::string* strings) {
+  PatternEntry entry;
+  entry.script = script;
+  entry.valid_schemes = pattern.valid_schemes();
+  entry.flags = (pattern.match_all_urls() ? kMatchAllUrls : 0) |
+                (pattern.match_subdomains() ? kMatchSubdomains : 0);
+  entry.scheme = AddString(pattern.scheme(), strings);
+  entry.host = AddString(pattern.host(), strings);
+  entry.port = AddString(pattern.port(), strings);
+  entry.path = AddString(EscapePath(pattern.path()), strings);
+  return entry;
+}
+
+bool UserScriptBundle::InStrings(const StringRef& ref) const {
+  return static_cast<uint64>(ref.offset) + ref.length <= header_->string_bytes;
+}
+
+base::StringPiece UserScriptBundle::StringAt(const StringRef& ref) const {
+  return base::StringPiece(strings_ + ref.offset, ref.length);
+}
+
+bool UserScriptBundle::MatchesPattern(const PatternEntry& pattern,
+                                      const GURL& url) const {
+  // Like URLPattern::MatchesURL, filesystem URLs are matched by the scheme,
+  // host and port of their inner URL, and no other nested URL matches.
+  const GURL* test_url = &url;
+  const bool has_inner_url = url.inner_url() != NULL;
+  if (has_inner_url) {
+    if (!url.SchemeIsFileSystem())
+      return false;
+    test_url = url.inner_url();
+  }
+
+  // Scheme.
+  if (pattern.valid_schemes != static_cast<uint32>(URLPattern::SCHEME_ALL)) {
+    bool valid_scheme = false;
+    for (size_t i = 0; i < arraysize(kSchemeMasks) && !valid_scheme; ++i) {
+      valid_scheme = test_url->SchemeIs(kSchemeMasks[i].scheme) &&
+          (pattern.valid_schemes & kSchemeMasks[i].mask) != 0;
+    }
+    if (!valid_scheme)
+      return false;
+  }
+  const base::StringPiece scheme = StringAt(pattern.scheme);
+  if (scheme != "*" && scheme != test_url->scheme())
+    return false;
+  if (pattern.flags & kMatchAllUrls)
+    return true;
+
+  // Host, which is ignored for file URLs.
+  if (!test_url->SchemeIsFile()) {
+    const base::StringPiece pattern_host = StringAt(pattern.host);
+    const std::string& host = test_url->host();
+    if (pattern_host != host) {
+      if (!(pattern.flags & kMatchSubdomains))
+        return false;
+      if (!pattern_host.empty()) {
+        if (test_url->HostIsIPAddress() ||
+            host.size() <= pattern_host.size() ||
+            host.compare(host.size() - pattern_host.size(),
+                         pattern_host.size(), pattern_host.data(),
+                         pattern_host.size()) != 0 ||
+            host[host.size() - pattern_host.size() - 1] != '.') {
+          return false;
+        }
+      }
+    }
+  }
+
+  // Port.
+  const base::StringPiece port = StringAt(pattern.port);
+  if (port != "*" && port != base::IntToString(test_url->EffectiveIntPort()))
+    return false;
+
+  // Path, which for filesystem URLs includes the inner path.
+  std::string path = url.PathForRequest();
+  if (has_inner_url)
+    path = test_url->path() + path;
+  const base::StringPiece pattern_path = StringAt(pattern.path);
+  if (pattern_path == path + "/*")
+    return true;
+  return MatchPattern(path, pattern_path);
+}
+
+bool UserScriptBundle::MatchesGlobs(uint32 first,
+                                    uint32 count,
+                                    const GURL& url) const {
+  for (uint32 i = first; i < first + count; ++i) {
+    if (MatchPattern(url.spec(), StringAt(globs_[i])))
+      return true;
+  }
+  return false;
+}
+
+void UserScriptBundle::AddHostCandidates(
+    const base::StringPiece& host,
+    bool suffix,
+    const GURL& url,
+    std::vector<size_t>* candidates) const {
+  // Binary search for the first entry of |host|.
+  uint32 begin = 0;
+  uint32 end = header_->host_count;
+  while (begin < end) {
+    const uint32 mid = begin + (end - begin) / 2;
+    if (StringAt(hosts_[mid].host) < host)
+      begin = mid + 1;
+    else
+      end = mid;
+  }
+  for (uint32 i = begin;
+       i < header_->host_count && StringAt(hosts_[i].host) == host; ++i) {
+    const PatternEntry& pattern = patterns_[hosts_[i].pattern];
+    if (suffix && !(pattern.flags & kMatchSubdomains))
+      continue;
+    if (MatchesPattern(pattern, url))
+      candidates->push_back(pattern.script);
+  }
+}
+
+}  // namespace extensions
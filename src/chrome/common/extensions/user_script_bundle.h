@@ -0,0 +1,133 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// A flat, read-only image of the content scripts of a profile.  The browser
+// flattens its UserScriptList into one image and shares it with renderers
+// through read-only shared memory.  Renderers read the image in place, with
+// no unpickling, and decide which scripts to inject into a frame through a
+// precompiled match index:
+//
+// - patterns with a specific host are found by binary search on the URL's
+//   host and on each of its parent domains;
+// - patterns matching every host are kept in a short list of their own;
+// - scripts with no patterns at all, which match on globs only, are always
+//   candidates.
+//
+// Only the candidates are then checked against their exclude patterns and
+// globs, so the decision cost no longer grows with every installed script.
+//
+// Image layout, all fields in host byte order and 4-byte aligned:
+//
+// Header header;
+// ScriptEntry scripts[header.script_count];
+// FileEntry files[header.file_count];        // js files, then css files, of
+//                                            // each script in turn.
+// PatternEntry patterns[header.pattern_count];
+// StringRef globs[header.glob_count];
+// HostEntry hosts[header.host_count];        // Sorted by host.
+// uint32 any_host[header.any_host_count];    // Indices into |patterns|.
+// uint32 unindexed[header.unindexed_count];  // Indices into |scripts|.
+// char strings[header.string_bytes];
+
+#ifndef CHROME_COMMON_EXTENSIONS_USER_SCRIPT_BUNDLE_H_
+#define CHROME_COMMON_EXTENSIONS_USER_SCRIPT_BUNDLE_H_
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/string_piece.h"
+#include "extensions/common/user_script.h"
+
+class GURL;
+class URLPattern;
+
+namespace extensions {
+
+class UserScriptBundle {
+ public:
+  ~UserScriptBundle();
+
+  // Flattens |scripts|, including the content of their files, into |image|.
+  static void Build(const UserScriptList& scripts, std::string* image);
+
+  // Returns a view of the image at |data|, or NULL if it is not a valid image.
+  // Validation is a single pass over the tables.  |data| must stay valid and
+  // unchanged for the lifetime of the view, and must be 4-byte aligned.
+  static scoped_ptr<UserScriptBundle> Create(const char* data, size_t size);
+
+  size_t script_count() const;
+
+  base::StringPiece extension_id(size_t script) const;
+  UserScript::RunLocation run_location(size_t script) const;
+  bool emulate_greasemonkey(size_t script) const;
+  bool match_all_frames(size_t script) const;
+  bool is_incognito_enabled(size_t script) const;
+
+  size_t js_file_count(size_t script) const;
+  base::StringPiece js_file_url(size_t script, size_t index) const;
+  base::StringPiece js_file_content(size_t script, size_t index) const;
+  size_t css_file_count(size_t script) const;
+  base::StringPiece css_file_content(size_t script, size_t index) const;
+
+  // Appends the indices of the scripts which match |url|, in ascending order,
+  // to |scripts|.  This is the same decision as UserScript::MatchesURL().
+  void GetScriptsForURL(const GURL& url, std::vector<size_t>* scripts) const;
+
+ private:
+  struct Header;
+  struct StringRef;
+  struct ScriptEntry;
+  struct FileEntry;
+  struct PatternEntry;
+  struct HostEntry;
+
+  UserScriptBundle();
+
+  // Appends |value| to |strings| and returns a reference to it.
+  static StringRef AddString(const base::StringPiece& value,
+                             std::string* strings);
+
+  // Flattens |pattern|, which belongs to |script|, adding its strings to
+  // |strings|.
+  static PatternEntry FlattenPattern(uint32 script,
+                                     const URLPattern& pattern,
+                                     std::string* strings);
+
+  // Returns true if |ref| lies within the string table.
+  bool InStrings(const StringRef& ref) const;
+
+  base::StringPiece StringAt(const StringRef& ref) const;
+
+  // Returns true if |url| matches |pattern|, as URLPattern::MatchesURL().
+  bool MatchesPattern(const PatternEntry& pattern, const GURL& url) const;
+
+  // Returns true if |url| matches any of |count| globs from |first|.
+  bool MatchesGlobs(uint32 first, uint32 count, const GURL& url) const;
+
+  // Adds the scripts of the patterns indexed under |host| which match |url|
+  // to |candidates|.  |suffix| is true if |host| is a parent domain of the
+  // host of |url|.
+  void AddHostCandidates(const base::StringPiece& host,
+                         bool suffix,
+                         const GURL& url,
+                         std::vector<size_t>* candidates) const;
+
+  const Header* header_;
+  const ScriptEntry* scripts_;
+  const FileEntry* files_;
+  const PatternEntry* patterns_;
+  const StringRef* globs_;
+  const HostEntry* hosts_;
+  const uint32* any_host_;
+  const uint32* unindexed_;
+  const char* strings_;
+
+  DISALLOW_COPY_AND_ASSIGN(UserScriptBundle);
+};
+
+}  // namespace extensions
+
+#endif  // CHROME_COMMON_EXTENSIONS_USER_SCRIPT_BUNDLE_H_
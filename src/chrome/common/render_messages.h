@@ -398,8 +398,13 @@ IPC_MESSAGE_ROUTED5(ChromeViewMsg_SetNavigationCorrectionInfo,
 // Misc messages
 // These are messages sent from the renderer to the browser process.
 
-IPC_MESSAGE_CONTROL1(ChromeViewHostMsg_UpdatedCacheStats,
-                     blink::WebCache::UsageStats /* stats */)
+// Along with the stats of the in-memory cache, tells the browser how many
+// resource loads missed the cache since the last update, and how many objects
+// the cache holds.
+IPC_MESSAGE_CONTROL3(ChromeViewHostMsg_UpdatedCacheStats,
+                     blink::WebCache::UsageStats /* stats */,
+                     uint32 /* misses */,
+                     uint32 /* object_count */)
 
 // Tells the browser that content in the current page was blocked due to the
 // user's content settings.
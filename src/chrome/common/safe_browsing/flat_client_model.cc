@@ -0,0 +1,306 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/common/safe_browsing/flat_client_model.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/stl_util.h"
+#include "chrome/common/safe_browsing/client_model.pb.h"
+
+namespace safe_browsing {
+
+namespace {
+
+// Identifies the image format.  Bump |kFormatVersion| when the layout changes;
+// browser and renderer are always the same build, so there is no need to read
+// older images.
+const uint32 kMagic = 0x4C444D46;  // "FMDL"
+const uint32 kFormatVersion = 1;
+
+// Orders page term indices by the model hash they refer to.
+class HashIndexLess {
+ public:
+  explicit HashIndexLess(const ClientSideModel& model) : model_(model) {}
+  bool operator()(uint32 a, uint32 b) const {
+    return model_.hashes(a) < model_.hashes(b);
+  }
+
+ private:
+  const ClientSideModel& model_;
+};
+
+template <typename T>
+void AppendArray(const std::vector<T>& values, std::string* image) {
+  if (!values.empty()) {
+    image->append(reinterpret_cast<const char*>(&values[0]),
+                  values.size() * sizeof(T));
+  }
+}
+
+}  // namespace
+
+struct FlatClientModel::Header {
+  uint32 magic;
+  uint32 format_version;
+  int32 version;
+  uint32 murmurhash3_seed;
+  uint32 max_words_per_term;
+  uint32 max_shingles_per_page;
+  uint32 shingle_size;
+  uint32 hash_count;
+  uint32 rule_count;
+  uint32 rule_feature_count;
+  uint32 page_term_count;
+  uint32 page_word_count;
+  uint32 string_bytes;
+};
+
+struct FlatClientModel::HashEntry {
+  uint32 offset;
+  uint32 length;
+};
+
+struct FlatClientModel::RuleEntry {
+  float weight;
+  uint32 first_feature;
+  uint32 feature_count;
+};
+
+FlatClientModel::FlatClientModel()
+    : header_(NULL),
+      hashes_(NULL),
+      rules_(NULL),
+      rule_features_(NULL),
+      page_terms_(NULL),
+      page_words_(NULL),
+      strings_(NULL) {}
+
+FlatClientModel::~FlatClientModel() {}
+
+// static
+bool FlatClientModel::Build(const ClientSideModel& model, std::string* image) {
+  const uint32 hash_count = model.hashes_size();
+
+  std::vector<HashEntry> hashes;
+  std::string strings;
+  for (int i = 0; i < model.hashes_size(); ++i) {
+    HashEntry entry;
+    entry.offset = strings.size();
+    entry.length = model.hashes(i).size();
+    hashes.push_back(entry);
+    strings.append(model.hashes(i));
+  }
+
+  std::vector<RuleEntry> rules;
+  std::vector<uint32> rule_features;
+  for (int i = 0; i < model.rule_size(); ++i) {
+    const ClientSideModel::Rule& rule = model.rule(i);
+    RuleEntry entry;
+    entry.weight = rule.weight();
+    entry.first_feature = rule_features.size();
+    entry.feature_count = rule.feature_size();
+    for (int j = 0; j < rule.feature_size(); ++j) {
+      if (rule.feature(j) < 0 ||
+          static_cast<uint32>(rule.feature(j)) >= hash_count) {
+        return false;
+      }
+      rule_features.push_back(rule.feature(j));
+    }
+    rules.push_back(entry);
+  }
+
+  std::vector<uint32> page_terms;
+  for (int i = 0; i < model.page_term_size(); ++i) {
+    if (model.page_term(i) < 0 ||
+        static_cast<uint32>(model.page_term(i)) >= hash_count) {
+      return false;
+    }
+    page_terms.push_back(model.page_term(i));
+  }
+  std::sort(page_terms.begin(), page_terms.end(), HashIndexLess(model));
+
+  std::vector<uint32> page_words(model.page_word().begin(),
+                                 model.page_word().end());
+  std::sort(page_words.begin(), page_words.end());
+
+  Header header;
+  header.magic = kMagic;
+  header.format_version = kFormatVersion;
+  header.version = model.version();
+  header.murmurhash3_seed = model.murmur_hash_seed();
+  header.max_words_per_term = model.max_words_per_term();
+  header.max_shingles_per_page = model.max_shingles_per_page();
+  header.shingle_size = model.shingle_size();
+  header.hash_count = hashes.size();
+  header.rule_count = rules.size();
+  header.rule_feature_count = rule_features.size();
+  header.page_term_count = page_terms.size();
+  header.page_word_count = page_words.size();
+  header.string_bytes = strings.size();
+
+  image->assign(reinterpret_cast<const char*>(&header), sizeof(header));
+  AppendArray(hashes, image);
+  AppendArray(rules, image);
+  AppendArray(rule_features, image);
+  AppendArray(page_terms, image);
+  AppendArray(page_words, image);
+  image->append(strings);
+  return true;
+}
+
+// static
+const char* FlatClientModel::CopyToAlignedBuffer(const std::string& image,
+                                                 std::vector<uint32>* buffer) {
+  buffer->assign((image.size() + sizeof(uint32) - 1) / sizeof(uint32), 0);
+  if (!image.empty())
+    memcpy(vector_as_array(buffer), image.data(), image.size());
+  return reinterpret_cast<const char*>(vector_as_array(buffer));
+}
+
+// static
+scoped_ptr<FlatClientModel> FlatClientModel::Create(const char* data,
+                                                    size_t size) {
+  DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(data) % sizeof(uint32));
+  if (reinterpret_cast<uintptr_t>(data) % sizeof(uint32) != 0 ||
+      size < sizeof(Header)) {
+    return scoped_ptr<FlatClientModel>();
+  }
+
+  const Header* header = reinterpret_cast<const Header*>(data);
+  if (header->magic != kMagic || header->format_version != kFormatVersion)
+    return scoped_ptr<FlatClientModel>();
+
+  // 64-bit arithmetic cannot overflow on 32-bit counts.
+  const uint64 expected_size = sizeof(Header) +
+      static_cast<uint64>(header->hash_count) * sizeof(HashEntry) +
+      static_cast<uint64>(header->rule_count) * sizeof(RuleEntry) +
+      static_cast<uint64>(header->rule_feature_count) * sizeof(uint32) +
+      static_cast<uint64>(header->page_term_count) * sizeof(uint32) +
+      static_cast<uint64>(header->page_word_count) * sizeof(uint32) +
+      header->string_bytes;
+  if (expected_size != size)
+    return scoped_ptr<FlatClientModel>();
+
+  scoped_ptr<FlatClientModel> model(new FlatClientModel());
+  const char* pos = data + sizeof(Header);
+  model->header_ = header;
+  model->hashes_ = reinterpret_cast<const HashEntry*>(pos);
+  pos += header->hash_count * sizeof(HashEntry);
+  model->rules_ = reinterpret_cast<const RuleEntry*>(pos);
+  pos += header->rule_count * sizeof(RuleEntry);
+  model->rule_features_ = reinterpret_cast<const uint32*>(pos);
+  pos += header->rule_feature_count * sizeof(uint32);
+  model->page_terms_ = reinterpret_cast<const uint32*>(pos);
+  pos += header->page_term_count * sizeof(uint32);
+  model->page_words_ = reinterpret_cast<const uint32*>(pos);
+  pos += header->page_word_count * sizeof(uint32);
+  model->strings_ = pos;
+
+  // Every index must stay inside the image, so that lookups need no checks.
+  for (uint32 i = 0; i < header->hash_count; ++i) {
+    const HashEntry& entry = model->hashes_[i];
+    if (static_cast<uint64>(entry.offset) + entry.length > header->string_bytes)
+      return scoped_ptr<FlatClientModel>();
+  }
+  for (uint32 i = 0; i < header->rule_count; ++i) {
+    const RuleEntry& entry = model->rules_[i];
+    if (static_cast<uint64>(entry.first_feature) + entry.feature_count >
+        header->rule_feature_count) {
+      return scoped_ptr<FlatClientModel>();
+    }
+  }
+  for (uint32 i = 0; i < header->rule_feature_count; ++i) {
+    if (model->rule_features_[i] >= header->hash_count)
+      return scoped_ptr<FlatClientModel>();
+  }
+  for (uint32 i = 0; i < header->page_term_count; ++i) {
+    if (model->page_terms_[i] >= header->hash_count)
+      return scoped_ptr<FlatClientModel>();
+    if (i > 0 && model->HashAt(model->page_terms_[i]) <
+        model->HashAt(model->page_terms_[i - 1])) {
+      return scoped_ptr<FlatClientModel>();
+    }
+  }
+  for (uint32 i = 1; i < header->page_word_count; ++i) {
+    if (model->page_words_[i] < model->page_words_[i - 1])
+      return scoped_ptr<FlatClientModel>();
+  }
+
+  return model.Pass();
+}
+
+int FlatClientModel::version() const {
+  return header_->version;
+}
+
+uint32 FlatClientModel::murmurhash3_seed() const {
+  return header_->murmurhash3_seed;
+}
+
+size_t FlatClientModel::max_words_per_term() const {
+  return header_->max_words_per_term;
+}
+
+size_t FlatClientModel::max_shingles_per_page() const {
+  return header_->max_shingles_per_page;
+}
+
+size_t FlatClientModel::shingle_size() const {
+  return header_->shingle_size;
+}
+
+size_t FlatClientModel::rule_count() const {
+  return header_->rule_count;
+}
+
+float FlatClientModel::rule_weight(size_t rule) const {
+  DCHECK_LT(rule, rule_count());
+  return rules_[rule].weight;
+}
+
+size_t FlatClientModel::rule_feature_count(size_t rule) const {
+  DCHECK_LT(rule, rule_count());
+  return rules_[rule].feature_count;
+}
+
+base::StringPiece FlatClientModel::rule_feature(size_t rule,
+                                                size_t index) const {
+  DCHECK_LT(index, rule_feature_count(rule));
+  return HashAt(rule_features_[rules_[rule].first_feature + index]);
+}
+
+bool FlatClientModel::HasPageTerm(const base::StringPiece& term_hash) const {
+  // Binary search over |page_terms_|, which is sorted by hash.
+  size_t begin = 0;
+  size_t end = header_->page_term_count;
+  while (begin < end) {
+    const size_t mid = begin + (end - begin) / 2;
+    const int cmp = HashAt(page_terms_[mid]).compare(term_hash);
+    if (cmp == 0)
+      return true;
+    if (cmp < 0) {
+      begin = mid + 1;
+    } else {
+      end = mid;
+    }
+  }
+  return false;
+}
+
+bool FlatClientModel::HasPageWord(uint32 word_hash) const {
+  return std::binary_search(page_words_,
+                            page_words_ + header_->page_word_count,
+                            word_hash);
+}
+
+base::StringPiece FlatClientModel::HashAt(uint32 index) const {
+  const HashEntry& entry = hashes_[index];
+  return base::StringPiece(strings_ + entry.offset, entry.length);
+}
+
+}  // namespace safe_browsing
@@ -0,0 +1,94 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// A flat, read-only image of a client-side phishing model.  The browser
+// flattens the ClientSideModel protocol buffer once and shares the image with
+// every renderer through shared memory.  Renderers read the image in place:
+// there is no parsing step and nothing is copied into per-process hash sets,
+// so the model costs each renderer only the pages it touches.
+//
+// Image layout, all fields in host byte order and 4-byte aligned:
+//
+// Header header;
+// HashEntry hashes[header.hash_count];        // Into |strings|.
+// RuleEntry rules[header.rule_count];
+// uint32 rule_features[header.rule_feature_count];  // Indices into |hashes|.
+// uint32 page_terms[header.page_term_count];  // Indices into |hashes|, sorted
+//                                             // by the hash they refer to.
+// uint32 page_words[header.page_word_count];  // Sorted.
+// char strings[header.string_bytes];
+
+#ifndef CHROME_COMMON_SAFE_BROWSING_FLAT_CLIENT_MODEL_H_
+#define CHROME_COMMON_SAFE_BROWSING_FLAT_CLIENT_MODEL_H_
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/string_piece.h"
+
+namespace safe_browsing {
+class ClientSideModel;
+
+class FlatClientModel {
+ public:
+  ~FlatClientModel();
+
+  // Flattens |model| into |image|.  Returns false if |model| refers to hashes
+  // which it does not contain.
+  static bool Build(const ClientSideModel& model, std::string* image);
+
+  // Copies |image| into |buffer|, which unlike the data of a std::string is
+  // aligned for Create(), and returns the start of the copy.
+  static const char* CopyToAlignedBuffer(const std::string& image,
+                                         std::vector<uint32>* buffer);
+
+  // Returns a view of the image at |data|, or NULL if it is not a valid image.
+  // Validation is a single pass over the index tables.  |data| must stay
+  // valid and unchanged for the lifetime of the view, and must be 4-byte
+  // aligned, as shared memory and CopyToAlignedBuffer() are.
+  static scoped_ptr<FlatClientModel> Create(const char* data, size_t size);
+
+  // Model parameters, see client_model.proto.
+  int version() const;
+  uint32 murmurhash3_seed() const;
+  size_t max_words_per_term() const;
+  size_t max_shingles_per_page() const;
+  size_t shingle_size() const;
+
+  size_t rule_count() const;
+  float rule_weight(size_t rule) const;
+  size_t rule_feature_count(size_t rule) const;
+  base::StringPiece rule_feature(size_t rule, size_t index) const;
+
+  // Returns true if |term_hash|, the SHA-256 of a page term, is in the model.
+  bool HasPageTerm(const base::StringPiece& term_hash) const;
+
+  // Returns true if |word_hash|, the murmurhash3 of a word, is in the model.
+  bool HasPageWord(uint32 word_hash) const;
+
+ private:
+  struct Header;
+  struct HashEntry;
+  struct RuleEntry;
+
+  FlatClientModel();
+
+  base::StringPiece HashAt(uint32 index) const;
+
+  const Header* header_;
+  const HashEntry* hashes_;
+  const RuleEntry* rules_;
+  const uint32* rule_features_;
+  const uint32* page_terms_;
+  const uint32* page_words_;
+  const char* strings_;
+
+  DISALLOW_COPY_AND_ASSIGN(FlatClientModel);
+};
+
+}  // namespace safe_browsing
+
+#endif  // CHROME_COMMON_SAFE_BROWSING_FLAT_CLIENT_MODEL_H_
@@ -4,6 +4,7 @@
 
 // Multiply-included message file, so no include guard.
 
+#include "base/memory/shared_memory.h"
 #include "ipc/ipc_message_macros.h"
 #include "url/gurl.h"
 
@@ -49,6 +50,14 @@ IPC_MESSAGE_ROUTED1(SafeBrowsingHostMsg_MalwareDOMDetails,
 IPC_MESSAGE_CONTROL1(SafeBrowsingMsg_SetPhishingModel,
                      std::string /* encoded ClientSideModel proto */)
 
+// A classification model for client-side phishing detection, as a read-only
+// safe_browsing::FlatClientModel image which the browser shares with every
+// renderer.  Used instead of SafeBrowsingMsg_SetPhishingModel when the image
+// could be shared.
+IPC_MESSAGE_CONTROL2(SafeBrowsingMsg_SetPhishingModelImage,
+                     base::SharedMemoryHandle /* image */,
+                     uint32 /* image size */)
+
 // Request a DOM tree when a malware interstitial is shown.
 IPC_MESSAGE_ROUTED0(SafeBrowsingMsg_GetMalwareDOMDetails)
 
@@ -59,16 +59,38 @@ namespace {
 const int kCacheStatsDelayMS = 2000;
 const size_t kUnitializedCacheCapacity = UINT_MAX;
 
+// Returns true for the resources Blink keeps in its memory cache.  Other loads,
+// such as frames, XHRs and media, always go to the network stack, so they are
+// not memory cache misses.
+bool IsMemoryCacheable(ResourceType::Type resource_type) {
+  switch (resource_type) {
+    case ResourceType::STYLESHEET:
+    case ResourceType::SCRIPT:
+    case ResourceType::IMAGE:
+    case ResourceType::FONT_RESOURCE:
+    case ResourceType::SUB_RESOURCE:
+      return true;
+    default:
+      return false;
+  }
+}
+
 class RendererResourceDelegate : public content::ResourceDispatcherDelegate {
  public:
   RendererResourceDelegate()
-      : weak_factory_(this) {
+      : misses_(0),
+        weak_factory_(this) {
   }
 
   virtual content::RequestPeer* OnRequestComplete(
       content::RequestPeer* current_peer,
       ResourceType::Type resource_type,
       int error_code) OVERRIDE {
+    // Cacheable requests only reach the resource dispatcher when the memory
+    // cache could not serve them.  Failed loads leave nothing to cache.
+    if (error_code == net::OK && IsMemoryCacheable(resource_type))
+      ++misses_;
+
     // Update the browser about our cache.
     // Rate limit informing the host of our cache stats.
     if (!weak_factory_.HasWeakPtrs()) {
@@ -100,9 +122,19 @@ class RendererResourceDelegate : public content::ResourceDispatcherDelegate {
   void InformHostOfCacheStats() {
     WebCache::UsageStats stats;
     WebCache::getUsageStats(&stats);
-    RenderThread::Get()->Send(new ChromeViewHostMsg_UpdatedCacheStats(stats));
+    WebCache::ResourceTypeStats type_stats;
+    WebCache::getResourceTypeStats(&type_stats);
+    const size_t object_count = type_stats.images.count +
+        type_stats.cssStyleSheets.count + type_stats.scripts.count +
+        type_stats.xslStyleSheets.count + type_stats.fonts.count;
+    RenderThread::Get()->Send(new ChromeViewHostMsg_UpdatedCacheStats(
+        stats, misses_, object_count));
+    misses_ = 0;
   }
 
+  // Number of requests completed since the host was last informed.
+  uint32 misses_;
+
   base::WeakPtrFactory<RendererResourceDelegate> weak_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(RendererResourceDelegate);
@@ -9,15 +9,20 @@
 #include "chrome/renderer/web_apps.h"
 #include "content/public/common/url_constants.h"
 #include "content/public/renderer/render_view.h"
+#include "extensions/common/api/messaging/message.h"
+#include "extensions/renderer/dispatcher.h"
+#include "extensions/renderer/messaging_bindings.h"
 #include "ipc/ipc_message_macros.h"
 #include "third_party/WebKit/public/web/WebView.h"
 #include "url/gurl.h"
 
 namespace extensions {
 
-ChromeExtensionHelper::ChromeExtensionHelper(content::RenderView* render_view)
+ChromeExtensionHelper::ChromeExtensionHelper(content::RenderView* render_view,
+                                             Dispatcher* dispatcher)
     : content::RenderViewObserver(render_view),
-      content::RenderViewObserverTracker<ChromeExtensionHelper>(render_view) {
+      content::RenderViewObserverTracker<ChromeExtensionHelper>(render_view),
+      dispatcher_(dispatcher) {
 }
 
 ChromeExtensionHelper::~ChromeExtensionHelper() {
@@ -29,6 +34,8 @@ bool ChromeExtensionHelper::OnMessageReceived(
   IPC_BEGIN_MESSAGE_MAP(ChromeExtensionHelper, message)
     IPC_MESSAGE_HANDLER(ChromeExtensionMsg_GetApplicationInfo,
                         OnGetApplicationInfo)
+    IPC_MESSAGE_HANDLER(ChromeExtensionMsg_DeliverSharedMessage,
+                        OnDeliverSharedMessage)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
   return handled;
@@ -57,4 +64,25 @@ void ChromeExtensionHelper::OnGetApplicationInfo(int page_id) {
       routing_id(), page_id, app_info));
 }
 
+void ChromeExtensionHelper::OnDeliverSharedMessage(
+    int target_port_id,
+    base::SharedMemoryHandle payload,
+    uint32 size,
+    bool user_gesture) {
+  // The mapping closes the handle even if the payload is not delivered.
+  base::SharedMemory shared_memory(payload, true /* read_only */);
+  if (size == 0 || !shared_memory.Map(size))
+    return;
+
+  // The bindings take the payload as a string, so it is copied once here,
+  // where ExtensionMsg_DeliverMessage copied it into and out of the message.
+  MessagingBindings::DeliverMessage(
+      dispatcher_->script_context_set().GetAll(),
+      target_port_id,
+      Message(std::string(static_cast<const char*>(shared_memory.memory()),
+                          size),
+              user_gesture),
+      render_view());
+}
+
 }  // namespace extensions
@@ -5,8 +5,10 @@
 #ifndef CHROME_RENDERER_EXTENSIONS_CHROME_EXTENSION_HELPER_H_
 #define CHROME_RENDERER_EXTENSIONS_CHROME_EXTENSION_HELPER_H_
 
+#include "base/basictypes.h"
 #include "base/macros.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
 #include "content/public/renderer/render_view_observer.h"
 #include "content/public/renderer/render_view_observer_tracker.h"
 
@@ -14,13 +16,16 @@ struct WebApplicationInfo;
 
 namespace extensions {
 
+class Dispatcher;
+
 // RenderView plumbing for Chrome-specific extension features.
 // See also extensions/renderer/extension_helper.h.
 class ChromeExtensionHelper
     : public content::RenderViewObserver,
       public content::RenderViewObserverTracker<ChromeExtensionHelper> {
  public:
-  explicit ChromeExtensionHelper(content::RenderView* render_view);
+  ChromeExtensionHelper(content::RenderView* render_view,
+                        Dispatcher* dispatcher);
   virtual ~ChromeExtensionHelper();
 
  private:
@@ -29,6 +34,12 @@ class ChromeExtensionHelper
 
   // IPC message handlers.
   void OnGetApplicationInfo(int page_id);
+  void OnDeliverSharedMessage(int target_port_id,
+                              base::SharedMemoryHandle payload,
+                              uint32 size,
+                              bool user_gesture);
+
+  Dispatcher* dispatcher_;
 
   // The app info that we are processing. This is used when installing an app
   // via application definition. The in-progress web app is stored here while
@@ -3,14 +3,103 @@
 // found in the LICENSE file.
 
 #include "chrome/renderer/safe_browsing/murmurhash3_util.h"
+
+#include <string.h>
+
+#include <algorithm>
+
 #include "third_party/smhasher/src/MurmurHash3.h"
 
 namespace safe_browsing {
 
+namespace {
+
+// The number of strings that MurmurHash3Strings() mixes in lockstep.
+const size_t kLanes = 4;
+
+// Constants and mixing steps of MurmurHash3_x86_32, see
+// third_party/smhasher/src/MurmurHash3.cpp.
+const uint32 kC1 = 0xcc9e2d51;
+const uint32 kC2 = 0x1b873593;
+
+inline uint32 Rotl32(uint32 x, int r) {
+  return (x << r) | (x >> (32 - r));
+}
+
+inline uint32 MixK1(uint32 k1) {
+  k1 *= kC1;
+  k1 = Rotl32(k1, 15);
+  return k1 * kC2;
+}
+
+inline uint32 MixBlock(uint32 h1, const char* block) {
+  uint32 k1;
+  memcpy(&k1, block, sizeof(k1));
+  h1 ^= MixK1(k1);
+  h1 = Rotl32(h1, 13);
+  return h1 * 5 + 0xe6546b64;
+}
+
+// Mixes the 4-byte blocks of |str| from |first_block| onwards into |h1|, then
+// the trailing bytes and the length, and returns the finalized hash.
+uint32 FinishHash(uint32 h1, size_t first_block, const base::StringPiece& str) {
+  const size_t num_blocks = str.size() / 4;
+  for (size_t i = first_block; i < num_blocks; ++i)
+    h1 = MixBlock(h1, str.data() + i * 4);
+
+  const uint8* tail = reinterpret_cast<const uint8*>(str.data()) +
+      num_blocks * 4;
+  uint32 k1 = 0;
+  switch (str.size() & 3) {
+    case 3:
+      k1 ^= tail[2] << 16;
+    case 2:
+      k1 ^= tail[1] << 8;
+    case 1:
+      k1 ^= tail[0];
+      h1 ^= MixK1(k1);
+  }
+
+  h1 ^= static_cast<uint32>(str.size());
+  h1 ^= h1 >> 16;
+  h1 *= 0x85ebca6b;
+  h1 ^= h1 >> 13;
+  h1 *= 0xc2b2ae35;
+  h1 ^= h1 >> 16;
+  return h1;
+}
+
+}  // namespace
+
 uint32 MurmurHash3String(const std::string& str, uint32 seed) {
   uint32 output;
   MurmurHash3_x86_32(str.data(), str.size(), seed, &output);
   return output;
 }
 
+void MurmurHash3Strings(const std::vector<base::StringPiece>& strs,
+                        uint32 seed,
+                        std::vector<uint32>* hashes) {
+  hashes->resize(strs.size());
+  size_t i = 0;
+  for (; i + kLanes <= strs.size(); i += kLanes) {
+    const base::StringPiece* lanes = &strs[i];
+    size_t common_blocks = lanes[0].size() / 4;
+    for (size_t lane = 1; lane < kLanes; ++lane)
+      common_blocks = std::min(common_blocks, lanes[lane].size() / 4);
+
+    uint32 h[kLanes];
+    for (size_t lane = 0; lane < kLanes; ++lane)
+      h[lane] = seed;
+    for (size_t block = 0; block < common_blocks; ++block) {
+      for (size_t lane = 0; lane < kLanes; ++lane)
+        h[lane] = MixBlock(h[lane], lanes[lane].data() + block * 4);
+    }
+    for (size_t lane = 0; lane < kLanes; ++lane)
+      (*hashes)[i + lane] = FinishHash(h[lane], common_blocks, lanes[lane]);
+  }
+  for (; i < strs.size(); ++i)
+    (*hashes)[i] = FinishHash(seed, 0, strs[i]);
+}
+
 }  // namespace safe_browsing
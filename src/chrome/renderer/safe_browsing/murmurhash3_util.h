@@ -6,7 +6,10 @@
 #define CHROME_RENDERER_SAFE_BROWSING_MURMURHASH3_UTIL_H_
 
 #include <string>
+#include <vector>
+
 #include "base/basictypes.h"
+#include "base/strings/string_piece.h"
 
 namespace safe_browsing {
 
@@ -14,6 +17,16 @@ namespace safe_browsing {
 // output as a uint32.
 uint32 MurmurHash3String(const std::string& str, uint32 seed);
 
+// Runs the 32-bit murmurhash3 function on each of |strs|, replacing the
+// contents of |hashes| with the outputs in the same order.  The result is
+// identical to calling MurmurHash3String() on every string, but several
+// strings are mixed in lockstep so that their independent multiply chains
+// overlap.  This pays off when the strings have similar lengths, such as the
+// words and shingles of a page.
+void MurmurHash3Strings(const std::vector<base::StringPiece>& strs,
+                        uint32 seed,
+                        std::vector<uint32>* hashes);
+
 }  // namespace safe_browsing
 
 #endif  // CHROME_RENDERER_SAFE_BROWSING_MURMURHASH3_UTIL_H_
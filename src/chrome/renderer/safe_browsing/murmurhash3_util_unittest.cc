@@ -7,6 +7,8 @@
 #include "chrome/renderer/safe_browsing/murmurhash3_util.h"
 
 #include <string>
+#include <vector>
+
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace safe_browsing {
@@ -16,4 +18,26 @@ TEST(MurmurHash3UtilTest, MurmurHash3String) {
   EXPECT_EQ(3322282861U, MurmurHash3String("abcde", 56789U));
 }
 
+TEST(MurmurHash3UtilTest, MurmurHash3Strings) {
+  // Strings of every tail length, in batches which are and are not a
+  // multiple of the lane count, must hash as they do one at a time.
+  const std::string text = "the quick brown fox jumps over the lazy dog ";
+  std::vector<base::StringPiece> strs;
+  for (size_t length = 0; length <= text.size(); ++length)
+    strs.push_back(base::StringPiece(text.data(), length));
+  for (size_t start = 0; start < text.size(); start += 3)
+    strs.push_back(base::StringPiece(text.data() + start, 9));
+
+  for (size_t count = 0; count <= strs.size(); ++count) {
+    std::vector<base::StringPiece> batch(strs.begin(), strs.begin() + count);
+    std::vector<uint32> hashes(7, 0);
+    MurmurHash3Strings(batch, 56789U, &hashes);
+    ASSERT_EQ(count, hashes.size());
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_EQ(MurmurHash3String(batch[i].as_string(), 56789U), hashes[i])
+          << "count " << count << " string " << i;
+    }
+  }
+}
+
 }  // namespace safe_browsing
@@ -13,6 +13,7 @@
 #include "base/message_loop/message_loop.h"
 #include "base/metrics/histogram.h"
 #include "base/strings/string_util.h"
+#include "base/time/time.h"
 #include "chrome/common/safe_browsing/csd.pb.h"
 #include "chrome/common/url_constants.h"
 #include "chrome/renderer/safe_browsing/feature_extractor_clock.h"
@@ -59,8 +60,7 @@ void PhishingClassifier::set_phishing_scorer(const Scorer* scorer) {
     dom_extractor_.reset(
         new PhishingDOMFeatureExtractor(render_view_, clock_.get()));
     term_extractor_.reset(new PhishingTermFeatureExtractor(
-        &scorer_->page_terms(),
-        &scorer_->page_words(),
+        scorer_->flat_model(),
         scorer_->max_words_per_term(),
         scorer_->murmurhash3_seed(),
         scorer_->max_shingles_per_page(),
@@ -205,7 +205,10 @@ void PhishingClassifier::TermExtractionFinished(bool success) {
          it != shingle_hashes_->end(); ++it) {
       verdict.add_shingle_hashes(*it);
     }
+    const base::TimeTicks score_start = base::TimeTicks::Now();
     float score = static_cast<float>(scorer_->ComputeScore(hashed_features));
+    UMA_HISTOGRAM_TIMES("SBClientPhishing.ComputeScoreTime",
+                        base::TimeTicks::Now() - score_start);
     verdict.set_client_score(score);
     verdict.set_is_phishing(score >= kPhishyThreshold);
     RunCallback(verdict);
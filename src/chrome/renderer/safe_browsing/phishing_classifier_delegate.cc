@@ -61,6 +61,8 @@ bool PhishingClassifierFilter::OnControlMessageReceived(
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(PhishingClassifierFilter, message)
     IPC_MESSAGE_HANDLER(SafeBrowsingMsg_SetPhishingModel, OnSetPhishingModel)
+    IPC_MESSAGE_HANDLER(SafeBrowsingMsg_SetPhishingModelImage,
+                        OnSetPhishingModelImage)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
   return handled;
@@ -77,6 +79,28 @@ void PhishingClassifierFilter::OnSetPhishingModel(const std::string& model) {
       return;
     }
   }
+  SetScorer(scorer);
+}
+
+void PhishingClassifierFilter::OnSetPhishingModelImage(
+    base::SharedMemoryHandle image,
+    uint32 size) {
+  scoped_ptr<base::SharedMemory> shared_memory(
+      new base::SharedMemory(image, true /* read_only */));
+  if (!shared_memory->Map(size)) {
+    DLOG(ERROR) << "Unable to map the phishing model image.";
+    return;
+  }
+  safe_browsing::Scorer* scorer =
+      safe_browsing::Scorer::CreateFromFlatModel(shared_memory.Pass(), size);
+  if (!scorer) {
+    DLOG(ERROR) << "Unable to create a PhishingScorer - corrupt model?";
+    return;
+  }
+  SetScorer(scorer);
+}
+
+void PhishingClassifierFilter::SetScorer(safe_browsing::Scorer* scorer) {
   PhishingClassifierDelegates::iterator i;
   for (i = g_delegates.Get().begin(); i != g_delegates.Get().end(); ++i) {
     (*i)->SetPhishingScorer(scorer);
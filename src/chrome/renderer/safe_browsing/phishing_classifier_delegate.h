@@ -8,6 +8,7 @@
 #define CHROME_RENDERER_SAFE_BROWSING_PHISHING_CLASSIFIER_DELEGATE_H_
 
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
 #include "base/strings/string16.h"
 #include "content/public/common/page_transition_types.h"
 #include "content/public/renderer/render_process_observer.h"
@@ -29,6 +30,10 @@ class PhishingClassifierFilter : public content::RenderProcessObserver {
  private:
   PhishingClassifierFilter();
   void OnSetPhishingModel(const std::string& model);
+  void OnSetPhishingModelImage(base::SharedMemoryHandle image, uint32 size);
+
+  // Hands |scorer| to all delegates, NULL disables phishing detection.
+  void SetScorer(safe_browsing::Scorer* scorer);
 
   DISALLOW_COPY_AND_ASSIGN(PhishingClassifierFilter);
 };
@@ -4,8 +4,8 @@
 
 #include "chrome/renderer/safe_browsing/phishing_term_feature_extractor.h"
 
-#include <list>
-#include <map>
+#include <algorithm>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/compiler_specific.h"
@@ -17,6 +17,7 @@
 #include "base/metrics/histogram.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/time/time.h"
+#include "chrome/common/safe_browsing/flat_client_model.h"
 #include "chrome/renderer/safe_browsing/feature_extractor_clock.h"
 #include "chrome/renderer/safe_browsing/features.h"
 #include "chrome/renderer/safe_browsing/murmurhash3_util.h"
@@ -40,21 +41,27 @@ const int PhishingTermFeatureExtractor::kMaxTotalTimeMs = 500;
 
 // All of the state pertaining to the current feature extraction.
 struct PhishingTermFeatureExtractor::ExtractionState {
-  // Stores up to max_words_per_term_ previous words separated by spaces.
-  std::string previous_words;
+  // The lowercased UTF-8 words of the current batch, each followed by a
+  // space.  These are preceded by the last few words of earlier batches,
+  // which may still start a shingle or a page term.  Every shingle and term
+  // is therefore a substring of |words|, so the n-grams never need to be
+  // rebuilt as the window slides forward.
+  std::string words;
 
-  // Stores the current shingle after a new word is processed and added in.
-  std::string current_shingle;
+  // The offset in |words| at which each word starts.
+  std::vector<size_t> word_starts;
 
-  // Stores the sizes of the words in current_shingle. Note: the size includes
-  // the space after each word. In other words, the sum of all sizes in this
-  // list is equal to the length of current_shingle.
-  std::list<size_t> shingle_word_sizes;
+  // The number of words at the front of |words| which are carried over from
+  // earlier batches.
+  size_t num_carried_words;
 
-  // Stores the sizes of the words in previous_words.  Note: the size includes
-  // the space after each word.  In other words, the sum of all sizes in this
-  // list is equal to the length of previous_words.
-  std::list<size_t> previous_word_sizes;
+  // The number of words before the last word handled which, together with
+  // it, form a run of page words.  This is at most max_words_per_term_ - 1.
+  size_t num_term_words;
+
+  // Scratch space for hashing a batch, kept to avoid reallocating.
+  std::vector<base::StringPiece> pieces;
+  std::vector<uint32> hashes;
 
   // An iterator for word breaking.
   scoped_ptr<base::i18n::BreakIterator> iterator;
@@ -66,7 +73,9 @@ struct PhishingTermFeatureExtractor::ExtractionState {
   int num_iterations;
 
   ExtractionState(const base::string16& text, base::TimeTicks start_time_ticks)
-      : start_time(start_time_ticks),
+      : num_carried_words(0),
+        num_term_words(0),
+        start_time(start_time_ticks),
         num_iterations(0) {
 
     scoped_ptr<base::i18n::BreakIterator> i(
@@ -79,18 +88,33 @@ struct PhishingTermFeatureExtractor::ExtractionState {
       DLOG(ERROR) << "failed to open iterator";
     }
   }
+
+  size_t num_batch_words() const {
+    return word_starts.size() - num_carried_words;
+  }
+
+  // Returns the word at |index| in |words|, without its trailing space.
+  base::StringPiece word(size_t index) const {
+    return base::StringPiece(words.data() + word_starts[index],
+                             word_end(index) - word_starts[index] - 1);
+  }
+
+  // Returns the offset in |words| just past the space following the word at
+  // |index|.
+  size_t word_end(size_t index) const {
+    return index + 1 < word_starts.size() ? word_starts[index + 1]
+                                          : words.size();
+  }
 };
 
 PhishingTermFeatureExtractor::PhishingTermFeatureExtractor(
-    const base::hash_set<std::string>* page_term_hashes,
-    const base::hash_set<uint32>* page_word_hashes,
+    const FlatClientModel* model,
     size_t max_words_per_term,
     uint32 murmurhash3_seed,
     size_t max_shingles_per_page,
     size_t shingle_size,
     FeatureExtractorClock* clock)
-    : page_term_hashes_(page_term_hashes),
-      page_word_hashes_(page_word_hashes),
+    : model_(model),
       max_words_per_term_(max_words_per_term),
       murmurhash3_seed_(murmurhash3_seed),
       max_shingles_per_page_(max_shingles_per_page),
@@ -148,120 +172,130 @@ void PhishingTermFeatureExtractor::ExtractFeaturesWithTimeout() {
     return;
   }
 
-  int num_words = 0;
   while (state_->iterator->Advance()) {
-    if (state_->iterator->IsWord()) {
-      const size_t start = state_->iterator->prev();
-      const size_t length = state_->iterator->pos() - start;
-      HandleWord(base::StringPiece16(page_text_->data() + start, length));
-      ++num_words;
+    if (!state_->iterator->IsWord())
+      continue;
+    const size_t start = state_->iterator->prev();
+    const size_t length = state_->iterator->pos() - start;
+    AppendWord(base::StringPiece16(page_text_->data() + start, length));
+    if (state_->num_batch_words() < static_cast<size_t>(kClockCheckGranularity))
+      continue;
+
+    HandleBatch();
+    base::TimeTicks now = clock_->Now();
+    if (now - state_->start_time >=
+        base::TimeDelta::FromMilliseconds(kMaxTotalTimeMs)) {
+      DLOG(ERROR) << "Feature extraction took too long, giving up";
+      // We expect this to happen infrequently, so record when it does.
+      UMA_HISTOGRAM_COUNTS("SBClientPhishing.TermFeatureTimeout", 1);
+      RunCallback(false);
+      return;
     }
-
-    if (num_words >= kClockCheckGranularity) {
-      num_words = 0;
-      base::TimeTicks now = clock_->Now();
-      if (now - state_->start_time >=
-          base::TimeDelta::FromMilliseconds(kMaxTotalTimeMs)) {
-        DLOG(ERROR) << "Feature extraction took too long, giving up";
-        // We expect this to happen infrequently, so record when it does.
-        UMA_HISTOGRAM_COUNTS("SBClientPhishing.TermFeatureTimeout", 1);
-        RunCallback(false);
-        return;
-      }
-      base::TimeDelta chunk_elapsed = now - current_chunk_start_time;
-      if (chunk_elapsed >=
-          base::TimeDelta::FromMilliseconds(kMaxTimePerChunkMs)) {
-        // The time limit for the current chunk is up, so post a task to
-        // continue extraction.
-        //
-        // Record how much time we actually spent on the chunk.  If this is
-        // much higher than kMaxTimePerChunkMs, we may need to adjust the
-        // clock granularity.
-        UMA_HISTOGRAM_TIMES("SBClientPhishing.TermFeatureChunkTime",
-                            chunk_elapsed);
-        base::MessageLoop::current()->PostTask(
-            FROM_HERE,
-            base::Bind(
-                &PhishingTermFeatureExtractor::ExtractFeaturesWithTimeout,
-                weak_factory_.GetWeakPtr()));
-        return;
-      }
-      // Otherwise, continue.
+    base::TimeDelta chunk_elapsed = now - current_chunk_start_time;
+    if (chunk_elapsed >=
+        base::TimeDelta::FromMilliseconds(kMaxTimePerChunkMs)) {
+      // The time limit for the current chunk is up, so post a task to
+      // continue extraction.
+      //
+      // Record how much time we actually spent on the chunk.  If this is
+      // much higher than kMaxTimePerChunkMs, we may need to adjust the
+      // clock granularity.
+      UMA_HISTOGRAM_TIMES("SBClientPhishing.TermFeatureChunkTime",
+                          chunk_elapsed);
+      base::MessageLoop::current()->PostTask(
+          FROM_HERE,
+          base::Bind(
+              &PhishingTermFeatureExtractor::ExtractFeaturesWithTimeout,
+              weak_factory_.GetWeakPtr()));
+      return;
     }
+    // Otherwise, continue.
   }
+  HandleBatch();
   RunCallback(true);
 }
 
-void PhishingTermFeatureExtractor::HandleWord(
+void PhishingTermFeatureExtractor::AppendWord(
     const base::StringPiece16& word) {
-  // First, extract shingle hashes.
-  const std::string& word_lower = base::UTF16ToUTF8(base::i18n::ToLower(word));
-  state_->current_shingle.append(word_lower + " ");
-  state_->shingle_word_sizes.push_back(word_lower.size() + 1);
-  if (state_->shingle_word_sizes.size() == shingle_size_) {
-    shingle_hashes_->insert(
-        MurmurHash3String(state_->current_shingle, murmurhash3_seed_));
-    state_->current_shingle.erase(0, state_->shingle_word_sizes.front());
-    state_->shingle_word_sizes.pop_front();
-  }
-  // Check if the size of shingle hashes is over the limit.
-  if (shingle_hashes_->size() > max_shingles_per_page_) {
-    // Pop the largest one.
-    std::set<uint32>::iterator it = shingle_hashes_->end();
-    shingle_hashes_->erase(--it);
-  }
-
-  // Next, extract page terms.
-  uint32 word_hash = MurmurHash3String(word_lower, murmurhash3_seed_);
+  state_->word_starts.push_back(state_->words.size());
+  state_->words.append(base::UTF16ToUTF8(base::i18n::ToLower(word)));
+  // Note: it's possible that the document language doesn't use ASCII spaces
+  // to separate words.  That's fine though, we just need to be consistent
+  // with how the model is generated.
+  state_->words.push_back(' ');
+}
 
-  // Quick out if the word is not part of any term, which is the common case.
-  if (page_word_hashes_->find(word_hash) == page_word_hashes_->end()) {
-    // Word doesn't exist in our terms so we can clear the n-gram state.
-    state_->previous_words.clear();
-    state_->previous_word_sizes.clear();
+void PhishingTermFeatureExtractor::HandleBatch() {
+  ExtractionState* state = state_.get();
+  const size_t num_words = state->word_starts.size();
+  const size_t first_word = state->num_carried_words;
+  if (first_word == num_words)
     return;
+
+  // Hash every word of the batch, followed by every shingle which ends in the
+  // batch.  A shingle includes the space after each of its words.
+  state->pieces.clear();
+  for (size_t i = first_word; i < num_words; ++i)
+    state->pieces.push_back(state->word(i));
+  const size_t first_shingle_end =
+      shingle_size_ > 0 ? std::max(first_word, shingle_size_ - 1) : num_words;
+  for (size_t i = first_shingle_end; i < num_words; ++i) {
+    const size_t start = state->word_starts[i + 1 - shingle_size_];
+    state->pieces.push_back(base::StringPiece(
+        state->words.data() + start, state->word_end(i) - start));
   }
+  MurmurHash3Strings(state->pieces, murmurhash3_seed_, &state->hashes);
 
-  // Find all of the n-grams that we need to check and compute their SHA-256
-  // hashes.
-  std::map<std::string /* hash */, std::string /* plaintext */>
-      hashes_to_check;
-  hashes_to_check[crypto::SHA256HashString(word_lower)] = word_lower;
-
-  // Combine the new word with the previous words to find additional n-grams.
-  // Note that we don't yet add the new word length to previous_word_sizes,
-  // since we don't want to compute the hash for the word by itself again.
-  //
-  state_->previous_words.append(word_lower);
-  std::string current_term = state_->previous_words;
-  for (std::list<size_t>::iterator it = state_->previous_word_sizes.begin();
-       it != state_->previous_word_sizes.end(); ++it) {
-    hashes_to_check[crypto::SHA256HashString(current_term)] = current_term;
-    current_term.erase(0, *it);
+  // First, extract shingle hashes.
+  for (size_t i = num_words - first_word; i < state->hashes.size(); ++i) {
+    shingle_hashes_->insert(state->hashes[i]);
+    // Check if the size of shingle hashes is over the limit.
+    if (shingle_hashes_->size() > max_shingles_per_page_) {
+      // Pop the largest one.
+      std::set<uint32>::iterator it = shingle_hashes_->end();
+      shingle_hashes_->erase(--it);
+    }
   }
 
-  // Add features for any hashes that match page_term_hashes_.
-  for (std::map<std::string, std::string>::iterator it =
-           hashes_to_check.begin();
-       it != hashes_to_check.end(); ++it) {
-    if (page_term_hashes_->find(it->first) != page_term_hashes_->end()) {
-      features_->AddBooleanFeature(features::kPageTerm + it->second);
+  // Next, extract page terms.
+  for (size_t i = first_word; i < num_words; ++i) {
+    // Quick out if the word is not part of any term, which is the common case.
+    if (!model_->HasPageWord(state->hashes[i - first_word])) {
+      // Word doesn't exist in our terms so we can clear the n-gram state.
+      state->num_term_words = 0;
+      continue;
     }
+
+    // Check the word by itself and the n-grams it ends, and add features for
+    // any SHA-256 hashes that match the model's page terms.
+    const size_t term_end = state->word_end(i) - 1;
+    for (size_t j = i - state->num_term_words; j <= i; ++j) {
+      const base::StringPiece term(state->words.data() + state->word_starts[j],
+                                   term_end - state->word_starts[j]);
+      if (model_->HasPageTerm(crypto::SHA256HashString(term)))
+        features_->AddBooleanFeature(features::kPageTerm + term.as_string());
+    }
+
+    // Cap the number of previous words.
+    if (state->num_term_words + 1 < max_words_per_term_)
+      ++state->num_term_words;
   }
 
-  // Now that we have handled the current word, we have to add a space at the
-  // end of it, and add the new word's size (including the space) to
-  // previous_word_sizes.  Note: it's possible that the document language
-  // doesn't use ASCII spaces to separate words.  That's fine though, we just
-  // need to be consistent with how the model is generated.
-  state_->previous_words.append(" ");
-  state_->previous_word_sizes.push_back(word_lower.size() + 1);
-
-  // Cap the number of previous words.
-  if (state_->previous_word_sizes.size() >= max_words_per_term_) {
-    state_->previous_words.erase(0, state_->previous_word_sizes.front());
-    state_->previous_word_sizes.pop_front();
+  // Carry over the words which may still start a shingle or a term, and drop
+  // the rest.
+  const size_t window = std::max(shingle_size_, max_words_per_term_);
+  const size_t num_carried = std::min(num_words, window > 0 ? window - 1 : 0);
+  const size_t num_dropped = num_words - num_carried;
+  if (num_dropped > 0) {
+    const size_t dropped_bytes = num_carried > 0 ?
+        state->word_starts[num_dropped] : state->words.size();
+    state->words.erase(0, dropped_bytes);
+    state->word_starts.erase(state->word_starts.begin(),
+                             state->word_starts.begin() + num_dropped);
+    for (size_t i = 0; i < state->word_starts.size(); ++i)
+      state->word_starts[i] -= dropped_bytes;
   }
+  state->num_carried_words = num_carried;
 }
 
 void PhishingTermFeatureExtractor::CheckNoPendingExtraction() {
@@ -21,7 +21,6 @@
 
 #include "base/basictypes.h"
 #include "base/callback.h"
-#include "base/containers/hash_tables.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/strings/string16.h"
@@ -30,6 +29,7 @@
 namespace safe_browsing {
 class FeatureExtractorClock;
 class FeatureMap;
+class FlatClientModel;
 
 class PhishingTermFeatureExtractor {
  public:
@@ -38,14 +38,13 @@ class PhishingTermFeatureExtractor {
   typedef base::Callback<void(bool)> DoneCallback;
 
   // Creates a PhishingTermFeatureExtractor which will extract features for
-  // all of the terms whose SHA-256 hashes are in |page_term_hashes|.  These
-  // terms may be multi-word n-grams, with at most |max_words_per_term| words.
+  // all of the page terms in |model|, which are SHA-256 hashes.  These terms
+  // may be multi-word n-grams, with at most |max_words_per_term| words.
   //
-  // |page_word_hashes| contains the murmur3 hashes for all of the individual
-  // words that make up the terms.  Both sets of strings are UTF-8 encoded and
-  // lowercased prior to hashing.  The caller owns both sets of strings, and
-  // must ensure that they are valid until the PhishingTermFeatureExtractor is
-  // destroyed.
+  // The page words of |model| are the murmur3 hashes for all of the individual
+  // words that make up the terms.  Both are UTF-8 encoded and lowercased prior
+  // to hashing.  The caller owns |model|, and must ensure that it is valid
+  // until the PhishingTermFeatureExtractor is destroyed.
   //
   // In addition to extracting page terms, we will also extract text shingling
   // sketch, which consists of hashes of N-gram-words (referred to as shingles)
@@ -55,8 +54,7 @@ class PhishingTermFeatureExtractor {
   // |clock| is used for timing feature extractor operations, and may be mocked
   // for testing.  The caller keeps ownership of the clock.
   PhishingTermFeatureExtractor(
-      const base::hash_set<std::string>* page_term_hashes,
-      const base::hash_set<uint32>* page_word_hashes,
+      const FlatClientModel* model,
       size_t max_words_per_term,
       uint32 murmurhash3_seed,
       size_t max_shingles_per_page,
@@ -96,7 +94,8 @@ class PhishingTermFeatureExtractor {
 
   // The number of words that we will process before checking to see whether
   // kMaxTimePerChunkMs has elapsed.  Since checking the current time can be
-  // slow, we don't do this on every word processed.
+  // slow, we don't do this on every word processed.  Words are hashed in
+  // batches of this size.
   static const int kClockCheckGranularity;
 
   // The maximum total amount of time that the feature extractor will run
@@ -109,8 +108,13 @@ class PhishingTermFeatureExtractor {
   // finishes, calls RunCallback().
   void ExtractFeaturesWithTimeout();
 
-  // Handles a single word in the page text.
-  void HandleWord(const base::StringPiece16& word);
+  // Lowercases |word|, converts it to UTF-8 and appends it to the current
+  // batch of words.
+  void AppendWord(const base::StringPiece16& word);
+
+  // Extracts the shingle hashes and page terms of the current batch of words.
+  // All of the words and shingles in the batch are hashed in one pass.
+  void HandleBatch();
 
   // Helper to verify that there is no pending feature extraction.  Dies in
   // debug builds if the state is not as expected.  This is a no-op in release
@@ -123,15 +127,13 @@ class PhishingTermFeatureExtractor {
   // Clears all internal feature extraction state.
   void Clear();
 
-  // All of the term hashes that we are looking for in the page.
-  const base::hash_set<std::string>* page_term_hashes_;
-
-  // Murmur3 hashes of all the individual words in page_term_hashes_.  If
-  // page_term_hashes_ included (hashed) "one" and "one two", page_word_hashes_
-  // would contain (hashed) "one" and "two".  We do this so that we can have a
-  // quick out in the common case that the current word we are processing
-  // doesn't contain any part of one of our terms.
-  const base::hash_set<uint32>* page_word_hashes_;
+  // Holds the term hashes that we are looking for in the page, and the
+  // Murmur3 hashes of all the individual words in those terms.  If the terms
+  // included (hashed) "one" and "one two", the words would contain (hashed)
+  // "one" and "two".  We do this so that we can have a quick out in the common
+  // case that the current word we are processing doesn't contain any part of
+  // one of our terms.
+  const FlatClientModel* model_;
 
   // The maximum number of words in an n-gram.
   const size_t max_words_per_term_;
@@ -0,0 +1,133 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/renderer/safe_browsing/phishing_term_feature_extractor.h"
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/string16.h"
+#include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversions.h"
+#include "base/time/time.h"
+#include "chrome/common/safe_browsing/client_model.pb.h"
+#include "chrome/common/safe_browsing/flat_client_model.h"
+#include "chrome/renderer/safe_browsing/features.h"
+#include "chrome/renderer/safe_browsing/mock_feature_extractor_clock.h"
+#include "chrome/renderer/safe_browsing/murmurhash3_util.h"
+#include "chrome/renderer/safe_browsing/test_utils.h"
+#include "crypto/sha2.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+using base::ASCIIToUTF16;
+using ::testing::Return;
+
+namespace safe_browsing {
+
+namespace {
+
+const uint32 kMurmurHash3Seed = 2777808611U;
+const int kNumWords = 200000;
+const size_t kMaxShinglesPerPage = 200;
+
+}  // namespace
+
+class PhishingTermFeatureExtractorPerfTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    ClientSideModel model;
+    model.add_page_term(model.hashes_size());
+    model.add_hashes(crypto::SHA256HashString("multi word test"));
+    model.add_page_word(MurmurHash3String("multi", kMurmurHash3Seed));
+    model.add_page_word(MurmurHash3String("word", kMurmurHash3Seed));
+    model.add_page_word(MurmurHash3String("test", kMurmurHash3Seed));
+
+    std::string image;
+    ASSERT_TRUE(FlatClientModel::Build(model, &image));
+    model_ = FlatClientModel::Create(
+        FlatClientModel::CopyToAlignedBuffer(image, &model_image_),
+        image.size());
+    ASSERT_TRUE(model_.get());
+
+    extractor_.reset(new PhishingTermFeatureExtractor(
+        model_.get(),
+        3 /* max_words_per_term */,
+        kMurmurHash3Seed,
+        kMaxShinglesPerPage,
+        4 /* shingle_size */,
+        &clock_));
+  }
+
+  // Runs the TermFeatureExtractor on |page_text|, waiting for the
+  // completion callback.  Returns the success boolean from the callback.
+  bool ExtractFeatures(const base::string16* page_text,
+                       FeatureMap* features,
+                       std::set<uint32>* shingle_hashes) {
+    success_ = false;
+    extractor_->ExtractFeatures(
+        page_text,
+        features,
+        shingle_hashes,
+        base::Bind(&PhishingTermFeatureExtractorPerfTest::ExtractionDone,
+                   base::Unretained(this)));
+    msg_loop_.Run();
+    return success_;
+  }
+
+  // Completion callback for feature extraction.
+  void ExtractionDone(bool success) {
+    success_ = success;
+    msg_loop_.Quit();
+  }
+
+  base::MessageLoop msg_loop_;
+  MockFeatureExtractorClock clock_;
+  scoped_ptr<PhishingTermFeatureExtractor> extractor_;
+  std::vector<uint32> model_image_;
+  scoped_ptr<FlatClientModel> model_;
+  bool success_;  // holds the success value from ExtractFeatures
+};
+
+// A large page, mostly of words outside the model, with a page term now and
+// then.  Reports how many words per second the extractor handles.
+TEST_F(PhishingTermFeatureExtractorPerfTest, Throughput) {
+  base::string16 page_text;
+  for (int i = 0; i < kNumWords; ++i) {
+    page_text.append(ASCIIToUTF16(i % 1000 == 0 ?
+        "multi word test " : base::StringPrintf("word%d ", i % 5000)));
+  }
+
+  // The mock clock never advances, so extraction runs in a single chunk and
+  // the measurement excludes the time spent in the message loop.
+  EXPECT_CALL(clock_, Now()).WillRepeatedly(Return(base::TimeTicks::Now()));
+
+  FeatureMap features;
+  std::set<uint32> shingle_hashes;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  ASSERT_TRUE(ExtractFeatures(&page_text, &features, &shingle_hashes));
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  FeatureMap expected_features;
+  expected_features.AddBooleanFeature(features::kPageTerm +
+                                      std::string("multi word test"));
+  ExpectFeatureMapsAreEqual(features, expected_features);
+  EXPECT_EQ(kMaxShinglesPerPage, shingle_hashes.size());
+
+  perf_test::PrintResult(
+      "term_feature_extraction",
+      "",
+      "words_per_second",
+      static_cast<size_t>(kNumWords / std::max(elapsed.InSecondsF(), 1e-6)),
+      "words/s",
+      true);
+}
+
+}  // namespace safe_browsing
@@ -5,6 +5,7 @@
 #include "chrome/renderer/safe_browsing/phishing_term_feature_extractor.h"
 
 #include <string>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/callback.h"
@@ -15,6 +16,8 @@
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/time/time.h"
+#include "chrome/common/safe_browsing/client_model.pb.h"
+#include "chrome/common/safe_browsing/flat_client_model.h"
 #include "chrome/renderer/safe_browsing/features.h"
 #include "chrome/renderer/safe_browsing/mock_feature_extractor_clock.h"
 #include "chrome/renderer/safe_browsing/murmurhash3_util.h"
@@ -48,9 +51,11 @@ class PhishingTermFeatureExtractorTest : public ::testing::Test {
     // Chinese (translation of "goodbye")
     terms.insert("\xe5\x86\x8d\xe8\xa7\x81");
 
+    ClientSideModel model;
     for (base::hash_set<std::string>::iterator it = terms.begin();
          it != terms.end(); ++it) {
-      term_hashes_.insert(crypto::SHA256HashString(*it));
+      model.add_page_term(model.hashes_size());
+      model.add_hashes(crypto::SHA256HashString(*it));
     }
 
     base::hash_set<std::string> words;
@@ -68,16 +73,22 @@ class PhishingTermFeatureExtractorTest : public ::testing::Test {
 
     for (base::hash_set<std::string>::iterator it = words.begin();
          it != words.end(); ++it) {
-      word_hashes_.insert(MurmurHash3String(*it, kMurmurHash3Seed));
+      model.add_page_word(MurmurHash3String(*it, kMurmurHash3Seed));
     }
 
+    std::string image;
+    ASSERT_TRUE(FlatClientModel::Build(model, &image));
+    model_ = FlatClientModel::Create(
+        FlatClientModel::CopyToAlignedBuffer(image, &model_image_),
+        image.size());
+    ASSERT_TRUE(model_.get());
+
     ResetExtractor(3 /* max shingles per page */);
   }
 
   void ResetExtractor(size_t max_shingles_per_page) {
     extractor_.reset(new PhishingTermFeatureExtractor(
-        &term_hashes_,
-        &word_hashes_,
+        model_.get(),
         3 /* max_words_per_term */,
         kMurmurHash3Seed,
         max_shingles_per_page,
@@ -131,8 +142,8 @@ class PhishingTermFeatureExtractorTest : public ::testing::Test {
   base::MessageLoop msg_loop_;
   MockFeatureExtractorClock clock_;
   scoped_ptr<PhishingTermFeatureExtractor> extractor_;
-  base::hash_set<std::string> term_hashes_;
-  base::hash_set<uint32> word_hashes_;
+  std::vector<uint32> model_image_;
+  scoped_ptr<FlatClientModel> model_;
   bool success_;  // holds the success value from ExtractFeatures
 };
 
@@ -6,11 +6,15 @@
 
 #include <math.h>
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
 #include "base/metrics/histogram.h"
 #include "base/strings/string_piece.h"
 #include "chrome/common/safe_browsing/client_model.pb.h"
+#include "chrome/common/safe_browsing/flat_client_model.h"
 #include "chrome/renderer/safe_browsing/features.h"
 
 namespace {
@@ -22,6 +26,8 @@ enum ScorerCreationStatus {
   SCORER_FAIL_MODEL_FILE_TOO_LARGE,  // Not used anymore
   SCORER_FAIL_MODEL_PARSE_ERROR,
   SCORER_FAIL_MODEL_MISSING_FIELDS,
+  SCORER_FAIL_MODEL_BAD_HASH_IDS,
+  SCORER_FAIL_FLAT_MODEL_INVALID,
   SCORER_STATUS_MAX  // Always add new values before this one.
 };
 
@@ -34,6 +40,12 @@ void RecordScorerCreationStatus(ScorerCreationStatus status) {
 
 namespace safe_browsing {
 
+// Orders feature weights by name only.
+static bool FeatureNameLess(const std::pair<base::StringPiece, double>& a,
+                            const std::pair<base::StringPiece, double>& b) {
+  return a.first < b.first;
+}
+
 // Helper function which converts log odds to a probability in the range
 // [0.0,1.0].
 static double LogOdds2Prob(double log_odds) {
@@ -47,13 +59,20 @@ static double LogOdds2Prob(double log_odds) {
   return odds/(odds+1.0);
 }
 
-Scorer::Scorer() {}
+Scorer::Scorer() {
+  std::string image;
+  const bool built = FlatClientModel::Build(ClientSideModel(), &image);
+  DCHECK(built);
+  model_ = FlatClientModel::Create(
+      FlatClientModel::CopyToAlignedBuffer(image, &image_), image.size());
+  DCHECK(model_.get());
+}
+
 Scorer::~Scorer() {}
 
 /* static */
 Scorer* Scorer::Create(const base::StringPiece& model_str) {
-  scoped_ptr<Scorer> scorer(new Scorer());
-  ClientSideModel& model = scorer->model_;
+  ClientSideModel model;
   if (!model.ParseFromArray(model_str.data(), model_str.size())) {
     DLOG(ERROR) << "Unable to parse phishing model.  This Scorer object is "
                 << "invalid.";
@@ -65,60 +84,94 @@ Scorer* Scorer::Create(const base::StringPiece& model_str) {
     RecordScorerCreationStatus(SCORER_FAIL_MODEL_MISSING_FIELDS);
     return NULL;
   }
-  RecordScorerCreationStatus(SCORER_SUCCESS);
-  for (int i = 0; i < model.page_term_size(); ++i) {
-    scorer->page_terms_.insert(model.hashes(model.page_term(i)));
+  std::string image;
+  if (!FlatClientModel::Build(model, &image)) {
+    DLOG(ERROR) << "Phishing model refers to hashes it does not contain.";
+    RecordScorerCreationStatus(SCORER_FAIL_MODEL_BAD_HASH_IDS);
+    return NULL;
   }
-  for (int i = 0; i < model.page_word_size(); ++i) {
-    scorer->page_words_.insert(model.page_word(i));
+  scoped_ptr<Scorer> scorer(new Scorer());
+  scorer->model_.reset();
+  scorer->model_ = FlatClientModel::Create(
+      FlatClientModel::CopyToAlignedBuffer(image, &scorer->image_),
+      image.size());
+  DCHECK(scorer->model_.get());
+  RecordScorerCreationStatus(SCORER_SUCCESS);
+  return scorer.release();
+}
+
+/* static */
+Scorer* Scorer::CreateFromFlatModel(
+    scoped_ptr<base::SharedMemory> shared_memory,
+    size_t size) {
+  DCHECK(shared_memory->memory());
+  scoped_ptr<FlatClientModel> model = FlatClientModel::Create(
+      static_cast<const char*>(shared_memory->memory()), size);
+  if (!model.get()) {
+    DLOG(ERROR) << "Invalid flat phishing model.";
+    RecordScorerCreationStatus(SCORER_FAIL_FLAT_MODEL_INVALID);
+    return NULL;
   }
+  RecordScorerCreationStatus(SCORER_SUCCESS);
+  scoped_ptr<Scorer> scorer(new Scorer());
+  scorer->model_ = model.Pass();
+  scorer->shared_memory_ = shared_memory.Pass();
+  scorer->image_.clear();
   return scorer.release();
 }
 
 double Scorer::ComputeScore(const FeatureMap& features) const {
+  const base::hash_map<std::string, double>& feature_map = features.features();
+  FeatureWeights weights;
+  weights.reserve(feature_map.size());
+  for (base::hash_map<std::string, double>::const_iterator it =
+           feature_map.begin();
+       it != feature_map.end(); ++it) {
+    weights.push_back(std::make_pair(base::StringPiece(it->first), it->second));
+  }
+  std::sort(weights.begin(), weights.end(), FeatureNameLess);
+
   double logodds = 0.0;
-  for (int i = 0; i < model_.rule_size(); ++i) {
-    logodds += ComputeRuleScore(model_.rule(i), features);
+  for (size_t i = 0; i < model_->rule_count(); ++i) {
+    logodds += ComputeRuleScore(i, weights);
   }
   return LogOdds2Prob(logodds);
 }
 
 int Scorer::model_version() const {
-  return model_.version();
+  return model_->version();
 }
 
-const base::hash_set<std::string>& Scorer::page_terms() const {
-  return page_terms_;
-}
-
-const base::hash_set<uint32>& Scorer::page_words() const {
-  return page_words_;
+const FlatClientModel* Scorer::flat_model() const {
+  return model_.get();
 }
 
 size_t Scorer::max_words_per_term() const {
-  return model_.max_words_per_term();
+  return model_->max_words_per_term();
 }
 
 uint32 Scorer::murmurhash3_seed() const {
-  return model_.murmur_hash_seed();
+  return model_->murmurhash3_seed();
 }
 
 size_t Scorer::max_shingles_per_page() const {
-  return model_.max_shingles_per_page();
+  return model_->max_shingles_per_page();
 }
 
 size_t Scorer::shingle_size() const {
-  return model_.shingle_size();
+  return model_->shingle_size();
 }
 
-double Scorer::ComputeRuleScore(const ClientSideModel::Rule& rule,
-                                const FeatureMap& features) const {
-  const base::hash_map<std::string, double>& feature_map = features.features();
+double Scorer::ComputeRuleScore(size_t rule,
+                                const FeatureWeights& weights) const {
   double rule_score = 1.0;
-  for (int i = 0; i < rule.feature_size(); ++i) {
-    base::hash_map<std::string, double>::const_iterator it = feature_map.find(
-        model_.hashes(rule.feature(i)));
-    if (it == feature_map.end() || it->second == 0.0) {
+  const size_t feature_count = model_->rule_feature_count(rule);
+  for (size_t i = 0; i < feature_count; ++i) {
+    const base::StringPiece feature = model_->rule_feature(rule, i);
+    FeatureWeights::const_iterator it = std::lower_bound(
+        weights.begin(), weights.end(), std::make_pair(feature, 0.0),
+        FeatureNameLess);
+    if (it == weights.end() || it->first != feature || it->second == 0.0) {
       // If the feature of the rule does not exist in the given feature map the
       // feature weight is considered to be zero.  If the feature weight is zero
       // we leave early since we know that the rule score will be zero.
@@ -126,6 +179,6 @@ double Scorer::ComputeRuleScore(const ClientSideModel::Rule& rule,
     }
     rule_score *= it->second;
   }
-  return rule_score * rule.weight();
+  return rule_score * model_->rule_weight(rule);
 }
 }  // namespace safe_browsing
@@ -5,6 +5,8 @@
 // This class loads a client-side model and lets you compute a phishing score
 // for a set of previously extracted features.  The phishing score corresponds
 // to the probability that the features are indicative of a phishing site.
+// The model is read from a FlatClientModel image, which is normally mapped
+// from shared memory so that all renderers use a single copy.
 //
 // For more details on how the score is actually computed for a given model
 // and a given set of features read the comments in client_model.proto file.
@@ -15,14 +17,20 @@
 #define CHROME_RENDERER_SAFE_BROWSING_SCORER_H_
 
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "base/basictypes.h"
-#include "base/containers/hash_tables.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/strings/string_piece.h"
-#include "chrome/common/safe_browsing/client_model.pb.h"
+
+namespace base {
+class SharedMemory;
+}
 
 namespace safe_browsing {
 class FeatureMap;
+class FlatClientModel;
 
 // Scorer methods are virtual to simplify mocking of this class.
 class Scorer {
@@ -33,6 +41,13 @@ class Scorer {
   // model.  If parsing fails this method returns NULL.
   static Scorer* Create(const base::StringPiece& model_str);
 
+  // Factory method which creates a new Scorer object reading the flat model
+  // image of |size| bytes in |shared_memory|, which must already be mapped.
+  // Takes ownership of |shared_memory|.  Returns NULL if the image is invalid.
+  static Scorer* CreateFromFlatModel(
+      scoped_ptr<base::SharedMemory> shared_memory,
+      size_t size);
+
   // This method computes the probability that the given features are indicative
   // of phishing.  It returns a score value that falls in the range [0.0,1.0]
   // (range is inclusive on both ends).
@@ -43,13 +58,8 @@ class Scorer {
 
   // -- Accessors used by the page feature extractor ---------------------------
 
-  // Returns a set of hashed page terms that appear in the model in binary
-  // format.
-  const base::hash_set<std::string>& page_terms() const;
-
-  // Returns a set of hashed page words that appear in the model in binary
-  // format.
-  const base::hash_set<uint32>& page_words() const;
+  // Returns the model, for looking up hashed page terms and page words.
+  const FlatClientModel* flat_model() const;
 
   // Return the maximum number of words per term for the loaded model.
   size_t max_words_per_term() const;
@@ -65,23 +75,27 @@ class Scorer {
 
  protected:
   // Most clients should use the factory method.  This constructor is public
-  // to allow for mock implementations.
+  // to allow for mock implementations, and loads an empty model.
   Scorer();
 
  private:
   friend class PhishingScorerTest;
 
-  // Computes the score for a given rule and feature map.  The score is computed
-  // by multiplying the rule weight with the product of feature weights for the
-  // given rule.  The feature weights are stored in the feature map.  If a
-  // particular feature does not exist in the feature map we set its weight to
-  // zero.
-  double ComputeRuleScore(const ClientSideModel::Rule& rule,
-                          const FeatureMap& features) const;
-
-  ClientSideModel model_;
-  base::hash_set<std::string> page_terms_;
-  base::hash_set<uint32> page_words_;
+  // The weights of a FeatureMap sorted by feature name, so that the features
+  // of the model's rules can be looked up without copying them to strings.
+  typedef std::vector<std::pair<base::StringPiece, double> > FeatureWeights;
+
+  // Computes the score for a given rule and feature weights.  The score is
+  // computed by multiplying the rule weight with the product of feature weights
+  // for the given rule.  If a particular feature does not exist in |weights| we
+  // set its weight to zero.
+  double ComputeRuleScore(size_t rule, const FeatureWeights& weights) const;
+
+  // Holds the image when it is not in shared memory, in a buffer aligned for
+  // FlatClientModel::Create().
+  std::vector<uint32> image_;
+  scoped_ptr<base::SharedMemory> shared_memory_;
+  scoped_ptr<FlatClientModel> model_;
 
   DISALLOW_COPY_AND_ASSIGN(Scorer);
 };
@@ -9,9 +9,11 @@
 #include "base/files/scoped_temp_dir.h"
 #include "base/format_macros.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
 #include "base/message_loop/message_loop.h"
 #include "base/threading/thread.h"
 #include "chrome/common/safe_browsing/client_model.pb.h"
+#include "chrome/common/safe_browsing/flat_client_model.h"
 #include "chrome/renderer/safe_browsing/features.h"
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -71,31 +73,78 @@ TEST_F(PhishingScorerTest, HasValidModel) {
   scorer.reset(Scorer::Create("bogus string"));
   EXPECT_FALSE(scorer.get());
 
+  // Model refers to a hash it does not contain.
+  model_.add_page_term(model_.hashes_size());
+  scorer.reset(Scorer::Create(model_.SerializeAsString()));
+  EXPECT_FALSE(scorer.get());
+
   // Mode is missing a required field.
   model_.clear_max_words_per_term();
   scorer.reset(Scorer::Create(model_.SerializePartialAsString()));
   EXPECT_FALSE(scorer.get());
 }
 
+TEST_F(PhishingScorerTest, CreateFromFlatModel) {
+  std::string image;
+  ASSERT_TRUE(FlatClientModel::Build(model_, &image));
+
+  scoped_ptr<base::SharedMemory> shared_memory(new base::SharedMemory());
+  ASSERT_TRUE(shared_memory->CreateAndMapAnonymous(image.size()));
+  memcpy(shared_memory->memory(), image.data(), image.size());
+  scoped_ptr<Scorer> scorer(
+      Scorer::CreateFromFlatModel(shared_memory.Pass(), image.size()));
+  ASSERT_TRUE(scorer.get());
+  EXPECT_TRUE(scorer->flat_model()->HasPageTerm("token one"));
+  EXPECT_EQ(2U, scorer->max_words_per_term());
+
+  FeatureMap features;
+  EXPECT_DOUBLE_EQ(0.62245933120185459, scorer->ComputeScore(features));
+
+  // A truncated image is rejected.
+  shared_memory.reset(new base::SharedMemory());
+  ASSERT_TRUE(shared_memory->CreateAndMapAnonymous(image.size()));
+  memcpy(shared_memory->memory(), image.data(), image.size());
+  scorer.reset(
+      Scorer::CreateFromFlatModel(shared_memory.Pass(), image.size() - 1));
+  EXPECT_FALSE(scorer.get());
+
+  // So is one with a page term index out of range.  The page terms follow
+  // the header, five hashes, three rules, and three rule features.
+  const size_t kPageTermOffset = 13 * sizeof(uint32) + 5 * 2 * sizeof(uint32) +
+      3 * 3 * sizeof(uint32) + 3 * sizeof(uint32);
+  uint32 page_term = 0;
+  memcpy(&page_term, image.data() + kPageTermOffset, sizeof(page_term));
+  ASSERT_EQ(3U, page_term);
+  page_term = 99;
+  shared_memory.reset(new base::SharedMemory());
+  ASSERT_TRUE(shared_memory->CreateAndMapAnonymous(image.size()));
+  memcpy(shared_memory->memory(), image.data(), image.size());
+  memcpy(static_cast<char*>(shared_memory->memory()) + kPageTermOffset,
+         &page_term, sizeof(page_term));
+  scorer.reset(Scorer::CreateFromFlatModel(shared_memory.Pass(),
+                                           image.size()));
+  EXPECT_FALSE(scorer.get());
+}
+
 TEST_F(PhishingScorerTest, PageTerms) {
   scoped_ptr<Scorer> scorer(Scorer::Create(model_.SerializeAsString()));
   ASSERT_TRUE(scorer.get());
-  base::hash_set<std::string> expected_page_terms;
-  expected_page_terms.insert("token one");
-  expected_page_terms.insert("token two");
-  EXPECT_THAT(scorer->page_terms(),
-              ::testing::ContainerEq(expected_page_terms));
+  const FlatClientModel* model = scorer->flat_model();
+  EXPECT_TRUE(model->HasPageTerm("token one"));
+  EXPECT_TRUE(model->HasPageTerm("token two"));
+  EXPECT_FALSE(model->HasPageTerm("feature1"));
+  EXPECT_FALSE(model->HasPageTerm("token"));
 }
 
 TEST_F(PhishingScorerTest, PageWords) {
   scoped_ptr<Scorer> scorer(Scorer::Create(model_.SerializeAsString()));
   ASSERT_TRUE(scorer.get());
-  base::hash_set<uint32> expected_page_words;
-  expected_page_words.insert(1000U);
-  expected_page_words.insert(2000U);
-  expected_page_words.insert(3000U);
-  EXPECT_THAT(scorer->page_words(),
-              ::testing::ContainerEq(expected_page_words));
+  const FlatClientModel* model = scorer->flat_model();
+  EXPECT_TRUE(model->HasPageWord(1000U));
+  EXPECT_TRUE(model->HasPageWord(2000U));
+  EXPECT_TRUE(model->HasPageWord(3000U));
+  EXPECT_FALSE(model->HasPageWord(0U));
+  EXPECT_FALSE(model->HasPageWord(2500U));
   EXPECT_EQ(2U, scorer->max_words_per_term());
   EXPECT_EQ(12345U, scorer->murmurhash3_seed());
   EXPECT_EQ(10U, scorer->max_shingles_per_page());
@@ -40,7 +40,8 @@ SpellingEngine* CreateNativeSpellingEngine() {
 HunspellEngine::HunspellEngine()
     : hunspell_enabled_(false),
       initialized_(false),
-      dictionary_requested_(false) {
+      dictionary_requested_(false),
+      first_check_recorded_(false) {
   // Wait till we check the first word before doing any initializing.
 }
 
@@ -69,11 +70,20 @@ void HunspellEngine::InitializeHunspell() {
 
     DHISTOGRAM_TIMES("Spellcheck.InitTime",
                      base::Histogram::DebugNow() - debug_start_time);
+    RecordInitMetrics();
   } else {
     NOTREACHED() << "Could not mmap spellchecker dictionary.";
   }
 }
 
+void HunspellEngine::RecordInitMetrics() {
+  if (first_check_recorded_ || first_check_time_.is_null())
+    return;
+  first_check_recorded_ = true;
+  UMA_HISTOGRAM_TIMES("SpellCheck.TimeToFirstCheck",
+                      TimeTicks::Now() - first_check_time_);
+}
+
 bool HunspellEngine::CheckSpelling(const base::string16& word_to_check,
                                    int tag) {
   // Assume all words that cannot be checked are valid. Since Chrome can't
@@ -123,6 +133,9 @@ void HunspellEngine::FillSuggestionList(
 }
 
 bool HunspellEngine::InitializeIfNeeded() {
+  if (first_check_time_.is_null())
+    first_check_time_ = TimeTicks::Now();
+
   if (!initialized_ && !dictionary_requested_) {
     // RenderThread will not exist in test.
     if (RenderThread::Get())
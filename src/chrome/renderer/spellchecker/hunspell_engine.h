@@ -11,6 +11,7 @@
 #include "base/memory/scoped_ptr.h"
 #include "base/strings/string16.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/time/time.h"
 #include "chrome/common/spellcheck_common.h"
 #include "chrome/renderer/spellchecker/spelling_engine.h"
 
@@ -40,6 +41,9 @@ class HunspellEngine : public SpellingEngine {
   // non-null. This blocks.
   void InitializeHunspell();
 
+  // Records how long the first word waited for the dictionary.
+  void RecordInitMetrics();
+
   // We memory-map the BDict file.
   scoped_ptr<base::MemoryMappedFile> bdict_file_;
 
@@ -59,6 +63,10 @@ class HunspellEngine : public SpellingEngine {
 
   // This flag is true if we have requested dictionary.
   bool dictionary_requested_;
+
+  // When the first word was checked, until the first time Hunspell is ready.
+  base::TimeTicks first_check_time_;
+  bool first_check_recorded_;
 };
 
 #endif  // CHROME_RENDERER_SPELLCHECKER_HUNSPELL_ENGINE_H_
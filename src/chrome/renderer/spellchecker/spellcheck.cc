@@ -4,9 +4,14 @@
 
 #include "chrome/renderer/spellchecker/spellcheck.h"
 
+#include <algorithm>
+
 #include "base/bind.h"
 #include "base/message_loop/message_loop_proxy.h"
+#include "base/metrics/histogram.h"
+#include "base/strings/string_util.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/time/time.h"
 #include "chrome/common/render_messages.h"
 #include "chrome/common/spellcheck_common.h"
 #include "chrome/common/spellcheck_messages.h"
@@ -67,26 +72,81 @@ bool DocumentMarkersCollector::Visit(content::RenderView* render_view) {
   return true;
 }
 
+#if !defined(OS_MACOSX)
+// Background checking yields to other tasks once a slice has run this long.
+const int kSpellCheckSliceMs = 10;
+
+// Within a slice, text is checked in chunks of about this many characters,
+// between which the time is checked.
+const size_t kSpellCheckChunkLength = 1024;
+
+// Returns the start of the word around |position| in |text|, taking any run
+// of non-whitespace characters as a word. The word iterator never joins
+// characters across whitespace, so checking can restart there.
+size_t StartOfWordAt(const base::string16& text, size_t position) {
+  while (position > 0 && !IsWhitespace(text[position - 1]))
+    --position;
+  return position;
+}
+
+// Returns the end of the word around |position| in |text|.
+size_t EndOfWordAt(const base::string16& text, size_t position) {
+  while (position < text.length() && !IsWhitespace(text[position]))
+    ++position;
+  return position;
+}
+#endif
+
 }  // namespace
 
 class SpellCheck::SpellcheckRequest {
  public:
   SpellcheckRequest(const base::string16& text,
                     blink::WebTextCheckingCompletion* completion)
-      : text_(text), completion_(completion) {
+      : text_(text),
+        completion_(completion),
+        started_(false),
+        check_start_(0),
+        check_end_(0) {
     DCHECK(completion);
   }
   ~SpellcheckRequest() {}
 
-  base::string16 text() { return text_; }
+  const base::string16& text() const { return text_; }
   blink::WebTextCheckingCompletion* completion() { return completion_; }
 
+  // The state of the background check. The misspellings before
+  // |check_start()| are in |results()|; the text between |check_start()| and
+  // |check_end()| is left to check; and the misspellings from |check_end()|
+  // on, which were reused from the previous paragraph, are in
+  // |suffix_results()|.
+  bool started() const { return started_; }
+  size_t check_start() const { return check_start_; }
+  size_t check_end() const { return check_end_; }
+  std::vector<WebTextCheckingResult>* results() { return &results_; }
+  std::vector<WebTextCheckingResult>* suffix_results() {
+    return &suffix_results_;
+  }
+
+  void Start(size_t check_start, size_t check_end) {
+    started_ = true;
+    check_start_ = check_start;
+    check_end_ = check_end;
+  }
+  void set_check_start(size_t check_start) { check_start_ = check_start; }
+
  private:
   base::string16 text_;  // Text to be checked in this task.
 
   // The interface to send the misspelled ranges to WebKit.
   blink::WebTextCheckingCompletion* completion_;
 
+  bool started_;
+  size_t check_start_;
+  size_t check_end_;
+  std::vector<WebTextCheckingResult> results_;
+  std::vector<WebTextCheckingResult> suffix_results_;
+
   DISALLOW_COPY_AND_ASSIGN(SpellcheckRequest);
 };
 
@@ -146,6 +206,10 @@ void SpellCheck::OnCustomDictionaryChanged(
     const std::vector<std::string>& words_added,
     const std::vector<std::string>& words_removed) {
   custom_dictionary_.OnCustomDictionaryChanged(words_added, words_removed);
+#if !defined(OS_MACOSX)
+  last_paragraph_.clear();
+  last_paragraph_results_.clear();
+#endif
 }
 
 void SpellCheck::OnEnableAutoSpellCorrect(bool enable) {
@@ -172,6 +236,10 @@ void SpellCheck::Init(base::File file,
                       const std::string& language) {
   spellcheck_.Init(file.Pass(), language);
   custom_dictionary_.Init(custom_words);
+#if !defined(OS_MACOSX)
+  last_paragraph_.clear();
+  last_paragraph_results_.clear();
+#endif
 }
 
 bool SpellCheck::SpellCheckWord(
@@ -202,40 +270,9 @@ bool SpellCheck::SpellCheckParagraph(
   // Mac has its own spell checker, so this method will not be used.
   DCHECK(results);
   std::vector<WebTextCheckingResult> textcheck_results;
-  size_t length = text.length();
-  size_t offset = 0;
-
-  // Spellcheck::SpellCheckWord() automatically breaks text into words and
-  // checks the spellings of the extracted words. This function sets the
-  // position and length of the first misspelled word and returns false when
-  // the text includes misspelled words. Therefore, we just repeat calling the
-  // function until it returns true to check the whole text.
-  int misspelling_start = 0;
-  int misspelling_length = 0;
-  while (offset <= length) {
-    if (SpellCheckWord(&text[offset],
-                       length - offset,
-                       0,
-                       &misspelling_start,
-                       &misspelling_length,
-                       NULL)) {
-      results->assign(textcheck_results);
-      return true;
-    }
-
-    if (!custom_dictionary_.SpellCheckWord(
-            text, misspelling_start + offset, misspelling_length)) {
-      base::string16 replacement;
-      textcheck_results.push_back(WebTextCheckingResult(
-          blink::WebTextDecorationTypeSpelling,
-          misspelling_start + offset,
-          misspelling_length,
-          replacement));
-    }
-    offset += misspelling_start + misspelling_length;
-  }
+  SpellCheckRange(text, 0, text.length(), &textcheck_results);
   results->assign(textcheck_results);
-  return false;
+  return textcheck_results.empty();
 #else
   // This function is only invoked for spell checker functionality that runs
   // on the render thread. OSX builds don't have that.
@@ -327,20 +364,127 @@ void SpellCheck::PostDelayedSpellCheckTask(SpellcheckRequest* request) {
   base::MessageLoopProxy::current()->PostTask(FROM_HERE,
       base::Bind(&SpellCheck::PerformSpellCheck,
                  AsWeakPtr(),
-                 base::Owned(request)));
+                 base::Passed(make_scoped_ptr(request))));
 }
 #endif
 
 #if !defined(OS_MACOSX)  // Mac uses its native engine instead.
-void SpellCheck::PerformSpellCheck(SpellcheckRequest* param) {
-  DCHECK(param);
+void SpellCheck::PerformSpellCheck(scoped_ptr<SpellcheckRequest> request) {
+  DCHECK(request.get());
 
   if (!spellcheck_.IsEnabled()) {
-    param->completion()->didCancelCheckingText();
-  } else {
-    WebVector<blink::WebTextCheckingResult> results;
-    SpellCheckParagraph(param->text(), &results);
-    param->completion()->didFinishCheckingText(results);
+    request->completion()->didCancelCheckingText();
+    return;
+  }
+
+  if (!request->started())
+    StartSpellCheck(request.get());
+
+  const base::string16& text = request->text();
+  const base::TimeTicks deadline = base::TimeTicks::Now() +
+      base::TimeDelta::FromMilliseconds(kSpellCheckSliceMs);
+  while (request->check_start() < request->check_end()) {
+    size_t chunk_end = request->check_end();
+    if (chunk_end - request->check_start() > kSpellCheckChunkLength) {
+      chunk_end = EndOfWordAt(
+          text, request->check_start() + kSpellCheckChunkLength);
+      chunk_end = std::min(chunk_end, request->check_end());
+    }
+    SpellCheckRange(text, request->check_start(), chunk_end,
+                    request->results());
+    request->set_check_start(chunk_end);
+
+    if (request->check_start() < request->check_end() &&
+        base::TimeTicks::Now() >= deadline) {
+      PostDelayedSpellCheckTask(request.release());
+      return;
+    }
+  }
+
+  request->results()->insert(request->results()->end(),
+                             request->suffix_results()->begin(),
+                             request->suffix_results()->end());
+  last_paragraph_ = text;
+  last_paragraph_results_ = *request->results();
+  WebVector<WebTextCheckingResult> results(*request->results());
+  request->completion()->didFinishCheckingText(results);
+}
+
+void SpellCheck::StartSpellCheck(SpellcheckRequest* request) {
+  const base::string16& text = request->text();
+  const size_t shorter = std::min(text.length(), last_paragraph_.length());
+
+  // Find the text which changed: everything between the longest common
+  // prefix and the longest common suffix, widened to whole words.
+  size_t prefix = 0;
+  while (prefix < shorter && text[prefix] == last_paragraph_[prefix])
+    ++prefix;
+  size_t suffix = 0;
+  while (suffix < shorter - prefix &&
+         text[text.length() - suffix - 1] ==
+             last_paragraph_[last_paragraph_.length() - suffix - 1]) {
+    ++suffix;
+  }
+  const size_t check_start = StartOfWordAt(text, prefix);
+  const size_t check_end = EndOfWordAt(text, text.length() - suffix);
+
+  // Keep the misspellings before the change, and those after it, moved by
+  // the change in length.
+  const int delta = static_cast<int>(text.length()) -
+      static_cast<int>(last_paragraph_.length());
+  const int old_check_end = static_cast<int>(check_end) - delta;
+  for (size_t i = 0; i < last_paragraph_results_.size(); ++i) {
+    WebTextCheckingResult result = last_paragraph_results_[i];
+    if (result.location + result.length <= static_cast<int>(check_start)) {
+      request->results()->push_back(result);
+    } else if (result.location >= old_check_end) {
+      result.location += delta;
+      request->suffix_results()->push_back(result);
+    }
+  }
+  request->Start(check_start, check_end);
+
+  if (!text.empty()) {
+    UMA_HISTOGRAM_PERCENTAGE(
+        "SpellCheck.ParagraphRecheckedPercent",
+        static_cast<int>((check_end - check_start) * 100 / text.length()));
+  }
+}
+
+void SpellCheck::SpellCheckRange(
+    const base::string16& text,
+    size_t start,
+    size_t end,
+    std::vector<WebTextCheckingResult>* results) {
+  DCHECK_LE(end, text.length());
+  size_t offset = start;
+
+  // SpellCheckWord() automatically breaks text into words and checks the
+  // spellings of the extracted words. It sets the position and length of the
+  // first misspelled word and returns false when the text includes misspelled
+  // words. Therefore, we just repeat calling it from the end of each
+  // misspelling until it returns true to check the whole range.
+  int misspelling_start = 0;
+  int misspelling_length = 0;
+  while (offset < end) {
+    if (SpellCheckWord(&text[offset],
+                       end - offset,
+                       0,
+                       &misspelling_start,
+                       &misspelling_length,
+                       NULL)) {
+      return;
+    }
+
+    if (!custom_dictionary_.SpellCheckWord(
+            text, misspelling_start + offset, misspelling_length)) {
+      results->push_back(WebTextCheckingResult(
+          blink::WebTextDecorationTypeSpelling,
+          misspelling_start + offset,
+          misspelling_length,
+          base::string16()));
+    }
+    offset += misspelling_start + misspelling_length;
   }
 }
 #endif
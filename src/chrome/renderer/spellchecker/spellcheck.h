@@ -89,7 +89,9 @@ class SpellCheck : public content::RenderProcessObserver,
   base::string16 GetAutoCorrectionWord(const base::string16& word, int tag);
 
   // Requests to spellcheck the specified text in the background. This function
-  // posts a background task and calls SpellCheckParagraph() in the task.
+  // posts a background task which checks the text in slices, so that a long
+  // paragraph does not block the render thread. Only the part of the text
+  // which changed since the last paragraph checked is checked again.
 #if !defined (OS_MACOSX)
   void RequestTextChecking(const base::string16& text,
                            blink::WebTextCheckingCompletion* completion);
@@ -134,8 +136,20 @@ class SpellCheck : public content::RenderProcessObserver,
   // Takes ownership of |request|.
   void PostDelayedSpellCheckTask(SpellcheckRequest* request);
 
-  // Performs spell checking from the request queue.
-  void PerformSpellCheck(SpellcheckRequest* request);
+  // Performs spell checking from the request queue. Checks one slice of the
+  // request, and posts another task for the rest if there is any.
+  void PerformSpellCheck(scoped_ptr<SpellcheckRequest> request);
+
+  // Compares the text of |request| with |last_paragraph_|, and sets up
+  // |request| to check only the part which changed.
+  void StartSpellCheck(SpellcheckRequest* request);
+
+  // Checks the words of |text| between |start| and |end|, which must lie at
+  // word boundaries, and appends the misspellings to |results|.
+  void SpellCheckRange(const base::string16& text,
+                       size_t start,
+                       size_t end,
+                       std::vector<blink::WebTextCheckingResult>* results);
 
   // The parameters of a pending background-spellchecking request. When WebKit
   // sends a background-spellchecking request before initializing hunspell,
@@ -143,6 +157,11 @@ class SpellCheck : public content::RenderProcessObserver,
   // hunspell. (When WebKit sends two or more requests, we cancel the previous
   // requests so we do not have to use vectors.)
   scoped_ptr<SpellcheckRequest> pending_request_param_;
+
+  // The last paragraph checked in the background, and its misspellings, from
+  // which the next request reuses the results of unchanged text.
+  base::string16 last_paragraph_;
+  std::vector<blink::WebTextCheckingResult> last_paragraph_results_;
 #endif
 
   SpellcheckLanguage spellcheck_;  // Language-specific spellchecking code.
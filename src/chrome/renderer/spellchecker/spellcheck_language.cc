@@ -8,9 +8,16 @@
 #include "chrome/renderer/spellchecker/spellcheck_worditerator.h"
 #include "chrome/renderer/spellchecker/spelling_engine.h"
 
+namespace {
+
+// The number of word results SpellcheckLanguage keeps.
+const size_t kWordCacheSize = 10000;
+
+}  // namespace
 
 SpellcheckLanguage::SpellcheckLanguage()
-    : platform_spelling_engine_(CreateNativeSpellingEngine()) {
+    : platform_spelling_engine_(CreateNativeSpellingEngine()),
+      word_cache_(kWordCacheSize) {
 }
 
 SpellcheckLanguage::~SpellcheckLanguage() {
@@ -20,6 +27,7 @@ void SpellcheckLanguage::Init(base::File file, const std::string& language) {
   DCHECK(platform_spelling_engine_.get());
   platform_spelling_engine_->Init(file.Pass());
 
+  word_cache_.Clear();
   character_attributes_.SetDefaultLanguage(language);
   text_iterator_.Reset();
   contraction_iterator_.Reset();
@@ -70,12 +78,7 @@ bool SpellcheckLanguage::SpellCheckWord(
   while (text_iterator_.GetNextWord(&word, &word_start, &word_length)) {
     // Found a word (or a contraction) that the spellchecker can check the
     // spelling of.
-    if (platform_spelling_engine_->CheckSpelling(word, tag))
-      continue;
-
-    // If the given word is a concatenated word of two or more valid words
-    // (e.g. "hello:hello"), we should treat it as a valid word.
-    if (IsValidContraction(word, tag))
+    if (IsCorrectWord(word, tag))
       continue;
 
     *misspelling_start = word_start;
@@ -92,6 +95,22 @@ bool SpellcheckLanguage::SpellCheckWord(
   return true;
 }
 
+bool SpellcheckLanguage::IsCorrectWord(const base::string16& word, int tag) {
+  if (tag == 0) {
+    WordCache::iterator cached = word_cache_.Get(word);
+    if (cached != word_cache_.end())
+      return cached->second;
+  }
+
+  // If the given word is a concatenated word of two or more valid words
+  // (e.g. "hello:hello"), we should treat it as a valid word.
+  const bool correct = platform_spelling_engine_->CheckSpelling(word, tag) ||
+                       IsValidContraction(word, tag);
+  if (tag == 0)
+    word_cache_.Put(word, correct);
+  return correct;
+}
+
 // Returns whether or not the given string is a valid contraction.
 // This function is a fall-back when the SpellcheckWordIterator class
 // returns a concatenated word which is not in the selected dictionary
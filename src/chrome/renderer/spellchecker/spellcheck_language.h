@@ -9,6 +9,7 @@
 #include <string>
 #include <vector>
 
+#include "base/containers/mru_cache.h"
 #include "base/files/file.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/strings/string16.h"
@@ -54,6 +55,10 @@ class SpellcheckLanguage {
   // (e.g. "word:word").
   bool IsValidContraction(const base::string16& word, int tag);
 
+  // Returns whether the spelling engine accepts |word|, either as a word or as
+  // a contraction of valid words. Results are cached in |word_cache_|.
+  bool IsCorrectWord(const base::string16& word, int tag);
+
   // Represents character attributes used for filtering out characters which
   // are not supported by this SpellCheck object.
   SpellcheckCharAttribute character_attributes_;
@@ -70,6 +75,13 @@ class SpellcheckLanguage {
   // should only be set if hunspell is not used. (I.e. on OSX, for now)
   scoped_ptr<SpellingEngine> platform_spelling_engine_;
 
+  // The most recently checked words and whether they are correct, so that
+  // rechecking unchanged text does not go back to the spelling engine. Words
+  // checked with a document tag are not cached, as the result may depend on
+  // the document. Cleared whenever the dictionary or language changes.
+  typedef base::MRUCache<base::string16, bool> WordCache;
+  WordCache word_cache_;
+
   DISALLOW_COPY_AND_ASSIGN(SpellcheckLanguage);
 };
 
@@ -0,0 +1,126 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <set>
+#include <string>
+
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/message_loop/message_loop.h"
+#include "base/path_service.h"
+#include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversions.h"
+#include "base/time/time.h"
+#include "chrome/common/spellcheck_common.h"
+#include "chrome/renderer/spellchecker/spellcheck.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "third_party/WebKit/public/web/WebTextCheckingCompletion.h"
+#include "third_party/WebKit/public/web/WebTextCheckingResult.h"
+
+// Background checking is not used with the platform spellchecker.
+#if !defined(OS_MACOSX)
+
+namespace {
+
+// A document of kSentences copies of kSentence, each with one misspelling.
+const char kSentence[] =
+    "The quick brown fox jumps over the lazy dog, and teh dog sleeps. ";
+const size_t kSentences = 2000;
+
+// Typed into the middle of the document, one character at a time.
+const char kTyped[] = "misteak ";
+
+base::FilePath GetHunspellDirectory() {
+  base::FilePath hunspell_directory;
+  if (!PathService::Get(base::DIR_SOURCE_ROOT, &hunspell_directory))
+    return base::FilePath();
+
+  hunspell_directory = hunspell_directory.AppendASCII("third_party");
+  hunspell_directory = hunspell_directory.AppendASCII("hunspell_dictionaries");
+  return hunspell_directory;
+}
+
+// Keeps the results of the last background check.
+class TextCheckingCompletion : public blink::WebTextCheckingCompletion {
+ public:
+  TextCheckingCompletion() : completion_count_(0) {}
+
+  virtual void didFinishCheckingText(
+      const blink::WebVector<blink::WebTextCheckingResult>& results)
+          OVERRIDE {
+    completion_count_++;
+    last_results_ = results;
+  }
+
+  virtual void didCancelCheckingText() OVERRIDE {
+    completion_count_++;
+  }
+
+  size_t completion_count_;
+  blink::WebVector<blink::WebTextCheckingResult> last_results_;
+};
+
+}  // namespace
+
+// Checks a long document, then types into the middle of it one character at a
+// time, and reports the time per keystroke of checking the whole document
+// against checking it in the background, which only checks the edited words.
+TEST(SpellCheckPerfTest, LongDocumentTyping) {
+  base::MessageLoop message_loop;
+  base::FilePath hunspell_directory = GetHunspellDirectory();
+  ASSERT_FALSE(hunspell_directory.empty());
+  SpellCheck spell_check;
+  spell_check.Init(
+      base::File(chrome::spellcheck_common::GetVersionedFileName(
+                     "en-US", hunspell_directory),
+                 base::File::FLAG_OPEN | base::File::FLAG_READ),
+      std::set<std::string>(), "en-US");
+
+  base::string16 text;
+  for (size_t i = 0; i < kSentences; ++i)
+    text += base::ASCIIToUTF16(kSentence);
+  const size_t middle = text.length() / 2;
+
+  // The first check loads the dictionary and fills the word cache, as typing
+  // into a page would.
+  base::TimeTicks start = base::TimeTicks::Now();
+  blink::WebVector<blink::WebTextCheckingResult> results;
+  spell_check.SpellCheckParagraph(text, &results);
+  const base::TimeDelta cold_time = base::TimeTicks::Now() - start;
+  EXPECT_EQ(kSentences, results.size());
+
+  base::TimeDelta full_time;
+  base::TimeDelta incremental_time;
+  TextCheckingCompletion completion;
+  spell_check.RequestTextChecking(text, &completion);
+  base::MessageLoop::current()->RunUntilIdle();
+  for (size_t i = 0; i < arraysize(kTyped) - 1; ++i) {
+    text.insert(middle + i, 1, kTyped[i]);
+
+    start = base::TimeTicks::Now();
+    spell_check.SpellCheckParagraph(text, &results);
+    full_time += base::TimeTicks::Now() - start;
+
+    start = base::TimeTicks::Now();
+    spell_check.RequestTextChecking(text, &completion);
+    base::MessageLoop::current()->RunUntilIdle();
+    incremental_time += base::TimeTicks::Now() - start;
+  }
+  EXPECT_EQ(arraysize(kTyped), completion.completion_count_);
+
+  const double keystrokes = arraysize(kTyped) - 1;
+  const std::string trace =
+      base::StringPrintf("%d_chars", static_cast<int>(text.length()));
+  perf_test::PrintResult("spellcheck_first_check", "", trace,
+                         cold_time.InMillisecondsF(), "ms", true);
+  perf_test::PrintResult("spellcheck_keystroke_full", "", trace,
+                         full_time.InMillisecondsF() / keystrokes, "ms",
+                         true);
+  perf_test::PrintResult("spellcheck_keystroke_background", "", trace,
+                         incremental_time.InMillisecondsF() / keystrokes, "ms",
+                         true);
+}
+
+#endif  // !defined(OS_MACOSX)
@@ -5,6 +5,7 @@
 #include "base/file_util.h"
 #include "base/message_loop/message_loop.h"
 #include "base/path_service.h"
+#include "base/strings/stringprintf.h"
 #include "base/strings/sys_string_conversions.h"
 #include "base/strings/utf_string_conversions.h"
 #include "chrome/common/chrome_paths.h"
@@ -19,6 +20,16 @@
 
 namespace {
 
+// Returns the ranges of |results|, for comparing them.
+std::string DescribeResults(
+    const blink::WebVector<blink::WebTextCheckingResult>& results) {
+  std::string description;
+  for (size_t i = 0; i < results.size(); ++i)
+    description += base::StringPrintf("[%d,%d)", results[i].location,
+                                      results[i].location + results[i].length);
+  return description;
+}
+
 base::FilePath GetHunspellDirectory() {
   base::FilePath hunspell_directory;
   if (!PathService::Get(base::DIR_SOURCE_ROOT, &hunspell_directory))
@@ -1126,6 +1137,72 @@ TEST_F(SpellCheckTest, RequestSpellCheckMultipleTimesWithoutInitialization) {
     EXPECT_EQ(completion[i].completion_count_, 1U);
 }
 
+// Edits a paragraph in several ways between background checks, which then
+// only check the changed text again, and compares their results with checking
+// the whole paragraph.
+TEST_F(SpellCheckTest, RequestSpellCheckAfterEdits) {
+  const char* kEdits[] = {
+    "apple, zz, orange, zz",
+    "apple, zz, orangee, zz",
+    "apple, zz, orange, zz",
+    "apple, zz, orange zz, zz",
+    "applezz, orange zz, zz",
+    "zz applezz, orange zz, zz",
+    "zz applezz, orange zz, zzpear",
+    "zz applezz, orange zz, zz pear",
+    "apple pear",
+    "",
+    "zz",
+    "zz zz zz",
+    "zz zzz zz",
+  };
+
+  for (size_t i = 0; i < arraysize(kEdits); ++i) {
+    const base::string16 text(base::ASCIIToUTF16(kEdits[i]));
+    MockTextCheckingCompletion completion;
+    spell_check()->RequestTextChecking(text, &completion);
+    base::MessageLoop::current()->RunUntilIdle();
+    ASSERT_EQ(1U, completion.completion_count_);
+
+    blink::WebVector<blink::WebTextCheckingResult> expected;
+    spell_check()->SpellCheckParagraph(text, &expected);
+    EXPECT_EQ(DescribeResults(expected),
+              DescribeResults(completion.last_results_)) << kEdits[i];
+  }
+}
+
+// Types into the middle of a document that is checked in several slices, and
+// compares the background results after each keystroke with checking the whole
+// document.
+TEST_F(SpellCheckTest, LongDocumentTyping) {
+  const char kSentence[] =
+      "The quick brown fox jumps over the lazy dog, and teh dog sleeps. ";
+  const int kSentences = 2000;
+  base::string16 text;
+  for (int i = 0; i < kSentences; ++i)
+    text += base::ASCIIToUTF16(kSentence);
+  const size_t middle = text.length() / 2;
+
+  blink::WebVector<blink::WebTextCheckingResult> results;
+  spell_check()->SpellCheckParagraph(text, &results);
+  EXPECT_EQ(static_cast<size_t>(kSentences), results.size());
+
+  const char kTyped[] = "misteak ";
+  MockTextCheckingCompletion completion;
+  spell_check()->RequestTextChecking(text, &completion);
+  base::MessageLoop::current()->RunUntilIdle();
+  for (size_t i = 0; i < arraysize(kTyped) - 1; ++i) {
+    text.insert(middle + i, 1, kTyped[i]);
+
+    spell_check()->SpellCheckParagraph(text, &results);
+    spell_check()->RequestTextChecking(text, &completion);
+    base::MessageLoop::current()->RunUntilIdle();
+    EXPECT_EQ(DescribeResults(results),
+              DescribeResults(completion.last_results_));
+  }
+  EXPECT_EQ(arraysize(kTyped), completion.completion_count_);
+}
+
 TEST_F(SpellCheckTest, CreateTextCheckingResults) {
   // Verify that the SpellCheck class keeps the spelling marker added to a
   // misspelled word "zz".
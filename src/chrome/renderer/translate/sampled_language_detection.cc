@@ -0,0 +1,103 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/renderer/translate/sampled_language_detection.h"
+
+#include <algorithm>
+
+#include "base/basictypes.h"
+#include "base/strings/string_util.h"
+#include "components/translate/core/language_detection/language_detection_util.h"
+
+namespace translate {
+
+namespace {
+
+// The number of characters in each chunk of a sample.
+const size_t kSampleChunkLength = 512;
+
+// The sample sizes given to CLD in turn, before the whole text.
+const size_t kSampleBudgets[] = { 2048, 8192, 32768 };
+
+// How far from the ideal start or end of a chunk to look for whitespace.
+const size_t kMaxSnapDistance = 64;
+
+}  // namespace
+
+SampledLanguageDetails::SampledLanguageDetails()
+    : is_cld_reliable(false),
+      sampled_chars(0),
+      rounds(0) {
+}
+
+SampledLanguageDetails::~SampledLanguageDetails() {}
+
+base::string16 SampleText(const base::string16& contents, size_t budget) {
+  if (contents.length() <= budget)
+    return contents;
+
+  const size_t chunks = std::max<size_t>(budget / kSampleChunkLength, 1);
+  const size_t chunk_length = budget / chunks;
+  const size_t stride = contents.length() / chunks;
+  base::string16 sample;
+  sample.reserve(budget + chunks);
+  for (size_t i = 0; i < chunks; ++i) {
+    size_t start = i * stride;
+    if (start > 0) {
+      const size_t space =
+          contents.find_first_of(base::kWhitespaceUTF16, start - 1);
+      if (space != base::string16::npos && space < start + kMaxSnapDistance)
+        start = space + 1;
+    }
+    size_t end = std::min(start + chunk_length, contents.length());
+    if (end < contents.length()) {
+      const size_t space =
+          contents.find_last_of(base::kWhitespaceUTF16, end);
+      if (space != base::string16::npos && space > start &&
+          space + kMaxSnapDistance > end) {
+        end = space;
+      }
+    }
+    if (start >= end)
+      continue;
+    if (!sample.empty())
+      sample.push_back(' ');
+    sample.append(contents, start, end - start);
+  }
+  return sample;
+}
+
+SampledLanguageDetails DeterminePageLanguageFromSamples(
+    const std::string& code,
+    const std::string& html_lang,
+    const base::string16& contents) {
+  const base::TimeTicks start_time = base::TimeTicks::Now();
+  SampledLanguageDetails details;
+  std::string previous_cld_language;
+  bool previous_reliable = false;
+  for (size_t i = 0; i <= arraysize(kSampleBudgets); ++i) {
+    const bool whole = (i == arraysize(kSampleBudgets)) ||
+                       (contents.length() <= kSampleBudgets[i]);
+    const base::string16 sample =
+        whole ? contents : SampleText(contents, kSampleBudgets[i]);
+    details.language = DeterminePageLanguage(
+        code, html_lang, sample, &details.cld_language,
+        &details.is_cld_reliable);
+    details.sampled_chars = sample.length();
+    ++details.rounds;
+
+    // Two reliable rounds in a row agree: more text is unlikely to change
+    // the answer.
+    if (whole || (details.is_cld_reliable && previous_reliable &&
+                  details.cld_language == previous_cld_language)) {
+      break;
+    }
+    previous_cld_language = details.cld_language;
+    previous_reliable = details.is_cld_reliable;
+  }
+  details.detection_time = base::TimeTicks::Now() - start_time;
+  return details;
+}
+
+}  // namespace translate
@@ -0,0 +1,52 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_RENDERER_TRANSLATE_SAMPLED_LANGUAGE_DETECTION_H_
+#define CHROME_RENDERER_TRANSLATE_SAMPLED_LANGUAGE_DETECTION_H_
+
+#include <string>
+
+#include "base/strings/string16.h"
+#include "base/time/time.h"
+
+namespace translate {
+
+// The result of DeterminePageLanguageFromSamples().
+struct SampledLanguageDetails {
+  SampledLanguageDetails();
+  ~SampledLanguageDetails();
+
+  // As returned by DeterminePageLanguage().
+  std::string language;
+  std::string cld_language;
+  bool is_cld_reliable;
+
+  // The number of characters of the page given to CLD in the last round, and
+  // the number of rounds.
+  size_t sampled_chars;
+  int rounds;
+
+  // How long detection took, on the thread it ran on.
+  base::TimeDelta detection_time;
+};
+
+// Returns about |budget| characters of |contents|, taken as chunks spread
+// evenly across it, so that a sample is not only the header or navigation
+// text at the start of a page.  Chunks start and end at whitespace when there
+// is any nearby, so that words are not cut.  Returns all of |contents| if it
+// is no longer than |budget|.
+base::string16 SampleText(const base::string16& contents, size_t budget);
+
+// Determines the language of a page as DeterminePageLanguage() does, but
+// gives CLD growing samples of |contents| and stops as soon as two rounds in
+// a row reliably agree, rather than always running it over the whole text.
+// This does not touch the DOM, so it can run on any thread.
+SampledLanguageDetails DeterminePageLanguageFromSamples(
+    const std::string& code,
+    const std::string& html_lang,
+    const base::string16& contents);
+
+}  // namespace translate
+
+#endif  // CHROME_RENDERER_TRANSLATE_SAMPLED_LANGUAGE_DETECTION_H_
@@ -0,0 +1,75 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "chrome/renderer/translate/sampled_language_detection.h"
+#include "chrome/renderer/translate/sampled_language_detection_test_util.h"
+#include "components/translate/core/language_detection/language_detection_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace translate {
+
+namespace {
+
+// Page sizes, in paragraphs; the largest is close to the 64K characters
+// ChromeRenderViewObserver captures.
+const int kParagraphCounts[] = { 20, 80, 250 };
+
+// Detections timed per page.
+const int kRuns = 10;
+
+// Times detecting the language of |page| from its whole text and from
+// samples, and reports the times under |trace|.
+void TimeDetection(const base::string16& page, const std::string& trace) {
+  base::TimeDelta whole_time;
+  base::TimeDelta sampled_time;
+  size_t sampled_chars = 0;
+  for (int run = 0; run < kRuns; ++run) {
+    const base::TimeTicks start = base::TimeTicks::Now();
+    std::string cld_language;
+    bool is_cld_reliable = false;
+    const std::string whole_language = DeterminePageLanguage(
+        std::string(), std::string(), page, &cld_language, &is_cld_reliable);
+    whole_time += base::TimeTicks::Now() - start;
+
+    SampledLanguageDetails details =
+        DeterminePageLanguageFromSamples(std::string(), std::string(), page);
+    sampled_time += details.detection_time;
+    sampled_chars = details.sampled_chars;
+    EXPECT_EQ(whole_language, details.language) << trace;
+  }
+
+  perf_test::PrintResult("language_detection_whole", "", trace,
+                         whole_time.InMicroseconds() /
+                             static_cast<double>(kRuns),
+                         "us", true);
+  perf_test::PrintResult("language_detection_sampled", "", trace,
+                         sampled_time.InMicroseconds() /
+                             static_cast<double>(kRuns),
+                         "us", true);
+  perf_test::PrintResult("language_detection_sampled_chars", "", trace,
+                         sampled_chars, "chars", false);
+}
+
+}  // namespace
+
+// Times detecting the language of French pages of several sizes, which start
+// with English navigation text, and of a page whose first third is English.
+TEST(SampledLanguageDetectionPerfTest, PageSizes) {
+  for (size_t i = 0; i < arraysize(kParagraphCounts); ++i) {
+    const base::string16 page = MakeTestPage("fr", kParagraphCounts[i]);
+    TimeDetection(page, base::StringPrintf(
+        "%d_chars", static_cast<int>(page.length())));
+  }
+
+  const base::string16 mixed_page = MakeMixedTestPage("en", 80, "fr", 170);
+  TimeDetection(mixed_page, base::StringPrintf(
+      "mixed_%d_chars", static_cast<int>(mixed_page.length())));
+}
+
+}  // namespace translate
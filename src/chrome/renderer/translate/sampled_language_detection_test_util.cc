@@ -0,0 +1,164 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/renderer/translate/sampled_language_detection_test_util.h"
+
+#include <algorithm>
+
+#include "base/basictypes.h"
+#include "base/logging.h"
+#include "base/strings/utf_string_conversions.h"
+
+namespace translate {
+
+namespace {
+
+// Navigation text in English.
+const char kBoilerplate[] =
+    "Home News Sport Weather Contact us Sign in Register Search Menu Privacy "
+    "Terms of use Help Settings Subscribe Follow us Share this page ";
+
+// Body paragraphs of pages in a few languages, on different subjects.
+const struct {
+  const char* language;
+  const char* paragraph;
+} kCorpus[] = {
+  { "en", "The committee met on Tuesday to discuss the new budget for the "
+          "city library, which has been closed for repairs since the storm "
+          "damaged its roof last winter. Members agreed that the reading "
+          "rooms should open again before the start of the school year. " },
+  { "en", "Preheat the oven and grease a large baking tin. Beat the butter "
+          "and sugar together until pale, then add the eggs one at a time. "
+          "Fold in the flour gently and pour the mixture into the tin before "
+          "baking it for about forty minutes. " },
+  { "en", "The visiting side scored twice in the first half, but a late "
+          "penalty and a header from the captain in the last minute of "
+          "injury time earned the home team a draw that keeps them in second "
+          "place in the league. " },
+  { "fr", "Le conseil municipal s'est réuni mardi pour discuter du nouveau "
+          "budget de la bibliothèque, fermée pour travaux depuis que la "
+          "tempête a endommagé son toit l'hiver dernier. Les membres ont "
+          "convenu que les salles de lecture devraient rouvrir avant la "
+          "rentrée scolaire. " },
+  { "fr", "Préchauffez le four et beurrez un grand moule. Battez le beurre "
+          "et le sucre jusqu'à ce que le mélange blanchisse, puis ajoutez "
+          "les œufs un par un. Incorporez délicatement la farine et versez "
+          "la pâte dans le moule avant de la faire cuire une quarantaine de "
+          "minutes. " },
+  { "fr", "Les visiteurs ont marqué deux fois en première période, mais un "
+          "penalty tardif et une tête du capitaine dans les arrêts de jeu "
+          "ont permis à l'équipe locale d'arracher un match nul qui la "
+          "maintient à la deuxième place du championnat. " },
+  { "de", "Der Ausschuss traf sich am Dienstag, um über den neuen Haushalt "
+          "der Stadtbibliothek zu beraten, die seit dem Sturm im letzten "
+          "Winter wegen Reparaturen am Dach geschlossen ist. Die Mitglieder "
+          "waren sich einig, dass die Lesesäle vor Beginn des Schuljahres "
+          "wieder öffnen sollen. " },
+  { "de", "Den Backofen vorheizen und eine große Form einfetten. Butter und "
+          "Zucker schaumig schlagen, dann die Eier nacheinander unterrühren. "
+          "Das Mehl vorsichtig unterheben und den Teig in die Form füllen, "
+          "bevor er etwa vierzig Minuten gebacken wird. " },
+  { "de", "Die Gäste trafen in der ersten Halbzeit zweimal, doch ein später "
+          "Elfmeter und ein Kopfball des Kapitäns in der Nachspielzeit "
+          "sicherten der Heimmannschaft ein Unentschieden, mit dem sie auf "
+          "dem zweiten Tabellenplatz bleibt. " },
+  { "es", "El comité se reunió el martes para hablar del nuevo presupuesto "
+          "de la biblioteca municipal, que está cerrada por reparaciones "
+          "desde que la tormenta dañó su tejado el invierno pasado. Los "
+          "miembros acordaron que las salas de lectura deberían abrir de "
+          "nuevo antes del comienzo del curso escolar. " },
+  { "es", "Precalienta el horno y engrasa un molde grande. Bate la "
+          "mantequilla con el azúcar hasta que blanquee y añade los huevos "
+          "de uno en uno. Incorpora la harina con cuidado y vierte la masa "
+          "en el molde antes de hornearla unos cuarenta minutos. " },
+  { "es", "Los visitantes marcaron dos goles en la primera parte, pero un "
+          "penalti en los últimos minutos y un cabezazo del capitán en el "
+          "tiempo de descuento dieron al equipo local un empate que lo "
+          "mantiene en el segundo puesto de la liga. " },
+  { "it", "Il comitato si è riunito martedì per discutere il nuovo bilancio "
+          "della biblioteca comunale, chiusa per lavori da quando la "
+          "tempesta ha danneggiato il tetto lo scorso inverno. I membri "
+          "hanno concordato che le sale di lettura dovrebbero riaprire prima "
+          "dell'inizio dell'anno scolastico. " },
+  { "it", "Preriscaldate il forno e imburrate una teglia grande. Sbattete il "
+          "burro con lo zucchero fino a renderlo chiaro, poi aggiungete le "
+          "uova una alla volta. Incorporate delicatamente la farina e "
+          "versate l'impasto nella teglia prima di cuocerlo per circa "
+          "quaranta minuti. " },
+  { "it", "Gli ospiti hanno segnato due volte nel primo tempo, ma un rigore "
+          "nel finale e un colpo di testa del capitano nei minuti di recupero "
+          "hanno regalato alla squadra di casa un pareggio che la tiene al "
+          "secondo posto in classifica. " },
+  { "nl", "De commissie kwam dinsdag bijeen om de nieuwe begroting van de "
+          "stadsbibliotheek te bespreken, die sinds de storm van afgelopen "
+          "winter het dak beschadigde gesloten is voor reparaties. De leden "
+          "waren het erover eens dat de leeszalen voor het begin van het "
+          "schooljaar weer open moeten gaan. " },
+  { "nl", "Verwarm de oven voor en vet een grote bakvorm in. Klop de boter "
+          "en de suiker luchtig en voeg de eieren een voor een toe. Spatel "
+          "de bloem er voorzichtig door en giet het beslag in de vorm voordat "
+          "je het ongeveer veertig minuten bakt. " },
+  { "nl", "De bezoekers scoorden twee keer in de eerste helft, maar een late "
+          "strafschop en een kopbal van de aanvoerder in de blessuretijd "
+          "leverden de thuisploeg een gelijkspel op waardoor ze op de tweede "
+          "plaats van de competitie blijft. " },
+  { "pt", "O comitê se reuniu na terça-feira para discutir o novo orçamento "
+          "da biblioteca municipal, fechada para reparos desde que a "
+          "tempestade danificou o telhado no inverno passado. Os membros "
+          "concordaram que as salas de leitura devem reabrir antes do início "
+          "do ano letivo. " },
+  { "pt", "Preaqueça o forno e unte uma forma grande. Bata a manteiga com o "
+          "açúcar até obter um creme claro e junte os ovos um de cada vez. "
+          "Misture a farinha com cuidado e despeje a massa na forma antes de "
+          "levá-la ao forno por cerca de quarenta minutos. " },
+  { "pt", "Os visitantes marcaram duas vezes no primeiro tempo, mas um "
+          "pênalti no fim e um gol de cabeça do capitão nos acréscimos deram "
+          "ao time da casa um empate que o mantém em segundo lugar no "
+          "campeonato. " },
+};
+
+// Appends |paragraphs| paragraphs of body text in |language| to |page|.
+void AppendTestParagraphs(const std::string& language,
+                          int paragraphs,
+                          std::string* page) {
+  std::vector<const char*> corpus;
+  for (size_t i = 0; i < arraysize(kCorpus); ++i) {
+    if (language == kCorpus[i].language)
+      corpus.push_back(kCorpus[i].paragraph);
+  }
+  CHECK(!corpus.empty()) << language;
+  for (int i = 0; i < paragraphs; ++i)
+    page->append(corpus[i % corpus.size()]);
+}
+
+}  // namespace
+
+std::vector<std::string> GetTestCorpusLanguages() {
+  std::vector<std::string> languages;
+  for (size_t i = 0; i < arraysize(kCorpus); ++i) {
+    if (std::find(languages.begin(), languages.end(), kCorpus[i].language) ==
+        languages.end()) {
+      languages.push_back(kCorpus[i].language);
+    }
+  }
+  return languages;
+}
+
+base::string16 MakeTestPage(const std::string& language, int paragraphs) {
+  std::string page(kBoilerplate);
+  AppendTestParagraphs(language, paragraphs, &page);
+  return base::UTF8ToUTF16(page);
+}
+
+base::string16 MakeMixedTestPage(const std::string& lead_language,
+                                 int lead_paragraphs,
+                                 const std::string& language,
+                                 int paragraphs) {
+  std::string page(kBoilerplate);
+  AppendTestParagraphs(lead_language, lead_paragraphs, &page);
+  AppendTestParagraphs(language, paragraphs, &page);
+  return base::UTF8ToUTF16(page);
+}
+
+}  // namespace translate
@@ -0,0 +1,34 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_RENDERER_TRANSLATE_SAMPLED_LANGUAGE_DETECTION_TEST_UTIL_H_
+#define CHROME_RENDERER_TRANSLATE_SAMPLED_LANGUAGE_DETECTION_TEST_UTIL_H_
+
+#include <string>
+#include <vector>
+
+#include "base/strings/string16.h"
+
+namespace translate {
+
+// Returns the languages the test corpus has body text in.
+std::vector<std::string> GetTestCorpusLanguages();
+
+// Returns a page of English navigation text, as many pages start with
+// whatever their language, followed by |paragraphs| paragraphs in |language|.
+// The paragraphs cycle through several different ones, so that pages are not
+// one paragraph repeated.
+base::string16 MakeTestPage(const std::string& language, int paragraphs);
+
+// Returns a page of English navigation text, followed by |lead_paragraphs|
+// paragraphs in |lead_language| and then |paragraphs| paragraphs in
+// |language|.
+base::string16 MakeMixedTestPage(const std::string& lead_language,
+                                 int lead_paragraphs,
+                                 const std::string& language,
+                                 int paragraphs);
+
+}  // namespace translate
+
+#endif  // CHROME_RENDERER_TRANSLATE_SAMPLED_LANGUAGE_DETECTION_TEST_UTIL_H_
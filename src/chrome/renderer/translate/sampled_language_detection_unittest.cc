@@ -0,0 +1,109 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/renderer/translate/sampled_language_detection.h"
+
+#include <string>
+#include <vector>
+
+#include "base/strings/utf_string_conversions.h"
+#include "chrome/renderer/translate/sampled_language_detection_test_util.h"
+#include "components/translate/core/language_detection/language_detection_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace translate {
+
+TEST(SampledLanguageDetectionTest, SampleText) {
+  const base::string16 text(base::ASCIIToUTF16("one two three"));
+  EXPECT_EQ(text, SampleText(text, text.length()));
+
+  base::string16 long_text;
+  for (int i = 0; i < 1000; ++i)
+    long_text += base::ASCIIToUTF16("word ");
+  long_text += base::ASCIIToUTF16("last");
+  const base::string16 sample = SampleText(long_text, 2048);
+  EXPECT_LE(sample.length(), 2048u + 4);
+  EXPECT_GT(sample.length(), 1500u);
+
+  // Chunks start and end at whole words.
+  EXPECT_EQ(base::ASCIIToUTF16("word"), sample.substr(0, 4));
+  EXPECT_NE(base::string16::npos, sample.find(base::ASCIIToUTF16("word word")));
+  EXPECT_EQ(base::string16::npos, sample.find(base::ASCIIToUTF16("wor ")));
+  EXPECT_EQ(base::string16::npos, sample.find(base::ASCIIToUTF16(" ord")));
+}
+
+TEST(SampledLanguageDetectionTest, SmallPagesAreDetectedWhole) {
+  const base::string16 page = MakeTestPage("fr", 1);
+  SampledLanguageDetails details =
+      DeterminePageLanguageFromSamples(std::string(), std::string(), page);
+  EXPECT_EQ(1, details.rounds);
+  EXPECT_EQ(page.length(), details.sampled_chars);
+}
+
+TEST(SampledLanguageDetectionTest, MetaTagsStillApply) {
+  const base::string16 page = MakeTestPage("de", 100);
+  SampledLanguageDetails details =
+      DeterminePageLanguageFromSamples("de", std::string(), page);
+  EXPECT_EQ("de", details.language);
+}
+
+// Detects the language of a corpus of large pages from samples and from their
+// whole text, and checks that they agree.
+TEST(SampledLanguageDetectionTest, CorpusAccuracy) {
+  const int kParagraphCounts[] = { 20, 80, 250 };
+  const std::vector<std::string> languages = GetTestCorpusLanguages();
+  for (size_t i = 0; i < languages.size(); ++i) {
+    for (size_t j = 0; j < arraysize(kParagraphCounts); ++j) {
+      const base::string16 page =
+          MakeTestPage(languages[i], kParagraphCounts[j]);
+
+      std::string cld_language;
+      bool is_cld_reliable = false;
+      const std::string whole_language = DeterminePageLanguage(
+          std::string(), std::string(), page, &cld_language,
+          &is_cld_reliable);
+
+      SampledLanguageDetails details =
+          DeterminePageLanguageFromSamples(std::string(), std::string(), page);
+      EXPECT_EQ(whole_language, details.language)
+          << languages[i] << " x" << kParagraphCounts[j];
+      EXPECT_LE(details.sampled_chars, page.length());
+    }
+  }
+}
+
+// Detects pages which start with a long run of text in another language, so
+// that the first chunks of the first sample are not in the language of most
+// of the page.
+TEST(SampledLanguageDetectionTest, MixedLanguagePages) {
+  const struct {
+    const char* lead_language;
+    int lead_paragraphs;
+    const char* language;
+    int paragraphs;
+  } kPages[] = {
+    { "en", 20, "fr", 60 },
+    { "de", 40, "es", 80 },
+    { "fr", 60, "it", 120 },
+    { "es", 10, "nl", 30 },
+    { "en", 80, "pt", 170 },
+  };
+  for (size_t i = 0; i < arraysize(kPages); ++i) {
+    const base::string16 page = MakeMixedTestPage(
+        kPages[i].lead_language, kPages[i].lead_paragraphs,
+        kPages[i].language, kPages[i].paragraphs);
+
+    std::string cld_language;
+    bool is_cld_reliable = false;
+    const std::string whole_language = DeterminePageLanguage(
+        std::string(), std::string(), page, &cld_language, &is_cld_reliable);
+    EXPECT_EQ(kPages[i].language, whole_language) << i;
+
+    SampledLanguageDetails details =
+        DeterminePageLanguageFromSamples(std::string(), std::string(), page);
+    EXPECT_EQ(whole_language, details.language) << i;
+  }
+}
+
+}  // namespace translate
@@ -15,9 +15,12 @@
 #endif
 #include "base/logging.h"
 #include "base/message_loop/message_loop.h"
+#include "base/metrics/histogram.h"
 #include "base/strings/string16.h"
 #include "base/strings/string_util.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/task_runner_util.h"
+#include "base/threading/worker_pool.h"
 #include "chrome/renderer/isolated_world_ids.h"
 #include "components/translate/content/common/translate_messages.h"
 #include "components/translate/core/common/translate_constants.h"
@@ -75,6 +78,11 @@ const char kAutoDetectionLanguage[] = "auto";
 // Isolated world sets following content-security-policy.
 const char kContentSecurityPolicy[] = "script-src 'self' 'unsafe-eval'";
 
+// Pages with at least this many characters of text have their language
+// detected on a worker thread, from samples of the text.  Smaller pages are
+// quicker to detect in place than to send to another thread.
+const size_t kMinCharsForWorkerDetection = 4096;
+
 }  // namespace
 
 #if defined(CLD2_DYNAMIC_MODE)
@@ -99,6 +107,7 @@ TranslateHelper::TranslateHelper(content::RenderView* render_view)
       deferred_page_id_(-1),
       deferred_contents_(ASCIIToUTF16(""))
 #endif
+      ,detection_weak_factory_(this)
   {
 }
 
@@ -175,6 +184,7 @@ void TranslateHelper::PageCaptured(int page_id,
   }
 #endif
   page_id_ = page_id;
+  const base::TimeTicks start_time = base::TimeTicks::Now();
   WebDocument document = main_frame->document();
   std::string content_language = document.contentLanguage().utf8();
   WebElement html_element = document.documentElement();
@@ -183,17 +193,72 @@ void TranslateHelper::PageCaptured(int page_id,
   // BrowserTest.WindowOpenClose.
   if (!html_element.isNull())
     html_lang = html_element.getAttribute("lang").utf8();
+
+  // Running CLD over a large page would block the render thread, so sample
+  // the page on a worker thread and send the language when it is done.
+  if (contents.length() >= kMinCharsForWorkerDetection) {
+    base::PostTaskAndReplyWithResult(
+        GetDetectionTaskRunner().get(),
+        FROM_HERE,
+        base::Bind(&translate::DeterminePageLanguageFromSamples,
+                   content_language, html_lang, contents),
+        base::Bind(&TranslateHelper::OnPageLanguageDetermined,
+                   detection_weak_factory_.GetWeakPtr(),
+                   page_id, content_language, html_lang, contents));
+    UMA_HISTOGRAM_TIMES("Translate.LanguageDetectionMainThreadTime",
+                        base::TimeTicks::Now() - start_time);
+    return;
+  }
+
   std::string cld_language;
   bool is_cld_reliable;
   std::string language = translate::DeterminePageLanguage(
       content_language, html_lang, contents, &cld_language, &is_cld_reliable);
+  UMA_HISTOGRAM_TIMES("Translate.LanguageDetectionMainThreadTime",
+                      base::TimeTicks::Now() - start_time);
+
+  SendLanguageDetermined(&document, content_language, html_lang, language,
+                         cld_language, is_cld_reliable, contents);
+}
 
+void TranslateHelper::OnPageLanguageDetermined(
+    int page_id,
+    const std::string& content_language,
+    const std::string& html_lang,
+    const base::string16& contents,
+    const translate::SampledLanguageDetails& result) {
+  UMA_HISTOGRAM_TIMES("Translate.LanguageDetectionWorkerTime",
+                      result.detection_time);
+  UMA_HISTOGRAM_PERCENTAGE(
+      "Translate.LanguageDetectionSampledPercent",
+      static_cast<int>(result.sampled_chars * 100 / contents.length()));
+
+  // Drop the result if the user navigated away in the meantime.
+  WebFrame* main_frame = GetMainFrame();
+  if (!main_frame || render_view()->GetPageId() != page_id ||
+      page_id_ != page_id) {
+    return;
+  }
+  WebDocument document = main_frame->document();
+  SendLanguageDetermined(&document, content_language, html_lang,
+                         result.language, result.cld_language,
+                         result.is_cld_reliable, contents);
+}
+
+void TranslateHelper::SendLanguageDetermined(
+    WebDocument* document,
+    const std::string& content_language,
+    const std::string& html_lang,
+    const std::string& language,
+    const std::string& cld_language,
+    bool is_cld_reliable,
+    const base::string16& contents) {
   if (language.empty())
     return;
 
   language_determined_time_ = base::TimeTicks::Now();
 
-  GURL url(document.url());
+  GURL url(document->url());
   LanguageDetectionDetails details;
   details.time = base::Time::Now();
   details.url = url;
@@ -210,7 +275,7 @@ void TranslateHelper::PageCaptured(int page_id,
   Send(new ChromeViewHostMsg_TranslateLanguageDetermined(
       routing_id(),
       details,
-      IsTranslationAllowed(&document) && !language.empty()));
+      IsTranslationAllowed(document) && !language.empty()));
 }
 
 void TranslateHelper::CancelPendingTranslation() {
@@ -263,6 +328,10 @@ base::TimeDelta TranslateHelper::AdjustDelay(int delayInMs) {
   return base::TimeDelta::FromMilliseconds(delayInMs);
 }
 
+scoped_refptr<base::TaskRunner> TranslateHelper::GetDetectionTaskRunner() {
+  return base::WorkerPool::GetTaskRunner(true);
+}
+
 void TranslateHelper::ExecuteScript(const std::string& script) {
   WebFrame* main_frame = GetMainFrame();
   if (!main_frame)
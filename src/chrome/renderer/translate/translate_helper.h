@@ -14,8 +14,10 @@
 #if defined(CLD2_DYNAMIC_MODE)
 #include "base/lazy_instance.h"
 #endif
+#include "base/memory/ref_counted.h"
 #include "base/memory/weak_ptr.h"
 #include "base/time/time.h"
+#include "chrome/renderer/translate/sampled_language_detection.h"
 #include "components/translate/core/common/translate_errors.h"
 #include "content/public/renderer/render_view_observer.h"
 #if defined(CLD2_DYNAMIC_MODE)
@@ -23,6 +25,10 @@
 #include "url/gurl.h"
 #endif
 
+namespace base {
+class TaskRunner;
+}
+
 namespace blink {
 class WebDocument;
 class WebFrame;
@@ -81,6 +87,10 @@ class TranslateHelper : public content::RenderViewObserver {
   // immediately by returning 0.
   virtual base::TimeDelta AdjustDelay(int delayInMs);
 
+  // Returns the task runner which detects the language of large pages.  Tests
+  // override this to choose when detection runs.
+  virtual scoped_refptr<base::TaskRunner> GetDetectionTaskRunner();
+
   // Executes the JavaScript code in |script| in the main frame of RenderView.
   virtual void ExecuteScript(const std::string& script);
 
@@ -147,6 +157,24 @@ class TranslateHelper : public content::RenderViewObserver {
   // if the page is being closed.
   blink::WebFrame* GetMainFrame();
 
+  // Called on the render thread when language detection of a large page on a
+  // worker thread is done.
+  void OnPageLanguageDetermined(
+      int page_id,
+      const std::string& content_language,
+      const std::string& html_lang,
+      const base::string16& contents,
+      const translate::SampledLanguageDetails& result);
+
+  // Tells the browser the language of the page in |document|.
+  void SendLanguageDetermined(blink::WebDocument* document,
+                              const std::string& content_language,
+                              const std::string& html_lang,
+                              const std::string& language,
+                              const std::string& cld_language,
+                              bool is_cld_reliable,
+                              const base::string16& contents);
+
   // ID to represent a page which TranslateHelper captured and determined a
   // content language.
   int page_id_;
@@ -230,6 +258,10 @@ class TranslateHelper : public content::RenderViewObserver {
 
 #endif
 
+  // Used for replies from language detection on a worker thread, which only
+  // depend on the page id still being current.
+  base::WeakPtrFactory<TranslateHelper> detection_weak_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(TranslateHelper);
 };
 
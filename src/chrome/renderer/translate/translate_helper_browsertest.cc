@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include "base/strings/utf_string_conversions.h"
+#include "base/test/test_simple_task_runner.h"
 #include "base/time/time.h"
 #include "chrome/renderer/translate/translate_helper.h"
 #include "chrome/test/base/chrome_render_view_test.h"
@@ -19,7 +21,8 @@ using testing::_;
 class TestTranslateHelper : public TranslateHelper {
  public:
   explicit TestTranslateHelper(content::RenderView* render_view)
-      : TranslateHelper(render_view) {
+      : TranslateHelper(render_view),
+        detection_task_runner_(new base::TestSimpleTaskRunner) {
   }
 
   virtual base::TimeDelta AdjustDelay(int delayInMs) OVERRIDE {
@@ -28,6 +31,14 @@ class TestTranslateHelper : public TranslateHelper {
     return base::TimeDelta();
   }
 
+  virtual scoped_refptr<base::TaskRunner> GetDetectionTaskRunner() OVERRIDE {
+    return detection_task_runner_;
+  }
+
+  base::TestSimpleTaskRunner* detection_task_runner() {
+    return detection_task_runner_.get();
+  }
+
   void TranslatePage(int page_id,
                      const std::string& source_lang,
                      const std::string& target_lang,
@@ -48,6 +59,8 @@ class TestTranslateHelper : public TranslateHelper {
   MOCK_METHOD1(ExecuteScriptAndGetDoubleResult, double(const std::string&));
 
  private:
+  scoped_refptr<base::TestSimpleTaskRunner> detection_task_runner_;
+
   DISALLOW_COPY_AND_ASSIGN(TestTranslateHelper);
 };
 
@@ -88,6 +101,18 @@ class TranslateHelperBrowserTest : public ChromeRenderViewTest {
     return true;
   }
 
+  // Returns the text of a French page long enough to be detected off the
+  // render thread.
+  base::string16 GetLargePageContents() {
+    std::string contents;
+    while (contents.length() < 8192) {
+      contents += "Le conseil municipal s'est réuni mardi pour discuter du "
+                  "nouveau budget de la bibliothèque, fermée pour travaux "
+                  "depuis que la tempête a endommagé son toit. ";
+    }
+    return base::UTF8ToUTF16(contents);
+  }
+
   TestTranslateHelper* translate_helper_;
 
  private:
@@ -337,6 +362,47 @@ TEST_F(TranslateHelperBrowserTest, MultipleDifferentTranslations) {
   EXPECT_EQ(TranslateErrors::NONE, error);
 }
 
+// Tests that the language of a large page is detected off the render thread,
+// and sent to the browser once detection is done.
+TEST_F(TranslateHelperBrowserTest, LargePageDetectedAsync) {
+  LoadHTML("<html><body>Une page.</body></html>");
+  render_thread_->sink().ClearMessages();
+
+  const base::string16 contents = GetLargePageContents();
+  translate_helper_->PageCaptured(view_->GetPageId(), contents);
+  EXPECT_TRUE(translate_helper_->detection_task_runner()->HasPendingTask());
+  EXPECT_FALSE(render_thread_->sink().GetFirstMessageMatching(
+      ChromeViewHostMsg_TranslateLanguageDetermined::ID));
+
+  translate_helper_->detection_task_runner()->RunPendingTasks();
+  base::MessageLoop::current()->RunUntilIdle();
+  const IPC::Message* message = render_thread_->sink().GetUniqueMessageMatching(
+      ChromeViewHostMsg_TranslateLanguageDetermined::ID);
+  ASSERT_NE(static_cast<IPC::Message*>(NULL), message);
+  ChromeViewHostMsg_TranslateLanguageDetermined::Param params;
+  ChromeViewHostMsg_TranslateLanguageDetermined::Read(message, &params);
+  EXPECT_EQ("fr", params.a.cld_language);
+  EXPECT_EQ("fr", params.a.adopted_language);
+  EXPECT_EQ(contents, params.a.contents);
+  EXPECT_TRUE(params.b);
+}
+
+// Tests that the language of a large page is not sent if the view navigated
+// to another page while it was being detected.
+TEST_F(TranslateHelperBrowserTest, StaleLargePageDetectionDropped) {
+  LoadHTML("<html><body>Une page.</body></html>");
+  translate_helper_->PageCaptured(view_->GetPageId(), GetLargePageContents());
+  EXPECT_TRUE(translate_helper_->detection_task_runner()->HasPendingTask());
+
+  LoadHTML("<html><body>Another page.</body></html>");
+  render_thread_->sink().ClearMessages();
+
+  translate_helper_->detection_task_runner()->RunPendingTasks();
+  base::MessageLoop::current()->RunUntilIdle();
+  EXPECT_FALSE(render_thread_->sink().GetFirstMessageMatching(
+      ChromeViewHostMsg_TranslateLanguageDetermined::ID));
+}
+
 // Tests that we send the right translate language message for a page and that
 // we respect the "no translate" meta-tag.
 TEST_F(ChromeRenderViewTest, TranslatablePage) {
@@ -8,6 +8,7 @@
 #include "base/threading/thread_restrictions.h"
 #include "build/build_config.h"
 #include "content/browser/browser_child_process_host_impl.h"
+#include "content/browser/gpu/shader_disk_cache.h"
 #include "content/browser/notification_service_impl.h"
 #include "net/url_request/url_fetcher.h"
 #include "net/url_request/url_request.h"
@@ -69,6 +70,10 @@ void BrowserProcessSubThread::IOThreadPreCleanUp() {
   // and delete the BrowserChildProcessHost instances to release whatever
   // IO thread only resources they are referencing.
   BrowserChildProcessHostImpl::TerminateAll();
+
+  // Write the shader cache shared by every profile while the CACHE thread
+  // can still do it.
+  ShaderCacheFactory::GetInstance()->Shutdown();
 #endif  // !defined(OS_IOS)
 }
 
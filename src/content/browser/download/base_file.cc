@@ -22,6 +22,13 @@
 
 namespace content {
 
+namespace {
+
+// How far ahead of the data written so far to reserve disk space.
+const int64 kPreallocationStepBytes = 16 * 1024 * 1024;
+
+}  // namespace
+
 // This will initialize the entire array to zero.
 const unsigned char BaseFile::kEmptySha256Hash[] = { 0 };
 
@@ -38,6 +45,8 @@ BaseFile::BaseFile(const base::FilePath& full_path,
       referrer_url_(referrer_url),
       file_(file.Pass()),
       bytes_so_far_(received_bytes),
+      preallocated_bytes_(0),
+      preallocation_failed_(false),
       start_tick_(base::TimeTicks::Now()),
       calculate_hash_(calculate_hash),
       detached_(false),
@@ -106,6 +115,11 @@ DownloadInterruptReason BaseFile::AppendDataToFile(const char* data,
   if (data_len == 0)
     return DOWNLOAD_INTERRUPT_REASON_NONE;
 
+  if (!preallocation_failed_ &&
+      bytes_so_far_ + static_cast<int64>(data_len) > preallocated_bytes_) {
+    Preallocate(bytes_so_far_ + data_len);
+  }
+
   // The Write call below is not guaranteed to write all the data.
   size_t write_count = 0;
   size_t len = data_len;
@@ -208,6 +222,10 @@ void BaseFile::SetClientGuid(const std::string& guid) {
 DownloadInterruptReason BaseFile::AnnotateWithSourceInformation() {
   return DOWNLOAD_INTERRUPT_REASON_NONE;
 }
+
+bool BaseFile::ReserveFileSpace(int64 length) {
+  return false;
+}
 #endif
 
 bool BaseFile::GetHash(std::string* hash) {
@@ -229,6 +247,11 @@ std::string BaseFile::GetHashState() {
                      hash_state.size());
 }
 
+scoped_ptr<crypto::SecureHash> BaseFile::ReleaseSecureHash() {
+  calculate_hash_ = false;
+  return secure_hash_.Pass();
+}
+
 // static
 bool BaseFile::IsEmptyHash(const std::string& hash) {
   return (hash.size() == crypto::kSHA256Length &&
@@ -255,6 +278,9 @@ DownloadInterruptReason BaseFile::Open() {
       net::NetLog::TYPE_DOWNLOAD_FILE_OPENED,
       base::Bind(&FileOpenedNetLogCallback, &full_path_, bytes_so_far_));
 
+  // Space reserved for a previous handle may have been released.
+  preallocated_bytes_ = 0;
+
   // Create a new file if it is not provided.
   if (!file_.IsValid()) {
     file_.Initialize(
@@ -298,6 +324,11 @@ void BaseFile::Close() {
   bound_net_log_.AddEvent(net::NetLog::TYPE_DOWNLOAD_FILE_CLOSED);
 
   if (file_.IsValid()) {
+    // Give back any space reserved past the data actually written.
+    if (preallocated_bytes_ > bytes_so_far_)
+      file_.SetLength(bytes_so_far_);
+    preallocated_bytes_ = 0;
+
     // Currently we don't really care about the return value, since if it fails
     // theres not much we can do.  But we might in the future.
     file_.Flush();
@@ -305,6 +336,15 @@ void BaseFile::Close() {
   }
 }
 
+void BaseFile::Preallocate(int64 needed_bytes) {
+  const int64 length = needed_bytes + kPreallocationStepBytes;
+  if (!ReserveFileSpace(length)) {
+    preallocation_failed_ = true;
+    return;
+  }
+  preallocated_bytes_ = length;
+}
+
 void BaseFile::ClearFile() {
   // This should only be called when we have a stream.
   DCHECK(file_.IsValid());
@@ -90,6 +90,11 @@ class CONTENT_EXPORT BaseFile {
   // Returns the current (intermediate) state of the hash as a byte string.
   virtual std::string GetHashState();
 
+  // Stops hashing data appended to the file, and returns the hash of the data
+  // so far for the caller to continue.  Returns NULL if the file was not being
+  // hashed.  GetHash() and GetHashState() report nothing afterwards.
+  scoped_ptr<crypto::SecureHash> ReleaseSecureHash();
+
   // Returns true if the given hash is considered empty.  An empty hash is
   // a string of size crypto::kSHA256Length that contains only zeros (initial
   // value for the hash).
@@ -110,6 +115,16 @@ class CONTENT_EXPORT BaseFile {
   // Resets file_.
   void ClearFile();
 
+  // Reserves disk space for at least |needed_bytes| plus the next
+  // kPreallocationStepBytes of the file, so that the file system can give a
+  // download a few large extents rather than growing it one write at a time.
+  // Gives up for good if the platform can't.
+  void Preallocate(int64 needed_bytes);
+
+  // Platform specific method that asks the file system to reserve |length|
+  // bytes for file_ without changing its size.  Returns false if it can't.
+  bool ReserveFileSpace(int64 length);
+
   // Platform specific method that moves a file to a new path and adjusts the
   // security descriptor / permissions on the file to match the defaults for the
   // new directory.
@@ -153,6 +168,11 @@ class CONTENT_EXPORT BaseFile {
   // Amount of data received up so far, in bytes.
   int64 bytes_so_far_;
 
+  // Length of file_ that has disk space reserved for it, and whether reserving
+  // space has failed.
+  int64 preallocated_bytes_;
+  bool preallocation_failed_;
+
   // Start time for calculating speed.
   base::TimeTicks start_tick_;
 
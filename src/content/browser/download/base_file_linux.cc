@@ -4,6 +4,10 @@
 
 #include "content/browser/download/base_file.h"
 
+#include <fcntl.h>
+#include <linux/falloc.h>
+
+#include "base/posix/eintr_wrapper.h"
 #include "content/browser/download/file_metadata_linux.h"
 #include "content/public/browser/browser_thread.h"
 
@@ -17,4 +21,13 @@ DownloadInterruptReason BaseFile::AnnotateWithSourceInformation() {
   return DOWNLOAD_INTERRUPT_REASON_NONE;
 }
 
+bool BaseFile::ReserveFileSpace(int64 length) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+
+  // FALLOC_FL_KEEP_SIZE leaves the file size alone, so that a partial download
+  // still ends where its data does.
+  return HANDLE_EINTR(fallocate(file_.GetPlatformFile(), FALLOC_FL_KEEP_SIZE,
+                                0, length)) == 0;
+}
+
 }  // namespace content
@@ -4,6 +4,10 @@
 
 #include "content/browser/download/base_file.h"
 
+#include <fcntl.h>
+
+#include <algorithm>
+
 #include "content/browser/download/file_metadata_mac.h"
 #include "content/public/browser/browser_thread.h"
 
@@ -18,4 +22,21 @@ DownloadInterruptReason BaseFile::AnnotateWithSourceInformation() {
   return DOWNLOAD_INTERRUPT_REASON_NONE;
 }
 
+bool BaseFile::ReserveFileSpace(int64 length) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+
+  // F_PREALLOCATE reserves space past the end of what is already allocated,
+  // without changing the size of the file.  Ask for contiguous space first,
+  // then for any space.
+  const int64 allocated = std::max(bytes_so_far_, preallocated_bytes_);
+  if (allocated >= length)
+    return true;
+  fstore_t store = { F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0,
+                     length - allocated, 0 };
+  if (fcntl(file_.GetPlatformFile(), F_PREALLOCATE, &store) == 0)
+    return true;
+  store.fst_flags = F_ALLOCATEALL;
+  return fcntl(file_.GetPlatformFile(), F_PREALLOCATE, &store) == 0;
+}
+
 }  // namespace content
@@ -454,6 +454,53 @@ TEST_F(BaseFileTest, RenameWhileInProgress) {
   base_file_->Finish();
 }
 
+// Space reserved ahead of the data doesn't change the size of the file while
+// it is written, renamed or after it is finished.
+TEST_F(BaseFileTest, PreallocationKeepsSize) {
+  ASSERT_TRUE(InitializeFile());
+  ASSERT_TRUE(AppendDataToFile(kTestData1));
+
+  int64 size = -1;
+  EXPECT_TRUE(base::GetFileSize(base_file_->full_path(), &size));
+  EXPECT_EQ(kTestDataLength1, size);
+
+  base::FilePath new_path(temp_dir_.path().AppendASCII("NewFile"));
+  EXPECT_EQ(DOWNLOAD_INTERRUPT_REASON_NONE, base_file_->Rename(new_path));
+  ASSERT_TRUE(AppendDataToFile(kTestData2));
+  EXPECT_TRUE(base::GetFileSize(new_path, &size));
+  EXPECT_EQ(kTestDataLength1 + kTestDataLength2, size);
+
+  base_file_->Finish();
+  EXPECT_TRUE(base::GetFileSize(new_path, &size));
+  EXPECT_EQ(kTestDataLength1 + kTestDataLength2, size);
+}
+
+// Once the hash is released, the file stops hashing and the caller can go on
+// from the data written so far.
+TEST_F(BaseFileTest, ReleaseSecureHash) {
+  ResetHash();
+  UpdateHash(kTestData1, kTestDataLength1);
+  UpdateHash(kTestData2, kTestDataLength2);
+  std::string expected_hash = GetFinalHash();
+
+  MakeFileWithHash();
+  ASSERT_TRUE(InitializeFile());
+  ASSERT_TRUE(AppendDataToFile(kTestData1));
+  scoped_ptr<crypto::SecureHash> secure_hash(base_file_->ReleaseSecureHash());
+  ASSERT_TRUE(secure_hash.get());
+  ASSERT_TRUE(AppendDataToFile(kTestData2));
+  secure_hash->Update(kTestData2, kTestDataLength2);
+  base_file_->Finish();
+
+  std::string hash;
+  EXPECT_FALSE(base_file_->GetHash(&hash));
+  EXPECT_TRUE(base_file_->GetHashState().empty());
+  hash.resize(crypto::kSHA256Length);
+  secure_hash->Finish(&hash[0], hash.size());
+  EXPECT_EQ(expected_hash, hash);
+  EXPECT_FALSE(base_file_->ReleaseSecureHash().get());
+}
+
 // Test that a failed rename reports the correct error.
 TEST_F(BaseFileTest, RenameWithError) {
   ASSERT_TRUE(InitializeFile());
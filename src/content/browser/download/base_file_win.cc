@@ -323,6 +323,27 @@ DownloadInterruptReason BaseFile::MoveFileAndAdjustPermissions(
   return interrupt_reason;
 }
 
+bool BaseFile::ReserveFileSpace(int64 length) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+
+  // SetFileInformationByHandle() is not available before Vista, where space
+  // is simply allocated as the file grows.
+  typedef BOOL (WINAPI* SetFileInformationByHandleFunction)(
+      HANDLE, FILE_INFO_BY_HANDLE_CLASS, LPVOID, DWORD);
+  static SetFileInformationByHandleFunction set_file_information =
+      reinterpret_cast<SetFileInformationByHandleFunction>(GetProcAddress(
+          GetModuleHandle(L"kernel32.dll"), "SetFileInformationByHandle"));
+  if (!set_file_information)
+    return false;
+
+  // The allocation size is separate from the end of the file, and whatever is
+  // unused is given back when the handle is closed.
+  FILE_ALLOCATION_INFO info;
+  info.AllocationSize.QuadPart = length;
+  return !!set_file_information(file_.GetPlatformFile(), FileAllocationInfo,
+                                &info, sizeof(info));
+}
+
 DownloadInterruptReason BaseFile::AnnotateWithSourceInformation() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
   DCHECK(!detached_);
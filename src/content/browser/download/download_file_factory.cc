@@ -4,7 +4,9 @@
 
 #include "content/browser/download/download_file_factory.h"
 
+#include "base/threading/sequenced_worker_pool.h"
 #include "content/browser/download/download_file_impl.h"
+#include "content/public/browser/browser_thread.h"
 
 namespace content {
 
@@ -19,9 +21,18 @@ DownloadFile* DownloadFileFactory::CreateFile(
     scoped_ptr<ByteStreamReader> stream,
     const net::BoundNetLog& bound_net_log,
     base::WeakPtr<DownloadDestinationObserver> observer) {
-  return new DownloadFileImpl(
+  DownloadFileImpl* download_file = new DownloadFileImpl(
       save_info.Pass(), default_downloads_directory, url, referrer_url,
       calculate_hash, stream.Pass(), bound_net_log, observer);
+
+  // Each download hashes on its own sequence, so that concurrent downloads
+  // hash in parallel and off the FILE thread.
+  base::SequencedWorkerPool* pool = BrowserThread::GetBlockingPool();
+  download_file->SetHashTaskRunner(
+      pool->GetSequencedTaskRunnerWithShutdownBehavior(
+          pool->GetSequenceToken(),
+          base::SequencedWorkerPool::SKIP_ON_SHUTDOWN));
+  return download_file;
 }
 
 }  // namespace content
@@ -7,9 +7,13 @@
 #include <string>
 
 #include "base/bind.h"
+#include "base/bind_helpers.h"
 #include "base/file_util.h"
 #include "base/message_loop/message_loop_proxy.h"
+#include "base/pickle.h"
+#include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
+#include "base/task_runner_util.h"
 #include "base/time/time.h"
 #include "content/browser/byte_stream.h"
 #include "content/browser/download/download_create_info.h"
@@ -18,6 +22,7 @@
 #include "content/browser/download/download_stats.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/download_destination_observer.h"
+#include "crypto/secure_hash.h"
 #include "net/base/io_buffer.h"
 
 namespace content {
@@ -25,8 +30,78 @@ namespace content {
 const int kUpdatePeriodMs = 500;
 const int kMaxTimeBlockingFileThreadMs = 1000;
 
+// How much written data may wait for the hash stage before reading from the
+// stream stops, so that a slow hash stage holds back the network rather than
+// buffering the download in memory.
+const size_t kMaxHashBytesInFlight = 4 * 1024 * 1024;
+
 int DownloadFile::number_active_objects_ = 0;
 
+namespace {
+
+void PostToUIThread(const base::Closure& task) {
+  BrowserThread::PostTask(BrowserThread::UI, FROM_HERE, task);
+}
+
+void SendUpdateWithHashState(
+    base::WeakPtr<DownloadDestinationObserver> observer,
+    int64 bytes_so_far,
+    int64 bytes_per_sec,
+    const std::string& hash_state) {
+  BrowserThread::PostTask(
+      BrowserThread::UI, FROM_HERE,
+      base::Bind(&DownloadDestinationObserver::DestinationUpdate,
+                 observer, bytes_so_far, bytes_per_sec, hash_state));
+}
+
+void SendCompleted(base::WeakPtr<DownloadDestinationObserver> observer,
+                   const std::string& hash) {
+  BrowserThread::PostTask(
+      BrowserThread::UI, FROM_HERE,
+      base::Bind(&DownloadDestinationObserver::DestinationCompleted,
+                 observer, hash));
+}
+
+}  // namespace
+
+class DownloadFileImpl::HashStage {
+ public:
+  explicit HashStage(scoped_ptr<crypto::SecureHash> secure_hash)
+      : secure_hash_(secure_hash.Pass()) {
+  }
+
+  void Update(scoped_refptr<net::IOBuffer> data, size_t data_len) {
+    DCHECK(secure_hash_);
+    secure_hash_->Update(data->data(), data_len);
+  }
+
+  // Returns the state of the hash of the data so far, as
+  // BaseFile::GetHashState() does.
+  std::string GetHashState() {
+    Pickle hash_state;
+    if (!secure_hash_ || !secure_hash_->Serialize(&hash_state))
+      return std::string();
+    return std::string(reinterpret_cast<const char*>(hash_state.data()),
+                       hash_state.size());
+  }
+
+  // Returns the hash of all the data, or an empty string if there was none.
+  std::string Finish() {
+    DCHECK(secure_hash_);
+    std::string hash(crypto::kSHA256Length, '\0');
+    secure_hash_->Finish(string_as_array(&hash), hash.size());
+    secure_hash_.reset();
+    if (BaseFile::IsEmptyHash(hash))
+      hash.clear();
+    return hash;
+  }
+
+ private:
+  scoped_ptr<crypto::SecureHash> secure_hash_;
+
+  DISALLOW_COPY_AND_ASSIGN(HashStage);
+};
+
 DownloadFileImpl::DownloadFileImpl(
     scoped_ptr<DownloadSaveInfo> save_info,
     const base::FilePath& default_download_directory,
@@ -46,6 +121,8 @@ DownloadFileImpl::DownloadFileImpl(
                 bound_net_log),
           default_download_directory_(default_download_directory),
           stream_reader_(stream.Pass()),
+          hash_bytes_in_flight_(0),
+          waiting_for_hash_stage_(false),
           bytes_seen_(0),
           bound_net_log_(bound_net_log),
           observer_(observer),
@@ -54,9 +131,21 @@ DownloadFileImpl::DownloadFileImpl(
 
 DownloadFileImpl::~DownloadFileImpl() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+  if (hash_stage_)
+    hash_task_runner_->DeleteSoon(FROM_HERE, hash_stage_.release());
   --number_active_objects_;
 }
 
+void DownloadFileImpl::SetHashTaskRunner(
+    const scoped_refptr<base::SequencedTaskRunner>& hash_task_runner) {
+  DCHECK(!update_timer_);
+  scoped_ptr<crypto::SecureHash> secure_hash(file_.ReleaseSecureHash());
+  if (!secure_hash)
+    return;
+  hash_task_runner_ = hash_task_runner;
+  hash_stage_.reset(new HashStage(secure_hash.Pass()));
+}
+
 void DownloadFileImpl::Initialize(const InitializeCallback& callback) {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
 
@@ -64,8 +153,7 @@ void DownloadFileImpl::Initialize(const InitializeCallback& callback) {
   DownloadInterruptReason result =
       file_.Initialize(default_download_directory_);
   if (result != DOWNLOAD_INTERRUPT_REASON_NONE) {
-    BrowserThread::PostTask(
-        BrowserThread::UI, FROM_HERE, base::Bind(callback, result));
+    PostInOrder(base::Bind(callback, result));
     return;
   }
 
@@ -80,9 +168,7 @@ void DownloadFileImpl::Initialize(const InitializeCallback& callback) {
   // Initial pull from the straw.
   StreamActive();
 
-  BrowserThread::PostTask(
-      BrowserThread::UI, FROM_HERE, base::Bind(
-          callback, DOWNLOAD_INTERRUPT_REASON_NONE));
+  PostInOrder(base::Bind(callback, DOWNLOAD_INTERRUPT_REASON_NONE));
 
   ++number_active_objects_;
 }
@@ -126,9 +212,7 @@ void DownloadFileImpl::RenameAndUniquify(
     new_path.clear();
   }
 
-  BrowserThread::PostTask(
-      BrowserThread::UI, FROM_HERE,
-      base::Bind(callback, reason, new_path));
+  PostInOrder(base::Bind(callback, reason, new_path));
 }
 
 void DownloadFileImpl::RenameAndAnnotate(
@@ -164,9 +248,7 @@ void DownloadFileImpl::RenameAndAnnotate(
     new_path.clear();
   }
 
-  BrowserThread::PostTask(
-      BrowserThread::UI, FROM_HERE,
-      base::Bind(callback, reason, new_path));
+  PostInOrder(base::Bind(callback, reason, new_path));
 }
 
 void DownloadFileImpl::Detach() {
@@ -202,6 +284,10 @@ void DownloadFileImpl::SetClientGuid(const std::string& guid) {
 }
 
 void DownloadFileImpl::StreamActive() {
+  // OnDataHashed() resumes reading once the hash stage has caught up.
+  if (waiting_for_hash_stage_)
+    return;
+
   base::TimeTicks start(base::TimeTicks::Now());
   base::TimeTicks now;
   scoped_refptr<net::IOBuffer> incoming_data;
@@ -227,6 +313,16 @@ void DownloadFileImpl::StreamActive() {
           reason = AppendDataToFile(
               incoming_data.get()->data(), incoming_data_size);
           disk_writes_time_ += (base::TimeTicks::Now() - write_start);
+          if (hash_stage_ && reason == DOWNLOAD_INTERRUPT_REASON_NONE) {
+            hash_bytes_in_flight_ += incoming_data_size;
+            hash_task_runner_->PostTaskAndReply(
+                FROM_HERE,
+                base::Bind(&HashStage::Update,
+                           base::Unretained(hash_stage_.get()),
+                           incoming_data, incoming_data_size),
+                base::Bind(&DownloadFileImpl::OnDataHashed,
+                           weak_factory_.GetWeakPtr(), incoming_data_size));
+          }
           bytes_seen_ += incoming_data_size;
           total_incoming_data_size += incoming_data_size;
         }
@@ -252,11 +348,17 @@ void DownloadFileImpl::StreamActive() {
     now = base::TimeTicks::Now();
   } while (state == ByteStreamReader::STREAM_HAS_DATA &&
            reason == DOWNLOAD_INTERRUPT_REASON_NONE &&
-           now - start <= delta);
+           now - start <= delta &&
+           hash_bytes_in_flight_ < kMaxHashBytesInFlight);
 
-  // If we're stopping to yield the thread, post a task so we come back.
   if (state == ByteStreamReader::STREAM_HAS_DATA &&
-      now - start > delta) {
+      reason == DOWNLOAD_INTERRUPT_REASON_NONE &&
+      hash_bytes_in_flight_ >= kMaxHashBytesInFlight) {
+    // Stop reading until OnDataHashed() finds the hash stage has caught up.
+    waiting_for_hash_stage_ = true;
+  } else if (state == ByteStreamReader::STREAM_HAS_DATA &&
+             now - start > delta) {
+    // If we're stopping to yield the thread, post a task so we come back.
     BrowserThread::PostTask(
         BrowserThread::FILE, FROM_HERE,
         base::Bind(&DownloadFileImpl::StreamActive,
@@ -276,10 +378,17 @@ void DownloadFileImpl::StreamActive() {
     stream_reader_->RegisterCallback(base::Closure());
     weak_factory_.InvalidateWeakPtrs();
     SendUpdate();                       // Make info up to date before error.
-    BrowserThread::PostTask(
-        BrowserThread::UI, FROM_HERE,
-        base::Bind(&DownloadDestinationObserver::DestinationError,
-                   observer_, reason));
+    PostInOrder(base::Bind(&DownloadDestinationObserver::DestinationError,
+                           observer_, reason));
+  } else if (state == ByteStreamReader::STREAM_COMPLETE && hash_stage_) {
+    // Signal successful completion once the hash stage has caught up.
+    stream_reader_->RegisterCallback(base::Closure());
+    weak_factory_.InvalidateWeakPtrs();
+    SendUpdate();
+    base::PostTaskAndReplyWithResult(
+        hash_task_runner_.get(), FROM_HERE,
+        base::Bind(&HashStage::Finish, base::Unretained(hash_stage_.get())),
+        base::Bind(&SendCompleted, observer_));
   } else if (state == ByteStreamReader::STREAM_COMPLETE) {
     // Signal successful completion and shut down processing.
     stream_reader_->RegisterCallback(base::Closure());
@@ -303,6 +412,17 @@ void DownloadFileImpl::StreamActive() {
 }
 
 void DownloadFileImpl::SendUpdate() {
+  if (hash_stage_) {
+    // The hash stage has been given exactly the bytes written so far, so the
+    // state it returns matches them, as resumption needs.
+    base::PostTaskAndReplyWithResult(
+        hash_task_runner_.get(), FROM_HERE,
+        base::Bind(&HashStage::GetHashState,
+                   base::Unretained(hash_stage_.get())),
+        base::Bind(&SendUpdateWithHashState, observer_, file_.bytes_so_far(),
+                   CurrentSpeed()));
+    return;
+  }
   BrowserThread::PostTask(
       BrowserThread::UI, FROM_HERE,
       base::Bind(&DownloadDestinationObserver::DestinationUpdate,
@@ -310,6 +430,27 @@ void DownloadFileImpl::SendUpdate() {
                  GetHashState()));
 }
 
+void DownloadFileImpl::OnDataHashed(size_t data_len) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+  DCHECK_GE(hash_bytes_in_flight_, data_len);
+  hash_bytes_in_flight_ -= data_len;
+  if (waiting_for_hash_stage_ &&
+      hash_bytes_in_flight_ <= kMaxHashBytesInFlight / 2) {
+    waiting_for_hash_stage_ = false;
+    StreamActive();
+  }
+}
+
+void DownloadFileImpl::PostInOrder(const base::Closure& task) {
+  if (!hash_stage_) {
+    PostToUIThread(task);
+    return;
+  }
+  hash_task_runner_->PostTaskAndReply(
+      FROM_HERE, base::Bind(&base::DoNothing),
+      base::Bind(&PostToUIThread, task));
+}
+
 // static
 int DownloadFile::GetNumberOfDownloadFiles() {
   return number_active_objects_;
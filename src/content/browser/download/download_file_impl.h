@@ -10,6 +10,7 @@
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/weak_ptr.h"
+#include "base/sequenced_task_runner.h"
 #include "base/time/time.h"
 #include "base/timer/timer.h"
 #include "content/browser/byte_stream.h"
@@ -46,6 +47,15 @@ class CONTENT_EXPORT DownloadFileImpl : virtual public DownloadFile {
 
   virtual ~DownloadFileImpl();
 
+  // Hashes the downloaded data on |hash_task_runner| rather than on the FILE
+  // thread as it is written, so that writing one download doesn't wait on
+  // hashing it.  May be called on any thread, but before Initialize().  Does
+  // nothing if the file isn't being hashed.  GetHash() and GetHashState()
+  // report nothing afterwards; the observer still gets the hash state with
+  // every update, for the same bytes, and the hash on completion.
+  void SetHashTaskRunner(
+      const scoped_refptr<base::SequencedTaskRunner>& hash_task_runner);
+
   // DownloadFile functions.
   virtual void Initialize(const InitializeCallback& callback) OVERRIDE;
   virtual void RenameAndUniquify(
@@ -69,9 +79,21 @@ class CONTENT_EXPORT DownloadFileImpl : virtual public DownloadFile {
       const char* data, size_t data_len);
 
  private:
+  // Hashes the data of one download, on the hash task runner.
+  class HashStage;
+
   // Send an update on our progress.
   void SendUpdate();
 
+  // Posts |task| to the UI thread after any update already sent, which may be
+  // waiting on the hash stage.
+  void PostInOrder(const base::Closure& task);
+
+  // Called on the FILE thread once the hash stage has hashed |data_len| more
+  // bytes.  Resumes reading the stream if it stopped to let the hash stage
+  // catch up.
+  void OnDataHashed(size_t data_len);
+
   // Called when there's some activity on stream_reader_ that needs to be
   // handled.
   void StreamActive();
@@ -82,6 +104,15 @@ class CONTENT_EXPORT DownloadFileImpl : virtual public DownloadFile {
   // The default directory for creating the download file.
   base::FilePath default_download_directory_;
 
+  // Set when hashing runs on |hash_task_runner_|, and deleted there.
+  scoped_refptr<base::SequencedTaskRunner> hash_task_runner_;
+  scoped_ptr<HashStage> hash_stage_;
+
+  // Bytes written but not yet hashed, and whether reading from the stream
+  // stopped until the hash stage catches up.
+  size_t hash_bytes_in_flight_;
+  bool waiting_for_hash_stage_;
+
   // The stream through which data comes.
   // TODO(rdsmith): Move this into BaseFile; requires using the same
   // stream semantics in SavePackage.  Alternatively, replace SaveFile
@@ -0,0 +1,162 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file_path.h"
+#include "base/memory/weak_ptr.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/stl_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "base/time/time.h"
+#include "content/browser/browser_thread_impl.h"
+#include "content/browser/byte_stream.h"
+#include "content/browser/download/download_create_info.h"
+#include "content/browser/download/download_file_impl.h"
+#include "content/public/browser/download_destination_observer.h"
+#include "content/public/browser/download_interrupt_reasons.h"
+#include "net/base/io_buffer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "url/gurl.h"
+
+namespace content {
+
+namespace {
+
+// Concurrent downloads, and the size of each.
+const size_t kDownloads = 4;
+const int64 kBytesPerDownload = 64 * 1024 * 1024;
+
+// The size of the buffers the stream hands out, as a network read would.
+const size_t kBufferSize = 64 * 1024;
+
+void IgnoreInitializeResult(DownloadInterruptReason reason) {}
+
+// Produces |total_bytes| of the same data, as fast as it is read.
+class GeneratedByteStreamReader : public ByteStreamReader {
+ public:
+  GeneratedByteStreamReader(scoped_refptr<net::IOBuffer> data,
+                            size_t data_len,
+                            int64 total_bytes)
+      : data_(data),
+        data_len_(data_len),
+        remaining_bytes_(total_bytes) {
+  }
+  virtual ~GeneratedByteStreamReader() {}
+
+  virtual StreamState Read(scoped_refptr<net::IOBuffer>* data,
+                           size_t* length) OVERRIDE {
+    if (remaining_bytes_ <= 0)
+      return STREAM_COMPLETE;
+    *data = data_;
+    *length = std::min<int64>(data_len_, remaining_bytes_);
+    remaining_bytes_ -= *length;
+    return STREAM_HAS_DATA;
+  }
+  virtual int GetStatus() const OVERRIDE {
+    return DOWNLOAD_INTERRUPT_REASON_NONE;
+  }
+  virtual void RegisterCallback(const base::Closure& sink_callback) OVERRIDE {}
+
+ private:
+  scoped_refptr<net::IOBuffer> data_;
+  size_t data_len_;
+  int64 remaining_bytes_;
+};
+
+// Collects the hashes of |expected| downloads, then runs |done|.
+class CompletionObserver : public DownloadDestinationObserver {
+ public:
+  CompletionObserver(size_t expected, const base::Closure& done)
+      : expected_(expected),
+        done_(done) {
+  }
+
+  virtual void DestinationUpdate(int64 bytes_so_far,
+                                 int64 bytes_per_sec,
+                                 const std::string& hash_state) OVERRIDE {}
+  virtual void DestinationError(DownloadInterruptReason reason) OVERRIDE {
+    ADD_FAILURE() << DownloadInterruptReasonToString(reason);
+    DestinationCompleted(std::string());
+  }
+  virtual void DestinationCompleted(const std::string& hash) OVERRIDE {
+    hashes_.push_back(hash);
+    if (hashes_.size() == expected_)
+      done_.Run();
+  }
+
+  const std::vector<std::string>& hashes() const { return hashes_; }
+
+ private:
+  size_t expected_;
+  base::Closure done_;
+  std::vector<std::string> hashes_;
+};
+
+}  // namespace
+
+// Writes several large downloads at once, hashing on the FILE thread and then
+// in a separate stage per download, and reports the aggregate throughput.
+TEST(DownloadFilePerfTest, ConcurrentDownloads) {
+  base::MessageLoopForUI message_loop;
+  BrowserThreadImpl ui_thread(BrowserThread::UI, &message_loop);
+  BrowserThreadImpl file_thread(BrowserThread::FILE, &message_loop);
+
+  scoped_refptr<net::IOBuffer> data(new net::IOBuffer(kBufferSize));
+  for (size_t i = 0; i < kBufferSize; ++i)
+    data->data()[i] = static_cast<char>(i * 7 + i / 256);
+
+  scoped_refptr<base::SequencedWorkerPool> pool(
+      new base::SequencedWorkerPool(kDownloads, "DownloadHash"));
+  std::string expected_hash;
+  for (int separate_stage = 0; separate_stage < 2; ++separate_stage) {
+    base::RunLoop run_loop;
+    CompletionObserver observer(kDownloads, run_loop.QuitClosure());
+    base::WeakPtrFactory<DownloadDestinationObserver> observer_factory(
+        &observer);
+    std::vector<DownloadFileImpl*> files;
+    for (size_t i = 0; i < kDownloads; ++i) {
+      files.push_back(new DownloadFileImpl(
+          make_scoped_ptr(new DownloadSaveInfo()), base::FilePath(), GURL(),
+          GURL(), true,
+          scoped_ptr<ByteStreamReader>(new GeneratedByteStreamReader(
+              data, kBufferSize, kBytesPerDownload)),
+          net::BoundNetLog(), observer_factory.GetWeakPtr()));
+      if (separate_stage) {
+        files.back()->SetHashTaskRunner(
+            pool->GetSequencedTaskRunner(pool->GetSequenceToken()));
+      }
+    }
+
+    const base::TimeTicks start = base::TimeTicks::Now();
+    for (size_t i = 0; i < kDownloads; ++i)
+      files[i]->Initialize(base::Bind(&IgnoreInitializeResult));
+    run_loop.Run();
+    const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    ASSERT_EQ(kDownloads, observer.hashes().size());
+    if (expected_hash.empty())
+      expected_hash = observer.hashes()[0];
+    for (size_t i = 0; i < kDownloads; ++i)
+      EXPECT_EQ(expected_hash, observer.hashes()[i]);
+    STLDeleteElements(&files);
+    message_loop.RunUntilIdle();
+
+    perf_test::PrintResult(
+        "download_throughput",
+        separate_stage ? "_hash_stage" : "_file_thread",
+        base::StringPrintf("%d_downloads", static_cast<int>(kDownloads)),
+        (kDownloads * kBytesPerDownload / 1024 / 1024) / elapsed.InSecondsF(),
+        "MB/s", true);
+  }
+  pool->Shutdown();
+}
+
+}  // namespace content
@@ -2,8 +2,13 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "base/file_util.h"
 #include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/test/test_file_util.h"
 #include "content/browser/browser_thread_impl.h"
@@ -26,6 +31,7 @@ using ::testing::AnyNumber;
 using ::testing::DoAll;
 using ::testing::InSequence;
 using ::testing::Return;
+using ::testing::SaveArg;
 using ::testing::SetArgPointee;
 using ::testing::StrictMock;
 
@@ -59,6 +65,73 @@ class MockDownloadDestinationObserver : public DownloadDestinationObserver {
 
 MATCHER(IsNullCallback, "") { return (arg.is_null()); }
 
+void IgnoreInitializeResult(DownloadInterruptReason reason) {}
+
+// Produces |total_bytes| of the same data, as fast as it is read.
+class GeneratedByteStreamReader : public ByteStreamReader {
+ public:
+  GeneratedByteStreamReader(scoped_refptr<net::IOBuffer> data,
+                            size_t data_len,
+                            int64 total_bytes)
+      : data_(data),
+        data_len_(data_len),
+        total_bytes_(total_bytes),
+        remaining_bytes_(total_bytes) {
+  }
+  virtual ~GeneratedByteStreamReader() {}
+
+  int64 bytes_read() const { return total_bytes_ - remaining_bytes_; }
+
+  virtual StreamState Read(scoped_refptr<net::IOBuffer>* data,
+                           size_t* length) OVERRIDE {
+    if (remaining_bytes_ <= 0)
+      return STREAM_COMPLETE;
+    *data = data_;
+    *length = std::min<int64>(data_len_, remaining_bytes_);
+    remaining_bytes_ -= *length;
+    return STREAM_HAS_DATA;
+  }
+  virtual int GetStatus() const OVERRIDE {
+    return DOWNLOAD_INTERRUPT_REASON_NONE;
+  }
+  virtual void RegisterCallback(const base::Closure& sink_callback) OVERRIDE {}
+
+ private:
+  scoped_refptr<net::IOBuffer> data_;
+  size_t data_len_;
+  int64 total_bytes_;
+  int64 remaining_bytes_;
+};
+
+// Collects the hashes of |expected| downloads, then runs |done|.
+class CompletionObserver : public DownloadDestinationObserver {
+ public:
+  CompletionObserver(size_t expected, const base::Closure& done)
+      : expected_(expected),
+        done_(done) {
+  }
+
+  virtual void DestinationUpdate(int64 bytes_so_far,
+                                 int64 bytes_per_sec,
+                                 const std::string& hash_state) OVERRIDE {}
+  virtual void DestinationError(DownloadInterruptReason reason) OVERRIDE {
+    ADD_FAILURE() << DownloadInterruptReasonToString(reason);
+    DestinationCompleted(std::string());
+  }
+  virtual void DestinationCompleted(const std::string& hash) OVERRIDE {
+    hashes_.push_back(hash);
+    if (hashes_.size() == expected_)
+      done_.Run();
+  }
+
+  const std::vector<std::string>& hashes() const { return hashes_; }
+
+ private:
+  size_t expected_;
+  base::Closure done_;
+  std::vector<std::string> hashes_;
+};
+
 }  // namespace
 
 class DownloadFileTest : public testing::Test {
@@ -128,7 +201,7 @@ class DownloadFileTest : public testing::Test {
         .RetiresOnSaturation();
 
     scoped_ptr<DownloadSaveInfo> save_info(new DownloadSaveInfo());
-    download_file_.reset(
+    DownloadFileImpl* download_file =
         new DownloadFileImpl(save_info.Pass(),
                              base::FilePath(),
                              GURL(),  // Source
@@ -136,7 +209,10 @@ class DownloadFileTest : public testing::Test {
                              calculate_hash,
                              scoped_ptr<ByteStreamReader>(input_stream_),
                              net::BoundNetLog(),
-                             observer_factory_.GetWeakPtr()));
+                             observer_factory_.GetWeakPtr());
+    if (hash_task_runner_)
+      download_file->SetHashTaskRunner(hash_task_runner_);
+    download_file_.reset(download_file);
     download_file_->SetClientGuid(
         "12345678-ABCD-1234-DCBA-123456789ABC");
 
@@ -292,6 +368,9 @@ class DownloadFileTest : public testing::Test {
   // Sink callback data for stream.
   base::Closure sink_callback_;
 
+  // If set, where the download file hashes its data.
+  scoped_refptr<base::SequencedTaskRunner> hash_task_runner_;
+
   // Latest update sent to the observer.
   int64 bytes_;
   int64 bytes_per_sec_;
@@ -600,4 +679,76 @@ TEST_F(DownloadFileTest, ConfirmUpdate) {
   DestroyDownloadFile(0);
 }
 
+// Hash in a separate stage, and check that the observer gets the same hash
+// and an update for all the data.
+TEST_F(DownloadFileTest, HashInSeparateStage) {
+  hash_task_runner_ = loop_.message_loop_proxy();
+  ASSERT_TRUE(CreateDownloadFile(0, true));
+
+  const char* chunks1[] = { kTestData1, kTestData2, kTestData3 };
+  AppendDataToFile(chunks1, 3);
+
+  ::testing::Sequence s1;
+  SetupFinishStream(DOWNLOAD_INTERRUPT_REASON_NONE, s1);
+  std::string hash;
+  EXPECT_CALL(*(observer_.get()), DestinationCompleted(_))
+      .WillOnce(SaveArg<0>(&hash));
+  sink_callback_.Run();
+  loop_.RunUntilIdle();
+
+  EXPECT_EQ(kDataHash, base::HexEncode(hash.data(), hash.size()));
+  EXPECT_EQ(static_cast<int64>(strlen(kTestData1) + strlen(kTestData2) +
+                               strlen(kTestData3)),
+            bytes_);
+  EXPECT_FALSE(hash_state_.empty());
+
+  // The file no longer hashes anything itself.
+  EXPECT_FALSE(download_file_->GetHash(&hash));
+  DestroyDownloadFile(0);
+  loop_.RunUntilIdle();
+}
+
+// Stream more data than the hash stage may fall behind by, and check that
+// reading stops until the hash stage catches up, and that the hash comes out
+// the same as hashing on the FILE thread.
+TEST_F(DownloadFileTest, HashStageHoldsBackStream) {
+  const int64 kBytes = 16 * 1024 * 1024;
+  const size_t kBufferSize = 64 * 1024;
+  scoped_refptr<net::IOBuffer> data(new net::IOBuffer(kBufferSize));
+  for (size_t i = 0; i < kBufferSize; ++i)
+    data->data()[i] = static_cast<char>(i * 7 + i / 256);
+
+  std::vector<std::string> hashes;
+  for (int separate_stage = 0; separate_stage < 2; ++separate_stage) {
+    base::RunLoop run_loop;
+    CompletionObserver observer(1, run_loop.QuitClosure());
+    base::WeakPtrFactory<DownloadDestinationObserver> observer_factory(
+        &observer);
+    GeneratedByteStreamReader* reader =
+        new GeneratedByteStreamReader(data, kBufferSize, kBytes);
+    scoped_ptr<DownloadFileImpl> file(new DownloadFileImpl(
+        make_scoped_ptr(new DownloadSaveInfo()), base::FilePath(), GURL(),
+        GURL(), true, scoped_ptr<ByteStreamReader>(reader),
+        net::BoundNetLog(), observer_factory.GetWeakPtr()));
+    if (separate_stage) {
+      // The hash stage runs on this thread, so none of its work is done until
+      // the first read returns.
+      file->SetHashTaskRunner(loop_.message_loop_proxy());
+    }
+
+    file->Initialize(base::Bind(&IgnoreInitializeResult));
+    if (separate_stage)
+      EXPECT_LT(reader->bytes_read(), kBytes);
+    run_loop.Run();
+
+    EXPECT_EQ(kBytes, reader->bytes_read());
+    ASSERT_EQ(1u, observer.hashes().size());
+    hashes.push_back(observer.hashes()[0]);
+    file.reset();
+    loop_.RunUntilIdle();
+  }
+  EXPECT_FALSE(hashes[0].empty());
+  EXPECT_EQ(hashes[0], hashes[1]);
+}
+
 }  // namespace content
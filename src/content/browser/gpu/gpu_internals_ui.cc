@@ -9,6 +9,7 @@
 #include "base/bind.h"
 #include "base/bind_helpers.h"
 #include "base/command_line.h"
+#include "base/format_macros.h"
 #include "base/i18n/time_formatting.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/stringprintf.h"
@@ -24,6 +25,7 @@
 #include "content/public/browser/web_ui_message_handler.h"
 #include "content/public/common/content_client.h"
 #include "content/public/common/content_switches.h"
+#include "content/public/common/gpu_memory_stats.h"
 #include "content/public/common/url_constants.h"
 #include "gpu/config/gpu_feature_type.h"
 #include "gpu/config/gpu_info.h"
@@ -191,6 +193,32 @@ base::DictionaryValue* GpuInfoAsDictionaryValue() {
   return info;
 }
 
+// Lists, for each process with GPU memory, what it uses and what the GPU
+// memory manager budgeted for its visible surfaces.
+base::ListValue* MemoryBudgetAsListValue(
+    const GPUVideoMemoryUsageStats& stats) {
+  base::ListValue* memory_budget = new base::ListValue();
+  for (GPUVideoMemoryUsageStats::ProcessMap::const_iterator it =
+           stats.process_map.begin();
+       it != stats.process_map.end();
+       ++it) {
+    const GPUVideoMemoryUsageStats::ProcessStats& process_stats = it->second;
+    std::string desc = base::StringPrintf("Process %d",
+                                          static_cast<int>(it->first));
+    if (process_stats.has_duplicates)
+      desc += " (total)";
+    memory_budget->Append(NewDescriptionValuePair(
+        desc,
+        base::StringPrintf("%" PRIuS " bytes used, %" PRIuS " bytes budget, "
+                           "%u visible, %u hibernated",
+                           process_stats.video_memory,
+                           process_stats.budget,
+                           process_stats.visible_client_count,
+                           process_stats.hibernated_client_count)));
+  }
+  return memory_budget;
+}
+
 // This class receives javascript messages from the renderer.
 // Note that the WebUI infrastructure runs on the UI thread, therefore all of
 // this class's methods are expected to run on the UI thread.
@@ -208,6 +236,8 @@ class GpuMessageHandler
   // GpuDataManagerObserver implementation.
   virtual void OnGpuInfoUpdate() OVERRIDE;
   virtual void OnGpuSwitching() OVERRIDE;
+  virtual void OnVideoMemoryUsageStatsUpdate(
+      const GPUVideoMemoryUsageStats& video_memory_usage_stats) OVERRIDE;
 
   // Messages
   void OnBrowserBridgeInitialized(const base::ListValue* list);
@@ -222,6 +252,10 @@ class GpuMessageHandler
   // DCHECK).
   bool observing_;
 
+  // The GPU memory manager's budgets as last reported, shown with the GPU
+  // info.
+  GPUVideoMemoryUsageStats video_memory_usage_stats_;
+
   DISALLOW_COPY_AND_ASSIGN(GpuMessageHandler);
 };
 
@@ -311,6 +345,10 @@ void GpuMessageHandler::OnBrowserBridgeInitialized(
   // Gpu process has not run yet, this will trigger its launch.
   GpuDataManagerImpl::GetInstance()->RequestCompleteGpuInfoIfNeeded();
 
+  // Ask for the GPU memory budgets too; they arrive through
+  // OnVideoMemoryUsageStatsUpdate.
+  GpuDataManagerImpl::GetInstance()->RequestVideoMemoryUsageStatsUpdate();
+
   // Run callback immediately in case the info is ready and no update in the
   // future.
   OnGpuInfoUpdate();
@@ -356,6 +394,9 @@ void GpuMessageHandler::OnGpuInfoUpdate() {
   if (feature_status)
     gpu_info_val->Set("featureStatus", feature_status);
 
+  gpu_info_val->Set("memoryBudget",
+                    MemoryBudgetAsListValue(video_memory_usage_stats_));
+
   // Send GPU Info to javascript.
   web_ui()->CallJavascriptFunction("browserBridge.onGpuInfoUpdate",
       *(gpu_info_val.get()));
@@ -365,6 +406,12 @@ void GpuMessageHandler::OnGpuSwitching() {
   GpuDataManagerImpl::GetInstance()->RequestCompleteGpuInfoIfNeeded();
 }
 
+void GpuMessageHandler::OnVideoMemoryUsageStatsUpdate(
+    const GPUVideoMemoryUsageStats& video_memory_usage_stats) {
+  video_memory_usage_stats_ = video_memory_usage_stats;
+  OnGpuInfoUpdate();
+}
+
 }  // namespace
 
 
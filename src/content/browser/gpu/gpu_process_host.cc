@@ -20,6 +20,7 @@
 #include "content/browser/gpu/gpu_data_manager_impl.h"
 #include "content/browser/gpu/gpu_process_host_ui_shim.h"
 #include "content/browser/gpu/shader_disk_cache.h"
+#include "content/browser/gpu/shader_pack_cache.h"
 #include "content/browser/renderer_host/render_widget_helper.h"
 #include "content/browser/renderer_host/render_widget_host_impl.h"
 #include "content/common/child_process_host_impl.h"
@@ -522,6 +523,11 @@ bool GpuProcessHost::Init() {
   if (!Send(new GpuMsg_Initialize()))
     return false;
 
+  if (!CommandLine::ForCurrentProcess()->HasSwitch(
+      switches::kDisableGpuShaderDiskCache)) {
+    PreloadSharedShaderCache();
+  }
+
   return true;
 }
 
@@ -1041,9 +1047,32 @@ void GpuProcessHost::LoadedShader(const std::string& key,
     Send(new GpuMsg_LoadedShader(data));
 }
 
+void GpuProcessHost::PreloadSharedShaderCache() {
+  TRACE_EVENT0("gpu", "GpuProcessHost::PreloadSharedShaderCache");
+
+  ShaderCacheFactory* factory = ShaderCacheFactory::GetInstance();
+  if (!factory->shared_cache()) {
+    const base::FilePath directory =
+        GetContentClient()->browser()->GetSharedShaderCacheDirectory();
+    if (directory.empty())
+      return;
+    factory->InitSharedCache(directory);
+  }
+  factory->shared_cache()->SendShadersTo(host_id_);
+}
+
 void GpuProcessHost::CreateChannelCache(int32 client_id) {
   TRACE_EVENT0("gpu", "GpuProcessHost::CreateChannelCache");
 
+  // The shared cache already holds the shaders of every profile, so there is
+  // no need to open the profile's own cache.
+  ShaderCacheFactory* factory = ShaderCacheFactory::GetInstance();
+  if (factory->shared_cache()) {
+    if (factory->HasCacheInfo(client_id))
+      shared_shader_cache_clients_.insert(client_id);
+    return;
+  }
+
   scoped_refptr<ShaderDiskCache> cache =
       ShaderCacheFactory::GetInstance()->Get(client_id);
   if (!cache.get())
@@ -1057,12 +1086,22 @@ void GpuProcessHost::CreateChannelCache(int32 client_id) {
 void GpuProcessHost::OnDestroyChannel(int32 client_id) {
   TRACE_EVENT0("gpu", "GpuProcessHost::OnDestroyChannel");
   client_id_to_shader_cache_.erase(client_id);
+  shared_shader_cache_clients_.erase(client_id);
 }
 
 void GpuProcessHost::OnCacheShader(int32 client_id,
                                    const std::string& key,
                                    const std::string& shader) {
   TRACE_EVENT0("gpu", "GpuProcessHost::OnCacheShader");
+  if (shared_shader_cache_clients_.count(client_id)) {
+    // The shared cache is gone once shutdown has started.
+    ShaderPackCache* shared_cache =
+        ShaderCacheFactory::GetInstance()->shared_cache();
+    if (shared_cache)
+      shared_cache->Cache(GetShaderPrefixKey() + ":" + key, shader);
+    return;
+  }
+
   ClientIdToShaderCacheMap::iterator iter =
       client_id_to_shader_cache_.find(client_id);
   // If the cache doesn't exist then this is an off the record profile.
@@ -170,6 +170,9 @@ class GpuProcessHost : public BrowserChildProcessHostDelegate,
       const GpuHostMsg_AcceleratedSurfaceBuffersSwapped_Params& params);
 #endif
 
+  // Sends the shaders of the cache shared by every profile to the GPU
+  // process, once they have been read.
+  void PreloadSharedShaderCache();
   void CreateChannelCache(int32 client_id);
   void OnDestroyChannel(int32 client_id);
   void OnCacheShader(int32 client_id, const std::string& key,
@@ -252,6 +255,10 @@ class GpuProcessHost : public BrowserChildProcessHostDelegate,
       ClientIdToShaderCacheMap;
   ClientIdToShaderCacheMap client_id_to_shader_cache_;
 
+  // Clients whose shaders go to the shared cache rather than to one of
+  // |client_id_to_shader_cache_|.
+  std::set<int32> shared_shader_cache_clients_;
+
   std::string shader_prefix_key_;
 
   // Keep an extra reference to the SurfaceRef stored in the GpuSurfaceTracker
@@ -6,6 +6,7 @@
 
 #include "base/threading/thread_checker.h"
 #include "content/browser/gpu/gpu_process_host.h"
+#include "content/browser/gpu/shader_pack_cache.h"
 #include "content/public/browser/browser_thread.h"
 #include "gpu/command_buffer/common/constants.h"
 #include "net/base/cache_type.h"
@@ -427,6 +428,29 @@ void ShaderCacheFactory::RemoveCacheInfo(int32 client_id) {
   client_id_to_path_map_.erase(client_id);
 }
 
+bool ShaderCacheFactory::HasCacheInfo(int32 client_id) const {
+  return client_id_to_path_map_.count(client_id) > 0;
+}
+
+void ShaderCacheFactory::InitSharedCache(const base::FilePath& directory) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (shared_cache_)
+    return;
+  shared_cache_.reset(new ShaderPackCache(
+      directory,
+      gpu::kDefaultMaxProgramCacheMemoryBytes,
+      BrowserThread::GetMessageLoopProxyForThread(BrowserThread::CACHE)
+          .get()));
+  shared_cache_->Load();
+}
+
+void ShaderCacheFactory::Shutdown() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  // ~ShaderPackCache() posts the write to the CACHE thread, which is stopped
+  // after the IO thread and so still runs it.
+  shared_cache_.reset();
+}
+
 scoped_refptr<ShaderDiskCache> ShaderCacheFactory::Get(int32 client_id) {
   ClientIdToPathMap::iterator iter =
       client_id_to_path_map_.find(client_id);
@@ -462,6 +486,21 @@ void ShaderCacheFactory::ClearByPath(const base::FilePath& path,
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
   DCHECK(!callback.is_null());
 
+  if (shared_cache_) {
+    shared_cache_->Clear(delete_begin, delete_end,
+                         base::Bind(&ShaderCacheFactory::ClearProfileCache,
+                                    base::Unretained(this), path, delete_begin,
+                                    delete_end, callback));
+    return;
+  }
+  ClearProfileCache(path, delete_begin, delete_end, callback);
+}
+
+void ShaderCacheFactory::ClearProfileCache(const base::FilePath& path,
+                                           const base::Time& delete_begin,
+                                           const base::Time& delete_end,
+                                           const base::Closure& callback) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
   scoped_refptr<ShaderClearHelper> helper = new ShaderClearHelper(
       GetByPath(path), path, delete_begin, delete_end, callback);
 
@@ -11,6 +11,7 @@
 
 #include "base/files/file_path.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/memory/singleton.h"
 #include "content/common/content_export.h"
 #include "net/disk_cache/disk_cache.h"
@@ -20,6 +21,7 @@ namespace content {
 class ShaderDiskCacheEntry;
 class ShaderDiskReadHelper;
 class ShaderClearHelper;
+class ShaderPackCache;
 
 // ShaderDiskCache is the interface to the on disk cache for
 // GL shaders.
@@ -96,7 +98,8 @@ class CONTENT_EXPORT ShaderDiskCache
 };
 
 // ShaderCacheFactory maintains a cache of ShaderDiskCache objects
-// so we only create one per profile directory.
+// so we only create one per profile directory, and the ShaderPackCache shared
+// by every profile, if there is one.
 class CONTENT_EXPORT ShaderCacheFactory {
  public:
   static ShaderCacheFactory* GetInstance();
@@ -104,7 +107,8 @@ class CONTENT_EXPORT ShaderCacheFactory {
   // Clear the shader disk cache for the given |path|. This supports unbounded
   // deletes in either direction by using null Time values for either
   // |begin_time| or |end_time|. The |callback| will be executed when the
-  // clear is complete.
+  // clear is complete. The shared cache does not know which profile cached a
+  // shader, so the range is cleared from it as well.
   void ClearByPath(const base::FilePath& path,
                    const base::Time& begin_time,
                    const base::Time& end_time,
@@ -119,6 +123,21 @@ class CONTENT_EXPORT ShaderCacheFactory {
   // Remove the path mapping for |client_id|.
   void RemoveCacheInfo(int32 client_id);
 
+  // Whether |client_id| has a path, that is, whether its shaders may be
+  // cached.
+  bool HasCacheInfo(int32 client_id) const;
+
+  // Creates the cache shared by every profile in |directory| and starts
+  // reading it. Does nothing if the shared cache already exists.
+  void InitSharedCache(const base::FilePath& directory);
+
+  // Returns the shared cache, or NULL if there is none.
+  ShaderPackCache* shared_cache() { return shared_cache_.get(); }
+
+  // Writes the shared cache's changes and destroys it.  The factory itself is
+  // leaked, so this must be called before the IO thread goes away.
+  void Shutdown();
+
   // Set the provided |cache| into the cache map for the given |path|.
   void AddToCache(const base::FilePath& path, ShaderDiskCache* cache);
 
@@ -132,6 +151,13 @@ class CONTENT_EXPORT ShaderCacheFactory {
   ShaderCacheFactory();
   ~ShaderCacheFactory();
 
+  // Clears the profile cache at |path|, after the shared cache has been
+  // cleared if there is one.
+  void ClearProfileCache(const base::FilePath& path,
+                         const base::Time& begin_time,
+                         const base::Time& end_time,
+                         const base::Closure& callback);
+
   scoped_refptr<ShaderDiskCache> GetByPath(const base::FilePath& path);
   void CacheCleared(const base::FilePath& path);
 
@@ -141,6 +167,8 @@ class CONTENT_EXPORT ShaderCacheFactory {
   typedef std::map<int32, base::FilePath> ClientIdToPathMap;
   ClientIdToPathMap client_id_to_path_map_;
 
+  scoped_ptr<ShaderPackCache> shared_cache_;
+
   typedef std::queue<scoped_refptr<ShaderClearHelper> > ShaderClearQueue;
   typedef std::map<base::FilePath, ShaderClearQueue> ShaderClearMap;
   ShaderClearMap shader_clear_map_;
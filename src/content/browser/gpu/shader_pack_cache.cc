@@ -0,0 +1,362 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "content/browser/gpu/shader_pack_cache.h"
+
+#include <string.h>
+
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/file_util.h"
+#include "base/files/important_file_writer.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/metrics/histogram.h"
+#include "base/sequenced_task_runner.h"
+#include "content/browser/gpu/gpu_process_host.h"
+
+namespace content {
+
+namespace {
+
+// "GSPK", for GPU shader pack.
+const uint32 kPackMagic = 0x4b505347;
+const uint32 kPackVersion = 1;
+
+// How long after a change the pack file is written, so that the shaders of a
+// page that is loading are written together.
+const int kWriteDelaySeconds = 10;
+
+struct PackHeader {
+  uint32 magic;
+  uint32 version;
+  uint32 entry_count;
+  uint32 padding;
+};
+COMPILE_ASSERT(sizeof(PackHeader) == 16, pack_header_has_no_padding);
+
+struct PackIndexEntry {
+  uint32 key_size;
+  uint32 shader_size;
+  int64 cache_time;
+};
+COMPILE_ASSERT(sizeof(PackIndexEntry) == 16, pack_index_entry_has_no_padding);
+
+void WritePack(const base::FilePath& path, const std::string& data) {
+  if (!base::CreateDirectory(path.DirName()) ||
+      !base::ImportantFileWriter::WriteFileAtomically(path, data)) {
+    LOG(ERROR) << "Failed to write the shader pack " << path.value();
+  }
+}
+
+}  // namespace
+
+const base::FilePath::CharType ShaderPackCache::kPackFileName[] =
+    FILE_PATH_LITERAL("GPUShaderPack");
+
+ShaderPackCache::Entry::Entry() {}
+
+ShaderPackCache::Entry::~Entry() {}
+
+ShaderPackCache::PackEntry::PackEntry() {}
+
+ShaderPackCache::PackEntry::~PackEntry() {}
+
+ShaderPackCache::ShaderPackCache(const base::FilePath& directory,
+                                 size_t max_size,
+                                 base::SequencedTaskRunner* task_runner)
+    : pack_path_(directory.Append(kPackFileName)),
+      max_size_(max_size),
+      task_runner_(task_runner),
+      load_started_(false),
+      loaded_(false),
+      current_size_(0),
+      dirty_(false),
+      weak_factory_(this) {
+}
+
+ShaderPackCache::~ShaderPackCache() {
+  DCHECK(CalledOnValidThread());
+  // Write whatever the timer would have, without waiting for it.
+  if (loaded_ && dirty_) {
+    task_runner_->PostTask(
+        FROM_HERE, base::Bind(&WritePack, pack_path_, SerializePack(entries_)));
+  }
+}
+
+void ShaderPackCache::Load() {
+  DCHECK(CalledOnValidThread());
+  if (load_started_)
+    return;
+  load_started_ = true;
+
+  PackEntries* entries = new PackEntries;
+  task_runner_->PostTaskAndReply(
+      FROM_HERE,
+      base::Bind(base::IgnoreResult(&ShaderPackCache::ReadPack),
+                 pack_path_,
+                 entries),
+      base::Bind(&ShaderPackCache::OnLoaded,
+                 weak_factory_.GetWeakPtr(),
+                 base::TimeTicks::Now(),
+                 base::Owned(entries)));
+}
+
+void ShaderPackCache::SendShadersTo(int host_id) {
+  RunWhenLoaded(base::Bind(&ShaderPackCache::SendShadersToNow,
+                           weak_factory_.GetWeakPtr(),
+                           host_id));
+}
+
+void ShaderPackCache::Cache(const std::string& key,
+                            const std::string& shader) {
+  DCHECK(CalledOnValidThread());
+  Entry entry;
+  entry.shader = shader;
+  entry.cache_time = base::Time::Now();
+  AddEntry(key, entry);
+  EvictIfNecessary();
+  ScheduleWrite();
+}
+
+bool ShaderPackCache::GetShader(const std::string& key,
+                                std::string* shader) const {
+  DCHECK(CalledOnValidThread());
+  EntryMap::const_iterator iter = entries_.find(key);
+  if (iter == entries_.end())
+    return false;
+  *shader = iter->second.shader;
+  return true;
+}
+
+void ShaderPackCache::Clear(const base::Time& begin_time,
+                            const base::Time& end_time,
+                            const base::Closure& callback) {
+  RunWhenLoaded(base::Bind(&ShaderPackCache::ClearNow,
+                           weak_factory_.GetWeakPtr(),
+                           begin_time,
+                           end_time,
+                           callback));
+}
+
+void ShaderPackCache::RunWhenLoaded(const base::Closure& callback) {
+  DCHECK(CalledOnValidThread());
+  if (loaded_) {
+    callback.Run();
+    return;
+  }
+  pending_tasks_.push_back(callback);
+  Load();
+}
+
+void ShaderPackCache::Flush(const base::Closure& callback) {
+  DCHECK(CalledOnValidThread());
+  if (!loaded_) {
+    RunWhenLoaded(base::Bind(&ShaderPackCache::Flush,
+                             weak_factory_.GetWeakPtr(),
+                             callback));
+    return;
+  }
+  write_timer_.Stop();
+  Write(callback);
+}
+
+// static
+bool ShaderPackCache::ReadPack(const base::FilePath& path,
+                               PackEntries* entries) {
+  DCHECK(entries->empty());
+  base::MemoryMappedFile file;
+  if (!base::PathExists(path) || !file.Initialize(path))
+    return false;
+
+  const uint8* data = file.data();
+  const size_t length = file.length();
+  PackHeader header;
+  if (length < sizeof(header))
+    return false;
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != kPackMagic || header.version != kPackVersion)
+    return false;
+
+  const size_t index_offset = sizeof(header);
+  if (header.entry_count > (length - index_offset) / sizeof(PackIndexEntry))
+    return false;
+
+  // Keys and shaders follow the index in the order it lists them.
+  size_t offset = index_offset + header.entry_count * sizeof(PackIndexEntry);
+  entries->resize(header.entry_count);
+  for (uint32 i = 0; i < header.entry_count; ++i) {
+    PackIndexEntry index;
+    memcpy(&index,
+           data + index_offset + i * sizeof(PackIndexEntry),
+           sizeof(index));
+    if (index.key_size > length - offset ||
+        index.shader_size > length - offset - index.key_size) {
+      entries->clear();
+      return false;
+    }
+    PackEntry* entry = &(*entries)[i];
+    entry->key.assign(reinterpret_cast<const char*>(data + offset),
+                      index.key_size);
+    offset += index.key_size;
+    entry->entry.shader.assign(reinterpret_cast<const char*>(data + offset),
+                               index.shader_size);
+    offset += index.shader_size;
+    entry->entry.cache_time = base::Time::FromInternalValue(index.cache_time);
+  }
+  if (offset != length) {
+    entries->clear();
+    return false;
+  }
+  return true;
+}
+
+// static
+std::string ShaderPackCache::SerializePack(const EntryMap& entries) {
+  PackHeader header;
+  header.magic = kPackMagic;
+  header.version = kPackVersion;
+  header.entry_count = entries.size();
+  header.padding = 0;
+
+  std::vector<PackIndexEntry> index;
+  index.reserve(entries.size());
+  size_t data_size = 0;
+  for (EntryMap::const_iterator i = entries.begin(); i != entries.end(); ++i) {
+    PackIndexEntry index_entry;
+    index_entry.key_size = i->first.size();
+    index_entry.shader_size = i->second.shader.size();
+    index_entry.cache_time = i->second.cache_time.ToInternalValue();
+    index.push_back(index_entry);
+    data_size += i->first.size() + i->second.shader.size();
+  }
+
+  std::string pack;
+  pack.reserve(sizeof(header) + index.size() * sizeof(PackIndexEntry) +
+               data_size);
+  pack.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (!index.empty()) {
+    pack.append(reinterpret_cast<const char*>(&index[0]),
+                index.size() * sizeof(PackIndexEntry));
+  }
+  for (EntryMap::const_iterator i = entries.begin(); i != entries.end(); ++i) {
+    pack.append(i->first);
+    pack.append(i->second.shader);
+  }
+  return pack;
+}
+
+void ShaderPackCache::OnLoaded(base::TimeTicks start_time,
+                               PackEntries* entries) {
+  DCHECK(CalledOnValidThread());
+  // Shaders cached while the pack was read are newer than the pack's.
+  for (PackEntries::const_iterator i = entries->begin(); i != entries->end();
+       ++i) {
+    if (!entries_.count(i->key))
+      AddEntry(i->key, i->entry);
+  }
+  EvictIfNecessary();
+  loaded_ = true;
+
+  UMA_HISTOGRAM_TIMES("GPU.ShaderPackCache.LoadTime",
+                      base::TimeTicks::Now() - start_time);
+  UMA_HISTOGRAM_COUNTS("GPU.ShaderPackCache.LoadedEntries", entries->size());
+
+  if (dirty_)
+    ScheduleWrite();
+
+  std::vector<base::Closure> tasks;
+  tasks.swap(pending_tasks_);
+  for (size_t i = 0; i < tasks.size(); ++i)
+    tasks[i].Run();
+}
+
+void ShaderPackCache::AddEntry(const std::string& key, const Entry& entry) {
+  EntryMap::iterator iter = entries_.find(key);
+  if (iter != entries_.end()) {
+    current_size_ -= key.size() + iter->second.shader.size();
+    iter->second = entry;
+  } else {
+    entries_[key] = entry;
+  }
+  current_size_ += key.size() + entry.shader.size();
+  dirty_ = true;
+}
+
+void ShaderPackCache::EvictIfNecessary() {
+  while (current_size_ > max_size_ && !entries_.empty()) {
+    EntryMap::iterator oldest = entries_.begin();
+    for (EntryMap::iterator i = entries_.begin(); i != entries_.end(); ++i) {
+      if (i->second.cache_time < oldest->second.cache_time)
+        oldest = i;
+    }
+    current_size_ -= oldest->first.size() + oldest->second.shader.size();
+    entries_.erase(oldest);
+    dirty_ = true;
+  }
+}
+
+void ShaderPackCache::ScheduleWrite() {
+  // Writing before the pack is read would drop the shaders in it.
+  if (!loaded_ || write_timer_.IsRunning())
+    return;
+  write_timer_.Start(FROM_HERE,
+                     base::TimeDelta::FromSeconds(kWriteDelaySeconds),
+                     this,
+                     &ShaderPackCache::OnWriteTimer);
+}
+
+void ShaderPackCache::OnWriteTimer() {
+  Write(base::Closure());
+}
+
+void ShaderPackCache::Write(const base::Closure& callback) {
+  DCHECK(loaded_);
+  const base::Closure reply =
+      callback.is_null() ? base::Bind(&base::DoNothing) : callback;
+  if (!dirty_) {
+    // Still reply after any write in flight.
+    task_runner_->PostTaskAndReply(
+        FROM_HERE, base::Bind(&base::DoNothing), reply);
+    return;
+  }
+  dirty_ = false;
+  task_runner_->PostTaskAndReply(
+      FROM_HERE,
+      base::Bind(&WritePack, pack_path_, SerializePack(entries_)),
+      reply);
+}
+
+void ShaderPackCache::SendShadersToNow(int host_id) {
+  GpuProcessHost* host = GpuProcessHost::FromID(host_id);
+  if (!host)
+    return;
+  for (EntryMap::const_iterator i = entries_.begin(); i != entries_.end();
+       ++i) {
+    host->LoadedShader(i->first, i->second.shader);
+  }
+}
+
+void ShaderPackCache::ClearNow(const base::Time& begin_time,
+                               const base::Time& end_time,
+                               const base::Closure& callback) {
+  EntryMap::iterator i = entries_.begin();
+  while (i != entries_.end()) {
+    const base::Time& cache_time = i->second.cache_time;
+    if ((begin_time.is_null() || cache_time >= begin_time) &&
+        (end_time.is_null() || cache_time < end_time)) {
+      current_size_ -= i->first.size() + i->second.shader.size();
+      entries_.erase(i++);
+      dirty_ = true;
+    } else {
+      ++i;
+    }
+  }
+  // Browsing data removal expects the shaders to be gone from disk, not just
+  // from memory, when it is told the clear is done.
+  Flush(callback);
+}
+
+}  // namespace content
@@ -0,0 +1,151 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CONTENT_BROWSER_GPU_SHADER_PACK_CACHE_H_
+#define CONTENT_BROWSER_GPU_SHADER_PACK_CACHE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/threading/non_thread_safe.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "content/common/content_export.h"
+
+namespace base {
+class SequencedTaskRunner;
+}
+
+namespace content {
+
+// ShaderPackCache is a shader cache shared by every storage partition, so
+// that a shader compiled for one principal is not compiled again for the
+// next.  Shaders are keyed by the hash of their source, as GpuProcessHost
+// already keys them.
+//
+// The cache lives in a single pack file: an index of key sizes, shader sizes
+// and cache times, followed by the keys and shaders.  The file is
+// memory-mapped and read in one pass on |task_runner|, rather than entry by
+// entry through a disk cache, and every GPU process gets the whole cache as
+// soon as it starts.  Changes are written back as a new pack a few seconds
+// after the last one.
+//
+// This class lives on the IO thread.
+class CONTENT_EXPORT ShaderPackCache : public base::NonThreadSafe {
+ public:
+  // The name of the pack file in the directory given to the constructor.
+  static const base::FilePath::CharType kPackFileName[];
+
+  // Stores the pack in |directory|, keeping at most |max_size| bytes of keys
+  // and shaders.  File work is posted to |task_runner|.
+  ShaderPackCache(const base::FilePath& directory,
+                  size_t max_size,
+                  base::SequencedTaskRunner* task_runner);
+  ~ShaderPackCache();
+
+  // Starts reading the pack file.
+  void Load();
+
+  // Whether the pack file has been read.
+  bool loaded() const { return loaded_; }
+
+  // Sends every shader to the GPU process host with |host_id|, once the pack
+  // file has been read.
+  void SendShadersTo(int host_id);
+
+  // Store the |shader| into the cache under |key|.
+  void Cache(const std::string& key, const std::string& shader);
+
+  // Sets |shader| to the shader cached under |key|, if there is one.
+  bool GetShader(const std::string& key, std::string* shader) const;
+
+  // Clears the entries cached between |begin_time| and |end_time|, once
+  // the pack file has been read.  Null times leave the range unbounded in that
+  // direction.  |callback|, if not null, runs on this thread once the pack
+  // file has been written without them.
+  void Clear(const base::Time& begin_time,
+             const base::Time& end_time,
+             const base::Closure& callback);
+
+  // Runs |callback| once the pack file has been read, or right away if it
+  // already has.
+  void RunWhenLoaded(const base::Closure& callback);
+
+  // Writes any changes to the pack file now, and runs |callback| on this
+  // thread when the write is done.
+  void Flush(const base::Closure& callback);
+
+  // Returns the number of shaders in the cache.
+  size_t size() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    Entry();
+    ~Entry();
+
+    std::string shader;
+    base::Time cache_time;
+  };
+  typedef std::map<std::string, Entry> EntryMap;
+
+  // An entry of the pack file, as read on |task_runner_|.
+  struct PackEntry {
+    PackEntry();
+    ~PackEntry();
+
+    std::string key;
+    Entry entry;
+  };
+  typedef std::vector<PackEntry> PackEntries;
+
+  // Reads the pack at |path| into |entries|.  Returns false, leaving
+  // |entries| empty, if the file is missing or malformed.
+  static bool ReadPack(const base::FilePath& path, PackEntries* entries);
+
+  // Serializes |entries| in the pack file format.
+  static std::string SerializePack(const EntryMap& entries);
+
+  void OnLoaded(base::TimeTicks start_time, PackEntries* entries);
+  void AddEntry(const std::string& key, const Entry& entry);
+  void EvictIfNecessary();
+  void ScheduleWrite();
+  void OnWriteTimer();
+  void Write(const base::Closure& callback);
+  void SendShadersToNow(int host_id);
+  void ClearNow(const base::Time& begin_time,
+                const base::Time& end_time,
+                const base::Closure& callback);
+
+  const base::FilePath pack_path_;
+  const size_t max_size_;
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+
+  bool load_started_;
+  bool loaded_;
+  EntryMap entries_;
+
+  // The size of the keys and shaders in |entries_|.
+  size_t current_size_;
+
+  // Work waiting for the pack file to be read.
+  std::vector<base::Closure> pending_tasks_;
+
+  // Whether |entries_| differs from the pack file.
+  bool dirty_;
+  base::OneShotTimer<ShaderPackCache> write_timer_;
+
+  base::WeakPtrFactory<ShaderPackCache> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShaderPackCache);
+};
+
+}  // namespace content
+
+#endif  // CONTENT_BROWSER_GPU_SHADER_PACK_CACHE_H_
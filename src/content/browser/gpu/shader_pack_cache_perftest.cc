@@ -0,0 +1,102 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "content/browser/gpu/shader_pack_cache.h"
+
+#include <string>
+
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop/message_loop_proxy.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+#include "content/browser/gpu/shader_disk_cache.h"
+#include "content/public/test/test_browser_thread_bundle.h"
+#include "net/base/test_completion_callback.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace content {
+namespace {
+
+const size_t kMaxCacheSize = 4 * 1024 * 1024;
+const int kDefaultClientId = 42;
+const int kShaders = 300;
+
+std::string MakeKey(int i) {
+  return "prefix:" + base::IntToString(i);
+}
+
+// A linked program of about the size WebGL pages produce.
+std::string MakeShader(int i) {
+  return std::string(8 * 1024, 'a' + i % 26);
+}
+
+}  // namespace
+
+// Fills a profile's disk cache and the shared pack with the same shaders, and
+// reports how long each takes to have every shader ready for the GPU process
+// when a new principal starts, which is what the first WebGL frame of the
+// principal waits for.
+TEST(ShaderPackCachePerfTest, Load) {
+  TestBrowserThreadBundle thread_bundle(TestBrowserThreadBundle::IO_MAINLOOP);
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const base::FilePath profile_path = temp_dir.path().AppendASCII("Profile");
+  ShaderCacheFactory* factory = ShaderCacheFactory::GetInstance();
+  factory->SetCacheInfo(kDefaultClientId, profile_path);
+
+  scoped_refptr<ShaderDiskCache> disk_cache = factory->Get(kDefaultClientId);
+  net::TestCompletionCallback available_cb;
+  ASSERT_EQ(net::OK, available_cb.GetResult(
+      disk_cache->SetAvailableCallback(available_cb.callback())));
+  scoped_ptr<ShaderPackCache> pack_cache(new ShaderPackCache(
+      temp_dir.path(), kMaxCacheSize,
+      base::MessageLoopProxy::current().get()));
+  for (int i = 0; i < kShaders; ++i) {
+    disk_cache->Cache(MakeKey(i), MakeShader(i));
+    pack_cache->Cache(MakeKey(i), MakeShader(i));
+  }
+  net::TestCompletionCallback complete_cb;
+  ASSERT_EQ(net::OK, complete_cb.GetResult(
+      disk_cache->SetCacheCompleteCallback(complete_cb.callback())));
+  base::RunLoop flush_loop;
+  pack_cache->Flush(flush_loop.QuitClosure());
+  flush_loop.Run();
+  disk_cache = NULL;
+  pack_cache.reset();
+  base::RunLoop().RunUntilIdle();
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  disk_cache = factory->Get(kDefaultClientId);
+  net::TestCompletionCallback reload_cb;
+  ASSERT_EQ(net::OK, reload_cb.GetResult(
+      disk_cache->SetAvailableCallback(reload_cb.callback())));
+  const base::TimeDelta disk_cache_time = base::TimeTicks::Now() - start;
+  EXPECT_EQ(kShaders, disk_cache->Size());
+
+  start = base::TimeTicks::Now();
+  pack_cache.reset(new ShaderPackCache(
+      temp_dir.path(), kMaxCacheSize,
+      base::MessageLoopProxy::current().get()));
+  base::RunLoop load_loop;
+  pack_cache->RunWhenLoaded(load_loop.QuitClosure());
+  load_loop.Run();
+  const base::TimeDelta pack_cache_time = base::TimeTicks::Now() - start;
+  EXPECT_EQ(static_cast<size_t>(kShaders), pack_cache->size());
+
+  const std::string trace = base::IntToString(kShaders) + "_shaders";
+  perf_test::PrintResult("shaders_ready", "", "disk_cache_" + trace,
+                         disk_cache_time.InMillisecondsF(), "ms", true);
+  perf_test::PrintResult("shaders_ready", "", "shader_pack_" + trace,
+                         pack_cache_time.InMillisecondsF(), "ms", true);
+
+  disk_cache = NULL;
+  pack_cache.reset();
+  factory->RemoveCacheInfo(kDefaultClientId);
+  base::RunLoop().RunUntilIdle();
+}
+
+}  // namespace content
@@ -0,0 +1,235 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "content/browser/gpu/shader_pack_cache.h"
+
+#include <string>
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop/message_loop_proxy.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+#include "content/browser/gpu/shader_disk_cache.h"
+#include "content/public/test/test_browser_thread_bundle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace content {
+namespace {
+
+const size_t kMaxCacheSize = 1024 * 1024;
+
+std::string MakeKey(int i) {
+  return "prefix:" + base::IntToString(i);
+}
+
+// A linked program of about the size WebGL pages produce.
+std::string MakeShader(int i) {
+  return std::string(8 * 1024, 'a' + i % 26);
+}
+
+}  // namespace
+
+class ShaderPackCacheTest : public testing::Test {
+ public:
+  ShaderPackCacheTest()
+      : thread_bundle_(TestBrowserThreadBundle::IO_MAINLOOP) {
+  }
+
+  virtual ~ShaderPackCacheTest() {}
+
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  }
+
+  const base::FilePath& directory() const { return temp_dir_.path(); }
+
+  scoped_ptr<ShaderPackCache> CreateCache(size_t max_size) {
+    return make_scoped_ptr(new ShaderPackCache(
+        directory(), max_size, base::MessageLoopProxy::current().get()));
+  }
+
+  // Creates a cache over the pack in |directory()| and waits for it to be
+  // read.
+  scoped_ptr<ShaderPackCache> CreateLoadedCache(size_t max_size) {
+    scoped_ptr<ShaderPackCache> cache(CreateCache(max_size));
+    base::RunLoop run_loop;
+    cache->RunWhenLoaded(run_loop.QuitClosure());
+    run_loop.Run();
+    EXPECT_TRUE(cache->loaded());
+    return cache.Pass();
+  }
+
+  void Flush(ShaderPackCache* cache) {
+    base::RunLoop run_loop;
+    cache->Flush(run_loop.QuitClosure());
+    run_loop.Run();
+  }
+
+ private:
+  base::ScopedTempDir temp_dir_;
+  TestBrowserThreadBundle thread_bundle_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShaderPackCacheTest);
+};
+
+TEST_F(ShaderPackCacheTest, PersistsAcrossInstances) {
+  scoped_ptr<ShaderPackCache> cache(CreateLoadedCache(kMaxCacheSize));
+  EXPECT_EQ(0u, cache->size());
+  cache->Cache(MakeKey(1), MakeShader(1));
+  cache->Cache(MakeKey(2), MakeShader(2));
+  cache->Cache(MakeKey(1), MakeShader(3));
+  Flush(cache.get());
+  cache.reset();
+
+  cache = CreateLoadedCache(kMaxCacheSize);
+  EXPECT_EQ(2u, cache->size());
+  std::string shader;
+  ASSERT_TRUE(cache->GetShader(MakeKey(1), &shader));
+  EXPECT_EQ(MakeShader(3), shader);
+  ASSERT_TRUE(cache->GetShader(MakeKey(2), &shader));
+  EXPECT_EQ(MakeShader(2), shader);
+  EXPECT_FALSE(cache->GetShader(MakeKey(3), &shader));
+}
+
+TEST_F(ShaderPackCacheTest, KeepsShadersCachedWhileLoading) {
+  scoped_ptr<ShaderPackCache> cache(CreateLoadedCache(kMaxCacheSize));
+  cache->Cache(MakeKey(1), MakeShader(1));
+  Flush(cache.get());
+  cache.reset();
+
+  cache = CreateCache(kMaxCacheSize);
+  cache->Load();
+  cache->Cache(MakeKey(1), MakeShader(2));
+  EXPECT_FALSE(cache->loaded());
+  Flush(cache.get());
+  EXPECT_TRUE(cache->loaded());
+
+  std::string shader;
+  ASSERT_TRUE(cache->GetShader(MakeKey(1), &shader));
+  EXPECT_EQ(MakeShader(2), shader);
+}
+
+TEST_F(ShaderPackCacheTest, IgnoresMalformedPack) {
+  const base::FilePath pack_path =
+      directory().Append(ShaderPackCache::kPackFileName);
+  scoped_ptr<ShaderPackCache> cache(CreateLoadedCache(kMaxCacheSize));
+  cache->Cache(MakeKey(1), MakeShader(1));
+  Flush(cache.get());
+  cache.reset();
+
+  // Cut the pack short.
+  std::string pack;
+  ASSERT_TRUE(base::ReadFileToString(pack_path, &pack));
+  pack.resize(pack.size() - 1);
+  ASSERT_EQ(static_cast<int>(pack.size()),
+            base::WriteFile(pack_path, pack.data(), pack.size()));
+  cache = CreateLoadedCache(kMaxCacheSize);
+  EXPECT_EQ(0u, cache->size());
+  cache.reset();
+
+  const char kGarbage[] = "not a shader pack";
+  ASSERT_EQ(static_cast<int>(sizeof(kGarbage)),
+            base::WriteFile(pack_path, kGarbage, sizeof(kGarbage)));
+  cache = CreateLoadedCache(kMaxCacheSize);
+  EXPECT_EQ(0u, cache->size());
+
+  // The cache still works, and replaces the bad pack.
+  cache->Cache(MakeKey(2), MakeShader(2));
+  Flush(cache.get());
+  cache.reset();
+  cache = CreateLoadedCache(kMaxCacheSize);
+  EXPECT_EQ(1u, cache->size());
+}
+
+TEST_F(ShaderPackCacheTest, ClearsRange) {
+  scoped_ptr<ShaderPackCache> cache(CreateLoadedCache(kMaxCacheSize));
+  cache->Cache(MakeKey(1), MakeShader(1));
+  const base::Time first_cached = base::Time::Now();
+  while (base::Time::Now() == first_cached) {}
+  const base::Time middle = base::Time::Now();
+  cache->Cache(MakeKey(2), MakeShader(2));
+
+  base::RunLoop run_loop;
+  cache->Clear(middle, base::Time(), run_loop.QuitClosure());
+  run_loop.Run();
+  EXPECT_EQ(1u, cache->size());
+  std::string shader;
+  EXPECT_TRUE(cache->GetShader(MakeKey(1), &shader));
+
+  // The pack has already been written when the clear completes.
+  cache.reset();
+  cache = CreateLoadedCache(kMaxCacheSize);
+  EXPECT_EQ(1u, cache->size());
+
+  base::RunLoop clear_all;
+  cache->Clear(base::Time(), base::Time(), clear_all.QuitClosure());
+  clear_all.Run();
+  EXPECT_EQ(0u, cache->size());
+  cache.reset();
+  cache = CreateLoadedCache(kMaxCacheSize);
+  EXPECT_EQ(0u, cache->size());
+}
+
+// Clearing a profile's browsing data clears the shared cache on disk before
+// it reports that it is done.
+TEST_F(ShaderPackCacheTest, ClearByPathWritesSharedCache) {
+  ShaderCacheFactory* factory = ShaderCacheFactory::GetInstance();
+  factory->InitSharedCache(directory());
+  base::RunLoop load_loop;
+  factory->shared_cache()->RunWhenLoaded(load_loop.QuitClosure());
+  load_loop.Run();
+  factory->shared_cache()->Cache(MakeKey(1), MakeShader(1));
+  Flush(factory->shared_cache());
+  factory->shared_cache()->Cache(MakeKey(2), MakeShader(2));
+
+  base::RunLoop clear_loop;
+  factory->ClearByPath(directory().AppendASCII("Profile"), base::Time(),
+                       base::Time(), clear_loop.QuitClosure());
+  clear_loop.Run();
+  EXPECT_EQ(0u, factory->shared_cache()->size());
+
+  scoped_ptr<ShaderPackCache> cache(CreateLoadedCache(kMaxCacheSize));
+  EXPECT_EQ(0u, cache->size());
+
+  factory->Shutdown();
+  base::RunLoop().RunUntilIdle();
+}
+
+TEST_F(ShaderPackCacheTest, ShutdownWritesSharedCache) {
+  ShaderCacheFactory* factory = ShaderCacheFactory::GetInstance();
+  factory->InitSharedCache(directory());
+  base::RunLoop load_loop;
+  factory->shared_cache()->RunWhenLoaded(load_loop.QuitClosure());
+  load_loop.Run();
+  factory->shared_cache()->Cache(MakeKey(1), MakeShader(1));
+
+  // The change is written without waiting for the write delay.
+  factory->Shutdown();
+  EXPECT_FALSE(factory->shared_cache());
+  base::RunLoop().RunUntilIdle();
+
+  scoped_ptr<ShaderPackCache> cache(CreateLoadedCache(kMaxCacheSize));
+  EXPECT_EQ(1u, cache->size());
+}
+
+TEST_F(ShaderPackCacheTest, EvictsOldestShaders) {
+  const size_t kEntrySize = MakeKey(0).size() + MakeShader(0).size();
+  scoped_ptr<ShaderPackCache> cache(CreateLoadedCache(3 * kEntrySize));
+  for (int i = 0; i < 5; ++i) {
+    const base::Time now = base::Time::Now();
+    while (base::Time::Now() == now) {}
+    cache->Cache(MakeKey(i), MakeShader(i));
+  }
+  EXPECT_EQ(3u, cache->size());
+  std::string shader;
+  EXPECT_FALSE(cache->GetShader(MakeKey(0), &shader));
+  EXPECT_FALSE(cache->GetShader(MakeKey(1), &shader));
+  EXPECT_TRUE(cache->GetShader(MakeKey(4), &shader));
+}
+
+}  // namespace content
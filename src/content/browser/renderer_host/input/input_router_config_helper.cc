@@ -140,6 +140,8 @@ InputRouterImpl::Config GetInputRouterConfigForPlatform() {
   config.gesture_config = GetGestureEventQueueConfig();
   config.touch_config = GetTouchEventQueueConfig();
   config.touch_config.touch_scrolling_mode = GetTouchScrollingMode();
+  config.frame_aligned_dispatch = CommandLine::ForCurrentProcess()->HasSwitch(
+      switches::kEnableFrameAlignedInput);
   return config;
 }
 
@@ -20,6 +20,7 @@
 #include "content/common/edit_command.h"
 #include "content/common/input/input_event_ack_state.h"
 #include "content/common/input/touch_action.h"
+#include "content/common/input/web_input_event_traits.h"
 #include "content/common/input/web_touch_event_traits.h"
 #include "content/common/input_messages.h"
 #include "content/common/view_messages.h"
@@ -55,9 +56,28 @@ const char* GetEventAckName(InputEventAckState ack_result) {
   return "";
 }
 
+// Continuous events arrive as fast as the device reports them, but the
+// renderer needs at most one of each per frame.
+bool IsContinuousEvent(const WebInputEvent& event) {
+  switch (event.type) {
+    case WebInputEvent::MouseMove:
+    case WebInputEvent::MouseWheel:
+    case WebInputEvent::TouchMove:
+    case WebInputEvent::GestureScrollUpdate:
+    case WebInputEvent::GestureScrollUpdateWithoutPropagation:
+    case WebInputEvent::GesturePinchUpdate:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// The vsync interval assumed until the view reports one.
+const int64 kDefaultVSyncIntervalUs = base::Time::kMicrosecondsPerSecond / 60;
+
 } // namespace
 
-InputRouterImpl::Config::Config() {
+InputRouterImpl::Config::Config() : frame_aligned_dispatch(false) {
 }
 
 InputRouterImpl::InputRouterImpl(IPC::Sender* sender,
@@ -77,7 +97,10 @@ InputRouterImpl::InputRouterImpl(IPC::Sender* sender,
       current_ack_source_(ACK_SOURCE_NONE),
       flush_requested_(false),
       touch_event_queue_(this, config.touch_config),
-      gesture_event_queue_(this, this, config.gesture_config) {
+      gesture_event_queue_(this, this, config.gesture_config),
+      frame_aligned_dispatch_(config.frame_aligned_dispatch),
+      vsync_interval_(
+          TimeDelta::FromMicroseconds(kDefaultVSyncIntervalUs)) {
   DCHECK(sender);
   DCHECK(client);
   DCHECK(ack_handler);
@@ -266,6 +289,13 @@ void InputRouterImpl::OnViewUpdated(int view_flags) {
   UpdateTouchAckTimeoutEnabled();
 }
 
+void InputRouterImpl::OnVSyncParametersChanged(TimeTicks timebase,
+                                               TimeDelta interval) {
+  vsync_timebase_ = timebase;
+  if (interval > TimeDelta())
+    vsync_interval_ = interval;
+}
+
 bool InputRouterImpl::OnMessageReceived(const IPC::Message& message) {
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(InputRouterImpl, message)
@@ -436,18 +466,118 @@ bool InputRouterImpl::OfferToClient(const WebInputEvent& input_event,
 bool InputRouterImpl::OfferToRenderer(const WebInputEvent& input_event,
                                       const ui::LatencyInfo& latency_info,
                                       bool is_keyboard_shortcut) {
-  if (Send(new InputMsg_HandleInputEvent(
+  if (frame_aligned_dispatch_ && IsContinuousEvent(input_event)) {
+    HoldForNextFrame(input_event, latency_info);
+    return true;
+  }
+
+  // Other events go at once, but must not overtake the events held before
+  // them.
+  DispatchHeldEvents();
+  return SendToRenderer(input_event, latency_info, is_keyboard_shortcut);
+}
+
+bool InputRouterImpl::SendToRenderer(const WebInputEvent& input_event,
+                                     const ui::LatencyInfo& latency_info,
+                                     bool is_keyboard_shortcut) {
+  if (!Send(new InputMsg_HandleInputEvent(
           routing_id(), &input_event, latency_info, is_keyboard_shortcut))) {
-    // Ack messages for ignored ack event types should never be sent by the
-    // renderer. Consequently, such event types should not affect event time
-    // or in-flight event count metrics.
-    if (!WebInputEventTraits::IgnoresAckDisposition(input_event)) {
-      input_event_start_time_ = TimeTicks::Now();
-      client_->IncrementInFlightEventCount();
+    return false;
+  }
+
+  // Record how long the event spent in the browser since it reached the
+  // RenderWidgetHost, which includes any time held for a frame.
+  for (ui::LatencyInfo::LatencyMap::const_iterator it =
+           latency_info.latency_components.begin();
+       it != latency_info.latency_components.end(); ++it) {
+    if (it->first.first == ui::INPUT_EVENT_LATENCY_BEGIN_RWH_COMPONENT) {
+      UMA_HISTOGRAM_CUSTOM_COUNTS(
+          "Event.Latency.Browser.Queueing",
+          (TimeTicks::HighResNow() - it->second.event_time).InMicroseconds(),
+          1,
+          1000000,
+          100);
+      break;
     }
-    return true;
   }
-  return false;
+
+  // Ack messages for ignored ack event types should never be sent by the
+  // renderer. Consequently, such event types should not affect event time
+  // or in-flight event count metrics.
+  if (!WebInputEventTraits::IgnoresAckDisposition(input_event)) {
+    input_event_start_time_ = TimeTicks::Now();
+    send_times_[input_event.type].push_back(input_event_start_time_);
+    client_->IncrementInFlightEventCount();
+  }
+  return true;
+}
+
+void InputRouterImpl::HoldForNextFrame(const WebInputEvent& input_event,
+                                       const ui::LatencyInfo& latency_info) {
+  // Events that ignore their ack have been acked already, so nothing stops
+  // the next event of their stream from following them here.  Coalesce it
+  // into the held one, keeping the older LatencyInfo.
+  if (!held_events_.empty()) {
+    WebInputEvent* last_event = held_events_.back()->event.get();
+    if (WebInputEventTraits::IgnoresAckDisposition(input_event) &&
+        WebInputEventTraits::IgnoresAckDisposition(*last_event) &&
+        WebInputEventTraits::CanCoalesce(input_event, *last_event)) {
+      WebInputEventTraits::Coalesce(input_event, last_event);
+      return;
+    }
+  }
+
+  held_events_.push_back(new HeldEvent(input_event, latency_info));
+  if (!frame_timer_.IsRunning()) {
+    frame_timer_.Start(FROM_HERE, TimeUntilNextFrame(), this,
+                       &InputRouterImpl::OnFrame);
+  }
+}
+
+void InputRouterImpl::DispatchHeldEvents() {
+  frame_timer_.Stop();
+  if (held_events_.empty())
+    return;
+
+  TRACE_EVENT1("input", "InputRouterImpl::DispatchHeldEvents",
+               "count", held_events_.size());
+  ScopedVector<HeldEvent> events;
+  events.swap(held_events_);
+  for (size_t i = 0; i < events.size(); ++i)
+    SendToRenderer(*events[i]->event, events[i]->latency, false);
+}
+
+void InputRouterImpl::OnFrame() {
+  DispatchHeldEvents();
+  SignalFlushedIfNecessary();
+}
+
+TimeDelta InputRouterImpl::TimeUntilNextFrame() const {
+  // The timebase comes from TimeTicks::HighResNow().
+  const int64 interval_us = vsync_interval_.InMicroseconds();
+  int64 phase_us =
+      (TimeTicks::HighResNow() - vsync_timebase_).InMicroseconds() %
+      interval_us;
+  if (phase_us < 0)
+    phase_us += interval_us;
+  return TimeDelta::FromMicroseconds(interval_us - phase_us);
+}
+
+void InputRouterImpl::RecordRendererLatency(WebInputEvent::Type type,
+                                            bool handled_on_compositor_thread) {
+  SendTimeMap::iterator it = send_times_.find(type);
+  if (it == send_times_.end() || it->second.empty())
+    return;
+
+  const TimeDelta latency = TimeTicks::Now() - it->second.front();
+  it->second.pop_front();
+  if (handled_on_compositor_thread) {
+    UMA_HISTOGRAM_CUSTOM_COUNTS("Event.Latency.Renderer.CompositorThread",
+                                latency.InMicroseconds(), 1, 1000000, 100);
+  } else {
+    UMA_HISTOGRAM_CUSTOM_COUNTS("Event.Latency.Renderer.MainThread",
+                                latency.InMicroseconds(), 1, 1000000, 100);
+  }
 }
 
 void InputRouterImpl::SendSyntheticWheelEventForPinch(
@@ -494,6 +624,7 @@ void InputRouterImpl::OnInputEventAck(
   // Log the time delta for processing an input event.
   TimeDelta delta = TimeTicks::Now() - input_event_start_time_;
   UMA_HISTOGRAM_TIMES("MPArch.IIR_InputEventDelta", delta);
+  RecordRendererLatency(ack.type, ack.handled_on_compositor_thread);
 
   if (ack.overscroll) {
     DCHECK(ack.type == WebInputEvent::MouseWheel ||
@@ -728,6 +859,7 @@ bool InputRouterImpl::HasPendingEvents() const {
   return !touch_event_queue_.empty() ||
          !gesture_event_queue_.empty() ||
          !key_queue_.empty() ||
+         !held_events_.empty() ||
          mouse_move_pending_ ||
          mouse_wheel_pending_ ||
          select_range_pending_ ||
@@ -752,4 +884,12 @@ InputRouterImpl::QueuedWheelEvent::QueuedWheelEvent(
 InputRouterImpl::QueuedWheelEvent::~QueuedWheelEvent() {
 }
 
+InputRouterImpl::HeldEvent::HeldEvent(const WebInputEvent& event,
+                                      const ui::LatencyInfo& latency)
+    : event(WebInputEventTraits::Clone(event)), latency(latency) {
+}
+
+InputRouterImpl::HeldEvent::~HeldEvent() {
+}
+
 }  // namespace content
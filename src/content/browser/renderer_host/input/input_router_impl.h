@@ -5,17 +5,22 @@
 #ifndef CONTENT_BROWSER_RENDERER_HOST_INPUT_INPUT_ROUTER_IMPL_H_
 #define CONTENT_BROWSER_RENDERER_HOST_INPUT_INPUT_ROUTER_IMPL_H_
 
+#include <deque>
+#include <map>
 #include <queue>
 
 #include "base/basictypes.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
 #include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "content/browser/renderer_host/input/gesture_event_queue.h"
 #include "content/browser/renderer_host/input/input_router.h"
 #include "content/browser/renderer_host/input/touch_action_filter.h"
 #include "content/browser/renderer_host/input/touch_event_queue.h"
 #include "content/browser/renderer_host/input/touchpad_tap_suppression_controller.h"
 #include "content/common/input/input_event_stream_validator.h"
+#include "content/common/input/scoped_web_input_event.h"
 #include "content/public/browser/native_web_keyboard_event.h"
 
 struct InputHostMsg_HandleInputEvent_ACK_Params;
@@ -47,6 +52,12 @@ class CONTENT_EXPORT InputRouterImpl
     Config();
     GestureEventQueue::Config gesture_config;
     TouchEventQueue::Config touch_config;
+
+    // Whether continuous events (mouse moves, wheels, touch moves and scroll
+    // and pinch updates) are held until the next vsync instead of being sent
+    // as soon as they are ready, so that the renderer gets at most one of
+    // each per frame.  Defaults to false.
+    bool frame_aligned_dispatch;
   };
 
   InputRouterImpl(IPC::Sender* sender,
@@ -74,11 +85,14 @@ class CONTENT_EXPORT InputRouterImpl
   virtual const NativeWebKeyboardEvent* GetLastKeyboardEvent() const OVERRIDE;
   virtual bool ShouldForwardTouchEvent() const OVERRIDE;
   virtual void OnViewUpdated(int view_flags) OVERRIDE;
+  virtual void OnVSyncParametersChanged(base::TimeTicks timebase,
+                                        base::TimeDelta interval) OVERRIDE;
 
   // IPC::Listener
   virtual bool OnMessageReceived(const IPC::Message& message) OVERRIDE;
 
 private:
+  friend class InputRouterImplPerfTest;
   friend class InputRouterImplTest;
   friend class MockRenderWidgetHost;
 
@@ -123,11 +137,45 @@ private:
                      const ui::LatencyInfo& latency_info);
 
   // Returns true if |input_event| was successfully sent to the renderer
-  // as an async IPC Message.
+  // as an async IPC Message, or held to be sent at the next frame.
   bool OfferToRenderer(const blink::WebInputEvent& input_event,
                        const ui::LatencyInfo& latency_info,
                        bool is_keyboard_shortcut);
 
+  // Sends |input_event| to the renderer now.
+  bool SendToRenderer(const blink::WebInputEvent& input_event,
+                      const ui::LatencyInfo& latency_info,
+                      bool is_keyboard_shortcut);
+
+  // Holds the continuous |input_event| in |held_events_| until the next
+  // frame.
+  void HoldForNextFrame(const blink::WebInputEvent& input_event,
+                        const ui::LatencyInfo& latency_info);
+
+  // Sends the events in |held_events_| to the renderer, in order.
+  void DispatchHeldEvents();
+
+  // Called at vsync while events are held.
+  void OnFrame();
+
+  // Returns the time until the next vsync.
+  base::TimeDelta TimeUntilNextFrame() const;
+
+  // Records how long the renderer took to ack the oldest event of |type| sent
+  // to it, by the thread that handled it.
+  void RecordRendererLatency(blink::WebInputEvent::Type type,
+                             bool handled_on_compositor_thread);
+
+  // A continuous event held until the next frame.
+  struct HeldEvent {
+    HeldEvent(const blink::WebInputEvent& event,
+              const ui::LatencyInfo& latency);
+    ~HeldEvent();
+
+    ScopedWebInputEvent event;
+    ui::LatencyInfo latency;
+  };
+
   // A data structure that attaches some metadata to a WebMouseWheelEvent
   // and its latency info.
   struct QueuedWheelEvent {
@@ -283,6 +331,24 @@ private:
   TouchActionFilter touch_action_filter_;
   InputEventStreamValidator event_stream_validator_;
 
+  // See Config::frame_aligned_dispatch.
+  bool frame_aligned_dispatch_;
+
+  // The display's vsync phase and interval, from |OnVSyncParametersChanged()|.
+  base::TimeTicks vsync_timebase_;
+  base::TimeDelta vsync_interval_;
+
+  // Continuous events waiting for the next frame, oldest first.  Each stream
+  // of continuous events waits for an ack before sending its next event, so
+  // later events of the stream coalesce in its own queue meanwhile.
+  ScopedVector<HeldEvent> held_events_;
+  base::OneShotTimer<InputRouterImpl> frame_timer_;
+
+  // When the events awaiting an ack from the renderer were sent, by type.
+  typedef std::map<blink::WebInputEvent::Type, std::deque<base::TimeTicks> >
+      SendTimeMap;
+  SendTimeMap send_times_;
+
   DISALLOW_COPY_AND_ASSIGN(InputRouterImpl);
 };
 
@@ -4,9 +4,11 @@
 
 #include "base/basictypes.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/strings/stringprintf.h"
 #include "content/browser/renderer_host/input/input_ack_handler.h"
 #include "content/browser/renderer_host/input/input_router_client.h"
 #include "content/browser/renderer_host/input/input_router_impl.h"
+#include "content/common/input/synthetic_web_input_event_builders.h"
 #include "content/common/input/web_input_event_traits.h"
 #include "content/common/input_messages.h"
 #include "content/common/view_messages.h"
@@ -18,6 +20,8 @@
 using base::TimeDelta;
 using blink::WebGestureEvent;
 using blink::WebInputEvent;
+using blink::WebMouseEvent;
+using blink::WebMouseWheelEvent;
 using blink::WebTouchEvent;
 using blink::WebTouchPoint;
 
@@ -87,15 +91,28 @@ class NullInputRouterClient : public InputRouterClient {
 
 class NullIPCSender : public IPC::Sender {
  public:
-  NullIPCSender() : sent_count_(0) {}
+  NullIPCSender() : sent_count_(0), record_unacked_types_(false) {}
   virtual ~NullIPCSender() {}
 
   virtual bool Send(IPC::Message* message) OVERRIDE {
+    if (record_unacked_types_)
+      RecordUnackedType(*message);
     delete message;
     ++sent_count_;
     return true;
   }
 
+  // Whether to record the types of the sent events that expect an ack.
+  void set_record_unacked_types(bool record) {
+    record_unacked_types_ = record;
+  }
+
+  std::vector<WebInputEvent::Type> TakeUnackedTypes() {
+    std::vector<WebInputEvent::Type> types;
+    types.swap(unacked_types_);
+    return types;
+  }
+
   size_t GetAndResetSentEventCount() {
     size_t message_count = sent_count_;
     sent_count_ = 0;
@@ -105,7 +122,19 @@ class NullIPCSender : public IPC::Sender {
   bool HasMessages() const { return sent_count_ > 0; }
 
  private:
+  void RecordUnackedType(const IPC::Message& message) {
+    InputMsg_HandleInputEvent::Param params;
+    if (message.type() != InputMsg_HandleInputEvent::ID ||
+        !InputMsg_HandleInputEvent::Read(&message, &params) ||
+        WebInputEventTraits::IgnoresAckDisposition(*params.a)) {
+      return;
+    }
+    unacked_types_.push_back(params.a->type);
+  }
+
   size_t sent_count_;
+  bool record_unacked_types_;
+  std::vector<WebInputEvent::Type> unacked_types_;
 };
 
 // TODO(jdduke): Use synthetic gesture pipeline, crbug.com/344598.
@@ -170,6 +199,27 @@ Touches BuildTouchSequence(size_t steps,
   return touches;
 }
 
+typedef std::vector<WebMouseEvent> MouseEvents;
+MouseEvents BuildMouseMoveSequence(size_t steps,
+                                   gfx::Vector2dF origin,
+                                   gfx::Vector2dF distance) {
+  MouseEvents events;
+  const gfx::Vector2dF delta = ScaleVector2d(distance, 1.f / steps);
+  for (size_t i = 0; i < steps; ++i) {
+    const gfx::Vector2dF position = origin + ScaleVector2d(delta, i);
+    events.push_back(SyntheticWebMouseEventBuilder::Build(
+        WebInputEvent::MouseMove, position.x(), position.y(), 0));
+  }
+  return events;
+}
+
+typedef std::vector<WebMouseWheelEvent> WheelEvents;
+WheelEvents BuildWheelSequence(size_t steps, gfx::Vector2dF distance) {
+  const gfx::Vector2dF delta = ScaleVector2d(distance, 1.f / steps);
+  return WheelEvents(steps, SyntheticWebMouseWheelEventBuilder::Build(
+      delta.x(), delta.y(), 0, true));
+}
+
 class InputEventTimer {
  public:
   InputEventTimer(const char* test_name, int64 event_count)
@@ -212,7 +262,13 @@ class InputRouterImplPerfTest : public testing::Test {
                                             client_.get(),
                                             ack_handler_.get(),
                                             MSG_ROUTING_NONE,
-                                            InputRouterImpl::Config()));
+                                            config_));
+  }
+
+  void SetUpForFrameAlignedDispatch() {
+    config_.frame_aligned_dispatch = true;
+    TearDown();
+    SetUp();
   }
 
   virtual void TearDown() OVERRIDE {
@@ -234,6 +290,16 @@ class InputRouterImplPerfTest : public testing::Test {
     input_router_->SendTouchEvent(TouchEventWithLatencyInfo(touch, latency));
   }
 
+  void SendEvent(const WebMouseEvent& mouse, const ui::LatencyInfo& latency) {
+    input_router_->SendMouseEvent(MouseEventWithLatencyInfo(mouse, latency));
+  }
+
+  void SendEvent(const WebMouseWheelEvent& wheel,
+                 const ui::LatencyInfo& latency) {
+    input_router_->SendWheelEvent(
+        MouseWheelEventWithLatencyInfo(wheel, latency));
+  }
+
   void SendEventAckIfNecessary(const blink::WebInputEvent& event,
                                InputEventAckState ack_result) {
     if (WebInputEventTraits::IgnoresAckDisposition(event))
@@ -301,6 +367,63 @@ class InputRouterImplPerfTest : public testing::Test {
     }
   }
 
+  // Ends a frame: held events are sent, and the renderer acks every event it
+  // received, which may release coalesced events.  Returns the number of
+  // events sent to the renderer during the frame.
+  size_t EndFrame() {
+    if (config_.frame_aligned_dispatch)
+      input_router_->OnFrame();
+    const size_t sent_count = GetAndResetSentEventCount();
+    const std::vector<WebInputEvent::Type> types = sender_->TakeUnackedTypes();
+    for (size_t i = 0; i < types.size(); ++i) {
+      InputHostMsg_HandleInputEvent_ACK_Params ack;
+      ack.type = types[i];
+      ack.state = INPUT_EVENT_ACK_STATE_CONSUMED;
+      InputHostMsg_HandleInputEvent_ACK response(0, ack);
+      input_router_->OnMessageReceived(response);
+    }
+    return sent_count;
+  }
+
+  // Sends |events| as a device reporting |events_per_frame| of them each
+  // frame, with the renderer acking what it receives by the end of the frame.
+  // Reports the time per event and how many events the renderer received per
+  // frame.
+  template <typename EventType>
+  void SimulateHighFrequencyInput(const char* test_name,
+                                  const std::vector<EventType>& events,
+                                  size_t events_per_frame,
+                                  size_t iterations) {
+    OnHasTouchEventHandlers(true);
+    sender_->set_record_unacked_types(true);
+
+    size_t frame_count = 0;
+    size_t sent_count = 0;
+    {
+      InputEventTimer timer(test_name, events.size() * iterations);
+      while (iterations--) {
+        for (size_t i = 0; i < events.size(); ++i) {
+          SendEvent(events[i], CreateLatencyInfo());
+          if ((i + 1) % events_per_frame == 0) {
+            sent_count += EndFrame();
+            ++frame_count;
+          }
+        }
+        sent_count += EndFrame();
+        ++frame_count;
+      }
+    }
+
+    perf_test::PrintResult(
+        "renderer_events_per_frame",
+        "",
+        test_name,
+        base::StringPrintf("%.2f", static_cast<double>(sent_count) /
+                                       frame_count),
+        "events",
+        true);
+  }
+
   void SimulateTouchAndScrollEventSequence(const char* test_name,
                                            size_t steps,
                                            gfx::Vector2dF origin,
@@ -335,6 +458,7 @@ class InputRouterImplPerfTest : public testing::Test {
 
  private:
   int64 last_input_id_;
+  InputRouterImpl::Config config_;
   scoped_ptr<NullIPCSender> sender_;
   scoped_ptr<NullInputRouterClient> client_;
   scoped_ptr<NullInputAckHandler> ack_handler_;
@@ -387,4 +511,67 @@ TEST_F(InputRouterImplPerfTest, TouchSwipeToGestureScroll) {
                                       kDefaultIterations);
 }
 
+// A gaming mouse reports at 1000 Hz, about 16 events per 60 Hz frame.
+const size_t kHighFrequencySteps(1000);
+const size_t kMouseEventsPerFrame(16);
+
+// Precise touchpads and high-rate touchscreens report at about 240 Hz.
+const size_t kTouchpadEventsPerFrame(4);
+const size_t kTouchscreenEventsPerFrame(4);
+
+TEST_F(InputRouterImplPerfTest, HighFrequencyMouseMove) {
+  SimulateHighFrequencyInput(
+      "HighFrequencyMouseMove ",
+      BuildMouseMoveSequence(
+          kHighFrequencySteps, kDefaultOrigin, kDefaultDistance),
+      kMouseEventsPerFrame,
+      kDefaultIterations);
+}
+
+TEST_F(InputRouterImplPerfTest, HighFrequencyMouseMoveFrameAligned) {
+  SetUpForFrameAlignedDispatch();
+  SimulateHighFrequencyInput(
+      "HighFrequencyMouseMoveFrameAligned ",
+      BuildMouseMoveSequence(
+          kHighFrequencySteps, kDefaultOrigin, kDefaultDistance),
+      kMouseEventsPerFrame,
+      kDefaultIterations);
+}
+
+TEST_F(InputRouterImplPerfTest, HighFrequencyWheel) {
+  SimulateHighFrequencyInput(
+      "HighFrequencyWheel ",
+      BuildWheelSequence(kHighFrequencySteps, kDefaultDistance),
+      kTouchpadEventsPerFrame,
+      kDefaultIterations);
+}
+
+TEST_F(InputRouterImplPerfTest, HighFrequencyWheelFrameAligned) {
+  SetUpForFrameAlignedDispatch();
+  SimulateHighFrequencyInput(
+      "HighFrequencyWheelFrameAligned ",
+      BuildWheelSequence(kHighFrequencySteps, kDefaultDistance),
+      kTouchpadEventsPerFrame,
+      kDefaultIterations);
+}
+
+TEST_F(InputRouterImplPerfTest, HighFrequencyTouchSwipe) {
+  SimulateHighFrequencyInput(
+      "HighFrequencyTouchSwipe ",
+      BuildTouchSequence(kHighFrequencySteps, kDefaultOrigin,
+                         kDefaultDistance),
+      kTouchscreenEventsPerFrame,
+      kDefaultIterations);
+}
+
+TEST_F(InputRouterImplPerfTest, HighFrequencyTouchSwipeFrameAligned) {
+  SetUpForFrameAlignedDispatch();
+  SimulateHighFrequencyInput(
+      "HighFrequencyTouchSwipeFrameAligned ",
+      BuildTouchSequence(kHighFrequencySteps, kDefaultOrigin,
+                         kDefaultDistance),
+      kTouchscreenEventsPerFrame,
+      kDefaultIterations);
+}
+
 }  // namespace content
@@ -179,6 +179,22 @@ class InputRouterImplTest : public testing::Test {
     SetUp();
   }
 
+  void SetUpForFrameAlignedDispatch() {
+    config_.frame_aligned_dispatch = true;
+    TearDown();
+    SetUp();
+  }
+
+  void SimulateVSync() {
+    input_router_->OnFrame();
+  }
+
+  WebInputEvent::Type GetSentEventTypeAt(size_t index) {
+    const WebInputEvent* event =
+        GetInputEventFromMessage(*process_->sink().GetMessageAt(index));
+    return event ? event->type : WebInputEvent::Undefined;
+  }
+
   void SimulateKeyboardEvent(WebInputEvent::Type type, bool is_shortcut) {
     WebKeyboardEvent event = SyntheticWebKeyboardEventBuilder::Build(type);
     NativeWebKeyboardEvent native_event;
@@ -1691,4 +1707,75 @@ TEST_F(InputRouterImplTest, OverscrollDispatch) {
             client_overscroll.current_fling_velocity);
 }
 
+// Continuous events are held until vsync, and coalesce meanwhile.
+TEST_F(InputRouterImplTest, FrameAlignedDispatchHoldsContinuousEvents) {
+  SetUpForFrameAlignedDispatch();
+
+  SimulateMouseEvent(WebInputEvent::MouseMove, 1, 1);
+  SimulateWheelEvent(0, -5, 0, false);
+  EXPECT_EQ(0U, GetSentMessageCountAndResetSink());
+  EXPECT_TRUE(HasPendingEvents());
+
+  // Both go at the next frame, as do later events only once acked.
+  SimulateVSync();
+  ASSERT_EQ(2U, process_->sink().message_count());
+  EXPECT_EQ(WebInputEvent::MouseMove, GetSentEventTypeAt(0));
+  EXPECT_EQ(WebInputEvent::MouseWheel, GetSentEventTypeAt(1));
+  GetSentMessageCountAndResetSink();
+
+  SimulateMouseEvent(WebInputEvent::MouseMove, 2, 2);
+  SimulateMouseEvent(WebInputEvent::MouseMove, 3, 3);
+  SimulateWheelEvent(0, -5, 0, false);
+  SimulateWheelEvent(0, -5, 0, false);
+  SimulateVSync();
+  EXPECT_EQ(0U, GetSentMessageCountAndResetSink());
+
+  SendInputEventACK(WebInputEvent::MouseMove,
+                    INPUT_EVENT_ACK_STATE_CONSUMED);
+  SendInputEventACK(WebInputEvent::MouseWheel,
+                    INPUT_EVENT_ACK_STATE_CONSUMED);
+  EXPECT_EQ(0U, GetSentMessageCountAndResetSink());
+  SimulateVSync();
+  EXPECT_EQ(2U, GetSentMessageCountAndResetSink());
+}
+
+// Other events go at once, after the events held before them.
+TEST_F(InputRouterImplTest, FrameAlignedDispatchKeepsEventOrder) {
+  SetUpForFrameAlignedDispatch();
+
+  SimulateMouseEvent(WebInputEvent::MouseMove, 1, 1);
+  EXPECT_EQ(0U, GetSentMessageCountAndResetSink());
+  SimulateMouseEvent(WebInputEvent::MouseDown, 1, 1);
+  ASSERT_EQ(2U, process_->sink().message_count());
+  EXPECT_EQ(WebInputEvent::MouseMove, GetSentEventTypeAt(0));
+  EXPECT_EQ(WebInputEvent::MouseDown, GetSentEventTypeAt(1));
+  GetSentMessageCountAndResetSink();
+
+  SimulateVSync();
+  EXPECT_EQ(0U, GetSentMessageCountAndResetSink());
+}
+
+TEST_F(InputRouterImplTest, FrameAlignedDispatchFollowsVSync) {
+  SetUpForFrameAlignedDispatch();
+  input_router_->OnVSyncParametersChanged(base::TimeTicks::HighResNow(),
+                                          TimeDelta::FromMilliseconds(2));
+
+  SimulateMouseEvent(WebInputEvent::MouseMove, 1, 1);
+  EXPECT_EQ(0U, GetSentMessageCountAndResetSink());
+  RunTasksAndWait(TimeDelta::FromMilliseconds(10));
+  EXPECT_EQ(1U, GetSentMessageCountAndResetSink());
+
+  // A flush completes once the held events have been sent and acked.
+  SimulateMouseEvent(WebInputEvent::MouseMove, 2, 2);
+  Flush();
+  EXPECT_EQ(0U, GetAndResetDidFlushCount());
+  SendInputEventACK(WebInputEvent::MouseMove,
+                    INPUT_EVENT_ACK_STATE_CONSUMED);
+  RunTasksAndWait(TimeDelta::FromMilliseconds(10));
+  EXPECT_EQ(1U, GetSentMessageCountAndResetSink());
+  SendInputEventACK(WebInputEvent::MouseMove,
+                    INPUT_EVENT_ACK_STATE_CONSUMED);
+  EXPECT_EQ(1U, GetAndResetDidFlushCount());
+}
+
 }  // namespace content
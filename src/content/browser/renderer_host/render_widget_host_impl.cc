@@ -1193,6 +1193,7 @@ void RenderWidgetHostImpl::OnSelectionBoundsChanged(
 
 void RenderWidgetHostImpl::UpdateVSyncParameters(base::TimeTicks timebase,
                                                  base::TimeDelta interval) {
+  input_router_->OnVSyncParametersChanged(timebase, interval);
   Send(new ViewMsg_UpdateVSyncParameters(GetRoutingID(), timebase, interval));
 }
 
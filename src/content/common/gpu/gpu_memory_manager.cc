@@ -5,6 +5,7 @@
 #include "content/common/gpu/gpu_memory_manager.h"
 
 #include <algorithm>
+#include <set>
 
 #include "base/bind.h"
 #include "base/command_line.h"
@@ -377,6 +378,31 @@ void GpuMemoryManager::GetVideoMemoryUsageStats(
         tracking_group->GetPid()].video_memory += tracking_group->GetSize();
   }
 
+  // Report each budget group's allocation as of the last Manage().
+  for (ClientStateList::const_iterator it = clients_visible_mru_.begin();
+       it != clients_visible_mru_.end();
+       ++it) {
+    const GpuMemoryManagerClientState* client_state = *it;
+    GPUVideoMemoryUsageStats::ProcessStats* process_stats =
+        &video_memory_usage_stats->process_map[
+            client_state->tracking_group_->GetPid()];
+    process_stats->budget += client_state->bytes_allocation_when_visible_;
+    process_stats->visible_client_count++;
+  }
+  ClientStateList clients = clients_nonvisible_mru_;
+  clients.insert(clients.end(),
+                 clients_nonsurface_.begin(),
+                 clients_nonsurface_.end());
+  for (ClientStateList::const_iterator it = clients.begin();
+       it != clients.end();
+       ++it) {
+    const GpuMemoryManagerClientState* client_state = *it;
+    if (client_state->hibernated_) {
+      video_memory_usage_stats->process_map[
+          client_state->tracking_group_->GetPid()].hibernated_client_count++;
+    }
+  }
+
   // Assign the total across all processes in the GPU process
   video_memory_usage_stats->process_map[
       base::GetCurrentProcId()].video_memory = GetCurrentUsage();
@@ -398,9 +424,15 @@ void GpuMemoryManager::Manage() {
   // Update the limit on unmanaged memory.
   UpdateUnmanagedMemoryLimits();
 
+  // Compute allocation when for all clients.
+  ComputeVisibleSurfacesAllocations();
+
+  // Distribute the remaining memory to visible clients.
+  DistributeRemainingMemoryToVisibleSurfaces();
+
   // Determine which clients are "hibernated" (which determines the
   // distribution of frontbuffers and memory among clients that don't have
-  // surfaces).
+  // surfaces). This depends on what the visible clients need.
   SetClientsHibernatedState();
 
   // Assign memory allocations to clients that have surfaces.
@@ -454,6 +486,59 @@ uint64 GpuMemoryManager::ComputeCap(
   return bytes_sum_limit / bytes_size;
 }
 
+GpuMemoryManager::AllocationLevels::AllocationLevels()
+    : bytes_minimum(0),
+      bytes_required(0),
+      bytes_nicetohave(0) {
+}
+
+// static
+std::vector<uint64> GpuMemoryManager::ShareBudget(
+    const std::vector<AllocationLevels>& levels, uint64 bytes_budget) {
+  uint64 bytes_minimum = 0;
+  uint64 bytes_required = 0;
+  uint64 bytes_nicetohave = 0;
+  for (size_t i = 0; i < levels.size(); ++i) {
+    bytes_minimum += levels[i].bytes_minimum;
+    bytes_required += levels[i].bytes_required;
+    bytes_nicetohave += levels[i].bytes_nicetohave;
+  }
+
+  // Determine which of the three levels we can satisfy, and split what is
+  // left above the level below it.
+  std::vector<uint64> allocations(levels.size());
+  if (bytes_minimum > bytes_budget) {
+    for (size_t i = 0; i < levels.size(); ++i)
+      allocations[i] = levels[i].bytes_minimum;
+  } else if (bytes_required > bytes_budget) {
+    std::vector<uint64> bytes_to_fit;
+    for (size_t i = 0; i < levels.size(); ++i)
+      bytes_to_fit.push_back(levels[i].bytes_required -
+                             levels[i].bytes_minimum);
+    uint64 bytes_above_minimum_cap =
+        ComputeCap(bytes_to_fit, bytes_budget - bytes_minimum);
+    for (size_t i = 0; i < levels.size(); ++i) {
+      allocations[i] = levels[i].bytes_minimum +
+                       std::min(bytes_to_fit[i], bytes_above_minimum_cap);
+    }
+  } else if (bytes_nicetohave > bytes_budget) {
+    std::vector<uint64> bytes_to_fit;
+    for (size_t i = 0; i < levels.size(); ++i)
+      bytes_to_fit.push_back(levels[i].bytes_nicetohave -
+                             levels[i].bytes_required);
+    uint64 bytes_above_required_cap =
+        ComputeCap(bytes_to_fit, bytes_budget - bytes_required);
+    for (size_t i = 0; i < levels.size(); ++i) {
+      allocations[i] = levels[i].bytes_required +
+                       std::min(bytes_to_fit[i], bytes_above_required_cap);
+    }
+  } else {
+    for (size_t i = 0; i < levels.size(); ++i)
+      allocations[i] = levels[i].bytes_nicetohave;
+  }
+  return allocations;
+}
+
 uint64 GpuMemoryManager::ComputeClientAllocationWhenVisible(
     GpuMemoryManagerClientState* client_state,
     uint64 bytes_above_required_cap,
@@ -485,17 +570,12 @@ uint64 GpuMemoryManager::ComputeClientAllocationWhenVisible(
 
 void GpuMemoryManager::ComputeVisibleSurfacesAllocations() {
   uint64 bytes_available_total = GetAvailableGpuMemory();
-  uint64 bytes_above_required_cap = std::numeric_limits<uint64>::max();
-  uint64 bytes_above_minimum_cap = std::numeric_limits<uint64>::max();
   uint64 bytes_overall_cap_visible = GetMaximumClientAllocation();
 
   // Compute memory usage at three levels
   // - painting everything that is nicetohave for visible clients
   // - painting only what that is visible
   // - giving every client the minimum allocation
-  uint64 bytes_nicetohave_visible = 0;
-  uint64 bytes_required_visible = 0;
-  uint64 bytes_minimum_visible = 0;
   for (ClientStateList::const_iterator it = clients_visible_mru_.begin();
        it != clients_visible_mru_.end();
        ++it) {
@@ -503,14 +583,14 @@ void GpuMemoryManager::ComputeVisibleSurfacesAllocations() {
     client_state->bytes_allocation_ideal_nicetohave_ =
         ComputeClientAllocationWhenVisible(
             client_state,
-            bytes_above_required_cap,
-            bytes_above_minimum_cap,
+            std::numeric_limits<uint64>::max(),
+            std::numeric_limits<uint64>::max(),
             bytes_overall_cap_visible);
     client_state->bytes_allocation_ideal_required_ =
         ComputeClientAllocationWhenVisible(
             client_state,
             0,
-            bytes_above_minimum_cap,
+            std::numeric_limits<uint64>::max(),
             bytes_overall_cap_visible);
     client_state->bytes_allocation_ideal_minimum_ =
         ComputeClientAllocationWhenVisible(
@@ -518,62 +598,86 @@ void GpuMemoryManager::ComputeVisibleSurfacesAllocations() {
             0,
             0,
             bytes_overall_cap_visible);
+  }
 
-    bytes_nicetohave_visible +=
-        client_state->bytes_allocation_ideal_nicetohave_;
-    bytes_required_visible +=
-        client_state->bytes_allocation_ideal_required_;
-    bytes_minimum_visible +=
-        client_state->bytes_allocation_ideal_minimum_;
-  }
-
-  // Determine which of those three points we can satisfy, and limit
-  // bytes_above_required_cap and bytes_above_minimum_cap to not go
-  // over the limit.
-  if (bytes_minimum_visible > bytes_available_total) {
-    bytes_above_required_cap = 0;
-    bytes_above_minimum_cap = 0;
-  } else if (bytes_required_visible > bytes_available_total) {
-    std::vector<uint64> bytes_to_fit;
-    for (ClientStateList::const_iterator it = clients_visible_mru_.begin();
-         it != clients_visible_mru_.end();
+  // The foreground client, the one most recently made visible, comes first
+  // and gets up to its nicetohave level from the whole budget, so that the
+  // tab being looked at is not starved by other visible surfaces.
+  ClientStateList clients_background = clients_visible_mru_;
+  uint64 bytes_available_background = bytes_available_total;
+  if (!clients_background.empty()) {
+    GpuMemoryManagerClientState* foreground = clients_background.front();
+    clients_background.pop_front();
+    foreground->bytes_allocation_when_visible_ = std::max(
+        foreground->bytes_allocation_ideal_minimum_,
+        std::min(foreground->bytes_allocation_ideal_nicetohave_,
+                 bytes_available_total));
+    bytes_available_background -= std::min(
+        foreground->bytes_allocation_when_visible_, bytes_available_total);
+  }
+
+  // The rest of the budget is split among budget groups, one per renderer
+  // process (and so one per principal), so that a process with many visible
+  // surfaces does not crowd out the others, and then among the clients of
+  // each group.
+  typedef std::map<base::ProcessId, ClientStateList> BudgetGroupMap;
+  BudgetGroupMap budget_groups;
+  for (ClientStateList::const_iterator it = clients_background.begin();
+       it != clients_background.end();
+       ++it) {
+    GpuMemoryManagerClientState* client_state = *it;
+    budget_groups[client_state->tracking_group_->GetPid()].push_back(
+        client_state);
+  }
+
+  std::vector<AllocationLevels> group_levels;
+  for (BudgetGroupMap::const_iterator group = budget_groups.begin();
+       group != budget_groups.end();
+       ++group) {
+    AllocationLevels levels;
+    for (ClientStateList::const_iterator it = group->second.begin();
+         it != group->second.end();
          ++it) {
-      GpuMemoryManagerClientState* client_state = *it;
-      bytes_to_fit.push_back(client_state->bytes_allocation_ideal_required_ -
-                             client_state->bytes_allocation_ideal_minimum_);
+      levels.bytes_minimum += (*it)->bytes_allocation_ideal_minimum_;
+      levels.bytes_required += (*it)->bytes_allocation_ideal_required_;
+      levels.bytes_nicetohave += (*it)->bytes_allocation_ideal_nicetohave_;
     }
-    bytes_above_required_cap = 0;
-    bytes_above_minimum_cap = ComputeCap(
-        bytes_to_fit, bytes_available_total - bytes_minimum_visible);
-  } else if (bytes_nicetohave_visible > bytes_available_total) {
-    std::vector<uint64> bytes_to_fit;
-    for (ClientStateList::const_iterator it = clients_visible_mru_.begin();
-         it != clients_visible_mru_.end();
+    group_levels.push_back(levels);
+  }
+  std::vector<uint64> group_budgets =
+      ShareBudget(group_levels, bytes_available_background);
+
+  size_t group_index = 0;
+  for (BudgetGroupMap::const_iterator group = budget_groups.begin();
+       group != budget_groups.end();
+       ++group, ++group_index) {
+    std::vector<AllocationLevels> client_levels;
+    for (ClientStateList::const_iterator it = group->second.begin();
+         it != group->second.end();
          ++it) {
-      GpuMemoryManagerClientState* client_state = *it;
-      bytes_to_fit.push_back(client_state->bytes_allocation_ideal_nicetohave_ -
-                             client_state->bytes_allocation_ideal_required_);
+      AllocationLevels levels;
+      levels.bytes_minimum = (*it)->bytes_allocation_ideal_minimum_;
+      levels.bytes_required = (*it)->bytes_allocation_ideal_required_;
+      levels.bytes_nicetohave = (*it)->bytes_allocation_ideal_nicetohave_;
+      client_levels.push_back(levels);
+    }
+    std::vector<uint64> client_budgets =
+        ShareBudget(client_levels, group_budgets[group_index]);
+    size_t client_index = 0;
+    for (ClientStateList::const_iterator it = group->second.begin();
+         it != group->second.end();
+         ++it, ++client_index) {
+      (*it)->bytes_allocation_when_visible_ = client_budgets[client_index];
     }
-    bytes_above_required_cap = ComputeCap(
-        bytes_to_fit, bytes_available_total - bytes_required_visible);
-    bytes_above_minimum_cap = std::numeric_limits<uint64>::max();
   }
 
-  // Given those computed limits, set the actual memory allocations for the
-  // visible clients, tracking the largest allocation and the total allocation
-  // for future use.
+  // Track the largest allocation and the total allocation for future use.
   uint64 bytes_allocated_visible = 0;
   uint64 bytes_allocated_max_client_allocation = 0;
   for (ClientStateList::const_iterator it = clients_visible_mru_.begin();
        it != clients_visible_mru_.end();
        ++it) {
     GpuMemoryManagerClientState* client_state = *it;
-    client_state->bytes_allocation_when_visible_ =
-        ComputeClientAllocationWhenVisible(
-            client_state,
-            bytes_above_required_cap,
-            bytes_above_minimum_cap,
-            bytes_overall_cap_visible);
     bytes_allocated_visible += client_state->bytes_allocation_when_visible_;
     bytes_allocated_max_client_allocation = std::max(
         bytes_allocated_max_client_allocation,
@@ -583,7 +687,8 @@ void GpuMemoryManager::ComputeVisibleSurfacesAllocations() {
   // Set the limit for nonvisible clients for when they become visible.
   // Use the same formula, with a lowered overall cap in case any of the
   // currently-nonvisible clients are much more resource-intensive than any
-  // of the existing clients.
+  // of the existing clients. Becoming visible makes a client the foreground
+  // one, so its limit is not held to its group's share.
   uint64 bytes_overall_cap_nonvisible = bytes_allocated_max_client_allocation;
   if (bytes_available_total > bytes_allocated_visible) {
     bytes_overall_cap_nonvisible +=
@@ -598,8 +703,8 @@ void GpuMemoryManager::ComputeVisibleSurfacesAllocations() {
     client_state->bytes_allocation_when_visible_ =
         ComputeClientAllocationWhenVisible(
             client_state,
-            bytes_above_required_cap,
-            bytes_above_minimum_cap,
+            std::numeric_limits<uint64>::max(),
+            std::numeric_limits<uint64>::max(),
             bytes_overall_cap_nonvisible);
   }
 }
@@ -643,13 +748,7 @@ void GpuMemoryManager::DistributeRemainingMemoryToVisibleSurfaces() {
 }
 
 void GpuMemoryManager::AssignSurfacesAllocations() {
-  // Compute allocation when for all clients.
-  ComputeVisibleSurfacesAllocations();
-
-  // Distribute the remaining memory to visible clients.
-  DistributeRemainingMemoryToVisibleSurfaces();
-
-  // Send that allocation to the clients.
+  // Send the allocations to the clients.
   ClientStateList clients = clients_visible_mru_;
   clients.insert(clients.end(),
                  clients_nonvisible_mru_.begin(),
@@ -697,11 +796,14 @@ void GpuMemoryManager::AssignNonSurfacesAllocations() {
 }
 
 void GpuMemoryManager::SetClientsHibernatedState() const {
-  // Re-set all tracking groups as being hibernated.
+  // Re-set all tracking groups as being hibernated, remembering the size of
+  // those that were not.
   for (TrackingGroupMap::const_iterator it = tracking_groups_.begin();
        it != tracking_groups_.end();
        ++it) {
     GpuMemoryTrackingGroup* tracking_group = it->second;
+    if (!tracking_group->hibernated_)
+      tracking_group->size_before_hibernation_ = tracking_group->GetSize();
     tracking_group->hibernated_ = true;
   }
   // All clients with surfaces that are visible are non-hibernated.
@@ -715,18 +817,45 @@ void GpuMemoryManager::SetClientsHibernatedState() const {
     non_hibernated_clients++;
   }
   // Then an additional few clients with surfaces are non-hibernated too, up to
-  // a fixed limit.
+  // a fixed limit, and only while the memory their tracking groups hold fits
+  // in what the visible clients leave at their required level. Past that,
+  // the least recently used are hibernated, which discards their resources
+  // before visible content is starved. A hibernated group is counted at its
+  // size from before hibernation, as the memory it freed is what waking it up
+  // would take back; counting what it holds now would wake it up again on the
+  // next Manage.
+  uint64 bytes_required_visible = 0;
+  std::set<GpuMemoryTrackingGroup*> counted_tracking_groups;
+  for (ClientStateList::const_iterator it = clients_visible_mru_.begin();
+       it != clients_visible_mru_.end();
+       ++it) {
+    GpuMemoryManagerClientState* client_state = *it;
+    bytes_required_visible += client_state->bytes_allocation_ideal_required_;
+    counted_tracking_groups.insert(client_state->tracking_group_);
+  }
+  const uint64 bytes_available_total = GetAvailableGpuMemory();
+  const uint64 bytes_nonvisible_limit =
+      bytes_available_total > bytes_required_visible ?
+          bytes_available_total - bytes_required_visible : 0;
+  uint64 bytes_nonvisible = 0;
   for (ClientStateList::const_iterator it = clients_nonvisible_mru_.begin();
        it != clients_nonvisible_mru_.end();
        ++it) {
     GpuMemoryManagerClientState* client_state = *it;
     if (non_hibernated_clients < max_surfaces_with_frontbuffer_soft_limit_) {
-      client_state->hibernated_ = false;
-      client_state->tracking_group_->hibernated_ = false;
-      non_hibernated_clients++;
-    } else {
-      client_state->hibernated_ = true;
+      GpuMemoryTrackingGroup* tracking_group = client_state->tracking_group_;
+      if (counted_tracking_groups.insert(tracking_group).second) {
+        bytes_nonvisible += std::max(tracking_group->GetSize(),
+                                     tracking_group->size_before_hibernation_);
+      }
+      if (bytes_nonvisible <= bytes_nonvisible_limit) {
+        client_state->hibernated_ = false;
+        client_state->tracking_group_->hibernated_ = false;
+        non_hibernated_clients++;
+        continue;
+      }
     }
+    client_state->hibernated_ = true;
   }
   // Clients that don't have surfaces are non-hibernated if they are
   // in a GL share group with a non-hibernated surface.
@@ -7,6 +7,7 @@
 
 #include <list>
 #include <map>
+#include <vector>
 
 #include "base/basictypes.h"
 #include "base/cancelable_callback.h"
@@ -107,12 +108,28 @@ class CONTENT_EXPORT GpuMemoryManager :
                            UnmanagedTracking);
   FRIEND_TEST_ALL_PREFIXES(GpuMemoryManagerTest,
                            DefaultAllocation);
+  FRIEND_TEST_ALL_PREFIXES(GpuMemoryManagerTest,
+                           ForegroundClientHasPriority);
+  FRIEND_TEST_ALL_PREFIXES(GpuMemoryManagerTest,
+                           BudgetGroupsShareFairly);
+  FRIEND_TEST_ALL_PREFIXES(GpuMemoryManagerTest,
+                           HiddenClientsDiscardedUnderPressure);
 
   typedef std::map<gpu::gles2::MemoryTracker*, GpuMemoryTrackingGroup*>
       TrackingGroupMap;
 
   typedef std::list<GpuMemoryManagerClientState*> ClientStateList;
 
+  // The allocations of a client, or of a budget group of clients, at the
+  // three performance levels.
+  struct AllocationLevels {
+    AllocationLevels();
+
+    uint64 bytes_minimum;
+    uint64 bytes_required;
+    uint64 bytes_nicetohave;
+  };
+
   void Manage();
   void SetClientsHibernatedState() const;
   void AssignSurfacesAllocations();
@@ -122,7 +139,16 @@ class CONTENT_EXPORT GpuMemoryManager :
   // sum_i min(bytes[i], cap) <= bytes_sum_limit
   static uint64 ComputeCap(std::vector<uint64> bytes, uint64 bytes_sum_limit);
 
-  // Compute the allocation for clients when visible and not visible.
+  // Split |bytes_budget| among |levels|: each gets its minimum level, then its
+  // required level, then its nicetohave level, as far as the budget goes. The
+  // first level that does not fit for all is split with ComputeCap.
+  static std::vector<uint64> ShareBudget(
+      const std::vector<AllocationLevels>& levels, uint64 bytes_budget);
+
+  // Compute the allocation for clients when visible and not visible. The
+  // foreground client is served first, then the rest of the budget is split
+  // among budget groups (one per renderer process), then among the clients
+  // of each group.
   void ComputeVisibleSurfacesAllocations();
   void DistributeRemainingMemoryToVisibleSurfaces();
 
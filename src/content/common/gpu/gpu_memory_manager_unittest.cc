@@ -97,8 +97,11 @@ class FakeClient : public GpuMemoryManagerClient {
     client_state_.reset(memmgr_->CreateClientState(this, false, true));
   }
 
-  // This will create a client with a surface
-  FakeClient(GpuMemoryManager* memmgr, int32 surface_id, bool visible)
+  // This will create a client with a surface, in the renderer process |pid|
+  FakeClient(GpuMemoryManager* memmgr,
+             int32 surface_id,
+             bool visible,
+             base::ProcessId pid = 0)
       : memmgr_(memmgr),
         suggest_have_frontbuffer_(false),
         total_gpu_memory_(0),
@@ -106,7 +109,7 @@ class FakeClient : public GpuMemoryManagerClient {
         memory_tracker_(NULL) {
     memory_tracker_ = new FakeMemoryTracker();
     tracking_group_.reset(
-        memmgr_->CreateTrackingGroup(0, memory_tracker_.get()));
+        memmgr_->CreateTrackingGroup(pid, memory_tracker_.get()));
     client_state_.reset(
         memmgr_->CreateClientState(this, surface_id != 0, visible));
   }
@@ -276,9 +279,11 @@ TEST_F(GpuMemoryManagerTest, TestManageBasicFunctionality) {
 // according to visibility and last used time for stubs with surface.
 // Expect memory allocation to be shared according to share groups for stubs
 // without a surface.
+// Expect the stub most recently made visible to be served first.
 TEST_F(GpuMemoryManagerTest, TestManageChangingVisibility) {
   FakeClient stub1(&memmgr_, GenerateUniqueSurfaceId(), true),
-             stub2(&memmgr_, GenerateUniqueSurfaceId(), false);
+             stub2(&memmgr_, GenerateUniqueSurfaceId(), false),
+             stub6(&memmgr_, GenerateUniqueSurfaceId(), true);
 
   FakeClient stub3(&memmgr_, &stub1), stub4(&memmgr_, &stub2);
   FakeClient stub5(&memmgr_ , &stub2);
@@ -299,11 +304,26 @@ TEST_F(GpuMemoryManagerTest, TestManageChangingVisibility) {
   EXPECT_TRUE(IsAllocationBackgroundForSurfaceNo(stub3.allocation_));
   EXPECT_TRUE(IsAllocationForegroundForSurfaceNo(stub4.allocation_));
   EXPECT_TRUE(IsAllocationForegroundForSurfaceNo(stub5.allocation_));
+
+  // Showing stub1 again makes it the foreground stub, which gets its
+  // nicetohave level ahead of stub2 and stub6.
+  memmgr_.TestingSetAvailableGpuMemory(256);
+  memmgr_.TestingSetMinimumClientAllocation(8);
+  SetClientStats(&stub1, 48, 96);
+  SetClientStats(&stub2, 48, 96);
+  SetClientStats(&stub6, 48, 96);
+  stub1.SetVisible(true);
+
+  Manage();
+  EXPECT_EQ(128u, stub1.BytesWhenVisible());
+  EXPECT_EQ(64u, stub2.BytesWhenVisible());
+  EXPECT_EQ(64u, stub6.BytesWhenVisible());
 }
 
 // Test GpuMemoryManager::Manage functionality: Test more than threshold number
 // of visible stubs.
 // Expect all allocations to continue to have frontbuffer.
+// Expect the stub most recently made visible to be served first.
 TEST_F(GpuMemoryManagerTest, TestManageManyVisibleStubs) {
   FakeClient stub1(&memmgr_, GenerateUniqueSurfaceId(), true),
              stub2(&memmgr_, GenerateUniqueSurfaceId(), true),
@@ -321,6 +341,29 @@ TEST_F(GpuMemoryManagerTest, TestManageManyVisibleStubs) {
   EXPECT_TRUE(IsAllocationForegroundForSurfaceNo(stub5.allocation_));
   EXPECT_TRUE(IsAllocationForegroundForSurfaceNo(stub6.allocation_));
   EXPECT_TRUE(IsAllocationForegroundForSurfaceNo(stub7.allocation_));
+
+  // The nicetohave levels do not all fit. stub4 was made visible last and
+  // gets all of its own; the others split what is left.
+  memmgr_.TestingSetAvailableGpuMemory(256);
+  memmgr_.TestingSetMinimumClientAllocation(8);
+  SetClientStats(&stub1, 48, 96);
+  SetClientStats(&stub2, 48, 96);
+  SetClientStats(&stub3, 48, 96);
+  SetClientStats(&stub4, 48, 96);
+
+  Manage();
+  EXPECT_EQ(128u, stub4.BytesWhenVisible());
+  EXPECT_GT(stub4.BytesWhenVisible(), stub1.BytesWhenVisible());
+  EXPECT_GT(stub4.BytesWhenVisible(), stub2.BytesWhenVisible());
+  EXPECT_GT(stub4.BytesWhenVisible(), stub3.BytesWhenVisible());
+
+  stub1.SetVisible(false);
+  stub1.SetVisible(true);
+  Manage();
+  EXPECT_EQ(128u, stub1.BytesWhenVisible());
+  EXPECT_GT(stub1.BytesWhenVisible(), stub2.BytesWhenVisible());
+  EXPECT_GT(stub1.BytesWhenVisible(), stub3.BytesWhenVisible());
+  EXPECT_GT(stub1.BytesWhenVisible(), stub4.BytesWhenVisible());
 }
 
 // Test GpuMemoryManager::Manage functionality: Test more than threshold number
@@ -609,4 +652,113 @@ TEST_F(GpuMemoryManagerTest, DefaultAllocation) {
             memmgr_.GetDefaultClientAllocation());
 }
 
+// Test that the foreground client, the one most recently made visible, gets
+// its nicetohave level ahead of the other visible clients.
+TEST_F(GpuMemoryManagerTest, ForegroundClientHasPriority) {
+  memmgr_.TestingSetAvailableGpuMemory(256);
+  memmgr_.TestingSetMinimumClientAllocation(8);
+
+  FakeClient stub1(&memmgr_, GenerateUniqueSurfaceId(), true),
+             stub2(&memmgr_, GenerateUniqueSurfaceId(), true),
+             stub3(&memmgr_, GenerateUniqueSurfaceId(), true);
+  SetClientStats(&stub1, 48, 96);
+  SetClientStats(&stub2, 48, 96);
+  SetClientStats(&stub3, 48, 96);
+
+  // The three nicetohave levels do not fit. stub3 was made visible last and
+  // gets all of its own; the others split what is left.
+  Manage();
+  EXPECT_EQ(128u, stub3.BytesWhenVisible());
+  EXPECT_EQ(64u, stub1.BytesWhenVisible());
+  EXPECT_EQ(64u, stub2.BytesWhenVisible());
+
+  stub1.SetVisible(false);
+  stub1.SetVisible(true);
+  Manage();
+  EXPECT_EQ(128u, stub1.BytesWhenVisible());
+  EXPECT_EQ(64u, stub2.BytesWhenVisible());
+  EXPECT_EQ(64u, stub3.BytesWhenVisible());
+}
+
+// Test that visible clients in the background are budgeted per renderer
+// process first, so that a process with many surfaces does not take the
+// memory of the others.
+TEST_F(GpuMemoryManagerTest, BudgetGroupsShareFairly) {
+  memmgr_.TestingSetAvailableGpuMemory(256);
+  memmgr_.TestingSetMinimumClientAllocation(8);
+
+  FakeClient stub2a(&memmgr_, GenerateUniqueSurfaceId(), true, 2),
+             stub2b(&memmgr_, GenerateUniqueSurfaceId(), true, 2),
+             stub2c(&memmgr_, GenerateUniqueSurfaceId(), true, 2),
+             stub3(&memmgr_, GenerateUniqueSurfaceId(), true, 3),
+             stub1(&memmgr_, GenerateUniqueSurfaceId(), true, 1);
+  SetClientStats(&stub1, 48, 96);
+  SetClientStats(&stub2a, 48, 96);
+  SetClientStats(&stub2b, 48, 96);
+  SetClientStats(&stub2c, 48, 96);
+  SetClientStats(&stub3, 48, 96);
+
+  Manage();
+  EXPECT_EQ(128u, stub1.BytesWhenVisible());
+  EXPECT_GT(stub3.BytesWhenVisible(), stub2a.BytesWhenVisible());
+  EXPECT_GT(stub3.BytesWhenVisible(), stub2b.BytesWhenVisible());
+  EXPECT_GT(stub3.BytesWhenVisible(), stub2c.BytesWhenVisible());
+  EXPECT_LE(stub1.BytesWhenVisible() + stub2a.BytesWhenVisible() +
+                stub2b.BytesWhenVisible() + stub2c.BytesWhenVisible() +
+                stub3.BytesWhenVisible(),
+            256u);
+
+  GPUVideoMemoryUsageStats stats;
+  memmgr_.GetVideoMemoryUsageStats(&stats);
+  EXPECT_EQ(128u, stats.process_map[1].budget);
+  EXPECT_EQ(1u, stats.process_map[1].visible_client_count);
+  EXPECT_EQ(stub2a.BytesWhenVisible() + stub2b.BytesWhenVisible() +
+                stub2c.BytesWhenVisible(),
+            stats.process_map[2].budget);
+  EXPECT_EQ(3u, stats.process_map[2].visible_client_count);
+  EXPECT_EQ(0u, stats.process_map[2].hibernated_client_count);
+}
+
+// Test that hidden clients are hibernated, dropping their frontbuffers and
+// their offscreen contexts' memory, once what they hold no longer fits next to
+// what the visible clients require.
+TEST_F(GpuMemoryManagerTest, HiddenClientsDiscardedUnderPressure) {
+  memmgr_.TestingSetAvailableGpuMemory(64);
+  memmgr_.TestingSetMinimumClientAllocation(8);
+
+  FakeClient stub1(&memmgr_, GenerateUniqueSurfaceId(), true, 1),
+             stub2(&memmgr_, GenerateUniqueSurfaceId(), false, 2);
+  FakeClient stub3(&memmgr_, &stub2);
+  SetClientStats(&stub1, 32, 32);
+
+  Manage();
+  EXPECT_TRUE(stub2.suggest_have_frontbuffer_);
+  EXPECT_EQ(GetMinimumClientAllocation(), stub3.BytesWhenVisible());
+
+  memmgr_.TrackMemoryAllocatedChange(
+      stub2.tracking_group_.get(),
+      0,
+      40,
+      gpu::gles2::MemoryTracker::kManaged);
+  Manage();
+  EXPECT_TRUE(stub1.suggest_have_frontbuffer_);
+  EXPECT_FALSE(stub2.suggest_have_frontbuffer_);
+  EXPECT_EQ(0u, stub3.BytesWhenVisible());
+
+  GPUVideoMemoryUsageStats stats;
+  memmgr_.GetVideoMemoryUsageStats(&stats);
+  EXPECT_EQ(2u, stats.process_map[2].hibernated_client_count);
+
+  // Hibernation frees stub2's memory. It is still counted at its size from
+  // before, so it is not woken up only to be hibernated again.
+  memmgr_.TrackMemoryAllocatedChange(
+      stub2.tracking_group_.get(),
+      40,
+      0,
+      gpu::gles2::MemoryTracker::kManaged);
+  Manage();
+  EXPECT_FALSE(stub2.suggest_have_frontbuffer_);
+  EXPECT_EQ(0u, stub3.BytesWhenVisible());
+}
+
 }  // namespace content
@@ -15,6 +15,7 @@ GpuMemoryTrackingGroup::GpuMemoryTrackingGroup(
     : pid_(pid),
       size_(0),
       hibernated_(false),
+      size_before_hibernation_(0),
       memory_tracker_(memory_tracker),
       memory_manager_(memory_manager) {
 }
@@ -48,6 +48,11 @@ class CONTENT_EXPORT GpuMemoryTrackingGroup {
   // non-surface clients should be hibernated.
   bool hibernated_;
 
+  // The size of the group as of the last Manage that left it non-hibernated.
+  // Hibernation frees the group's memory, so this is what it would take back
+  // if it were woken up again.
+  uint64 size_before_hibernation_;
+
   gpu::gles2::MemoryTracker* memory_tracker_;
   GpuMemoryManager* memory_manager_;
 };
@@ -203,6 +203,9 @@ IPC_STRUCT_TRAITS_END()
 IPC_STRUCT_TRAITS_BEGIN(content::GPUVideoMemoryUsageStats::ProcessStats)
   IPC_STRUCT_TRAITS_MEMBER(video_memory)
   IPC_STRUCT_TRAITS_MEMBER(has_duplicates)
+  IPC_STRUCT_TRAITS_MEMBER(budget)
+  IPC_STRUCT_TRAITS_MEMBER(visible_client_count)
+  IPC_STRUCT_TRAITS_MEMBER(hibernated_client_count)
 IPC_STRUCT_TRAITS_END()
 
 IPC_STRUCT_TRAITS_BEGIN(content::GPUVideoMemoryUsageStats)
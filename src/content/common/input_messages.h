@@ -100,6 +100,9 @@ IPC_STRUCT_BEGIN(InputHostMsg_HandleInputEvent_ACK_Params)
   IPC_STRUCT_MEMBER(blink::WebInputEvent::Type, type)
   IPC_STRUCT_MEMBER(content::InputEventAckState, state)
   IPC_STRUCT_MEMBER(ui::LatencyInfo, latency)
+  // True if the compositor thread handled the event without involving the
+  // renderer's main thread.
+  IPC_STRUCT_MEMBER(bool, handled_on_compositor_thread)
   // TODO(jdduke): Use Optional<T> type to avoid heap alloc, crbug.com/375002.
   IPC_STRUCT_MEMBER(scoped_ptr<content::DidOverscrollParams>, overscroll)
 IPC_STRUCT_END()
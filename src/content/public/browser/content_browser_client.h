@@ -543,6 +543,11 @@ class CONTENT_EXPORT ContentBrowserClient {
   // else we should do with the file.
   virtual std::string GetDefaultDownloadName();
 
+  // Returns the directory of the GPU shader cache shared by every browser
+  // context, or an empty path to keep a shader cache per storage partition
+  // only. This can be called on any thread.
+  virtual base::FilePath GetSharedShaderCacheDirectory();
+
   // Notification that a pepper plugin has just been spawned. This allows the
   // embedder to add filters onto the host to implement interfaces.
   // This is called on the IO thread.
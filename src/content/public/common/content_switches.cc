@@ -402,6 +402,10 @@ const char kEnableFastTextAutosizing[]      = "enable-fast-text-autosizing";
 const char kEnableFixedPositionCreatesStackingContext[]
     = "enable-fixed-position-creates-stacking-context";
 
+// Send continuous input events (mouse moves, wheels, touch moves and scroll
+// and pinch updates) to the renderer at most once per frame, at vsync.
+const char kEnableFrameAlignedInput[]       = "enable-frame-aligned-input";
+
 // Enable Gesture Tap Highlight
 const char kEnableGestureTapHighlight[]     = "enable-gesture-tap-highlight";
 
@@ -16,7 +16,10 @@ GPUVideoMemoryUsageStats::~GPUVideoMemoryUsageStats() {
 
 GPUVideoMemoryUsageStats::ProcessStats::ProcessStats()
     : video_memory(0),
-      has_duplicates(false) {
+      has_duplicates(false),
+      budget(0),
+      visible_client_count(0),
+      hibernated_client_count(0) {
 }
 
 GPUVideoMemoryUsageStats::ProcessStats::~ProcessStats() {
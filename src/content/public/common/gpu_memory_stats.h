@@ -31,6 +31,16 @@ struct CONTENT_EXPORT GPUVideoMemoryUsageStats {
     // it is counting other processes' resources (e.g, the GPU process has
     // duplicate set to true because it is the aggregate of all processes)
     bool has_duplicates;
+
+    // The bytes the memory manager allocated to this process' visible
+    // surfaces in its last pass. Each renderer process is a budget group.
+    size_t budget;
+
+    // The number of this process' surfaces that are visible, and the number
+    // of its surfaces and offscreen contexts that were hibernated, which
+    // discards their resources.
+    uint32 visible_client_count;
+    uint32 hibernated_client_count;
   };
   typedef std::map<base::ProcessId, ProcessStats> ProcessMap;
 
@@ -195,6 +195,7 @@ void InputEventFilter::ForwardToHandler(const IPC::Message& message) {
   ack.type = event->type;
   ack.state = ack_state;
   ack.latency = latency_info;
+  ack.handled_on_compositor_thread = true;
   ack.overscroll = overscroll_params.Pass();
   SendMessage(scoped_ptr<IPC::Message>(
       new InputHostMsg_HandleInputEvent_ACK(routing_id, ack)));
@@ -29,6 +29,7 @@ class ActiveLoader {
   bool deferred() { return deferred_; }
 
  private:
+  friend class BufferedDataSourcePerfTest;
   friend class BufferedDataSourceTest;
 
   scoped_ptr<blink::WebURLLoader> loader_;
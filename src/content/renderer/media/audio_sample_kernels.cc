@@ -0,0 +1,276 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "content/renderer/media/audio_sample_kernels.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "base/cpu.h"
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "content/renderer/media/audio_sample_kernels_testing.h"
+#include "media/base/audio_bus.h"
+
+#if defined(AUDIO_SAMPLE_KERNELS_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace content {
+namespace audio_sample_kernels {
+
+namespace {
+
+// The scales media::AudioBus uses for 16-bit samples, which differ for
+// negative and positive samples so that both ends of the int16 range map to
+// -1.0 and 1.0.
+const float kNegativeToFloatScale = 1.0f / 32768;
+const float kPositiveToFloatScale = 1.0f / kint16max;
+const float kNegativeToInt16Scale = 32768;
+const float kPositiveToInt16Scale = kint16max;
+
+inline float ToFloatSample(int16 v) {
+  return v * (v < 0 ? kNegativeToFloatScale : kPositiveToFloatScale);
+}
+
+inline int16 ToInt16Sample(float v) {
+  if (v < 0) {
+    return v <= -1 ? kint16min :
+        static_cast<int16>(v * kNegativeToInt16Scale);
+  }
+  return v >= 1 ? kint16max : static_cast<int16>(v * kPositiveToInt16Scale);
+}
+
+// The implementations the CPU supports.
+struct Kernels {
+  Kernels()
+      : max_abs(&MaxAbs_C),
+        int16_to_float(&Int16ToFloat_C),
+        float_to_int16(&FloatToInt16_C),
+        deinterleave_stereo(&DeinterleaveStereo_C),
+        interleave_stereo(&InterleaveStereo_C) {
+#if defined(AUDIO_SAMPLE_KERNELS_SSE2)
+    if (base::CPU().has_sse2()) {
+      max_abs = &MaxAbs_SSE2;
+      int16_to_float = &Int16ToFloat_SSE2;
+      float_to_int16 = &FloatToInt16_SSE2;
+      deinterleave_stereo = &DeinterleaveStereo_SSE2;
+      interleave_stereo = &InterleaveStereo_SSE2;
+    }
+#endif
+  }
+
+  int (*max_abs)(const int16*, int);
+  void (*int16_to_float)(const int16*, int, float*);
+  void (*float_to_int16)(const float*, int, int16*);
+  void (*deinterleave_stereo)(const int16*, int, float*, float*);
+  void (*interleave_stereo)(const float*, const float*, int, int16*);
+};
+
+base::LazyInstance<Kernels>::Leaky g_kernels = LAZY_INSTANCE_INITIALIZER;
+
+#if defined(AUDIO_SAMPLE_KERNELS_SSE2)
+
+// Returns |negative| in the lanes where |v| is negative and |positive| in the
+// others.
+inline __m128 SelectBySign(__m128 v, __m128 negative, __m128 positive) {
+  const __m128 mask = _mm_cmplt_ps(v, _mm_setzero_ps());
+  return _mm_or_ps(_mm_and_ps(mask, negative), _mm_andnot_ps(mask, positive));
+}
+
+// Sign-extends the low or high four int16s of |v| to int32s.
+inline __m128i UnpackLow(__m128i v) {
+  return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+}
+
+inline __m128i UnpackHigh(__m128i v) {
+  return _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+}
+
+// Vector versions of ToFloatSample() and ToInt16Sample(), which leave the
+// int16 samples in int32 lanes.
+inline __m128 ToFloatSamples(__m128i v) {
+  const __m128 f = _mm_cvtepi32_ps(v);
+  return _mm_mul_ps(f, SelectBySign(f, _mm_set1_ps(kNegativeToFloatScale),
+                                    _mm_set1_ps(kPositiveToFloatScale)));
+}
+
+inline __m128i ToInt16Samples(__m128 v) {
+  v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+  return _mm_cvttps_epi32(
+      _mm_mul_ps(v, SelectBySign(v, _mm_set1_ps(kNegativeToInt16Scale),
+                                 _mm_set1_ps(kPositiveToInt16Scale))));
+}
+
+#endif  // defined(AUDIO_SAMPLE_KERNELS_SSE2)
+
+}  // namespace
+
+int MaxAbs(const int16* src, int length) {
+  return g_kernels.Get().max_abs(src, length);
+}
+
+void Int16ToFloat(const int16* src, int length, float* dest) {
+  g_kernels.Get().int16_to_float(src, length, dest);
+}
+
+void FloatToInt16(const float* src, int length, int16* dest) {
+  g_kernels.Get().float_to_int16(src, length, dest);
+}
+
+void FromInterleaved(const int16* src, int frames, media::AudioBus* dest) {
+  DCHECK_LE(frames, dest->frames());
+  const Kernels& kernels = g_kernels.Get();
+  const int channels = dest->channels();
+  if (channels == 1) {
+    kernels.int16_to_float(src, frames, dest->channel(0));
+  } else if (channels == 2) {
+    kernels.deinterleave_stereo(src, frames, dest->channel(0),
+                                dest->channel(1));
+  } else {
+    for (int ch = 0; ch < channels; ++ch) {
+      float* channel_data = dest->channel(ch);
+      for (int i = 0, offset = ch; i < frames; ++i, offset += channels)
+        channel_data[i] = ToFloatSample(src[offset]);
+    }
+  }
+  dest->ZeroFramesPartial(frames, dest->frames() - frames);
+}
+
+void ToInterleaved(const media::AudioBus* src, int frames, int16* dest) {
+  DCHECK_LE(frames, src->frames());
+  const Kernels& kernels = g_kernels.Get();
+  const int channels = src->channels();
+  if (channels == 1) {
+    kernels.float_to_int16(src->channel(0), frames, dest);
+  } else if (channels == 2) {
+    kernels.interleave_stereo(src->channel(0), src->channel(1), frames, dest);
+  } else {
+    for (int ch = 0; ch < channels; ++ch) {
+      const float* channel_data = src->channel(ch);
+      for (int i = 0, offset = ch; i < frames; ++i, offset += channels)
+        dest[offset] = ToInt16Sample(channel_data[i]);
+    }
+  }
+}
+
+int MaxAbs_C(const int16* src, int length) {
+  int max = 0;
+  for (int i = 0; i < length; ++i)
+    max = std::max(max, std::abs(static_cast<int>(src[i])));
+  return max;
+}
+
+void Int16ToFloat_C(const int16* src, int length, float* dest) {
+  for (int i = 0; i < length; ++i)
+    dest[i] = ToFloatSample(src[i]);
+}
+
+void FloatToInt16_C(const float* src, int length, int16* dest) {
+  for (int i = 0; i < length; ++i)
+    dest[i] = ToInt16Sample(src[i]);
+}
+
+void DeinterleaveStereo_C(const int16* src, int frames,
+                          float* left, float* right) {
+  for (int i = 0; i < frames; ++i) {
+    left[i] = ToFloatSample(src[2 * i]);
+    right[i] = ToFloatSample(src[2 * i + 1]);
+  }
+}
+
+void InterleaveStereo_C(const float* left, const float* right,
+                        int frames, int16* dest) {
+  for (int i = 0; i < frames; ++i) {
+    dest[2 * i] = ToInt16Sample(left[i]);
+    dest[2 * i + 1] = ToInt16Sample(right[i]);
+  }
+}
+
+#if defined(AUDIO_SAMPLE_KERNELS_SSE2)
+
+int MaxAbs_SSE2(const int16* src, int length) {
+  const int rem = length % 8;
+  const int last_index = length - rem;
+  __m128i max = _mm_setzero_si128();
+  __m128i min = _mm_setzero_si128();
+  for (int i = 0; i < last_index; i += 8) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    max = _mm_max_epi16(max, v);
+    min = _mm_min_epi16(min, v);
+  }
+
+  // Negating the minimum overflows int16 for -32768, so finish in int.
+  int16 maxes[8];
+  int16 mins[8];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(maxes), max);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(mins), min);
+  int result = MaxAbs_C(src + last_index, rem);
+  for (int i = 0; i < 8; ++i)
+    result = std::max(result, std::max<int>(maxes[i], -mins[i]));
+  return result;
+}
+
+void Int16ToFloat_SSE2(const int16* src, int length, float* dest) {
+  const int rem = length % 8;
+  const int last_index = length - rem;
+  for (int i = 0; i < last_index; i += 8) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm_storeu_ps(dest + i, ToFloatSamples(UnpackLow(v)));
+    _mm_storeu_ps(dest + i + 4, ToFloatSamples(UnpackHigh(v)));
+  }
+  Int16ToFloat_C(src + last_index, rem, dest + last_index);
+}
+
+void FloatToInt16_SSE2(const float* src, int length, int16* dest) {
+  const int rem = length % 8;
+  const int last_index = length - rem;
+  for (int i = 0; i < last_index; i += 8) {
+    const __m128i low = ToInt16Samples(_mm_loadu_ps(src + i));
+    const __m128i high = ToInt16Samples(_mm_loadu_ps(src + i + 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                     _mm_packs_epi32(low, high));
+  }
+  FloatToInt16_C(src + last_index, rem, dest + last_index);
+}
+
+void DeinterleaveStereo_SSE2(const int16* src, int frames,
+                             float* left, float* right) {
+  const int rem = frames % 4;
+  const int last_index = frames - rem;
+  for (int i = 0; i < last_index; i += 4) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+    // L0 R0 L1 R1 and L2 R2 L3 R3.
+    const __m128 low = ToFloatSamples(UnpackLow(v));
+    const __m128 high = ToFloatSamples(UnpackHigh(v));
+    _mm_storeu_ps(left + i, _mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(right + i,
+                  _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  DeinterleaveStereo_C(src + 2 * last_index, rem, left + last_index,
+                       right + last_index);
+}
+
+void InterleaveStereo_SSE2(const float* left, const float* right,
+                           int frames, int16* dest) {
+  const int rem = frames % 4;
+  const int last_index = frames - rem;
+  for (int i = 0; i < last_index; i += 4) {
+    const __m128i l = ToInt16Samples(_mm_loadu_ps(left + i));
+    const __m128i r = ToInt16Samples(_mm_loadu_ps(right + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 2 * i),
+                     _mm_packs_epi32(_mm_unpacklo_epi32(l, r),
+                                     _mm_unpackhi_epi32(l, r)));
+  }
+  InterleaveStereo_C(left + last_index, right + last_index, rem,
+                     dest + 2 * last_index);
+}
+
+#endif  // defined(AUDIO_SAMPLE_KERNELS_SSE2)
+
+}  // namespace audio_sample_kernels
+}  // namespace content
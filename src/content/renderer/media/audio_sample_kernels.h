@@ -0,0 +1,47 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CONTENT_RENDERER_MEDIA_AUDIO_SAMPLE_KERNELS_H_
+#define CONTENT_RENDERER_MEDIA_AUDIO_SAMPLE_KERNELS_H_
+
+#include "base/basictypes.h"
+#include "content/common/content_export.h"
+
+namespace media {
+class AudioBus;
+}
+
+namespace content {
+
+// Kernels for the per-sample work of the MediaStream audio path: levels and
+// conversions between interleaved int16 and planar float.  Each one picks the
+// fastest implementation the CPU supports the first time it is used.  The
+// float and int16 conversions scale samples exactly as
+// media::AudioBus::FromInterleaved() and ToInterleaved() do, so that they
+// can be used in their place.
+namespace audio_sample_kernels {
+
+// Returns the largest absolute value of the |length| samples in |src|.  This
+// can be 32768, which does not fit in an int16.
+CONTENT_EXPORT int MaxAbs(const int16* src, int length);
+
+// Converts |length| samples between int16 and float in [-1.0, 1.0].  Floats
+// outside that range are clamped.
+CONTENT_EXPORT void Int16ToFloat(const int16* src, int length, float* dest);
+CONTENT_EXPORT void FloatToInt16(const float* src, int length, int16* dest);
+
+// Deinterleaves |frames| frames of |dest|->channels() channels from |src| into
+// |dest|, and zeroes any frames of |dest| after them.
+CONTENT_EXPORT void FromInterleaved(const int16* src, int frames,
+                                    media::AudioBus* dest);
+
+// Interleaves the first |frames| frames of |src| into |dest|.
+CONTENT_EXPORT void ToInterleaved(const media::AudioBus* src, int frames,
+                                  int16* dest);
+
+}  // namespace audio_sample_kernels
+
+}  // namespace content
+
+#endif  // CONTENT_RENDERER_MEDIA_AUDIO_SAMPLE_KERNELS_H_
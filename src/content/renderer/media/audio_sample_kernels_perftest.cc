@@ -0,0 +1,158 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "content/renderer/media/audio_sample_kernels.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/rand_util.h"
+#include "base/time/time.h"
+#include "content/renderer/media/audio_sample_kernels_testing.h"
+#include "media/base/audio_bus.h"
+#include "media/base/vector_math.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace content {
+namespace audio_sample_kernels {
+
+namespace {
+
+// A minute of 48 kHz stereo audio in 10 ms buffers.
+const int kBuffers = 6000;
+const int kLength = 2 * 480;
+
+std::vector<int16> RandomSamples(int length) {
+  std::vector<int16> samples(length);
+  for (int i = 0; i < length; ++i)
+    samples[i] = static_cast<int16>(base::RandInt(kint16min, kint16max));
+  return samples;
+}
+
+std::vector<float> RandomFloats(int length) {
+  std::vector<float> samples(length);
+  for (int i = 0; i < length; ++i)
+    samples[i] = static_cast<float>(base::RandDouble() * 2.2 - 1.1);
+  return samples;
+}
+
+base::TimeTicks ThreadNow() {
+  return base::TimeTicks::IsThreadNowSupported() ?
+      base::TimeTicks::ThreadNow() : base::TimeTicks::Now();
+}
+
+// Reports how long |kBuffers| runs of |kernel| take per buffer.
+void TimeKernel(const std::string& name,
+                const std::string& trace,
+                const base::Closure& kernel) {
+  const base::TimeTicks start = ThreadNow();
+  for (int i = 0; i < kBuffers; ++i)
+    kernel.Run();
+  const base::TimeDelta elapsed = ThreadNow() - start;
+  perf_test::PrintResult(name, "", trace,
+                         elapsed.InMicroseconds() /
+                             static_cast<double>(kBuffers),
+                         "us/buffer", true);
+}
+
+}  // namespace
+
+// Times each kernel in C and in the implementation picked for this CPU.
+TEST(AudioSampleKernelsPerfTest, Kernels) {
+  const std::vector<int16> samples(RandomSamples(kLength));
+  const std::vector<float> floats(RandomFloats(kLength));
+  std::vector<float> float_output(kLength);
+  std::vector<int16> int16_output(kLength);
+
+  TimeKernel("max_abs", "c", base::Bind(base::IgnoreResult(&MaxAbs_C),
+                                        &samples[0], kLength));
+  TimeKernel("max_abs", "dispatched",
+             base::Bind(base::IgnoreResult(&MaxAbs), &samples[0], kLength));
+  TimeKernel("int16_to_float", "c", base::Bind(&Int16ToFloat_C, &samples[0],
+                                               kLength, &float_output[0]));
+  TimeKernel("int16_to_float", "dispatched",
+             base::Bind(&Int16ToFloat, &samples[0], kLength,
+                        &float_output[0]));
+  TimeKernel("float_to_int16", "c", base::Bind(&FloatToInt16_C, &floats[0],
+                                               kLength, &int16_output[0]));
+  TimeKernel("float_to_int16", "dispatched",
+             base::Bind(&FloatToInt16, &floats[0], kLength,
+                        &int16_output[0]));
+}
+
+// Runs a conference-sized set of local tracks through the per-buffer work of
+// the MediaStream audio path: the level of each track, conversion to planar
+// float, mixing at each track's volume and conversion back for WebRTC.
+// Reports the thread CPU time taken with media::AudioBus and a scalar level,
+// and with the kernels.  Both mix with media::vector_math::FMAC().
+TEST(AudioSampleKernelsPerfTest, Pipeline) {
+  const int kTracks = 16;
+  const int kChannels = 2;
+  const int kFramesPer10Ms = 480;
+  const int kPipelineBuffers = 1000;
+
+  ScopedVector<std::vector<int16> > inputs;
+  for (int i = 0; i < kTracks; ++i) {
+    inputs.push_back(new std::vector<int16>(
+        RandomSamples(kChannels * kFramesPer10Ms)));
+  }
+  scoped_ptr<media::AudioBus> track_bus(
+      media::AudioBus::Create(kChannels, kFramesPer10Ms));
+  scoped_ptr<media::AudioBus> mix_bus(
+      media::AudioBus::Create(kChannels, kFramesPer10Ms));
+  std::vector<int16> output(kChannels * kFramesPer10Ms);
+  std::vector<int16> expected_output(output.size());
+  int level = 0;
+
+  base::TimeTicks start = ThreadNow();
+  for (int buffer = 0; buffer < kPipelineBuffers; ++buffer) {
+    mix_bus->Zero();
+    for (int track = 0; track < kTracks; ++track) {
+      const std::vector<int16>& input = *inputs[track];
+      level = std::max(level, MaxAbs_C(&input[0], input.size()));
+      track_bus->FromInterleaved(&input[0], kFramesPer10Ms,
+                                 sizeof(input[0]));
+      const float gain = 1.0f / (track + 1);
+      for (int ch = 0; ch < kChannels; ++ch) {
+        media::vector_math::FMAC(track_bus->channel(ch), gain, kFramesPer10Ms,
+                                 mix_bus->channel(ch));
+      }
+    }
+    mix_bus->ToInterleaved(kFramesPer10Ms, sizeof(expected_output[0]),
+                           &expected_output[0]);
+  }
+  const base::TimeDelta scalar_time = ThreadNow() - start;
+
+  start = ThreadNow();
+  for (int buffer = 0; buffer < kPipelineBuffers; ++buffer) {
+    mix_bus->Zero();
+    for (int track = 0; track < kTracks; ++track) {
+      const std::vector<int16>& input = *inputs[track];
+      level = std::max(level, MaxAbs(&input[0], input.size()));
+      FromInterleaved(&input[0], kFramesPer10Ms, track_bus.get());
+      const float gain = 1.0f / (track + 1);
+      for (int ch = 0; ch < kChannels; ++ch) {
+        media::vector_math::FMAC(track_bus->channel(ch), gain, kFramesPer10Ms,
+                                 mix_bus->channel(ch));
+      }
+    }
+    ToInterleaved(mix_bus.get(), kFramesPer10Ms, &output[0]);
+  }
+  const base::TimeDelta kernel_time = ThreadNow() - start;
+
+  EXPECT_TRUE(expected_output == output);
+  EXPECT_GT(level, 0);
+  perf_test::PrintResult("pipeline_cpu_time", "", "audio_bus",
+                         scalar_time.InMillisecondsF(), "ms", true);
+  perf_test::PrintResult("pipeline_cpu_time", "", "kernels",
+                         kernel_time.InMillisecondsF(), "ms", true);
+}
+
+}  // namespace audio_sample_kernels
+}  // namespace content
@@ -0,0 +1,49 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CONTENT_RENDERER_MEDIA_AUDIO_SAMPLE_KERNELS_TESTING_H_
+#define CONTENT_RENDERER_MEDIA_AUDIO_SAMPLE_KERNELS_TESTING_H_
+
+#include "base/basictypes.h"
+#include "build/build_config.h"
+#include "content/common/content_export.h"
+
+// SSE2 intrinsics are available to every x86 compiler that targets SSE2, and
+// always to MSVC, which leaves it to us to check the CPU at runtime.
+#if defined(ARCH_CPU_X86_FAMILY) && \
+    (defined(__SSE2__) || defined(COMPILER_MSVC))
+#define AUDIO_SAMPLE_KERNELS_SSE2
+#endif
+
+namespace content {
+namespace audio_sample_kernels {
+
+// The implementations behind the kernels in audio_sample_kernels.h.  Only
+// for tests and benchmarks; everything else should use the dispatched
+// kernels.
+CONTENT_EXPORT int MaxAbs_C(const int16* src, int length);
+CONTENT_EXPORT void Int16ToFloat_C(const int16* src, int length, float* dest);
+CONTENT_EXPORT void FloatToInt16_C(const float* src, int length, int16* dest);
+CONTENT_EXPORT void DeinterleaveStereo_C(const int16* src, int frames,
+                                         float* left, float* right);
+CONTENT_EXPORT void InterleaveStereo_C(const float* left, const float* right,
+                                       int frames, int16* dest);
+
+#if defined(AUDIO_SAMPLE_KERNELS_SSE2)
+CONTENT_EXPORT int MaxAbs_SSE2(const int16* src, int length);
+CONTENT_EXPORT void Int16ToFloat_SSE2(const int16* src, int length,
+                                      float* dest);
+CONTENT_EXPORT void FloatToInt16_SSE2(const float* src, int length,
+                                      int16* dest);
+CONTENT_EXPORT void DeinterleaveStereo_SSE2(const int16* src, int frames,
+                                            float* left, float* right);
+CONTENT_EXPORT void InterleaveStereo_SSE2(const float* left,
+                                          const float* right,
+                                          int frames, int16* dest);
+#endif
+
+}  // namespace audio_sample_kernels
+}  // namespace content
+
+#endif  // CONTENT_RENDERER_MEDIA_AUDIO_SAMPLE_KERNELS_TESTING_H_
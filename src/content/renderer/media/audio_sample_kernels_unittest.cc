@@ -0,0 +1,130 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "content/renderer/media/audio_sample_kernels.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/rand_util.h"
+#include "content/renderer/media/audio_sample_kernels_testing.h"
+#include "media/base/audio_bus.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace content {
+namespace audio_sample_kernels {
+
+namespace {
+
+// 10 ms of 48 kHz audio, plus a few samples so that the vector loops leave a
+// remainder.
+const int kFrames = 483;
+
+std::vector<int16> RandomSamples(int length) {
+  std::vector<int16> samples(length);
+  for (int i = 0; i < length; ++i)
+    samples[i] = static_cast<int16>(base::RandInt(kint16min, kint16max));
+  return samples;
+}
+
+// Samples a little beyond [-1.0, 1.0], so that clamping is exercised.
+std::vector<float> RandomFloats(int length) {
+  std::vector<float> samples(length);
+  for (int i = 0; i < length; ++i)
+    samples[i] = static_cast<float>(base::RandDouble() * 2.2 - 1.1);
+  return samples;
+}
+
+}  // namespace
+
+TEST(AudioSampleKernelsTest, MaxAbs) {
+  std::vector<int16> samples(RandomSamples(kFrames));
+  for (int length = 0; length <= kFrames; length += 7)
+    EXPECT_EQ(MaxAbs_C(&samples[0], length), MaxAbs(&samples[0], length));
+
+  // The absolute value of the smallest sample does not fit in an int16.
+  samples.assign(kFrames, 0);
+  samples[kFrames / 2] = kint16min;
+  EXPECT_EQ(32768, MaxAbs(&samples[0], kFrames));
+  samples[kFrames - 1] = kint16max;
+  samples[kFrames / 2] = -5;
+  EXPECT_EQ(kint16max, MaxAbs(&samples[0], kFrames));
+  EXPECT_EQ(0, MaxAbs(&samples[0], 0));
+}
+
+// The conversions must give the same results as media::AudioBus.
+TEST(AudioSampleKernelsTest, FromInterleavedMatchesAudioBus) {
+  for (int channels = 1; channels <= 3; ++channels) {
+    SCOPED_TRACE(channels);
+    std::vector<int16> samples(RandomSamples(channels * kFrames));
+    samples[0] = kint16min;
+    samples[1] = kint16max;
+    scoped_ptr<media::AudioBus> expected(
+        media::AudioBus::Create(channels, kFrames + 1));
+    scoped_ptr<media::AudioBus> actual(
+        media::AudioBus::Create(channels, kFrames + 1));
+    expected->FromInterleaved(&samples[0], kFrames, sizeof(samples[0]));
+    actual->channel(0)[kFrames] = 1.0f;
+    FromInterleaved(&samples[0], kFrames, actual.get());
+    for (int ch = 0; ch < channels; ++ch) {
+      for (int i = 0; i <= kFrames; ++i)
+        ASSERT_FLOAT_EQ(expected->channel(ch)[i], actual->channel(ch)[i]) << i;
+    }
+  }
+}
+
+TEST(AudioSampleKernelsTest, ToInterleavedMatchesAudioBus) {
+  for (int channels = 1; channels <= 3; ++channels) {
+    SCOPED_TRACE(channels);
+    scoped_ptr<media::AudioBus> bus(media::AudioBus::Create(channels,
+                                                            kFrames));
+    for (int ch = 0; ch < channels; ++ch) {
+      std::vector<float> floats(RandomFloats(kFrames));
+      floats[0] = -1.0f;
+      floats[1] = 1.0f;
+      std::copy(floats.begin(), floats.end(), bus->channel(ch));
+    }
+    std::vector<int16> expected(channels * kFrames);
+    std::vector<int16> actual(channels * kFrames);
+    bus->ToInterleaved(kFrames, sizeof(expected[0]), &expected[0]);
+    ToInterleaved(bus.get(), kFrames, &actual[0]);
+    EXPECT_TRUE(expected == actual);
+  }
+}
+
+#if defined(AUDIO_SAMPLE_KERNELS_SSE2)
+TEST(AudioSampleKernelsTest, SSE2MatchesC) {
+  const std::vector<int16> samples(RandomSamples(2 * kFrames));
+  const std::vector<float> floats(RandomFloats(2 * kFrames));
+  EXPECT_EQ(MaxAbs_C(&samples[0], kFrames), MaxAbs_SSE2(&samples[0], kFrames));
+
+  std::vector<float> expected_floats(2 * kFrames);
+  std::vector<float> actual_floats(2 * kFrames);
+  Int16ToFloat_C(&samples[0], kFrames, &expected_floats[0]);
+  Int16ToFloat_SSE2(&samples[0], kFrames, &actual_floats[0]);
+  EXPECT_TRUE(expected_floats == actual_floats);
+
+  DeinterleaveStereo_C(&samples[0], kFrames, &expected_floats[0],
+                       &expected_floats[kFrames]);
+  DeinterleaveStereo_SSE2(&samples[0], kFrames, &actual_floats[0],
+                          &actual_floats[kFrames]);
+  EXPECT_TRUE(expected_floats == actual_floats);
+
+  std::vector<int16> expected_samples(2 * kFrames);
+  std::vector<int16> actual_samples(2 * kFrames);
+  FloatToInt16_C(&floats[0], kFrames, &expected_samples[0]);
+  FloatToInt16_SSE2(&floats[0], kFrames, &actual_samples[0]);
+  EXPECT_TRUE(expected_samples == actual_samples);
+
+  InterleaveStereo_C(&floats[0], &floats[kFrames], kFrames,
+                     &expected_samples[0]);
+  InterleaveStereo_SSE2(&floats[0], &floats[kFrames], kFrames,
+                        &actual_samples[0]);
+  EXPECT_TRUE(expected_samples == actual_samples);
+}
+#endif  // defined(AUDIO_SAMPLE_KERNELS_SSE2)
+
+}  // namespace audio_sample_kernels
+}  // namespace content
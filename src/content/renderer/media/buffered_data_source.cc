@@ -7,7 +7,10 @@
 #include "base/bind.h"
 #include "base/callback_helpers.h"
 #include "base/message_loop/message_loop_proxy.h"
+#include "base/metrics/histogram.h"
+#include "base/strings/stringprintf.h"
 #include "content/public/common/url_constants.h"
+#include "content/renderer/media/media_block_cache.h"
 #include "media/base/media_log.h"
 #include "net/base/net_errors.h"
 
@@ -89,6 +92,9 @@ BufferedDataSource::BufferedDataSource(
       assume_fully_buffered_(false),
       streaming_(false),
       frame_(frame),
+      block_cache_(NULL),
+      bytes_read_(0),
+      bytes_read_from_block_cache_(0),
       intermediate_read_buffer_(new uint8[kInitialReadBufferSize]),
       intermediate_read_buffer_size_(kInitialReadBufferSize),
       render_loop_(render_loop),
@@ -105,7 +111,13 @@ BufferedDataSource::BufferedDataSource(
   DCHECK(!downloading_cb_.is_null());
 }
 
-BufferedDataSource::~BufferedDataSource() {}
+BufferedDataSource::~BufferedDataSource() {
+  if (block_cache_ && bytes_read_ > 0) {
+    UMA_HISTOGRAM_PERCENTAGE(
+        "Media.BlockCacheReadPercent",
+        static_cast<int>(bytes_read_from_block_cache_ * 100 / bytes_read_));
+  }
+}
 
 // A factory method to create BufferedResourceLoader using the read parameters.
 // This method can be overridden to inject mock BufferedResourceLoader object
@@ -118,14 +130,21 @@ BufferedResourceLoader* BufferedDataSource::CreateResourceLoader(
       BufferedResourceLoader::kReadThenDefer :
       BufferedResourceLoader::kCapacityDefer;
 
-  return new BufferedResourceLoader(url_,
-                                    cors_mode_,
-                                    first_byte_position,
-                                    last_byte_position,
-                                    strategy,
-                                    bitrate_,
-                                    playback_rate_,
-                                    media_log_.get());
+  BufferedResourceLoader* loader =
+      new BufferedResourceLoader(url_,
+                                 cors_mode_,
+                                 first_byte_position,
+                                 last_byte_position,
+                                 strategy,
+                                 bitrate_,
+                                 playback_rate_,
+                                 media_log_.get());
+  if (block_cache_) {
+    loader->set_data_received_cb(
+        base::Bind(&MediaBlockCache::Write, base::Unretained(block_cache_),
+                   block_cache_key_));
+  }
+  return loader;
 }
 
 void BufferedDataSource::Initialize(
@@ -138,6 +157,12 @@ void BufferedDataSource::Initialize(
   url_ = url;
   cors_mode_ = cors_mode;
 
+  // Responses may differ by CORS mode, so they are cached separately.
+  block_cache_key_ = base::StringPrintf("%d ", cors_mode_) + url_.spec();
+  // Keeps what the loaders download cached until this is stopped.
+  if (block_cache_)
+    block_cache_->SetReaderPosition(this, block_cache_key_, 0);
+
   init_cb_ = init_cb;
 
   if (url_.SchemeIs(url::kHttpScheme) || url_.SchemeIs(url::kHttpsScheme)) {
@@ -161,6 +186,12 @@ void BufferedDataSource::Initialize(
       frame_);
 }
 
+void BufferedDataSource::SetBlockCache(MediaBlockCache* block_cache) {
+  DCHECK(render_loop_->BelongsToCurrentThread());
+  DCHECK(!loader_.get());
+  block_cache_ = block_cache;
+}
+
 void BufferedDataSource::SetPreload(Preload preload) {
   DCHECK(render_loop_->BelongsToCurrentThread());
   preload_ = preload;
@@ -293,6 +324,8 @@ void BufferedDataSource::StopLoader() {
 
   if (loader_)
     loader_->Stop();
+  if (block_cache_)
+    block_cache_->RemoveReader(this);
 }
 
 void BufferedDataSource::SetBitrateTask(int bitrate) {
@@ -324,6 +357,17 @@ void BufferedDataSource::ReadInternal() {
     intermediate_read_buffer_.reset(new uint8[size]);
   }
 
+  if (block_cache_) {
+    block_cache_->SetReaderPosition(this, block_cache_key_, position);
+
+    // Prefer |loader_| for what it can serve, so that it keeps being drained
+    // and doesn't stall deferred with a full buffer.
+    if (!loader_->CanServeRead(position) &&
+        ReadFromBlockCache(position, size)) {
+      return;
+    }
+  }
+
   // Perform the actual read with BufferedResourceLoader.
   loader_->Read(position,
                 size,
@@ -358,6 +402,8 @@ void BufferedDataSource::StartCallback(
 
   if (success) {
     total_bytes_ = loader_->instance_size();
+    if (block_cache_)
+      block_cache_->SetValidator(block_cache_key_, loader_->cache_validator());
     streaming_ = !assume_fully_buffered_ &&
         (total_bytes_ == kPositionNotSpecified || !loader_->range_supported());
 
@@ -397,6 +443,9 @@ void BufferedDataSource::PartialReadStartCallback(
   DCHECK(loader_.get());
 
   if (status == BufferedResourceLoader::kOk) {
+    if (block_cache_)
+      block_cache_->SetValidator(block_cache_key_, loader_->cache_validator());
+
     // Once the request has started successfully, we can proceed with
     // reading from it.
     ReadInternal();
@@ -453,6 +502,7 @@ void BufferedDataSource::ReadCallback(
   }
 
   if (bytes_read > 0) {
+    bytes_read_ += bytes_read;
     memcpy(read_op_->data(), intermediate_read_buffer_.get(), bytes_read);
   } else if (bytes_read == 0 && total_bytes_ == kPositionNotSpecified) {
     // We've reached the end of the file and we didn't know the total size
@@ -537,4 +587,20 @@ void BufferedDataSource::UpdateDeferStrategy(bool paused) {
   loader_->UpdateDeferStrategy(BufferedResourceLoader::kCapacityDefer);
 }
 
+bool BufferedDataSource::ReadFromBlockCache(int64 position, int size) {
+  DCHECK(render_loop_->BelongsToCurrentThread());
+  const int bytes_read = block_cache_->Read(
+      block_cache_key_, position, size, intermediate_read_buffer_.get());
+
+  // A read that ends at the end of the resource is complete too.
+  if (bytes_read == 0 ||
+      (bytes_read < size && position + bytes_read != total_bytes_)) {
+    return false;
+  }
+
+  bytes_read_from_block_cache_ += bytes_read;
+  ReadCallback(BufferedResourceLoader::kOk, bytes_read);
+  return true;
+}
+
 }  // namespace content
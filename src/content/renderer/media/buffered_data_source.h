@@ -27,6 +27,8 @@ class MediaLog;
 
 namespace content {
 
+class MediaBlockCache;
+
 class CONTENT_EXPORT BufferedDataSourceHost {
  public:
   // Notify the host of the total size of the media file.
@@ -69,6 +71,14 @@ class CONTENT_EXPORT BufferedDataSource : public media::DataSource {
       BufferedResourceLoader::CORSMode cors_mode,
       const InitializeCB& init_cb);
 
+  // Reads through |block_cache| whatever the current loader can't serve, and
+  // adds everything the loaders download to it if the response can be
+  // validated.  |block_cache| must outlive this object.  Must be called before
+  // Initialize().
+  //
+  // Method called on the render thread.
+  void SetBlockCache(MediaBlockCache* block_cache);
+
   // Adjusts the buffering algorithm based on the given preload value.
   void SetPreload(Preload preload);
 
@@ -112,6 +122,7 @@ class CONTENT_EXPORT BufferedDataSource : public media::DataSource {
       int64 first_byte_position, int64 last_byte_position);
 
  private:
+  friend class BufferedDataSourcePerfTest;
   friend class BufferedDataSourceTest;
 
   // Task posted to perform actual reading on the render thread.
@@ -147,6 +158,10 @@ class CONTENT_EXPORT BufferedDataSource : public media::DataSource {
   // change in playback rate.
   void UpdateDeferStrategy(bool paused);
 
+  // Fulfills the current read from |block_cache_| if it has all of it, and
+  // returns whether it did.
+  bool ReadFromBlockCache(int64 position, int size);
+
   // URL of the resource requested.
   GURL url_;
   // crossorigin attribute on the corresponding HTML media element, if any.
@@ -171,6 +186,15 @@ class CONTENT_EXPORT BufferedDataSource : public media::DataSource {
   // A resource loader for the media resource.
   scoped_ptr<BufferedResourceLoader> loader_;
 
+  // The cache shared with other data sources, if any, and the key of this
+  // resource in it.
+  MediaBlockCache* block_cache_;
+  std::string block_cache_key_;
+
+  // Bytes read in total and from |block_cache_|.
+  int64 bytes_read_;
+  int64 bytes_read_from_block_cache_;
+
   // Callback method from the pipeline for initialization.
   InitializeCB init_cb_;
 
@@ -0,0 +1,217 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/message_loop/message_loop.h"
+#include "base/time/time.h"
+#include "content/renderer/media/buffered_data_source.h"
+#include "content/renderer/media/media_block_cache.h"
+#include "content/renderer/media/test_response_generator.h"
+#include "content/test/mock_webframeclient.h"
+#include "content/test/mock_weburlloader.h"
+#include "media/base/media_log.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "third_party/WebKit/public/platform/WebURLResponse.h"
+#include "third_party/WebKit/public/web/WebLocalFrame.h"
+#include "third_party/WebKit/public/web/WebView.h"
+
+using ::testing::NiceMock;
+
+using blink::WebLocalFrame;
+using blink::WebString;
+using blink::WebURLLoader;
+using blink::WebURLResponse;
+using blink::WebView;
+
+namespace content {
+
+namespace {
+
+const int64 kFileSize = 5000000;
+const int kDataSize = 1024;
+const char kHttpUrl[] = "http://localhost/foo.webm";
+
+// Seeks timed once both positions have been downloaded.
+const int kSeeks = 1000;
+
+class NullBufferedDataSourceHost : public BufferedDataSourceHost {
+ public:
+  NullBufferedDataSourceHost() {}
+  virtual ~NullBufferedDataSourceHost() {}
+
+  virtual void SetTotalBytes(int64 total_bytes) OVERRIDE {}
+  virtual void AddBufferedByteRange(int64 start, int64 end) OVERRIDE {}
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(NullBufferedDataSourceHost);
+};
+
+void OnDownloading(bool downloading) {}
+
+}  // namespace
+
+// Loads through a MockWebURLLoader instead of the network.
+class PerfTestBufferedDataSource : public BufferedDataSource {
+ public:
+  PerfTestBufferedDataSource(
+      const scoped_refptr<base::MessageLoopProxy>& message_loop,
+      WebLocalFrame* frame,
+      BufferedDataSourceHost* host)
+      : BufferedDataSource(message_loop, frame, new media::MediaLog(), host,
+                           base::Bind(&OnDownloading)),
+        loaders_created_(0) {
+  }
+  virtual ~PerfTestBufferedDataSource() {}
+
+  int loaders_created() const { return loaders_created_; }
+
+ protected:
+  virtual BufferedResourceLoader* CreateResourceLoader(
+      int64 first_byte_position, int64 last_byte_position) OVERRIDE;
+
+ private:
+  int loaders_created_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerfTestBufferedDataSource);
+};
+
+class BufferedDataSourcePerfTest : public testing::Test {
+ public:
+  BufferedDataSourcePerfTest()
+      : view_(WebView::create(NULL)),
+        frame_(WebLocalFrame::create(&client_)),
+        response_generator_(GURL(kHttpUrl), kFileSize),
+        reads_(0) {
+    view_->setMainFrame(frame_);
+    data_source_.reset(
+        new PerfTestBufferedDataSource(message_loop_.message_loop_proxy(),
+                                       view_->mainFrame()->toWebLocalFrame(),
+                                       &host_));
+  }
+
+  virtual ~BufferedDataSourcePerfTest() {
+    view_->close();
+    frame_->close();
+  }
+
+  static void SetTestLoader(BufferedResourceLoader* loader) {
+    loader->test_loader_ =
+        scoped_ptr<WebURLLoader>(new NiceMock<MockWebURLLoader>());
+  }
+
+ protected:
+  // Responds to the current loader with a 206 response that has an ETag, so
+  // that the block cache keeps what it downloads.
+  void Respond(int64 first_byte_offset) {
+    WebURLResponse response =
+        response_generator_.Generate206(first_byte_offset);
+    response.setHTTPHeaderField(WebString::fromUTF8("ETag"),
+                                WebString::fromUTF8("\"1\""));
+    loader()->didReceiveResponse(url_loader(), response);
+    message_loop_.RunUntilIdle();
+  }
+
+  void ReceiveData(int size) {
+    scoped_ptr<char[]> data(new char[size]);
+    memset(data.get(), 0xA5, size);  // Arbitrary non-zero value.
+
+    loader()->didReceiveData(url_loader(), data.get(), size, size);
+    message_loop_.RunUntilIdle();
+  }
+
+  void ReadAt(int64 position) {
+    data_source_->Read(position, kDataSize, buffer_,
+                       base::Bind(&BufferedDataSourcePerfTest::OnRead,
+                                  base::Unretained(this)));
+    message_loop_.RunUntilIdle();
+  }
+
+  void OnRead(int size) {
+    EXPECT_EQ(kDataSize, size);
+    ++reads_;
+  }
+
+  void OnInitialize(bool success) { EXPECT_TRUE(success); }
+
+  BufferedResourceLoader* loader() { return data_source_->loader_.get(); }
+  WebURLLoader* url_loader() {
+    return loader()->active_loader_->loader_.get();
+  }
+
+  base::MessageLoop message_loop_;
+  MockWebFrameClient client_;
+  WebView* view_;
+  WebLocalFrame* frame_;
+  NullBufferedDataSourceHost host_;
+  TestResponseGenerator response_generator_;
+  scoped_ptr<PerfTestBufferedDataSource> data_source_;
+  int reads_;
+
+ private:
+  // Used for calling BufferedDataSource::Read().
+  uint8 buffer_[kDataSize];
+
+  DISALLOW_COPY_AND_ASSIGN(BufferedDataSourcePerfTest);
+};
+
+BufferedResourceLoader* PerfTestBufferedDataSource::CreateResourceLoader(
+    int64 first_byte_position, int64 last_byte_position) {
+  BufferedResourceLoader* loader = BufferedDataSource::CreateResourceLoader(
+      first_byte_position, last_byte_position);
+  BufferedDataSourcePerfTest::SetTestLoader(loader);
+  ++loaders_created_;
+  return loader;
+}
+
+// Seeks back and forth between two positions and reports how many requests
+// and bytes that costs with the block cache, and how long the seeks take.
+TEST_F(BufferedDataSourcePerfTest, RepeatedSeeksWithBlockCache) {
+  const int64 kPositions[] = { 0, MediaBlockCache::kBlockSize * 100 };
+
+  MediaBlockCache block_cache(kFileSize);
+  data_source_->SetBlockCache(&block_cache);
+  data_source_->Initialize(
+      GURL(kHttpUrl), BufferedResourceLoader::kUnspecified,
+      base::Bind(&BufferedDataSourcePerfTest::OnInitialize,
+                 base::Unretained(this)));
+  message_loop_.RunUntilIdle();
+  Respond(0);
+
+  // The first visit to each position downloads it.
+  int64 bytes_fetched = 0;
+  for (size_t i = 0; i < arraysize(kPositions); ++i) {
+    ReadAt(kPositions[i]);
+    if (i > 0)
+      Respond(kPositions[i]);
+    ReceiveData(kDataSize);
+    bytes_fetched += kDataSize;
+  }
+  ASSERT_EQ(static_cast<int>(arraysize(kPositions)), reads_);
+
+  // Later seeks don't download anything.
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kSeeks; ++i)
+    ReadAt(kPositions[i % arraysize(kPositions)]);
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  EXPECT_EQ(static_cast<int>(arraysize(kPositions)) + kSeeks, reads_);
+  EXPECT_EQ(static_cast<int>(arraysize(kPositions)),
+            data_source_->loaders_created());
+
+  perf_test::PrintResult("block_cache_requests", "", "repeated_seeks",
+                         static_cast<size_t>(data_source_->loaders_created()),
+                         "requests", false);
+  perf_test::PrintResult("block_cache_bytes_fetched", "", "repeated_seeks",
+                         static_cast<size_t>(bytes_fetched), "bytes", false);
+  perf_test::PrintResult("block_cache_seek_time", "", "repeated_seeks",
+                         elapsed.InMicroseconds() / static_cast<double>(kSeeks),
+                         "us/seek", true);
+
+  data_source_->Stop(base::Bind(&base::DoNothing));
+  message_loop_.RunUntilIdle();
+}
+
+}  // namespace content
@@ -6,6 +6,7 @@
 #include "base/message_loop/message_loop.h"
 #include "content/public/common/url_constants.h"
 #include "content/renderer/media/buffered_data_source.h"
+#include "content/renderer/media/media_block_cache.h"
 #include "content/renderer/media/test_response_generator.h"
 #include "content/test/mock_webframeclient.h"
 #include "content/test/mock_weburlloader.h"
@@ -145,6 +146,14 @@ class BufferedDataSourceTest : public testing::Test {
     Respond(response_generator_->Generate206(0));
   }
 
+  // Helper to initialize tests with a valid 206 response that has an ETag.
+  void InitializeWithValidated206Response() {
+    Initialize(kHttpUrl, true);
+
+    EXPECT_CALL(host_, SetTotalBytes(response_generator_->content_length()));
+    Respond(GenerateValidated206(0));
+  }
+
   // Helper to initialize tests with a valid file:// response.
   void InitializeWithFileResponse() {
     Initialize(kFileUrl, true);
@@ -168,6 +177,14 @@ class BufferedDataSourceTest : public testing::Test {
     message_loop_.RunUntilIdle();
   }
 
+  WebURLResponse GenerateValidated206(int64 first_byte_offset) {
+    WebURLResponse response =
+        response_generator_->Generate206(first_byte_offset);
+    response.setHTTPHeaderField(WebString::fromUTF8("ETag"),
+                                WebString::fromUTF8("\"1\""));
+    return response;
+  }
+
   void ExpectCreateResourceLoader() {
     EXPECT_CALL(*data_source_, CreateResourceLoader(_, _))
         .WillOnce(Invoke(data_source_.get(),
@@ -669,4 +686,69 @@ TEST_F(BufferedDataSourceTest, File_FinishLoading) {
   Stop();
 }
 
+TEST_F(BufferedDataSourceTest, Http_SeekBackReadsFromBlockCache) {
+  MediaBlockCache block_cache(kFileSize);
+  data_source_->SetBlockCache(&block_cache);
+  InitializeWithValidated206Response();
+
+  EXPECT_CALL(*this, ReadCallback(kDataSize));
+  EXPECT_CALL(host_, AddBufferedByteRange(0, kDataSize - 1));
+  ReadAt(0);
+  ReceiveData(kDataSize);
+  EXPECT_EQ(kDataSize, block_cache.bytes());
+
+  // Reading far ahead needs a new loader.
+  ExpectCreateResourceLoader();
+  ReadAt(kFarReadPosition);
+  Respond(GenerateValidated206(kFarReadPosition));
+  EXPECT_CALL(*this, ReadCallback(kDataSize));
+  EXPECT_CALL(host_, AddBufferedByteRange(kFarReadPosition,
+                                          kFarReadPosition + kDataSize - 1));
+  ReceiveData(kDataSize);
+
+  // Reading the start again doesn't.
+  EXPECT_CALL(*this, ReadCallback(kDataSize));
+  ReadAt(0);
+
+  EXPECT_TRUE(data_source_->loading());
+  Stop();
+
+  // Nothing else reads the resource, so it is released.
+  EXPECT_EQ(0, block_cache.bytes());
+}
+
+TEST_F(BufferedDataSourceTest, Http_UnvalidatedResponseIsNotCached) {
+  MediaBlockCache block_cache(kFileSize);
+  data_source_->SetBlockCache(&block_cache);
+  InitializeWith206Response();
+
+  EXPECT_CALL(*this, ReadCallback(kDataSize));
+  EXPECT_CALL(host_, AddBufferedByteRange(0, kDataSize - 1));
+  ReadAt(0);
+  ReceiveData(kDataSize);
+  EXPECT_EQ(0, block_cache.bytes());
+
+  Stop();
+}
+
+TEST_F(BufferedDataSourceTest, Http_NoStoreResponseIsNotCached) {
+  MediaBlockCache block_cache(kFileSize);
+  data_source_->SetBlockCache(&block_cache);
+  Initialize(kHttpUrl, true);
+
+  WebURLResponse response = GenerateValidated206(0);
+  response.setHTTPHeaderField(WebString::fromUTF8("Cache-Control"),
+                              WebString::fromUTF8("no-store"));
+  EXPECT_CALL(host_, SetTotalBytes(response_generator_->content_length()));
+  Respond(response);
+
+  EXPECT_CALL(*this, ReadCallback(kDataSize));
+  EXPECT_CALL(host_, AddBufferedByteRange(0, kDataSize - 1));
+  ReadAt(0);
+  ReceiveData(kDataSize);
+  EXPECT_EQ(0, block_cache.bytes());
+
+  Stop();
+}
+
 }  // namespace content
@@ -311,6 +311,21 @@ void BufferedResourceLoader::Read(
   DoneRead(kCacheMiss, 0);
 }
 
+bool BufferedResourceLoader::CanServeRead(int64 position) const {
+  if (loader_failed_)
+    return false;
+
+  // The same checks as CanFulfillRead() and WillFulfillRead(), but for the
+  // start of a read that hasn't been made yet.
+  const int64 first_offset = position - offset_;
+  if (first_offset < 0 && (first_offset + buffer_.backward_bytes()) < 0)
+    return false;
+  if (first_offset < buffer_.forward_bytes())
+    return true;
+  return active_loader_.get() != NULL &&
+      (first_offset - buffer_.forward_bytes()) < kForwardWaitThreshold;
+}
+
 int64 BufferedResourceLoader::content_length() {
   return content_length_;
 }
@@ -369,6 +384,7 @@ void BufferedResourceLoader::didReceiveResponse(
     return;
 
   uint32 reasons = GetReasonsForUncacheability(response);
+  const bool no_store = (reasons & kNoStore) != 0;
   might_be_reused_from_cache_in_future_ = reasons == 0;
   UMA_HISTOGRAM_BOOLEAN("Media.CacheUseful", reasons == 0);
   int shift = 0;
@@ -433,6 +449,15 @@ void BufferedResourceLoader::didReceiveResponse(
     }
   }
 
+  const std::string etag = response.httpHeaderField("ETag").utf8();
+  const std::string last_modified =
+      response.httpHeaderField("Last-Modified").utf8();
+  if (!no_store && instance_size_ != kPositionNotSpecified &&
+      (!etag.empty() || !last_modified.empty())) {
+    cache_validator_ = base::Int64ToString(instance_size_) + "\n" + etag +
+        "\n" + last_modified;
+  }
+
   // Calls with a successful response.
   DoneStart(kOk);
 }
@@ -446,6 +471,11 @@ void BufferedResourceLoader::didReceiveData(
   DCHECK(active_loader_.get());
   DCHECK_GT(data_length, 0);
 
+  if (!data_received_cb_.is_null()) {
+    data_received_cb_.Run(offset_ + buffer_.forward_bytes(),
+                          reinterpret_cast<const uint8*>(data), data_length);
+  }
+
   buffer_.Append(reinterpret_cast<const uint8*>(data), data_length);
 
   // If there is an active read request, try to fulfill the request.
@@ -123,6 +123,17 @@ class CONTENT_EXPORT BufferedResourceLoader
   void Read(int64 position, int read_size,
             uint8* buffer, const ReadCB& read_cb);
 
+  // Returns true if a Read() at |position| would be fulfilled from what is
+  // buffered or is about to arrive, rather than fail with kCacheMiss.
+  bool CanServeRead(int64 position) const;
+
+  // Sets a callback to run with the offset in the resource of every piece of
+  // data that arrives, and the data.
+  typedef base::Callback<void(int64, const uint8*, int)> DataReceivedCB;
+  void set_data_received_cb(const DataReceivedCB& data_received_cb) {
+    data_received_cb_ = data_received_cb;
+  }
+
   // Gets the content length in bytes of the instance after this loader has been
   // started. If this value is |kPositionNotSpecified|, then content length is
   // unknown.
@@ -132,6 +143,11 @@ class CONTENT_EXPORT BufferedResourceLoader
   // |kPositionNotSpecified|, then the size is unknown.
   int64 instance_size();
 
+  // Identifies the version of the resource the response is for, from its
+  // length and its ETag and Last-Modified headers, once this loader has
+  // started.  Empty if the response mustn't be stored or has no validators.
+  const std::string& cache_validator() const { return cache_validator_; }
+
   // Returns true if the server supports byte range requests.
   bool range_supported();
 
@@ -203,6 +219,7 @@ class CONTENT_EXPORT BufferedResourceLoader
       int64* last_byte_position, int64* instance_size);
 
  private:
+  friend class BufferedDataSourcePerfTest;
   friend class BufferedDataSourceTest;
   friend class BufferedResourceLoaderTest;
   friend class MockBufferedDataSource;
@@ -286,11 +303,15 @@ class CONTENT_EXPORT BufferedResourceLoader
   // zero-indexed file offset of the furthest buffered byte.
   ProgressCB progress_cb_;
 
+  // Executed with every piece of data that arrives, if set.
+  DataReceivedCB data_received_cb_;
+
   // Members used during request start.
   StartCB start_cb_;
   int64 offset_;
   int64 content_length_;
   int64 instance_size_;
+  std::string cache_validator_;
 
   // Members used during a read operation. They should be reset after each
   // read has completed or failed.
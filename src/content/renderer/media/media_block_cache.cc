@@ -0,0 +1,202 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "content/renderer/media/media_block_cache.h"
+
+#include <algorithm>
+
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+
+namespace content {
+
+namespace {
+
+// The memory shared by all the media of a render process.
+const int64 kDefaultCapacity = 32 * 1024 * 1024;
+
+// How far behind and ahead of a reader's position blocks are kept for it.
+const int64 kKeepBehindReaderBytes = 2 * 1024 * 1024;
+const int64 kKeepAheadOfReaderBytes = 8 * 1024 * 1024;
+
+base::LazyInstance<MediaBlockCache>::Leaky g_media_block_cache =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+const int MediaBlockCache::kBlockSize = 32 * 1024;
+
+MediaBlockCache::Block::Block() {}
+
+MediaBlockCache::Block::~Block() {}
+
+MediaBlockCache::MediaBlockCache()
+    : capacity_(kDefaultCapacity),
+      bytes_(0) {
+}
+
+MediaBlockCache::MediaBlockCache(int64 capacity)
+    : capacity_(capacity),
+      bytes_(0) {
+}
+
+MediaBlockCache::~MediaBlockCache() {}
+
+// static
+MediaBlockCache* MediaBlockCache::GetInstance() {
+  return g_media_block_cache.Pointer();
+}
+
+void MediaBlockCache::SetValidator(const std::string& resource,
+                                   const std::string& validator) {
+  DCHECK(CalledOnValidThread());
+  ValidatorMap::const_iterator i = validators_.find(resource);
+  if (i != validators_.end() && i->second == validator)
+    return;
+
+  RemoveResource(resource);
+  if (!validator.empty())
+    validators_[resource] = validator;
+}
+
+void MediaBlockCache::Write(const std::string& resource,
+                            int64 position,
+                            const uint8* data,
+                            int size) {
+  DCHECK(CalledOnValidThread());
+  DCHECK_GE(position, 0);
+  if (validators_.find(resource) == validators_.end())
+    return;
+
+  while (size > 0) {
+    const BlockKey key(resource, position / kBlockSize);
+    const size_t offset = position % kBlockSize;
+    const size_t length = std::min<size_t>(size, kBlockSize - offset);
+
+    BlockMap::iterator block = blocks_.find(key);
+    if (block == blocks_.end() && offset == 0) {
+      block = blocks_.insert(std::make_pair(key, Block())).first;
+      block->second.lru_position = lru_.insert(lru_.end(), key);
+    }
+    if (block != blocks_.end()) {
+      std::string* block_data = &block->second.data;
+      if (offset <= block_data->size() &&
+          offset + length > block_data->size()) {
+        const size_t skip = block_data->size() - offset;
+        block_data->append(reinterpret_cast<const char*>(data) + skip,
+                           length - skip);
+        bytes_ += length - skip;
+      }
+      Touch(block);
+    }
+
+    position += length;
+    data += length;
+    size -= length;
+  }
+  EvictIfNeeded();
+}
+
+int MediaBlockCache::Read(const std::string& resource,
+                          int64 position,
+                          int size,
+                          uint8* data) {
+  DCHECK(CalledOnValidThread());
+  DCHECK_GE(position, 0);
+  int bytes_read = 0;
+  while (bytes_read < size) {
+    BlockMap::iterator block =
+        blocks_.find(BlockKey(resource, position / kBlockSize));
+    const size_t offset = position % kBlockSize;
+    if (block == blocks_.end() || offset >= block->second.data.size())
+      break;
+
+    const size_t length = std::min<size_t>(
+        size - bytes_read, block->second.data.size() - offset);
+    memcpy(data + bytes_read, block->second.data.data() + offset, length);
+    Touch(block);
+    position += length;
+    bytes_read += length;
+  }
+  return bytes_read;
+}
+
+void MediaBlockCache::SetReaderPosition(const void* reader,
+                                        const std::string& resource,
+                                        int64 position) {
+  DCHECK(CalledOnValidThread());
+  readers_[reader] = std::make_pair(resource, position);
+}
+
+void MediaBlockCache::RemoveReader(const void* reader) {
+  DCHECK(CalledOnValidThread());
+  ReaderMap::iterator removed = readers_.find(reader);
+  if (removed == readers_.end())
+    return;
+
+  const std::string resource = removed->second.first;
+  readers_.erase(removed);
+  for (ReaderMap::const_iterator i = readers_.begin(); i != readers_.end();
+       ++i) {
+    if (i->second.first == resource)
+      return;
+  }
+  RemoveResource(resource);
+}
+
+void MediaBlockCache::Clear() {
+  DCHECK(CalledOnValidThread());
+  blocks_.clear();
+  lru_.clear();
+  validators_.clear();
+  bytes_ = 0;
+}
+
+void MediaBlockCache::RemoveResource(const std::string& resource) {
+  BlockMap::iterator block = blocks_.lower_bound(BlockKey(resource, 0));
+  while (block != blocks_.end() && block->first.first == resource) {
+    bytes_ -= block->second.data.size();
+    lru_.erase(block->second.lru_position);
+    blocks_.erase(block++);
+  }
+  validators_.erase(resource);
+}
+
+void MediaBlockCache::Touch(BlockMap::iterator block) {
+  lru_.splice(lru_.end(), lru_, block->second.lru_position);
+}
+
+void MediaBlockCache::EvictIfNeeded() {
+  while (bytes_ > capacity_) {
+    // Evict the least recently used block that no reader is near, or failing
+    // that the least recently used block.
+    BlockList::iterator victim = lru_.begin();
+    for (BlockList::iterator i = lru_.begin(); i != lru_.end(); ++i) {
+      if (!IsNearReader(*i)) {
+        victim = i;
+        break;
+      }
+    }
+    BlockMap::iterator block = blocks_.find(*victim);
+    DCHECK(block != blocks_.end());
+    bytes_ -= block->second.data.size();
+    lru_.erase(victim);
+    blocks_.erase(block);
+  }
+}
+
+bool MediaBlockCache::IsNearReader(const BlockKey& key) const {
+  const int64 block_start = key.second * kBlockSize;
+  for (ReaderMap::const_iterator i = readers_.begin(); i != readers_.end();
+       ++i) {
+    if (i->second.first == key.first &&
+        block_start + kBlockSize > i->second.second - kKeepBehindReaderBytes &&
+        block_start < i->second.second + kKeepAheadOfReaderBytes) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace content
@@ -0,0 +1,129 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CONTENT_RENDERER_MEDIA_MEDIA_BLOCK_CACHE_H_
+#define CONTENT_RENDERER_MEDIA_MEDIA_BLOCK_CACHE_H_
+
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "base/basictypes.h"
+#include "base/threading/non_thread_safe.h"
+#include "content/common/content_export.h"
+
+namespace content {
+
+// A cache of media bytes shared by every BufferedDataSource in the render
+// process, so that players of the same resource, or a player that seeks back
+// to data its loader has already let go of, read it again without downloading
+// it again.
+//
+// Bytes are kept in blocks of kBlockSize keyed by resource and offset, up to a
+// memory limit shared by all resources.  Readers report where they are
+// playing, and blocks near any of those positions are evicted only once there
+// is nothing else left to evict; otherwise the least recently used block goes
+// first.  A resource's blocks are dropped once it has no readers left.
+//
+// Only bytes of a resource whose response has a validator are kept, and they
+// are dropped as soon as a response with a different validator is seen.
+//
+// MediaBlockCache is single threaded and must be accessed on the render
+// thread.
+class CONTENT_EXPORT MediaBlockCache : public base::NonThreadSafe {
+ public:
+  // The size of a full block.
+  static const int kBlockSize;
+
+  MediaBlockCache();
+  explicit MediaBlockCache(int64 capacity);
+  ~MediaBlockCache();
+
+  // Returns the cache shared by the render process.
+  static MediaBlockCache* GetInstance();
+
+  // Records |validator| as identifying the bytes of |resource| that are
+  // written from now on, and drops what is cached of |resource| if it was
+  // written under another validator.  An empty |validator| means the bytes
+  // mustn't be cached.
+  void SetValidator(const std::string& resource, const std::string& validator);
+
+  // Stores the |size| bytes of |resource| at |position| in |data|, if
+  // |resource| has a validator.  A block only keeps a contiguous run of bytes
+  // from its start, so bytes that would leave a gap are dropped.
+  void Write(const std::string& resource,
+             int64 position,
+             const uint8* data,
+             int size);
+
+  // Copies as many of the |size| bytes of |resource| at |position| as are
+  // cached contiguously into |data|, and returns how many that was.
+  int Read(const std::string& resource, int64 position, int size,
+           uint8* data);
+
+  // Records that |reader| is playing |resource| at |position|, replacing
+  // where it was before.
+  void SetReaderPosition(const void* reader,
+                         const std::string& resource,
+                         int64 position);
+
+  // Forgets |reader|'s position, and drops the blocks of its resource if no
+  // other reader is playing it.
+  void RemoveReader(const void* reader);
+
+  // Drops every block, e.g. when the system is low on memory.
+  void Clear();
+
+  int64 capacity() const { return capacity_; }
+  int64 bytes() const { return bytes_; }
+
+ private:
+  // A resource and the index of a block in it.
+  typedef std::pair<std::string, int64> BlockKey;
+  typedef std::list<BlockKey> BlockList;
+
+  struct Block {
+    Block();
+    ~Block();
+
+    std::string data;
+
+    // Where the block is in |lru_|.
+    BlockList::iterator lru_position;
+  };
+  typedef std::map<BlockKey, Block> BlockMap;
+
+  typedef std::map<const void*, std::pair<std::string, int64> > ReaderMap;
+  typedef std::map<std::string, std::string> ValidatorMap;
+
+  // Marks |block| as the most recently used.
+  void Touch(BlockMap::iterator block);
+
+  // Drops the blocks and validator of |resource|.
+  void RemoveResource(const std::string& resource);
+
+  // Evicts blocks until the cache is within its capacity.
+  void EvictIfNeeded();
+
+  // Returns true if the block |key| is near where any reader of its resource
+  // is playing.
+  bool IsNearReader(const BlockKey& key) const;
+
+  const int64 capacity_;
+  int64 bytes_;
+  BlockMap blocks_;
+
+  // Keys of |blocks_|, least recently used first.
+  BlockList lru_;
+
+  ReaderMap readers_;
+  ValidatorMap validators_;
+
+  DISALLOW_COPY_AND_ASSIGN(MediaBlockCache);
+};
+
+}  // namespace content
+
+#endif  // CONTENT_RENDERER_MEDIA_MEDIA_BLOCK_CACHE_H_
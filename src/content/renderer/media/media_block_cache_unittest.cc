@@ -0,0 +1,191 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "content/renderer/media/media_block_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace content {
+
+namespace {
+
+const char kResource[] = "0 http://localhost/foo.webm";
+const char kOtherResource[] = "0 http://localhost/bar.webm";
+const char kValidator[] = "5000000\n\"v1\"\n";
+const char kOtherValidator[] = "5000000\n\"v2\"\n";
+
+// Returns |size| bytes whose values depend on their position.
+std::vector<uint8> MakeData(int64 position, int size) {
+  std::vector<uint8> data(size);
+  for (int i = 0; i < size; ++i)
+    data[i] = static_cast<uint8>((position + i) * 13);
+  return data;
+}
+
+void Write(MediaBlockCache* cache, const std::string& resource,
+           int64 position, int size) {
+  std::vector<uint8> data(MakeData(position, size));
+  cache->Write(resource, position, &data[0], size);
+}
+
+// Returns how many of the |size| bytes at |position| are cached, checking
+// that they are the bytes written there.
+int Read(MediaBlockCache* cache, const std::string& resource,
+         int64 position, int size) {
+  std::vector<uint8> data(size);
+  const int bytes_read = cache->Read(resource, position, size, &data[0]);
+  data.resize(bytes_read);
+  EXPECT_TRUE(MakeData(position, bytes_read) == data);
+  return bytes_read;
+}
+
+}  // namespace
+
+TEST(MediaBlockCacheTest, WriteAndRead) {
+  const int kBlockSize = MediaBlockCache::kBlockSize;
+  MediaBlockCache cache(10 * kBlockSize);
+  cache.SetValidator(kResource, kValidator);
+  cache.SetValidator(kOtherResource, kValidator);
+
+  Write(&cache, kResource, 0, 2 * kBlockSize + 100);
+  EXPECT_EQ(2 * kBlockSize + 100, cache.bytes());
+  EXPECT_EQ(2 * kBlockSize + 100,
+            Read(&cache, kResource, 0, 3 * kBlockSize));
+  EXPECT_EQ(500, Read(&cache, kResource, kBlockSize - 200, 500));
+  EXPECT_EQ(0, Read(&cache, kOtherResource, 0, 500));
+
+  // Writes that overlap what is cached only add what is new.
+  Write(&cache, kResource, 2 * kBlockSize, 300);
+  EXPECT_EQ(2 * kBlockSize + 300, cache.bytes());
+  EXPECT_EQ(300, Read(&cache, kResource, 2 * kBlockSize, 1000));
+}
+
+TEST(MediaBlockCacheTest, GapsAreNotCached) {
+  const int kBlockSize = MediaBlockCache::kBlockSize;
+  MediaBlockCache cache(10 * kBlockSize);
+  cache.SetValidator(kResource, kValidator);
+  cache.SetValidator(kOtherResource, kValidator);
+
+  // Data that starts partway into an empty block is kept from the next block.
+  Write(&cache, kResource, kBlockSize / 2, kBlockSize);
+  EXPECT_EQ(kBlockSize / 2, cache.bytes());
+  EXPECT_EQ(0, Read(&cache, kResource, kBlockSize / 2, 100));
+  EXPECT_EQ(100, Read(&cache, kResource, kBlockSize, 100));
+
+  // Data after a gap in a block is dropped.
+  Write(&cache, kResource, kBlockSize * 3 / 2 + 10, 100);
+  EXPECT_EQ(kBlockSize / 2, cache.bytes());
+}
+
+TEST(MediaBlockCacheTest, EvictsLeastRecentlyUsed) {
+  const int kBlockSize = MediaBlockCache::kBlockSize;
+  MediaBlockCache cache(3 * kBlockSize);
+  cache.SetValidator(kResource, kValidator);
+  cache.SetValidator(kOtherResource, kValidator);
+
+  Write(&cache, kResource, 0, 3 * kBlockSize);
+  EXPECT_EQ(100, Read(&cache, kResource, 0, 100));
+  Write(&cache, kOtherResource, 0, kBlockSize);
+
+  EXPECT_EQ(3 * kBlockSize, cache.bytes());
+  EXPECT_EQ(100, Read(&cache, kResource, 0, 100));
+  EXPECT_EQ(0, Read(&cache, kResource, kBlockSize, 100));
+  EXPECT_EQ(100, Read(&cache, kResource, 2 * kBlockSize, 100));
+  EXPECT_EQ(100, Read(&cache, kOtherResource, 0, 100));
+}
+
+TEST(MediaBlockCacheTest, EvictionSparesReaderPositions) {
+  const int kBlockSize = MediaBlockCache::kBlockSize;
+  const int64 kFar = 1000 * kBlockSize;
+  MediaBlockCache cache(3 * kBlockSize);
+  cache.SetValidator(kResource, kValidator);
+  cache.SetValidator(kOtherResource, kValidator);
+  int reader = 0;
+
+  // The block a reader is playing survives though it is the least recently
+  // used.
+  Write(&cache, kResource, kFar, kBlockSize);
+  cache.SetReaderPosition(&reader, kResource, kFar);
+  Write(&cache, kOtherResource, 0, 3 * kBlockSize);
+  EXPECT_EQ(100, Read(&cache, kResource, kFar, 100));
+  EXPECT_EQ(0, Read(&cache, kOtherResource, 0, 100));
+
+  // Once the reader has gone, so is the resource.
+  cache.RemoveReader(&reader);
+  EXPECT_EQ(0, Read(&cache, kResource, kFar, 100));
+  EXPECT_EQ(2 * kBlockSize, cache.bytes());
+}
+
+TEST(MediaBlockCacheTest, ReleasedWithLastReader) {
+  const int kBlockSize = MediaBlockCache::kBlockSize;
+  MediaBlockCache cache(10 * kBlockSize);
+  cache.SetValidator(kResource, kValidator);
+  int reader = 0;
+  int other_reader = 0;
+
+  cache.SetReaderPosition(&reader, kResource, 0);
+  cache.SetReaderPosition(&other_reader, kResource, kBlockSize);
+  Write(&cache, kResource, 0, 2 * kBlockSize);
+
+  cache.RemoveReader(&reader);
+  EXPECT_EQ(2 * kBlockSize, cache.bytes());
+  EXPECT_EQ(100, Read(&cache, kResource, 0, 100));
+
+  cache.RemoveReader(&other_reader);
+  EXPECT_EQ(0, cache.bytes());
+  EXPECT_EQ(0, Read(&cache, kResource, 0, 100));
+
+  // Nothing more is cached until a validator is set again.
+  Write(&cache, kResource, 0, kBlockSize);
+  EXPECT_EQ(0, cache.bytes());
+}
+
+TEST(MediaBlockCacheTest, OnlyValidatedResponsesAreCached) {
+  const int kBlockSize = MediaBlockCache::kBlockSize;
+  MediaBlockCache cache(10 * kBlockSize);
+
+  // Nothing is cached without a validator.
+  Write(&cache, kResource, 0, kBlockSize);
+  EXPECT_EQ(0, cache.bytes());
+  cache.SetValidator(kResource, "");
+  Write(&cache, kResource, 0, kBlockSize);
+  EXPECT_EQ(0, cache.bytes());
+
+  cache.SetValidator(kResource, kValidator);
+  cache.SetValidator(kOtherResource, kValidator);
+  Write(&cache, kResource, 0, kBlockSize);
+  Write(&cache, kOtherResource, 0, kBlockSize);
+
+  // The same validator keeps what is cached.
+  cache.SetValidator(kResource, kValidator);
+  EXPECT_EQ(100, Read(&cache, kResource, 0, 100));
+
+  // A different one drops it, but only for that resource.
+  cache.SetValidator(kResource, kOtherValidator);
+  EXPECT_EQ(0, Read(&cache, kResource, 0, 100));
+  EXPECT_EQ(100, Read(&cache, kOtherResource, 0, 100));
+  EXPECT_EQ(kBlockSize, cache.bytes());
+
+  // So does a response that mustn't be stored.
+  cache.SetValidator(kOtherResource, "");
+  EXPECT_EQ(0, cache.bytes());
+  Write(&cache, kOtherResource, 0, kBlockSize);
+  EXPECT_EQ(0, cache.bytes());
+}
+
+TEST(MediaBlockCacheTest, Clear) {
+  const int kBlockSize = MediaBlockCache::kBlockSize;
+  MediaBlockCache cache(10 * kBlockSize);
+  cache.SetValidator(kResource, kValidator);
+  Write(&cache, kResource, 0, 2 * kBlockSize);
+
+  cache.Clear();
+  EXPECT_EQ(0, cache.bytes());
+  EXPECT_EQ(0, Read(&cache, kResource, 0, 100));
+}
+
+}  // namespace content
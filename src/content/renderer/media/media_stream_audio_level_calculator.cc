@@ -6,29 +6,10 @@
 
 #include "base/logging.h"
 #include "base/stl_util.h"
+#include "content/renderer/media/audio_sample_kernels.h"
 
 namespace content {
 
-namespace {
-
-// Calculates the maximum absolute amplitude of the audio data.
-// Note, the return value can be bigger than std::numeric_limits<int16>::max().
-int MaxAmplitude(const int16* audio_data, int length) {
-  int max = 0, absolute = 0;
-  for (int i = 0; i < length; ++i) {
-    absolute = std::abs(audio_data[i]);
-    if (absolute > max)
-      max = absolute;
-  }
-  // The range of int16 is [-32768, 32767], verify the |max| should not be
-  // bigger than 32768.
-  DCHECK(max <= std::abs(std::numeric_limits<int16>::min()));
-
-  return max;
-}
-
-}  // namespace
-
 MediaStreamAudioLevelCalculator::MediaStreamAudioLevelCalculator()
     : counter_(0),
       max_amplitude_(0),
@@ -46,7 +27,10 @@ int MediaStreamAudioLevelCalculator::Calculate(const int16* audio_data,
   // every 10ms, |level_| will be updated approximately every 100ms.
   static const int kUpdateFrequency = 10;
 
-  int max = MaxAmplitude(audio_data, number_of_channels * number_of_frames);
+  // Note, |max| can be bigger than std::numeric_limits<int16>::max().
+  int max = audio_sample_kernels::MaxAbs(audio_data,
+                                         number_of_channels * number_of_frames);
+  DCHECK_LE(max, 32768);
   max_amplitude_ = std::max(max_amplitude_, max);
 
   if (counter_++ == kUpdateFrequency) {
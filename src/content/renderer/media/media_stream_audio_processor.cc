@@ -9,6 +9,7 @@
 #include "base/metrics/field_trial.h"
 #include "base/metrics/histogram.h"
 #include "content/public/common/content_switches.h"
+#include "content/renderer/media/audio_sample_kernels.h"
 #include "content/renderer/media/media_stream_audio_processor_options.h"
 #include "content/renderer/media/rtc_media_constraints.h"
 #include "content/renderer/media/webrtc_audio_device_impl.h"
@@ -109,9 +110,9 @@ class MediaStreamAudioProcessor::MediaStreamAudioConverter
     // TODO(xians): Figure out a better way to handle the interleaved and
     // deinterleaved format switching.
     DCHECK_EQ(audio_wrapper_->frames(), sink_params_.frames_per_buffer());
-    audio_wrapper_->ToInterleaved(audio_wrapper_->frames(),
-                                  sink_params_.bits_per_sample() / 8,
-                                  out->data_);
+    DCHECK_EQ(sink_params_.bits_per_sample(), 16);
+    audio_sample_kernels::ToInterleaved(audio_wrapper_.get(),
+                                        audio_wrapper_->frames(), out->data_);
 
     out->samples_per_channel_ = sink_params_.frames_per_buffer();
     out->sample_rate_hz_ = sink_params_.sample_rate();
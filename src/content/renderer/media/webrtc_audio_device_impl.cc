@@ -8,6 +8,7 @@
 #include "base/metrics/histogram.h"
 #include "base/strings/string_util.h"
 #include "base/win/windows_version.h"
+#include "content/renderer/media/audio_sample_kernels.h"
 #include "content/renderer/media/media_stream_audio_processor.h"
 #include "content/renderer/media/webrtc_audio_capturer.h"
 #include "content/renderer/media/webrtc_audio_renderer.h"
@@ -185,9 +186,8 @@ void WebRtcAudioDeviceImpl::RenderData(media::AudioBus* audio_bus,
 
   // De-interleave each channel and convert to 32-bit floating-point
   // with nominal range -1.0 -> +1.0 to match the callback format.
-  audio_bus->FromInterleaved(&render_buffer_[0],
-                             audio_bus->frames(),
-                             bytes_per_sample);
+  audio_sample_kernels::FromInterleaved(&render_buffer_[0], audio_bus->frames(),
+                                        audio_bus);
 
   // Pass the render data to the playout sinks.
   base::AutoLock auto_lock(lock_);
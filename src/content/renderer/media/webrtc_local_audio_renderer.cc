@@ -10,6 +10,7 @@
 #include "base/metrics/histogram.h"
 #include "base/synchronization/lock.h"
 #include "content/renderer/media/audio_device_factory.h"
+#include "content/renderer/media/audio_sample_kernels.h"
 #include "content/renderer/media/webrtc_audio_capturer.h"
 #include "media/audio/audio_output_device.h"
 #include "media/base/audio_bus.h"
@@ -72,9 +73,8 @@ void WebRtcLocalAudioRenderer::OnData(const int16* audio_data,
       loopback_fifo_->max_frames()) {
     scoped_ptr<media::AudioBus> audio_source = media::AudioBus::Create(
         number_of_channels, number_of_frames);
-    audio_source->FromInterleaved(audio_data,
-                                  audio_source->frames(),
-                                  sizeof(audio_data[0]));
+    audio_sample_kernels::FromInterleaved(audio_data, audio_source->frames(),
+                                          audio_source.get());
     loopback_fifo_->Push(audio_source.get());
 
     const base::TimeTicks now = base::TimeTicks::Now();
@@ -75,6 +75,7 @@
 #include "content/renderer/media/audio_input_message_filter.h"
 #include "content/renderer/media/audio_message_filter.h"
 #include "content/renderer/media/audio_renderer_mixer_manager.h"
+#include "content/renderer/media/media_block_cache.h"
 #include "content/renderer/media/media_stream_center.h"
 #include "content/renderer/media/midi_message_filter.h"
 #include "content/renderer/media/peer_connection_tracker.h"
@@ -1426,6 +1427,9 @@ void RenderThreadImpl::OnMemoryPressure(
       blink::WebImageCache::clear();
     }
 
+    // Drop the media bytes kept for seeking back.
+    MediaBlockCache::GetInstance()->Clear();
+
     // Purge Skia font cache, by setting it to 0 and then again to the previous
     // limit.
     size_t font_cache_limit = SkGraphics::SetFontCacheLimit(0);